@@ -4,3 +4,8 @@
 
 TIME_COLS = ["TimeFirstTxPacket", "TimeLastTxPacket", "TimeFirstRxPacket",
              "TimeLastRxPacket", "DelaySum", "JitterSum", "Duration"]
+
+# The magic starting the binary columnar load balancing metrics files, written
+# by `FlowMonitor::LbPerformanceMetricsToBinaryFile`.
+LB_METRICS_BINARY_MAGIC = b"NS3LBM\0\0"
+LB_METRICS_BINARY_VERSION = 1
@@ -97,3 +97,77 @@ def get_lb_performance_metrics(lb_metrics_file):
   for col in config.TIME_COLS:
       df[col] = df[col].map(lambda x : float(x[1:(len(x)-2)]))
   return df
+
+def _align_to_8(offset):
+  """ Rounds `offset` up to a multiple of 8 bytes. """
+  return (offset + 7) // 8 * 8
+
+def load_lb_performance_metrics_binary(lb_metrics_file):
+  """ Maps the columns of the binary load balancing metrics in `lb_metrics_file`.
+
+  The file is memory mapped and each column is a view of it, so nothing is
+  parsed or copied until the values are used.
+
+  Parameters
+  ----------
+  lb_metrics_file: str
+    A string representing the path to a file written by
+    `FlowMonitor::LbPerformanceMetricsToBinaryFile`, in the format described
+    in ns3/flow-monitor/ipv4-lb-flow-stats.h. The columns are those of the csv
+    format, with addresses as uint32 and all time values as int64 nanoseconds.
+
+  Returns
+  -------
+  dict
+    A dictionary mapping each column name to a read-only numpy array of the
+    values of the column, one per flow.
+
+  """
+  data = np.memmap(lb_metrics_file, dtype=np.uint8, mode="r")
+  if bytes(data[:8]) != config.LB_METRICS_BINARY_MAGIC:
+    raise ValueError("{} is not a binary load balancing metrics file".format(
+      lb_metrics_file))
+  version, num_columns = data[8:16].view("<u4")
+  if version != config.LB_METRICS_BINARY_VERSION:
+    raise ValueError("{} has unsupported version {}".format(
+      lb_metrics_file, version))
+  num_rows = int(data[16:24].view("<u8")[0])
+
+  offset = 24
+  columns = []
+  for _ in range(num_columns):
+    kind = chr(data[offset])
+    size = int(data[offset + 1])
+    name_length = int(data[(offset + 2):(offset + 4)].view("<u2")[0])
+    name = bytes(data[(offset + 4):(offset + 4 + name_length)]).decode("ascii")
+    columns.append((name, np.dtype("<{}{}".format(kind, size))))
+    offset += 4 + name_length
+  offset = _align_to_8(offset)
+
+  metrics = {}
+  for name, dtype in columns:
+    metrics[name] = np.frombuffer(data, dtype=dtype, count=num_rows,
+                                  offset=offset)
+    offset = _align_to_8(offset + num_rows * dtype.itemsize)
+  return metrics
+
+def get_lb_performance_metrics_binary(lb_metrics_file):
+  """ Retrieves the binary load balancing metrics from `lb_metrics_file`.
+
+  Parameters
+  ----------
+  lb_metrics_file: str
+    A string representing the path to a file written by
+    `FlowMonitor::LbPerformanceMetricsToBinaryFile`.
+
+  Returns
+  -------
+  pd.DataFrame
+    A pandas dataframe containing the load balancing performance metrics for
+    a set of flows, with the columns of `get_lb_performance_metrics` except
+    that addresses are uint32 and the `config.TIME_COLS` are int64
+    nanoseconds.
+
+  """
+  return pd.DataFrame(load_lb_performance_metrics_binary(lb_metrics_file),
+                      copy=False)
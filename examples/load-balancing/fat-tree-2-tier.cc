@@ -18,11 +18,14 @@
 #include "ns3/network-module.h"
 #include "ns3/nstime.h"
 #include "ns3/point-to-point-module.h"
+#include "ns3/fat-tree-routing-helper.h"
 #include "ns3/flow-monitor-helper.h"
 #include "ns3/ipv4-global-routing-helper.h"
 
 #include "cdf.h"
+#include "lb-utils.h"
 
+#include <chrono>
 #include <iostream>
 
 // Two-tier leaf spine topology.
@@ -131,7 +134,8 @@ int main(int argc, char* argv[]) {
     double END_TIME = 0.5;
     double FLOW_LAUNCH_END_TIME = 0.2;
 
-    // Setup ECMP routing.
+    // Setup ECMP routing, used as is by packet spraying and as the fallback
+    // of the other schemes.
     Config::SetDefault("ns3::Ipv4GlobalRouting::RandomEcmpRouting", BooleanValue(true));
 
     std::string cdfFileName = "examples/load-balancing/DCTCP_CDF.txt";
@@ -152,6 +156,15 @@ int main(int argc, char* argv[]) {
     // Requests per second
     double requestRate = 1.0; 
 
+    std::string loadBalancingScheme = "packet_spray";
+    uint32_t drillSampleSize = 2;  // Used for DRILL.
+    uint16_t flowletTimeoutUs = 500; // Used for flowlet based schemes.
+
+    // Install the leaf-spine routes directly instead of running SPF from
+    // every node. Interface events reweigh these routes, but an explicit
+    // recomputation of the global routes falls back to the full SPF routes.
+    bool closedFormRouting = false;
+
     CommandLine cmd;
     cmd.AddValue("startTime", "Start time of the simulation", START_TIME);
     cmd.AddValue("endTime", "End time of the simulation", END_TIME);
@@ -172,8 +185,20 @@ int main(int argc, char* argv[]) {
     cmd.AddValue("fixedRequestRate", "Identifies whether the request rate should be a fixed value or based on a calculation", fixedRequestRate);
     cmd.AddValue("requestRate", "The request rate for flow generation (rate at which flows are generated)", requestRate);
 
+    cmd.AddValue("loadBalancingScheme", "The load balancing scheme used in the experiment", loadBalancingScheme);
+    cmd.AddValue("drillSampleSize", "The number of ports DRILL samples when making per packet choices", drillSampleSize);
+    cmd.AddValue("flowletTimeoutUs", "The flowlet timeout in microseconds", flowletTimeoutUs);
+    cmd.AddValue("closedFormRouting", "Install the leaf-spine routes directly rather than with global routing", closedFormRouting);
+
     cmd.Parse(argc, argv);
 
+    LbScheme lbScheme = StringToLbScheme(loadBalancingScheme);
+    if (lbScheme == LbScheme::UNKNOWN) {
+        NS_LOG_ERROR("Must specify a valid load balancing scheme");
+        return -1;
+    }
+    NS_LOG_INFO("Load balancing scheme: " << LbSchemeToString(lbScheme));
+
     uint64_t SPINE_LEAF_CAPACITY = spineToLeafCapacity * LINK_CAPACITY_BASE;
     uint64_t LEAF_SERVER_CAPACITY = leafToServerCapacity * LINK_CAPACITY_BASE;
     Time LINK_LATENCY = MicroSeconds(linkLatency);
@@ -187,9 +212,8 @@ int main(int argc, char* argv[]) {
     NodeContainer servers;
     servers.Create(SERVER_COUNT * LEAF_COUNT);
 
-    InternetStackHelper internet;
-    Ipv4GlobalRoutingHelper globalRoutingHelper;
-    internet.SetRoutingHelper(globalRoutingHelper);
+    InternetStackHelper internet = ConfigureLoadBalancing(
+        lbScheme, drillSampleSize, flowletTimeoutUs);
 
     internet.Install(servers);
     internet.Install(spines);
@@ -237,7 +261,24 @@ int main(int argc, char* argv[]) {
         }
     }
 
-    Ipv4GlobalRoutingHelper::PopulateRoutingTables();
+    for (int leaf_idx = 0; leaf_idx < LEAF_COUNT; leaf_idx++) {
+        NodeContainer leafServers;
+        for (int server_num = 0; server_num < SERVER_COUNT; server_num++) {
+            leafServers.Add(servers.Get((leaf_idx * SERVER_COUNT) + server_num));
+        }
+        SetLbLeaf(lbScheme, leaves.Get(leaf_idx), leaf_idx, leafServers);
+    }
+
+    auto routingStart = std::chrono::steady_clock::now();
+    if (closedFormRouting) {
+        FatTreeRoutingHelper fatTreeRouting(spines, leaves);
+        fatTreeRouting.PopulateRoutingTables();
+    } else {
+        PopulateLbRoutingTables(lbScheme);
+    }
+    std::chrono::duration<double> routingTime =
+        std::chrono::steady_clock::now() - routingStart;
+    NS_LOG_INFO("Routes populated in " << routingTime.count() << " s");
 
     // Oversubscription ratio: ratio of total capacity of server to leaf links
     // (max volume of traffic that can enter network) to total capacity of
@@ -1,9 +1,13 @@
 #include "lb-utils.h"
 
+#include "ns3/ipv4-clove-routing-helper.h"
+#include "ns3/ipv4-conga-routing-helper.h"
 #include "ns3/ipv4-drill-routing-helper.h"
 #include "ns3/ipv4-ecmp-flow-routing-helper.h"
 #include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/ipv4-hermes-routing-helper.h"
 #include "ns3/ipv4-letflow-routing-helper.h"
+#include "ns3/ipv4-presto-routing-helper.h"
 #include "ns3/nstime.h"
 
 using namespace ns3;
@@ -19,6 +23,18 @@ void SetLogging(LbScheme lbScheme, LogLevel level) {
     case LbScheme::LETFLOW:
       LogComponentEnable("Ipv4LetFlowRouting", level);
       break;
+    case LbScheme::CONGA:
+      LogComponentEnable("Ipv4CongaRouting", level);
+      break;
+    case LbScheme::PRESTO:
+      LogComponentEnable("Ipv4PrestoRouting", level);
+      break;
+    case LbScheme::HERMES:
+      LogComponentEnable("Ipv4HermesRouting", level);
+      break;
+    case LbScheme::CLOVE:
+      LogComponentEnable("Ipv4CloveRouting", level);
+      break;
     default:
       LogComponentEnable("Ipv4GlobalRouting", level);
       break;
@@ -52,6 +68,36 @@ InternetStackHelper ConfigureLoadBalancing(LbScheme lbScheme,
         internet.SetRoutingHelper(letflowRouting);
         break;
       }
+    case LbScheme::CONGA:
+      {
+        Config::SetDefault("ns3::Ipv4CongaRouting::FlowletTimeout",
+                           TimeValue(MicroSeconds(flowletTimeoutUs)));
+        Ipv4CongaRoutingHelper congaRouting;
+        internet.SetRoutingHelper(congaRouting);
+        break;
+      }
+    case LbScheme::PRESTO:
+      {
+        Ipv4PrestoRoutingHelper prestoRouting;
+        internet.SetRoutingHelper(prestoRouting);
+        break;
+      }
+    case LbScheme::HERMES:
+      {
+        Config::SetDefault("ns3::Ipv4HermesRouting::FlowletTimeout",
+                           TimeValue(MicroSeconds(flowletTimeoutUs)));
+        Ipv4HermesRoutingHelper hermesRouting;
+        internet.SetRoutingHelper(hermesRouting);
+        break;
+      }
+    case LbScheme::CLOVE:
+      {
+        Config::SetDefault("ns3::Ipv4CloveRouting::FlowletTimeout",
+                           TimeValue(MicroSeconds(flowletTimeoutUs)));
+        Ipv4CloveRoutingHelper cloveRouting;
+        internet.SetRoutingHelper(cloveRouting);
+        break;
+      }
     default:
       {
         Ipv4GlobalRoutingHelper globalRouting;
@@ -73,8 +119,34 @@ void PopulateLbRoutingTables(LbScheme lbScheme) {
     case LbScheme::LETFLOW:
       Ipv4LetFlowRoutingHelper::PopulateRoutingTables();
       break;
+    case LbScheme::CONGA:
+      Ipv4CongaRoutingHelper::PopulateRoutingTables();
+      break;
+    case LbScheme::PRESTO:
+      Ipv4PrestoRoutingHelper::PopulateRoutingTables();
+      break;
+    case LbScheme::HERMES:
+      Ipv4HermesRoutingHelper::PopulateRoutingTables();
+      break;
+    case LbScheme::CLOVE:
+      Ipv4CloveRoutingHelper::PopulateRoutingTables();
+      break;
     default:
       Ipv4GlobalRoutingHelper::PopulateRoutingTables();
       break;
   }
 }
+
+void SetLbLeaf(LbScheme lbScheme, Ptr<Node> leaf, uint32_t leafId,
+               NodeContainer hosts) {
+  if (lbScheme == LbScheme::CONGA) {
+    Ipv4CongaRoutingHelper congaRouting;
+    congaRouting.AddLeaf(leaf, leafId, hosts);
+  } else if (lbScheme == LbScheme::HERMES) {
+    Ipv4HermesRoutingHelper hermesRouting;
+    hermesRouting.AddLeaf(leaf, hosts);
+  } else if (lbScheme == LbScheme::CLOVE) {
+    Ipv4CloveRoutingHelper cloveRouting;
+    cloveRouting.AddLeaf(leaf, hosts);
+  }
+}
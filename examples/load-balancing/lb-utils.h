@@ -19,4 +19,10 @@ InternetStackHelper ConfigureLoadBalancing(LbScheme lbScheme,
 
 void PopulateLbRoutingTables(LbScheme lbScheme);
 
+// Registers a leaf switch and the hosts below it with schemes that need to
+// know the topology (CONGA, Hermes, Clove). Does nothing for the other schemes.
+// Must be called after addresses are assigned.
+void SetLbLeaf(LbScheme lbScheme, Ptr<Node> leaf, uint32_t leafId,
+               NodeContainer hosts);
+
 #endif  // LB_UTILS_H
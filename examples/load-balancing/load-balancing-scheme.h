@@ -10,14 +10,22 @@ enum class LbScheme {
   ECMP = 1,
   DRILL = 2,
   LETFLOW = 3,
-  UNKNOWN = 4
+  CONGA = 4,
+  PRESTO = 5,
+  HERMES = 6,
+  CLOVE = 7,
+  UNKNOWN = 8
 };
 
 static std::unordered_map<std::string, LbScheme> const lbSchemesMap = {
   {"packet_spray", LbScheme::PACKET_SPRAY},
   {"ecmp", LbScheme::ECMP},
   {"drill", LbScheme::DRILL},
-  {"letflow", LbScheme::LETFLOW}
+  {"letflow", LbScheme::LETFLOW},
+  {"conga", LbScheme::CONGA},
+  {"presto", LbScheme::PRESTO},
+  {"hermes", LbScheme::HERMES},
+  {"clove", LbScheme::CLOVE}
 };
 
 static std::string LbSchemeToString(LbScheme scheme) {
@@ -30,6 +38,14 @@ static std::string LbSchemeToString(LbScheme scheme) {
       return "drill";
     case LbScheme::LETFLOW:
       return "letflow";
+    case LbScheme::CONGA:
+      return "conga";
+    case LbScheme::PRESTO:
+      return "presto";
+    case LbScheme::HERMES:
+      return "hermes";
+    case LbScheme::CLOVE:
+      return "clove";
     case LbScheme::UNKNOWN:
       return "unknown";
   }
@@ -0,0 +1,115 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "ipv4-clove-routing-helper.h"
+
+#include "ns3/global-router-interface.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("Ipv4CloveRoutingHelper");
+
+Ipv4CloveRoutingHelper::Ipv4CloveRoutingHelper() {}
+
+Ipv4CloveRoutingHelper::Ipv4CloveRoutingHelper(
+	const Ipv4CloveRoutingHelper& o) {
+}
+
+Ipv4CloveRoutingHelper* Ipv4CloveRoutingHelper::Copy(void) const {
+	return new Ipv4CloveRoutingHelper(*this);
+}
+
+Ptr<Ipv4RoutingProtocol>
+Ipv4CloveRoutingHelper::Create(Ptr<Node> node) const {
+	NS_LOG_LOGIC("Adding GlobalRouter interface to node " << node->GetId());
+	Ptr<GlobalRouter> globalRouter = CreateObject<GlobalRouter>();
+	node->AggregateObject(globalRouter);
+
+	NS_LOG_LOGIC("Adding GlobalRouting interface " << node->GetId());
+	Ptr<Ipv4GlobalRouting> globalRouting = CreateObject<Ipv4GlobalRouting>();
+	globalRouter->SetRoutingProtocol(globalRouting);
+
+    Ptr<Ipv4CloveRouting> cloveRouting =
+      CreateObject<Ipv4CloveRouting>(globalRouting);
+	return cloveRouting;
+}
+
+void Ipv4CloveRoutingHelper::PopulateRoutingTables() {
+	GlobalRouteManager::BuildGlobalRoutingDatabase();
+	GlobalRouteManager::InitializeRoutes();
+}
+
+void Ipv4CloveRoutingHelper::RecomputeRoutingTables() {
+	GlobalRouteManager::DeleteGlobalRoutes();
+	GlobalRouteManager::BuildGlobalRoutingDatabase();
+	GlobalRouteManager::InitializeRoutes();
+}
+
+void Ipv4CloveRoutingHelper::UpdateRoutingTables() {
+	GlobalRouteManager::UpdateRoutes();
+}
+
+Ptr<Ipv4CloveRouting>
+Ipv4CloveRoutingHelper::GetCloveRouting(Ptr<Ipv4> ipv4) const {
+	Ptr<Ipv4RoutingProtocol> ipv4rp = ipv4->GetRoutingProtocol();
+	// If the routing protocol can be cast to Ipv4CloveRouting then return
+	// the cast.
+	if (DynamicCast<Ipv4CloveRouting>(ipv4rp)) {
+		return DynamicCast<Ipv4CloveRouting>(ipv4rp);
+	}
+	// If the routing protocol can be cast to Ipv4ListRouting then perform the
+	// cast and iterate through the list searching for a Ipv4CloveRouting.
+	if (DynamicCast<Ipv4ListRouting>(ipv4rp)) {
+		Ptr<Ipv4ListRouting> lrp = DynamicCast<Ipv4ListRouting>(ipv4rp);
+		int16_t priority;
+		for (uint32_t route_idx = 0;
+			 route_idx < lrp->GetNRoutingProtocols();
+			 route_idx++) {
+			Ptr<Ipv4RoutingProtocol> temp = lrp->GetRoutingProtocol(
+				route_idx, priority);
+		    if (DynamicCast<Ipv4CloveRouting>(temp)) {
+		    	return DynamicCast<Ipv4CloveRouting>(temp);
+		    }
+		}
+	}
+	return nullptr;
+}
+
+void Ipv4CloveRoutingHelper::AddLeaf(Ptr<Node> leaf,
+	                                 NodeContainer hosts) const {
+	Ptr<Ipv4> leafIpv4 = leaf->GetObject<Ipv4>();
+	NS_ASSERT_MSG(leafIpv4, "Ipv4 not installed on leaf " << leaf->GetId());
+	Ptr<Ipv4EcmpFlowRouting> leafRouting =
+		DynamicCast<Ipv4EcmpFlowRouting>(leafIpv4->GetRoutingProtocol());
+	Ptr<Ipv4CloveRouting> leafCloveRouting = GetCloveRouting(leafIpv4);
+	if (leafCloveRouting) {
+		leafRouting = leafCloveRouting->GetEcmpRouting();
+	}
+	NS_ASSERT_MSG(leafRouting, "Leaf " << leaf->GetId()
+		<< " does not run ECMP flow routing");
+
+	for (NodeContainer::Iterator host = hosts.Begin(); host != hosts.End();
+		 ++host) {
+		Ptr<Ipv4CloveRouting> hostRouting =
+			GetCloveRouting((*host)->GetObject<Ipv4>());
+		NS_ASSERT_MSG(hostRouting, "Host " << (*host)->GetId()
+			<< " does not run Clove routing");
+		hostRouting->SetLeafRouting(leafRouting);
+	}
+}
+
+int64_t Ipv4CloveRoutingHelper::AssignStreams(NodeContainer c,
+	                                           int64_t stream) const {
+	int64_t currentStream = stream;
+	for (NodeContainer::Iterator i = c.Begin(); i != c.End(); ++i) {
+		Ptr<Ipv4> ipv4 = (*i)->GetObject<Ipv4>();
+		NS_ASSERT_MSG(ipv4, "Ipv4 not installed on node");
+		Ptr<Ipv4CloveRouting> cloveRouting = GetCloveRouting(ipv4);
+		if (cloveRouting) {
+			currentStream += cloveRouting->AssignStreams(currentStream);
+		}
+	}
+	return (currentStream - stream);
+}
+
+}  // namespace ns3
\ No newline at end of file
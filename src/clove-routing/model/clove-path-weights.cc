@@ -0,0 +1,64 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "clove-path-weights.h"
+
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("ClovePathWeights");
+
+ClovePathWeights::ClovePathWeights() {}
+
+void ClovePathWeights::Configure(const std::vector<uint16_t>& ports) {
+	NS_LOG_FUNCTION(this << ports.size());
+	NS_ASSERT_MSG(!ports.empty(), "Clove needs at least one path");
+	m_ports = ports;
+	m_weights.assign(ports.size(), 1.0 / ports.size());
+	m_nextReduceTimes.assign(ports.size(), Time(0));
+}
+
+uint32_t ClovePathWeights::GetNPaths() const {
+	return m_ports.size();
+}
+
+uint16_t ClovePathWeights::GetPort(uint32_t path) const {
+	return m_ports[path];
+}
+
+double ClovePathWeights::GetWeight(uint32_t path) const {
+	return m_weights[path];
+}
+
+uint32_t ClovePathWeights::Choose(double u) const {
+	double sum = 0;
+	for (uint32_t path = 0; path + 1 < m_weights.size(); path++) {
+		sum += m_weights[path];
+		if (u < sum) {
+			return path;
+		}
+	}
+	// Rounding may leave u above the sum of all but the last weight.
+	return m_weights.size() - 1;
+}
+
+bool ClovePathWeights::ReduceWeight(uint32_t path, double fraction,
+	                                Time now, Time holdTime) {
+	uint32_t nPaths = m_weights.size();
+	if (nPaths < 2 || now < m_nextReduceTimes[path]) {
+		return false;
+	}
+	m_nextReduceTimes[path] = now + holdTime;
+	double moved = m_weights[path] * fraction;
+	m_weights[path] -= moved;
+	for (uint32_t other = 0; other < nPaths; other++) {
+		if (other != path) {
+			m_weights[other] += moved / (nPaths - 1);
+		}
+	}
+	NS_LOG_LOGIC(this << " Path " << path << " weight down to "
+		<< m_weights[path]);
+	return true;
+}
+
+}  // namespace ns3
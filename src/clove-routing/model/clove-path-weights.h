@@ -0,0 +1,85 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef CLOVE_PATH_WEIGHTS_H
+#define CLOVE_PATH_WEIGHTS_H
+
+#include "ns3/nstime.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup clove-routing
+ *
+ * \brief The paths from a host to one destination and their weights.
+ *
+ * Each path is named by the source port that makes the ECMP hashes of the
+ * switches send a flow on it. The weights sum to 1 and start equal. When a
+ * path reports congestion, a fraction of its weight is taken away and spread
+ * evenly over the other paths, so traffic shifts away from congested paths
+ * and flows back as the others report congestion in turn.
+ *
+ * The state of a destination is a few small arrays, one entry per path.
+ */
+class ClovePathWeights {
+public:
+	ClovePathWeights();
+
+	/**
+	 * \brief Sets the paths, with equal weights.
+	 *
+	 * \param ports the source port of each path.
+	 */
+	void Configure(const std::vector<uint16_t>& ports);
+
+	/**
+	 * \returns the number of paths.
+	 */
+	uint32_t GetNPaths() const;
+
+	/**
+	 * \param path the path index.
+	 * \returns the source port of the path.
+	 */
+	uint16_t GetPort(uint32_t path) const;
+
+	/**
+	 * \param path the path index.
+	 * \returns the weight of the path.
+	 */
+	double GetWeight(uint32_t path) const;
+
+	/**
+	 * \brief Picks a path with probability equal to its weight.
+	 *
+	 * \param u a uniform sample in [0, 1).
+	 * \returns the path index.
+	 */
+	uint32_t Choose(double u) const;
+
+	/**
+	 * \brief Shifts weight away from a path that reported congestion.
+	 *
+	 * A path loses weight at most once per holdTime, so that the marks of
+	 * one congestion episode, echoed by many ACKs, count once.
+	 *
+	 * \param path the path index.
+	 * \param fraction the fraction of its weight the path loses.
+	 * \param now the current time.
+	 * \param holdTime the time before the path may lose weight again.
+	 * \returns true if the weights changed.
+	 */
+	bool ReduceWeight(uint32_t path, double fraction, Time now,
+		              Time holdTime);
+
+private:
+	std::vector<uint16_t> m_ports;
+	std::vector<double> m_weights;
+	// The time from which each path may lose weight again.
+	std::vector<Time> m_nextReduceTimes;
+};
+
+}  // namespace ns3
+
+#endif  // CLOVE_PATH_WEIGHTS_H
@@ -0,0 +1,331 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "ipv4-clove-routing.h"
+
+#include "ns3/double.h"
+#include "ns3/flow-key-tag.h"
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/object.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/tcp-l4-protocol.h"
+#include "ns3/uinteger.h"
+
+#include <map>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("Ipv4CloveRouting");
+
+NS_OBJECT_ENSURE_REGISTERED(Ipv4CloveRouting);
+
+TypeId Ipv4CloveRouting::GetTypeId(void) {
+	static TypeId tid = TypeId("ns3::Ipv4CloveRouting")
+	    .SetParent<Object>()
+	    .SetGroupName("CloveRouting")
+	    .AddAttribute("FlowletTimeout",
+	                  "The gap after which the packets of a flow start a new "
+	                  "flowlet that may take another path",
+	                  TimeValue(MicroSeconds(150)),
+	                  MakeTimeAccessor(&Ipv4CloveRouting::m_flowletTimeout),
+	                  MakeTimeChecker())
+	    .AddAttribute("EcnReduction",
+	                  "The fraction of its weight a path loses when an ACK "
+	                  "of a flow on it echoes ECN",
+	                  DoubleValue(1.0 / 3),
+	                  MakeDoubleAccessor(&Ipv4CloveRouting::m_ecnReduction),
+	                  MakeDoubleChecker<double>(0, 1))
+	    .AddAttribute("WeightHoldTime",
+	                  "The time before a path that lost weight may lose "
+	                  "weight again, about one RTT",
+	                  TimeValue(MicroSeconds(100)),
+	                  MakeTimeAccessor(&Ipv4CloveRouting::m_weightHoldTime),
+	                  MakeTimeChecker())
+	    .AddAttribute("BasePort",
+	                  "The first source port tried to find the paths to a "
+	                  "destination",
+	                  UintegerValue(49152),
+	                  MakeUintegerAccessor(&Ipv4CloveRouting::m_basePort),
+	                  MakeUintegerChecker<uint16_t>())
+	    .AddAttribute("PathPorts",
+	                  "The number of source ports tried to find the paths to "
+	                  "a destination",
+	                  UintegerValue(64),
+	                  MakeUintegerAccessor(&Ipv4CloveRouting::m_pathPorts),
+	                  MakeUintegerChecker<uint32_t>(1, 65536))
+	    .AddAttribute("DstPort",
+	                  "The destination port of the flow keys of flowlets, "
+	                  "the port of the overlay encapsulation",
+	                  UintegerValue(4789),
+	                  MakeUintegerAccessor(&Ipv4CloveRouting::m_dstPort),
+	                  MakeUintegerChecker<uint16_t>())
+	    .AddAttribute("IdleTimeout",
+	                  "The time after which a flow that sent nothing is "
+	                  "forgotten",
+	                  TimeValue(MilliSeconds(10)),
+	                  MakeTimeAccessor(&Ipv4CloveRouting::m_idleTimeout),
+	                  MakeTimeChecker());
+	return tid;
+}
+
+Ipv4CloveRouting::Ipv4CloveRouting(Ptr<Ipv4GlobalRouting> globalRouting)
+	: m_flowletTimeout(MicroSeconds(150)),
+	  m_ecnReduction(1.0 / 3),
+	  m_weightHoldTime(MicroSeconds(100)),
+	  m_basePort(49152),
+	  m_pathPorts(64),
+	  m_dstPort(4789),
+	  m_idleTimeout(MilliSeconds(10)),
+	  m_ipv4(nullptr),
+	  m_tcpConnected(false),
+	  m_leafRouting(nullptr),
+	  m_flowlets(0) {
+	NS_LOG_FUNCTION(this);
+	m_rand = CreateObject<UniformRandomVariable>();
+	m_ecmpRouting = CreateObject<Ipv4EcmpFlowRouting>(globalRouting);
+}
+
+Ipv4CloveRouting::~Ipv4CloveRouting() {
+	NS_LOG_FUNCTION(this);
+}
+
+Ptr<Ipv4Route> Ipv4CloveRouting::RouteOutput(Ptr<Packet> p,
+	                                         const Ipv4Header& header,
+	                                         Ptr<NetDevice> oif,
+	                                         Socket::SocketErrno& sockerr) {
+	NS_LOG_FUNCTION(this << p << &header << oif << &sockerr);
+	Ptr<Ipv4Route> route = m_ecmpRouting->RouteOutput(p, header, oif, sockerr);
+	if (route == nullptr || p == nullptr || m_leafRouting == nullptr ||
+		header.GetProtocol() != TcpL4Protocol::PROT_NUMBER ||
+		header.GetDestination().IsMulticast() ||
+		header.GetDestination().IsBroadcast()) {
+		return route;
+	}
+	if (!m_tcpConnected) {
+		Ptr<TcpL4Protocol> tcp = m_ipv4->GetObject<TcpL4Protocol>();
+		if (tcp != nullptr) {
+			tcp->TraceConnectWithoutContext(
+				"AckReceived",
+				MakeCallback(&Ipv4CloveRouting::AckReceived, this));
+			m_tcpConnected = true;
+		}
+	}
+
+	uint64_t flowKey = FlowKeyTag::ExtractFlowKey(p);
+	if (flowKey == 0) {
+		return route;
+	}
+	// The switches hash the packet as they will receive it.
+	Ipv4Header outer = header;
+	outer.SetSource(route->GetSource());
+	uint16_t port = ChoosePath(flowKey, outer);
+	FlowKeyTag flowKeyTag(FlowKeyTag::ConstructFlowKey(
+		outer.GetSource(), outer.GetDestination(), port, m_dstPort,
+		outer.GetProtocol()));
+	p->ReplacePacketTag(flowKeyTag);
+	return route;
+}
+
+bool Ipv4CloveRouting::RouteInput(Ptr<const Packet> p,
+	                              const Ipv4Header& header,
+	                              Ptr<const NetDevice> idev,
+	                              UnicastForwardCallback ucb,
+	                              MulticastForwardCallback mcb,
+	                              LocalDeliverCallback lcb,
+	                              ErrorCallback ecb) {
+	NS_LOG_LOGIC(this << " Route Input: " << p << " IP header: " << header);
+	return m_ecmpRouting->RouteInput(p, header, idev, ucb, mcb, lcb, ecb);
+}
+
+uint64_t Ipv4CloveRouting::GetDestinationKey(Ipv4Address dst,
+	                                         uint8_t protocol) {
+	return (static_cast<uint64_t>(dst.Get()) << 8) | protocol;
+}
+
+ClovePathWeights& Ipv4CloveRouting::GetDestination(
+	const Ipv4Header& header) {
+	uint64_t key =
+		GetDestinationKey(header.GetDestination(), header.GetProtocol());
+	auto destinationItr = m_destinations.find(key);
+	if (destinationItr != m_destinations.end()) {
+		return destinationItr->second;
+	}
+
+	// Keep the first source port found for each route of the leaf. The TTL
+	// is part of the hash, and the leaf sees the one the host sets.
+	Ipv4Header probe = header;
+	UintegerValue ttl(64);
+	m_ipv4->GetAttributeFailSafe("DefaultTtl", ttl);
+	probe.SetTtl(ttl.Get());
+	std::map<int32_t, uint16_t> routePorts;
+	for (uint32_t i = 0; i < m_pathPorts; i++) {
+		uint16_t port = m_basePort + i;
+		int32_t routeIndex = m_leafRouting->GetRouteIndex(
+			probe, FlowKeyTag::ConstructFlowKey(
+				header.GetSource(), header.GetDestination(), port, m_dstPort,
+				header.GetProtocol()));
+		if (routeIndex < 0) {
+			break;
+		}
+		routePorts.insert(std::make_pair(routeIndex, port));
+	}
+	std::vector<uint16_t> ports;
+	for (const auto& routePort : routePorts) {
+		ports.push_back(routePort.second);
+	}
+	if (ports.empty()) {
+		ports.push_back(m_basePort);
+	}
+	NS_LOG_LOGIC(this << " Found " << ports.size() << " paths to "
+		<< header.GetDestination());
+
+	ClovePathWeights& weights = m_destinations[key];
+	weights.Configure(ports);
+	return weights;
+}
+
+uint16_t Ipv4CloveRouting::ChoosePath(uint64_t flowKey,
+	                                  const Ipv4Header& header) {
+	Time now = Simulator::Now();
+	if (now - m_lastFlowSweep > m_idleTimeout) {
+		ForgetIdleFlows();
+	}
+	ClovePathWeights& weights = GetDestination(header);
+
+	auto flowItr = m_flows.find(flowKey);
+	if (flowItr == m_flows.end()) {
+		Flow& flow = m_flows[flowKey];
+		flow.destination =
+			GetDestinationKey(header.GetDestination(), header.GetProtocol());
+		flow.path = weights.Choose(m_rand->GetValue());
+		flow.lastSendTime = now;
+		m_flowlets++;
+		NS_LOG_LOGIC(this << " New flow " << flowKey << " to "
+			<< header.GetDestination() << " on path " << flow.path);
+		return weights.GetPort(flow.path);
+	}
+
+	Flow& flow = flowItr->second;
+	if (now - flow.lastSendTime > m_flowletTimeout) {
+		// A new flowlet cannot be reordered with the packets before it.
+		flow.path = weights.Choose(m_rand->GetValue());
+		m_flowlets++;
+		NS_LOG_LOGIC(this << " Flow " << flowKey << " starts a flowlet on "
+			<< "path " << flow.path);
+	}
+	flow.lastSendTime = now;
+	return weights.GetPort(flow.path);
+}
+
+void Ipv4CloveRouting::AckReceived(uint64_t flowKey, uint32_t bytesAcked,
+	                               bool ecnEcho, Time rtt) {
+	if (!ecnEcho) {
+		return;
+	}
+	auto flowItr = m_flows.find(flowKey);
+	if (flowItr == m_flows.end()) {
+		return;
+	}
+	const Flow& flow = flowItr->second;
+	auto destinationItr = m_destinations.find(flow.destination);
+	if (destinationItr == m_destinations.end()) {
+		return;
+	}
+	destinationItr->second.ReduceWeight(flow.path, m_ecnReduction,
+		                                Simulator::Now(), m_weightHoldTime);
+}
+
+void Ipv4CloveRouting::ForgetIdleFlows() {
+	Time now = Simulator::Now();
+	for (auto flowItr = m_flows.begin(); flowItr != m_flows.end();) {
+		if (now - flowItr->second.lastSendTime > m_idleTimeout) {
+			flowItr = m_flows.erase(flowItr);
+		} else {
+			++flowItr;
+		}
+	}
+	m_lastFlowSweep = now;
+}
+
+Ptr<Ipv4EcmpFlowRouting> Ipv4CloveRouting::GetEcmpRouting() const {
+	return m_ecmpRouting;
+}
+
+void Ipv4CloveRouting::SetLeafRouting(Ptr<Ipv4EcmpFlowRouting> leafRouting) {
+	NS_LOG_FUNCTION(this << leafRouting);
+	m_leafRouting = leafRouting;
+	m_flows.clear();
+	m_destinations.clear();
+}
+
+const ClovePathWeights* Ipv4CloveRouting::GetPathWeights(
+	Ipv4Address dst, uint8_t protocol) const {
+	auto destinationItr =
+		m_destinations.find(GetDestinationKey(dst, protocol));
+	if (destinationItr == m_destinations.end()) {
+		return nullptr;
+	}
+	return &destinationItr->second;
+}
+
+uint64_t Ipv4CloveRouting::GetFlowlets() const {
+	return m_flowlets;
+}
+
+void Ipv4CloveRouting::NotifyInterfaceUp(uint32_t interface) {
+	m_ecmpRouting->NotifyInterfaceUp(interface);
+}
+
+void Ipv4CloveRouting::NotifyInterfaceDown(uint32_t interface) {
+	m_ecmpRouting->NotifyInterfaceDown(interface);
+}
+
+void Ipv4CloveRouting::NotifyAddAddress(
+	uint32_t interface, Ipv4InterfaceAddress address) {
+	m_ecmpRouting->NotifyAddAddress(interface, address);
+}
+
+void Ipv4CloveRouting::NotifyRemoveAddress(
+	uint32_t interface, Ipv4InterfaceAddress address) {
+	m_ecmpRouting->NotifyRemoveAddress(interface, address);
+}
+
+void Ipv4CloveRouting::SetIpv4(Ptr<Ipv4> ipv4) {
+	NS_LOG_LOGIC(this << " Setting up IPv4: " << ipv4);
+	NS_ASSERT(m_ipv4 == nullptr && ipv4 != nullptr);
+	m_ipv4 = ipv4;
+	m_ecmpRouting->SetIpv4(ipv4);
+}
+
+void Ipv4CloveRouting::PrintRoutingTable(Ptr<OutputStreamWrapper> stream,
+	                                     Time::Unit unit) const {
+	m_ecmpRouting->PrintRoutingTable(stream, unit);
+}
+
+void Ipv4CloveRouting::DoDispose(void) {
+	NS_LOG_FUNCTION(this);
+	m_flows.clear();
+	m_destinations.clear();
+	m_leafRouting = nullptr;
+	m_ipv4 = nullptr;
+	m_ecmpRouting->Dispose();
+	m_ecmpRouting = nullptr;
+}
+
+uint32_t Ipv4CloveRouting::GetNRoutes() const {
+	NS_LOG_FUNCTION(this);
+	return m_ecmpRouting->GetNRoutes();
+}
+
+Ipv4RoutingTableEntry* Ipv4CloveRouting::GetRoute(uint32_t i) const {
+	NS_LOG_FUNCTION(this << " " << i);
+	return m_ecmpRouting->GetRoute(i);
+}
+
+int64_t Ipv4CloveRouting::AssignStreams(int64_t stream) {
+	NS_LOG_FUNCTION(this << stream);
+	m_rand->SetStream(stream);
+	return 1;
+}
+
+}  // namespace ns3
@@ -0,0 +1,219 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef IPV4_CLOVE_ROUTING_H
+#define IPV4_CLOVE_ROUTING_H
+
+#include "ns3/clove-path-weights.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/ipv4-ecmp-flow-routing.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/object.h"
+#include "ns3/packet.h"
+#include "ns3/node.h"
+#include "ns3/nstime.h"
+#include "ns3/random-variable-stream.h"
+
+#include <unordered_map>
+
+namespace ns3 {
+
+/**
+ * \ingroup clove-routing
+ *
+ * \brief Clove edge load balancing over ECMP switches.
+ *
+ * Implements Clove-ECN from "Clove: Congestion-Aware Load Balancing at the
+ * Virtual Edge". The switches are left alone: every node hashes flows on
+ * their flow key like Ipv4EcmpFlowRouting. Hosts steer their flowlets by
+ * rewriting the flow key of the packets they send, which plays the part of
+ * the outer header of the overlay encapsulation of Clove: the flow key of a
+ * flowlet is built from a source port picked for its path and DstPort.
+ *
+ * A host finds the paths to a destination by asking the ECMP routing of its
+ * leaf which route each of PathPorts source ports from BasePort takes, as
+ * the traceroutes of Clove do, and keeps one port per route. The weights of
+ * the paths are kept per destination in a ClovePathWeights. A new flow or
+ * flowlet, after a gap of FlowletTimeout, picks a path with probability
+ * equal to its weight. An ACK of a flow that echoes ECN takes EcnReduction
+ * of the weight of the path of the flow and spreads it over the other paths,
+ * at most once per WeightHoldTime for each path.
+ *
+ * Hosts without a leaf (see Ipv4CloveRoutingHelper::AddLeaf) route like
+ * Ipv4EcmpFlowRouting.
+ *
+ * Clove only steers TCP flows; packets of other protocols route like
+ * Ipv4EcmpFlowRouting. The ECN echoes that weigh the paths come from TCP
+ * ACKs, and UDP sockets call RouteOutput before UdpL4Protocol tags the flow
+ * key, which it then overwrites, so a UDP path could not be kept anyway.
+ */
+class Ipv4CloveRouting : public Ipv4RoutingProtocol {
+public:
+	Ipv4CloveRouting(Ptr<Ipv4GlobalRouting> globalRouting);
+	~Ipv4CloveRouting();
+
+	static TypeId GetTypeId();
+
+	// Inherited from Ipv4RoutingProtocol.
+	Ptr<Ipv4Route> RouteOutput(
+		Ptr<Packet> p, const Ipv4Header& header, Ptr<NetDevice> oif,
+		Socket::SocketErrno& sockerr) override;
+	bool RouteInput(
+		Ptr<const Packet> p, const Ipv4Header& header,
+		Ptr<const NetDevice> idev, UnicastForwardCallback ucb,
+		MulticastForwardCallback mcb, LocalDeliverCallback lcb,
+		ErrorCallback ecb) override;
+	void NotifyInterfaceUp(uint32_t interface) override;
+	void NotifyInterfaceDown(uint32_t interface) override;
+	void NotifyAddAddress(uint32_t interface,
+		                  Ipv4InterfaceAddress address) override;
+	void NotifyRemoveAddress(uint32_t interface,
+		                     Ipv4InterfaceAddress address) override;
+	void SetIpv4(Ptr<Ipv4> ipv4) override;
+	void PrintRoutingTable(Ptr<OutputStreamWrapper> stream,
+		                   Time::Unit unit = Time::S) const override;
+
+	/**
+	 * \brief Get the number of individual unicast routes that have been
+	 * added to the routing table.
+	 */
+	uint32_t GetNRoutes() const;
+
+	/**
+	 * \brief Get a route from the unicast routing table.
+	 *
+	 * \param i The index (into the routing table) of the route to retrieve.
+	 *
+	 * \return If the route is set, a pointer to that Ipv4RoutingTableEntry
+	 * is returned, otherwise, nullptr is returned.
+	 */
+	Ipv4RoutingTableEntry* GetRoute(uint32_t i) const;
+
+	virtual void DoDispose(void) override;
+
+	/**
+	 * \returns the ECMP routing this node forwards with.
+	 */
+	Ptr<Ipv4EcmpFlowRouting> GetEcmpRouting() const;
+
+	/**
+	 * \brief Sets the ECMP routing of the leaf of this host, which tells the
+	 * paths to each destination. Forgets what is known of the paths.
+	 *
+	 * \param leafRouting the ECMP routing of the leaf.
+	 */
+	void SetLeafRouting(Ptr<Ipv4EcmpFlowRouting> leafRouting);
+
+	/**
+	 * \brief Gets the paths to a destination and their weights.
+	 *
+	 * \param dst the destination address.
+	 * \param protocol the IP protocol of the flows.
+	 * \returns the paths, or nullptr if the host never sent to the
+	 * destination.
+	 */
+	const ClovePathWeights* GetPathWeights(Ipv4Address dst,
+		                                   uint8_t protocol) const;
+
+	/**
+	 * \returns the number of flowlets that started on a path.
+	 */
+	uint64_t GetFlowlets() const;
+
+	/**
+	 * Assign a fixed random variable stream number to the random variables
+	 * used by this model.  Return the number of streams (possibly zero) that
+	 * have been assigned.
+	 *
+	 * \param stream first stream index to use
+	 * \return the number of stream indices assigned by this model
+	 */
+	int64_t AssignStreams(int64_t stream);
+
+private:
+	// The path a flow sent by this host is on.
+	struct Flow {
+		// The key of the paths of the flow in m_destinations.
+		uint64_t destination = 0;
+		uint32_t path = 0;
+		Time lastSendTime;
+	};
+
+	/**
+	 * \param dst the destination address.
+	 * \param protocol the IP protocol.
+	 * \returns the key of the paths to the destination in m_destinations.
+	 */
+	static uint64_t GetDestinationKey(Ipv4Address dst, uint8_t protocol);
+
+	/**
+	 * \brief Gets the paths to a destination, finding them if needed.
+	 *
+	 * \param header the header of the packet sent to the destination, with
+	 * the source of its route.
+	 * \returns the paths to the destination.
+	 */
+	ClovePathWeights& GetDestination(const Ipv4Header& header);
+
+	/**
+	 * \brief Picks the path of a packet sent by this host.
+	 *
+	 * \param flowKey the key of the flow of the packet.
+	 * \param header the header of the packet, with the source of its route.
+	 * \returns the source port of the path.
+	 */
+	uint16_t ChoosePath(uint64_t flowKey, const Ipv4Header& header);
+
+	/**
+	 * \brief Receives the report of an ACK from TcpL4Protocol.
+	 *
+	 * \param flowKey the key of the flow the ACK acknowledged data of.
+	 * \param bytesAcked the number of bytes newly acknowledged.
+	 * \param ecnEcho whether the ACK carried an ECN echo.
+	 * \param rtt the latest RTT sample of the flow.
+	 */
+	void AckReceived(uint64_t flowKey, uint32_t bytesAcked, bool ecnEcho,
+		             Time rtt);
+
+	/**
+	 * \brief Forgets the flows that sent nothing for IdleTimeout.
+	 */
+	void ForgetIdleFlows();
+
+	// A uniform random number generator for path choices.
+	Ptr<UniformRandomVariable> m_rand;
+
+	Time m_flowletTimeout;
+	double m_ecnReduction;
+	Time m_weightHoldTime;
+	uint16_t m_basePort;
+	uint32_t m_pathPorts;
+	uint16_t m_dstPort;
+	Time m_idleTimeout;
+
+	// Ipv4 address associated with this router.
+	Ptr<Ipv4> m_ipv4;
+
+	// Whether the ACK reports of TCP are connected. TCP is installed after
+	// the routing protocol, so this is done with the first packet sent.
+	bool m_tcpConnected;
+
+	// The ECMP routing of the leaf of this host, if any.
+	Ptr<Ipv4EcmpFlowRouting> m_leafRouting;
+
+	std::unordered_map<uint64_t, Flow> m_flows;
+	std::unordered_map<uint64_t, ClovePathWeights> m_destinations;
+
+	Time m_lastFlowSweep;
+
+	uint64_t m_flowlets;
+
+	// Clove keeps the switches as they are, so every node forwards with
+	// ECMP flow routing over the routes of global routing.
+	Ptr<Ipv4EcmpFlowRouting> m_ecmpRouting;
+};
+
+}  // namespace ns3
+
+#endif  // IPV4_CLOVE_ROUTING_H
@@ -0,0 +1,411 @@
+#include "ns3/clove-path-weights.h"
+#include "ns3/double.h"
+#include "ns3/flow-key-tag.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/ipv4-clove-routing-helper.h"
+#include "ns3/ipv4-clove-routing.h"
+#include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/log.h"
+#include "ns3/node-container.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/pointer.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simulator.h"
+#include "ns3/tcp-l4-protocol.h"
+#include "ns3/test.h"
+#include "ns3/uinteger.h"
+
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("Ipv4CloveRoutingTestSuite");
+
+/**
+ * \defgroup clove-routing-tests Tests for clove-routing
+ * \ingroup clove-routing
+ * \ingroup tests
+ * 
+ * This test suite tests the path weights of Clove hosts, how hosts find the
+ * paths to a destination over ECMP switches, and how the ECN echoes of the
+ * ACKs of their flows move weight between paths.
+ */
+
+/// The number of spines of the networks of BuildLeafSpine.
+static const uint32_t CLOVE_SPINES = 4;
+
+/**
+ * \ingroup clove-routing-tests
+ * 
+ * \brief Builds two leaves with a host each, joined by CLOVE_SPINES spines,
+ * with Clove on every node and the leaf of the first host added.
+ * 
+ * \param hosts The hosts, created by the function.
+ * \param leaves The leaves, created by the function.
+ * \return The addresses of the hosts.
+ */
+static std::vector<Ipv4Address> BuildLeafSpine(NodeContainer& hosts,
+                                               NodeContainer& leaves) {
+  NodeContainer spines;
+  spines.Create(CLOVE_SPINES);
+  leaves.Create(2);
+  hosts.Create(2);
+
+  InternetStackHelper internet;
+  Ipv4CloveRoutingHelper cloveRouting;
+  internet.SetRoutingHelper(cloveRouting);
+  internet.Install(spines);
+  internet.Install(leaves);
+  internet.Install(hosts);
+
+  SimpleNetDeviceHelper simpleHelper;
+  simpleHelper.SetNetDevicePointToPointMode(true);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase("10.0.0.0", "255.255.255.252");
+  std::vector<Ipv4Address> hostAddresses;
+  for (uint32_t leaf = 0; leaf < 2; leaf++) {
+    Ipv4InterfaceContainer interfaces = ipv4.Assign(simpleHelper.Install(
+      NodeContainer(hosts.Get(leaf), leaves.Get(leaf)),
+      CreateObject<SimpleChannel>()));
+    hostAddresses.push_back(interfaces.GetAddress(0));
+    ipv4.NewNetwork();
+    for (uint32_t spine = 0; spine < CLOVE_SPINES; spine++) {
+      ipv4.Assign(simpleHelper.Install(
+        NodeContainer(leaves.Get(leaf), spines.Get(spine)),
+        CreateObject<SimpleChannel>()));
+      ipv4.NewNetwork();
+    }
+  }
+  Ipv4CloveRoutingHelper::PopulateRoutingTables();
+  cloveRouting.AddLeaf(leaves.Get(0), NodeContainer(hosts.Get(0)));
+  return hostAddresses;
+}
+
+/**
+ * \ingroup clove-routing-tests
+ * 
+ * \brief Clove path weights test.
+ * 
+ * Checks that paths are picked in proportion to their weights and that a
+ * path that reports congestion gives weight to the others, once per hold
+ * time.
+ */
+class PathWeightsTest : public TestCase {
+public:
+  void DoRun() override;
+  PathWeightsTest();
+};
+
+PathWeightsTest::PathWeightsTest()
+  : TestCase("Clove path weights shift away from congested paths") {}
+
+void PathWeightsTest::DoRun() {
+  ClovePathWeights weights;
+  weights.Configure({49152, 49153, 49160, 49170});
+  NS_TEST_ASSERT_MSG_EQ(weights.GetNPaths(), 4, "Four paths were set");
+  NS_TEST_ASSERT_MSG_EQ(weights.GetPort(2), 49160, "Paths keep their ports");
+  NS_TEST_ASSERT_MSG_EQ_TOL(weights.GetWeight(0), 0.25, 1e-9,
+                            "Paths start with equal weights");
+  NS_TEST_ASSERT_MSG_EQ(weights.Choose(0.1), 0, "Samples pick paths by weight");
+  NS_TEST_ASSERT_MSG_EQ(weights.Choose(0.3), 1, "Samples pick paths by weight");
+  NS_TEST_ASSERT_MSG_EQ(weights.Choose(0.99), 3, "Samples pick paths by weight");
+
+  bool reduced = weights.ReduceWeight(0, 0.4, MicroSeconds(10),
+                                      MicroSeconds(100));
+  NS_TEST_ASSERT_MSG_EQ(reduced, true, "A congested path loses weight");
+  NS_TEST_ASSERT_MSG_EQ_TOL(weights.GetWeight(0), 0.15, 1e-9,
+                            "The path loses the fraction of its weight");
+  NS_TEST_ASSERT_MSG_EQ_TOL(weights.GetWeight(1), 0.25 + 0.1 / 3, 1e-9,
+                            "The other paths share the weight lost");
+  NS_TEST_ASSERT_MSG_EQ(weights.Choose(0.2), 1,
+                        "The lighter path is picked less often");
+
+  reduced = weights.ReduceWeight(0, 0.4, MicroSeconds(50), MicroSeconds(100));
+  NS_TEST_ASSERT_MSG_EQ(reduced, false,
+                        "A path loses weight once per hold time");
+  reduced = weights.ReduceWeight(1, 0.4, MicroSeconds(50), MicroSeconds(100));
+  NS_TEST_ASSERT_MSG_EQ(reduced, true, "Paths are held separately");
+  reduced = weights.ReduceWeight(0, 0.4, MicroSeconds(110), MicroSeconds(100));
+  NS_TEST_ASSERT_MSG_EQ(reduced, true,
+                        "A path may lose weight again after the hold time");
+
+  double sum = 0;
+  for (uint32_t path = 0; path < weights.GetNPaths(); path++) {
+    sum += weights.GetWeight(path);
+  }
+  NS_TEST_ASSERT_MSG_EQ_TOL(sum, 1, 1e-9, "The weights sum to 1");
+
+  ClovePathWeights single;
+  single.Configure({49152});
+  NS_TEST_ASSERT_MSG_EQ(single.ReduceWeight(0, 0.4, Seconds(0), Seconds(0)),
+                        false, "A single path keeps its weight");
+}
+
+/**
+ * \ingroup clove-routing-tests
+ * 
+ * \brief Clove path discovery test.
+ * 
+ * A host below a leaf with four uplinks finds a source port for each of
+ * them from the ECMP hash of the leaf, and sends its flows with the flow
+ * key of one of the ports. Packets that are not TCP keep their flow key.
+ */
+class PathDiscoveryTest : public TestCase {
+public:
+  void DoRun() override;
+  PathDiscoveryTest();
+};
+
+PathDiscoveryTest::PathDiscoveryTest()
+  : TestCase("Clove hosts find a source port for each path") {}
+
+void PathDiscoveryTest::DoRun() {
+  const uint32_t nSpines = CLOVE_SPINES;
+  NodeContainer hosts;
+  NodeContainer leaves;
+  std::vector<Ipv4Address> hostAddresses = BuildLeafSpine(hosts, leaves);
+  Ipv4CloveRoutingHelper cloveRouting;
+
+  Ptr<Ipv4CloveRouting> hostRouting =
+    cloveRouting.GetCloveRouting(hosts.Get(0)->GetObject<Ipv4>());
+  Ptr<Ipv4EcmpFlowRouting> leafRouting =
+    cloveRouting.GetCloveRouting(leaves.Get(0)->GetObject<Ipv4>())
+      ->GetEcmpRouting();
+
+  const uint8_t protocol = 6;
+  Ptr<Packet> packet = Create<Packet>(100);
+  uint64_t flowKey = FlowKeyTag::ConstructFlowKey(
+    hostAddresses[0], hostAddresses[1], 1234, 80, protocol);
+  packet->AddPacketTag(FlowKeyTag(flowKey));
+  Ipv4Header header;
+  header.SetSource(hostAddresses[0]);
+  header.SetDestination(hostAddresses[1]);
+  header.SetProtocol(protocol);
+  Socket::SocketErrno sockerr;
+  Ptr<Ipv4Route> route =
+    hostRouting->RouteOutput(packet, header, nullptr, sockerr);
+  NS_TEST_ASSERT_MSG_NE(route, nullptr, "The host has a route");
+
+  const ClovePathWeights* weights =
+    hostRouting->GetPathWeights(hostAddresses[1], protocol);
+  NS_TEST_ASSERT_MSG_NE(weights, nullptr, "The host found the paths");
+  NS_TEST_ASSERT_MSG_EQ(weights->GetNPaths(), nSpines,
+                        "The host found a path over each uplink");
+
+  // Paths are ordered by the route of the leaf they take.
+  header.SetTtl(64);
+  uint64_t pathKey = FlowKeyTag::ExtractFlowKey(packet);
+  bool onPath = false;
+  for (uint32_t path = 0; path < weights->GetNPaths(); path++) {
+    uint64_t key = FlowKeyTag::ConstructFlowKey(
+      hostAddresses[0], hostAddresses[1], weights->GetPort(path), 4789,
+      protocol);
+    NS_TEST_ASSERT_MSG_EQ(leafRouting->GetRouteIndex(header, key),
+                          static_cast<int32_t>(path),
+                          "The port of a path takes its uplink");
+    onPath = onPath || key == pathKey;
+  }
+  NS_TEST_ASSERT_MSG_EQ(onPath, true,
+                        "The packet carries the flow key of a path");
+  NS_TEST_ASSERT_MSG_EQ(hostRouting->GetFlowlets(), 1,
+                        "The flow started a flowlet");
+
+  const uint8_t udp = 17;
+  Ptr<Packet> udpPacket = Create<Packet>(100);
+  uint64_t udpKey = FlowKeyTag::ConstructFlowKey(
+    hostAddresses[0], hostAddresses[1], 1234, 80, udp);
+  udpPacket->AddPacketTag(FlowKeyTag(udpKey));
+  header.SetProtocol(udp);
+  NS_TEST_ASSERT_MSG_NE(hostRouting->RouteOutput(udpPacket, header, nullptr,
+                                                 sockerr),
+                        nullptr, "The host has a route for UDP");
+  NS_TEST_ASSERT_MSG_EQ(FlowKeyTag::ExtractFlowKey(udpPacket), udpKey,
+                        "UDP packets keep their flow key");
+  NS_TEST_ASSERT_MSG_EQ(hostRouting->GetFlowlets(), 1,
+                        "UDP packets start no flowlet");
+
+  Simulator::Destroy();
+}
+
+/**
+ * \ingroup clove-routing-tests
+ * 
+ * \brief Clove ECN feedback test.
+ * 
+ * h0 sends a flow to h1 and reports the ACKs of the flow as TCP would. An
+ * ACK echoing ECN must take EcnReduction of the weight of the path of the
+ * flow and spread it over the other paths, at most once per WeightHoldTime,
+ * while ACKs without ECN or of unknown flows change nothing. New flows must
+ * then avoid a path whose weight is gone.
+ */
+class EcnFeedbackTest : public TestCase {
+public:
+  void DoRun() override;
+  EcnFeedbackTest();
+
+private:
+  /**
+   * \brief Sends a packet of a TCP flow from h0 to h1 through the routing of
+   * h0.
+   * 
+   * \param routing The Clove routing of h0.
+   * \param hostAddresses The addresses of h0 and h1.
+   * \param sport The source port of the flow.
+   * \return The path the packet is sent on, or the number of paths if its
+   * flow key matches none.
+   */
+  static uint32_t Send(Ptr<Ipv4CloveRouting> routing,
+                       const std::vector<Ipv4Address>& hostAddresses,
+                       uint16_t sport);
+
+  /**
+   * \brief Checks the weights of the paths to h1.
+   * 
+   * \param weights The weights of the paths to h1.
+   * \param path The path of the flow.
+   * \param weight The expected weight of the path of the flow, the other
+   * paths sharing the rest.
+   * \param msg The message of a failure.
+   */
+  void CheckWeights(const ClovePathWeights* weights, uint32_t path,
+                    double weight, std::string msg);
+};
+
+EcnFeedbackTest::EcnFeedbackTest()
+  : TestCase("Clove moves weight off paths whose ACKs echo ECN") {}
+
+uint32_t EcnFeedbackTest::Send(Ptr<Ipv4CloveRouting> routing,
+                               const std::vector<Ipv4Address>& hostAddresses,
+                               uint16_t sport) {
+  const uint8_t protocol = TcpL4Protocol::PROT_NUMBER;
+  Ptr<Packet> packet = Create<Packet>(100);
+  packet->AddPacketTag(FlowKeyTag(FlowKeyTag::ConstructFlowKey(
+    hostAddresses[0], hostAddresses[1], sport, 80, protocol)));
+  Ipv4Header header;
+  header.SetDestination(hostAddresses[1]);
+  header.SetProtocol(protocol);
+  Socket::SocketErrno sockerr;
+  routing->RouteOutput(packet, header, nullptr, sockerr);
+
+  const ClovePathWeights* weights =
+    routing->GetPathWeights(hostAddresses[1], protocol);
+  uint64_t pathKey = FlowKeyTag::ExtractFlowKey(packet);
+  uint32_t path = 0;
+  while (path < weights->GetNPaths() &&
+         pathKey != FlowKeyTag::ConstructFlowKey(
+           hostAddresses[0], hostAddresses[1], weights->GetPort(path), 4789,
+           protocol)) {
+    path++;
+  }
+  return path;
+}
+
+void EcnFeedbackTest::CheckWeights(const ClovePathWeights* weights,
+                                   uint32_t path, double weight,
+                                   std::string msg) {
+  for (uint32_t other = 0; other < weights->GetNPaths(); other++) {
+    double expected = other == path
+      ? weight : (1 - weight) / (weights->GetNPaths() - 1);
+    NS_TEST_ASSERT_MSG_EQ_TOL(weights->GetWeight(other), expected, 1e-9,
+                              msg << " (path " << other << ")");
+  }
+}
+
+void EcnFeedbackTest::DoRun() {
+  NodeContainer hosts;
+  NodeContainer leaves;
+  std::vector<Ipv4Address> hostAddresses = BuildLeafSpine(hosts, leaves);
+  Ipv4CloveRoutingHelper cloveRouting;
+  Ptr<Ipv4CloveRouting> routing =
+    cloveRouting.GetCloveRouting(hosts.Get(0)->GetObject<Ipv4>());
+  Ptr<TcpL4Protocol> tcp = hosts.Get(0)->GetObject<TcpL4Protocol>();
+  const double reduction = 1.0 / 3;
+  const Time holdTime = MicroSeconds(100);
+  routing->SetAttribute("EcnReduction", DoubleValue(reduction));
+  routing->SetAttribute("WeightHoldTime", TimeValue(holdTime));
+
+  // The host reports ACKs with the flow key of the socket, not of the path.
+  uint32_t path = Send(routing, hostAddresses, 1234);
+  const ClovePathWeights* weights =
+    routing->GetPathWeights(hostAddresses[1], TcpL4Protocol::PROT_NUMBER);
+  NS_TEST_ASSERT_MSG_NE(weights, nullptr, "The host found the paths");
+  NS_TEST_ASSERT_MSG_EQ(weights->GetNPaths(), CLOVE_SPINES,
+                        "The host found a path over each uplink");
+  NS_TEST_ASSERT_MSG_LT(path, CLOVE_SPINES, "The flow takes a path");
+  double weight = 1.0 / CLOVE_SPINES;
+  tcp->NotifyAckReceived(hostAddresses[0], hostAddresses[1], 1234, 80, 100,
+                         false, MicroSeconds(50));
+  CheckWeights(weights, path, weight, "An ACK without ECN changed weights");
+
+  tcp->NotifyAckReceived(hostAddresses[0], hostAddresses[1], 1234, 80, 100,
+                         true, MicroSeconds(50));
+  weight *= 1 - reduction;
+  CheckWeights(weights, path, weight, "An ECN echo did not move weight");
+  tcp->NotifyAckReceived(hostAddresses[0], hostAddresses[1], 1234, 80, 100,
+                         true, MicroSeconds(50));
+  CheckWeights(weights, path, weight, "Weight moved within the hold time");
+  tcp->NotifyAckReceived(hostAddresses[0], hostAddresses[1], 4321, 80, 100,
+                         true, MicroSeconds(50));
+  CheckWeights(weights, path, weight, "An unknown flow moved weight");
+
+  Simulator::Stop(holdTime);
+  Simulator::Run();
+  tcp->NotifyAckReceived(hostAddresses[0], hostAddresses[1], 1234, 80, 100,
+                         true, MicroSeconds(50));
+  weight *= 1 - reduction;
+  CheckWeights(weights, path, weight, "Weight did not move after the hold "
+                                      "time");
+
+  // A path that loses all its weight takes no new flow.
+  routing->SetAttribute("EcnReduction", DoubleValue(1));
+  Simulator::Stop(holdTime);
+  Simulator::Run();
+  tcp->NotifyAckReceived(hostAddresses[0], hostAddresses[1], 1234, 80, 100,
+                         true, MicroSeconds(50));
+  CheckWeights(weights, path, 0, "The weight of the path is not gone");
+  std::set<uint32_t> paths;
+  for (uint16_t sport = 2000; sport < 2064; sport++) {
+    paths.insert(Send(routing, hostAddresses, sport));
+  }
+  NS_TEST_ASSERT_MSG_EQ(paths.count(path), 0,
+                        "A new flow took the path without weight");
+  NS_TEST_ASSERT_MSG_EQ(paths.size(), CLOVE_SPINES - 1,
+                        "New flows spread over the other paths");
+
+  Simulator::Destroy();
+}
+
+/**
+ * \ingroup clove-routing-tests
+ * TestSuite for module clove-routing
+ */
+class CloveRoutingTestSuite : public TestSuite
+{
+  public:
+    CloveRoutingTestSuite();
+};
+
+CloveRoutingTestSuite::CloveRoutingTestSuite()
+    : TestSuite("ipv4-clove-routing", UNIT)
+{
+    // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
+    AddTestCase(new PathWeightsTest, TestCase::QUICK);
+    AddTestCase(new PathDiscoveryTest, TestCase::QUICK);
+    AddTestCase(new EcnFeedbackTest, TestCase::QUICK);
+}
+
+// Do not forget to allocate an instance of this TestSuite
+/**
+ * \ingroup clove-routing-tests
+ * Static variable for test initialization
+ */
+static CloveRoutingTestSuite scloveRoutingTestSuite;
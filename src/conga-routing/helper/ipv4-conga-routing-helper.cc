@@ -0,0 +1,124 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "ipv4-conga-routing-helper.h"
+
+#include "ns3/global-router-interface.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/log.h"
+#include "ns3/node-list.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("Ipv4CongaRoutingHelper");
+
+Ipv4CongaRoutingHelper::Ipv4CongaRoutingHelper() {}
+
+Ipv4CongaRoutingHelper::Ipv4CongaRoutingHelper(
+	const Ipv4CongaRoutingHelper& o) {
+}
+
+Ipv4CongaRoutingHelper* Ipv4CongaRoutingHelper::Copy(void) const {
+	return new Ipv4CongaRoutingHelper(*this);
+}
+
+Ptr<Ipv4RoutingProtocol>
+Ipv4CongaRoutingHelper::Create(Ptr<Node> node) const {
+	NS_LOG_LOGIC("Adding GlobalRouter interface to node " << node->GetId());
+	Ptr<GlobalRouter> globalRouter = CreateObject<GlobalRouter>();
+	node->AggregateObject(globalRouter);
+
+	NS_LOG_LOGIC("Adding GlobalRouting interface " << node->GetId());
+	Ptr<Ipv4GlobalRouting> globalRouting = CreateObject<Ipv4GlobalRouting>();
+	globalRouter->SetRoutingProtocol(globalRouting);
+
+	Ptr<Ipv4CongaRouting> congaRouting =
+		CreateObject<Ipv4CongaRouting>(globalRouting);
+	return congaRouting;
+}
+
+void Ipv4CongaRoutingHelper::PopulateRoutingTables() {
+	GlobalRouteManager::BuildGlobalRoutingDatabase();
+	GlobalRouteManager::InitializeRoutes();
+}
+
+void Ipv4CongaRoutingHelper::RecomputeRoutingTables() {
+	GlobalRouteManager::DeleteGlobalRoutes();
+	GlobalRouteManager::BuildGlobalRoutingDatabase();
+	GlobalRouteManager::InitializeRoutes();
+}
+
+void Ipv4CongaRoutingHelper::UpdateRoutingTables() {
+	GlobalRouteManager::UpdateRoutes();
+}
+
+Ptr<Ipv4CongaRouting>
+Ipv4CongaRoutingHelper::GetCongaRouting(Ptr<Ipv4> ipv4) const {
+	Ptr<Ipv4RoutingProtocol> ipv4rp = ipv4->GetRoutingProtocol();
+	// If the routing protocol can be cast to Ipv4CongaRouting then return
+	// the cast.
+	if (DynamicCast<Ipv4CongaRouting>(ipv4rp)) {
+		return DynamicCast<Ipv4CongaRouting>(ipv4rp);
+	}
+	// If the routing protocol can be cast to Ipv4ListRouting then perform the
+	// cast and iterate through the list searching for a Ipv4CongaRouting.
+	if (DynamicCast<Ipv4ListRouting>(ipv4rp)) {
+		Ptr<Ipv4ListRouting> lrp = DynamicCast<Ipv4ListRouting>(ipv4rp);
+		int16_t priority;
+		for (uint32_t route_idx = 0;
+			 route_idx < lrp->GetNRoutingProtocols();
+			 route_idx++) {
+			Ptr<Ipv4RoutingProtocol> temp = lrp->GetRoutingProtocol(
+				route_idx, priority);
+			if (DynamicCast<Ipv4CongaRouting>(temp)) {
+				return DynamicCast<Ipv4CongaRouting>(temp);
+			}
+		}
+	}
+	return nullptr;
+}
+
+void Ipv4CongaRoutingHelper::AddLeaf(Ptr<Node> leaf, uint32_t leafId,
+	                                 NodeContainer hosts) const {
+	Ptr<Ipv4CongaRouting> leafRouting =
+		GetCongaRouting(leaf->GetObject<Ipv4>());
+	NS_ASSERT_MSG(leafRouting, "Leaf " << leaf->GetId()
+		<< " does not run CONGA routing");
+	leafRouting->SetLeafId(leafId);
+
+	// Every router needs the map: leaves use it to find the destination leaf
+	// and the other switches ignore it.
+	for (NodeContainer::Iterator host = hosts.Begin(); host != hosts.End();
+		 ++host) {
+		Ptr<Ipv4> hostIpv4 = (*host)->GetObject<Ipv4>();
+		// Interface 0 is the loopback.
+		for (uint32_t i = 1; i < hostIpv4->GetNInterfaces(); i++) {
+			for (uint32_t j = 0; j < hostIpv4->GetNAddresses(i); j++) {
+				Ipv4Address addr = hostIpv4->GetAddress(i, j).GetLocal();
+				for (NodeList::Iterator node = NodeList::Begin();
+					 node != NodeList::End(); ++node) {
+					Ptr<Ipv4> ipv4 = (*node)->GetObject<Ipv4>();
+					Ptr<Ipv4CongaRouting> routing =
+						ipv4 ? GetCongaRouting(ipv4) : nullptr;
+					if (routing) {
+						routing->AddAddressToLeafIdMap(addr, leafId);
+					}
+				}
+			}
+		}
+	}
+}
+
+int64_t Ipv4CongaRoutingHelper::AssignStreams(NodeContainer c,
+	                                          int64_t stream) const {
+	int64_t currentStream = stream;
+	for (NodeContainer::Iterator i = c.Begin(); i != c.End(); ++i) {
+		Ptr<Ipv4> ipv4 = (*i)->GetObject<Ipv4>();
+		NS_ASSERT_MSG(ipv4, "Ipv4 not installed on node");
+		Ptr<Ipv4CongaRouting> congaRouting = GetCongaRouting(ipv4);
+		if (congaRouting) {
+			currentStream += congaRouting->AssignStreams(currentStream);
+		}
+	}
+	return (currentStream - stream);
+}
+
+}  // namespace ns3
@@ -0,0 +1,101 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef IPV4_CONGA_ROUTING_HELPER_H
+#define IPV4_CONGA_ROUTING_HELPER_H
+
+#include "ns3/ipv4-conga-routing.h"
+#include "ns3/ipv4-routing-helper.h"
+#include "ns3/node-container.h"
+
+namespace ns3 {
+
+class Ipv4CongaRoutingHelper : public Ipv4RoutingHelper {
+public:
+	/**
+	 * \brief Construct a CongaRoutingHelper to more easily manage
+	 * CONGA routing.
+	 */
+	Ipv4CongaRoutingHelper();
+
+	/**
+	 * \brief Construct a CongaRoutingHelper from another previously
+	 * initialized instance (Copy Constructor).
+	 * 
+	 * \param o object to be copied.
+	 */
+	Ipv4CongaRoutingHelper(const Ipv4CongaRoutingHelper& o);
+
+	// Delete assignment operator to avoid misuse.
+	Ipv4CongaRoutingHelper& operator=(
+		const Ipv4CongaRoutingHelper&) = delete;
+
+    /**
+     * \returns pointer to clone of this Ipv4CongaRoutingHelper.
+     */
+	Ipv4CongaRoutingHelper* Copy(void) const override;
+
+    /**
+     * \brief This method is called by ns3::InternetStackHelper::Install.
+     * 
+     * \param node The node on which the routing protocol will run.
+     * 
+     * \returns a newly-created routing protocol.
+     */
+	virtual Ptr<Ipv4RoutingProtocol> Create(Ptr<Node> node) const override;
+
+	/**
+	 * \brief Build a routing database and initialize the routing tables of
+	 * the nodes in the simulation. Makes all nodes in the simulation into
+	 * routers.
+	 */
+	static void PopulateRoutingTables();
+
+	/**
+	 * \brief Remove all routes that were previously installed in a prior call
+	 * to either PopulateRoutingTables() or RecomputeRoutingTables(), and add
+	 * a new set of routes.
+	 */
+	static void RecomputeRoutingTables();
+
+	/**
+	 * \brief Update the routes that were previously installed after links
+	 * went up or down, recomputing only the routes the changes affect. The
+	 * routes are the same as those of RecomputeRoutingTables().
+	 */
+	static void UpdateRoutingTables();
+
+    /**
+     * \brief Retrieve the Ipv4CongaRouting protocol attached to the helper.
+     * 
+     * \param ipv4 The Ptr<Ipv4> to search for the CONGA routing protocol.
+     * 
+     * \returns Ipv4CongaRouting pointer or nullptr if not found.
+     */
+	Ptr<Ipv4CongaRouting> GetCongaRouting(Ptr<Ipv4> ipv4) const;
+
+	/**
+	 * \brief Makes a node a CONGA leaf and tells every CONGA router which
+	 * leaf the hosts below it are attached to.
+	 * 
+	 * Must be called after addresses have been assigned to the hosts.
+	 * 
+	 * \param leaf the leaf switch.
+	 * \param leafId the ID of the leaf, below the MaxLeaves attribute.
+	 * \param hosts the hosts attached to the leaf.
+	 */
+	void AddLeaf(Ptr<Node> leaf, uint32_t leafId, NodeContainer hosts) const;
+
+	/**
+	 * Assign a fixed random variable stream number to the random variables
+	 * used by the CONGA routing protocols on a set of nodes.
+	 * 
+	 * \param c NodeContainer of the set of nodes.
+	 * \param stream first stream index to use.
+	 * 
+	 * \returns the number of stream indices assigned by this helper.
+	 */
+	int64_t AssignStreams(NodeContainer c, int64_t stream) const;
+};
+
+}  // namespace ns3
+
+#endif  // IPV4_CONGA_ROUTING_HELPER_H
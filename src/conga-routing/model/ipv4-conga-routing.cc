@@ -0,0 +1,513 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "ipv4-conga-routing.h"
+
+#include "ipv4-conga-tag.h"
+
+#include "ns3/channel.h"
+#include "ns3/data-rate.h"
+#include "ns3/double.h"
+#include "ns3/flow-key-tag.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/log.h"
+#include "ns3/net-device.h"
+#include "ns3/node.h"
+#include "ns3/object.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("Ipv4CongaRouting");
+
+NS_OBJECT_ENSURE_REGISTERED(Ipv4CongaRouting);
+
+TypeId Ipv4CongaRouting::GetTypeId(void) {
+	static TypeId tid = TypeId("ns3::Ipv4CongaRouting")
+	    .SetParent<Object>()
+	    .SetGroupName("CongaRouting")
+	    .AddAttribute("FlowletTimeout",
+	                  "The minimum inter-packet arrival gap to denote a new "
+	                  "flowlet",
+	                  TimeValue(MicroSeconds(500)),
+	                  MakeTimeAccessor(&Ipv4CongaRouting::m_flowletTimeout),
+	                  MakeTimeChecker())
+	    .AddAttribute("TDre",
+	                  "The period at which DRE registers are decayed",
+	                  TimeValue(MicroSeconds(30)),
+	                  MakeTimeAccessor(&Ipv4CongaRouting::m_tDre),
+	                  MakeTimeChecker())
+	    .AddAttribute("Alpha",
+	                  "The fraction of a DRE register dropped every TDre",
+	                  DoubleValue(0.2),
+	                  MakeDoubleAccessor(&Ipv4CongaRouting::m_alpha),
+	                  MakeDoubleChecker<double>(0.0, 1.0))
+	    .AddAttribute("QuantizeBits",
+	                  "The number of bits congestion is quantized to",
+	                  UintegerValue(3),
+	                  MakeUintegerAccessor(&Ipv4CongaRouting::m_quantizeBits),
+	                  MakeUintegerChecker<uint32_t>(1, 8))
+	    .AddAttribute("AgingTime",
+	                  "How long a Congestion-To-Leaf entry is used without "
+	                  "being refreshed by feedback",
+	                  TimeValue(MilliSeconds(10)),
+	                  MakeTimeAccessor(&Ipv4CongaRouting::m_agingTime),
+	                  MakeTimeChecker())
+	    .AddAttribute("MaxLeaves",
+	                  "The number of leaves the congestion tables have room "
+	                  "for",
+	                  UintegerValue(64),
+	                  MakeUintegerAccessor(&Ipv4CongaRouting::m_maxLeaves),
+	                  MakeUintegerChecker<uint32_t>(1))
+	    .AddAttribute("FlowletTableSize",
+	                  "The number of entries in the flowlet table, rounded "
+	                  "up to a power of 2",
+	                  UintegerValue(65536),
+	                  MakeUintegerAccessor(
+	                      &Ipv4CongaRouting::m_flowletTableSize),
+	                  MakeUintegerChecker<uint32_t>(1, 1u << 31));
+	return tid;
+}
+
+Ipv4CongaRouting::Ipv4CongaRouting(Ptr<Ipv4GlobalRouting> globalRouting)
+	: m_flowletTimeout(MicroSeconds(500)),
+	  m_tDre(MicroSeconds(30)),
+	  m_alpha(0.2),
+	  m_quantizeBits(3),
+	  m_agingTime(MilliSeconds(10)),
+	  m_maxLeaves(64),
+	  m_isLeaf(false),
+	  m_leafId(0),
+	  m_ipv4(nullptr),
+	  m_flowletTableSize(65536),
+	  m_nTablePorts(0),
+	  m_globalRouting(globalRouting) {
+	NS_LOG_FUNCTION(this);
+	m_rand = CreateObject<UniformRandomVariable>();
+}
+
+Ipv4CongaRouting::~Ipv4CongaRouting() {
+	NS_LOG_FUNCTION(this);
+}
+
+Ptr<Ipv4Route> Ipv4CongaRouting::RouteOutput(Ptr<Packet> packet,
+	                                         const Ipv4Header& header,
+	                                         Ptr<NetDevice> oif,
+	                                         Socket::SocketErrno& sockerr) {
+	NS_LOG_FUNCTION(this << packet << &header << oif << &sockerr);
+	// Delegate to Global Routing. CONGA is only implemented in the network
+	// and does not extend to the hosts.
+	return m_globalRouting->RouteOutput(packet, header, oif, sockerr);
+}
+
+bool Ipv4CongaRouting::RouteInput(Ptr<const Packet> p,
+	                              const Ipv4Header& header,
+	                              Ptr<const NetDevice> idev,
+	                              UnicastForwardCallback ucb,
+	                              MulticastForwardCallback mcb,
+	                              LocalDeliverCallback lcb,
+	                              ErrorCallback ecb) {
+	NS_LOG_LOGIC(this << " Route Input: " << p << " IP header: " << header);
+	uint32_t iif = m_ipv4->GetInterfaceForDevice(idev);
+
+	// Check if it this is the intended destination. If so then we call the
+	// local callback (lcb) to push it up the stack.
+	if (m_ipv4->IsDestinationAddress(header.GetDestination(), iif)) {
+		if (!lcb.IsNull()) {
+			NS_LOG_LOGIC("Local delivery to " << header.GetDestination());
+			lcb(p, header, iif);
+			return true;
+		}
+		// The local delivery callback is null.  This may be a multicast
+		// or broadcast packet, so return false so that another
+		// multicast routing protocol can handle it.
+		return false;
+	}
+
+	// CONGA routing only supports unicast.
+	if (header.GetDestination().IsMulticast() ||
+		header.GetDestination().IsBroadcast()) {
+		NS_LOG_ERROR(this << " CONGA routing only supports unicast");
+		ecb(p, header, Socket::ERROR_NOROUTETOHOST);
+		return false;
+	}
+
+	// Check if the input device supports IP forwarding.
+	if (m_ipv4->IsForwarding(iif) == false) {
+		NS_LOG_ERROR(this << " Forwarding is disabled for this interface");
+		ecb(p, header, Socket::ERROR_NOROUTETOHOST);
+		return false;
+	}
+
+	const Ipv4GlobalRouting::RouteGroup& routeEntries =
+		m_globalRouting->GetRoutesToDst(header.GetDestination());
+	if (routeEntries.empty()) {
+		NS_LOG_ERROR(this << " CONGA routing cannot find routing entry");
+		ecb(p, header, Socket::ERROR_NOROUTETOHOST);
+		return false;
+	}
+
+	Time now = Simulator::Now();
+	uint64_t flowKey = FlowKeyTag::ExtractFlowKey(p);
+	uint32_t dstLeafId = 0;
+	bool dstLeafKnown = LookupLeafId(header.GetDestination(), dstLeafId);
+	Ipv4CongaTag congaTag;
+	bool tagged = p->PeekPacketTag(congaTag);
+	if (m_isLeaf && m_nTablePorts == 0) {
+		ConfigureTables();
+	}
+
+	uint32_t selectedPort = 0;
+	if (m_isLeaf && !tagged && dstLeafKnown && dstLeafId != m_leafId) {
+		// Source leaf. Packets of an active flowlet keep its uplink, new
+		// flowlets take the least congested path to the destination leaf.
+		bool activeFlowlet = false;
+		LetFlowFlowlet* flowlet = nullptr;
+		if (flowKey != 0) {
+			if (!m_flowletTable.IsConfigured()) {
+				// The table is large, so only leaves that source flows into
+				// the fabric allocate it.
+				m_flowletTable.Configure(m_flowletTableSize, false);
+			}
+			bool found = false;
+			flowlet = &m_flowletTable.Lookup(
+				flowKey, now, m_flowletTimeout, found);
+			activeFlowlet =
+				found && now - flowlet->activeTime <= m_flowletTimeout;
+		}
+		if (activeFlowlet) {
+			selectedPort = flowlet->port;
+		} else {
+			selectedPort = ChooseCongaPort(routeEntries, dstLeafId);
+			NS_LOG_LOGIC(this << " Creating new flowlet for " << flowKey
+				<< " selected port: " << selectedPort);
+			if (flowlet != nullptr) {
+				flowlet->port = selectedPort;
+			}
+		}
+		if (flowlet != nullptr) {
+			flowlet->activeTime = now;
+		}
+
+		CongaPort& dre = GetDre(selectedPort);
+		dre.dre += p->GetSize() + header.GetSerializedSize();
+
+		congaTag.SetLbTag(selectedPort);
+		congaTag.SetCe(QuantizeDre(dre));
+		// Piggyback one Congestion-From-Leaf entry for the destination
+		// leaf, going round robin over the entries that have been seen.
+		for (uint32_t i = 0; i < m_nTablePorts; i++) {
+			uint32_t port = m_feedbackCursor[dstLeafId];
+			m_feedbackCursor[dstLeafId] = (port + 1) % m_nTablePorts;
+			const CongaMetric& metric =
+				m_congestionFromLeaf[TableIndex(dstLeafId, port)];
+			if (metric.valid) {
+				congaTag.SetFbLbTag(port);
+				congaTag.SetFbMetric(metric.ce);
+				break;
+			}
+		}
+
+		Ptr<Packet> packet = p->Copy();
+		packet->AddPacketTag(congaTag);
+		ucb(ConstructIpv4Route(selectedPort, header.GetDestination()),
+			packet, header);
+		return true;
+	}
+
+	if (m_isLeaf && tagged && dstLeafKnown && dstLeafId == m_leafId) {
+		// Destination leaf. Record the congestion of the path the packet
+		// took and the feedback about the paths towards its source leaf.
+		uint32_t srcLeafId = 0;
+		if (LookupLeafId(header.GetSource(), srcLeafId) &&
+			congaTag.GetLbTag() < m_nTablePorts) {
+			CongaMetric& from =
+				m_congestionFromLeaf[TableIndex(srcLeafId, congaTag.GetLbTag())];
+			from.ce = congaTag.GetCe();
+			from.updateTime = now;
+			from.valid = true;
+			if (congaTag.GetFbLbTag() != 0 &&
+				congaTag.GetFbLbTag() < m_nTablePorts) {
+				CongaMetric& to = m_congestionToLeaf[
+					TableIndex(srcLeafId, congaTag.GetFbLbTag())];
+				to.ce = congaTag.GetFbMetric();
+				to.updateTime = now;
+				to.valid = true;
+			}
+		}
+		// The tag does not leave the fabric.
+		Ptr<Packet> packet = p->Copy();
+		packet->RemovePacketTag(congaTag);
+		selectedPort = ChooseFlowPort(routeEntries, flowKey);
+		CongaPort& dre = GetDre(selectedPort);
+		dre.dre += p->GetSize() + header.GetSerializedSize();
+		ucb(ConstructIpv4Route(selectedPort, header.GetDestination()),
+			packet, header);
+		return true;
+	}
+
+	// Every other hop picks a route per flow and, if the packet is tagged,
+	// raises its congestion to that of the egress port.
+	selectedPort = ChooseFlowPort(routeEntries, flowKey);
+	CongaPort& dre = GetDre(selectedPort);
+	dre.dre += p->GetSize() + header.GetSerializedSize();
+	Ptr<Ipv4Route> route =
+		ConstructIpv4Route(selectedPort, header.GetDestination());
+	uint8_t ce = QuantizeDre(dre);
+	if (tagged && ce > congaTag.GetCe()) {
+		congaTag.SetCe(ce);
+		Ptr<Packet> packet = p->Copy();
+		packet->ReplacePacketTag(congaTag);
+		ucb(route, packet, header);
+		return true;
+	}
+	ucb(route, p, header);
+	return true;
+}
+
+bool Ipv4CongaRouting::LookupLeafId(Ipv4Address addr,
+	                                uint32_t& leafId) const {
+	auto itr = m_leafIdMap.find(addr.Get());
+	if (itr == m_leafIdMap.end()) {
+		return false;
+	}
+	leafId = itr->second;
+	return true;
+}
+
+uint32_t Ipv4CongaRouting::ChooseCongaPort(
+	const Ipv4GlobalRouting::RouteGroup& routeEntries, uint32_t dstLeafId) {
+	NS_LOG_FUNCTION(this << dstLeafId);
+	uint8_t leastCongestion = UINT8_MAX;
+	m_candidatePorts.clear();
+	for (Ipv4RoutingTableEntry* entry : routeEntries) {
+		uint32_t port = entry->GetInterface();
+		uint8_t congestion = std::max(QuantizeDre(GetDre(port)),
+			                          GetCongestionToLeaf(dstLeafId, port));
+		if (congestion < leastCongestion) {
+			leastCongestion = congestion;
+			m_candidatePorts.clear();
+		}
+		if (congestion == leastCongestion) {
+			m_candidatePorts.push_back(port);
+		}
+	}
+	uint32_t idx = m_rand->GetInteger(0, m_candidatePorts.size() - 1);
+	return m_candidatePorts[idx];
+}
+
+uint32_t Ipv4CongaRouting::ChooseFlowPort(
+	const Ipv4GlobalRouting::RouteGroup& routeEntries, uint64_t flowKey) {
+	uint32_t idx = 0;
+	if (flowKey != 0) {
+		idx = flowKey % routeEntries.size();
+	} else {
+		idx = m_rand->GetInteger(0, routeEntries.size() - 1);
+	}
+	return routeEntries[idx]->GetInterface();
+}
+
+CongaPort& Ipv4CongaRouting::GetDre(uint32_t port) {
+	if (port >= m_ports.size()) {
+		m_ports.resize(port + 1);
+	}
+	CongaPort& dre = m_ports[port];
+	Time now = Simulator::Now();
+	if (!dre.bound) {
+		// Devices without a DataRate attribute never look congested.
+		DataRateValue rate;
+		Ptr<NetDevice> dev = m_ipv4->GetNetDevice(port);
+		if (dev->GetAttributeFailSafe("DataRate", rate)) {
+			dre.rate = rate.Get().GetBitRate() / 8.0;
+		}
+		dre.lastDecay = now;
+		dre.bound = true;
+	}
+
+	// Rather than scheduling an event every TDre, apply all the periods
+	// that elapsed since the last decay at once.
+	int64_t periods = 0;
+	if (m_tDre.IsStrictlyPositive()) {
+		periods = (now - dre.lastDecay).GetTimeStep() / m_tDre.GetTimeStep();
+	}
+	if (periods > 0) {
+		dre.dre *= std::pow(1.0 - m_alpha, static_cast<double>(periods));
+		dre.lastDecay += TimeStep(m_tDre.GetTimeStep() * periods);
+	}
+	return dre;
+}
+
+uint8_t Ipv4CongaRouting::QuantizeDre(const CongaPort& dre) const {
+	if (dre.rate <= 0 || m_alpha <= 0) {
+		return 0;
+	}
+	// The register settles at rate * tau bytes for a saturated link, where
+	// tau = TDre / Alpha.
+	double tau = m_tDre.GetSeconds() / m_alpha;
+	double utilization = dre.dre / (dre.rate * tau);
+	uint32_t maxLevel = (1u << m_quantizeBits) - 1;
+	double level = std::floor(utilization * (maxLevel + 1));
+	return static_cast<uint8_t>(std::min(level, static_cast<double>(maxLevel)));
+}
+
+void Ipv4CongaRouting::ConfigureTables() {
+	NS_LOG_FUNCTION(this);
+	// The uplinks are identified by interface index in an 8 bit field.
+	m_nTablePorts = std::min<uint32_t>(m_ipv4->GetNInterfaces(), 256);
+	m_congestionToLeaf.assign(m_maxLeaves * m_nTablePorts, CongaMetric());
+	m_congestionFromLeaf.assign(m_maxLeaves * m_nTablePorts, CongaMetric());
+	m_feedbackCursor.assign(m_maxLeaves, 0);
+}
+
+uint32_t Ipv4CongaRouting::TableIndex(uint32_t leafId, uint32_t port) const {
+	NS_ASSERT_MSG(leafId < m_maxLeaves, "Leaf " << leafId << " exceeds MaxLeaves");
+	return leafId * m_nTablePorts + port;
+}
+
+void Ipv4CongaRouting::SetLeafId(uint32_t leafId) {
+	NS_LOG_FUNCTION(this << leafId);
+	NS_ASSERT_MSG(leafId < m_maxLeaves, "Leaf " << leafId << " exceeds MaxLeaves");
+	m_isLeaf = true;
+	m_leafId = leafId;
+}
+
+void Ipv4CongaRouting::AddAddressToLeafIdMap(Ipv4Address addr,
+	                                         uint32_t leafId) {
+	NS_LOG_FUNCTION(this << addr << leafId);
+	NS_ASSERT_MSG(leafId < m_maxLeaves, "Leaf " << leafId << " exceeds MaxLeaves");
+	m_leafIdMap[addr.Get()] = leafId;
+}
+
+void Ipv4CongaRouting::SetFlowletTimeout(Time timeout) {
+	m_flowletTimeout = timeout;
+}
+
+uint8_t Ipv4CongaRouting::GetLocalCongestion(uint32_t port) {
+	return QuantizeDre(GetDre(port));
+}
+
+uint8_t Ipv4CongaRouting::GetCongestionToLeaf(uint32_t leafId,
+	                                          uint32_t port) const {
+	if (port >= m_nTablePorts) {
+		return 0;
+	}
+	const CongaMetric& metric = m_congestionToLeaf[TableIndex(leafId, port)];
+	// Stale entries are forgotten so that paths that stopped getting
+	// feedback are tried again.
+	if (!metric.valid ||
+		Simulator::Now() - metric.updateTime > m_agingTime) {
+		return 0;
+	}
+	return metric.ce;
+}
+
+uint8_t Ipv4CongaRouting::GetCongestionFromLeaf(uint32_t leafId,
+	                                            uint32_t port) const {
+	if (port >= m_nTablePorts) {
+		return 0;
+	}
+	return m_congestionFromLeaf[TableIndex(leafId, port)].ce;
+}
+
+uint32_t Ipv4CongaRouting::GetFlowletTableCapacity() const {
+	return m_flowletTable.GetCapacity();
+}
+
+int64_t Ipv4CongaRouting::AssignStreams(int64_t stream) {
+	NS_LOG_FUNCTION(this << stream);
+	m_rand->SetStream(stream);
+	return 1;
+}
+
+void Ipv4CongaRouting::NotifyInterfaceUp(uint32_t interface) {
+	m_routeCache.clear();
+	m_ports.clear();
+	m_globalRouting->NotifyInterfaceUp(interface);
+}
+
+void Ipv4CongaRouting::NotifyInterfaceDown(uint32_t interface) {
+	m_routeCache.clear();
+	m_ports.clear();
+	m_globalRouting->NotifyInterfaceDown(interface);
+}
+
+void Ipv4CongaRouting::NotifyAddAddress(
+	uint32_t interface, Ipv4InterfaceAddress address) {
+	m_routeCache.clear();
+	m_globalRouting->NotifyAddAddress(interface, address);
+}
+
+void Ipv4CongaRouting::NotifyRemoveAddress(
+	uint32_t interface, Ipv4InterfaceAddress address) {
+	m_routeCache.clear();
+	m_globalRouting->NotifyRemoveAddress(interface, address);
+}
+
+void Ipv4CongaRouting::SetIpv4(Ptr<Ipv4> ipv4) {
+	NS_LOG_LOGIC(this << " Setting up IPv4: " << ipv4);
+	NS_ASSERT(m_ipv4 == nullptr && ipv4 != nullptr);
+	m_ipv4 = ipv4;
+	m_globalRouting->SetIpv4(ipv4);
+}
+
+void Ipv4CongaRouting::PrintRoutingTable(Ptr<OutputStreamWrapper> stream,
+	                                     Time::Unit unit) const {
+	m_globalRouting->PrintRoutingTable(stream, unit);
+}
+
+void Ipv4CongaRouting::DoDispose(void) {
+	NS_LOG_FUNCTION(this);
+	m_routeCache.clear();
+	m_ports.clear();
+	m_rand = nullptr;
+	m_ipv4 = nullptr;
+	m_globalRouting->DoDispose();
+	m_globalRouting = nullptr;
+}
+
+uint32_t Ipv4CongaRouting::GetNRoutes() const {
+	NS_LOG_FUNCTION(this);
+	return m_globalRouting->GetNRoutes();
+}
+
+Ipv4RoutingTableEntry* Ipv4CongaRouting::GetRoute(uint32_t i) const {
+	NS_LOG_FUNCTION(this << " " << i);
+	return m_globalRouting->GetRoute(i);
+}
+
+Ptr<Ipv4Route>
+Ipv4CongaRouting::ConstructIpv4Route(uint32_t port, Ipv4Address dstAddr) {
+	// Reuse the route if one was already built from this port to the
+	// destination.
+	uint64_t cacheKey = (static_cast<uint64_t>(port) << 32) | dstAddr.Get();
+	auto cacheItr = m_routeCache.find(cacheKey);
+	if (cacheItr != m_routeCache.end()) {
+		return cacheItr->second;
+	}
+
+	// Port and channel to send from on this router.
+	Ptr<NetDevice> dev = m_ipv4->GetNetDevice(port);
+	Ptr<Channel> channel = dev->GetChannel();
+
+	// The next hop is the device on the other end of the point-to-point
+	// channel.
+	uint32_t otherEnd = (channel->GetDevice(0) == dev) ? 1 : 0;
+	Ptr<Node> nextHop = channel->GetDevice(otherEnd)->GetNode();
+	uint32_t nextIf = channel->GetDevice(otherEnd)->GetIfIndex();
+	Ipv4Address nextHopAddr =
+		nextHop->GetObject<Ipv4>()->GetAddress(nextIf, 0).GetLocal();
+
+	Ptr<Ipv4Route> route = Create<Ipv4Route>();
+	route->SetOutputDevice(dev);
+	route->SetGateway(nextHopAddr);
+	route->SetSource(m_ipv4->GetAddress(port, 0).GetLocal());
+	route->SetDestination(dstAddr);
+	m_routeCache[cacheKey] = route;
+	return route;
+}
+
+}  // namespace ns3
@@ -0,0 +1,309 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef IPV4_CONGA_ROUTING_H
+#define IPV4_CONGA_ROUTING_H
+
+#include "ns3/ipv4-address.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/object.h"
+#include "ns3/packet.h"
+#include "ns3/node.h"
+#include "ns3/nstime.h"
+#include "ns3/letflow-flowlet-table.h"
+#include "ns3/random-variable-stream.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace ns3 {
+
+// The DRE (discounting rate estimator) register of a port. Ports are bound
+// lazily since devices only have their rates once the topology is built.
+struct CongaPort {
+	bool bound = false;
+	// The link rate in bytes per second, 0 if the device has no rate.
+	double rate = 0;
+	// The number of bytes sent, decayed by Alpha every TDre.
+	double dre = 0;
+	// The last time the register was decayed.
+	Time lastDecay;
+};
+
+// An entry of the Congestion-To-Leaf or Congestion-From-Leaf table.
+struct CongaMetric {
+	uint8_t ce = 0;
+	Time updateTime;
+	bool valid = false;
+};
+
+/**
+ * \ingroup conga-routing
+ *
+ * \brief CONGA congestion-aware load balancing.
+ *
+ * Implements the scheme from "CONGA: Distributed Congestion-Aware Load
+ * Balancing for Datacenters". Like LetFlow, CONGA switches flowlets, but a
+ * source leaf places each new flowlet on the uplink with the least
+ * congested path to the destination leaf instead of picking one at random.
+ *
+ * Every port keeps a DRE register. The source leaf tags packets with the
+ * chosen uplink and its congestion (see Ipv4CongaTag), every hop raises the
+ * congestion to that of its egress port, and the destination leaf records
+ * it in its Congestion-From-Leaf table. The metrics are piggybacked back to
+ * the source leaf, which keeps them in its Congestion-To-Leaf table. Both
+ * tables have a fixed size of MaxLeaves entries per port.
+ *
+ * Nodes that have no leaf ID (spines) only update the congestion of tagged
+ * packets and pick among equal cost routes per flow.
+ */
+class Ipv4CongaRouting : public Ipv4RoutingProtocol {
+public:
+	Ipv4CongaRouting(Ptr<Ipv4GlobalRouting> globalRouting);
+	~Ipv4CongaRouting();
+
+	static TypeId GetTypeId();
+
+	// Inherited from Ipv4RoutingProtocol.
+	Ptr<Ipv4Route> RouteOutput(
+		Ptr<Packet> p, const Ipv4Header& header, Ptr<NetDevice> oif,
+		Socket::SocketErrno& sockerr) override;
+	bool RouteInput(
+		Ptr<const Packet> p, const Ipv4Header& header,
+		Ptr<const NetDevice> idev, UnicastForwardCallback ucb,
+		MulticastForwardCallback mcb, LocalDeliverCallback lcb,
+		ErrorCallback ecb) override;
+	void NotifyInterfaceUp(uint32_t interface) override;
+	void NotifyInterfaceDown(uint32_t interface) override;
+	void NotifyAddAddress(uint32_t interface,
+		                  Ipv4InterfaceAddress address) override;
+	void NotifyRemoveAddress(uint32_t interface,
+		                     Ipv4InterfaceAddress address) override;
+	void SetIpv4(Ptr<Ipv4> ipv4) override;
+	void PrintRoutingTable(Ptr<OutputStreamWrapper> stream,
+		                   Time::Unit unit = Time::S) const override;
+
+	/**
+	 * \brief Get the number of individual unicast routes that have been
+	 * added to the routing table.
+	 */
+	uint32_t GetNRoutes() const;
+
+	/**
+	 * \brief Get a route from the unicast routing table.
+	 * 
+	 * \param i The index (into the routing table) of the route to retrieve.
+	 * 
+	 * \return If the route is set, a pointer to that Ipv4RoutingTableEntry
+	 * is returned, otherwise, nullptr is returned.
+	 */
+	Ipv4RoutingTableEntry* GetRoute(uint32_t i) const;
+
+	virtual void DoDispose(void) override;
+
+	/**
+	 * \brief Makes this router a leaf.
+	 * 
+	 * \param leafId the ID of the leaf, less than MaxLeaves.
+	 */
+	void SetLeafId(uint32_t leafId);
+
+	/**
+	 * \brief Records the leaf that a host address sits under.
+	 * 
+	 * \param addr the address of the host.
+	 * \param leafId the ID of the leaf, less than MaxLeaves.
+	 */
+	void AddAddressToLeafIdMap(Ipv4Address addr, uint32_t leafId);
+
+    /**
+     * \brief sets the timeout period for flowlets.
+     * 
+     * \param timeout the length of time for the flowlet timeout.
+     */
+	void SetFlowletTimeout(Time timeout);
+
+	/**
+	 * \returns the quantized congestion of a port, measured by its DRE.
+	 * 
+	 * \param port the interface of the port.
+	 */
+	uint8_t GetLocalCongestion(uint32_t port);
+
+	/**
+	 * \returns the congestion of the path from this leaf to a leaf through
+	 * an uplink, 0 if it is unknown or has aged out.
+	 * 
+	 * \param leafId the destination leaf.
+	 * \param port the uplink on this leaf.
+	 */
+	uint8_t GetCongestionToLeaf(uint32_t leafId, uint32_t port) const;
+
+	/**
+	 * \returns the congestion last seen on packets from a leaf that left it
+	 * through an uplink, 0 if none was seen.
+	 * 
+	 * \param leafId the source leaf.
+	 * \param port the uplink on the source leaf.
+	 */
+	uint8_t GetCongestionFromLeaf(uint32_t leafId, uint32_t port) const;
+
+	/**
+	 * \returns the number of entries of the flowlet table, which is only
+	 * allocated when a source leaf forwards its first packet with a flow
+	 * key, so 0 on hosts and spines.
+	 */
+	uint32_t GetFlowletTableCapacity() const;
+
+	/**
+	 * Assign a fixed random variable stream number to the random variables
+	 * used by this model.  Return the number of streams (possibly zero) that
+	 * have been assigned.
+	 *
+	 * \param stream first stream index to use
+	 * \return the number of stream indices assigned by this model
+	 */
+	int64_t AssignStreams(int64_t stream);
+
+private:
+	/**
+	 * \brief Finds the leaf that an address sits under.
+	 * 
+	 * \param addr the address.
+	 * \param leafId set to the leaf of the address if it is known.
+	 * 
+	 * \returns whether the leaf of the address is known.
+	 */
+	bool LookupLeafId(Ipv4Address addr, uint32_t& leafId) const;
+
+	/**
+	 * \brief Picks the uplink with the least congested path to a leaf.
+	 * 
+	 * The congestion of a path is the larger of the local congestion of the
+	 * uplink and its Congestion-To-Leaf entry. Ties are broken at random.
+	 * 
+	 * \param routeEntries the routes to the destination.
+	 * \param dstLeafId the leaf of the destination.
+	 * 
+	 * \returns the interface of the chosen uplink.
+	 */
+	uint32_t ChooseCongaPort(const Ipv4GlobalRouting::RouteGroup& routeEntries,
+		                     uint32_t dstLeafId);
+
+	/**
+	 * \brief Picks one of the routes to the destination for a flow.
+	 * 
+	 * Packets of a flow always take the same route, so switches that do not
+	 * balance the flow do not reorder it. Packets without a flow key take a
+	 * random route.
+	 * 
+	 * \param routeEntries the routes to the destination.
+	 * \param flowKey the key of the flow, 0 if the packet has none.
+	 * 
+	 * \returns the interface of the chosen port.
+	 */
+	uint32_t ChooseFlowPort(const Ipv4GlobalRouting::RouteGroup& routeEntries,
+		                    uint64_t flowKey);
+
+	/**
+	 * \brief Returns the DRE register of a port, decayed up to now.
+	 * 
+	 * \param port the interface of the port.
+	 */
+	CongaPort& GetDre(uint32_t port);
+
+	/**
+	 * \returns the quantized congestion of a DRE register.
+	 * 
+	 * \param dre the register, already decayed.
+	 */
+	uint8_t QuantizeDre(const CongaPort& dre) const;
+
+	/**
+	 * \brief Allocates the congestion tables once the number of interfaces
+	 * is known.
+	 */
+	void ConfigureTables();
+
+	/**
+	 * \returns the index of a leaf and port in the congestion tables.
+	 */
+	uint32_t TableIndex(uint32_t leafId, uint32_t port) const;
+
+    /**
+     * \brief constructs a route to the destination.
+     * 
+     * Routes are cached per (port, destination) pair, so only the first
+     * packet sent from a port to a destination builds the route.
+     * 
+     * \param port the port from which the route will send packets.
+     * \param dstAddr the destination address for the route.
+     * 
+     * \returns Ptr<Ipv4Route> from the chosen port to the destination.
+     */
+    Ptr<Ipv4Route> ConstructIpv4Route(uint32_t port, Ipv4Address dstAddr);
+
+	// A uniform random number generator used to break ties between ports.
+	Ptr<UniformRandomVariable> m_rand;
+
+	// Flowlet timeout (minimum inter-packet gap denoting different flowlets).
+	Time m_flowletTimeout;
+
+	// The DRE period and the fraction of the register dropped each period.
+	Time m_tDre;
+	double m_alpha;
+	// The number of bits congestion is quantized to.
+	uint32_t m_quantizeBits;
+	// How long a Congestion-To-Leaf entry is trusted without feedback.
+	Time m_agingTime;
+	// The number of leaves the congestion tables have room for.
+	uint32_t m_maxLeaves;
+
+	// Whether this router is a leaf, and its ID if so.
+	bool m_isLeaf;
+	uint32_t m_leafId;
+	// The leaf of each known host address.
+	std::unordered_map<uint32_t, uint32_t> m_leafIdMap;
+
+	// Ipv4 address associated with this router.
+	Ptr<Ipv4> m_ipv4;
+
+	// The number of entries in the flowlet table.
+	uint32_t m_flowletTableSize;
+
+	// Flowlet table.
+	LetFlowFlowletTable m_flowletTable;
+
+	// The DRE register of each port, indexed by interface.
+	std::vector<CongaPort> m_ports;
+
+	// The number of ports in each row of the congestion tables, 0 until they
+	// are allocated.
+	uint32_t m_nTablePorts;
+	// Congestion of the paths to each leaf, indexed by leaf and local uplink.
+	std::vector<CongaMetric> m_congestionToLeaf;
+	// Congestion of the paths from each leaf, indexed by leaf and the uplink
+	// of the source leaf.
+	std::vector<CongaMetric> m_congestionFromLeaf;
+	// The next Congestion-From-Leaf entry fed back to each leaf.
+	std::vector<uint32_t> m_feedbackCursor;
+
+	// Ports tied for the least congested path, kept as a member so that
+	// choosing a port does not allocate on the forwarding path.
+	std::vector<uint32_t> m_candidatePorts;
+
+	// Routes built by ConstructIpv4Route, keyed by the port in the upper 32
+	// bits and the destination address in the lower 32 bits. The cache is
+	// cleared whenever an interface or address changes.
+	std::unordered_map<uint64_t, Ptr<Ipv4Route>> m_routeCache;
+
+	// A pointer to an Ipv4GlobalRouting object. CONGA only changes routes
+	// to balance loads but we leverage the existing global routing
+	// capabilities to pre-install routes and maintain the routing table.
+	Ptr<Ipv4GlobalRouting> m_globalRouting;
+};
+
+}  // namespace ns3
+
+#endif  // IPV4_CONGA_ROUTING_H
@@ -0,0 +1,64 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "ipv4-conga-tag.h"
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED(Ipv4CongaTag);
+
+Ipv4CongaTag::Ipv4CongaTag()
+	: m_lbTag(0),
+	  m_ce(0),
+	  m_fbLbTag(0),
+	  m_fbMetric(0) {}
+
+void Ipv4CongaTag::SetLbTag(uint8_t lbTag) { m_lbTag = lbTag; }
+
+uint8_t Ipv4CongaTag::GetLbTag() const { return m_lbTag; }
+
+void Ipv4CongaTag::SetCe(uint8_t ce) { m_ce = ce; }
+
+uint8_t Ipv4CongaTag::GetCe() const { return m_ce; }
+
+void Ipv4CongaTag::SetFbLbTag(uint8_t fbLbTag) { m_fbLbTag = fbLbTag; }
+
+uint8_t Ipv4CongaTag::GetFbLbTag() const { return m_fbLbTag; }
+
+void Ipv4CongaTag::SetFbMetric(uint8_t fbMetric) { m_fbMetric = fbMetric; }
+
+uint8_t Ipv4CongaTag::GetFbMetric() const { return m_fbMetric; }
+
+TypeId Ipv4CongaTag::GetTypeId() {
+	static TypeId tid = TypeId("ns3::Ipv4CongaTag")
+	  .SetParent<Tag>()
+	  .SetGroupName("CongaRouting")
+	  .AddConstructor<Ipv4CongaTag>();
+
+	return tid;
+}
+
+TypeId Ipv4CongaTag::GetInstanceTypeId() const { return GetTypeId(); }
+
+uint32_t Ipv4CongaTag::GetSerializedSize() const { return 4; }
+
+void Ipv4CongaTag::Serialize(TagBuffer i) const {
+	i.WriteU8(m_lbTag);
+	i.WriteU8(m_ce);
+	i.WriteU8(m_fbLbTag);
+	i.WriteU8(m_fbMetric);
+}
+
+void Ipv4CongaTag::Deserialize(TagBuffer i) {
+	m_lbTag = i.ReadU8();
+	m_ce = i.ReadU8();
+	m_fbLbTag = i.ReadU8();
+	m_fbMetric = i.ReadU8();
+}
+
+void Ipv4CongaTag::Print(std::ostream &os) const {
+	os << "LBTag=" << static_cast<uint32_t>(m_lbTag)
+	   << " CE=" << static_cast<uint32_t>(m_ce)
+	   << " FB_LBTag=" << static_cast<uint32_t>(m_fbLbTag)
+	   << " FB_Metric=" << static_cast<uint32_t>(m_fbMetric);
+}
+
+}  // namespace ns3
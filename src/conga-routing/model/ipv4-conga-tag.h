@@ -0,0 +1,60 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef IPV4_CONGA_TAG_H
+#define IPV4_CONGA_TAG_H
+
+#include "ns3/tag.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup conga-routing
+ *
+ * \brief The CONGA overlay header, carried as a packet tag.
+ *
+ * The source leaf stamps the uplink it chose (LBTag) and the congestion
+ * extent (CE) of that uplink. Each hop raises CE to the congestion of its
+ * own egress port, so the destination leaf learns the congestion of the
+ * whole path. The source leaf also piggybacks one entry of its
+ * Congestion-From-Leaf table for the destination leaf (FB_LBTag and
+ * FB_Metric), which is how path congestion flows back to the sender.
+ *
+ * Uplinks are identified by their interface index on the source leaf. As
+ * interface 0 is the loopback, an FB_LBTag of 0 means that the packet
+ * carries no feedback.
+ */
+class Ipv4CongaTag : public Tag {
+public:
+	Ipv4CongaTag();
+
+	void SetLbTag(uint8_t lbTag);
+	uint8_t GetLbTag() const;
+
+	void SetCe(uint8_t ce);
+	uint8_t GetCe() const;
+
+	void SetFbLbTag(uint8_t fbLbTag);
+	uint8_t GetFbLbTag() const;
+
+	void SetFbMetric(uint8_t fbMetric);
+	uint8_t GetFbMetric() const;
+
+	static TypeId GetTypeId();
+	virtual TypeId GetInstanceTypeId() const;
+
+	virtual uint32_t GetSerializedSize() const;
+
+	virtual void Serialize(TagBuffer i) const;
+	virtual void Deserialize(TagBuffer i);
+
+	virtual void Print(std::ostream& os) const;
+
+private:
+	uint8_t m_lbTag;
+	uint8_t m_ce;
+	uint8_t m_fbLbTag;
+	uint8_t m_fbMetric;
+};
+
+}  // namespace ns3
+
+#endif  // IPV4_CONGA_TAG_H
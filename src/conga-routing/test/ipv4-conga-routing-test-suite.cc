@@ -0,0 +1,564 @@
+#include "ns3/data-rate.h"
+#include "ns3/flow-key-tag.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-conga-routing-helper.h"
+#include "ns3/ipv4-conga-routing.h"
+#include "ns3/ipv4-conga-tag.h"
+#include "ns3/ipv4-routing-protocol.h"
+#include "ns3/log.h"
+#include "ns3/node-container.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simulator.h"
+#include "ns3/test.h"
+#include "ns3/uinteger.h"
+
+#include <set>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("Ipv4CongaRoutingTestSuite");
+
+/**
+ * \defgroup conga-routing-tests Tests for conga-routing
+ * \ingroup conga-routing
+ * \ingroup tests
+ * 
+ * This test suite tests the CONGA tag, the DRE registers of CONGA ports,
+ * how leaves fill their Congestion-From-Leaf and Congestion-To-Leaf tables
+ * from the tags and piggybacked feedback of the packets they forward, and
+ * how source leaves place new flowlets on the least congested uplink.
+ */
+
+/// The number of spines of the fabrics of CongaFabric.
+static const uint32_t CONGA_SPINES = 3;
+
+/// The bytes a packet of the tests adds to a DRE: its payload and IP header.
+static const uint32_t CONGA_PACKET_BYTES = 1000 + 20;
+
+/**
+ * \ingroup conga-routing-tests
+ * 
+ * \brief Two leaves with a host each, joined by CONGA_SPINES spines over
+ * 1Gbps links, with CONGA on every node and both leaves added.
+ * 
+ * The tests call RouteInput on the switches directly and hand the packets
+ * from hop to hop themselves.
+ */
+class CongaFabric {
+public:
+  CongaFabric();
+
+  /**
+   * \returns the CONGA routing of a node.
+   * 
+   * \param node the node.
+   */
+  Ptr<Ipv4CongaRouting> GetRouting(Ptr<Node> node) const;
+
+  /**
+   * \returns the interface of a leaf linked to a spine.
+   * 
+   * \param leaf the index of the leaf.
+   * \param spine the index of the spine.
+   */
+  uint32_t GetUplink(uint32_t leaf, uint32_t spine) const;
+
+  /**
+   * \returns the index of the spine an uplink of a leaf is linked to.
+   * 
+   * \param leaf the index of the leaf.
+   * \param port the interface of the uplink.
+   */
+  uint32_t GetSpine(uint32_t leaf, uint32_t port) const;
+
+  /**
+   * \returns a packet of a flow from the host of a leaf to the host of the
+   * other leaf, tagged with the key of the flow.
+   * 
+   * \param srcLeaf the index of the leaf of the source host.
+   * \param sport the source port of the flow.
+   */
+  Ptr<Packet> MakePacket(uint32_t srcLeaf, uint16_t sport) const;
+
+  /**
+   * \brief Hands a packet of a flow from the host of a leaf to a switch.
+   * 
+   * \param node the switch.
+   * \param idev the device of the switch the packet arrives on.
+   * \param srcLeaf the index of the leaf of the source host.
+   * \param packet the packet.
+   * \param route set to the route the switch gives the packet.
+   * 
+   * \returns the packet the switch forwards, nullptr if it drops it.
+   */
+  Ptr<const Packet> Forward(Ptr<Node> node, Ptr<NetDevice> idev,
+                            uint32_t srcLeaf, Ptr<const Packet> packet,
+                            Ptr<Ipv4Route>& route) const;
+
+  NodeContainer hosts;
+  NodeContainer leaves;
+  NodeContainer spines;
+  // The host and leaf devices of the link of each leaf to its host.
+  std::vector<NetDeviceContainer> hostLinks;
+  // The leaf and spine devices of each link, by leaf then spine.
+  std::vector<std::vector<NetDeviceContainer>> uplinks;
+  std::vector<Ipv4Address> hostAddresses;
+
+private:
+  /**
+   * \brief Receives the packets a switch forwards.
+   * 
+   * \param forwarded set to the packet.
+   * \param forwardedRoute set to the route of the packet.
+   * \param route the route of the packet.
+   * \param p the packet.
+   * \param header the IP header of the packet.
+   */
+  static void Capture(Ptr<const Packet>* forwarded,
+                      Ptr<Ipv4Route>* forwardedRoute, Ptr<Ipv4Route> route,
+                      Ptr<const Packet> p, const Ipv4Header& header);
+
+  Ipv4CongaRoutingHelper m_congaRouting;
+};
+
+CongaFabric::CongaFabric() {
+  spines.Create(CONGA_SPINES);
+  leaves.Create(2);
+  hosts.Create(2);
+
+  InternetStackHelper internet;
+  internet.SetRoutingHelper(m_congaRouting);
+  internet.Install(spines);
+  internet.Install(leaves);
+  internet.Install(hosts);
+
+  SimpleNetDeviceHelper simpleHelper;
+  simpleHelper.SetNetDevicePointToPointMode(true);
+  simpleHelper.SetDeviceAttribute("DataRate", DataRateValue(DataRate("1Gbps")));
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase("10.0.0.0", "255.255.255.252");
+  uplinks.resize(2);
+  for (uint32_t leaf = 0; leaf < 2; leaf++) {
+    hostLinks.push_back(simpleHelper.Install(
+      NodeContainer(hosts.Get(leaf), leaves.Get(leaf)),
+      CreateObject<SimpleChannel>()));
+    hostAddresses.push_back(ipv4.Assign(hostLinks[leaf]).GetAddress(0));
+    ipv4.NewNetwork();
+    for (uint32_t spine = 0; spine < CONGA_SPINES; spine++) {
+      uplinks[leaf].push_back(simpleHelper.Install(
+        NodeContainer(leaves.Get(leaf), spines.Get(spine)),
+        CreateObject<SimpleChannel>()));
+      ipv4.Assign(uplinks[leaf][spine]);
+      ipv4.NewNetwork();
+    }
+  }
+  Ipv4CongaRoutingHelper::PopulateRoutingTables();
+  for (uint32_t leaf = 0; leaf < 2; leaf++) {
+    m_congaRouting.AddLeaf(leaves.Get(leaf), leaf,
+                           NodeContainer(hosts.Get(leaf)));
+  }
+  NodeContainer all(spines, leaves, hosts);
+  m_congaRouting.AssignStreams(all, 1);
+}
+
+Ptr<Ipv4CongaRouting> CongaFabric::GetRouting(Ptr<Node> node) const {
+  return m_congaRouting.GetCongaRouting(node->GetObject<Ipv4>());
+}
+
+uint32_t CongaFabric::GetUplink(uint32_t leaf, uint32_t spine) const {
+  return leaves.Get(leaf)->GetObject<Ipv4>()->GetInterfaceForDevice(
+    uplinks[leaf][spine].Get(0));
+}
+
+uint32_t CongaFabric::GetSpine(uint32_t leaf, uint32_t port) const {
+  for (uint32_t spine = 0; spine < CONGA_SPINES; spine++) {
+    if (GetUplink(leaf, spine) == port) {
+      return spine;
+    }
+  }
+  return CONGA_SPINES;
+}
+
+Ptr<Packet> CongaFabric::MakePacket(uint32_t srcLeaf, uint16_t sport) const {
+  const uint8_t protocol = 17;
+  Ptr<Packet> packet = Create<Packet>(1000);
+  packet->AddPacketTag(FlowKeyTag(FlowKeyTag::ConstructFlowKey(
+    hostAddresses[srcLeaf], hostAddresses[1 - srcLeaf], sport, 80,
+    protocol)));
+  return packet;
+}
+
+void CongaFabric::Capture(Ptr<const Packet>* forwarded,
+                          Ptr<Ipv4Route>* forwardedRoute,
+                          Ptr<Ipv4Route> route, Ptr<const Packet> p,
+                          const Ipv4Header& header) {
+  *forwarded = p;
+  *forwardedRoute = route;
+}
+
+Ptr<const Packet> CongaFabric::Forward(Ptr<Node> node, Ptr<NetDevice> idev,
+                                       uint32_t srcLeaf,
+                                       Ptr<const Packet> packet,
+                                       Ptr<Ipv4Route>& route) const {
+  Ipv4Header header;
+  header.SetSource(hostAddresses[srcLeaf]);
+  header.SetDestination(hostAddresses[1 - srcLeaf]);
+  header.SetProtocol(17);
+  header.SetTtl(64);
+  Ptr<const Packet> forwarded = nullptr;
+  route = nullptr;
+  GetRouting(node)->RouteInput(
+    packet, header, idev,
+    MakeBoundCallback(&CongaFabric::Capture, &forwarded, &route),
+    Ipv4RoutingProtocol::MulticastForwardCallback(),
+    Ipv4RoutingProtocol::LocalDeliverCallback(),
+    Ipv4RoutingProtocol::ErrorCallback());
+  return forwarded;
+}
+
+/**
+ * \brief Runs the simulator until an absolute time.
+ * 
+ * \param time the time to stop at.
+ */
+static void AdvanceTo(Time time) {
+  Simulator::Stop(time - Simulator::Now());
+  Simulator::Run();
+}
+
+/**
+ * \returns the interface a route sends packets from on a node.
+ * 
+ * \param node the node.
+ * \param route the route.
+ */
+static uint32_t RoutePort(Ptr<Node> node, Ptr<Ipv4Route> route) {
+  return node->GetObject<Ipv4>()->GetInterfaceForDevice(
+    route->GetOutputDevice());
+}
+
+/**
+ * \ingroup conga-routing-tests
+ * 
+ * \brief CONGA tag test.
+ * 
+ * Checks that the load balancing and feedback fields survive being carried
+ * on a packet.
+ */
+class CongaTagTest : public TestCase {
+public:
+  void DoRun() override;
+  CongaTagTest();
+};
+
+CongaTagTest::CongaTagTest()
+  : TestCase("CONGA tag carries congestion and feedback") {}
+
+void CongaTagTest::DoRun() {
+  Ipv4CongaTag tag;
+  tag.SetLbTag(3);
+  tag.SetCe(5);
+  tag.SetFbLbTag(2);
+  tag.SetFbMetric(7);
+  NS_TEST_ASSERT_MSG_EQ(tag.GetSerializedSize(), 4, "Error -- tag too large");
+
+  Ptr<Packet> packet = Create<Packet>(100);
+  packet->AddPacketTag(tag);
+  Ipv4CongaTag copy;
+  NS_TEST_ASSERT_MSG_EQ(
+    packet->PeekPacketTag(copy), true, "Error -- tag not found");
+  NS_TEST_ASSERT_MSG_EQ(copy.GetLbTag(), 3, "Error -- wrong LB tag");
+  NS_TEST_ASSERT_MSG_EQ(copy.GetCe(), 5, "Error -- wrong congestion");
+  NS_TEST_ASSERT_MSG_EQ(copy.GetFbLbTag(), 2, "Error -- wrong feedback tag");
+  NS_TEST_ASSERT_MSG_EQ(copy.GetFbMetric(), 7, "Error -- wrong feedback");
+
+  // A switch on the path raises the congestion in place.
+  copy.SetCe(6);
+  packet->ReplacePacketTag(copy);
+  Ipv4CongaTag replaced;
+  packet->PeekPacketTag(replaced);
+  NS_TEST_ASSERT_MSG_EQ(replaced.GetCe(), 6, "Error -- congestion not raised");
+
+  // A fresh tag carries no feedback.
+  Ipv4CongaTag empty;
+  NS_TEST_ASSERT_MSG_EQ(empty.GetFbLbTag(), 0, "Error -- feedback set");
+}
+
+/**
+ * \ingroup conga-routing-tests
+ * 
+ * \brief CONGA DRE test.
+ * 
+ * The DRE of a 1Gbps port settles at rate * TDre / Alpha = 18750 bytes when
+ * the link is saturated, and the congestion of the port is its share of
+ * that, quantized to QuantizeBits = 3 bits. After 10 packets of 1020 bytes
+ * the port is at floor(8 * 10200 / 18750) = 4. The register must only lose
+ * Alpha of its bytes at the end of each whole TDre, and the congestion must
+ * stop at 7 however many bytes are sent.
+ */
+class DreTest : public TestCase {
+public:
+  void DoRun() override;
+  DreTest();
+};
+
+DreTest::DreTest()
+  : TestCase("CONGA DREs decay every TDre and quantize port utilization") {}
+
+void DreTest::DoRun() {
+  CongaFabric fabric;
+  Ptr<Node> leaf = fabric.leaves.Get(0);
+  Ptr<Ipv4CongaRouting> routing = fabric.GetRouting(leaf);
+
+  Ptr<Ipv4Route> route;
+  for (uint32_t i = 0; i < 10; i++) {
+    fabric.Forward(leaf, fabric.hostLinks[0].Get(1), 0,
+                   fabric.MakePacket(0, 1000), route);
+  }
+  NS_TEST_ASSERT_MSG_NE(route, nullptr, "The leaf forwards the flow");
+  uint32_t port = RoutePort(leaf, route);
+  NS_TEST_ASSERT_MSG_EQ(routing->GetLocalCongestion(port), 4,
+                        "Error -- wrong congestion for 10200 bytes");
+  for (uint32_t spine = 0; spine < CONGA_SPINES; spine++) {
+    uint32_t uplink = fabric.GetUplink(0, spine);
+    if (uplink != port) {
+      NS_TEST_ASSERT_MSG_EQ(routing->GetLocalCongestion(uplink), 0,
+                            "Error -- idle uplink congested");
+    }
+  }
+
+  // 10200 bytes, then 8160 after one period and 3342 after five.
+  AdvanceTo(MicroSeconds(29));
+  NS_TEST_ASSERT_MSG_EQ(routing->GetLocalCongestion(port), 4,
+                        "Error -- DRE decayed before the end of a period");
+  AdvanceTo(MicroSeconds(30));
+  NS_TEST_ASSERT_MSG_EQ(routing->GetLocalCongestion(port), 3,
+                        "Error -- DRE did not decay by Alpha");
+  AdvanceTo(MicroSeconds(150));
+  NS_TEST_ASSERT_MSG_EQ(routing->GetLocalCongestion(port), 1,
+                        "Error -- DRE did not decay for every period");
+  AdvanceTo(MilliSeconds(1));
+  NS_TEST_ASSERT_MSG_EQ(routing->GetLocalCongestion(port), 0,
+                        "Error -- idle port still congested");
+
+  // The flowlet timed out, so the burst is a new flowlet.
+  for (uint32_t i = 0; i < 100; i++) {
+    fabric.Forward(leaf, fabric.hostLinks[0].Get(1), 0,
+                   fabric.MakePacket(0, 1000), route);
+  }
+  port = RoutePort(leaf, route);
+  NS_TEST_ASSERT_MSG_EQ(routing->GetLocalCongestion(port), 7,
+                        "Error -- congestion not capped at 3 bits");
+
+  Simulator::Destroy();
+}
+
+/**
+ * \ingroup conga-routing-tests
+ * 
+ * \brief CONGA feedback test.
+ * 
+ * A packet from h0 to h1 leaves leaf 0 tagged with its uplink and the
+ * congestion of that uplink. The spine raises the congestion to that of its
+ * own port to leaf 1, and leaf 1 records it in its Congestion-From-Leaf
+ * table and strips the tag. The next packet from h1 to h0 piggybacks the
+ * entry, and leaf 0 records it in its Congestion-To-Leaf table, where it
+ * ages out after AgingTime.
+ */
+class FeedbackTest : public TestCase {
+public:
+  void DoRun() override;
+  FeedbackTest();
+};
+
+FeedbackTest::FeedbackTest()
+  : TestCase("CONGA leaves fill their congestion tables from feedback") {}
+
+void FeedbackTest::DoRun() {
+  CongaFabric fabric;
+  Ptr<Node> srcLeaf = fabric.leaves.Get(0);
+  Ptr<Node> dstLeaf = fabric.leaves.Get(1);
+
+  // Ten packets put the uplink at congestion 4.
+  Ptr<Ipv4Route> route;
+  Ptr<const Packet> packet;
+  for (uint32_t i = 0; i < 10; i++) {
+    packet = fabric.Forward(srcLeaf, fabric.hostLinks[0].Get(1), 0,
+                            fabric.MakePacket(0, 1000), route);
+  }
+  uint32_t port = RoutePort(srcLeaf, route);
+  uint32_t spine = fabric.GetSpine(0, port);
+  NS_TEST_ASSERT_MSG_LT(spine, CONGA_SPINES, "Error -- not an uplink");
+  Ipv4CongaTag tag;
+  NS_TEST_ASSERT_MSG_EQ(packet->PeekPacketTag(tag), true,
+                        "Error -- source leaf did not tag the packet");
+  NS_TEST_ASSERT_MSG_EQ(tag.GetLbTag(), port, "Error -- wrong LB tag");
+  NS_TEST_ASSERT_MSG_EQ(tag.GetCe(), 4, "Error -- wrong congestion");
+  NS_TEST_ASSERT_MSG_EQ(tag.GetFbLbTag(), 0,
+                        "Error -- feedback before any was seen");
+
+  // Fifteen packets of another flow put the port of the spine to leaf 1 at
+  // 6, which the tagged packet then carries.
+  Ptr<Node> spineNode = fabric.spines.Get(spine);
+  Ptr<NetDevice> spineIdev = fabric.uplinks[0][spine].Get(1);
+  for (uint32_t i = 0; i < 15; i++) {
+    fabric.Forward(spineNode, spineIdev, 0, fabric.MakePacket(0, 2000),
+                   route);
+  }
+  packet = fabric.Forward(spineNode, spineIdev, 0, packet, route);
+  packet->PeekPacketTag(tag);
+  NS_TEST_ASSERT_MSG_EQ(tag.GetCe(), 6, "Error -- spine did not raise CE");
+
+  packet = fabric.Forward(dstLeaf, fabric.uplinks[1][spine].Get(0), 0,
+                          packet, route);
+  NS_TEST_ASSERT_MSG_NE(packet, nullptr, "Error -- packet not delivered");
+  NS_TEST_ASSERT_MSG_EQ(packet->PeekPacketTag(tag), false,
+                        "Error -- tag left the fabric");
+  NS_TEST_ASSERT_MSG_EQ(
+    fabric.GetRouting(dstLeaf)->GetCongestionFromLeaf(0, port), 6,
+    "Error -- Congestion-From-Leaf not updated");
+
+  packet = fabric.Forward(dstLeaf, fabric.hostLinks[1].Get(1), 1,
+                          fabric.MakePacket(1, 3000), route);
+  packet->PeekPacketTag(tag);
+  NS_TEST_ASSERT_MSG_EQ(tag.GetFbLbTag(), port,
+                        "Error -- feedback not piggybacked");
+  NS_TEST_ASSERT_MSG_EQ(tag.GetFbMetric(), 6, "Error -- wrong feedback");
+
+  uint32_t backSpine = fabric.GetSpine(1, RoutePort(dstLeaf, route));
+  fabric.Forward(srcLeaf, fabric.uplinks[0][backSpine].Get(0), 1, packet,
+                 route);
+  Ptr<Ipv4CongaRouting> srcRouting = fabric.GetRouting(srcLeaf);
+  NS_TEST_ASSERT_MSG_EQ(srcRouting->GetCongestionToLeaf(1, port), 6,
+                        "Error -- Congestion-To-Leaf not updated");
+  for (uint32_t other = 0; other < CONGA_SPINES; other++) {
+    if (other != spine) {
+      NS_TEST_ASSERT_MSG_EQ(
+        srcRouting->GetCongestionToLeaf(1, fabric.GetUplink(0, other)), 0,
+        "Error -- feedback recorded for the wrong uplink");
+    }
+  }
+
+  AdvanceTo(MilliSeconds(10));
+  NS_TEST_ASSERT_MSG_EQ(srcRouting->GetCongestionToLeaf(1, port), 6,
+                        "Error -- entry aged out early");
+  AdvanceTo(MilliSeconds(10) + MicroSeconds(1));
+  NS_TEST_ASSERT_MSG_EQ(srcRouting->GetCongestionToLeaf(1, port), 0,
+                        "Error -- entry did not age out");
+
+  Simulator::Destroy();
+}
+
+/**
+ * \ingroup conga-routing-tests
+ * 
+ * \brief CONGA path choice test.
+ * 
+ * Leaf 0 learns that the paths to leaf 1 through the first two spines are
+ * at congestion 5. New flowlets must then all take the uplink to the last
+ * spine until its own congestion reaches 5, and spread over every uplink
+ * again once the feedback ages out. Only the source leaf allocates a
+ * flowlet table.
+ */
+class PathChoiceTest : public TestCase {
+public:
+  void DoRun() override;
+  PathChoiceTest();
+};
+
+PathChoiceTest::PathChoiceTest()
+  : TestCase("CONGA places new flowlets on the least congested uplink") {}
+
+void PathChoiceTest::DoRun() {
+  CongaFabric fabric;
+  Ptr<Node> leaf = fabric.leaves.Get(0);
+  Ptr<Ipv4CongaRouting> routing = fabric.GetRouting(leaf);
+
+  Ptr<Ipv4Route> route;
+  for (uint32_t spine = 0; spine + 1 < CONGA_SPINES; spine++) {
+    Ipv4CongaTag feedback;
+    feedback.SetLbTag(fabric.GetUplink(1, spine));
+    feedback.SetFbLbTag(fabric.GetUplink(0, spine));
+    feedback.SetFbMetric(5);
+    Ptr<Packet> packet = fabric.MakePacket(1, 1000);
+    packet->AddPacketTag(feedback);
+    fabric.Forward(leaf, fabric.uplinks[0][spine].Get(0), 1, packet, route);
+    NS_TEST_ASSERT_MSG_EQ(
+      routing->GetCongestionToLeaf(1, fabric.GetUplink(0, spine)), 5,
+      "Error -- feedback not recorded");
+  }
+
+  // Eight packets leave the last uplink at 8160 bytes, congestion 3.
+  uint32_t freePort = fabric.GetUplink(0, CONGA_SPINES - 1);
+  for (uint16_t sport = 1; sport <= 8; sport++) {
+    fabric.Forward(leaf, fabric.hostLinks[0].Get(1), 0,
+                   fabric.MakePacket(0, sport), route);
+    NS_TEST_ASSERT_MSG_EQ(RoutePort(leaf, route), freePort,
+                          "Error -- flowlet placed on a congested path");
+  }
+
+  AdvanceTo(MilliSeconds(11));
+  std::set<uint32_t> ports;
+  for (uint16_t sport = 100; sport < 130; sport++) {
+    fabric.Forward(leaf, fabric.hostLinks[0].Get(1), 0,
+                   fabric.MakePacket(0, sport), route);
+    ports.insert(RoutePort(leaf, route));
+  }
+  NS_TEST_ASSERT_MSG_EQ(ports.size(), CONGA_SPINES,
+                        "Error -- aged paths not used again");
+
+  NS_TEST_ASSERT_MSG_EQ(routing->GetFlowletTableCapacity(), 65536,
+                        "The source leaf allocates its flowlet table");
+  NS_TEST_ASSERT_MSG_EQ(
+    fabric.GetRouting(fabric.leaves.Get(1))->GetFlowletTableCapacity(), 0,
+    "Leaves that source no flow never allocate a flowlet table");
+  for (uint32_t i = 0; i < 2; i++) {
+    NS_TEST_ASSERT_MSG_EQ(
+      fabric.GetRouting(fabric.hosts.Get(i))->GetFlowletTableCapacity(), 0,
+      "Hosts never allocate a flowlet table");
+  }
+  for (uint32_t spine = 0; spine < CONGA_SPINES; spine++) {
+    NS_TEST_ASSERT_MSG_EQ(
+      fabric.GetRouting(fabric.spines.Get(spine))->GetFlowletTableCapacity(),
+      0, "Spines never allocate a flowlet table");
+  }
+
+  Simulator::Destroy();
+}
+
+// The TestSuite class names the TestSuite, identifies what type of TestSuite,
+// and enables the TestCases to be run.  Typically, only the constructor for
+// this class must be defined
+
+/**
+ * \ingroup conga-routing-tests
+ * TestSuite for module conga-routing
+ */
+class CongaRoutingTestSuite : public TestSuite
+{
+  public:
+    CongaRoutingTestSuite();
+};
+
+CongaRoutingTestSuite::CongaRoutingTestSuite()
+    : TestSuite("ipv4-conga-routing", UNIT)
+{
+    // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
+    AddTestCase(new CongaTagTest, TestCase::QUICK);
+    AddTestCase(new DreTest, TestCase::QUICK);
+    AddTestCase(new FeedbackTest, TestCase::QUICK);
+    AddTestCase(new PathChoiceTest, TestCase::QUICK);
+}
+
+// Do not forget to allocate an instance of this TestSuite
+/**
+ * \ingroup conga-routing-tests
+ * Static variable for test initialization
+ */
+static CongaRoutingTestSuite scongaRoutingTestSuite;
@@ -3,6 +3,7 @@
 
 #include "ns3/ipv4-drb-routing.h"
 #include "ns3/ipv4-routing-helper.h"
+#include "ns3/node-container.h"
 
 namespace ns3
 {
@@ -23,6 +24,17 @@ public:
 	virtual Ptr<Ipv4RoutingProtocol> Create(Ptr<Node> node) const;
 
 	Ptr<Ipv4DrbRouting> GetDrbRouting(Ptr<Ipv4> ipv4) const;
+
+	/**
+	 * Assign a fixed random variable stream number to the random variables
+	 * used by the DRB routing protocols of the nodes.
+	 *
+	 * \param c NodeContainer of the set of nodes for which the
+	 *          Ipv4DrbRouting should be modified to use a fixed stream
+	 * \param stream first stream index to use
+	 * \return the number of stream indices assigned by this helper
+	 */
+	int64_t AssignStreams(NodeContainer c, int64_t stream) const;
 };
 
 }  // namespace ns3
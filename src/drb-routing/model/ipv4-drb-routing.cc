@@ -4,9 +4,10 @@
 #include "ns3/net-device.h"
 #include "ns3/channel.h"
 #include "ns3/node.h"
-#include "ns3/flow-id-tag.h"
+#include "ns3/flow-key-tag.h"
 #include "ns3/ipv4-xpath-tag.h"
 #include "ns3/uinteger.h"
+#include "ns3/nstime.h"
 
 namespace ns3
 {
@@ -15,7 +16,11 @@ NS_LOG_COMPONENT_DEFINE("Ipv4DrbRouting");
 
 NS_OBJECT_ENSURE_REGISTERED(Ipv4DrbRouting);
 
-Ipv4DrbRouting::Ipv4DrbRouting() : m_mode(PER_FLOW) {
+Ipv4DrbRouting::Ipv4DrbRouting()
+	: m_allPaths(Create<DrbPathSchedule>()),
+	  m_mode(PER_FLOW),
+	  m_flowTableSize(4096),
+	  m_rand(CreateObject<UniformRandomVariable>()) {
 	NS_LOG_FUNCTION(this);
 }
 
@@ -31,7 +36,19 @@ TypeId Ipv4DrbRouting::GetTypeId() {
 	    .AddAttribute("Mode", "DRB Mode: 0 for PER DEST, 1 for PER FLOW",
 	    	          UintegerValue(1),
 	    	          MakeUintegerAccessor(&Ipv4DrbRouting::m_mode),
-	    	          MakeUintegerChecker<uint32_t>());
+	    	          MakeUintegerChecker<uint32_t>())
+	    .AddAttribute("FlowTableSize",
+	                  "The number of flows (or destinations) whose path "
+	                  "cursor is kept",
+	                  UintegerValue(4096),
+	                  MakeUintegerAccessor(&Ipv4DrbRouting::m_flowTableSize),
+	                  MakeUintegerChecker<uint32_t>(1))
+	    .AddAttribute("FlowIdleTimeout",
+	                  "How long a flow keeps its path cursor without sending "
+	                  "packets",
+	                  TimeValue(MilliSeconds(100)),
+	                  MakeTimeAccessor(&Ipv4DrbRouting::m_flowIdleTimeout),
+	                  MakeTimeChecker());
 
 	return tid;
 }
@@ -47,10 +64,7 @@ bool Ipv4DrbRouting::AddPath(uint32_t weight, uint32_t path) {
 		return false;
 	}
 
-    // push back `weight` instances of path.
-	for (uint32_t i = 0; i < weight; i++) {
-		m_allPaths.push_back(path);
-	}
+	m_allPaths = m_allPaths->AddPath(path, weight);
 	return true;
 }
 
@@ -61,25 +75,31 @@ bool Ipv4DrbRouting::AddWeightedPathToDsts(
     // First we add path to the list of all paths.
     Ipv4DrbRouting::AddPath(weight, path);
 
+    // Destinations that shared a schedule before the path is added keep
+    // sharing the new one.
+    std::map<const DrbPathSchedule*, Ptr<DrbPathSchedule>> updated;
+    Ptr<DrbPathSchedule> empty = Create<DrbPathSchedule>();
+
     // Add rules to all other tables
     std::set<Ipv4Address>::iterator itr = dstIPs.begin();
     for (; itr != dstIPs.end(); itr++) {
     	// We start from an empty list of paths, if we don't currently know
     	// of any paths to the destination we will just add the current path.
-    	std::vector<uint32_t> paths;
+    	Ptr<DrbPathSchedule> paths = empty;
     	auto dstPathPair = m_dstPaths.find(*itr);
 
     	// If we already have a list of paths for this destination, start
     	// from there.
     	if (dstPathPair != m_dstPaths.end()) {
-    		paths = dstPathPair->second; 
+    		paths = dstPathPair->second;
     	}
 
-    	// Now we add the path to the list.
-    	for (uint32_t i = 0; i < weight; i++) {
-    		paths.push_back(path);
+    	auto updatedItr = updated.find(PeekPointer(paths));
+    	if (updatedItr == updated.end()) {
+    		updatedItr = updated.insert(std::make_pair(
+    			PeekPointer(paths), paths->AddPath(path, weight))).first;
     	}
-    	m_dstPaths[*itr] = paths;
+    	m_dstPaths[*itr] = updatedItr->second;
     }
     return true;
 }
@@ -92,20 +112,15 @@ bool Ipv4DrbRouting::AddWeightedPathToDst(
  	// Now add rule to the destination paths. We start from an empty list of
  	// paths, if we don't currently know of any paths to the destination then
  	// we will just add the current path.
- 	std::vector<uint32_t> paths;
  	auto dstPathPair = m_dstPaths.find(dstAddr);
 
  	// If we already have a list of paths for this destination, start
  	// from there.
  	if (dstPathPair != m_dstPaths.end()) {
- 		paths = dstPathPair->second;
- 	}
-
- 	// Now we add the path to the list.
- 	for (uint32_t i = 0; i < weight; i++) {
- 		paths.push_back(path);
+ 		dstPathPair->second = dstPathPair->second->AddPath(path, weight);
+ 	} else {
+ 		m_dstPaths[dstAddr] = Create<DrbPathSchedule>()->AddPath(path, weight);
  	}
- 	m_dstPaths[dstAddr] = paths;
 
  	return true;
 }
@@ -120,16 +135,14 @@ Ptr<Ipv4Route> Ipv4DrbRouting::RouteOutput(
  		return 0;
  	}
 
- 	uint32_t flowIdentity = 0;
+ 	uint64_t flowIdentity = 0;
  	if (m_mode == PER_FLOW) {
- 		FlowIdTag flowIdTag;
- 		bool found = p->PeekPacketTag(flowIdTag);
- 		if (!found) {
+ 		flowIdentity = FlowKeyTag::ExtractFlowKey(p);
+ 		if (flowIdentity == 0) {
  			sockerr = Socket::ERROR_NOROUTETOHOST;
  			return 0;
  		}
- 		flowIdentity = flowIdTag.GetFlowId();
- 		NS_LOG_LOGIC("For flow with flow id: " << flowIdentity);
+ 		NS_LOG_LOGIC("For flow with flow key: " << flowIdentity);
  	}
  	// m_mode == PER_DEST
  	else {
@@ -139,31 +152,41 @@ Ptr<Ipv4Route> Ipv4DrbRouting::RouteOutput(
  		NS_LOG_LOGIC("For flow with dest: " << flowIdentity);
  	}
 
- 	std::vector<uint32_t> paths;
+ 	// The schedules are shared and immutable, so only a pointer is taken.
+ 	const DrbPathSchedule* paths = PeekPointer(m_allPaths);
  	auto dstItr = m_dstPaths.find(header.GetDestination());
- 	if (dstItr == m_dstPaths.end()) {
- 		// If we can't find the destination, just pick a random path.
- 		paths = m_allPaths;
- 	} else {
- 		// Otherwise use the set of paths to the destination.
- 		paths = dstItr->second;
+ 	if (dstItr != m_dstPaths.end()) {
+ 		// Use the set of paths to the destination. Otherwise just pick from
+ 		// all paths.
+ 		paths = PeekPointer(dstItr->second);
+ 	}
+ 	uint32_t length = paths->GetLength();
+ 	if (length == 0) {
+ 		NS_LOG_ERROR("DRB Routing has no path to " << header.GetDestination());
+ 		sockerr = Socket::ERROR_NOROUTETOHOST;
+ 		return 0;
  	}
 
- 	uint32_t pathIdx;
- 	auto flowItr = m_flowPathMap.find(flowIdentity);
- 	if (flowItr != m_flowPathMap.end()) {
- 		// If we already have a path for the flow, send it there.
- 		pathIdx = flowItr->second;
- 	} else {
+ 	// The table is sized on first use, once the attributes are set, as in
+ 	// Ipv4Drb.
+ 	if (m_flowCursors.GetCapacity() == 0) {
+ 		m_flowCursors.Configure(m_flowTableSize, m_flowIdleTimeout);
+ 	}
+
+ 	bool found = false;
+ 	uint32_t& cursor = m_flowCursors.Lookup(
+ 		flowIdentity, Simulator::Now(), found);
+ 	if (!found) {
  		// Otherwise, pick a random path.
- 		pathIdx = rand() % paths.size();
+ 		cursor = m_rand->GetInteger(0, length - 1);
  	}
 
  	// DRB sends the packets of a flow (or to a destination) in a round robin
- 	// fashion. So we send the packet down the current path and increment the
- 	// path index by 1 for the next packet.
- 	uint32_t path = paths[pathIdx];
- 	m_flowPathMap[flowIdentity] = (pathIdx + 1) % paths.size();
+ 	// fashion. So we send the packet down the current path and move the
+ 	// cursor by 1 for the next packet.
+ 	uint32_t pathIdx = cursor % length;
+ 	uint32_t path = paths->GetPath(pathIdx);
+ 	cursor = (pathIdx + 1) % length;
 
     // DRB doesn't actually do the sending, just tags the packet with the
     // path.
@@ -206,6 +229,16 @@ void Ipv4DrbRouting::SetIpv4(Ptr<Ipv4> ipv4) {
 void Ipv4DrbRouting::PrintRoutingTable(
 	Ptr<OutputStreamWrapper> stream, Time::Unit unit) const {}
 
-void Ipv4DrbRouting::DoDispose() {}
+int64_t Ipv4DrbRouting::AssignStreams(int64_t stream) {
+	NS_LOG_FUNCTION(this << stream);
+	m_rand->SetStream(stream);
+	return 1;
+}
+
+void Ipv4DrbRouting::DoDispose() {
+	m_rand = nullptr;
+	m_ipv4 = nullptr;
+	Ipv4RoutingProtocol::DoDispose();
+}
 
 }  // namespace ns3
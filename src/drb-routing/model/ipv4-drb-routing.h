@@ -7,6 +7,8 @@
 #include "ns3/packet.h"
 #include "ns3/ipv4-header.h"
 #include "ns3/ipv4-address.h"
+#include "ns3/ipv4-drb-path-table.h"
+#include "ns3/random-variable-stream.h"
 
 #include <map>
 #include <set>
@@ -62,20 +64,37 @@ public:
     virtual void PrintRoutingTable(
         Ptr<OutputStreamWrapper> stream, Time::Unit unit = Time::S) const;
 
+    /**
+     * Assign a fixed random variable stream number to the random variables
+     * used by this model.  Return the number of streams (possibly zero) that
+     * have been assigned.
+     *
+     * \param stream first stream index to use
+     * \return the number of stream indices assigned by this model
+     */
+    int64_t AssignStreams(int64_t stream);
+
     virtual void DoDispose();
 
 private:
     // Default paths to use when a path to the destination is not known.
     // Corresponds to just randomly selecting a path in hopes that a future
     // hop will know the path to the destination.
-    std::vector<uint32_t> m_allPaths;
-    // Destination specific paths. For each destination, a list of weighted
-    // paths is maintained to that destination.
-    std::map<Ipv4Address, std::vector<uint32_t>> m_dstPaths;
-    // Maintains a map of flow IDs to paths. So if a flow already has an
-    // associated path we can just reuse that path.
-    std::map<uint32_t, uint32_t> m_flowPathMap;
+    Ptr<DrbPathSchedule> m_allPaths;
+    // Destination specific paths. For each destination, a weighted schedule
+    // of paths is maintained to that destination. Destinations configured
+    // together share the same schedule.
+    std::map<Ipv4Address, Ptr<DrbPathSchedule>> m_dstPaths;
+    // Keeps the position of each flow (or destination) in its schedule. So
+    // if a flow already has an associated path we can just move on to the
+    // next one.
+    DrbFlowCursorTable m_flowCursors;
     enum DrbRoutingMode m_mode;
+    uint32_t m_flowTableSize;
+    Time m_flowIdleTimeout;
+
+    // Picks the first path of a new flow.
+    Ptr<UniformRandomVariable> m_rand;
 
     Ptr<Ipv4> m_ipv4;
 };
@@ -1,6 +1,7 @@
 
 // Include a header file from your module to test.
 #include "ns3/ipv4-drb-routing.h"
+#include "ns3/ipv4-drb-path-table.h"
 
 // An essential include is test.h
 #include "ns3/test.h"
@@ -57,6 +58,62 @@ DrbRoutingTestCase1::DoRun()
     NS_TEST_ASSERT_MSG_EQ_TOL(0.01, 0.01, 0.001, "Numbers are not equal within tolerance");
 }
 
+/**
+ * \ingroup drb-routing-tests
+ * Checks the weighted schedule and the bounded flow cursor table.
+ */
+class DrbPathTableTest : public TestCase
+{
+  public:
+    DrbPathTableTest();
+
+  private:
+    void DoRun() override;
+};
+
+DrbPathTableTest::DrbPathTableTest()
+    : TestCase("DRB path schedule interleaves weights and cursors are bounded")
+{
+}
+
+void
+DrbPathTableTest::DoRun()
+{
+    // Weights 6 and 2 reduce to 3 and 1 and are interleaved.
+    Ptr<DrbPathSchedule> empty = Create<DrbPathSchedule>();
+    Ptr<DrbPathSchedule> schedule = empty->AddPath(10, 6)->AddPath(20, 2);
+    NS_TEST_ASSERT_MSG_EQ(empty->GetLength(), 0, "Error -- schedule was modified");
+    NS_TEST_ASSERT_MSG_EQ(schedule->GetNPaths(), 2, "Error -- wrong number of paths");
+    NS_TEST_ASSERT_MSG_EQ(schedule->GetLength(), 4, "Error -- weights not reduced");
+    uint32_t expected[] = {10, 10, 20, 10};
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        NS_TEST_ASSERT_MSG_EQ(schedule->GetPath(i), expected[i], "Error -- wrong slot " << i);
+    }
+
+    // Adding weight to an existing path does not duplicate it.
+    schedule = schedule->AddPath(20, 2);
+    NS_TEST_ASSERT_MSG_EQ(schedule->GetNPaths(), 2, "Error -- path was duplicated");
+    // Weights 6 and 4 reduce to 3 and 2.
+    NS_TEST_ASSERT_MSG_EQ(schedule->GetLength(), 5, "Error -- weights not reduced");
+
+    DrbFlowCursorTable table;
+    table.Configure(1, MicroSeconds(50));
+    bool found = true;
+    uint32_t& cursor = table.Lookup(7, MicroSeconds(0), found);
+    NS_TEST_ASSERT_MSG_EQ(found, false, "Error -- new flow has a cursor");
+    cursor = 3;
+    NS_TEST_ASSERT_MSG_EQ(table.Lookup(7, MicroSeconds(10), found), 3, "Error -- cursor lost");
+    NS_TEST_ASSERT_MSG_EQ(found, true, "Error -- flow has no cursor");
+
+    // A busy entry is evicted, an idle one is reused.
+    table.Lookup(8, MicroSeconds(20), found);
+    NS_TEST_ASSERT_MSG_EQ(found, false, "Error -- new flow has a cursor");
+    NS_TEST_ASSERT_MSG_EQ(table.GetEvictions(), 1, "Error -- no eviction");
+    table.Lookup(9, MicroSeconds(200), found);
+    NS_TEST_ASSERT_MSG_EQ(table.GetEvictions(), 1, "Error -- idle entry was evicted");
+}
+
 // The TestSuite class names the TestSuite, identifies what type of TestSuite,
 // and enables the TestCases to be run.  Typically, only the constructor for
 // this class must be defined
@@ -76,6 +133,7 @@ DrbRoutingTestSuite::DrbRoutingTestSuite()
 {
     // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
     AddTestCase(new DrbRoutingTestCase1, TestCase::QUICK);
+    AddTestCase(new DrbPathTableTest, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
@@ -46,6 +46,10 @@ void Ipv4DrillRoutingHelper::RecomputeRoutingTables() {
 	GlobalRouteManager::InitializeRoutes();
 }
 
+void Ipv4DrillRoutingHelper::UpdateRoutingTables() {
+	GlobalRouteManager::UpdateRoutes();
+}
+
 Ptr<Ipv4DrillRouting>
 Ipv4DrillRoutingHelper::GetDrillRouting(Ptr<Ipv4> ipv4) const {
 	Ptr<Ipv4RoutingProtocol> ipv4rp = ipv4->GetRoutingProtocol();
@@ -73,4 +77,18 @@ Ipv4DrillRoutingHelper::GetDrillRouting(Ptr<Ipv4> ipv4) const {
 	return nullptr;
 }
 
+int64_t Ipv4DrillRoutingHelper::AssignStreams(NodeContainer c,
+		                                      int64_t stream) const {
+	int64_t currentStream = stream;
+	for (NodeContainer::Iterator i = c.Begin(); i != c.End(); ++i) {
+		Ptr<Ipv4> ipv4 = (*i)->GetObject<Ipv4>();
+		NS_ASSERT_MSG(ipv4, "Ipv4 not installed on node");
+		Ptr<Ipv4DrillRouting> drillRouting = GetDrillRouting(ipv4);
+		if (drillRouting) {
+			currentStream += drillRouting->AssignStreams(currentStream);
+		}
+	}
+	return (currentStream - stream);
+}
+
 }  // namespace ns3
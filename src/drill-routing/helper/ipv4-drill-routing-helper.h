@@ -54,6 +54,13 @@ public:
 	 */
 	static void RecomputeRoutingTables();
 
+	/**
+	 * \brief Update the routes that were previously installed after links
+	 * went up or down, recomputing only the routes the changes affect. The
+	 * routes are the same as those of RecomputeRoutingTables().
+	 */
+	static void UpdateRoutingTables();
+
 	/**
 	 * \brief Retrieve the Ipv4DrillRouting protocol attached to the helper.
 	 *
@@ -62,6 +69,19 @@ public:
 	 * \returns Ipv4DrillRouting pointer or nullptr if not found.
 	 */
 	Ptr<Ipv4DrillRouting> GetDrillRouting(Ptr<Ipv4> ipv4) const;
+
+	/**
+	 * \brief Assign a fixed random variable stream number to the random
+	 * variables used by DRILL to sample ports. Return the number of streams
+	 * (possibly zero) that have been assigned. The Install() method of the
+	 * InternetStackHelper should have previously been called by the user.
+	 *
+	 * \param c NodeContainer of the set of nodes running DRILL routing.
+	 * \param stream first stream index to use.
+	 *
+	 * \returns the number of stream indices assigned by this helper.
+	 */
+	int64_t AssignStreams(NodeContainer c, int64_t stream) const;
 };
 
 }  // namespace ns3
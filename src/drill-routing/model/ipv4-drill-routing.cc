@@ -14,7 +14,6 @@
 
 #include <algorithm>
 #include <limits>
-#include <random>
 #include <vector>
 
 namespace ns3
@@ -27,6 +26,7 @@ NS_OBJECT_ENSURE_REGISTERED(Ipv4DrillRouting);
 Ipv4DrillRouting::Ipv4DrillRouting(Ptr<Ipv4GlobalRouting> globalRouting)
     : m_d(2), m_ipv4(nullptr), m_globalRouting(globalRouting) {
     NS_LOG_FUNCTION(this);
+    m_rand = CreateObject<UniformRandomVariable>();
 }
 
 Ipv4DrillRouting::~Ipv4DrillRouting() {
@@ -99,7 +99,7 @@ bool Ipv4DrillRouting::RouteInput(Ptr<const Packet> p,
         return false;
     }
 
-    std::vector<Ipv4RoutingTableEntry*> allRoutes = LookupDrillRoutes(
+    const Ipv4GlobalRouting::RouteGroup& allRoutes = LookupDrillRoutes(
         header.GetDestination());
     if (allRoutes.empty()) {
         NS_LOG_ERROR(this << "DRILL routing cannot find route to "
@@ -127,22 +127,18 @@ bool Ipv4DrillRouting::RouteInput(Ptr<const Packet> p,
     // If we have at least `m_d` routes, then we sample `m_d`. Otherwise, we
     // sample all.
     uint32_t sampleNum = m_d < allRoutes.size() ? m_d : allRoutes.size();
-    // Only shuffle if m_d < allRoutes.size().
-    if (m_d < allRoutes.size()) {
-      // Shuffle so that we can randomly sample `m_d` ports.
-      std::random_device rd;
-      std::mt19937 g(rd());
-      std::shuffle(allRoutes.begin(), allRoutes.end(), g);
+    if (sampleNum < allRoutes.size() && m_globalRouting->HasWeightedRoutes()) {
+        SampleWeightedRoutes(header.GetDestination(), allRoutes, sampleNum);
+    } else {
+        SampleRoutes(allRoutes.size(), sampleNum);
     }
 
-    // We've already randomly shuffled so we can just go through the first
-    // `sample_num` entries in the shuffled array.
-    for (uint32_t samplePort = 0; samplePort < sampleNum; samplePort++) {
+    for (uint32_t routeIdx : m_sampledIndices) {
         uint32_t sampleLoad = CalculateQueueLength(
-            allRoutes[samplePort]->GetInterface());
+            allRoutes[routeIdx]->GetInterface());
         if (sampleLoad < leastLoad) {
             leastLoad = sampleLoad;
-            leastLoadedInterface = allRoutes[samplePort]->GetInterface();
+            leastLoadedInterface = allRoutes[routeIdx]->GetInterface();
         }
     }
 
@@ -158,20 +154,28 @@ bool Ipv4DrillRouting::RouteInput(Ptr<const Packet> p,
 }
 
 void Ipv4DrillRouting::NotifyInterfaceUp(uint32_t interface) {
+    m_routeCache.clear();
+    m_portQueues.clear();
     m_globalRouting->NotifyInterfaceUp(interface);
 }
 
 void Ipv4DrillRouting::NotifyInterfaceDown(uint32_t interface) {
+    m_routeCache.clear();
+    m_portQueues.clear();
     m_globalRouting->NotifyInterfaceDown(interface);
 }
 
 void Ipv4DrillRouting::NotifyAddAddress(uint32_t interface,
                                         Ipv4InterfaceAddress address) {
+    m_routeCache.clear();
+    m_portQueues.clear();
     m_globalRouting->NotifyAddAddress(interface, address);
 }
 
 void Ipv4DrillRouting::NotifyRemoveAddress(uint32_t interface,
                                            Ipv4InterfaceAddress address) {
+    m_routeCache.clear();
+    m_portQueues.clear();
     m_globalRouting->NotifyRemoveAddress(interface, address);
 }
 
@@ -197,56 +201,126 @@ Ipv4RoutingTableEntry* Ipv4DrillRouting::GetRoute(uint32_t i) const {
     return m_globalRouting->GetRoute(i);
 }
 
+int64_t Ipv4DrillRouting::AssignStreams(int64_t stream) {
+	NS_LOG_FUNCTION(this << stream);
+	m_rand->SetStream(stream);
+	return 1;
+}
+
 void Ipv4DrillRouting::DoDispose() {
 	NS_LOG_FUNCTION(this);
+	m_routeCache.clear();
+	m_portQueues.clear();
+	m_rand = nullptr;
 	m_ipv4 = nullptr;
 	m_globalRouting->DoDispose();
 	m_globalRouting = nullptr;
 }
 
-std::vector<Ipv4RoutingTableEntry*>
+const Ipv4GlobalRouting::RouteGroup&
 Ipv4DrillRouting::LookupDrillRoutes(Ipv4Address dst, Ptr<NetDevice> oif) {
 	NS_LOG_FUNCTION(this << dst << oif);
 	return m_globalRouting->GetRoutesToDst(dst, oif);
 }
 
+void Ipv4DrillRouting::SampleRoutes(uint32_t nRoutes, uint32_t sampleNum) {
+	m_sampledIndices.clear();
+	// Only sample if sampleNum < nRoutes, otherwise every route is used.
+	if (sampleNum >= nRoutes) {
+		for (uint32_t routeIdx = 0; routeIdx < nRoutes; routeIdx++) {
+			m_sampledIndices.push_back(routeIdx);
+		}
+		return;
+	}
+
+	// Floyd's algorithm: for each of the last `sampleNum` indices, draw an
+	// index up to it and take the drawn index if it has not been sampled
+	// yet, or the upper index itself otherwise. Every subset of size
+	// `sampleNum` is equally likely.
+	for (uint32_t upper = nRoutes - sampleNum; upper < nRoutes; upper++) {
+		uint32_t drawn = m_rand->GetInteger(0, upper);
+		if (std::find(m_sampledIndices.begin(), m_sampledIndices.end(),
+			          drawn) != m_sampledIndices.end()) {
+			drawn = upper;
+		}
+		m_sampledIndices.push_back(drawn);
+	}
+}
+
+void Ipv4DrillRouting::SampleWeightedRoutes(
+	Ipv4Address dst, const Ipv4GlobalRouting::RouteGroup& routes,
+	uint32_t sampleNum) {
+	m_sampledIndices.clear();
+	// Each sample is a WCMP pick, so routes with more capacity are sampled
+	// more often. A route drawn twice is simply compared twice.
+	for (uint32_t sample = 0; sample < sampleNum; sample++) {
+		m_sampledIndices.push_back(m_globalRouting->PickWeightedRoute(
+			dst, routes,
+			m_rand->GetInteger(0, std::numeric_limits<uint32_t>::max() - 1)));
+	}
+}
+
 uint32_t Ipv4DrillRouting::CalculateQueueLength(uint32_t interface) {
+	if (interface >= m_portQueues.size() || !m_portQueues[interface].bound) {
+		BindPortQueues(interface);
+	}
+
+	const DrillPortQueues& portQueues = m_portQueues[interface];
+	uint32_t queueLength = 0;
+	if (portQueues.deviceQueue) {
+		queueLength += portQueues.deviceQueue->GetNBytes();
+	}
+	if (portQueues.queueDisc) {
+		queueLength += portQueues.queueDisc->GetNBytes();
+	}
+	NS_LOG_LOGIC("Calculate queue length for " << interface
+		<< " as " << queueLength);
+	return queueLength;
+}
+
+void Ipv4DrillRouting::BindPortQueues(uint32_t interface) {
+	NS_LOG_FUNCTION(this << interface);
+	if (interface >= m_portQueues.size()) {
+		m_portQueues.resize(interface + 1);
+	}
+	DrillPortQueues& portQueues = m_portQueues[interface];
+	portQueues.bound = true;
+
 	Ptr<Ipv4L3Protocol> ipv4L3Protocol = DynamicCast<Ipv4L3Protocol>(m_ipv4);
 	if (!ipv4L3Protocol) {
 		NS_LOG_ERROR(
 			this << "Drill routing only works at the ipv4L3Protocol layer");
-		return 0;
+		return;
 	}
 
-	uint32_t queueLength = 0;
-	const Ptr<NetDevice> netDevice = this->m_ipv4->GetNetDevice(interface);
-
+	const Ptr<NetDevice> netDevice = m_ipv4->GetNetDevice(interface);
 	if (netDevice->IsPointToPoint()) {
 		Ptr<PointToPointNetDevice> p2pNetDevice =
 		    DynamicCast<PointToPointNetDevice>(netDevice);
 		if (p2pNetDevice) {
-		    queueLength += p2pNetDevice->GetQueue()->GetNBytes();
+		    portQueues.deviceQueue = p2pNetDevice->GetQueue();
 		}
 	}
 
 	Ptr<TrafficControlLayer> tc =
 	    ipv4L3Protocol->GetObject<TrafficControlLayer>();
 	if (!tc) {
-    NS_LOG_LOGIC("Calculate queue length for " << interface
-        << " as " << queueLength << ". No Traffic Control Layer");
-		return queueLength;
-	}
-	Ptr<QueueDisc> queueDisc = tc->GetRootQueueDiscOnDevice(netDevice);
-	if (queueDisc) {
-		queueLength += queueDisc->GetNBytes();
+		NS_LOG_LOGIC("No Traffic Control Layer for " << interface);
+		return;
 	}
-  NS_LOG_LOGIC("Calculate queue length for " << interface
-      << " as " << queueLength);
-	return queueLength;
+	portQueues.queueDisc = tc->GetRootQueueDiscOnDevice(netDevice);
 }
 
 Ptr<Ipv4Route>
 Ipv4DrillRouting::ConstructIpv4Route(uint32_t port, Ipv4Address dstAddr) {
+    // Reuse the route if one was already built from this port to the
+    // destination.
+    uint64_t cacheKey = (static_cast<uint64_t>(port) << 32) | dstAddr.Get();
+    auto cacheItr = m_routeCache.find(cacheKey);
+    if (cacheItr != m_routeCache.end()) {
+        return cacheItr->second;
+    }
+
     // Port and channel to send from on this router.
     Ptr<NetDevice> dev = m_ipv4->GetNetDevice(port);
     Ptr<Channel> channel = dev->GetChannel();
@@ -272,6 +346,7 @@ Ipv4DrillRouting::ConstructIpv4Route(uint32_t port, Ipv4Address dstAddr) {
     route->SetGateway(nextHopAddr);
     route->SetSource(m_ipv4->GetAddress(port, 0).GetLocal());
     route->SetDestination(dstAddr);
+    m_routeCache[cacheKey] = route;
     return route;
 }
 
@@ -12,6 +12,12 @@
 #include "ns3/node.h"
 #include "ns3/data-rate.h"
 #include "ns3/nstime.h"
+#include "ns3/queue.h"
+#include "ns3/queue-disc.h"
+#include "ns3/random-variable-stream.h"
+
+#include <map>
+#include <unordered_map>
 
 /**
  * \defgroup drill-routing Load balancing with DRILL.
@@ -27,6 +33,25 @@
 namespace ns3
 {
 
+/**
+ * \ingroup drill-routing
+ * 
+ * \brief The queues holding the backlog of an output port.
+ * 
+ * DRILL compares ports by the number of bytes waiting in the device queue
+ * plus the root queue disc installed on the device. The pointers are
+ * resolved once per port so that reading the backlog does not need any
+ * casts or object lookups.
+ */
+struct DrillPortQueues {
+    // Whether the queues have been resolved for the port.
+    bool bound = false;
+    // The transmit queue of a point-to-point device, if any.
+    Ptr<Queue<Packet>> deviceQueue;
+    // The root queue disc installed on the device, if any.
+    Ptr<QueueDisc> queueDisc;
+};
+
 /**
  * \ingroup drill-routing
  * 
@@ -77,6 +102,16 @@ public:
      */
     Ipv4RoutingTableEntry* GetRoute(uint32_t i) const;
 
+    /**
+     * Assign a fixed random variable stream number to the random variables
+     * used by this model. Return the number of streams (possibly zero) that
+     * have been assigned.
+     *
+     * \param stream first stream index to use
+     * \return the number of stream indices assigned by this model
+     */
+    int64_t AssignStreams(int64_t stream);
+
     virtual void DoDispose() override;
 private:
     /**
@@ -85,12 +120,40 @@ private:
      * \param dst The destination address.
      * \param oif Output interface if any (put nullptr otherwise).
      * 
-     * \returns Vector of Ipv4RoutingTableEntry objects for routes to the
+     * \returns Group of Ipv4RoutingTableEntry objects for routes to the
      * destination.
      */
-    std::vector<Ipv4RoutingTableEntry*> LookupDrillRoutes(
+    const Ipv4GlobalRouting::RouteGroup& LookupDrillRoutes(
         Ipv4Address dst, Ptr<NetDevice> oif = nullptr);
 
+    /**
+     * \brief Samples `sampleNum` distinct routes uniformly at random.
+     * 
+     * Uses Floyd's algorithm, which draws exactly `sampleNum` random
+     * numbers and does not need to permute the group of routes. The
+     * indices of the sampled routes are stored in `m_sampledIndices`.
+     * 
+     * \param nRoutes The number of routes to sample from.
+     * \param sampleNum The number of routes to sample.
+     */
+    void SampleRoutes(uint32_t nRoutes, uint32_t sampleNum);
+
+    /**
+     * \brief Samples `sampleNum` routes in proportion to their WCMP weights.
+     * 
+     * Used instead of SampleRoutes when the routes have weights (see
+     * Ipv4GlobalRouting::PickWeightedRoute). Samples are drawn with
+     * replacement. The indices of the sampled routes are stored in
+     * `m_sampledIndices`.
+     * 
+     * \param dst The destination address.
+     * \param routes The routes to the destination.
+     * \param sampleNum The number of routes to sample.
+     */
+    void SampleWeightedRoutes(Ipv4Address dst,
+                              const Ipv4GlobalRouting::RouteGroup& routes,
+                              uint32_t sampleNum);
+
     /**
      * \brief Calculates the queue length of a given interface.
      * 
@@ -103,9 +166,23 @@ private:
      */
     uint32_t CalculateQueueLength(uint32_t interface);
 
+    /**
+     * \brief Resolves the queues of an interface into `m_portQueues`.
+     * 
+     * This is done the first time an interface is sampled rather than in
+     * SetIpv4, as interfaces and queue discs are installed after the
+     * routing protocol.
+     * 
+     * \param interface The interface for which the queues are resolved.
+     */
+    void BindPortQueues(uint32_t interface);
+
     /**
      * \brief constructs a route to the destination.
      * 
+     * Routes are cached per (port, destination) pair, so only the first
+     * packet sent from a port to a destination builds the route.
+     * 
      * \param port the port from which the route will send packets.
      * \param dstAddr the destination address for the route.
      * 
@@ -117,10 +194,26 @@ private:
     // sample from.
     uint32_t m_d;
 
+    // A uniform random number generator used to sample ports.
+    Ptr<UniformRandomVariable> m_rand;
+
+    // Indices of the routes sampled for the current packet. Kept as a member
+    // so that sampling does not allocate on the forwarding path.
+    std::vector<uint32_t> m_sampledIndices;
+
+    // The queues of each port, indexed by interface. Cleared whenever an
+    // interface or address changes.
+    std::vector<DrillPortQueues> m_portQueues;
+
     // A map storing the port with the lowest queue for each destination based
     // on the previous iteration of DRILL (last time it sent a packet).
     std::map<Ipv4Address, uint32_t> m_previousBestQueueMap;
 
+    // Routes built by ConstructIpv4Route, keyed by the port in the upper 32
+    // bits and the destination address in the lower 32 bits. The cache is
+    // cleared whenever an interface or address changes.
+    std::unordered_map<uint64_t, Ptr<Ipv4Route>> m_routeCache;
+
     // Ipv4 address associated with this router.
     Ptr<Ipv4> m_ipv4;
 
@@ -3,20 +3,28 @@
 #include "ns3/ipv4-drill-routing-helper.h"
 #include "ns3/ipv4-drill-routing.h"
 #include "ns3/ipv4-l3-protocol.h"
+#include "ns3/ipv4-queue-disc-item.h"
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/log.h"
 #include "ns3/node-container.h"
 #include "ns3/node.h"
 #include "ns3/packet.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/point-to-point-net-device.h"
 #include "ns3/pointer.h"
+#include "ns3/queue-disc.h"
 #include "ns3/simple-channel.h"
 #include "ns3/simple-net-device-helper.h"
 #include "ns3/simple-net-device.h"
 #include "ns3/simulator.h"
 #include "ns3/test.h"
+#include "ns3/traffic-control-layer.h"
 #include "ns3/uinteger.h"
 
+#include <set>
+#include <vector>
+
 using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE("Ipv4DrillRoutingTestSuite");
@@ -125,6 +133,296 @@ void LinkTest::DoRun() {
 	Simulator::Destroy();
 }
 
+/**
+ * \ingroup drill-routing-tests
+ *
+ * \brief Ipv4 DRILL routing stream assignment test.
+ */
+class DrillAssignStreamsTest : public TestCase {
+public:
+	void DoRun() override;
+	DrillAssignStreamsTest();
+};
+
+DrillAssignStreamsTest::DrillAssignStreamsTest()
+	: TestCase("DRILL routing assigns one random stream per node") {}
+
+void DrillAssignStreamsTest::DoRun() {
+	NodeContainer nodes;
+	nodes.Create(2);
+
+	Ptr<SimpleChannel> channel = CreateObject<SimpleChannel>();
+	SimpleNetDeviceHelper simpleHelper;
+	simpleHelper.SetNetDevicePointToPointMode(true);
+	NetDeviceContainer net = simpleHelper.Install(nodes, channel);
+
+	InternetStackHelper internet;
+	Ipv4DrillRoutingHelper drillRouting;
+	internet.SetRoutingHelper(drillRouting);
+	internet.Install(nodes);
+
+	int64_t nStreams = drillRouting.AssignStreams(nodes, 10);
+	NS_TEST_ASSERT_MSG_EQ(nStreams, 2, "Error -- expected one stream per node");
+
+	Simulator::Destroy();
+}
+
+/**
+ * \ingroup drill-routing-tests
+ *
+ * \brief Ipv4 DRILL routing reproducibility test.
+ *
+ * A DRILL router A forwards packets from h0 towards h1 over four spines:
+ *
+ *          /-- s0 --\
+ *   h0 -- A --- ... --- B -- h1 (10.9.0.0/16)
+ *          \-- s3 --/
+ *
+ * Each packet goes to a new address of h1's network, so the port DRILL
+ * picks only depends on its samples. Runs with the same stream must pick the
+ * same ports, runs with another stream must not.
+ */
+class DrillReproducibilityTest : public TestCase {
+public:
+	void DoRun() override;
+	DrillReproducibilityTest();
+
+private:
+	/**
+	 * \brief Forwards packets through a DRILL router seeded with a stream.
+	 *
+	 * \param stream The stream assigned to the DRILL routers.
+	 *
+	 * \returns the output interface of each packet.
+	 */
+	std::vector<uint32_t> RunWithStream(int64_t stream);
+
+	/**
+	 * \brief Records the output interface of a forwarded packet.
+	 *
+	 * \param interfaces The interfaces recorded so far.
+	 * \param ipv4 The Ipv4 of the router.
+	 * \param route The route of the packet.
+	 * \param p The packet.
+	 * \param header The IP header of the packet.
+	 */
+	static void RecordInterface(std::vector<uint32_t>* interfaces,
+		                        Ptr<Ipv4> ipv4, Ptr<Ipv4Route> route,
+		                        Ptr<const Packet> p, const Ipv4Header& header);
+};
+
+DrillReproducibilityTest::DrillReproducibilityTest()
+	: TestCase("DRILL routing picks the same ports for the same stream") {}
+
+void DrillReproducibilityTest::RecordInterface(
+	std::vector<uint32_t>* interfaces, Ptr<Ipv4> ipv4, Ptr<Ipv4Route> route,
+	Ptr<const Packet> p, const Ipv4Header& header) {
+	interfaces->push_back(
+		ipv4->GetInterfaceForDevice(route->GetOutputDevice()));
+}
+
+std::vector<uint32_t> DrillReproducibilityTest::RunWithStream(int64_t stream) {
+	const uint32_t nSpines = 4;
+	NodeContainer hosts;
+	hosts.Create(2);
+	NodeContainer leaves;
+	leaves.Create(2);
+	NodeContainer spines;
+	spines.Create(nSpines);
+
+	InternetStackHelper internet;
+	Ipv4DrillRoutingHelper drillRouting;
+	internet.SetRoutingHelper(drillRouting);
+	internet.Install(hosts);
+	internet.Install(leaves);
+	internet.Install(spines);
+
+	SimpleNetDeviceHelper simpleHelper;
+	simpleHelper.SetNetDevicePointToPointMode(true);
+	Ipv4AddressHelper ipv4;
+	ipv4.SetBase("10.1.0.0", "255.255.255.252");
+	NetDeviceContainer hostLink = simpleHelper.Install(
+		NodeContainer(hosts.Get(0), leaves.Get(0)),
+		CreateObject<SimpleChannel>());
+	ipv4.Assign(hostLink);
+	ipv4.NewNetwork();
+	for (uint32_t spine = 0; spine < nSpines; spine++) {
+		for (uint32_t leaf = 0; leaf < 2; leaf++) {
+			ipv4.Assign(simpleHelper.Install(
+				NodeContainer(leaves.Get(leaf), spines.Get(spine)),
+				CreateObject<SimpleChannel>()));
+			ipv4.NewNetwork();
+		}
+	}
+	ipv4.SetBase("10.9.0.0", "255.255.0.0");
+	ipv4.Assign(simpleHelper.Install(
+		NodeContainer(leaves.Get(1), hosts.Get(1)),
+		CreateObject<SimpleChannel>()));
+	Ipv4DrillRoutingHelper::PopulateRoutingTables();
+	drillRouting.AssignStreams(leaves, stream);
+
+	Ptr<Ipv4> leafIpv4 = leaves.Get(0)->GetObject<Ipv4>();
+	Ptr<Ipv4DrillRouting> leafRouting = drillRouting.GetDrillRouting(leafIpv4);
+	std::vector<uint32_t> interfaces;
+	Ipv4RoutingProtocol::UnicastForwardCallback ucb = MakeBoundCallback(
+		&DrillReproducibilityTest::RecordInterface, &interfaces, leafIpv4);
+	Ptr<Packet> packet = Create<Packet>(100);
+	Ipv4Header header;
+	header.SetSource(Ipv4Address("10.1.0.1"));
+	for (uint32_t i = 0; i < 64; i++) {
+		header.SetDestination(Ipv4Address(Ipv4Address("10.9.1.0").Get() + i));
+		leafRouting->RouteInput(
+			packet, header, hostLink.Get(1), ucb,
+			Ipv4RoutingProtocol::MulticastForwardCallback(),
+			Ipv4RoutingProtocol::LocalDeliverCallback(),
+			Ipv4RoutingProtocol::ErrorCallback());
+	}
+
+	Simulator::Destroy();
+	return interfaces;
+}
+
+void DrillReproducibilityTest::DoRun() {
+	std::vector<uint32_t> first = RunWithStream(10);
+	NS_TEST_ASSERT_MSG_EQ(first.size(), 64, "Every packet is forwarded");
+	std::set<uint32_t> used(first.begin(), first.end());
+	NS_TEST_ASSERT_MSG_GT(used.size(), 1, "Packets are spread over the spines");
+
+	std::vector<uint32_t> second = RunWithStream(10);
+	NS_TEST_ASSERT_MSG_EQ((first == second), true,
+		                  "The same stream picks the same ports");
+
+	std::vector<uint32_t> other = RunWithStream(11);
+	NS_TEST_ASSERT_MSG_EQ(other.size(), 64, "Every packet is forwarded");
+	NS_TEST_ASSERT_MSG_EQ((first != other), true,
+		                  "Another stream picks other ports");
+}
+
+/**
+ * \ingroup drill-routing-tests
+ *
+ * \brief Ipv4 DRILL routing port queues test.
+ *
+ * A DRILL leaf A forwards packets from h0 to h1 over two point-to-point
+ * spines. Bytes are queued on its ports, in the device queue of one and the
+ * root queue disc of the other, between packets; each packet must leave by
+ * the port with the smaller backlog, read from the queues resolved for the
+ * port when it was first sampled.
+ */
+class DrillPortQueuesTest : public TestCase {
+public:
+	void DoRun() override;
+	DrillPortQueuesTest();
+
+private:
+	/**
+	 * \brief Records the output device of a forwarded packet.
+	 *
+	 * \param devices The devices recorded so far.
+	 * \param route The route of the packet.
+	 * \param p The packet.
+	 * \param header The IP header of the packet.
+	 */
+	static void RecordDevice(std::vector<Ptr<NetDevice>>* devices,
+		                     Ptr<Ipv4Route> route, Ptr<const Packet> p,
+		                     const Ipv4Header& header);
+};
+
+DrillPortQueuesTest::DrillPortQueuesTest()
+	: TestCase("DRILL routing picks the port with the smaller backlog") {}
+
+void DrillPortQueuesTest::RecordDevice(std::vector<Ptr<NetDevice>>* devices,
+	                                   Ptr<Ipv4Route> route,
+	                                   Ptr<const Packet> p,
+	                                   const Ipv4Header& header) {
+	devices->push_back(route->GetOutputDevice());
+}
+
+void DrillPortQueuesTest::DoRun() {
+	NodeContainer hosts;
+	hosts.Create(2);
+	NodeContainer leaves;
+	leaves.Create(2);
+	NodeContainer spines;
+	spines.Create(2);
+
+	InternetStackHelper internet;
+	Ipv4DrillRoutingHelper drillRouting;
+	internet.SetRoutingHelper(drillRouting);
+	internet.Install(hosts);
+	internet.Install(leaves);
+	internet.Install(spines);
+
+	PointToPointHelper p2p;
+	Ipv4AddressHelper ipv4;
+	ipv4.SetBase("10.1.0.0", "255.255.255.252");
+	NetDeviceContainer hostLink =
+		p2p.Install(NodeContainer(hosts.Get(0), leaves.Get(0)));
+	ipv4.Assign(hostLink);
+	ipv4.NewNetwork();
+	Ipv4InterfaceContainer dstInterfaces =
+		ipv4.Assign(p2p.Install(NodeContainer(leaves.Get(1), hosts.Get(1))));
+	ipv4.NewNetwork();
+	std::vector<Ptr<PointToPointNetDevice>> uplinks;
+	for (uint32_t spine = 0; spine < 2; spine++) {
+		for (uint32_t leaf = 0; leaf < 2; leaf++) {
+			NetDeviceContainer link =
+				p2p.Install(NodeContainer(leaves.Get(leaf), spines.Get(spine)));
+			ipv4.Assign(link);
+			ipv4.NewNetwork();
+			if (leaf == 0) {
+				uplinks.push_back(
+					DynamicCast<PointToPointNetDevice>(link.Get(0)));
+			}
+		}
+	}
+	Ipv4DrillRoutingHelper::PopulateRoutingTables();
+
+	// Queue discs are initialized with their node, at the start of a run.
+	leaves.Get(0)->Initialize();
+	Ptr<Ipv4DrillRouting> leafRouting =
+		drillRouting.GetDrillRouting(leaves.Get(0)->GetObject<Ipv4>());
+	Ptr<TrafficControlLayer> tc =
+		leaves.Get(0)->GetObject<TrafficControlLayer>();
+	Ptr<QueueDisc> uplinkQueueDisc =
+		tc->GetRootQueueDiscOnDevice(uplinks[1]);
+	NS_TEST_ASSERT_MSG_NE(uplinkQueueDisc, nullptr,
+		                  "The uplinks have a root queue disc");
+
+	std::vector<Ptr<NetDevice>> devices;
+	Ipv4RoutingProtocol::UnicastForwardCallback ucb =
+		MakeBoundCallback(&DrillPortQueuesTest::RecordDevice, &devices);
+	Ipv4Header header;
+	header.SetSource(Ipv4Address("10.1.0.1"));
+	header.SetDestination(dstInterfaces.GetAddress(1));
+	header.SetProtocol(17);
+	auto forward = [&]() {
+		leafRouting->RouteInput(
+			Create<Packet>(100), header, hostLink.Get(1), ucb,
+			Ipv4RoutingProtocol::MulticastForwardCallback(),
+			Ipv4RoutingProtocol::LocalDeliverCallback(),
+			Ipv4RoutingProtocol::ErrorCallback());
+	};
+
+	uplinks[0]->GetQueue()->Enqueue(Create<Packet>(1000));
+	forward();
+	NS_TEST_ASSERT_MSG_EQ(devices.size(), 1, "The packet is forwarded");
+	NS_TEST_ASSERT_MSG_EQ((devices.back() == uplinks[1]), true,
+		                  "The port with an empty device queue is picked");
+
+	for (uint32_t i = 0; i < 3; i++) {
+		uplinkQueueDisc->Enqueue(Create<Ipv4QueueDiscItem>(
+			Create<Packet>(1000), Mac48Address::GetBroadcast(), 0x0800,
+			header));
+	}
+	forward();
+	NS_TEST_ASSERT_MSG_EQ(devices.size(), 2, "The packet is forwarded");
+	NS_TEST_ASSERT_MSG_EQ((devices.back() == uplinks[0]), true,
+		                  "The backlog of the queue disc is counted");
+
+	Simulator::Destroy();
+}
+
 
 class DrillRoutingTestCase1 : public TestCase
 {
@@ -180,6 +478,9 @@ DrillRoutingTestSuite::DrillRoutingTestSuite()
 {
     // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
 	AddTestCase(new LinkTest, TestCase::QUICK);
+	AddTestCase(new DrillAssignStreamsTest, TestCase::QUICK);
+	AddTestCase(new DrillReproducibilityTest, TestCase::QUICK);
+	AddTestCase(new DrillPortQueuesTest, TestCase::QUICK);
     AddTestCase(new DrillRoutingTestCase1, TestCase::QUICK);
 }
 
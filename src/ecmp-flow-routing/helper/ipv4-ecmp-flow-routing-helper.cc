@@ -46,6 +46,10 @@ void Ipv4EcmpFlowRoutingHelper::RecomputeRoutingTables() {
 	GlobalRouteManager::InitializeRoutes();
 }
 
+void Ipv4EcmpFlowRoutingHelper::UpdateRoutingTables() {
+	GlobalRouteManager::UpdateRoutes();
+}
+
 Ptr<Ipv4EcmpFlowRouting>
 Ipv4EcmpFlowRoutingHelper::GetEcmpFlowRouting(Ptr<Ipv4> ipv4) const {
 	Ptr<Ipv4RoutingProtocol> ipv4rp = ipv4->GetRoutingProtocol();
@@ -61,6 +61,13 @@ public:
 	 */
 	static void RecomputeRoutingTables();
 
+	/**
+	 * \brief Update the routes that were previously installed after links
+	 * went up or down, recomputing only the routes the changes affect. The
+	 * routes are the same as those of RecomputeRoutingTables().
+	 */
+	static void UpdateRoutingTables();
+
 	/**
 	 * \brief Retrieve the Ipv4EcmpFlowRouting protocol attached to the
 	 * helper.
@@ -1,6 +1,9 @@
 #include "ipv4-ecmp-flow-routing.h"
 
-#include "ns3/flow-id-tag.h"
+#include "ns3/crc32.h"
+#include "ns3/enum.h"
+#include "ns3/flow-key-tag.h"
+#include "ns3/hash-fnv.h"
 #include "ns3/ipv4-route.h"
 #include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/log.h"
@@ -10,6 +13,7 @@
 #include "ns3/object.h"
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
+#include "ns3/uinteger.h"
 
 #include <vector>
 
@@ -20,15 +24,79 @@ NS_LOG_COMPONENT_DEFINE("Ipv4EcmpFlowRouting");
 
 NS_OBJECT_ENSURE_REGISTERED(Ipv4EcmpFlowRouting);
 
+namespace
+{
+
+// Size of the buffer hashed for each flow: source and destination
+// addresses, protocol, TTL, flow key and seed.
+const uint32_t FLOW_KEY_SIZE = 22;
+
+// Bits by which each unit of seed shifts the CRC bits that pick a route.
+// Switches whose seeds differ by one read disjoint windows of 5 bits, enough
+// for groups of up to 32 routes.
+const uint32_t CRC_SEED_BIT_OFFSET = 5;
+
+// Rotates the low `width` bits of `value` right by `bits`.
+inline uint32_t RotateRight(uint32_t value, uint32_t bits, uint32_t width) {
+	bits %= width;
+	if (bits == 0) {
+		return value;
+	}
+	uint32_t mask = (width == 32) ? 0xffffffff : ((1u << width) - 1);
+	return ((value >> bits) | (value << (width - bits))) & mask;
+}
+
+// Writes `value` to `buffer` in network byte order.
+inline void WriteU32(uint8_t* buffer, uint32_t value) {
+	buffer[0] = static_cast<uint8_t>(value >> 24);
+	buffer[1] = static_cast<uint8_t>(value >> 16);
+	buffer[2] = static_cast<uint8_t>(value >> 8);
+	buffer[3] = static_cast<uint8_t>(value);
+}
+
+// CRC-16/CCITT, as used by the ECMP hash units of many switch ASICs.
+uint16_t Crc16Calculate(const uint8_t* data, uint32_t length) {
+	uint16_t crc = 0xffff;
+	for (uint32_t i = 0; i < length; i++) {
+		crc ^= static_cast<uint16_t>(data[i]) << 8;
+		for (uint32_t bit = 0; bit < 8; bit++) {
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+		}
+	}
+	return crc;
+}
+
+}  // namespace
+
 TypeId Ipv4EcmpFlowRouting::GetTypeId() {
 	static TypeId tid = TypeId("ns3::Ipv4EcmpFlowRouting")
 	    .SetParent<Object>()
-	    .SetGroupName("Internet");
+	    .SetGroupName("Internet")
+	    .AddAttribute("HashAlgorithm",
+	                  "The hash function used to pick the route of a flow",
+	                  EnumValue(ECMP_HASH_MURMUR3),
+	                  MakeEnumAccessor(&Ipv4EcmpFlowRouting::m_hashAlgorithm),
+	                  MakeEnumChecker(ECMP_HASH_CRC16, "Crc16",
+	                                  ECMP_HASH_CRC32, "Crc32",
+	                                  ECMP_HASH_MURMUR3, "Murmur3",
+	                                  ECMP_HASH_FNV1A, "Fnv1a"))
+	    .AddAttribute("HashSeed",
+	                  "A per-switch salt mixed into the flow hash to avoid "
+	                  "hash polarization across tiers. With CRC hashes, it "
+	                  "selects the bits of the CRC that pick the route, so "
+	                  "adjacent tiers need different seeds",
+	                  UintegerValue(0),
+	                  MakeUintegerAccessor(&Ipv4EcmpFlowRouting::m_hashSeed),
+	                  MakeUintegerChecker<uint32_t>());
 	return tid;
 }
 
 Ipv4EcmpFlowRouting::Ipv4EcmpFlowRouting(Ptr<Ipv4GlobalRouting> globalRouting)
-    : m_ipv4(nullptr), m_globalRouting(globalRouting)
+    : m_hashAlgorithm(ECMP_HASH_MURMUR3),
+      m_hashSeed(0),
+      m_fnvHasher(Create<Hash::Function::Fnv1a>()),
+      m_ipv4(nullptr),
+      m_globalRouting(globalRouting)
 {
 	NS_LOG_FUNCTION(this);
 }
@@ -39,29 +107,29 @@ Ipv4EcmpFlowRouting::~Ipv4EcmpFlowRouting() {
 
 Ptr<Ipv4Route> Ipv4EcmpFlowRouting::PickEcmpRoute(Ipv4Address dst,
 	                                              const Ipv4Header& header,
-	                                              uint32_t flowId,
+	                                              uint64_t flowKey,
 	                                              Ptr<NetDevice> oif) {
-	NS_LOG_FUNCTION(this << dst << header << flowId << oif);
+	NS_LOG_FUNCTION(this << dst << header << flowKey << oif);
 	NS_LOG_LOGIC("Looking for route to destination " << dst);
 	Ptr<Ipv4Route> rtentry = nullptr;
-	std::vector<Ipv4RoutingTableEntry*> allRoutes = m_globalRouting->GetRoutesToDst(dst, oif);
+	const Ipv4GlobalRouting::RouteGroup& allRoutes =
+	    m_globalRouting->GetRoutesToDst(dst, oif);
 
 	if (!allRoutes.empty()) {
 		uint32_t selectIndex;
-		// If the flow ID is 0, it may be the socket setup endpoint request.
+		// If the flow key is 0, it may be the socket setup endpoint request.
 		// So we simply return the first available route to indicate that
 		// the address is not local.
-		if (flowId != 0) {
-			std::stringstream hash_string;
-			hash_string << flowId;
-			hash_string << header.GetTtl();
-			uint32_t hashedVal = Hash32(hash_string.str());
-			selectIndex = hashedVal % allRoutes.size();
+		if (flowKey != 0) {
+			uint32_t hashedVal = HashFlow(header, flowKey);
+			// Weighted groups spread the flows in proportion to the weights.
+			selectIndex =
+			    m_globalRouting->PickWeightedRoute(dst, allRoutes, hashedVal);
 			NS_LOG_LOGIC("Per flow ECMP is enabled, selected index: "
-				<< selectIndex << " for flow: " << flowId);
+				<< selectIndex << " for flow: " << flowKey);
 		} else {
 			selectIndex = 0;
-			NS_LOG_LOGIC("Flow ID was 0, picking default route");
+			NS_LOG_LOGIC("Flow key was 0, picking default route");
 		}
 
 		Ipv4RoutingTableEntry* route = allRoutes.at(selectIndex);
@@ -82,8 +150,8 @@ Ipv4EcmpFlowRouting::RouteOutput(Ptr<Packet> p,
 	                             Ptr<NetDevice> oif,
 	                             Socket::SocketErrno& sockerr) {
 	NS_LOG_FUNCTION(this << p << &header << oif << &sockerr);
-	// Recover the flow ID.
-	uint32_t flowId = ExtractFlowId(p);
+	// Recover the flow key.
+	uint64_t flowKey = ExtractFlowKey(p);
 
 	// ECMP flow-level routing does not support multicast.
 	if (header.GetDestination().IsMulticast()) {
@@ -93,7 +161,7 @@ Ipv4EcmpFlowRouting::RouteOutput(Ptr<Packet> p,
 	// Check if this is a unicast packet that we have a route for.
 	NS_LOG_LOGIC("Unicast destination - looking for route");
 	Ptr<Ipv4Route> rtentry = PickEcmpRoute(
-		header.GetDestination(), header, flowId, oif);
+		header.GetDestination(), header, flowKey, oif);
 	if (rtentry) {
 		sockerr = Socket::ERROR_NOTERROR;
 	} else {
@@ -138,9 +206,9 @@ bool Ipv4EcmpFlowRouting::RouteInput(Ptr<const Packet> p,
 	}
 	// Next, try to find a route.
 	NS_LOG_LOGIC("Unicast destination - looking up route");
-	uint32_t flowId = ExtractFlowId(ConstCast<Packet>(p));
+	uint64_t flowKey = ExtractFlowKey(ConstCast<Packet>(p));
 	Ptr<Ipv4Route> rtentry = PickEcmpRoute(
-		header.GetDestination(), header, flowId);
+		header.GetDestination(), header, flowKey);
 	if (rtentry) {
 		NS_LOG_LOGIC("Found unicast destination - calling unicast callback");
 		ucb(rtentry, p, header);
@@ -197,16 +265,64 @@ void Ipv4EcmpFlowRouting::PrintRoutingTable(Ptr<OutputStreamWrapper> stream,
 	m_globalRouting->PrintRoutingTable(stream, unit);
 }
 
-uint32_t Ipv4EcmpFlowRouting::ExtractFlowId(Ptr<Packet> p) {
-	uint32_t flowId = 0;
-	if (p != nullptr) {
-		FlowIdTag flowIdTag;
-		bool found = p->PeekPacketTag(flowIdTag);
-		if (found) {
-			flowId = flowIdTag.GetFlowId();
+int32_t Ipv4EcmpFlowRouting::GetRouteIndex(const Ipv4Header& header,
+	                                       uint64_t flowKey) {
+	const Ipv4GlobalRouting::RouteGroup& allRoutes =
+	    m_globalRouting->GetRoutesToDst(header.GetDestination());
+	if (allRoutes.empty()) {
+		return -1;
+	}
+	// Flows without a key take the first route, as in PickEcmpRoute.
+	if (flowKey == 0) {
+		return 0;
+	}
+	return m_globalRouting->PickWeightedRoute(
+	    header.GetDestination(), allRoutes, HashFlow(header, flowKey));
+}
+
+uint32_t Ipv4EcmpFlowRouting::HashFlow(const Ipv4Header& header,
+	                                   uint64_t flowKey) {
+	uint8_t buffer[FLOW_KEY_SIZE];
+	WriteU32(buffer, header.GetSource().Get());
+	WriteU32(buffer + 4, header.GetDestination().Get());
+	buffer[8] = header.GetProtocol();
+	buffer[9] = header.GetTtl();
+	WriteU32(buffer + 10, static_cast<uint32_t>(flowKey >> 32));
+	WriteU32(buffer + 14, static_cast<uint32_t>(flowKey));
+	WriteU32(buffer + 18, m_hashSeed);
+
+	// A CRC is affine: another seed, whether hashed with the flow or used as
+	// the initial value, only XORs the CRC with a constant. Switches would
+	// then pick routes from the same bits, so all the flows a switch sends
+	// to one port would take one port at the next tier. The seed instead
+	// picks which bits of the CRC select the route.
+	uint32_t crcOffset = m_hashSeed * CRC_SEED_BIT_OFFSET;
+	switch (m_hashAlgorithm) {
+		case ECMP_HASH_CRC16:
+			return RotateRight(Crc16Calculate(buffer, FLOW_KEY_SIZE),
+			                   crcOffset, 16);
+		case ECMP_HASH_CRC32:
+			return RotateRight(CRC32Calculate(buffer, FLOW_KEY_SIZE),
+			                   crcOffset, 32);
+		case ECMP_HASH_FNV1A: {
+			// The low bits of FNV-1a only depend on the low bits of each
+			// byte, so the high bits are folded in before the route is picked.
+			uint32_t hash = m_fnvHasher.clear().GetHash32(
+				reinterpret_cast<const char*>(buffer), FLOW_KEY_SIZE);
+			return hash ^ (hash >> 16);
 		}
+		case ECMP_HASH_MURMUR3:
+		default:
+			return Hash32(reinterpret_cast<const char*>(buffer),
+				          FLOW_KEY_SIZE);
+	}
+}
+
+uint64_t Ipv4EcmpFlowRouting::ExtractFlowKey(Ptr<Packet> p) {
+	if (p == nullptr) {
+		return 0;
 	}
-	return flowId;
+	return FlowKeyTag::ExtractFlowKey(p);
 }
 
 }  // namespace ns3
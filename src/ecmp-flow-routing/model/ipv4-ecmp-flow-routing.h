@@ -14,6 +14,7 @@
 #include "ns3/data-rate.h"
 #include "ns3/nstime.h"
 #include "ns3/event-id.h"
+#include "ns3/hash.h"
 
 /**
  * \defgroup ecmp-flow-routing ECMP flow-level routing
@@ -29,6 +30,21 @@
 namespace ns3
 {
 
+/**
+ * \ingroup ecmp-flow-routing
+ * 
+ * \brief The hash functions available to select an ECMP route for a flow.
+ * 
+ * CRC16 and CRC32 mirror the hash units of switch ASICs, while Murmur3 and
+ * FNV-1a are the general purpose hashes provided by ns-3.
+ */
+enum EcmpHashAlgorithm {
+    ECMP_HASH_CRC16 = 0,
+    ECMP_HASH_CRC32 = 1,
+    ECMP_HASH_MURMUR3 = 2,
+    ECMP_HASH_FNV1A = 3
+};
+
 /**
  * \ingroup ecmp-flow-routing
  * 
@@ -78,35 +94,79 @@ public:
     Ipv4RoutingTableEntry* GetRoute(uint32_t i) const;
 
     virtual void DoDispose(void) override;
+
+    /**
+     * \brief Tells which of the ECMP routes to its destination a flow takes.
+     * 
+     * Lets hosts find flow keys that take each path from this switch, the
+     * way traceroute finds source ports that do (see Ipv4CloveRouting).
+     * 
+     * \param header The header of the packets of the flow, as received.
+     * \param flowKey The key of the flow.
+     * 
+     * \return The index of the route in the ECMP group of the destination,
+     * or -1 if there is no route.
+     */
+    int32_t GetRouteIndex(const Ipv4Header& header, uint64_t flowKey);
 private:
     /**
      * \brief Choose a route according to ECMP flow-level routing.
      * 
-     * The flow ID is used to ensure that every packet for a flow uses
+     * The flow key is used to ensure that every packet for a flow uses
      * the same route, but the route for each flow is chosen at random.
      * 
      * \param dst The destination address.
      * \param header The packet header for the packet being routed.
-     * \param flowId The ID of the flow to which the packet belongs.
+     * \param flowKey The key of the flow to which the packet belongs.
      * \param oif The output interface if any (put nullptr otherwise).
      * 
      * \return Ipv4Route to route the packet to the destination.
      */
     Ptr<Ipv4Route> PickEcmpRoute(
         Ipv4Address dst, const Ipv4Header& header,
-        uint32_t flowId, Ptr<NetDevice> oif = nullptr);
+        uint64_t flowKey, Ptr<NetDevice> oif = nullptr);
+
+    /**
+     * \brief Hashes the flow of a packet to pick one of its ECMP routes.
+     * 
+     * The source and destination addresses, protocol, TTL, flow key and the
+     * per-switch seed are packed into a fixed-size buffer on the stack and
+     * hashed with the configured hash algorithm. The TTL and seed make the
+     * choice differ between tiers, avoiding hash polarization.
+     * 
+     * Changing the TTL or seed of a CRC only XORs it with a constant, so
+     * the CRC hashes are rotated right by 5 bits per unit of seed instead,
+     * the way switch ASICs select hash bits. Switches of adjacent tiers
+     * must then have different seeds: with the same seed, the flows a
+     * switch sends to one port all take the same port at the next tier.
+     * 
+     * \param header The packet header for the packet being routed.
+     * \param flowKey The key of the flow to which the packet belongs.
+     * 
+     * \return The hash of the flow.
+     */
+    uint32_t HashFlow(const Ipv4Header& header, uint64_t flowKey);
 
     /**
-     * \brief Extracts the flow ID for a packet.
+     * \brief Extracts the flow key for a packet.
      * 
-     * The flow ID is used by ECMP to make sure that all packets associated
+     * The flow key is used by ECMP to make sure that all packets associated
      * with a flow traverse the same path.
      * 
-     * \param p The packet from which the flow ID is extracted.
+     * \param p The packet from which the flow key is extracted.
      * 
-     * \return int The flow ID identifying the packet for the flow.
+     * \return The key of the flow, or 0 if the packet is not tagged.
      */
-    uint32_t ExtractFlowId(Ptr<Packet> p);
+    uint64_t ExtractFlowKey(Ptr<Packet> p);
+
+    // The hash function used to pick a route for each flow.
+    EcmpHashAlgorithm m_hashAlgorithm;
+
+    // A per-switch salt mixed into every flow hash.
+    uint32_t m_hashSeed;
+
+    // Hasher used for FNV-1a. Murmur3 uses the global ns-3 hasher.
+    Hasher m_fnvHasher;
 
     // Ipv4 address associated with this router.
     Ptr<Ipv4> m_ipv4;
@@ -13,9 +13,14 @@
 #include "ns3/simple-net-device-helper.h"
 #include "ns3/simple-net-device.h"
 #include "ns3/simulator.h"
+#include "ns3/string.h"
 #include "ns3/test.h"
 #include "ns3/uinteger.h"
 
+#include <set>
+#include <string>
+#include <vector>
+
 using namespace ns3;
 
 
@@ -128,6 +133,245 @@ void LinkTest::DoRun() {
 }
 
 
+/**
+ * \ingroup ecmp-flow-routing-tests
+ * 
+ * \brief Ipv4 Ecmp Flow Routing hash test.
+ * 
+ * A leaf A reaches h1 over four spines:
+ * 
+ *    h0 --- A === 4 spines === B --- h1
+ * 
+ * The route A gives many flows to h1 only depends on its HashAlgorithm and
+ * HashSeed attributes: the same attributes must give the same routes, and
+ * another algorithm or seed other routes.
+ */
+class HashSelectionTest : public TestCase {
+public:
+  void DoRun() override;
+  HashSelectionTest();
+
+private:
+  /**
+   * \brief Gets the routes a leaf configured with a hash gives to flows.
+   * 
+   * \param algorithm The name of the hash algorithm of the leaf.
+   * \param seed The hash seed of the leaf.
+   * 
+   * \returns the index of the route of each flow.
+   */
+  std::vector<int32_t> RouteFlows(std::string algorithm, uint32_t seed);
+};
+
+HashSelectionTest::HashSelectionTest()
+    : TestCase("ECMP flow routing picks routes by hash algorithm and seed") {}
+
+std::vector<int32_t> HashSelectionTest::RouteFlows(std::string algorithm,
+                                                   uint32_t seed) {
+  const uint32_t nSpines = 4;
+  NodeContainer hosts;
+  hosts.Create(2);
+  NodeContainer leaves;
+  leaves.Create(2);
+  NodeContainer spines;
+  spines.Create(nSpines);
+
+  InternetStackHelper internet;
+  Ipv4EcmpFlowRoutingHelper ecmpFlowRouting;
+  internet.SetRoutingHelper(ecmpFlowRouting);
+  internet.Install(hosts);
+  internet.Install(leaves);
+  internet.Install(spines);
+
+  SimpleNetDeviceHelper simpleHelper;
+  simpleHelper.SetNetDevicePointToPointMode(true);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase("10.1.0.0", "255.255.255.252");
+  ipv4.Assign(simpleHelper.Install(
+    NodeContainer(hosts.Get(0), leaves.Get(0)),
+    CreateObject<SimpleChannel>()));
+  ipv4.NewNetwork();
+  for (uint32_t spine = 0; spine < nSpines; spine++) {
+    for (uint32_t leaf = 0; leaf < 2; leaf++) {
+      ipv4.Assign(simpleHelper.Install(
+        NodeContainer(leaves.Get(leaf), spines.Get(spine)),
+        CreateObject<SimpleChannel>()));
+      ipv4.NewNetwork();
+    }
+  }
+  ipv4.SetBase("10.9.0.0", "255.255.255.0");
+  ipv4.Assign(simpleHelper.Install(
+    NodeContainer(leaves.Get(1), hosts.Get(1)),
+    CreateObject<SimpleChannel>()));
+  Ipv4EcmpFlowRoutingHelper::PopulateRoutingTables();
+
+  Ptr<Ipv4EcmpFlowRouting> leafRouting =
+      ecmpFlowRouting.GetEcmpFlowRouting(leaves.Get(0)->GetObject<Ipv4>());
+  leafRouting->SetAttribute("HashAlgorithm", StringValue(algorithm));
+  leafRouting->SetAttribute("HashSeed", UintegerValue(seed));
+
+  Ipv4Header header;
+  header.SetSource(Ipv4Address("10.1.0.1"));
+  header.SetDestination(Ipv4Address("10.9.0.2"));
+  header.SetProtocol(6);
+  header.SetTtl(63);
+  std::vector<int32_t> routes;
+  for (uint64_t flowKey = 1; flowKey <= 64; flowKey++) {
+    routes.push_back(leafRouting->GetRouteIndex(header, flowKey));
+  }
+
+  Simulator::Destroy();
+  return routes;
+}
+
+void HashSelectionTest::DoRun() {
+  std::vector<int32_t> first = RouteFlows("Murmur3", 0);
+  std::set<int32_t> used(first.begin(), first.end());
+  NS_TEST_ASSERT_MSG_EQ(used.size(), 4, "Flows are spread over the spines");
+  NS_TEST_ASSERT_MSG_EQ(used.count(-1), 0, "Every flow has a route");
+
+  std::vector<int32_t> second = RouteFlows("Murmur3", 0);
+  NS_TEST_ASSERT_MSG_EQ((first == second), true,
+                        "The same hash picks the same routes");
+
+  std::vector<int32_t> seeded = RouteFlows("Murmur3", 1234);
+  NS_TEST_ASSERT_MSG_EQ((first != seeded), true,
+                        "Another seed picks other routes");
+
+  for (std::string algorithm : {"Crc16", "Crc32", "Fnv1a"}) {
+    std::vector<int32_t> other = RouteFlows(algorithm, 0);
+    used = std::set<int32_t>(other.begin(), other.end());
+    NS_TEST_ASSERT_MSG_EQ(used.size(), 4,
+                          algorithm << " spreads flows over the spines");
+    NS_TEST_ASSERT_MSG_EQ((first != other), true,
+                          algorithm << " picks other routes than Murmur3");
+  }
+}
+
+
+/**
+ * \ingroup ecmp-flow-routing-tests
+ * 
+ * \brief Ipv4 Ecmp Flow Routing hash polarization test.
+ * 
+ * A leaf A reaches h1 over two tiers of four switches:
+ * 
+ *    h0 --- A === 4 aggregates === 4 spines === B --- h1
+ * 
+ * where every aggregate is linked to every spine. A and each aggregate have
+ * four routes to h1. The flows A sends to one aggregate must still spread
+ * over all the spines when the aggregates have another seed than A, for
+ * every hash algorithm.
+ */
+class HashPolarizationTest : public TestCase {
+public:
+  void DoRun() override;
+  HashPolarizationTest();
+};
+
+HashPolarizationTest::HashPolarizationTest()
+    : TestCase("ECMP flow routing spreads flows again at the next tier") {}
+
+void HashPolarizationTest::DoRun() {
+  const uint32_t nSwitches = 4;
+  const uint64_t nFlows = 2000;
+  NodeContainer hosts;
+  hosts.Create(2);
+  NodeContainer leaves;
+  leaves.Create(2);
+  NodeContainer aggregates;
+  aggregates.Create(nSwitches);
+  NodeContainer spines;
+  spines.Create(nSwitches);
+
+  InternetStackHelper internet;
+  Ipv4EcmpFlowRoutingHelper ecmpFlowRouting;
+  internet.SetRoutingHelper(ecmpFlowRouting);
+  internet.Install(hosts);
+  internet.Install(leaves);
+  internet.Install(aggregates);
+  internet.Install(spines);
+
+  SimpleNetDeviceHelper simpleHelper;
+  simpleHelper.SetNetDevicePointToPointMode(true);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase("10.1.0.0", "255.255.255.252");
+  ipv4.Assign(simpleHelper.Install(
+    NodeContainer(hosts.Get(0), leaves.Get(0)),
+    CreateObject<SimpleChannel>()));
+  ipv4.NewNetwork();
+  for (uint32_t i = 0; i < nSwitches; i++) {
+    ipv4.Assign(simpleHelper.Install(
+      NodeContainer(leaves.Get(0), aggregates.Get(i)),
+      CreateObject<SimpleChannel>()));
+    ipv4.NewNetwork();
+    ipv4.Assign(simpleHelper.Install(
+      NodeContainer(spines.Get(i), leaves.Get(1)),
+      CreateObject<SimpleChannel>()));
+    ipv4.NewNetwork();
+    for (uint32_t j = 0; j < nSwitches; j++) {
+      ipv4.Assign(simpleHelper.Install(
+        NodeContainer(aggregates.Get(i), spines.Get(j)),
+        CreateObject<SimpleChannel>()));
+      ipv4.NewNetwork();
+    }
+  }
+  ipv4.SetBase("10.9.0.0", "255.255.255.0");
+  ipv4.Assign(simpleHelper.Install(
+    NodeContainer(leaves.Get(1), hosts.Get(1)),
+    CreateObject<SimpleChannel>()));
+  Ipv4EcmpFlowRoutingHelper::PopulateRoutingTables();
+
+  Ptr<Ipv4EcmpFlowRouting> leafRouting =
+      ecmpFlowRouting.GetEcmpFlowRouting(leaves.Get(0)->GetObject<Ipv4>());
+  // Every aggregate has the same routes and seed, so they all give a flow
+  // the same route index and the first one stands for all of them.
+  Ptr<Ipv4EcmpFlowRouting> aggregateRouting =
+      ecmpFlowRouting.GetEcmpFlowRouting(
+        aggregates.Get(0)->GetObject<Ipv4>());
+
+  // The header of a flow as the leaf receives it from h0. The aggregate
+  // receives it once the leaf has decremented the TTL.
+  Ipv4Header header;
+  header.SetSource(Ipv4Address("10.1.0.1"));
+  header.SetDestination(Ipv4Address("10.9.0.2"));
+  header.SetProtocol(6);
+
+  for (std::string algorithm : {"Crc16", "Crc32", "Murmur3", "Fnv1a"}) {
+    leafRouting->SetAttribute("HashAlgorithm", StringValue(algorithm));
+    leafRouting->SetAttribute("HashSeed", UintegerValue(0));
+    aggregateRouting->SetAttribute("HashAlgorithm", StringValue(algorithm));
+    aggregateRouting->SetAttribute("HashSeed", UintegerValue(1));
+
+    std::vector<uint32_t> spineFlows(nSwitches, 0);
+    uint32_t aggregateFlows = 0;
+    for (uint64_t flowKey = 1; flowKey <= nFlows; flowKey++) {
+      header.SetTtl(64);
+      if (leafRouting->GetRouteIndex(header, flowKey) != 0) {
+        continue;
+      }
+      aggregateFlows++;
+      header.SetTtl(63);
+      int32_t spine = aggregateRouting->GetRouteIndex(header, flowKey);
+      NS_TEST_ASSERT_MSG_EQ((spine >= 0 && spine < (int32_t)nSwitches), true,
+                            algorithm << " gives the flow a route");
+      spineFlows[spine]++;
+    }
+
+    NS_TEST_ASSERT_MSG_GT(aggregateFlows, nFlows / (2 * nSwitches),
+                          algorithm << " sends flows to the aggregate");
+    for (uint32_t spine = 0; spine < nSwitches; spine++) {
+      NS_TEST_ASSERT_MSG_GT(spineFlows[spine],
+                            aggregateFlows / (2 * nSwitches),
+                            algorithm << " sends the flows of one aggregate "
+                            << "to spine " << spine);
+    }
+  }
+
+  Simulator::Destroy();
+}
+
+
 class EcmpFlowRoutingTestCase1 : public TestCase
 {
   public:
@@ -182,6 +426,8 @@ EcmpFlowRoutingTestSuite::EcmpFlowRoutingTestSuite()
 {
     // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
     AddTestCase(new LinkTest, TestCase::QUICK);
+    AddTestCase(new HashSelectionTest, TestCase::QUICK);
+    AddTestCase(new HashPolarizationTest, TestCase::QUICK);
     AddTestCase(new EcmpFlowRoutingTestCase1, TestCase::QUICK);
 }
 
@@ -19,6 +19,8 @@
 
 #include "flow-monitor-helper.h"
 
+#include "ns3/abort.h"
+#include "ns3/enum.h"
 #include "ns3/flow-monitor.h"
 #include "ns3/ipv4-flow-classifier.h"
 #include "ns3/ipv4-flow-probe.h"
@@ -28,6 +30,7 @@
 #include "ns3/ipv6-l3-protocol.h"
 #include "ns3/node-list.h"
 #include "ns3/node.h"
+#include "ns3/uinteger.h"
 
 namespace ns3
 {
@@ -54,6 +57,15 @@ FlowMonitorHelper::SetMonitorAttribute(std::string n1, const AttributeValue& v1)
     m_monitorFactory.Set(n1, v1);
 }
 
+void
+FlowMonitorHelper::SetMonitoringFidelity(FlowMonitor::Fidelity fidelity, uint32_t samplingInterval)
+{
+    NS_ABORT_MSG_IF(m_flowMonitor, "The fidelity must be set before the FlowMonitor is created");
+    NS_ABORT_MSG_IF(samplingInterval == 0, "The sampling interval must be positive");
+    m_monitorFactory.Set("Fidelity", EnumValue(fidelity));
+    m_monitorFactory.Set("SamplingInterval", UintegerValue(samplingInterval));
+}
+
 Ptr<FlowMonitor>
 FlowMonitorHelper::GetMonitor()
 {
@@ -221,4 +233,31 @@ void FlowMonitorHelper::LbPerformanceMetricsToFile(std::string fileName,
   }
 }
 
+void FlowMonitorHelper::LbPerformanceMetricsToBinaryStream(std::ostream& os) {
+  if (m_flowMonitor) {
+    m_flowMonitor->LbPerformanceMetricsToBinaryStream(os);
+  }
+}
+
+void FlowMonitorHelper::LbPerformanceMetricsToBinaryFile(std::string fileName) {
+  if (m_flowMonitor) {
+    m_flowMonitor->LbPerformanceMetricsToBinaryFile(fileName);
+  }
+}
+
+void FlowMonitorHelper::StreamLbPerformanceMetricsToFile(std::string fileName,
+                                                         Time::Unit timeUnit) {
+  GetMonitor()->StreamLbPerformanceMetricsToFile(fileName, timeUnit);
+}
+
+void FlowMonitorHelper::FinishFlow(
+    const Ipv4FlowClassifier::FiveTuple& tuple) {
+  FlowId flowId;
+  if (m_flowMonitor &&
+      DynamicCast<Ipv4FlowClassifier>(m_flowClassifier4)->LookupFlowId(
+        tuple, &flowId)) {
+    m_flowMonitor->FinishFlow(flowId);
+  }
+}
+
 } // namespace ns3
@@ -21,6 +21,7 @@
 
 #include "ns3/flow-classifier.h"
 #include "ns3/flow-monitor.h"
+#include "ns3/ipv4-flow-classifier.h"
 #include "ns3/node-container.h"
 #include "ns3/object-factory.h"
 
@@ -30,7 +31,6 @@ namespace ns3
 {
 
 class AttributeValue;
-class Ipv4FlowClassifier;
 class Ipv6FlowClassifier;
 
 /**
@@ -54,6 +54,23 @@ class FlowMonitorHelper
      */
     void SetMonitorAttribute(std::string n1, const AttributeValue& v1);
 
+    /**
+     * \brief Set how much the to-be-created FlowMonitor object follows each
+     * packet, trading the detail of its statistics for memory and time in
+     * long runs
+     *
+     * At FlowMonitor::FULL fidelity every packet is tracked from hop to hop;
+     * at FlowMonitor::SAMPLED fidelity one packet of each flow in
+     * samplingInterval is, for delays and jitters; at FlowMonitor::ENDPOINTS
+     * fidelity packets are only counted where they are sent and received,
+     * which is enough for flow completion times.
+     *
+     * \param fidelity how much each packet is followed
+     * \param samplingInterval one packet in this many is tracked at
+     * FlowMonitor::SAMPLED fidelity
+     */
+    void SetMonitoringFidelity(FlowMonitor::Fidelity fidelity, uint32_t samplingInterval = 16);
+
     /**
      * \brief Enable flow monitoring on a set of nodes
      * \param nodes A NodeContainer holding the set of nodes to work with.
@@ -167,6 +184,40 @@ class FlowMonitorHelper
      void LbPerformanceMetricsToFile(std::string fileName,
                                      Time::Unit timeUnit = Time::NS);
 
+    /**
+     * Writes the load balancing performance metrics to a std::ostream in a
+     * binary columnar format. See
+     * FlowMonitor::LbPerformanceMetricsToBinaryStream, which also tells how
+     * it combines with StreamLbPerformanceMetricsToFile.
+     * \param os the output stream.
+     */
+    void LbPerformanceMetricsToBinaryStream(std::ostream& os);
+
+    /**
+     * Same as LbPerformanceMetricsToBinaryStream but writes to a file
+     * instead.
+     * \param fileName name of path of the output file that will be created.
+     */
+    void LbPerformanceMetricsToBinaryFile(std::string fileName);
+
+    /**
+     * Writes the load balancing performance metrics of each flow to a file
+     * as soon as the flow finishes, and then forgets the flow. See
+     * FlowMonitor::StreamLbPerformanceMetricsToFile.
+     * \param fileName name of path of the output file that will be created.
+     * \param timeUnit the unit of time for reporting time values (default is
+     *                 nanoseconds).
+     */
+    void StreamLbPerformanceMetricsToFile(std::string fileName,
+                                          Time::Unit timeUnit = Time::NS);
+
+    /**
+     * Finishes an IPv4 flow, for instance once its application received its
+     * last expected byte. Does nothing if the flow was never seen.
+     * \param tuple the five-tuple of the flow.
+     */
+    void FinishFlow(const Ipv4FlowClassifier::FiveTuple& tuple);
+
   private:
     ObjectFactory m_monitorFactory;        //!< Object factory
     Ptr<FlowMonitor> m_flowMonitor;        //!< the FlowMonitor object
@@ -68,6 +68,12 @@ class FlowClassifier : public SimpleRefCount<FlowClassifier>
     /// \param indent number of spaces to use as base indentation level
     virtual void SerializeToXmlStream(std::ostream& os, uint16_t indent) const = 0;
 
+    /// Forgets a flow that will not be reported anymore, so that a packet
+    /// with the same classification later starts a new flow, with a new
+    /// FlowId.  Does nothing by default.
+    /// \param flowId the FlowId of the flow
+    virtual void ReleaseFlow(FlowId flowId);
+
   protected:
     /// Returns a new, unique Flow Identifier
     /// \returns a new FlowId
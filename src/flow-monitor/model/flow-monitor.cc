@@ -20,22 +20,114 @@
 #include "flow-monitor.h"
 
 #include "ns3/double.h"
+#include "ns3/enum.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
+#include "ns3/uinteger.h"
 
 #include "ipv4-lb-flow-stats.h"
 #include "ipv4-flow-classifier.h"
 
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 
 #define PERIODIC_CHECK_INTERVAL (Seconds(1))
+/// The size of the buffer of the streamed LB performance metrics
+#define LB_STREAM_BUFFER_SIZE (1 << 20)
 
 namespace ns3
 {
 
 NS_LOG_COMPONENT_DEFINE("FlowMonitor");
 
+namespace
+{
+
+/// The header of the csv of LB performance metrics
+const char* const LB_METRICS_CSV_HEADER =
+    "FlowId,SourceAddress,DestinationAddress,TimeFirstTxPacket,"
+    "TimeLastTxPacket,TimeFirstRxPacket,TimeLastRxPacket,DelaySum,"
+    "JitterSum,TxBytes,RxBytes,TxPackets,RxPackets,Duration,EffectiveRate,"
+    "DelayCount,SamplingInterval";
+
+/**
+ * \brief Gets the name of a fidelity, as in the Fidelity attribute
+ * \param fidelity the fidelity
+ * \returns the name of the fidelity
+ */
+const char*
+GetFidelityName(FlowMonitor::Fidelity fidelity)
+{
+    switch (fidelity)
+    {
+    case FlowMonitor::FULL:
+        return "Full";
+    case FlowMonitor::SAMPLED:
+        return "Sampled";
+    default:
+        return "Endpoints";
+    }
+}
+
+/**
+ * \brief Gets the LB performance metrics of a flow
+ * \param stats the statistics of the flow
+ * \param tuple the five-tuple of the flow, or nullptr if it is not known
+ * \param samplingInterval the sampling interval of the fidelity of the stats
+ * \returns the LB performance metrics of the flow
+ */
+Ipv4LbFlowStats
+GetIpv4LbFlowStats(const FlowMonitor::FlowStats& stats,
+                   const Ipv4FlowClassifier::FiveTuple* tuple,
+                   uint32_t samplingInterval)
+{
+    Ipv4LbFlowStats ipv4LbFlowStats;
+
+    ipv4LbFlowStats.delaySum = stats.delaySum;
+    ipv4LbFlowStats.jitterSum = stats.jitterSum;
+    ipv4LbFlowStats.timeFirstTxPacket = stats.timeFirstTxPacket;
+    ipv4LbFlowStats.timeLastTxPacket = stats.timeLastTxPacket;
+    ipv4LbFlowStats.timeFirstRxPacket = stats.timeFirstRxPacket;
+    ipv4LbFlowStats.timeLastRxPacket = stats.timeLastRxPacket;
+    ipv4LbFlowStats.txBytes = stats.txBytes;
+    ipv4LbFlowStats.rxBytes = stats.rxBytes;
+    ipv4LbFlowStats.txPackets = stats.txPackets;
+    ipv4LbFlowStats.rxPackets = stats.rxPackets;
+    ipv4LbFlowStats.delayCount = stats.delayCount;
+    ipv4LbFlowStats.samplingInterval = samplingInterval;
+
+    if (tuple != nullptr)
+    {
+        ipv4LbFlowStats.sourceAddress = tuple->sourceAddress;
+        ipv4LbFlowStats.destinationAddress = tuple->destinationAddress;
+    }
+    return ipv4LbFlowStats;
+}
+
+/**
+ * \brief Writes the csv row of LB performance metrics of a flow
+ * \param os the output stream
+ * \param flowId the flow identification
+ * \param stats the statistics of the flow
+ * \param tuple the five-tuple of the flow, or nullptr if it is not known
+ * \param samplingInterval the sampling interval of the fidelity of the stats
+ * \param timeUnit the unit of time for reporting time values
+ */
+void
+WriteLbFlowStats(std::ostream& os,
+                 FlowId flowId,
+                 const FlowMonitor::FlowStats& stats,
+                 const Ipv4FlowClassifier::FiveTuple* tuple,
+                 uint32_t samplingInterval,
+                 Time::Unit timeUnit)
+{
+    Ipv4LbFlowStats ipv4LbFlowStats = GetIpv4LbFlowStats(stats, tuple, samplingInterval);
+    SerializeIpv4LbFlowStatsToCsvStream(os, flowId, ipv4LbFlowStats, timeUnit);
+}
+
+} // namespace
+
 NS_OBJECT_ENSURE_REGISTERED(FlowMonitor);
 
 TypeId
@@ -83,7 +175,32 @@ FlowMonitor::GetTypeId()
                 ("The minimum inter-arrival time that is considered a flow interruption."),
                 TimeValue(Seconds(0.5)),
                 MakeTimeAccessor(&FlowMonitor::m_flowInterruptionsMinTime),
-                MakeTimeChecker());
+                MakeTimeChecker())
+            .AddAttribute("FlowIdleTimeout",
+                          ("When streaming LB performance metrics, the time after which "
+                           "a flow with no packet in flight and no packet sent or received "
+                           "is finished."),
+                          TimeValue(Seconds(2)),
+                          MakeTimeAccessor(&FlowMonitor::m_flowIdleTimeout),
+                          MakeTimeChecker())
+            .AddAttribute("Fidelity",
+                          ("How much each packet is followed: every packet from hop to hop, "
+                           "one packet in SamplingInterval, or no packet beyond its first "
+                           "transmission and its last reception."),
+                          EnumValue(FlowMonitor::FULL),
+                          MakeEnumAccessor(&FlowMonitor::m_fidelity),
+                          MakeEnumChecker(FlowMonitor::FULL,
+                                          "Full",
+                                          FlowMonitor::SAMPLED,
+                                          "Sampled",
+                                          FlowMonitor::ENDPOINTS,
+                                          "Endpoints"))
+            .AddAttribute("SamplingInterval",
+                          ("With the Sampled fidelity, one packet of each flow in this "
+                           "many is tracked."),
+                          UintegerValue(16),
+                          MakeUintegerAccessor(&FlowMonitor::m_samplingInterval),
+                          MakeUintegerChecker<uint32_t>(1));
     return tid;
 }
 
@@ -94,7 +211,9 @@ FlowMonitor::GetInstanceTypeId() const
 }
 
 FlowMonitor::FlowMonitor()
-    : m_enabled(false)
+    : m_enabled(false),
+      m_streaming(false),
+      m_lbStreamTimeUnit(Time::NS)
 {
     NS_LOG_FUNCTION(this);
 }
@@ -105,6 +224,12 @@ FlowMonitor::DoDispose()
     NS_LOG_FUNCTION(this);
     Simulator::Cancel(m_startEvent);
     Simulator::Cancel(m_stopEvent);
+    if (m_streaming)
+    {
+        FinishAllFlows();
+        m_lbStream.close();
+        m_streaming = false;
+    }
     for (std::list<Ptr<FlowClassifier>>::iterator iter = m_classifiers.begin();
          iter != m_classifiers.end();
          iter++)
@@ -116,6 +241,7 @@ FlowMonitor::DoDispose()
         m_flowProbes[i]->Dispose();
         m_flowProbes[i] = nullptr;
     }
+    m_trackedPackets.Clear();
     Object::DoDispose();
 }
 
@@ -129,6 +255,7 @@ FlowMonitor::GetStatsForFlow(FlowId flowId)
     {
         FlowMonitor::FlowStats& ref = m_flowStats[flowId];
         ref.delaySum = Seconds(0);
+        ref.delayCount = 0;
         ref.jitterSum = Seconds(0);
         ref.lastDelay = Seconds(0);
         ref.txBytes = 0;
@@ -161,15 +288,20 @@ FlowMonitor::ReportFirstTx(Ptr<FlowProbe> probe,
         NS_LOG_DEBUG("FlowMonitor not enabled; returning");
         return;
     }
+    if (IsFinished(flowId))
+    {
+        NS_LOG_DEBUG("Flow " << flowId << " finished; returning");
+        return;
+    }
     Time now = Simulator::Now();
-    TrackedPacket& tracked = m_trackedPackets[std::make_pair(flowId, packetId)];
-    tracked.firstSeenTime = now;
-    tracked.lastSeenTime = tracked.firstSeenTime;
-    tracked.timesForwarded = 0;
-    NS_LOG_DEBUG("ReportFirstTx: adding tracked packet (flowId=" << flowId << ", packetId="
-                                                                 << packetId << ").");
+    if (IsTracked(packetId))
+    {
+        m_trackedPackets.Insert(flowId, packetId, now);
+        NS_LOG_DEBUG("ReportFirstTx: adding tracked packet (flowId=" << flowId << ", packetId="
+                                                                     << packetId << ").");
 
-    probe->AddPacketStats(flowId, packetSize, Seconds(0));
+        probe->AddPacketStats(flowId, packetSize, Seconds(0));
+    }
 
     FlowStats& stats = GetStatsForFlow(flowId);
     stats.txBytes += packetSize;
@@ -193,19 +325,23 @@ FlowMonitor::ReportForwarding(Ptr<FlowProbe> probe,
         NS_LOG_DEBUG("FlowMonitor not enabled; returning");
         return;
     }
-    std::pair<FlowId, FlowPacketId> key(flowId, packetId);
-    TrackedPacketMap::iterator tracked = m_trackedPackets.find(key);
-    if (tracked == m_trackedPackets.end())
+    if (IsFinished(flowId))
+    {
+        NS_LOG_DEBUG("Flow " << flowId << " finished; returning");
+        return;
+    }
+    TrackedPacketTable::TrackedPacket* tracked =
+        m_trackedPackets.Touch(flowId, packetId, Simulator::Now());
+    if (tracked == nullptr)
     {
         NS_LOG_WARN("Received packet forward report (flowId="
                     << flowId << ", packetId=" << packetId << ") but not known to be transmitted.");
         return;
     }
 
-    tracked->second.timesForwarded++;
-    tracked->second.lastSeenTime = Simulator::Now();
+    tracked->timesForwarded++;
 
-    Time delay = (Simulator::Now() - tracked->second.firstSeenTime);
+    Time delay = (Simulator::Now() - tracked->firstSeenTime);
     probe->AddPacketStats(flowId, packetSize, delay);
 }
 
@@ -221,8 +357,14 @@ FlowMonitor::ReportLastRx(Ptr<FlowProbe> probe,
         NS_LOG_DEBUG("FlowMonitor not enabled; returning");
         return;
     }
-    TrackedPacketMap::iterator tracked = m_trackedPackets.find(std::make_pair(flowId, packetId));
-    if (tracked == m_trackedPackets.end())
+    if (IsFinished(flowId))
+    {
+        NS_LOG_DEBUG("Flow " << flowId << " finished; returning");
+        m_trackedPackets.Erase(flowId, packetId);
+        return;
+    }
+    TrackedPacketTable::TrackedPacket* tracked = m_trackedPackets.Find(flowId, packetId);
+    if (tracked == nullptr)
     {
         NS_LOG_WARN("Received packet last-tx report (flowId="
                     << flowId << ", packetId=" << packetId << ") but not known to be transmitted.");
@@ -230,13 +372,13 @@ FlowMonitor::ReportLastRx(Ptr<FlowProbe> probe,
     }
 
     Time now = Simulator::Now();
-    Time delay = (now - tracked->second.firstSeenTime);
+    Time delay = (now - tracked->firstSeenTime);
     probe->AddPacketStats(flowId, packetSize, delay);
 
     FlowStats& stats = GetStatsForFlow(flowId);
     stats.delaySum += delay;
     stats.delayHistogram.AddValue(delay.GetSeconds());
-    if (stats.rxPackets > 0)
+    if (stats.delayCount > 0)
     {
         Time jitter = stats.lastDelay - delay;
         if (jitter > Seconds(0))
@@ -251,7 +393,38 @@ FlowMonitor::ReportLastRx(Ptr<FlowProbe> probe,
         }
     }
     stats.lastDelay = delay;
+    stats.delayCount++;
+
+    RecordLastRx(stats, packetSize);
+    stats.timesForwarded += tracked->timesForwarded;
 
+    NS_LOG_DEBUG("ReportLastTx: removing tracked packet (flowId=" << flowId << ", packetId="
+                                                                  << packetId << ").");
+
+    m_trackedPackets.Erase(flowId, packetId); // we don't need to track this packet anymore
+}
+
+void
+FlowMonitor::ReportUntrackedLastRx(Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packetSize)
+{
+    NS_LOG_FUNCTION(this << probe << flowId << packetSize);
+    if (!m_enabled)
+    {
+        NS_LOG_DEBUG("FlowMonitor not enabled; returning");
+        return;
+    }
+    if (IsFinished(flowId))
+    {
+        NS_LOG_DEBUG("Flow " << flowId << " finished; returning");
+        return;
+    }
+    RecordLastRx(GetStatsForFlow(flowId), packetSize);
+}
+
+void
+FlowMonitor::RecordLastRx(FlowStats& stats, uint32_t packetSize)
+{
+    Time now = Simulator::Now();
     stats.rxBytes += packetSize;
     stats.packetSizeHistogram.AddValue((double)packetSize);
     stats.rxPackets++;
@@ -269,12 +442,6 @@ FlowMonitor::ReportLastRx(Ptr<FlowProbe> probe,
         }
     }
     stats.timeLastRxPacket = now;
-    stats.timesForwarded += tracked->second.timesForwarded;
-
-    NS_LOG_DEBUG("ReportLastTx: removing tracked packet (flowId=" << flowId << ", packetId="
-                                                                  << packetId << ").");
-
-    m_trackedPackets.erase(tracked); // we don't need to track this packet anymore
 }
 
 void
@@ -290,6 +457,12 @@ FlowMonitor::ReportDrop(Ptr<FlowProbe> probe,
         NS_LOG_DEBUG("FlowMonitor not enabled; returning");
         return;
     }
+    if (IsFinished(flowId))
+    {
+        NS_LOG_DEBUG("Flow " << flowId << " finished; returning");
+        m_trackedPackets.Erase(flowId, packetId);
+        return;
+    }
 
     probe->AddPacketDropStats(flowId, packetSize, reasonCode);
 
@@ -305,14 +478,12 @@ FlowMonitor::ReportDrop(Ptr<FlowProbe> probe,
     NS_LOG_DEBUG("++stats.packetsDropped["
                  << reasonCode << "]; // becomes: " << stats.packetsDropped[reasonCode]);
 
-    TrackedPacketMap::iterator tracked = m_trackedPackets.find(std::make_pair(flowId, packetId));
-    if (tracked != m_trackedPackets.end())
+    // we don't need to track this packet anymore
+    // FIXME: this will not necessarily be true with broadcast/multicast
+    if (m_trackedPackets.Erase(flowId, packetId))
     {
-        // we don't need to track this packet anymore
-        // FIXME: this will not necessarily be true with broadcast/multicast
-        NS_LOG_DEBUG("ReportDrop: removing tracked packet (flowId=" << flowId << ", packetId="
-                                                                    << packetId << ").");
-        m_trackedPackets.erase(tracked);
+        NS_LOG_DEBUG("ReportDrop: removed tracked packet (flowId=" << flowId << ", packetId="
+                                                                   << packetId << ").");
     }
 }
 
@@ -322,28 +493,60 @@ FlowMonitor::GetFlowStats() const
     return m_flowStats;
 }
 
+bool
+FlowMonitor::IsTracked(FlowPacketId packetId) const
+{
+    switch (m_fidelity)
+    {
+    case FULL:
+        return true;
+    case SAMPLED:
+        return packetId % m_samplingInterval == 0;
+    default:
+        return false;
+    }
+}
+
+FlowMonitor::Fidelity
+FlowMonitor::GetFidelity() const
+{
+    return m_fidelity;
+}
+
+uint32_t
+FlowMonitor::GetSamplingInterval() const
+{
+    switch (m_fidelity)
+    {
+    case FULL:
+        return 1;
+    case SAMPLED:
+        return m_samplingInterval;
+    default:
+        return 0;
+    }
+}
+
 void
 FlowMonitor::CheckForLostPackets(Time maxDelay)
 {
     NS_LOG_FUNCTION(this << maxDelay.As(Time::S));
     Time now = Simulator::Now();
 
-    for (TrackedPacketMap::iterator iter = m_trackedPackets.begin();
-         iter != m_trackedPackets.end();)
+    // the packets not seen for maxDelay are considered lost, and we won't
+    // track them anymore; only the generations old enough are visited
+    std::vector<FlowId> lostFlows;
+    m_trackedPackets.ExpireLostPackets(now - maxDelay, lostFlows);
+    for (std::vector<FlowId>::const_iterator iter = lostFlows.begin(); iter != lostFlows.end();
+         iter++)
     {
-        if (now - iter->second.lastSeenTime >= maxDelay)
+        // add the packet to the loss statistics, unless its flow was
+        // finished meanwhile
+        FlowStatsContainerI flow = m_flowStats.find(*iter);
+        NS_ASSERT(flow != m_flowStats.end() || IsFinished(*iter));
+        if (flow != m_flowStats.end())
         {
-            // packet is considered lost, add it to the loss statistics
-            FlowStatsContainerI flow = m_flowStats.find(iter->first.first);
-            NS_ASSERT(flow != m_flowStats.end());
             flow->second.lostPackets++;
-
-            // we won't track it anymore
-            m_trackedPackets.erase(iter++);
-        }
-        else
-        {
-            iter++;
         }
     }
 }
@@ -358,13 +561,53 @@ void
 FlowMonitor::PeriodicCheckForLostPackets()
 {
     CheckForLostPackets();
+    if (m_streaming)
+    {
+        FinishIdleFlows();
+        m_lbStream.flush();
+    }
     Simulator::Schedule(PERIODIC_CHECK_INTERVAL, &FlowMonitor::PeriodicCheckForLostPackets, this);
 }
 
+void
+FlowMonitor::FinishIdleFlows()
+{
+    NS_LOG_FUNCTION(this);
+    Time now = Simulator::Now();
+    std::vector<FlowId> idleFlows;
+    for (FlowStatsContainerCI flowI = m_flowStats.begin(); flowI != m_flowStats.end(); flowI++)
+    {
+        const FlowStats& stats = flowI->second;
+        Time lastSeen = std::max(stats.timeLastTxPacket, stats.timeLastRxPacket);
+        // losses are only known for tracked packets, so below full
+        // fidelity a flow is finished by its idle time alone
+        if (now - lastSeen >= m_flowIdleTimeout &&
+            (m_fidelity != FULL || stats.rxPackets + stats.lostPackets >= stats.txPackets))
+        {
+            idleFlows.push_back(flowI->first);
+        }
+    }
+    for (std::vector<FlowId>::const_iterator iter = idleFlows.begin(); iter != idleFlows.end();
+         iter++)
+    {
+        NS_LOG_DEBUG("Flow " << *iter << " idle; finishing it");
+        FinishFlow(*iter);
+    }
+}
+
+bool
+FlowMonitor::IsFinished(FlowId flowId) const
+{
+    return flowId < m_finishedFlows.size() && m_finishedFlows[flowId];
+}
+
 void
 FlowMonitor::NotifyConstructionCompleted()
 {
     Object::NotifyConstructionCompleted();
+    // a sweep for lost packets visits at most 1/16 of MaxPerHopDelay worth
+    // of packets that are not lost yet
+    m_trackedPackets.Configure(std::max(m_maxPerHopDelay / 16, MicroSeconds(1)));
     Simulator::Schedule(PERIODIC_CHECK_INTERVAL, &FlowMonitor::PeriodicCheckForLostPackets, this);
 }
 
@@ -443,7 +686,8 @@ FlowMonitor::SerializeToXmlStream(std::ostream& os,
     NS_LOG_FUNCTION(this << indent << enableHistograms << enableProbes);
     CheckForLostPackets();
 
-    os << std::string(indent, ' ') << "<FlowMonitor>\n";
+    os << std::string(indent, ' ') << "<FlowMonitor fidelity=\"" << GetFidelityName(m_fidelity)
+       << "\" samplingInterval=\"" << GetSamplingInterval() << "\">\n";
     indent += 2;
     os << std::string(indent, ' ') << "<FlowStats>\n";
     indent += 2;
@@ -455,7 +699,7 @@ FlowMonitor::SerializeToXmlStream(std::ostream& os,
         os << "<Flow flowId=\"" << flowI->first
            << "\"" ATTRIB_TIME(timeFirstTxPacket) ATTRIB_TIME(timeFirstRxPacket)
                   ATTRIB_TIME(timeLastTxPacket) ATTRIB_TIME(timeLastRxPacket) ATTRIB_TIME(delaySum)
-                      ATTRIB_TIME(jitterSum) ATTRIB_TIME(lastDelay) ATTRIB(txBytes) ATTRIB(rxBytes)
+                      ATTRIB(delayCount) ATTRIB_TIME(jitterSum) ATTRIB_TIME(lastDelay) ATTRIB(txBytes) ATTRIB(rxBytes)
                           ATTRIB(txPackets) ATTRIB(rxPackets) ATTRIB(lostPackets)
                               ATTRIB(timesForwarded)
            << ">\n";
@@ -567,45 +811,30 @@ void FlowMonitor::LbPerformanceMetricsToStream(std::ostream& os,
                                                Time::Unit timeUnit) {
   NS_LOG_FUNCTION(this << timeUnit);
   CheckForLostPackets();
+  if (m_streaming) {
+    NS_LOG_WARN("Streaming LB performance metrics; only the flows not "
+                "finished yet are written");
+  }
 
-  std::map<FlowId, Ipv4FlowClassifier::FiveTuple> fiveTuples;
+  Ptr<Ipv4FlowClassifier> classifier;
   for (auto itr = m_classifiers.begin(); itr != m_classifiers.end(); itr++) {
     if (DynamicCast<Ipv4FlowClassifier>(*itr)) {
-      fiveTuples = DynamicCast<Ipv4FlowClassifier>(*itr)->GetFiveTuples();
+      classifier = DynamicCast<Ipv4FlowClassifier>(*itr);
     }
   }
 
   // Add header for the csv file.
-  os << "FlowId,SourceAddress,DestinationAddress,TimeFirstTxPacket,"
-     << "TimeLastTxPacket,TimeFirstRxPacket,TimeLastRxPacket,DelaySum,"
-     << "JitterSum,TxBytes,RxBytes,TxPackets,RxPackets,Duration,EffectiveRate";
+  os << LB_METRICS_CSV_HEADER;
 
-  std::map<FlowId, Ipv4FlowClassifier::FiveTuple>::iterator tuplesItr;
   for (FlowStatsContainerCI flowI = m_flowStats.begin();
        flowI != m_flowStats.end();
        flowI++) {
+    Ipv4FlowClassifier::FiveTuple tuple;
+    bool found = classifier && classifier->LookupFlow(flowI->first, &tuple);
     os << '\n';
-    Ipv4LbFlowStats ipv4LbFlowStats;
-
-    ipv4LbFlowStats.delaySum = flowI->second.delaySum;
-    ipv4LbFlowStats.jitterSum = flowI->second.jitterSum;
-    ipv4LbFlowStats.timeFirstTxPacket = flowI->second.timeFirstTxPacket;
-    ipv4LbFlowStats.timeLastTxPacket = flowI->second.timeLastTxPacket;
-    ipv4LbFlowStats.timeFirstRxPacket = flowI->second.timeFirstRxPacket;
-    ipv4LbFlowStats.timeLastRxPacket = flowI->second.timeLastRxPacket;
-    ipv4LbFlowStats.txBytes = flowI->second.txBytes;
-    ipv4LbFlowStats.rxBytes = flowI->second.rxBytes;
-    ipv4LbFlowStats.txPackets = flowI->second.txPackets;
-    ipv4LbFlowStats.rxPackets = flowI->second.rxPackets;
-
-    tuplesItr = fiveTuples.find(flowI->first);
-    if (tuplesItr != fiveTuples.end()) {
-      ipv4LbFlowStats.sourceAddress = tuplesItr->second.sourceAddress;
-      ipv4LbFlowStats.destinationAddress = tuplesItr->second.destinationAddress;
-    }
-
-    SerializeIpv4LbFlowStatsToCsvStream(
-      os, flowI->first, ipv4LbFlowStats, timeUnit);
+    WriteLbFlowStats(os, flowI->first, flowI->second,
+                     found ? &tuple : nullptr,
+                     GetSamplingInterval(), timeUnit);
   }
 }
 
@@ -623,4 +852,114 @@ void FlowMonitor::LbPerformanceMetricsToFile(std::string fileName, Time::Unit ti
   os.close();
 }
 
+void FlowMonitor::LbPerformanceMetricsToBinaryStream(std::ostream& os) {
+  NS_LOG_FUNCTION(this);
+  CheckForLostPackets();
+  if (m_streaming) {
+    NS_LOG_WARN("Streaming LB performance metrics; only the flows not "
+                "finished yet are written");
+  }
+
+  Ptr<Ipv4FlowClassifier> classifier;
+  for (auto itr = m_classifiers.begin(); itr != m_classifiers.end(); itr++) {
+    if (DynamicCast<Ipv4FlowClassifier>(*itr)) {
+      classifier = DynamicCast<Ipv4FlowClassifier>(*itr);
+    }
+  }
+
+  std::vector<FlowId> flowIds;
+  std::vector<Ipv4LbFlowStats> ipv4LbFlowStats;
+  flowIds.reserve(m_flowStats.size());
+  ipv4LbFlowStats.reserve(m_flowStats.size());
+  for (FlowStatsContainerCI flowI = m_flowStats.begin();
+       flowI != m_flowStats.end();
+       flowI++) {
+    Ipv4FlowClassifier::FiveTuple tuple;
+    bool found = classifier && classifier->LookupFlow(flowI->first, &tuple);
+    flowIds.push_back(flowI->first);
+    ipv4LbFlowStats.push_back(GetIpv4LbFlowStats(
+      flowI->second, found ? &tuple : nullptr, GetSamplingInterval()));
+  }
+  SerializeIpv4LbFlowStatsToBinaryStream(os, flowIds, ipv4LbFlowStats);
+}
+
+void FlowMonitor::LbPerformanceMetricsToBinaryFile(std::string fileName) {
+  NS_LOG_FUNCTION(this << fileName);
+  std::ofstream os(fileName, std::ios::out | std::ios::binary);
+  LbPerformanceMetricsToBinaryStream(os);
+  os.close();
+}
+
+void FlowMonitor::StreamLbPerformanceMetricsToFile(std::string fileName,
+                                                   Time::Unit timeUnit) {
+  NS_LOG_FUNCTION(this << fileName << timeUnit);
+  if (m_streaming) {
+    // The flows finished so far stay in the previous file.
+    m_lbStream.close();
+  }
+  m_lbStreamBuffer.resize(LB_STREAM_BUFFER_SIZE);
+  m_lbStream.rdbuf()->pubsetbuf(m_lbStreamBuffer.data(),
+                                m_lbStreamBuffer.size());
+  m_lbStream.open(fileName, std::ios::out | std::ios::binary);
+  if (!m_lbStream.is_open()) {
+    NS_FATAL_ERROR("Could not open " << fileName);
+  }
+  m_lbStreamTimeUnit = timeUnit;
+  m_streaming = true;
+
+  // Add header for the csv file. Each row follows the header, so that the
+  // file is valid csv at every flush.
+  m_lbStream << LB_METRICS_CSV_HEADER;
+}
+
+void FlowMonitor::StreamLbPerformanceMetrics(FlowId flowId,
+                                             const FlowStats& stats) {
+  Ipv4FlowClassifier::FiveTuple tuple;
+  bool found = false;
+  for (auto itr = m_classifiers.begin(); itr != m_classifiers.end(); itr++) {
+    if (DynamicCast<Ipv4FlowClassifier>(*itr)) {
+      found = DynamicCast<Ipv4FlowClassifier>(*itr)->LookupFlow(flowId, &tuple);
+    }
+  }
+  m_lbStream << '\n';
+  WriteLbFlowStats(m_lbStream, flowId, stats, found ? &tuple : nullptr,
+                   GetSamplingInterval(), m_lbStreamTimeUnit);
+}
+
+void FlowMonitor::FinishFlow(FlowId flowId) {
+  NS_LOG_FUNCTION(this << flowId);
+  if (!m_streaming || IsFinished(flowId)) {
+    return;
+  }
+  if (m_finishedFlows.size() <= flowId) {
+    m_finishedFlows.resize(flowId + 1, false);
+  }
+  m_finishedFlows[flowId] = true;
+
+  FlowStatsContainerI flowI = m_flowStats.find(flowId);
+  if (flowI != m_flowStats.end()) {
+    StreamLbPerformanceMetrics(flowId, flowI->second);
+    m_flowStats.erase(flowI);
+  }
+  for (uint32_t i = 0; i < m_flowProbes.size(); i++) {
+    m_flowProbes[i]->RemoveFlowStats(flowId);
+  }
+  // The next packets of the flow start a new flow.
+  for (auto itr = m_classifiers.begin(); itr != m_classifiers.end(); itr++) {
+    (*itr)->ReleaseFlow(flowId);
+  }
+}
+
+void FlowMonitor::FinishAllFlows() {
+  NS_LOG_FUNCTION(this);
+  if (!m_streaming) {
+    return;
+  }
+  CheckForLostPackets();
+  while (!m_flowStats.empty()) {
+    FinishFlow(m_flowStats.begin()->first);
+  }
+  m_lbStream.flush();
+}
+
 } // namespace ns3
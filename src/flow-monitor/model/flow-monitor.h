@@ -27,7 +27,9 @@
 #include "ns3/nstime.h"
 #include "ns3/object.h"
 #include "ns3/ptr.h"
+#include "ns3/tracked-packet-table.h"
 
+#include <fstream>
 #include <map>
 #include <vector>
 
@@ -46,10 +48,27 @@ namespace ns3
  * The FlowMonitor class is responsible for coordinating efforts
  * regarding probes, and collects end-to-end flow statistics.
  *
+ * How much each packet is followed is set by the Fidelity attribute.  At
+ * FULL fidelity every packet is tracked from hop to hop.  At SAMPLED
+ * fidelity only one packet in SamplingInterval of each flow is tracked:
+ * packets, bytes, drops and their times stay exact, but delays, jitters,
+ * losses not reported as drops and the per-probe packet statistics only
+ * cover the tracked packets.  At ENDPOINTS fidelity no packet is tracked,
+ * and only the transmissions, receptions and drops of the packets are
+ * counted, which is enough for flow completion times.  The fidelity is
+ * written in every output.
  */
 class FlowMonitor : public Object
 {
   public:
+    /// How much each packet is followed
+    enum Fidelity
+    {
+        FULL,      //!< Track every packet
+        SAMPLED,   //!< Track one packet in SamplingInterval
+        ENDPOINTS, //!< Track no packet, only count them at their endpoints
+    };
+
     /// \brief Structure that represents the measured metrics of an individual packet flow
     struct FlowStats
     {
@@ -74,7 +93,11 @@ class FlowMonitor : public Object
 
         /// Contains the sum of all end-to-end delays for all received
         /// packets of the flow.
-        Time delaySum; // delayCount == rxPackets
+        Time delaySum;
+
+        /// Contains the number of received packets whose delay was
+        /// measured, i.e. all of them unless packets are sampled
+        uint32_t delayCount;
 
         /// Contains the sum of all end-to-end delay jitter (delay
         /// variation) values for all received packets of the flow.  Here
@@ -83,7 +106,7 @@ class FlowMonitor : public Object
         /// i.e. \f$Jitter\left\{P_N\right\} = \left|Delay\left\{P_N\right\} -
         /// Delay\left\{P_{N-1}\right\}\right|\f$. This definition is in accordance with the
         /// Type-P-One-way-ipdv as defined in IETF \RFC{3393}.
-        Time jitterSum; // jitterCount == rxPackets - 1
+        Time jitterSum; // jitterCount == delayCount - 1
 
         /// Contains the last measured delay of a packet
         /// It is stored to measure the packet's Jitter
@@ -203,6 +226,13 @@ class FlowMonitor : public Object
                       FlowPacketId packetId,
                       uint32_t packetSize);
     /// FlowProbe implementations are supposed to call this method to
+    /// report that a packet that is not tracked (see IsTracked) is being
+    /// received.
+    /// \param probe the reporting probe
+    /// \param flowId flow identification
+    /// \param packetSize packet size
+    void ReportUntrackedLastRx(Ptr<FlowProbe> probe, FlowId flowId, uint32_t packetSize);
+    /// FlowProbe implementations are supposed to call this method to
     /// report that a known packet is being dropped due to some reason.
     /// \param probe the reporting probe
     /// \param flowId flow identification
@@ -215,6 +245,21 @@ class FlowMonitor : public Object
                     uint32_t packetSize,
                     uint32_t reasonCode);
 
+    /// FlowProbe implementations are supposed to call this method to
+    /// know whether a new packet is tracked from hop to hop, and should be
+    /// reported by ReportForwarding and ReportLastRx, or only counted at
+    /// its endpoints, and reported by ReportUntrackedLastRx.
+    /// \param packetId Packet ID
+    /// \returns true if the packet is tracked
+    bool IsTracked(FlowPacketId packetId) const;
+
+    /// \returns how much each packet is followed
+    Fidelity GetFidelity() const;
+
+    /// \returns the sampling interval of the fidelity: 1 when every packet
+    /// is tracked, N when one packet in N is, and 0 when none is
+    uint32_t GetSamplingInterval() const;
+
     /// Check right now for packets that appear to be lost
     void CheckForLostPackets();
 
@@ -290,6 +335,8 @@ class FlowMonitor : public Object
                                    Time::Unit timeUnit = Time::NS);
 
     /// Writes the load balancing performance metrics to a std::ostream.
+    /// When streaming, only the flows not finished yet are written, the
+    /// finished ones being in the streamed file already.
     /// \param os the output stream.
     /// \param timeUnit the unit of time for reporting time values (default is
     ///                 nanoseconds).
@@ -309,27 +356,62 @@ class FlowMonitor : public Object
     void LbPerformanceMetricsToFile(std::string fileName,
                                     Time::Unit timeUnit = Time::NS);
 
+    /// Writes the load balancing performance metrics to a std::ostream in a
+    /// binary columnar format, with times as int64 nanoseconds, which is
+    /// faster to write and to load than the csv of
+    /// LbPerformanceMetricsToStream.  See
+    /// SerializeIpv4LbFlowStatsToBinaryStream for the format.  The format
+    /// starts with the number of flows and stores each column contiguously,
+    /// so it cannot be streamed; when streaming, only the flows not finished
+    /// yet are written, as by LbPerformanceMetricsToStream.
+    /// \param os the output stream.
+    void LbPerformanceMetricsToBinaryStream(std::ostream& os);
+
+    /// Same as LbPerformanceMetricsToBinaryStream but writes to a file
+    /// instead.
+    /// \param fileName name or path of the output file that will be created.
+    void LbPerformanceMetricsToBinaryFile(std::string fileName);
+
+    /// Starts writing the load balancing performance metrics of each flow
+    /// to a file, in the format of LbPerformanceMetricsToStream, as soon as
+    /// the flow finishes, and then forgets the flow, so that memory does not
+    /// grow with the number of flows of the run.  A flow finishes when
+    /// FinishFlow is called for it, when nothing was sent or received for it
+    /// for FlowIdleTimeout and it has no packet in flight, or at the latest
+    /// when the FlowMonitor is disposed.  The packets of a finished flow
+    /// still in flight are ignored, and the classifiers forget the flow, so
+    /// that the next packets of its five-tuple start a new flow, with a new
+    /// FlowId.  The file is written through a buffer, flushed every second
+    /// of simulated time.  It is always csv: the binary format of
+    /// LbPerformanceMetricsToBinaryStream cannot be written row by row.
+    /// \param fileName name or path of the output file that will be created.
+    /// \param timeUnit the unit of time for reporting time values (default is
+    ///                 nanoseconds).
+    void StreamLbPerformanceMetricsToFile(std::string fileName,
+                                          Time::Unit timeUnit = Time::NS);
+
+    /// Finishes a flow, for instance once its last expected byte has been
+    /// received.  When streaming, the flow is written out and forgotten,
+    /// by the FlowMonitor and by its classifiers.
+    /// \param flowId the flow identification.
+    void FinishFlow(FlowId flowId);
+
+    /// Finishes every flow not finished yet, and flushes the streamed
+    /// output.
+    void FinishAllFlows();
+
   protected:
     void NotifyConstructionCompleted() override;
     void DoDispose() override;
 
   private:
-    /// Structure to represent a single tracked packet data
-    struct TrackedPacket
-    {
-        Time firstSeenTime;      //!< absolute time when the packet was first seen by a probe
-        Time lastSeenTime;       //!< absolute time when the packet was last seen by a probe
-        uint32_t timesForwarded; //!< number of times the packet was reportedly forwarded
-    };
-
     /// FlowId --> FlowStats
     FlowStatsContainer m_flowStats;
 
     /// (FlowId,PacketId) --> TrackedPacket
-    typedef std::map<std::pair<FlowId, FlowPacketId>, TrackedPacket> TrackedPacketMap;
-    TrackedPacketMap m_trackedPackets; //!< Tracked packets
-    Time m_maxPerHopDelay;             //!< Minimum per-hop delay
-    FlowProbeContainer m_flowProbes;   //!< all the FlowProbes
+    TrackedPacketTable m_trackedPackets; //!< Tracked packets
+    Time m_maxPerHopDelay;               //!< Minimum per-hop delay
+    FlowProbeContainer m_flowProbes;     //!< all the FlowProbes
 
     // note: this is needed only for serialization
     std::list<Ptr<FlowClassifier>> m_classifiers; //!< the FlowClassifiers
@@ -342,14 +424,41 @@ class FlowMonitor : public Object
     double m_packetSizeBinWidth;        //!< packet size bin width (for histograms)
     double m_flowInterruptionsBinWidth; //!< Flow interruptions bin width (for histograms)
     Time m_flowInterruptionsMinTime;    //!< Flow interruptions minimum time
+    Fidelity m_fidelity;                //!< How much each packet is followed
+    uint32_t m_samplingInterval;        //!< One packet in this is tracked when SAMPLED
+
+    Time m_flowIdleTimeout;             //!< Time after which a quiet flow is finished
+    std::vector<bool> m_finishedFlows;  //!< Whether each FlowId was finished
+    bool m_streaming;                   //!< LB performance metrics are streamed
+    std::ofstream m_lbStream;           //!< Streamed LB performance metrics
+    std::vector<char> m_lbStreamBuffer; //!< Buffer of m_lbStream
+    Time::Unit m_lbStreamTimeUnit;      //!< Unit of the times of m_lbStream
 
     /// Get the stats for a given flow
     /// \param flowId the Flow identification
     /// \returns the stats of the flow
     FlowStats& GetStatsForFlow(FlowId flowId);
 
+    /// Records the reception of a packet, tracked or not
+    /// \param stats the stats of the flow of the packet
+    /// \param packetSize packet size
+    void RecordLastRx(FlowStats& stats, uint32_t packetSize);
+
     /// Periodic function to check for lost packets and prune statistics
     void PeriodicCheckForLostPackets();
+
+    /// Finishes the flows idle for FlowIdleTimeout with no packet in flight
+    void FinishIdleFlows();
+
+    /// \param flowId the flow identification
+    /// \returns true if the flow was finished
+    bool IsFinished(FlowId flowId) const;
+
+    /// \brief Writes the load balancing performance metrics of a flow to
+    /// the streamed output
+    /// \param flowId the flow identification
+    /// \param stats the statistics of the flow
+    void StreamLbPerformanceMetrics(FlowId flowId, const FlowStats& stats);
 };
 
 } // namespace ns3
@@ -91,6 +91,9 @@ class FlowProbe : public Object
     /// \param packetSize the packet size
     /// \param reasonCode reason code for the drop
     void AddPacketDropStats(FlowId flowId, uint32_t packetSize, uint32_t reasonCode);
+    /// Forget the flow stats of a flow
+    /// \param flowId the flow Identifier
+    void RemoveFlowStats(FlowId flowId);
 
     /// Get the partial flow statistics stored in this probe.  With this
     /// information you can, for example, find out what is the delay
@@ -19,6 +19,7 @@
 
 #include "ipv4-flow-classifier.h"
 
+#include "ns3/abort.h"
 #include "ns3/packet.h"
 #include "ns3/tcp-header.h"
 #include "ns3/udp-header.h"
@@ -91,8 +92,30 @@ operator==(const Ipv4FlowClassifier::FiveTuple& t1, const Ipv4FlowClassifier::Fi
             t1.sourcePort == t2.sourcePort && t1.destinationPort == t2.destinationPort);
 }
 
+std::size_t
+Ipv4FlowClassifier::PackedFiveTupleHash::operator()(const PackedFiveTuple& tuple) const
+{
+    // mix both words, so that flows differing only in a port spread
+    uint64_t hash = (tuple.addresses ^ (tuple.protocolAndPorts * 0x9E3779B97F4A7C15ULL)) *
+                    0xBF58476D1CE4E5B9ULL;
+    return static_cast<std::size_t>(hash ^ (hash >> 31));
+}
+
 Ipv4FlowClassifier::Ipv4FlowClassifier()
+    : m_firstFlowId(1)
+{
+}
+
+Ipv4FlowClassifier::PackedFiveTuple
+Ipv4FlowClassifier::Pack(const FiveTuple& tuple)
 {
+    PackedFiveTuple packed;
+    packed.addresses =
+        (static_cast<uint64_t>(tuple.sourceAddress.Get()) << 32) | tuple.destinationAddress.Get();
+    packed.protocolAndPorts = (static_cast<uint64_t>(tuple.protocol) << 32) |
+                              (static_cast<uint64_t>(tuple.sourcePort) << 16) |
+                              tuple.destinationPort;
+    return packed;
 }
 
 bool
@@ -145,36 +168,51 @@ Ipv4FlowClassifier::Classify(const Ipv4Header& ipHeader,
     tuple.destinationPort = dstPort;
 
     // try to insert the tuple, but check if it already exists
-    std::pair<std::map<FiveTuple, FlowId>::iterator, bool> insert =
-        m_flowMap.insert(std::pair<FiveTuple, FlowId>(tuple, 0));
+    std::pair<std::unordered_map<PackedFiveTuple, FlowId, PackedFiveTupleHash>::iterator, bool>
+        insert = m_flowMap.insert(std::make_pair(Pack(tuple), 0));
 
     // if the insertion succeeded, we need to assign this tuple a new flow identifier
     if (insert.second)
     {
+        // flow identifiers only grow; should one be skipped, its slot in the
+        // deque is left as a released placeholder
         FlowId newFlowId = GetNewFlowId();
+        NS_ABORT_MSG_IF(newFlowId < m_firstFlowId + m_flows.size(),
+                        "Flow identifier " << newFlowId << " assigned twice");
+        if (m_flows.empty())
+        {
+            m_firstFlowId = newFlowId;
+        }
+        m_flows.resize(newFlowId - m_firstFlowId, FlowState{FiveTuple(), 0, true, DscpCounts()});
         insert.first->second = newFlowId;
-        m_flowPktIdMap[newFlowId] = 0;
-        m_flowDscpMap[newFlowId];
+        m_flows.push_back(FlowState{tuple, 0, false, DscpCounts()});
     }
-    else
+    FlowState& flow = m_flows[insert.first->second - m_firstFlowId];
+    if (!insert.second)
     {
-        m_flowPktIdMap[insert.first->second]++;
+        flow.lastPacketId++;
     }
 
-    // increment the counter of packets with the same DSCP value
+    // increment the counter of packets with the same DSCP value; flows
+    // rarely carry more than one or two, so they are kept in a sorted vector
     Ipv4Header::DscpType dscp = ipHeader.GetDscp();
-    std::pair<std::map<Ipv4Header::DscpType, uint32_t>::iterator, bool> dscpInserter =
-        m_flowDscpMap[insert.first->second].insert(
-            std::pair<Ipv4Header::DscpType, uint32_t>(dscp, 1));
-
-    // if the insertion did not succeed, we need to increment the counter
-    if (!dscpInserter.second)
+    DscpCounts& dscpCounts = flow.dscpCounts;
+    DscpCounts::iterator dscpCount = dscpCounts.begin();
+    while (dscpCount != dscpCounts.end() && dscpCount->first < dscp)
+    {
+        dscpCount++;
+    }
+    if (dscpCount != dscpCounts.end() && dscpCount->first == dscp)
+    {
+        dscpCount->second++;
+    }
+    else
     {
-        m_flowDscpMap[insert.first->second][dscp]++;
+        dscpCounts.insert(dscpCount, std::make_pair(dscp, 1));
     }
 
     *out_flowId = insert.first->second;
-    *out_packetId = m_flowPktIdMap[*out_flowId];
+    *out_packetId = flow.lastPacketId;
 
     return true;
 }
@@ -182,25 +220,52 @@ Ipv4FlowClassifier::Classify(const Ipv4Header& ipHeader,
 Ipv4FlowClassifier::FiveTuple
 Ipv4FlowClassifier::FindFlow(FlowId flowId) const
 {
-    for (std::map<FiveTuple, FlowId>::const_iterator iter = m_flowMap.begin();
-         iter != m_flowMap.end();
-         iter++)
+    FiveTuple retval = {Ipv4Address::GetZero(), Ipv4Address::GetZero(), 0, 0, 0};
+    if (!LookupFlow(flowId, &retval))
     {
-        if (iter->second == flowId)
-        {
-            return iter->first;
-        }
+        NS_FATAL_ERROR("Could not find the flow with ID " << flowId);
     }
-    NS_FATAL_ERROR("Could not find the flow with ID " << flowId);
-    FiveTuple retval = {Ipv4Address::GetZero(), Ipv4Address::GetZero(), 0, 0, 0};
     return retval;
 }
 
+bool
+Ipv4FlowClassifier::IsKnownFlow(FlowId flowId) const
+{
+    return flowId >= m_firstFlowId && flowId - m_firstFlowId < m_flows.size() &&
+           !m_flows[flowId - m_firstFlowId].released;
+}
+
+bool
+Ipv4FlowClassifier::LookupFlow(FlowId flowId, FiveTuple* tuple) const
+{
+    if (!IsKnownFlow(flowId))
+    {
+        return false;
+    }
+    *tuple = m_flows[flowId - m_firstFlowId].tuple;
+    return true;
+}
+
+bool
+Ipv4FlowClassifier::LookupFlowId(const FiveTuple& tuple, FlowId* flowId) const
+{
+    std::unordered_map<PackedFiveTuple, FlowId, PackedFiveTupleHash>::const_iterator iter =
+        m_flowMap.find(Pack(tuple));
+    if (iter == m_flowMap.end())
+    {
+        return false;
+    }
+    *flowId = iter->second;
+    return true;
+}
+
 std::map<FlowId, Ipv4FlowClassifier::FiveTuple>
 Ipv4FlowClassifier::GetFiveTuples() const {
   std::map<FlowId, FiveTuple> result;
-  for (auto itr = m_flowMap.begin(); itr != m_flowMap.end(); itr++) {
-    result[itr->second] = itr->first;
+  for (uint32_t i = 0; i < m_flows.size(); i++) {
+    if (!m_flows[i].released) {
+      result.insert(result.end(), std::make_pair(m_firstFlowId + i, m_flows[i].tuple));
+    }
   }
   return result;
 }
@@ -215,16 +280,13 @@ Ipv4FlowClassifier::SortByCount::operator()(std::pair<Ipv4Header::DscpType, uint
 std::vector<std::pair<Ipv4Header::DscpType, uint32_t>>
 Ipv4FlowClassifier::GetDscpCounts(FlowId flowId) const
 {
-    std::map<FlowId, std::map<Ipv4Header::DscpType, uint32_t>>::const_iterator flow =
-        m_flowDscpMap.find(flowId);
-
-    if (flow == m_flowDscpMap.end())
+    if (!IsKnownFlow(flowId))
     {
         NS_FATAL_ERROR("Could not find the flow with ID " << flowId);
     }
 
-    std::vector<std::pair<Ipv4Header::DscpType, uint32_t>> v(flow->second.begin(),
-                                                             flow->second.end());
+    std::vector<std::pair<Ipv4Header::DscpType, uint32_t>> v(
+        m_flows[flowId - m_firstFlowId].dscpCounts);
     std::sort(v.begin(), v.end(), SortByCount());
     return v;
 }
@@ -235,33 +297,40 @@ Ipv4FlowClassifier::SerializeToXmlStream(std::ostream& os, uint16_t indent) cons
     Indent(os, indent);
     os << "<Ipv4FlowClassifier>\n";
 
+    // list the flows not released in the order of their tuples
+    std::vector<FlowId> flowIds;
+    flowIds.reserve(m_flows.size());
+    for (uint32_t i = 0; i < m_flows.size(); i++)
+    {
+        if (!m_flows[i].released)
+        {
+            flowIds.push_back(m_firstFlowId + i);
+        }
+    }
+    std::sort(flowIds.begin(), flowIds.end(), [this](FlowId left, FlowId right) {
+        return m_flows[left - m_firstFlowId].tuple < m_flows[right - m_firstFlowId].tuple;
+    });
+
     indent += 2;
-    for (std::map<FiveTuple, FlowId>::const_iterator iter = m_flowMap.begin();
-         iter != m_flowMap.end();
+    for (std::vector<FlowId>::const_iterator iter = flowIds.begin(); iter != flowIds.end();
          iter++)
     {
+        const FiveTuple& tuple = m_flows[*iter - m_firstFlowId].tuple;
         Indent(os, indent);
-        os << "<Flow flowId=\"" << iter->second << "\""
-           << " sourceAddress=\"" << iter->first.sourceAddress << "\""
-           << " destinationAddress=\"" << iter->first.destinationAddress << "\""
-           << " protocol=\"" << int(iter->first.protocol) << "\""
-           << " sourcePort=\"" << iter->first.sourcePort << "\""
-           << " destinationPort=\"" << iter->first.destinationPort << "\">\n";
+        os << "<Flow flowId=\"" << *iter << "\""
+           << " sourceAddress=\"" << tuple.sourceAddress << "\""
+           << " destinationAddress=\"" << tuple.destinationAddress << "\""
+           << " protocol=\"" << int(tuple.protocol) << "\""
+           << " sourcePort=\"" << tuple.sourcePort << "\""
+           << " destinationPort=\"" << tuple.destinationPort << "\">\n";
 
         indent += 2;
-        std::map<FlowId, std::map<Ipv4Header::DscpType, uint32_t>>::const_iterator flow =
-            m_flowDscpMap.find(iter->second);
-
-        if (flow != m_flowDscpMap.end())
+        const DscpCounts& dscpCounts = m_flows[*iter - m_firstFlowId].dscpCounts;
+        for (DscpCounts::const_iterator i = dscpCounts.begin(); i != dscpCounts.end(); i++)
         {
-            for (std::map<Ipv4Header::DscpType, uint32_t>::const_iterator i = flow->second.begin();
-                 i != flow->second.end();
-                 i++)
-            {
-                Indent(os, indent);
-                os << "<Dscp value=\"0x" << std::hex << static_cast<uint32_t>(i->first) << "\""
-                   << " packets=\"" << std::dec << i->second << "\" />\n";
-            }
+            Indent(os, indent);
+            os << "<Dscp value=\"0x" << std::hex << static_cast<uint32_t>(i->first) << "\""
+               << " packets=\"" << std::dec << i->second << "\" />\n";
         }
 
         indent -= 2;
@@ -274,4 +343,25 @@ Ipv4FlowClassifier::SerializeToXmlStream(std::ostream& os, uint16_t indent) cons
     os << "</Ipv4FlowClassifier>\n";
 }
 
+void
+Ipv4FlowClassifier::ReleaseFlow(FlowId flowId)
+{
+    if (!IsKnownFlow(flowId))
+    {
+        return;
+    }
+    FlowState& flow = m_flows[flowId - m_firstFlowId];
+    m_flowMap.erase(Pack(flow.tuple));
+    flow.released = true;
+    DscpCounts().swap(flow.dscpCounts);
+
+    // the flows released after a flow still in use stay in the deque, as
+    // placeholders, until that flow is released too
+    while (!m_flows.empty() && m_flows.front().released)
+    {
+        m_flows.pop_front();
+        m_firstFlowId++;
+    }
+}
+
 } // namespace ns3
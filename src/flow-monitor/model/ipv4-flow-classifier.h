@@ -23,8 +23,11 @@
 #include "ns3/flow-classifier.h"
 #include "ns3/ipv4-header.h"
 
+#include <deque>
 #include <map>
 #include <stdint.h>
+#include <unordered_map>
+#include <vector>
 
 namespace ns3
 {
@@ -34,7 +37,11 @@ class Packet;
 /// Classifies packets by looking at their IP and TCP/UDP headers.
 /// From these packet headers, a tuple (source-ip, destination-ip,
 /// protocol, source-port, destination-port) is created, and a unique
-/// flow identifier is assigned for each different tuple combination
+/// flow identifier is assigned for each different tuple combination.
+/// Tuples are looked up in a hash table, and flow identifiers are
+/// assigned in increasing order from 1, so that the data of each flow is
+/// kept in a deque indexed by flow identifier.  Released flows are dropped from
+/// the front of the deque.
 class Ipv4FlowClassifier : public FlowClassifier
 {
   public:
@@ -70,7 +77,19 @@ class Ipv4FlowClassifier : public FlowClassifier
     /// \returns the FiveTuple corresponding to flowId
     FiveTuple FindFlow(FlowId flowId) const;
 
-    /// A map of flow ids to FiveTuples.
+    /// Searches for the FiveTuple corresponding to the given flowId
+    /// \param flowId the FlowId to search for
+    /// \param tuple the FiveTuple corresponding to flowId, if found
+    /// \returns true if the flow was found
+    bool LookupFlow(FlowId flowId, FiveTuple* tuple) const;
+
+    /// Searches for the FlowId of the given FiveTuple
+    /// \param tuple the FiveTuple to search for
+    /// \param flowId the FlowId of tuple, if found
+    /// \returns true if the flow was found
+    bool LookupFlowId(const FiveTuple& tuple, FlowId* flowId) const;
+
+    /// A map of flow ids to FiveTuples, of the flows not released.
     std::map<FlowId, FiveTuple> GetFiveTuples() const;
 
     /// Comparator used to sort the vector of DSCP values
@@ -94,13 +113,57 @@ class Ipv4FlowClassifier : public FlowClassifier
 
     void SerializeToXmlStream(std::ostream& os, uint16_t indent) const override;
 
+    void ReleaseFlow(FlowId flowId) override;
+
   private:
+    /// The 13 bytes of a FiveTuple, packed in two words
+    struct PackedFiveTuple
+    {
+        uint64_t addresses;        //!< Source and destination addresses
+        uint64_t protocolAndPorts; //!< Protocol, source and destination ports
+
+        /// \param other the other operand
+        /// \returns true if the operands are equal
+        bool operator==(const PackedFiveTuple& other) const
+        {
+            return addresses == other.addresses && protocolAndPorts == other.protocolAndPorts;
+        }
+    };
+
+    /// Hash of a PackedFiveTuple
+    struct PackedFiveTupleHash
+    {
+        /// \param tuple the packed tuple
+        /// \returns the hash of the packed tuple
+        std::size_t operator()(const PackedFiveTuple& tuple) const;
+    };
+
+    /// (DSCP value, packet count) pairs, sorted by DSCP value
+    typedef std::vector<std::pair<Ipv4Header::DscpType, uint32_t>> DscpCounts;
+
+    /// \param tuple the FiveTuple
+    /// \returns the packed FiveTuple
+    static PackedFiveTuple Pack(const FiveTuple& tuple);
+
+    /// The data of a flow
+    struct FlowState
+    {
+        FiveTuple tuple;           //!< FiveTuple of the flow
+        FlowPacketId lastPacketId; //!< Last FlowPacketId of the flow
+        bool released;             //!< The flow was released
+        DscpCounts dscpCounts;     //!< (DSCP value, packet count) pairs of the flow
+    };
+
+    /// \param flowId the FlowId
+    /// \returns true if the flow was classified and not released
+    bool IsKnownFlow(FlowId flowId) const;
+
     /// Map to Flows Identifiers to FlowIds
-    std::map<FiveTuple, FlowId> m_flowMap;
-    /// Map to FlowIds to FlowPacketId
-    std::map<FlowId, FlowPacketId> m_flowPktIdMap;
-    /// Map FlowIds to (DSCP value, packet count) pairs
-    std::map<FlowId, std::map<Ipv4Header::DscpType, uint32_t>> m_flowDscpMap;
+    std::unordered_map<PackedFiveTuple, FlowId, PackedFiveTupleHash> m_flowMap;
+    /// Data of the flows from m_firstFlowId on, by FlowId - m_firstFlowId
+    std::deque<FlowState> m_flows;
+    /// FlowId of the first flow of m_flows
+    FlowId m_firstFlowId;
 };
 
 /**
@@ -262,7 +262,9 @@ Ipv4FlowProbe::Ipv4FlowProbe(Ptr<FlowMonitor> monitor,
     {
         NS_FATAL_ERROR("trace fail");
     }
-    if (!m_ipv4->TraceConnectWithoutContext(
+    // with only the endpoints monitored, no packet is followed from hop to hop
+    if (monitor->GetFidelity() != FlowMonitor::ENDPOINTS &&
+        !m_ipv4->TraceConnectWithoutContext(
             "UnicastForward",
             MakeCallback(&Ipv4FlowProbe::ForwardLogger, Ptr<Ipv4FlowProbe>(this))))
     {
@@ -382,6 +384,10 @@ Ipv4FlowProbe::ForwardLogger(const Ipv4Header& ipHeader,
 
         FlowId flowId = fTag.GetFlowId();
         FlowPacketId packetId = fTag.GetPacketId();
+        if (!m_flowMonitor->IsTracked(packetId))
+        {
+            return;
+        }
 
         uint32_t size = (ipPayload->GetSize() + ipHeader.GetSerializedSize());
         NS_LOG_DEBUG("ReportForwarding (" << this << ", " << flowId << ", " << packetId << ", "
@@ -410,6 +416,13 @@ Ipv4FlowProbe::ForwardUpLogger(const Ipv4Header& ipHeader,
         FlowPacketId packetId = fTag.GetPacketId();
 
         uint32_t size = (ipPayload->GetSize() + ipHeader.GetSerializedSize());
+        if (!m_flowMonitor->IsTracked(packetId))
+        {
+            NS_LOG_DEBUG("ReportUntrackedLastRx (" << this << ", " << flowId << ", " << size
+                                                   << "); " << ipHeader << *ipPayload);
+            m_flowMonitor->ReportUntrackedLastRx(this, flowId, size);
+            return;
+        }
         NS_LOG_DEBUG("ReportLastRx (" << this << ", " << flowId << ", " << packetId << ", " << size
                                       << "); " << ipHeader << *ipPayload);
         m_flowMonitor->ReportLastRx(this, flowId, packetId, size);
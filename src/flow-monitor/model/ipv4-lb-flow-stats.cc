@@ -1,17 +1,117 @@
 #include "ipv4-lb-flow-stats.h"
 
+#include "ns3/assert.h"
+
+#include <cstring>
+
 namespace ns3 {
 
+namespace {
+
+// The magic and the version of the binary format.
+const char BINARY_MAGIC[8] = {'N', 'S', '3', 'L', 'B', 'M', '\0', '\0'};
+const uint32_t BINARY_VERSION = 1;
+
+// The columns of the binary format, each with the way to get its value, as
+// the bits of a little-endian integer of `size` bytes.
+struct BinaryColumn {
+  const char* name;
+  char kind;
+  uint8_t size;
+  uint64_t (*get)(FlowId flowId, const Ipv4LbFlowStats& stats);
+};
+
+Time GetDuration(const Ipv4LbFlowStats& stats) {
+  return stats.timeLastRxPacket - stats.timeFirstTxPacket;
+}
+
+double GetEffectiveRate(const Ipv4LbFlowStats& stats) {
+  // `rxBytes * 8` gives the received bits. Then we divide by the duration in
+  // seconds to get bps.
+  return (stats.rxBytes * 8) / GetDuration(stats).GetSeconds();
+}
+
+uint64_t GetTimeBits(Time time) {
+  return static_cast<uint64_t>(time.GetNanoSeconds());
+}
+
+uint64_t GetDoubleBits(double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+const BinaryColumn BINARY_COLUMNS[] = {
+  {"FlowId", 'u', 4,
+   [](FlowId flowId, const Ipv4LbFlowStats&) -> uint64_t { return flowId; }},
+  {"SourceAddress", 'u', 4,
+   [](FlowId, const Ipv4LbFlowStats& stats) -> uint64_t {
+     return stats.sourceAddress.Get(); }},
+  {"DestinationAddress", 'u', 4,
+   [](FlowId, const Ipv4LbFlowStats& stats) -> uint64_t {
+     return stats.destinationAddress.Get(); }},
+  {"TimeFirstTxPacket", 'i', 8,
+   [](FlowId, const Ipv4LbFlowStats& stats) {
+     return GetTimeBits(stats.timeFirstTxPacket); }},
+  {"TimeLastTxPacket", 'i', 8,
+   [](FlowId, const Ipv4LbFlowStats& stats) {
+     return GetTimeBits(stats.timeLastTxPacket); }},
+  {"TimeFirstRxPacket", 'i', 8,
+   [](FlowId, const Ipv4LbFlowStats& stats) {
+     return GetTimeBits(stats.timeFirstRxPacket); }},
+  {"TimeLastRxPacket", 'i', 8,
+   [](FlowId, const Ipv4LbFlowStats& stats) {
+     return GetTimeBits(stats.timeLastRxPacket); }},
+  {"DelaySum", 'i', 8,
+   [](FlowId, const Ipv4LbFlowStats& stats) {
+     return GetTimeBits(stats.delaySum); }},
+  {"JitterSum", 'i', 8,
+   [](FlowId, const Ipv4LbFlowStats& stats) {
+     return GetTimeBits(stats.jitterSum); }},
+  {"TxBytes", 'u', 8,
+   [](FlowId, const Ipv4LbFlowStats& stats) { return stats.txBytes; }},
+  {"RxBytes", 'u', 8,
+   [](FlowId, const Ipv4LbFlowStats& stats) { return stats.rxBytes; }},
+  {"TxPackets", 'u', 4,
+   [](FlowId, const Ipv4LbFlowStats& stats) -> uint64_t {
+     return stats.txPackets; }},
+  {"RxPackets", 'u', 4,
+   [](FlowId, const Ipv4LbFlowStats& stats) -> uint64_t {
+     return stats.rxPackets; }},
+  {"Duration", 'i', 8,
+   [](FlowId, const Ipv4LbFlowStats& stats) {
+     return GetTimeBits(GetDuration(stats)); }},
+  {"EffectiveRate", 'f', 8,
+   [](FlowId, const Ipv4LbFlowStats& stats) {
+     return GetDoubleBits(GetEffectiveRate(stats)); }},
+  {"DelayCount", 'u', 4,
+   [](FlowId, const Ipv4LbFlowStats& stats) -> uint64_t {
+     return stats.delayCount; }},
+  {"SamplingInterval", 'u', 4,
+   [](FlowId, const Ipv4LbFlowStats& stats) -> uint64_t {
+     return stats.samplingInterval; }},
+};
+
+// Appends the `size` low bytes of `value` to `bytes`, little-endian first.
+void AppendLittleEndian(std::string& bytes, uint64_t value, uint8_t size) {
+  for (uint8_t i = 0; i < size; i++) {
+    bytes.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+
+// Pads `bytes` with zeros up to a multiple of 8 bytes.
+void AppendPadding(std::string& bytes) {
+  bytes.append((8 - bytes.size() % 8) % 8, '\0');
+}
+
+}  // namespace
+
 void SerializeIpv4LbFlowStatsToCsvStream(std::ostream& os,
                                          FlowId flowId,
                                          Ipv4LbFlowStats& ipv4LbFlowStats,
                                          Time::Unit timeUnit) {
-  Time duration = (
-    ipv4LbFlowStats.timeLastRxPacket - ipv4LbFlowStats.timeFirstTxPacket);
-  // `rxBytes * 8` gives the received bits. Then we divide by the duration in
-  // seconds to get bps.
-  double effectiveRate = ((ipv4LbFlowStats.rxBytes * 8) /
-                           duration.GetSeconds());
+  Time duration = GetDuration(ipv4LbFlowStats);
+  double effectiveRate = GetEffectiveRate(ipv4LbFlowStats);
   os << flowId << "," << ipv4LbFlowStats.sourceAddress << ","
      << ipv4LbFlowStats.destinationAddress << ","
      << ipv4LbFlowStats.timeFirstTxPacket.As(timeUnit) << ","
@@ -22,7 +122,45 @@ void SerializeIpv4LbFlowStatsToCsvStream(std::ostream& os,
      << ipv4LbFlowStats.jitterSum.As(timeUnit) << ","
      << ipv4LbFlowStats.txBytes << "," << ipv4LbFlowStats.rxBytes << ","
      << ipv4LbFlowStats.txPackets << "," << ipv4LbFlowStats.rxPackets << ","
-     << duration.As(timeUnit) << "," << effectiveRate;
+     << duration.As(timeUnit) << "," << effectiveRate << ","
+     << ipv4LbFlowStats.delayCount << "," << ipv4LbFlowStats.samplingInterval;
+}
+
+void SerializeIpv4LbFlowStatsToBinaryStream(
+  std::ostream& os, const std::vector<FlowId>& flowIds,
+  const std::vector<Ipv4LbFlowStats>& ipv4LbFlowStats) {
+  NS_ASSERT(flowIds.size() == ipv4LbFlowStats.size());
+  uint32_t numColumns = sizeof(BINARY_COLUMNS) / sizeof(BINARY_COLUMNS[0]);
+  uint64_t numRows = flowIds.size();
+
+  std::string bytes(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+  AppendLittleEndian(bytes, BINARY_VERSION, 4);
+  AppendLittleEndian(bytes, numColumns, 4);
+  AppendLittleEndian(bytes, numRows, 8);
+  for (uint32_t column = 0; column < numColumns; column++) {
+    const BinaryColumn& binaryColumn = BINARY_COLUMNS[column];
+    uint16_t nameLength = std::strlen(binaryColumn.name);
+    bytes.push_back(binaryColumn.kind);
+    AppendLittleEndian(bytes, binaryColumn.size, 1);
+    AppendLittleEndian(bytes, nameLength, 2);
+    bytes.append(binaryColumn.name, nameLength);
+  }
+  AppendPadding(bytes);
+  os.write(bytes.data(), bytes.size());
+
+  // Each column is built in memory then written at once.
+  for (uint32_t column = 0; column < numColumns; column++) {
+    const BinaryColumn& binaryColumn = BINARY_COLUMNS[column];
+    bytes.clear();
+    bytes.reserve(numRows * binaryColumn.size + 8);
+    for (uint64_t row = 0; row < numRows; row++) {
+      AppendLittleEndian(
+        bytes, binaryColumn.get(flowIds[row], ipv4LbFlowStats[row]),
+        binaryColumn.size);
+    }
+    AppendPadding(bytes);
+    os.write(bytes.data(), bytes.size());
+  }
 }
 
 }  // namespace ns3
@@ -6,6 +6,8 @@
 #include "ns3/ipv4-header.h"
 #include "ns3/nstime.h"
 
+#include <vector>
+
 namespace ns3 {
 
 typedef uint32_t FlowId;
@@ -48,6 +50,15 @@ struct Ipv4LbFlowStats {
 
   // Total number of received packets for the flow.
   uint32_t rxPackets;
+
+  // Number of received packets whose delay is in delaySum, all of them unless
+  // packets were sampled.
+  uint32_t delayCount;
+
+  // How the packets of the flow were sampled for delays: 1 if every packet
+  // was, N if one packet in N was, 0 if none was and only the endpoints were
+  // monitored.
+  uint32_t samplingInterval;
 };
 
 /// Write the Ipv4LbFlowStats to a std::ostream in csv format.
@@ -61,6 +72,30 @@ void SerializeIpv4LbFlowStatsToCsvStream(std::ostream& os,
                                          Ipv4LbFlowStats& ipv4LbFlowStats,
                                          Time::Unit timeUnit = Time::NS);
 
+/// Write the Ipv4LbFlowStats of a set of flows to a std::ostream in a binary
+/// columnar format, read by `LoadBalancingAnalysis.utils`.
+///
+/// All values are little-endian. The file starts with a header:
+///   - the magic "NS3LBM\0\0" (8 bytes),
+///   - the format version, 1 (uint32),
+///   - the number of columns (uint32),
+///   - the number of rows, i.e. flows (uint64),
+///   - for each column, its type kind ('u' unsigned integer, 'i' signed
+///     integer or 'f' IEEE 754 floating point, 1 byte), its item size in
+///     bytes (uint8), the length of its name (uint16) and its name, in ASCII,
+///   - zero padding up to a multiple of 8 bytes.
+/// Then each column follows as an array of one value per row, padded with
+/// zeros up to a multiple of 8 bytes, in the order of the header. The columns
+/// are those of the csv format, with addresses as uint32 in host order and
+/// times, including Duration, as int64 nanoseconds.
+///
+/// \param os the output stream.
+/// \param flowIds the Id of each flow being written.
+/// \param ipv4LbFlowStats the load balancing statistics of each flow.
+void SerializeIpv4LbFlowStatsToBinaryStream(
+  std::ostream& os, const std::vector<FlowId>& flowIds,
+  const std::vector<Ipv4LbFlowStats>& ipv4LbFlowStats);
+
 }  // namespace ns3
 
 #endif  // IPV4_LB_UTILS_H
@@ -197,6 +197,22 @@ Ipv6FlowClassifier::FindFlow(FlowId flowId) const
     return retval;
 }
 
+void
+Ipv6FlowClassifier::ReleaseFlow(FlowId flowId)
+{
+    for (std::map<FiveTuple, FlowId>::iterator iter = m_flowMap.begin(); iter != m_flowMap.end();
+         iter++)
+    {
+        if (iter->second == flowId)
+        {
+            m_flowMap.erase(iter);
+            break;
+        }
+    }
+    m_flowPktIdMap.erase(flowId);
+    m_flowDscpMap.erase(flowId);
+}
+
 bool
 Ipv6FlowClassifier::SortByCount::operator()(std::pair<Ipv6Header::DscpType, uint32_t> left,
                                             std::pair<Ipv6Header::DscpType, uint32_t> right)
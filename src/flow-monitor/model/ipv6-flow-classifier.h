@@ -92,6 +92,8 @@ class Ipv6FlowClassifier : public FlowClassifier
 
     void SerializeToXmlStream(std::ostream& os, uint16_t indent) const override;
 
+    void ReleaseFlow(FlowId flowId) override;
+
   private:
     /// Map to Flows Identifiers to FlowIds
     std::map<FiveTuple, FlowId> m_flowMap;
@@ -220,7 +220,9 @@ Ipv6FlowProbe::Ipv6FlowProbe(Ptr<FlowMonitor> monitor,
     {
         NS_FATAL_ERROR("trace fail");
     }
-    if (!ipv6->TraceConnectWithoutContext(
+    // with only the endpoints monitored, no packet is followed from hop to hop
+    if (monitor->GetFidelity() != FlowMonitor::ENDPOINTS &&
+        !ipv6->TraceConnectWithoutContext(
             "UnicastForward",
             MakeCallback(&Ipv6FlowProbe::ForwardLogger, Ptr<Ipv6FlowProbe>(this))))
     {
@@ -310,6 +312,10 @@ Ipv6FlowProbe::ForwardLogger(const Ipv6Header& ipHeader,
     {
         FlowId flowId = fTag.GetFlowId();
         FlowPacketId packetId = fTag.GetPacketId();
+        if (!m_flowMonitor->IsTracked(packetId))
+        {
+            return;
+        }
 
         uint32_t size = (ipPayload->GetSize() + ipHeader.GetSerializedSize());
         NS_LOG_DEBUG("ReportForwarding (" << this << ", " << flowId << ", " << packetId << ", "
@@ -332,6 +338,13 @@ Ipv6FlowProbe::ForwardUpLogger(const Ipv6Header& ipHeader,
         FlowPacketId packetId = fTag.GetPacketId();
 
         uint32_t size = (ipPayload->GetSize() + ipHeader.GetSerializedSize());
+        if (!m_flowMonitor->IsTracked(packetId))
+        {
+            NS_LOG_DEBUG("ReportUntrackedLastRx (" << this << ", " << flowId << ", " << size
+                                                   << ");");
+            m_flowMonitor->ReportUntrackedLastRx(this, flowId, size);
+            return;
+        }
         NS_LOG_DEBUG("ReportLastRx (" << this << ", " << flowId << ", " << packetId << ", " << size
                                       << ");");
         m_flowMonitor->ReportLastRx(this, flowId, packetId, size);
@@ -0,0 +1,300 @@
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation;
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "tracked-packet-table.h"
+
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+
+/// The number of slots of an empty table
+#define INITIAL_SLOTS 1024
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("TrackedPacketTable");
+
+TrackedPacketTable::TrackedPacketTable()
+    : m_slots(INITIAL_SLOTS),
+      m_mask(INITIAL_SLOTS - 1),
+      m_size(0),
+      m_deleted(0),
+      m_generationWidth(Seconds(1)),
+      m_firstGeneration(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+TrackedPacketTable::Configure(Time generationWidth)
+{
+    NS_LOG_FUNCTION(this << generationWidth.As(Time::S));
+    NS_ASSERT_MSG(generationWidth.IsStrictlyPositive(), "Generations must span some time");
+    Clear();
+    m_generationWidth = generationWidth;
+}
+
+uint64_t
+TrackedPacketTable::MakeKey(FlowId flowId, FlowPacketId packetId)
+{
+    return (static_cast<uint64_t>(flowId) << 32) | packetId;
+}
+
+uint32_t
+TrackedPacketTable::GetHome(uint64_t key) const
+{
+    // Fibonacci hashing spreads the consecutive packet IDs of a flow.
+    return static_cast<uint32_t>((key * 0x9E3779B97F4A7C15ULL) >> 32) & m_mask;
+}
+
+uint32_t
+TrackedPacketTable::FindSlot(uint64_t key) const
+{
+    uint32_t slot = GetHome(key);
+    while (m_slots[slot].state != EMPTY &&
+           (m_slots[slot].state != USED || m_slots[slot].key != key))
+    {
+        slot = (slot + 1) & m_mask;
+    }
+    return slot;
+}
+
+int64_t
+TrackedPacketTable::GetGeneration(Time time) const
+{
+    return time.GetTimeStep() / m_generationWidth.GetTimeStep();
+}
+
+void
+TrackedPacketTable::Link(uint32_t slot)
+{
+    if (m_generations.empty())
+    {
+        m_firstGeneration = GetGeneration(m_slots[slot].packet.lastSeenTime);
+    }
+    // Time does not go back, but a sweep may have passed the generation of
+    // a packet that is listed late; listing it first keeps it in the next
+    // sweep.
+    int64_t generation =
+        std::max(GetGeneration(m_slots[slot].packet.lastSeenTime), m_firstGeneration);
+    while (m_firstGeneration + static_cast<int64_t>(m_generations.size()) <= generation)
+    {
+        m_generations.push_back(NO_SLOT);
+    }
+    uint32_t& head = m_generations[generation - m_firstGeneration];
+    m_slots[slot].prev = NO_SLOT;
+    m_slots[slot].next = head;
+    if (head != NO_SLOT)
+    {
+        m_slots[head].prev = slot;
+    }
+    head = slot;
+}
+
+void
+TrackedPacketTable::Unlink(uint32_t slot)
+{
+    Slot& entry = m_slots[slot];
+    if (entry.prev != NO_SLOT)
+    {
+        m_slots[entry.prev].next = entry.next;
+    }
+    else
+    {
+        int64_t generation =
+            std::max(GetGeneration(entry.packet.lastSeenTime), m_firstGeneration);
+        m_generations[generation - m_firstGeneration] = entry.next;
+    }
+    if (entry.next != NO_SLOT)
+    {
+        m_slots[entry.next].prev = entry.prev;
+    }
+}
+
+TrackedPacketTable::TrackedPacket&
+TrackedPacketTable::Insert(FlowId flowId, FlowPacketId packetId, Time now)
+{
+    uint64_t key = MakeKey(flowId, packetId);
+    uint32_t slot = FindSlot(key);
+    if (m_slots[slot].state == USED)
+    {
+        Unlink(slot);
+    }
+    else
+    {
+        // Keep at least half of the slots empty so that probes stay short.
+        if (2 * (m_size + m_deleted + 1) > m_slots.size())
+        {
+            Rehash();
+            slot = FindSlot(key);
+        }
+        m_slots[slot].key = key;
+        m_slots[slot].state = USED;
+        m_size++;
+    }
+    TrackedPacket& packet = m_slots[slot].packet;
+    packet.firstSeenTime = now;
+    packet.lastSeenTime = now;
+    packet.timesForwarded = 0;
+    Link(slot);
+    return packet;
+}
+
+TrackedPacketTable::TrackedPacket*
+TrackedPacketTable::Find(FlowId flowId, FlowPacketId packetId)
+{
+    uint32_t slot = FindSlot(MakeKey(flowId, packetId));
+    return m_slots[slot].state == USED ? &m_slots[slot].packet : nullptr;
+}
+
+TrackedPacketTable::TrackedPacket*
+TrackedPacketTable::Touch(FlowId flowId, FlowPacketId packetId, Time now)
+{
+    uint32_t slot = FindSlot(MakeKey(flowId, packetId));
+    if (m_slots[slot].state != USED)
+    {
+        return nullptr;
+    }
+    TrackedPacket& packet = m_slots[slot].packet;
+    if (GetGeneration(now) != GetGeneration(packet.lastSeenTime))
+    {
+        Unlink(slot);
+        packet.lastSeenTime = now;
+        Link(slot);
+    }
+    else
+    {
+        packet.lastSeenTime = now;
+    }
+    return &packet;
+}
+
+void
+TrackedPacketTable::EraseSlot(uint32_t slot)
+{
+    Unlink(slot);
+    m_slots[slot].state = DELETED;
+    m_size--;
+    m_deleted++;
+    if (m_size == 0)
+    {
+        // Nothing is listed anymore, so the generations can start over.
+        m_generations.clear();
+    }
+}
+
+bool
+TrackedPacketTable::Erase(FlowId flowId, FlowPacketId packetId)
+{
+    uint32_t slot = FindSlot(MakeKey(flowId, packetId));
+    if (m_slots[slot].state != USED)
+    {
+        return false;
+    }
+    EraseSlot(slot);
+    return true;
+}
+
+void
+TrackedPacketTable::ExpireLostPackets(Time deadline, std::vector<FlowId>& lostFlows)
+{
+    NS_LOG_FUNCTION(this << deadline.As(Time::S));
+    int64_t lastGeneration = GetGeneration(deadline);
+    while (!m_generations.empty() && m_firstGeneration <= lastGeneration)
+    {
+        // Every packet of a generation before the one of the deadline is
+        // lost, the packets of the generation of the deadline are checked.
+        uint32_t slot = m_generations.front();
+        while (slot != NO_SLOT)
+        {
+            uint32_t next = m_slots[slot].next;
+            if (m_slots[slot].packet.lastSeenTime <= deadline)
+            {
+                lostFlows.push_back(static_cast<FlowId>(m_slots[slot].key >> 32));
+                EraseSlot(slot);
+                if (m_generations.empty())
+                {
+                    return;
+                }
+            }
+            slot = next;
+        }
+        if (m_generations.front() != NO_SLOT)
+        {
+            break;
+        }
+        m_generations.pop_front();
+        m_firstGeneration++;
+    }
+}
+
+void
+TrackedPacketTable::Rehash()
+{
+    uint32_t nSlots = m_slots.size();
+    if (4 * m_size >= nSlots)
+    {
+        nSlots *= 2;
+    }
+    NS_LOG_FUNCTION(this << m_size << m_deleted << nSlots);
+
+    // Moving the packets changes their slots, so the generation lists are
+    // rebuilt in the same order.
+    std::vector<Slot> oldSlots(nSlots);
+    oldSlots.swap(m_slots);
+    std::deque<uint32_t> oldGenerations(m_generations.size(), NO_SLOT);
+    oldGenerations.swap(m_generations);
+    m_mask = nSlots - 1;
+    m_deleted = 0;
+
+    for (std::size_t i = 0; i < oldGenerations.size(); i++)
+    {
+        // Collect the list first, and link its packets in reverse, to keep
+        // the order of the list.
+        std::vector<uint32_t> list;
+        for (uint32_t slot = oldGenerations[i]; slot != NO_SLOT; slot = oldSlots[slot].next)
+        {
+            list.push_back(slot);
+        }
+        for (auto itr = list.rbegin(); itr != list.rend(); itr++)
+        {
+            uint32_t slot = FindSlot(oldSlots[*itr].key);
+            m_slots[slot] = oldSlots[*itr];
+            Link(slot);
+        }
+    }
+}
+
+uint32_t
+TrackedPacketTable::GetSize() const
+{
+    return m_size;
+}
+
+void
+TrackedPacketTable::Clear()
+{
+    NS_LOG_FUNCTION(this);
+    std::vector<Slot>(INITIAL_SLOTS).swap(m_slots);
+    m_mask = INITIAL_SLOTS - 1;
+    m_size = 0;
+    m_deleted = 0;
+    m_generations.clear();
+    m_firstGeneration = 0;
+}
+
+} // namespace ns3
@@ -0,0 +1,206 @@
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation;
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef TRACKED_PACKET_TABLE_H
+#define TRACKED_PACKET_TABLE_H
+
+#include "ns3/flow-classifier.h"
+#include "ns3/nstime.h"
+
+#include <deque>
+#include <stdint.h>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup flow-monitor
+ * \brief The packets a FlowMonitor has seen sent but not yet received or dropped
+ *
+ * Packets are kept in a flat open-addressing hash table keyed by flow and
+ * packet ID, so that the reports of the probes, made for every packet at
+ * every hop, cost a probe of one contiguous array and no allocation.
+ *
+ * To find the lost packets without visiting every tracked packet, the
+ * packets are also linked, through their slots, into a list per generation
+ * of the time they were last seen, a generation covering a fixed span of
+ * time, like the buckets of a timer wheel.  A packet seen again in a later
+ * generation moves to its list.  A sweep only visits the generations old
+ * enough to hold lost packets, so its cost is proportional to the packets
+ * that expired, plus at most one generation of packets that did not.
+ */
+class TrackedPacketTable
+{
+  public:
+    /// Structure to represent a single tracked packet data
+    struct TrackedPacket
+    {
+        Time firstSeenTime;      //!< absolute time when the packet was first seen by a probe
+        Time lastSeenTime;       //!< absolute time when the packet was last seen by a probe
+        uint32_t timesForwarded; //!< number of times the packet was reportedly forwarded
+    };
+
+    TrackedPacketTable();
+
+    /**
+     * \brief Set the span of time of a generation
+     *
+     * Forgets every tracked packet.
+     *
+     * \param generationWidth the span of time of a generation; sweeps visit
+     * at most one generation of packets that are not lost yet
+     */
+    void Configure(Time generationWidth);
+
+    /**
+     * \brief Start tracking a packet, seen for the first time now
+     * \param flowId the flow of the packet
+     * \param packetId the packet ID
+     * \param now the current time
+     * \returns the tracked packet, valid until the table is next changed
+     */
+    TrackedPacket& Insert(FlowId flowId, FlowPacketId packetId, Time now);
+
+    /**
+     * \brief Find a tracked packet
+     * \param flowId the flow of the packet
+     * \param packetId the packet ID
+     * \returns the tracked packet, valid until the table is next changed, or
+     * nullptr if the packet is not tracked
+     */
+    TrackedPacket* Find(FlowId flowId, FlowPacketId packetId);
+
+    /**
+     * \brief Record that a tracked packet was seen again now
+     * \param flowId the flow of the packet
+     * \param packetId the packet ID
+     * \param now the current time
+     * \returns the tracked packet, valid until the table is next changed, or
+     * nullptr if the packet is not tracked
+     */
+    TrackedPacket* Touch(FlowId flowId, FlowPacketId packetId, Time now);
+
+    /**
+     * \brief Stop tracking a packet
+     * \param flowId the flow of the packet
+     * \param packetId the packet ID
+     * \returns true if the packet was tracked
+     */
+    bool Erase(FlowId flowId, FlowPacketId packetId);
+
+    /**
+     * \brief Stop tracking the packets last seen at or before a deadline
+     * \param deadline the time before which packets are lost
+     * \param lostFlows the flow of each lost packet is appended to it
+     */
+    void ExpireLostPackets(Time deadline, std::vector<FlowId>& lostFlows);
+
+    /**
+     * \returns the number of tracked packets
+     */
+    uint32_t GetSize() const;
+
+    /**
+     * \brief Forget every tracked packet
+     */
+    void Clear();
+
+  private:
+    /// The state of a slot of the hash table
+    enum SlotState : uint8_t
+    {
+        EMPTY,   //!< never used since the last rehash, ends a probe
+        USED,    //!< holds a packet
+        DELETED, //!< held a packet, skipped by probes
+    };
+
+    /// A slot of the hash table
+    struct Slot
+    {
+        TrackedPacket packet; //!< the tracked packet
+        uint64_t key;         //!< the flow ID and the packet ID
+        uint32_t prev;        //!< the previous slot of the generation list
+        uint32_t next;        //!< the next slot of the generation list
+        SlotState state;      //!< the state of the slot
+    };
+
+    /// The end of a generation list
+    static constexpr uint32_t NO_SLOT = 0xffffffff;
+
+    /**
+     * \param flowId the flow of the packet
+     * \param packetId the packet ID
+     * \returns the key of the packet
+     */
+    static uint64_t MakeKey(FlowId flowId, FlowPacketId packetId);
+
+    /**
+     * \param key the key of a packet
+     * \returns the slot the key hashes to
+     */
+    uint32_t GetHome(uint64_t key) const;
+
+    /**
+     * \param key the key of a packet
+     * \returns the slot of the packet, or the empty slot where it belongs
+     */
+    uint32_t FindSlot(uint64_t key) const;
+
+    /**
+     * \brief Stop tracking the packet of a slot
+     * \param slot the slot
+     */
+    void EraseSlot(uint32_t slot);
+
+    /**
+     * \brief Rebuild the table, with twice as many slots if it is filling
+     * up, dropping the deleted slots
+     */
+    void Rehash();
+
+    /**
+     * \param time a time
+     * \returns the generation of the time
+     */
+    int64_t GetGeneration(Time time) const;
+
+    /**
+     * \brief Link a slot into the list of the generation of the time its
+     * packet was last seen
+     * \param slot the slot
+     */
+    void Link(uint32_t slot);
+
+    /**
+     * \brief Unlink a slot from its generation list
+     * \param slot the slot
+     */
+    void Unlink(uint32_t slot);
+
+    std::vector<Slot> m_slots; //!< the hash table, a power of two of slots
+    uint32_t m_mask;           //!< the number of slots minus one
+    uint32_t m_size;           //!< the number of tracked packets
+    uint32_t m_deleted;        //!< the number of deleted slots
+
+    Time m_generationWidth; //!< the span of time of a generation
+    /// The first slot of the list of each generation, from m_firstGeneration on
+    std::deque<uint32_t> m_generations;
+    int64_t m_firstGeneration; //!< the generation of the front of m_generations
+};
+
+} // namespace ns3
+
+#endif /* TRACKED_PACKET_TABLE_H */
@@ -0,0 +1,898 @@
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation;
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "ns3/flow-monitor-helper.h"
+#include "ns3/flow-monitor.h"
+#include "ns3/flow-probe.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-flow-classifier.h"
+#include "ns3/ipv4-lb-flow-stats.h"
+#include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/node-container.h"
+#include "ns3/packet.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/simulator.h"
+#include "ns3/socket.h"
+#include "ns3/tcp-header.h"
+#include "ns3/test.h"
+#include "ns3/tracked-packet-table.h"
+#include "ns3/udp-header.h"
+#include "ns3/udp-socket-factory.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \defgroup flow-monitor-test Tests for flow-monitor
+ * \ingroup flow-monitor
+ * \ingroup tests
+ */
+
+namespace
+{
+
+/// The packets the sender of a line network sends
+const uint32_t LINE_PACKETS = 100;
+
+/**
+ * \brief Sends a packet of a flow, and schedules the next one
+ * \param socket the socket of the flow
+ * \param remaining the number of packets left to send, this one included
+ */
+void
+SendPacket(Ptr<Socket> socket, uint32_t remaining)
+{
+    socket->Send(Create<Packet>(500));
+    if (remaining > 1)
+    {
+        Simulator::Schedule(MilliSeconds(1), &SendPacket, socket, remaining - 1);
+    }
+}
+
+/// What a FlowMonitor saw of the one flow of a line network
+struct LineRun
+{
+    FlowMonitor::FlowStats stats; //!< the statistics of the flow
+    uint32_t probeStats;          //!< the number of probes with stats of the flow
+};
+
+/**
+ * \brief Sends LINE_PACKETS UDP packets over n0 -- n1 -- n2 with a
+ * FlowMonitor on every node
+ * \param fidelity how much the FlowMonitor follows each packet
+ * \param samplingInterval the sampling interval of the SAMPLED fidelity
+ * \returns what the FlowMonitor saw of the flow
+ */
+LineRun
+RunLine(FlowMonitor::Fidelity fidelity, uint32_t samplingInterval)
+{
+    NodeContainer nodes;
+    nodes.Create(3);
+    InternetStackHelper internet;
+    internet.Install(nodes);
+
+    SimpleNetDeviceHelper simpleHelper;
+    simpleHelper.SetNetDevicePointToPointMode(true);
+    simpleHelper.SetChannelAttribute("Delay", TimeValue(MicroSeconds(100)));
+    Ipv4AddressHelper ipv4;
+    ipv4.SetBase("10.1.1.0", "255.255.255.252");
+    ipv4.Assign(simpleHelper.Install(NodeContainer(nodes.Get(0), nodes.Get(1))));
+    ipv4.SetBase("10.1.2.0", "255.255.255.252");
+    Ipv4InterfaceContainer last =
+        ipv4.Assign(simpleHelper.Install(NodeContainer(nodes.Get(1), nodes.Get(2))));
+    Ipv4GlobalRoutingHelper::PopulateRoutingTables();
+
+    FlowMonitorHelper flowmon;
+    flowmon.SetMonitoringFidelity(fidelity, samplingInterval);
+    Ptr<FlowMonitor> monitor = flowmon.InstallAll();
+
+    Ptr<Socket> sink = Socket::CreateSocket(nodes.Get(2), UdpSocketFactory::GetTypeId());
+    sink->Bind(InetSocketAddress(Ipv4Address::GetAny(), 9));
+    Ptr<Socket> source = Socket::CreateSocket(nodes.Get(0), UdpSocketFactory::GetTypeId());
+    source->Connect(InetSocketAddress(last.GetAddress(1), 9));
+    Simulator::Schedule(Seconds(1), &SendPacket, source, LINE_PACKETS);
+
+    Simulator::Stop(Seconds(2));
+    Simulator::Run();
+
+    LineRun run;
+    FlowMonitor::FlowStatsContainer flowStats = monitor->GetFlowStats();
+    NS_ASSERT(flowStats.size() == 1);
+    run.stats = flowStats.begin()->second;
+    run.probeStats = 0;
+    for (Ptr<FlowProbe> probe : monitor->GetAllProbes())
+    {
+        run.probeStats += probe->GetStats().size();
+    }
+
+    Simulator::Destroy();
+    return run;
+}
+
+/**
+ * \brief The slot a packet hashes to in a TrackedPacketTable, mirroring the
+ * hash of the table
+ * \param flowId the flow of the packet
+ * \param packetId the packet ID
+ * \param nSlots the number of slots of the table
+ * \returns the home slot of the packet
+ */
+uint32_t
+HomeSlot(FlowId flowId, FlowPacketId packetId, uint32_t nSlots)
+{
+    uint64_t key = (static_cast<uint64_t>(flowId) << 32) | packetId;
+    return static_cast<uint32_t>((key * 0x9E3779B97F4A7C15ULL) >> 32) & (nSlots - 1);
+}
+
+/// The rows of a csv file, each split into its fields
+typedef std::vector<std::vector<std::string>> CsvRows;
+
+/**
+ * \brief Reads a csv file
+ * \param fileName the name of the file
+ * \param header the first line of the file
+ * \returns the rows after the first line
+ */
+CsvRows
+ReadCsv(const std::string& fileName, std::string* header)
+{
+    CsvRows rows;
+    std::ifstream is(fileName);
+    std::getline(is, *header);
+    std::string line;
+    while (std::getline(is, line))
+    {
+        rows.emplace_back();
+        std::istringstream fields(line);
+        std::string field;
+        while (std::getline(fields, field, ','))
+        {
+            rows.back().push_back(field);
+        }
+    }
+    return rows;
+}
+
+/**
+ * \param rows the rows of a csv file
+ * \param row the index of the row
+ * \param column the index of the column
+ * \returns the field, or an empty string if there is none
+ */
+std::string
+GetField(const CsvRows& rows, uint32_t row, uint32_t column)
+{
+    if (row >= rows.size() || column >= rows[row].size())
+    {
+        return "";
+    }
+    return rows[row][column];
+}
+
+/**
+ * \brief Classifies a packet with a TCP or UDP header, as for its first
+ * probe
+ * \param classifier the classifier
+ * \param tuple the five-tuple of the packet
+ * \param dscp the DSCP value of the packet
+ * \param flowId the FlowId of the packet, if classified
+ * \param packetId the packet ID of the packet, if classified
+ * \returns true if the packet was classified
+ */
+bool
+ClassifyPacket(Ptr<Ipv4FlowClassifier> classifier,
+               const Ipv4FlowClassifier::FiveTuple& tuple,
+               Ipv4Header::DscpType dscp,
+               FlowId* flowId,
+               FlowPacketId* packetId)
+{
+    Ipv4Header ipHeader;
+    ipHeader.SetSource(tuple.sourceAddress);
+    ipHeader.SetDestination(tuple.destinationAddress);
+    ipHeader.SetProtocol(tuple.protocol);
+    ipHeader.SetDscp(dscp);
+    Ptr<Packet> payload = Create<Packet>(100);
+    if (tuple.protocol == 6)
+    {
+        TcpHeader tcpHeader;
+        tcpHeader.SetSourcePort(tuple.sourcePort);
+        tcpHeader.SetDestinationPort(tuple.destinationPort);
+        payload->AddHeader(tcpHeader);
+    }
+    else
+    {
+        UdpHeader udpHeader;
+        udpHeader.SetSourcePort(tuple.sourcePort);
+        udpHeader.SetDestinationPort(tuple.destinationPort);
+        payload->AddHeader(udpHeader);
+    }
+    return classifier->Classify(ipHeader, payload, flowId, packetId);
+}
+
+/**
+ * \param bytes the bytes of a binary file
+ * \param offset the offset of the value
+ * \param size the size of the value, in bytes
+ * \returns the little-endian value at offset, zero-extended
+ */
+uint64_t
+ReadLittleEndian(const std::string& bytes, uint64_t offset, uint8_t size)
+{
+    uint64_t value = 0;
+    for (uint8_t i = 0; i < size && offset + i < bytes.size(); i++)
+    {
+        value |= static_cast<uint64_t>(static_cast<uint8_t>(bytes[offset + i])) << (8 * i);
+    }
+    return value;
+}
+
+/**
+ * \param size a size, in bytes
+ * \returns the size rounded up to a multiple of 8 bytes
+ */
+uint64_t
+RoundUpTo8(uint64_t size)
+{
+    return (size + 7) / 8 * 8;
+}
+
+} // namespace
+
+/**
+ * \ingroup flow-monitor-test
+ *
+ * \brief Checks what each fidelity of the FlowMonitor records of a flow.
+ *
+ * Every fidelity counts the packets and bytes of a flow and their times
+ * exactly; only the tracked packets, one in the sampling interval when
+ * sampled and none for the endpoints only, have their delays measured and
+ * are reported by the probes they cross.
+ */
+class FlowMonitorFidelityTestCase : public TestCase
+{
+  public:
+    FlowMonitorFidelityTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+FlowMonitorFidelityTestCase::FlowMonitorFidelityTestCase()
+    : TestCase("FlowMonitor fidelities track full, sampled or no packets")
+{
+}
+
+void
+FlowMonitorFidelityTestCase::DoRun()
+{
+    LineRun full = RunLine(FlowMonitor::FULL, 16);
+    NS_TEST_ASSERT_MSG_EQ(full.stats.txPackets, LINE_PACKETS, "Every packet is sent");
+    NS_TEST_ASSERT_MSG_EQ(full.stats.rxPackets, LINE_PACKETS, "Every packet is received");
+    NS_TEST_ASSERT_MSG_EQ(full.stats.delayCount, LINE_PACKETS, "Every delay is measured");
+    NS_TEST_ASSERT_MSG_EQ(full.stats.timesForwarded, LINE_PACKETS, "Every hop is tracked");
+    NS_TEST_ASSERT_MSG_EQ(full.probeStats, 3, "Every probe reports the flow");
+
+    const uint32_t samplingInterval = 8;
+    LineRun sampled = RunLine(FlowMonitor::SAMPLED, samplingInterval);
+    NS_TEST_ASSERT_MSG_EQ(sampled.stats.txPackets, LINE_PACKETS, "Packets are counted exactly");
+    NS_TEST_ASSERT_MSG_EQ(sampled.stats.rxPackets, LINE_PACKETS, "Packets are counted exactly");
+    NS_TEST_ASSERT_MSG_EQ(sampled.stats.rxBytes, full.stats.rxBytes, "Bytes are counted exactly");
+    // packet IDs start from 0, so the first packet of each interval is tracked
+    uint32_t sampledPackets = (LINE_PACKETS + samplingInterval - 1) / samplingInterval;
+    NS_TEST_ASSERT_MSG_EQ(sampled.stats.delayCount,
+                          sampledPackets,
+                          "One delay in the sampling interval is measured");
+    NS_TEST_ASSERT_MSG_EQ(sampled.stats.timesForwarded,
+                          sampledPackets,
+                          "Only the sampled packets are tracked from hop to hop");
+    NS_TEST_ASSERT_MSG_EQ_TOL(sampled.stats.delaySum.GetSeconds() / sampled.stats.delayCount,
+                              full.stats.delaySum.GetSeconds() / full.stats.delayCount,
+                              1e-9,
+                              "The sampled mean delay matches the full one on an idle line");
+    NS_TEST_ASSERT_MSG_EQ(sampled.stats.timeLastRxPacket,
+                          full.stats.timeLastRxPacket,
+                          "Flow completion times stay exact");
+
+    LineRun endpoints = RunLine(FlowMonitor::ENDPOINTS, 16);
+    NS_TEST_ASSERT_MSG_EQ(endpoints.stats.txPackets, LINE_PACKETS, "Packets are counted exactly");
+    NS_TEST_ASSERT_MSG_EQ(endpoints.stats.rxPackets, LINE_PACKETS, "Packets are counted exactly");
+    NS_TEST_ASSERT_MSG_EQ(endpoints.stats.txBytes, full.stats.txBytes, "Bytes are counted exactly");
+    NS_TEST_ASSERT_MSG_EQ(endpoints.stats.rxBytes, full.stats.rxBytes, "Bytes are counted exactly");
+    NS_TEST_ASSERT_MSG_EQ(endpoints.stats.timeFirstTxPacket,
+                          full.stats.timeFirstTxPacket,
+                          "Flow start times stay exact");
+    NS_TEST_ASSERT_MSG_EQ(endpoints.stats.timeLastRxPacket,
+                          full.stats.timeLastRxPacket,
+                          "Flow completion times stay exact");
+    NS_TEST_ASSERT_MSG_EQ(endpoints.stats.delayCount, 0, "No delay is measured");
+    NS_TEST_ASSERT_MSG_EQ(endpoints.stats.delaySum, Seconds(0), "No delay is measured");
+    NS_TEST_ASSERT_MSG_EQ(endpoints.stats.timesForwarded, 0, "No hop is tracked");
+    NS_TEST_ASSERT_MSG_EQ(endpoints.probeStats, 0, "No probe reports packets");
+}
+
+/**
+ * \ingroup flow-monitor-test
+ *
+ * \brief Checks the hash table and the generation lists of TrackedPacketTable.
+ *
+ * Packets are found until erased, including along probe chains that wrap
+ * around the end of the table and skip deleted slots, and survive the
+ * rehashes of a growing table.  Sweeps expire exactly the packets last seen
+ * by the deadline, whichever generation they were inserted or touched in.
+ */
+class TrackedPacketTableTestCase : public TestCase
+{
+  public:
+    TrackedPacketTableTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+TrackedPacketTableTestCase::TrackedPacketTableTestCase()
+    : TestCase("TrackedPacketTable finds, erases and expires packets")
+{
+}
+
+void
+TrackedPacketTableTestCase::DoRun()
+{
+    TrackedPacketTable table;
+    table.Configure(MilliSeconds(10));
+    TrackedPacketTable::TrackedPacket& inserted = table.Insert(1, 0, MilliSeconds(1));
+    inserted.timesForwarded = 2;
+    TrackedPacketTable::TrackedPacket* found = table.Find(1, 0);
+    NS_TEST_ASSERT_MSG_NE(found, nullptr, "An inserted packet is found");
+    NS_TEST_ASSERT_MSG_EQ(found->firstSeenTime, MilliSeconds(1), "The packet keeps its times");
+    NS_TEST_ASSERT_MSG_EQ(found->timesForwarded, 2, "The packet keeps its state");
+    NS_TEST_ASSERT_MSG_EQ(table.Find(1, 1), nullptr, "Other packets of the flow are not found");
+    NS_TEST_ASSERT_MSG_EQ(table.Find(2, 0), nullptr, "Packets of other flows are not found");
+    table.Insert(1, 0, MilliSeconds(3));
+    NS_TEST_ASSERT_MSG_EQ(table.GetSize(), 1, "A packet inserted again is tracked once");
+    NS_TEST_ASSERT_MSG_EQ(table.Find(1, 0)->firstSeenTime,
+                          MilliSeconds(3),
+                          "A packet inserted again starts over");
+    NS_TEST_ASSERT_MSG_EQ(table.Erase(1, 0), true, "A tracked packet is erased");
+    NS_TEST_ASSERT_MSG_EQ(table.Find(1, 0), nullptr, "An erased packet is not found");
+    NS_TEST_ASSERT_MSG_EQ(table.Erase(1, 0), false, "An erased packet is not erased again");
+    NS_TEST_ASSERT_MSG_EQ(table.GetSize(), 0, "No packet is tracked");
+
+    // Three packets hashing to the last slot of a fresh table of 1024 slots
+    // collide, and the last two wrap around to the first slots.
+    const uint32_t nSlots = 1024;
+    std::vector<FlowPacketId> colliding;
+    for (FlowPacketId packetId = 0; colliding.size() < 3; packetId++)
+    {
+        if (HomeSlot(5, packetId, nSlots) == nSlots - 1)
+        {
+            colliding.push_back(packetId);
+        }
+    }
+    table.Clear();
+    for (FlowPacketId packetId : colliding)
+    {
+        table.Insert(5, packetId, MilliSeconds(1));
+    }
+    NS_TEST_ASSERT_MSG_EQ(table.GetSize(), 3, "Colliding packets are tracked apart");
+    NS_TEST_ASSERT_MSG_EQ(table.Erase(5, colliding[0]), true, "A colliding packet is erased");
+    NS_TEST_ASSERT_MSG_EQ(table.Find(5, colliding[0]), nullptr, "An erased packet is not found");
+    NS_TEST_ASSERT_MSG_NE(table.Find(5, colliding[1]),
+                          nullptr,
+                          "Probes wrap around and skip erased slots");
+    NS_TEST_ASSERT_MSG_NE(table.Find(5, colliding[2]),
+                          nullptr,
+                          "Probes wrap around and skip erased slots");
+    table.Insert(5, colliding[0], MilliSeconds(1));
+    NS_TEST_ASSERT_MSG_EQ(table.GetSize(), 3, "An erased slot is reused");
+    NS_TEST_ASSERT_MSG_EQ(table.Erase(5, colliding[2]), true, "A wrapped packet is erased");
+    NS_TEST_ASSERT_MSG_NE(table.Find(5, colliding[0]), nullptr, "Other packets stay tracked");
+    NS_TEST_ASSERT_MSG_NE(table.Find(5, colliding[1]), nullptr, "Other packets stay tracked");
+
+    // Packets expire by the time they were last seen, not inserted.
+    table.Clear();
+    table.Insert(1, 0, MilliSeconds(0));
+    table.Insert(2, 0, MilliSeconds(5));
+    table.Insert(3, 0, MilliSeconds(12));
+    table.Insert(4, 0, MilliSeconds(25));
+    NS_TEST_ASSERT_MSG_NE(table.Touch(1, 0, MilliSeconds(21)), nullptr, "Packet 1 is tracked");
+    NS_TEST_ASSERT_MSG_EQ(table.Touch(9, 0, MilliSeconds(21)), nullptr, "Packet 9 is not tracked");
+    std::vector<FlowId> lostFlows;
+    table.ExpireLostPackets(MilliSeconds(8), lostFlows);
+    NS_TEST_ASSERT_MSG_EQ(lostFlows.size(), 1, "One packet was last seen by 8 ms");
+    NS_TEST_ASSERT_MSG_EQ(lostFlows[0], 2, "A packet seen again later is kept");
+    NS_TEST_ASSERT_MSG_EQ(table.Find(2, 0), nullptr, "A lost packet is not tracked");
+    lostFlows.clear();
+    table.ExpireLostPackets(MilliSeconds(12), lostFlows);
+    NS_TEST_ASSERT_MSG_EQ(lostFlows.size(), 1, "One packet was last seen by 12 ms");
+    NS_TEST_ASSERT_MSG_EQ(lostFlows[0], 3, "The deadline itself is lost");
+    // Packet 4 is seen again in its own generation.
+    table.Touch(4, 0, MilliSeconds(27));
+    lostFlows.clear();
+    table.ExpireLostPackets(MilliSeconds(26), lostFlows);
+    NS_TEST_ASSERT_MSG_EQ(lostFlows.size(), 1, "One packet was last seen by 26 ms");
+    NS_TEST_ASSERT_MSG_EQ(lostFlows[0], 1, "A touched packet expires from its new generation");
+    NS_TEST_ASSERT_MSG_NE(table.Find(4, 0), nullptr, "A packet seen after the deadline is kept");
+    lostFlows.clear();
+    table.ExpireLostPackets(MilliSeconds(30), lostFlows);
+    NS_TEST_ASSERT_MSG_EQ(lostFlows.size(), 1, "The last packet was last seen by 30 ms");
+    NS_TEST_ASSERT_MSG_EQ(table.GetSize(), 0, "No packet is tracked");
+
+    // Growing the table rehashes it without losing packets or their
+    // generations.
+    const uint32_t nPackets = 4000;
+    table.Configure(MicroSeconds(100));
+    for (FlowPacketId packetId = 0; packetId < nPackets; packetId++)
+    {
+        table.Insert(7, packetId, MicroSeconds(packetId));
+    }
+    for (FlowPacketId packetId = 1; packetId < nPackets; packetId += 2)
+    {
+        table.Erase(7, packetId);
+    }
+    NS_TEST_ASSERT_MSG_EQ(table.GetSize(), nPackets / 2, "Half of the packets are tracked");
+    uint32_t nMisplaced = 0;
+    for (FlowPacketId packetId = 0; packetId < nPackets; packetId++)
+    {
+        bool tracked = table.Find(7, packetId) != nullptr;
+        if (tracked != (packetId % 2 == 0))
+        {
+            nMisplaced++;
+        }
+    }
+    NS_TEST_ASSERT_MSG_EQ(nMisplaced, 0, "Exactly the packets not erased are found");
+    lostFlows.clear();
+    table.ExpireLostPackets(MicroSeconds(999), lostFlows);
+    NS_TEST_ASSERT_MSG_EQ(lostFlows.size(), 500, "The packets sent in the first ms are lost");
+    NS_TEST_ASSERT_MSG_EQ(table.Find(7, 998), nullptr, "A lost packet is not tracked");
+    NS_TEST_ASSERT_MSG_NE(table.Find(7, 1000), nullptr, "Later packets are kept");
+    NS_TEST_ASSERT_MSG_EQ(table.GetSize(), nPackets / 2 - 500, "Later packets are kept");
+}
+
+/**
+ * \ingroup flow-monitor-test
+ *
+ * \brief Checks the rows streamed by StreamLbPerformanceMetricsToFile.
+ *
+ * Two UDP flows cross n0 -- n1.  The first one is finished through the
+ * helper once its packets are received, and the second one once it is idle
+ * for FlowIdleTimeout at a periodic check; each is written out as it
+ * finishes, and forgotten by the monitor and the classifier.  Packets later
+ * sent on the tuple of the first flow start a new flow, which is written
+ * out by FinishAllFlows.
+ */
+class FlowMonitorStreamingTestCase : public TestCase
+{
+  public:
+    FlowMonitorStreamingTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+FlowMonitorStreamingTestCase::FlowMonitorStreamingTestCase()
+    : TestCase("FlowMonitor streams each flow as it finishes and then forgets it")
+{
+}
+
+void
+FlowMonitorStreamingTestCase::DoRun()
+{
+    NodeContainer nodes;
+    nodes.Create(2);
+    InternetStackHelper internet;
+    internet.Install(nodes);
+
+    SimpleNetDeviceHelper simpleHelper;
+    simpleHelper.SetNetDevicePointToPointMode(true);
+    simpleHelper.SetChannelAttribute("Delay", TimeValue(MicroSeconds(100)));
+    Ipv4AddressHelper ipv4;
+    ipv4.SetBase("10.1.1.0", "255.255.255.252");
+    Ipv4InterfaceContainer interfaces = ipv4.Assign(simpleHelper.Install(nodes));
+
+    FlowMonitorHelper flowmon;
+    Ptr<FlowMonitor> monitor = flowmon.InstallAll();
+    monitor->SetAttribute("FlowIdleTimeout", TimeValue(MilliSeconds(500)));
+    std::string fileName = CreateTempDirFilename("flow-monitor-streaming.csv");
+    flowmon.StreamLbPerformanceMetricsToFile(fileName);
+    Ptr<Ipv4FlowClassifier> classifier = DynamicCast<Ipv4FlowClassifier>(flowmon.GetClassifier());
+
+    Ptr<Socket> sink = Socket::CreateSocket(nodes.Get(1), UdpSocketFactory::GetTypeId());
+    sink->Bind(InetSocketAddress(Ipv4Address::GetAny(), 9));
+    Ptr<Socket> first = Socket::CreateSocket(nodes.Get(0), UdpSocketFactory::GetTypeId());
+    first->Bind(InetSocketAddress(Ipv4Address::GetAny(), 5000));
+    first->Connect(InetSocketAddress(interfaces.GetAddress(1), 9));
+    Ptr<Socket> second = Socket::CreateSocket(nodes.Get(0), UdpSocketFactory::GetTypeId());
+    second->Bind(InetSocketAddress(Ipv4Address::GetAny(), 5001));
+    second->Connect(InetSocketAddress(interfaces.GetAddress(1), 9));
+
+    Ipv4FlowClassifier::FiveTuple firstTuple = {interfaces.GetAddress(0),
+                                                interfaces.GetAddress(1),
+                                                17,
+                                                5000,
+                                                9};
+    Simulator::Schedule(Seconds(1), &SendPacket, first, 10);
+    Simulator::Schedule(Seconds(1), &SendPacket, second, 5);
+    Simulator::Schedule(MilliSeconds(1100), &FlowMonitorHelper::FinishFlow, &flowmon, firstTuple);
+    // the periodic check at 2 s finds the second flow idle, but not this one
+    Simulator::Schedule(MilliSeconds(1700), &SendPacket, first, 3);
+
+    Simulator::Stop(MilliSeconds(2500));
+    Simulator::Run();
+
+    std::string header;
+    CsvRows rows = ReadCsv(fileName, &header);
+    NS_TEST_ASSERT_MSG_EQ(header.substr(0, 34),
+                          "FlowId,SourceAddress,DestinationAd",
+                          "The file starts with the csv header");
+    NS_TEST_ASSERT_MSG_EQ(rows.size(), 2, "The finished flows are flushed by the periodic check");
+    NS_TEST_ASSERT_MSG_EQ(GetField(rows, 0, 16), "1", "A row has a field per column");
+    NS_TEST_ASSERT_MSG_EQ(GetField(rows, 0, 0), "1", "The flow finished explicitly comes first");
+    NS_TEST_ASSERT_MSG_EQ(GetField(rows, 0, 1), "10.1.1.1", "The row has the source address");
+    NS_TEST_ASSERT_MSG_EQ(GetField(rows, 0, 2), "10.1.1.2", "The row has the destination address");
+    NS_TEST_ASSERT_MSG_EQ(GetField(rows, 0, 11),
+                          "10",
+                          "All the packets sent before finishing are counted");
+    NS_TEST_ASSERT_MSG_EQ(GetField(rows, 0, 12), "10", "All the packets received are counted");
+    NS_TEST_ASSERT_MSG_EQ(GetField(rows, 1, 0), "2", "The idle flow comes next");
+    NS_TEST_ASSERT_MSG_EQ(GetField(rows, 1, 11), "5", "The idle flow sent 5 packets");
+    NS_TEST_ASSERT_MSG_EQ(GetField(rows, 1, 12), "5", "The idle flow received 5 packets");
+
+    FlowMonitor::FlowStatsContainer flowStats = monitor->GetFlowStats();
+    NS_TEST_ASSERT_MSG_EQ(flowStats.size(), 1, "The finished flows are forgotten");
+    NS_TEST_ASSERT_MSG_EQ(flowStats[3].txPackets,
+                          3,
+                          "A reused tuple gets a new FlowId, and its packets are counted");
+    NS_TEST_ASSERT_MSG_EQ(flowStats[3].rxPackets,
+                          3,
+                          "The packets of a reused tuple are not dropped");
+    for (Ptr<FlowProbe> probe : monitor->GetAllProbes())
+    {
+        FlowProbe::Stats probeStats = probe->GetStats();
+        NS_TEST_ASSERT_MSG_EQ((probeStats.find(1) == probeStats.end() &&
+                               probeStats.find(2) == probeStats.end()),
+                              true,
+                              "The probes forget the finished flows");
+    }
+    Ipv4FlowClassifier::FiveTuple tuple;
+    FlowId flowId = 0;
+    NS_TEST_ASSERT_MSG_EQ(classifier->LookupFlow(1, &tuple), false, "The classifier forgets");
+    NS_TEST_ASSERT_MSG_EQ(classifier->LookupFlow(2, &tuple), false, "The classifier forgets");
+    NS_TEST_ASSERT_MSG_EQ(classifier->LookupFlowId(firstTuple, &flowId), true, "Reused tuple");
+    NS_TEST_ASSERT_MSG_EQ(flowId, 3, "The tuple maps to the new flow");
+    NS_TEST_ASSERT_MSG_EQ(classifier->GetFiveTuples().size(), 1, "Only the new flow is kept");
+
+    // the binary format cannot be streamed, and holds the flows left
+    std::ostringstream binary;
+    monitor->LbPerformanceMetricsToBinaryStream(binary);
+    NS_TEST_ASSERT_MSG_EQ(ReadLittleEndian(binary.str(), 16, 8),
+                          1,
+                          "The binary format has only the flows not finished yet");
+
+    monitor->FinishAllFlows();
+    rows = ReadCsv(fileName, &header);
+    NS_TEST_ASSERT_MSG_EQ(rows.size(), 3, "FinishAllFlows writes out the flows left");
+    NS_TEST_ASSERT_MSG_EQ(GetField(rows, 2, 0),
+                          "3",
+                          "The new flow of the reused tuple is written out");
+    NS_TEST_ASSERT_MSG_EQ(GetField(rows, 2, 1), "10.1.1.1", "The row has the source address");
+    NS_TEST_ASSERT_MSG_EQ(GetField(rows, 2, 11), "3", "The new flow sent 3 packets");
+    NS_TEST_ASSERT_MSG_EQ(GetField(rows, 2, 12), "3", "The new flow received 3 packets");
+    NS_TEST_ASSERT_MSG_EQ(monitor->GetFlowStats().empty(), true, "Every flow is forgotten");
+
+    Simulator::Destroy();
+    std::remove(fileName.c_str());
+}
+
+/**
+ * \ingroup flow-monitor-test
+ *
+ * \brief Reads back the binary format of SerializeIpv4LbFlowStatsToBinaryStream.
+ *
+ * Two flows are written to a string, one with counters beyond 32 bits and
+ * one never received, whose duration is negative.  The magic, the header,
+ * the offset of each column and every value are checked against the
+ * documented layout.
+ */
+class Ipv4LbFlowStatsBinaryTestCase : public TestCase
+{
+  public:
+    Ipv4LbFlowStatsBinaryTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+Ipv4LbFlowStatsBinaryTestCase::Ipv4LbFlowStatsBinaryTestCase()
+    : TestCase("Binary LB performance metrics follow the documented layout")
+{
+}
+
+void
+Ipv4LbFlowStatsBinaryTestCase::DoRun()
+{
+    std::vector<FlowId> flowIds = {4, 9};
+    std::vector<Ipv4LbFlowStats> flowStats(2);
+    flowStats[0].sourceAddress = Ipv4Address("10.0.0.1");
+    flowStats[0].destinationAddress = Ipv4Address("10.0.1.2");
+    flowStats[0].timeFirstTxPacket = Seconds(1);
+    flowStats[0].timeLastTxPacket = MilliSeconds(1500);
+    flowStats[0].timeFirstRxPacket = MicroSeconds(1000100);
+    flowStats[0].timeLastRxPacket = Seconds(2);
+    flowStats[0].delaySum = MilliSeconds(3);
+    flowStats[0].jitterSum = NanoSeconds(1234);
+    flowStats[0].txBytes = 5000000000ULL;
+    flowStats[0].rxBytes = 4000000000ULL;
+    flowStats[0].txPackets = 1000;
+    flowStats[0].rxPackets = 990;
+    flowStats[0].delayCount = 124;
+    flowStats[0].samplingInterval = 8;
+    flowStats[1].sourceAddress = Ipv4Address("10.0.2.1");
+    flowStats[1].destinationAddress = Ipv4Address("10.0.0.2");
+    flowStats[1].timeFirstTxPacket = Seconds(3);
+    flowStats[1].timeLastTxPacket = MilliSeconds(3200);
+    flowStats[1].timeFirstRxPacket = Seconds(0);
+    flowStats[1].timeLastRxPacket = Seconds(0);
+    flowStats[1].delaySum = Seconds(0);
+    flowStats[1].jitterSum = Seconds(0);
+    flowStats[1].txBytes = 300;
+    flowStats[1].rxBytes = 0;
+    flowStats[1].txPackets = 3;
+    flowStats[1].rxPackets = 0;
+    flowStats[1].delayCount = 0;
+    flowStats[1].samplingInterval = 1;
+
+    std::ostringstream os;
+    SerializeIpv4LbFlowStatsToBinaryStream(os, flowIds, flowStats);
+    std::string bytes = os.str();
+
+    NS_TEST_ASSERT_MSG_EQ(bytes.substr(0, 8), std::string("NS3LBM\0\0", 8), "Magic");
+    NS_TEST_ASSERT_MSG_EQ(ReadLittleEndian(bytes, 8, 4), 1, "Format version");
+    NS_TEST_ASSERT_MSG_EQ(ReadLittleEndian(bytes, 12, 4), 17, "Number of columns");
+    NS_TEST_ASSERT_MSG_EQ(ReadLittleEndian(bytes, 16, 8), 2, "Number of rows");
+
+    /// A column of the binary format, with its value in each row
+    struct Column
+    {
+        const char* name;   //!< the name of the column
+        char kind;          //!< the type kind of the column
+        uint8_t size;       //!< the item size of the column
+        uint64_t values[2]; //!< the bits of the value of each row
+    };
+
+    double effectiveRate = 4000000000.0 * 8 / 1.0;
+    uint64_t effectiveRateBits;
+    std::memcpy(&effectiveRateBits, &effectiveRate, sizeof(effectiveRateBits));
+    double noRate = 0.0 * 8 / -3.0;
+    uint64_t noRateBits;
+    std::memcpy(&noRateBits, &noRate, sizeof(noRateBits));
+    const Column columns[] = {
+        {"FlowId", 'u', 4, {4, 9}},
+        {"SourceAddress", 'u', 4, {0x0a000001, 0x0a000201}},
+        {"DestinationAddress", 'u', 4, {0x0a000102, 0x0a000002}},
+        {"TimeFirstTxPacket", 'i', 8, {1000000000, 3000000000}},
+        {"TimeLastTxPacket", 'i', 8, {1500000000, 3200000000}},
+        {"TimeFirstRxPacket", 'i', 8, {1000100000, 0}},
+        {"TimeLastRxPacket", 'i', 8, {2000000000, 0}},
+        {"DelaySum", 'i', 8, {3000000, 0}},
+        {"JitterSum", 'i', 8, {1234, 0}},
+        {"TxBytes", 'u', 8, {5000000000ULL, 300}},
+        {"RxBytes", 'u', 8, {4000000000ULL, 0}},
+        {"TxPackets", 'u', 4, {1000, 3}},
+        {"RxPackets", 'u', 4, {990, 0}},
+        {"Duration", 'i', 8, {1000000000, static_cast<uint64_t>(-3000000000LL)}},
+        {"EffectiveRate", 'f', 8, {effectiveRateBits, noRateBits}},
+        {"DelayCount", 'u', 4, {124, 0}},
+        {"SamplingInterval", 'u', 4, {8, 1}},
+    };
+
+    uint64_t offset = 24;
+    for (const Column& column : columns)
+    {
+        uint16_t nameLength = std::strlen(column.name);
+        NS_TEST_ASSERT_MSG_EQ(bytes[offset], column.kind, "Kind of " << column.name);
+        NS_TEST_ASSERT_MSG_EQ(ReadLittleEndian(bytes, offset + 1, 1),
+                              column.size,
+                              "Item size of " << column.name);
+        NS_TEST_ASSERT_MSG_EQ(ReadLittleEndian(bytes, offset + 2, 2),
+                              nameLength,
+                              "Name length of " << column.name);
+        NS_TEST_ASSERT_MSG_EQ(bytes.substr(offset + 4, nameLength),
+                              column.name,
+                              "Name of " << column.name);
+        offset += 4 + nameLength;
+    }
+    NS_TEST_ASSERT_MSG_EQ(offset, 291, "The header takes 291 bytes");
+    NS_TEST_ASSERT_MSG_EQ(bytes.substr(offset, 5), std::string(5, '\0'), "The header is padded");
+    offset = RoundUpTo8(offset);
+
+    for (const Column& column : columns)
+    {
+        for (uint32_t row = 0; row < 2; row++)
+        {
+            NS_TEST_ASSERT_MSG_EQ(ReadLittleEndian(bytes, offset + row * column.size, column.size),
+                                  column.values[row],
+                                  "Row " << row << " of " << column.name);
+        }
+        offset += RoundUpTo8(2 * column.size);
+    }
+    NS_TEST_ASSERT_MSG_EQ(offset, 296 + 7 * 8 + 10 * 16, "The columns follow the header");
+    NS_TEST_ASSERT_MSG_EQ(bytes.size(), offset, "The last column ends the output");
+}
+
+/**
+ * \ingroup flow-monitor-test
+ *
+ * \brief Checks the flows and packets Ipv4FlowClassifier tells apart.
+ *
+ * TCP and UDP packets get the FlowId of their five-tuple, assigned from 1
+ * in order of appearance, and consecutive packet IDs; other protocols,
+ * fragments and truncated payloads are not classified.  The DSCP counts,
+ * the lookups, including of unknown and released flows, and the XML
+ * output, ordered by five-tuple, are checked along.
+ */
+class Ipv4FlowClassifierTestCase : public TestCase
+{
+  public:
+    Ipv4FlowClassifierTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+Ipv4FlowClassifierTestCase::Ipv4FlowClassifierTestCase()
+    : TestCase("Ipv4FlowClassifier assigns flows and packets by five-tuple")
+{
+}
+
+void
+Ipv4FlowClassifierTestCase::DoRun()
+{
+    Ptr<Ipv4FlowClassifier> classifier = Create<Ipv4FlowClassifier>();
+    Ipv4FlowClassifier::FiveTuple udp = {"10.0.0.2", "10.0.0.9", 17, 1000, 80};
+    Ipv4FlowClassifier::FiveTuple tcp = {"10.0.0.1", "10.0.0.9", 6, 1000, 80};
+    Ipv4FlowClassifier::FiveTuple otherPort = {"10.0.0.2", "10.0.0.9", 17, 1001, 80};
+    FlowId flowId = 0;
+    FlowPacketId packetId = 0;
+
+    NS_TEST_ASSERT_MSG_EQ(ClassifyPacket(classifier, udp, Ipv4Header::DSCP_EF, &flowId, &packetId),
+                          true,
+                          "UDP is classified");
+    NS_TEST_ASSERT_MSG_EQ(flowId, 1, "FlowIds start from 1");
+    NS_TEST_ASSERT_MSG_EQ(packetId, 0, "Packet IDs start from 0");
+    ClassifyPacket(classifier, tcp, Ipv4Header::DscpDefault, &flowId, &packetId);
+    NS_TEST_ASSERT_MSG_EQ(flowId, 2, "TCP is classified, as a new flow");
+    ClassifyPacket(classifier, udp, Ipv4Header::DSCP_AF11, &flowId, &packetId);
+    NS_TEST_ASSERT_MSG_EQ(flowId, 1, "A known tuple keeps its FlowId");
+    NS_TEST_ASSERT_MSG_EQ(packetId, 1, "Packet IDs are consecutive within a flow");
+    ClassifyPacket(classifier, otherPort, Ipv4Header::DscpDefault, &flowId, &packetId);
+    NS_TEST_ASSERT_MSG_EQ(flowId, 3, "A tuple differing in a port is a new flow");
+    NS_TEST_ASSERT_MSG_EQ(packetId, 0, "Packet IDs are counted per flow");
+    ClassifyPacket(classifier, udp, Ipv4Header::DSCP_EF, &flowId, &packetId);
+    NS_TEST_ASSERT_MSG_EQ(packetId, 2, "Packet IDs are consecutive within a flow");
+
+    Ipv4FlowClassifier::FiveTuple icmp = {"10.0.0.2", "10.0.0.9", 1, 1000, 80};
+    NS_TEST_ASSERT_MSG_EQ(
+        ClassifyPacket(classifier, icmp, Ipv4Header::DscpDefault, &flowId, &packetId),
+        false,
+        "Protocols other than TCP and UDP are not classified");
+    Ipv4Header fragmentHeader;
+    fragmentHeader.SetSource(udp.sourceAddress);
+    fragmentHeader.SetDestination(udp.destinationAddress);
+    fragmentHeader.SetProtocol(17);
+    fragmentHeader.SetFragmentOffset(64);
+    NS_TEST_ASSERT_MSG_EQ(
+        classifier->Classify(fragmentHeader, Create<Packet>(100), &flowId, &packetId),
+        false,
+        "Fragments past the first are not classified");
+    fragmentHeader.SetFragmentOffset(0);
+    NS_TEST_ASSERT_MSG_EQ(
+        classifier->Classify(fragmentHeader, Create<Packet>(3), &flowId, &packetId),
+        false,
+        "Payloads too short for the ports are not classified");
+
+    std::vector<std::pair<Ipv4Header::DscpType, uint32_t>> dscpCounts = {
+        {Ipv4Header::DSCP_EF, 2},
+        {Ipv4Header::DSCP_AF11, 1}};
+    NS_TEST_ASSERT_MSG_EQ((classifier->GetDscpCounts(1) == dscpCounts),
+                          true,
+                          "The packets of each DSCP value are counted, the most seen first");
+    NS_TEST_ASSERT_MSG_EQ(classifier->GetDscpCounts(2).size(), 1, "DSCP values are per flow");
+
+    Ipv4FlowClassifier::FiveTuple tuple;
+    NS_TEST_ASSERT_MSG_EQ(classifier->LookupFlow(0, &tuple), false, "FlowId 0 is never assigned");
+    NS_TEST_ASSERT_MSG_EQ(classifier->LookupFlow(4, &tuple), false, "FlowId 4 is not assigned");
+    NS_TEST_ASSERT_MSG_EQ(classifier->LookupFlow(2, &tuple), true, "FlowId 2 is assigned");
+    NS_TEST_ASSERT_MSG_EQ((tuple == tcp), true, "FlowId 2 is the TCP flow");
+    NS_TEST_ASSERT_MSG_EQ(classifier->LookupFlowId(otherPort, &flowId), true, "Known tuple");
+    NS_TEST_ASSERT_MSG_EQ(flowId, 3, "The tuple has its FlowId");
+    std::map<FlowId, Ipv4FlowClassifier::FiveTuple> fiveTuples = classifier->GetFiveTuples();
+    NS_TEST_ASSERT_MSG_EQ(fiveTuples.size(), 3, "Every flow has its tuple");
+    NS_TEST_ASSERT_MSG_EQ((fiveTuples[1] == udp && fiveTuples[2] == tcp &&
+                           fiveTuples[3] == otherPort),
+                          true,
+                          "Tuples are mapped by FlowId");
+
+    // the flows are listed by tuple, not by FlowId, with the DSCP values
+    // of each by value
+    std::ostringstream xml;
+    classifier->SerializeToXmlStream(xml, 0);
+    std::string flows = xml.str();
+    std::size_t tcpFlow = flows.find("<Flow flowId=\"2\" sourceAddress=\"10.0.0.1\"");
+    std::size_t udpFlow = flows.find("<Flow flowId=\"1\" sourceAddress=\"10.0.0.2\"");
+    std::size_t otherPortFlow = flows.find("<Flow flowId=\"3\"");
+    NS_TEST_ASSERT_MSG_NE(tcpFlow, std::string::npos, "Every flow is listed");
+    NS_TEST_ASSERT_MSG_NE(udpFlow, std::string::npos, "Every flow is listed");
+    NS_TEST_ASSERT_MSG_NE(otherPortFlow, std::string::npos, "Every flow is listed");
+    NS_TEST_ASSERT_MSG_LT(tcpFlow, udpFlow, "Flows are ordered by source address");
+    NS_TEST_ASSERT_MSG_LT(udpFlow, otherPortFlow, "Flows are ordered by source port");
+    std::size_t af11 = flows.find("<Dscp value=\"0xa\" packets=\"1\" />", udpFlow);
+    std::size_t ef = flows.find("<Dscp value=\"0x2e\" packets=\"2\" />", udpFlow);
+    NS_TEST_ASSERT_MSG_LT(af11, ef, "DSCP values are listed in increasing order");
+    NS_TEST_ASSERT_MSG_LT(ef, otherPortFlow, "DSCP values are listed in their flow");
+
+    // a released flow is forgotten, in the middle or at the front
+    classifier->ReleaseFlow(2);
+    NS_TEST_ASSERT_MSG_EQ(classifier->LookupFlow(2, &tuple), false, "A released flow is unknown");
+    NS_TEST_ASSERT_MSG_EQ(classifier->LookupFlowId(tcp, &flowId), false, "Its tuple too");
+    NS_TEST_ASSERT_MSG_EQ(classifier->LookupFlow(3, &tuple), true, "Later flows are kept");
+    ClassifyPacket(classifier, tcp, Ipv4Header::DscpDefault, &flowId, &packetId);
+    NS_TEST_ASSERT_MSG_EQ(flowId, 4, "A released tuple starts a new flow");
+    NS_TEST_ASSERT_MSG_EQ(packetId, 0, "A new flow starts from packet ID 0");
+    classifier->ReleaseFlow(1);
+    NS_TEST_ASSERT_MSG_EQ(classifier->LookupFlow(1, &tuple), false, "A released flow is unknown");
+    NS_TEST_ASSERT_MSG_EQ(classifier->LookupFlow(3, &tuple), true, "Later flows are kept");
+    NS_TEST_ASSERT_MSG_EQ((tuple == otherPort), true, "Later flows keep their tuple");
+    NS_TEST_ASSERT_MSG_EQ(classifier->GetDscpCounts(4).size(), 1, "Later flows keep their DSCP");
+    NS_TEST_ASSERT_MSG_EQ(classifier->GetFiveTuples().size(), 2, "Released flows are dropped");
+    xml.str("");
+    classifier->SerializeToXmlStream(xml, 0);
+    NS_TEST_ASSERT_MSG_EQ(xml.str().find("flowId=\"1\""),
+                          std::string::npos,
+                          "Released flows are not listed");
+    NS_TEST_ASSERT_MSG_NE(xml.str().find("flowId=\"4\""), std::string::npos, "New flows are");
+}
+
+/**
+ * \ingroup flow-monitor-test
+ *
+ * \brief TestSuite for module flow-monitor
+ */
+class FlowMonitorTestSuite : public TestSuite
+{
+  public:
+    FlowMonitorTestSuite();
+};
+
+FlowMonitorTestSuite::FlowMonitorTestSuite()
+    : TestSuite("flow-monitor", UNIT)
+{
+    AddTestCase(new FlowMonitorFidelityTestCase, TestCase::QUICK);
+    AddTestCase(new TrackedPacketTableTestCase, TestCase::QUICK);
+    AddTestCase(new FlowMonitorStreamingTestCase, TestCase::QUICK);
+    AddTestCase(new Ipv4LbFlowStatsBinaryTestCase, TestCase::QUICK);
+    AddTestCase(new Ipv4FlowClassifierTestCase, TestCase::QUICK);
+}
+
+/// Static variable for test initialization
+static FlowMonitorTestSuite g_flowMonitorTestSuite;
@@ -0,0 +1,128 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "ipv4-hermes-routing-helper.h"
+
+#include "ns3/channel.h"
+#include "ns3/global-router-interface.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/log.h"
+#include "ns3/net-device.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("Ipv4HermesRoutingHelper");
+
+Ipv4HermesRoutingHelper::Ipv4HermesRoutingHelper() {}
+
+Ipv4HermesRoutingHelper::Ipv4HermesRoutingHelper(
+	const Ipv4HermesRoutingHelper& o) {
+}
+
+Ipv4HermesRoutingHelper* Ipv4HermesRoutingHelper::Copy(void) const {
+	return new Ipv4HermesRoutingHelper(*this);
+}
+
+Ptr<Ipv4RoutingProtocol>
+Ipv4HermesRoutingHelper::Create(Ptr<Node> node) const {
+	NS_LOG_LOGIC("Adding GlobalRouter interface to node " << node->GetId());
+	Ptr<GlobalRouter> globalRouter = CreateObject<GlobalRouter>();
+	node->AggregateObject(globalRouter);
+
+	NS_LOG_LOGIC("Adding GlobalRouting interface " << node->GetId());
+	Ptr<Ipv4GlobalRouting> globalRouting = CreateObject<Ipv4GlobalRouting>();
+	globalRouter->SetRoutingProtocol(globalRouting);
+
+    Ptr<Ipv4HermesRouting> hermesRouting =
+      CreateObject<Ipv4HermesRouting>(globalRouting);
+	return hermesRouting;
+}
+
+void Ipv4HermesRoutingHelper::PopulateRoutingTables() {
+	GlobalRouteManager::BuildGlobalRoutingDatabase();
+	GlobalRouteManager::InitializeRoutes();
+}
+
+void Ipv4HermesRoutingHelper::RecomputeRoutingTables() {
+	GlobalRouteManager::DeleteGlobalRoutes();
+	GlobalRouteManager::BuildGlobalRoutingDatabase();
+	GlobalRouteManager::InitializeRoutes();
+}
+
+void Ipv4HermesRoutingHelper::UpdateRoutingTables() {
+	GlobalRouteManager::UpdateRoutes();
+}
+
+Ptr<Ipv4HermesRouting>
+Ipv4HermesRoutingHelper::GetHermesRouting(Ptr<Ipv4> ipv4) const {
+	Ptr<Ipv4RoutingProtocol> ipv4rp = ipv4->GetRoutingProtocol();
+	// If the routing protocol can be cast to Ipv4HermesRouting then return
+	// the cast.
+	if (DynamicCast<Ipv4HermesRouting>(ipv4rp)) {
+		return DynamicCast<Ipv4HermesRouting>(ipv4rp);
+	}
+	// If the routing protocol can be cast to Ipv4ListRouting then perform the
+	// cast and iterate through the list searching for a Ipv4HermesRouting.
+	if (DynamicCast<Ipv4ListRouting>(ipv4rp)) {
+		Ptr<Ipv4ListRouting> lrp = DynamicCast<Ipv4ListRouting>(ipv4rp);
+		int16_t priority;
+		for (uint32_t route_idx = 0;
+			 route_idx < lrp->GetNRoutingProtocols();
+			 route_idx++) {
+			Ptr<Ipv4RoutingProtocol> temp = lrp->GetRoutingProtocol(
+				route_idx, priority);
+		    if (DynamicCast<Ipv4HermesRouting>(temp)) {
+		    	return DynamicCast<Ipv4HermesRouting>(temp);
+		    }
+		}
+	}
+	return nullptr;
+}
+
+void Ipv4HermesRoutingHelper::AddLeaf(Ptr<Node> leaf,
+	                                  NodeContainer hosts) const {
+	// Every device of the leaf that does not lead to one of its hosts is an
+	// uplink.
+	uint32_t nUplinks = 0;
+	for (uint32_t i = 0; i < leaf->GetNDevices(); i++) {
+		Ptr<Channel> channel = leaf->GetDevice(i)->GetChannel();
+		if (channel == nullptr) {
+			continue;
+		}
+		bool toHost = false;
+		for (std::size_t j = 0; j < channel->GetNDevices(); j++) {
+			Ptr<Node> peer = channel->GetDevice(j)->GetNode();
+			for (NodeContainer::Iterator host = hosts.Begin();
+				 host != hosts.End(); ++host) {
+				toHost = toHost || *host == peer;
+			}
+		}
+		if (!toHost) {
+			nUplinks++;
+		}
+	}
+	NS_ASSERT_MSG(nUplinks > 0, "Leaf " << leaf->GetId() << " has no uplink");
+
+	for (NodeContainer::Iterator host = hosts.Begin(); host != hosts.End();
+		 ++host) {
+		Ptr<Ipv4HermesRouting> hostRouting =
+			GetHermesRouting((*host)->GetObject<Ipv4>());
+		NS_ASSERT_MSG(hostRouting, "Host " << (*host)->GetId()
+			<< " does not run Hermes routing");
+		hostRouting->SetPaths(nUplinks);
+	}
+}
+
+int64_t Ipv4HermesRoutingHelper::AssignStreams(NodeContainer c,
+	                                           int64_t stream) const {
+	int64_t currentStream = stream;
+	for (NodeContainer::Iterator i = c.Begin(); i != c.End(); ++i) {
+		Ptr<Ipv4> ipv4 = (*i)->GetObject<Ipv4>();
+		NS_ASSERT_MSG(ipv4, "Ipv4 not installed on node");
+		Ptr<Ipv4HermesRouting> hermesRouting = GetHermesRouting(ipv4);
+		if (hermesRouting) {
+			currentStream += hermesRouting->AssignStreams(currentStream);
+		}
+	}
+	return (currentStream - stream);
+}
+
+}  // namespace ns3
\ No newline at end of file
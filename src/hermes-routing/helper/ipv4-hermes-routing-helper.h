@@ -0,0 +1,100 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef IPV4_HERMES_ROUTING_HELPER_H
+#define IPV4_HERMES_ROUTING_HELPER_H
+
+#include "ns3/ipv4-hermes-routing.h"
+#include "ns3/ipv4-routing-helper.h"
+#include "ns3/node-container.h"
+
+namespace ns3 {
+
+class Ipv4HermesRoutingHelper : public Ipv4RoutingHelper {
+public:
+	/**
+	 * \brief Construct a HermesRoutingHelper to more easily manage
+	 * Hermes routing.
+	 */
+	Ipv4HermesRoutingHelper();
+
+	/**
+	 * \brief Construct a HermesRoutingHelper from another previously
+	 * initialized instance (Copy Constructor).
+	 * 
+	 * \param o object to be copied.
+	 */
+	Ipv4HermesRoutingHelper(const Ipv4HermesRoutingHelper& o);
+
+	// Delete assignment operator to avoid misuse.
+	Ipv4HermesRoutingHelper& operator=(
+		const Ipv4HermesRoutingHelper&) = delete;
+
+    /**
+     * \returns pointer to clone of this Ipv4HermesRoutingHelper.
+     */
+	Ipv4HermesRoutingHelper* Copy(void) const override;
+
+    /**
+     * \brief This method is called by ns3::InternetStackHelper::Install.
+     * 
+     * \param node The node on which the routing protocol will run.
+     * 
+     * \returns a newly-created routing protocol.
+     */
+	virtual Ptr<Ipv4RoutingProtocol> Create(Ptr<Node> node) const override;
+
+	/**
+	 * \brief Build a routing database and initialize the routing tables of
+	 * the nodes in the simulation. Makes all nodes in the simulation into
+	 * routers.
+	 */
+	static void PopulateRoutingTables();
+
+	/**
+	 * \brief Remove all routes that were previously installed in a prior call
+	 * to either PopulateRoutingTables() or RecomputeRoutingTables(), and add
+	 * a new set of routes.
+	 */
+	static void RecomputeRoutingTables();
+
+	/**
+	 * \brief Update the routes that were previously installed after links
+	 * went up or down, recomputing only the routes the changes affect. The
+	 * routes are the same as those of RecomputeRoutingTables().
+	 */
+	static void UpdateRoutingTables();
+
+    /**
+     * \brief Retrieve the Ipv4HermesRouting protocol attached to the helper.
+     * 
+     * \param ipv4 The Ptr<Ipv4> to search for the Hermes routing protocol.
+     * 
+     * \returns Ipv4HermesRouting pointer or nullptr if not found.
+     */
+	Ptr<Ipv4HermesRouting> GetHermesRouting(Ptr<Ipv4> ipv4) const;
+
+	/**
+	 * \brief Tells the hosts below a leaf how many paths they have to the
+	 * other leaves, the number of uplinks of the leaf.
+	 * 
+	 * Must be called after the links of the leaf have been installed.
+	 * 
+	 * \param leaf the leaf switch.
+	 * \param hosts the hosts attached to the leaf.
+	 */
+	void AddLeaf(Ptr<Node> leaf, NodeContainer hosts) const;
+
+	/**
+	 * Assign a fixed random variable stream number to the random variables
+	 * used by the Hermes routing protocols on a set of nodes.
+	 * 
+	 * \param c NodeContainer of the set of nodes.
+	 * \param stream first stream index to use.
+	 * 
+	 * \returns the number of stream indices assigned by this helper.
+	 */
+	int64_t AssignStreams(NodeContainer c, int64_t stream) const;
+};
+
+}  // namespace ns3
+
+#endif  // IPV4_HERMES_ROUTING_HELPER_H
\ No newline at end of file
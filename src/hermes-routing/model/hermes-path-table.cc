@@ -0,0 +1,107 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "hermes-path-table.h"
+
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("HermesPathTable");
+
+HermesPathTable::HermesPathTable() {}
+
+void HermesPathTable::Configure(uint32_t nPaths) {
+	NS_LOG_FUNCTION(this << nPaths);
+	NS_ASSERT_MSG(nPaths > 0, "Hermes needs at least one path");
+	m_paths.assign(nPaths, HermesPath());
+}
+
+uint32_t HermesPathTable::GetNPaths() const {
+	return m_paths.size();
+}
+
+const HermesPath& HermesPathTable::GetPath(uint32_t path) const {
+	return m_paths[path];
+}
+
+void HermesPathTable::RecordRtt(uint32_t path, Time rtt, double gain) {
+	HermesPath& state = m_paths[path];
+	if (!state.measured) {
+		state.rtt = rtt;
+		state.measured = true;
+		return;
+	}
+	state.rtt = Time::From((1 - gain) * state.rtt.GetDouble() +
+	                       gain * rtt.GetDouble());
+}
+
+void HermesPathTable::RecordEcn(uint32_t path, bool marked, double gain) {
+	HermesPath& state = m_paths[path];
+	state.ecnFraction = (1 - gain) * state.ecnFraction + (marked ? gain : 0);
+}
+
+HermesPathType HermesPathTable::Classify(
+	uint32_t path, const HermesThresholds& thresholds) const {
+	const HermesPath& state = m_paths[path];
+	if (!state.measured) {
+		return HERMES_PATH_GRAY;
+	}
+	if (state.ecnFraction < thresholds.ecnFraction &&
+		state.rtt < thresholds.rttLow) {
+		return HERMES_PATH_GOOD;
+	}
+	if (state.ecnFraction > thresholds.ecnFraction &&
+		state.rtt > thresholds.rttHigh) {
+		return HERMES_PATH_CONGESTED;
+	}
+	return HERMES_PATH_GRAY;
+}
+
+uint32_t HermesPathTable::ChooseBest(const HermesThresholds& thresholds,
+	                                 Ptr<UniformRandomVariable> rand) const {
+	uint32_t best = 0;
+	HermesPathType bestType = Classify(0, thresholds);
+	Time bestRtt = RankingRtt(0, thresholds);
+	uint32_t nTies = 1;
+	for (uint32_t path = 1; path < m_paths.size(); path++) {
+		HermesPathType type = Classify(path, thresholds);
+		Time rtt = RankingRtt(path, thresholds);
+		if (type < bestType || (type == bestType && rtt < bestRtt)) {
+			best = path;
+			bestType = type;
+			bestRtt = rtt;
+			nTies = 1;
+		} else if (type == bestType && rtt == bestRtt) {
+			// Keep each tied path with equal probability.
+			nTies++;
+			if (rand->GetInteger(0, nTies - 1) == 0) {
+				best = path;
+			}
+		}
+	}
+	return best;
+}
+
+bool HermesPathTable::IsNotablyBetter(
+	uint32_t current, uint32_t candidate,
+	const HermesThresholds& thresholds) const {
+	HermesPathType type = Classify(candidate, thresholds);
+	if (type == HERMES_PATH_GOOD) {
+		return true;
+	}
+	if (type != HERMES_PATH_GRAY || !m_paths[candidate].measured) {
+		return false;
+	}
+	const HermesPath& from = m_paths[current];
+	const HermesPath& to = m_paths[candidate];
+	return to.rtt + thresholds.deltaRtt < from.rtt &&
+		to.ecnFraction + thresholds.deltaEcnFraction < from.ecnFraction;
+}
+
+Time HermesPathTable::RankingRtt(uint32_t path,
+	                             const HermesThresholds& thresholds) const {
+	const HermesPath& state = m_paths[path];
+	return state.measured ? state.rtt : thresholds.rttLow;
+}
+
+}  // namespace ns3
@@ -0,0 +1,157 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef HERMES_PATH_TABLE_H
+#define HERMES_PATH_TABLE_H
+
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+#include "ns3/random-variable-stream.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup hermes-routing
+ *
+ * \brief The state of a path, from the RTT and ECN samples it produced.
+ */
+enum HermesPathType {
+	HERMES_PATH_GOOD = 0,
+	HERMES_PATH_GRAY = 1,
+	HERMES_PATH_CONGESTED = 2
+};
+
+/**
+ * \ingroup hermes-routing
+ *
+ * \brief The thresholds that tell the paths apart, shared by every path
+ * table of a host.
+ */
+struct HermesThresholds {
+	// Paths with a larger ECN fraction may be congested.
+	double ecnFraction = 0.4;
+	// Paths with a smaller RTT and ECN fraction are good.
+	Time rttLow;
+	// Paths with a larger RTT and ECN fraction are congested.
+	Time rttHigh;
+	// How much better a gray path must be than a congested one for a flow
+	// to move onto it.
+	Time deltaRtt;
+	double deltaEcnFraction = 0.05;
+	// The gain of the moving averages of the samples.
+	double gain = 0.125;
+};
+
+struct HermesPath {
+	// Moving average of the fraction of ECN marked samples.
+	double ecnFraction = 0;
+	// Moving average of the RTT samples.
+	Time rtt;
+	// Whether the path produced any RTT sample yet.
+	bool measured = false;
+};
+
+/**
+ * \ingroup hermes-routing
+ *
+ * \brief The paths from a host to one destination and what the host knows of
+ * them.
+ *
+ * The ECN fraction and RTT of each path are moving averages of the samples
+ * taken from the ACKs of the flows on the path and from probes. A path is
+ * good when both are below their thresholds, congested when both are above,
+ * and gray otherwise. A path without RTT samples is gray, so that unexplored
+ * paths rank below the paths known to be good.
+ */
+class HermesPathTable {
+public:
+	HermesPathTable();
+
+	/**
+	 * \brief Sets the number of paths, forgetting every sample.
+	 *
+	 * \param nPaths the number of paths.
+	 */
+	void Configure(uint32_t nPaths);
+
+	/**
+	 * \returns the number of paths.
+	 */
+	uint32_t GetNPaths() const;
+
+	/**
+	 * \param path the path index.
+	 * \returns the state of the path.
+	 */
+	const HermesPath& GetPath(uint32_t path) const;
+
+	/**
+	 * \brief Adds an RTT sample of a path.
+	 *
+	 * \param path the path index.
+	 * \param rtt the sample.
+	 * \param gain the gain of the moving average.
+	 */
+	void RecordRtt(uint32_t path, Time rtt, double gain);
+
+	/**
+	 * \brief Adds an ECN sample of a path.
+	 *
+	 * \param path the path index.
+	 * \param marked whether the sample was marked.
+	 * \param gain the gain of the moving average.
+	 */
+	void RecordEcn(uint32_t path, bool marked, double gain);
+
+	/**
+	 * \param path the path index.
+	 * \param thresholds the thresholds of the path types.
+	 * \returns the type of the path.
+	 */
+	HermesPathType Classify(uint32_t path,
+	                        const HermesThresholds& thresholds) const;
+
+	/**
+	 * \brief Picks the path for a new flow or flowlet.
+	 *
+	 * Good paths are preferred to gray paths and gray paths to congested
+	 * ones. Among paths of the same type the one with the smallest RTT wins,
+	 * and ties are broken at random.
+	 *
+	 * \param thresholds the thresholds of the path types.
+	 * \param rand the random variable that breaks ties.
+	 * \returns the path index.
+	 */
+	uint32_t ChooseBest(const HermesThresholds& thresholds,
+	                    Ptr<UniformRandomVariable> rand) const;
+
+	/**
+	 * \brief Tells whether a flow on a congested path should move to another
+	 * path.
+	 *
+	 * The candidate must be good, or gray with an RTT and ECN fraction
+	 * smaller than those of the current path by at least the deltas of the
+	 * thresholds.
+	 *
+	 * \param current the path of the flow.
+	 * \param candidate the path the flow would move to.
+	 * \param thresholds the thresholds of the path types.
+	 * \returns true if the flow should move.
+	 */
+	bool IsNotablyBetter(uint32_t current, uint32_t candidate,
+	                     const HermesThresholds& thresholds) const;
+
+private:
+	/**
+	 * \returns the RTT that ranks a path, the RTT low threshold for paths
+	 * without samples.
+	 */
+	Time RankingRtt(uint32_t path, const HermesThresholds& thresholds) const;
+
+	std::vector<HermesPath> m_paths;
+};
+
+}  // namespace ns3
+
+#endif  // HERMES_PATH_TABLE_H
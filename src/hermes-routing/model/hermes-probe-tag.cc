@@ -0,0 +1,66 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "hermes-probe-tag.h"
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED(HermesProbeTag);
+
+HermesProbeTag::HermesProbeTag()
+	: m_reply(0),
+	  m_pathId(0),
+	  m_sendTime(0),
+	  m_ecnMarked(0) {}
+
+void HermesProbeTag::SetReply(bool reply) { m_reply = reply; }
+
+bool HermesProbeTag::IsReply() const { return m_reply; }
+
+void HermesProbeTag::SetPathId(uint32_t pathId) { m_pathId = pathId; }
+
+uint32_t HermesProbeTag::GetPathId() const { return m_pathId; }
+
+void HermesProbeTag::SetSendTime(Time sendTime) {
+	m_sendTime = sendTime.GetTimeStep();
+}
+
+Time HermesProbeTag::GetSendTime() const { return TimeStep(m_sendTime); }
+
+void HermesProbeTag::SetEcnMarked(bool ecnMarked) { m_ecnMarked = ecnMarked; }
+
+bool HermesProbeTag::IsEcnMarked() const { return m_ecnMarked; }
+
+TypeId HermesProbeTag::GetTypeId() {
+	static TypeId tid = TypeId("ns3::HermesProbeTag")
+	  .SetParent<Tag>()
+	  .SetGroupName("HermesRouting")
+	  .AddConstructor<HermesProbeTag>();
+
+	return tid;
+}
+
+TypeId HermesProbeTag::GetInstanceTypeId() const { return GetTypeId(); }
+
+uint32_t HermesProbeTag::GetSerializedSize() const { return 14; }
+
+void HermesProbeTag::Serialize(TagBuffer i) const {
+	i.WriteU8(m_reply);
+	i.WriteU32(m_pathId);
+	i.WriteU64(m_sendTime);
+	i.WriteU8(m_ecnMarked);
+}
+
+void HermesProbeTag::Deserialize(TagBuffer i) {
+	m_reply = i.ReadU8();
+	m_pathId = i.ReadU32();
+	m_sendTime = i.ReadU64();
+	m_ecnMarked = i.ReadU8();
+}
+
+void HermesProbeTag::Print(std::ostream &os) const {
+	os << (m_reply ? "Reply" : "Probe")
+	   << " Path=" << m_pathId
+	   << " SendTime=" << TimeStep(m_sendTime).As(Time::US)
+	   << " ECN=" << static_cast<uint32_t>(m_ecnMarked);
+}
+
+}  // namespace ns3
@@ -0,0 +1,56 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef HERMES_PROBE_TAG_H
+#define HERMES_PROBE_TAG_H
+
+#include "ns3/nstime.h"
+#include "ns3/tag.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup hermes-routing
+ *
+ * \brief The header of a Hermes probe or probe reply, carried as a packet
+ * tag.
+ *
+ * A host probes a path by sending a probe to a host below the destination
+ * leaf on that path. The receiving host sends back a reply with the same
+ * path and send time, and whether the probe was ECN marked on the way, so
+ * the prober learns the RTT and congestion of the path.
+ */
+class HermesProbeTag : public Tag {
+public:
+	HermesProbeTag();
+
+	void SetReply(bool reply);
+	bool IsReply() const;
+
+	void SetPathId(uint32_t pathId);
+	uint32_t GetPathId() const;
+
+	void SetSendTime(Time sendTime);
+	Time GetSendTime() const;
+
+	void SetEcnMarked(bool ecnMarked);
+	bool IsEcnMarked() const;
+
+	static TypeId GetTypeId();
+	virtual TypeId GetInstanceTypeId() const;
+
+	virtual uint32_t GetSerializedSize() const;
+
+	virtual void Serialize(TagBuffer i) const;
+	virtual void Deserialize(TagBuffer i);
+
+	virtual void Print(std::ostream& os) const;
+
+private:
+	uint8_t m_reply;
+	uint32_t m_pathId;
+	int64_t m_sendTime;
+	uint8_t m_ecnMarked;
+};
+
+}  // namespace ns3
+
+#endif  // HERMES_PROBE_TAG_H
@@ -0,0 +1,542 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "ipv4-hermes-routing.h"
+
+#include "ns3/double.h"
+#include "ns3/flow-key-tag.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/ipv4-xpath-tag.h"
+#include "ns3/log.h"
+#include "ns3/net-device.h"
+#include "ns3/node.h"
+#include "ns3/object.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/socket.h"
+#include "ns3/tcp-l4-protocol.h"
+#include "ns3/uinteger.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("Ipv4HermesRouting");
+
+NS_OBJECT_ENSURE_REGISTERED(Ipv4HermesRouting);
+
+TypeId Ipv4HermesRouting::GetTypeId(void) {
+	static TypeId tid = TypeId("ns3::Ipv4HermesRouting")
+	    .SetParent<Object>()
+	    .SetGroupName("HermesRouting")
+	    .AddAttribute("Paths",
+	                  "The number of paths to every destination",
+	                  UintegerValue(4),
+	                  MakeUintegerAccessor(&Ipv4HermesRouting::SetPaths,
+	                                       &Ipv4HermesRouting::GetPaths),
+	                  MakeUintegerChecker<uint32_t>(1))
+	    .AddAttribute("EcnThreshold",
+	                  "The ECN fraction above which a path may be congested",
+	                  DoubleValue(0.4),
+	                  MakeDoubleAccessor(&Ipv4HermesRouting::m_ecnThreshold),
+	                  MakeDoubleChecker<double>(0, 1))
+	    .AddAttribute("RttLow",
+	                  "The RTT below which a path may be good",
+	                  TimeValue(MicroSeconds(100)),
+	                  MakeTimeAccessor(&Ipv4HermesRouting::m_rttLow),
+	                  MakeTimeChecker())
+	    .AddAttribute("RttHigh",
+	                  "The RTT above which a path may be congested",
+	                  TimeValue(MicroSeconds(150)),
+	                  MakeTimeAccessor(&Ipv4HermesRouting::m_rttHigh),
+	                  MakeTimeChecker())
+	    .AddAttribute("DeltaRtt",
+	                  "How much smaller the RTT of a gray path must be for a "
+	                  "flow to leave a congested path for it",
+	                  TimeValue(MicroSeconds(20)),
+	                  MakeTimeAccessor(&Ipv4HermesRouting::m_deltaRtt),
+	                  MakeTimeChecker())
+	    .AddAttribute("DeltaEcnThreshold",
+	                  "How much smaller the ECN fraction of a gray path must "
+	                  "be for a flow to leave a congested path for it",
+	                  DoubleValue(0.05),
+	                  MakeDoubleAccessor(
+	                      &Ipv4HermesRouting::m_deltaEcnThreshold),
+	                  MakeDoubleChecker<double>(0, 1))
+	    .AddAttribute("Gain",
+	                  "The gain of the moving averages of the RTT and ECN "
+	                  "samples of each path",
+	                  DoubleValue(0.125),
+	                  MakeDoubleAccessor(&Ipv4HermesRouting::m_gain),
+	                  MakeDoubleChecker<double>(0, 1))
+	    .AddAttribute("FlowletTimeout",
+	                  "The gap after which the packets of a flow start a new "
+	                  "flowlet that may take another path",
+	                  TimeValue(MicroSeconds(150)),
+	                  MakeTimeAccessor(&Ipv4HermesRouting::m_flowletTimeout),
+	                  MakeTimeChecker())
+	    .AddAttribute("RerouteSize",
+	                  "The number of bytes a flow must have sent before it "
+	                  "may leave a congested path",
+	                  UintegerValue(100000),
+	                  MakeUintegerAccessor(&Ipv4HermesRouting::m_rerouteSize),
+	                  MakeUintegerChecker<uint32_t>())
+	    .AddAttribute("RerouteRate",
+	                  "The sending rate below which a flow may leave a "
+	                  "congested path",
+	                  DataRateValue(DataRate("3Gbps")),
+	                  MakeDataRateAccessor(&Ipv4HermesRouting::m_rerouteRate),
+	                  MakeDataRateChecker())
+	    .AddAttribute("ProbeInterval",
+	                  "The time between two rounds of probes, zero to disable "
+	                  "probing",
+	                  TimeValue(MicroSeconds(500)),
+	                  MakeTimeAccessor(&Ipv4HermesRouting::m_probeInterval),
+	                  MakeTimeChecker())
+	    .AddAttribute("IdleTimeout",
+	                  "The time after which a flow that sent nothing is "
+	                  "forgotten and its destination is no longer probed",
+	                  TimeValue(MilliSeconds(10)),
+	                  MakeTimeAccessor(&Ipv4HermesRouting::m_idleTimeout),
+	                  MakeTimeChecker());
+	return tid;
+}
+
+Ipv4HermesRouting::Ipv4HermesRouting(Ptr<Ipv4GlobalRouting> globalRouting)
+	: m_nPaths(4),
+	  m_ecnThreshold(0.4),
+	  m_rttLow(MicroSeconds(100)),
+	  m_rttHigh(MicroSeconds(150)),
+	  m_deltaRtt(MicroSeconds(20)),
+	  m_deltaEcnThreshold(0.05),
+	  m_gain(0.125),
+	  m_flowletTimeout(MicroSeconds(150)),
+	  m_rerouteSize(100000),
+	  m_rerouteRate("3Gbps"),
+	  m_probeInterval(MicroSeconds(500)),
+	  m_idleTimeout(MilliSeconds(10)),
+	  m_ipv4(nullptr),
+	  m_tcpConnected(false),
+	  m_reroutes(0),
+	  m_probesSent(0),
+	  m_globalRouting(globalRouting) {
+	NS_LOG_FUNCTION(this);
+	m_rand = CreateObject<UniformRandomVariable>();
+}
+
+Ipv4HermesRouting::~Ipv4HermesRouting() {
+	NS_LOG_FUNCTION(this);
+}
+
+Ptr<Ipv4Route> Ipv4HermesRouting::RouteOutput(Ptr<Packet> p,
+	                                          const Ipv4Header& header,
+	                                          Ptr<NetDevice> oif,
+	                                          Socket::SocketErrno& sockerr) {
+	NS_LOG_FUNCTION(this << p << &header << oif << &sockerr);
+	Ptr<Ipv4Route> route =
+		m_globalRouting->RouteOutput(p, header, oif, sockerr);
+	if (route == nullptr || p == nullptr ||
+		header.GetDestination().IsMulticast() ||
+		header.GetDestination().IsBroadcast()) {
+		return route;
+	}
+	if (!m_tcpConnected) {
+		Ptr<TcpL4Protocol> tcp = m_ipv4->GetObject<TcpL4Protocol>();
+		if (tcp != nullptr) {
+			tcp->TraceConnectWithoutContext(
+				"AckReceived",
+				MakeCallback(&Ipv4HermesRouting::AckReceived, this));
+			m_tcpConnected = true;
+		}
+	}
+
+	uint64_t flowKey = FlowKeyTag::ExtractFlowKey(p);
+	if (flowKey == 0) {
+		return route;
+	}
+	Ipv4XPathTag xpathTag;
+	xpathTag.SetPathId(
+		ChoosePath(flowKey, header.GetDestination(), p->GetSize()));
+	p->ReplacePacketTag(xpathTag);
+	return route;
+}
+
+bool Ipv4HermesRouting::RouteInput(Ptr<const Packet> p,
+	                               const Ipv4Header& header,
+	                               Ptr<const NetDevice> idev,
+	                               UnicastForwardCallback ucb,
+	                               MulticastForwardCallback mcb,
+	                               LocalDeliverCallback lcb,
+	                               ErrorCallback ecb) {
+	NS_LOG_LOGIC(this << " Route Input: " << p << " IP header: " << header);
+	uint32_t iif = m_ipv4->GetInterfaceForDevice(idev);
+
+	// Check if it this is the intended destination. If so then we call the
+	// local callback (lcb) to push it up the stack.
+	if (m_ipv4->IsDestinationAddress(header.GetDestination(), iif)) {
+		HermesProbeTag probeTag;
+		if (header.GetProtocol() == PROBE_PROTOCOL &&
+			p->PeekPacketTag(probeTag)) {
+			ReceiveProbe(probeTag, header);
+			return true;
+		}
+		if (lcb.IsNull()) {
+			// The local delivery callback is null. This may be a multicast
+			// or broadcast packet, so return false so that another
+			// multicast routing protocol can handle it.
+			return false;
+		}
+		NS_LOG_LOGIC("Local delivery to " << header.GetDestination());
+		lcb(p, header, iif);
+		return true;
+	}
+
+	// Hermes routing only supports unicast.
+	if (header.GetDestination().IsMulticast() ||
+		header.GetDestination().IsBroadcast()) {
+		NS_LOG_ERROR(this << " Hermes routing only supports unicast");
+		ecb(p, header, Socket::ERROR_NOROUTETOHOST);
+		return false;
+	}
+
+	// Check if the input device supports IP forwarding.
+	if (m_ipv4->IsForwarding(iif) == false) {
+		NS_LOG_ERROR(this << " Forwarding is disabled for this interface");
+		ecb(p, header, Socket::ERROR_NOROUTETOHOST);
+		return false;
+	}
+
+	const Ipv4GlobalRouting::RouteGroup& routeEntries =
+		m_globalRouting->GetRoutesToDst(header.GetDestination());
+	if (routeEntries.empty()) {
+		NS_LOG_ERROR(this << " Hermes routing cannot find routing entry");
+		ecb(p, header, Socket::ERROR_NOROUTETOHOST);
+		return false;
+	}
+
+	// Follow the path the host chose. Untagged packets are hashed on their
+	// flow, or sprayed if they have none.
+	uint32_t pathIndex = 0;
+	Ipv4XPathTag xpathTag;
+	if (p->PeekPacketTag(xpathTag)) {
+		pathIndex = xpathTag.GetPathId() % routeEntries.size();
+	} else {
+		uint64_t flowKey = FlowKeyTag::ExtractFlowKey(p);
+		pathIndex = flowKey != 0
+			? flowKey % routeEntries.size()
+			: m_rand->GetInteger(0, routeEntries.size() - 1);
+	}
+	ucb(ConstructIpv4Route(routeEntries[pathIndex], header.GetDestination()),
+		p, header);
+	return true;
+}
+
+uint32_t Ipv4HermesRouting::ChoosePath(uint64_t flowKey, Ipv4Address dst,
+	                                   uint32_t size) {
+	Time now = Simulator::Now();
+	if (now - m_lastFlowSweep > m_idleTimeout) {
+		ForgetIdleFlows();
+	}
+	Destination& destination = GetDestination(dst);
+	destination.activeTime = now;
+	if (!m_probeEvent.IsRunning() && m_probeInterval.IsStrictlyPositive()) {
+		m_probeEvent = Simulator::Schedule(
+			m_probeInterval, &Ipv4HermesRouting::Probe, this);
+	}
+
+	auto flowItr = m_flows.find(flowKey);
+	if (flowItr == m_flows.end()) {
+		// New flows take the best path.
+		Flow& flow = m_flows[flowKey];
+		flow.dst = dst.Get();
+		flow.path = destination.paths.ChooseBest(m_thresholds, m_rand);
+		flow.startTime = now;
+		flow.bytesSent = size;
+		flow.lastSendTime = now;
+		NS_LOG_LOGIC(this << " New flow " << flowKey << " to " << dst
+			<< " on path " << flow.path);
+		return flow.path;
+	}
+
+	Flow& flow = flowItr->second;
+	uint32_t path = flow.path;
+	if (now - flow.lastSendTime > m_flowletTimeout) {
+		// So do new flowlets, which cannot be reordered with the packets
+		// before them.
+		path = destination.paths.ChooseBest(m_thresholds, m_rand);
+	} else if (destination.paths.Classify(flow.path, m_thresholds) ==
+	           HERMES_PATH_CONGESTED && flow.bytesSent > m_rerouteSize) {
+		// A flow that has sent enough to tell, yet sends slowly, is
+		// suffering from the congestion of its path rather than causing it.
+		double duration = (now - flow.startTime).GetSeconds();
+		if (duration > 0 &&
+			flow.bytesSent * 8 / duration < m_rerouteRate.GetBitRate()) {
+			uint32_t best = destination.paths.ChooseBest(m_thresholds, m_rand);
+			if (destination.paths.IsNotablyBetter(flow.path, best,
+				                                  m_thresholds)) {
+				path = best;
+			}
+		}
+	}
+	if (path != flow.path) {
+		NS_LOG_LOGIC(this << " Flow " << flowKey << " moves from path "
+			<< flow.path << " to path " << path);
+		flow.path = path;
+		m_reroutes++;
+	}
+	flow.bytesSent += size;
+	flow.lastSendTime = now;
+	return flow.path;
+}
+
+Ipv4HermesRouting::Destination&
+Ipv4HermesRouting::GetDestination(Ipv4Address dst) {
+	auto destinationItr = m_destinations.find(dst.Get());
+	if (destinationItr != m_destinations.end()) {
+		return destinationItr->second;
+	}
+	Destination& destination = m_destinations[dst.Get()];
+	destination.address = dst;
+	destination.paths.Configure(m_nPaths);
+	return destination;
+}
+
+void Ipv4HermesRouting::AckReceived(uint64_t flowKey, uint32_t bytesAcked,
+	                                bool ecnEcho, Time rtt) {
+	auto flowItr = m_flows.find(flowKey);
+	if (flowItr == m_flows.end()) {
+		return;
+	}
+	const Flow& flow = flowItr->second;
+	auto destinationItr = m_destinations.find(flow.dst);
+	if (destinationItr == m_destinations.end()) {
+		return;
+	}
+	HermesPathTable& paths = destinationItr->second.paths;
+	paths.RecordEcn(flow.path, ecnEcho, m_thresholds.gain);
+	if (rtt.IsStrictlyPositive()) {
+		paths.RecordRtt(flow.path, rtt, m_thresholds.gain);
+	}
+}
+
+void Ipv4HermesRouting::Probe() {
+	NS_LOG_FUNCTION(this);
+	Time now = Simulator::Now();
+	bool active = false;
+	for (auto& destinationItr : m_destinations) {
+		Destination& destination = destinationItr.second;
+		if (now - destination.activeTime > m_idleTimeout) {
+			continue;
+		}
+		active = true;
+		// Probe the best path known and two random ones, the power of two
+		// choices.
+		uint32_t best = destination.paths.ChooseBest(m_thresholds, m_rand);
+		uint32_t paths[] = {
+			best,
+			m_rand->GetInteger(0, m_nPaths - 1),
+			m_rand->GetInteger(0, m_nPaths - 1)};
+		for (uint32_t i = 0; i < 3; i++) {
+			if ((i > 0 && paths[i] == paths[0]) ||
+				(i > 1 && paths[i] == paths[1])) {
+				continue;
+			}
+			HermesProbeTag probeTag;
+			probeTag.SetPathId(paths[i]);
+			probeTag.SetSendTime(now);
+			SendProbe(destination.address, probeTag, true);
+			m_probesSent++;
+		}
+	}
+	// Stop probing until packets are sent again.
+	if (active) {
+		m_probeEvent = Simulator::Schedule(
+			m_probeInterval, &Ipv4HermesRouting::Probe, this);
+	}
+}
+
+void Ipv4HermesRouting::SendProbe(Ipv4Address dst, const HermesProbeTag& tag,
+	                              bool tagPath) {
+	Ptr<Packet> packet = Create<Packet>();
+	packet->AddPacketTag(tag);
+	Ipv4Header header;
+	header.SetDestination(dst);
+	header.SetProtocol(PROBE_PROTOCOL);
+	Socket::SocketErrno sockerr;
+	Ptr<Ipv4Route> route =
+		m_globalRouting->RouteOutput(packet, header, nullptr, sockerr);
+	if (route == nullptr) {
+		NS_LOG_LOGIC(this << " No route to probe " << dst);
+		return;
+	}
+	if (tagPath) {
+		Ipv4XPathTag xpathTag;
+		xpathTag.SetPathId(tag.GetPathId());
+		packet->AddPacketTag(xpathTag);
+		// Probes are ECN capable so that they see the marks of the path.
+		SocketIpTosTag tosTag;
+		tosTag.SetTos(Ipv4Header::ECN_ECT0);
+		packet->AddPacketTag(tosTag);
+	}
+	m_ipv4->Send(packet, route->GetSource(), dst, PROBE_PROTOCOL, route);
+}
+
+void Ipv4HermesRouting::ReceiveProbe(const HermesProbeTag& tag,
+	                                 const Ipv4Header& header) {
+	NS_LOG_FUNCTION(this << header);
+	if (!tag.IsReply()) {
+		HermesProbeTag replyTag = tag;
+		replyTag.SetReply(true);
+		replyTag.SetEcnMarked(header.GetEcn() == Ipv4Header::ECN_CE);
+		SendProbe(header.GetSource(), replyTag, false);
+		return;
+	}
+	auto destinationItr = m_destinations.find(header.GetSource().Get());
+	if (destinationItr == m_destinations.end() ||
+		tag.GetPathId() >= m_nPaths) {
+		return;
+	}
+	destinationItr->second.probeTime = Simulator::Now();
+	HermesPathTable& paths = destinationItr->second.paths;
+	paths.RecordRtt(tag.GetPathId(), Simulator::Now() - tag.GetSendTime(),
+		            m_thresholds.gain);
+	paths.RecordEcn(tag.GetPathId(), tag.IsEcnMarked(), m_thresholds.gain);
+}
+
+void Ipv4HermesRouting::ForgetIdleFlows() {
+	Time now = Simulator::Now();
+	for (auto flowItr = m_flows.begin(); flowItr != m_flows.end();) {
+		if (now - flowItr->second.lastSendTime > m_idleTimeout) {
+			flowItr = m_flows.erase(flowItr);
+		} else {
+			++flowItr;
+		}
+	}
+	// The flows to a destination sent no later than its activeTime, so an
+	// idle destination has no flow left, and only its probes can keep it.
+	for (auto destinationItr = m_destinations.begin();
+		 destinationItr != m_destinations.end();) {
+		const Destination& destination = destinationItr->second;
+		if (now - destination.activeTime > m_idleTimeout &&
+			now - destination.probeTime > m_idleTimeout) {
+			destinationItr = m_destinations.erase(destinationItr);
+		} else {
+			++destinationItr;
+		}
+	}
+	m_lastFlowSweep = now;
+}
+
+void Ipv4HermesRouting::SetPaths(uint32_t nPaths) {
+	NS_LOG_FUNCTION(this << nPaths);
+	m_nPaths = nPaths;
+	m_flows.clear();
+	m_destinations.clear();
+}
+
+uint32_t Ipv4HermesRouting::GetPaths() const {
+	return m_nPaths;
+}
+
+const HermesPathTable* Ipv4HermesRouting::GetPathTable(
+	Ipv4Address dst) const {
+	auto destinationItr = m_destinations.find(dst.Get());
+	if (destinationItr == m_destinations.end()) {
+		return nullptr;
+	}
+	return &destinationItr->second.paths;
+}
+
+void Ipv4HermesRouting::NotifyInterfaceUp(uint32_t interface) {
+	m_routeCache.clear();
+	m_globalRouting->NotifyInterfaceUp(interface);
+}
+
+void Ipv4HermesRouting::NotifyInterfaceDown(uint32_t interface) {
+	m_routeCache.clear();
+	m_globalRouting->NotifyInterfaceDown(interface);
+}
+
+void Ipv4HermesRouting::NotifyAddAddress(
+	uint32_t interface, Ipv4InterfaceAddress address) {
+	m_routeCache.clear();
+	m_globalRouting->NotifyAddAddress(interface, address);
+}
+
+void Ipv4HermesRouting::NotifyRemoveAddress(
+	uint32_t interface, Ipv4InterfaceAddress address) {
+	m_routeCache.clear();
+	m_globalRouting->NotifyRemoveAddress(interface, address);
+}
+
+void Ipv4HermesRouting::SetIpv4(Ptr<Ipv4> ipv4) {
+	NS_LOG_LOGIC(this << " Setting up IPv4: " << ipv4);
+	NS_ASSERT(m_ipv4 == nullptr && ipv4 != nullptr);
+	m_ipv4 = ipv4;
+	m_globalRouting->SetIpv4(ipv4);
+	// Attributes are set by now.
+	m_thresholds.ecnFraction = m_ecnThreshold;
+	m_thresholds.rttLow = m_rttLow;
+	m_thresholds.rttHigh = m_rttHigh;
+	m_thresholds.deltaRtt = m_deltaRtt;
+	m_thresholds.deltaEcnFraction = m_deltaEcnThreshold;
+	m_thresholds.gain = m_gain;
+}
+
+void Ipv4HermesRouting::PrintRoutingTable(Ptr<OutputStreamWrapper> stream,
+	                                      Time::Unit unit) const {
+	m_globalRouting->PrintRoutingTable(stream, unit);
+}
+
+void Ipv4HermesRouting::DoDispose(void) {
+	NS_LOG_FUNCTION(this);
+	m_probeEvent.Cancel();
+	m_flows.clear();
+	m_destinations.clear();
+	m_routeCache.clear();
+	m_ipv4 = nullptr;
+	m_globalRouting->DoDispose();
+	m_globalRouting = nullptr;
+}
+
+uint32_t Ipv4HermesRouting::GetNRoutes() const {
+	NS_LOG_FUNCTION(this);
+	return m_globalRouting->GetNRoutes();
+}
+
+Ipv4RoutingTableEntry* Ipv4HermesRouting::GetRoute(uint32_t i) const {
+	NS_LOG_FUNCTION(this << " " << i);
+	return m_globalRouting->GetRoute(i);
+}
+
+uint64_t Ipv4HermesRouting::GetReroutes() const {
+	return m_reroutes;
+}
+
+uint64_t Ipv4HermesRouting::GetProbesSent() const {
+	return m_probesSent;
+}
+
+int64_t Ipv4HermesRouting::AssignStreams(int64_t stream) {
+	NS_LOG_FUNCTION(this << stream);
+	m_rand->SetStream(stream);
+	return 1;
+}
+
+Ptr<Ipv4Route>
+Ipv4HermesRouting::ConstructIpv4Route(const Ipv4RoutingTableEntry* entry,
+	                                  Ipv4Address dstAddr) {
+	uint32_t port = entry->GetInterface();
+	uint64_t cacheKey = (static_cast<uint64_t>(port) << 32) | dstAddr.Get();
+	auto cacheItr = m_routeCache.find(cacheKey);
+	if (cacheItr != m_routeCache.end()) {
+		return cacheItr->second;
+	}
+
+	Ptr<Ipv4Route> route = Create<Ipv4Route>();
+	route->SetOutputDevice(m_ipv4->GetNetDevice(port));
+	route->SetGateway(entry->GetGateway());
+	route->SetSource(m_ipv4->GetAddress(port, 0).GetLocal());
+	route->SetDestination(dstAddr);
+	m_routeCache[cacheKey] = route;
+	return route;
+}
+
+}  // namespace ns3
@@ -0,0 +1,280 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef IPV4_HERMES_ROUTING_H
+#define IPV4_HERMES_ROUTING_H
+
+#include "ns3/data-rate.h"
+#include "ns3/event-id.h"
+#include "ns3/hermes-path-table.h"
+#include "ns3/hermes-probe-tag.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/object.h"
+#include "ns3/packet.h"
+#include "ns3/node.h"
+#include "ns3/nstime.h"
+#include "ns3/random-variable-stream.h"
+
+#include <unordered_map>
+
+namespace ns3 {
+
+/**
+ * \ingroup hermes-routing
+ *
+ * \brief Hermes host-based load balancing.
+ *
+ * Implements the load balancing of "Resilient Datacenter Load Balancing in
+ * the Wild". Hosts pick the path of every packet they send and stamp it in
+ * an Ipv4XPathTag. Switches forward tagged packets on the route with the
+ * path ID modulo the number of routes to the destination, so in a leaf-spine
+ * network the path ID picks the uplink of the source leaf.
+ *
+ * Hosts sense the paths to each destination with the RTT and ECN echo of the
+ * ACKs their TCP flows receive (the AckReceived trace of TcpL4Protocol),
+ * attributed to the current path of the flow, and by probing. Every
+ * ProbeInterval, a host that sent to a destination within IdleTimeout
+ * probes two random paths and the best known path to it. Paths are then
+ * good, gray or congested (see HermesPathTable).
+ *
+ * Rerouting is cautious and timely. New flows and flowlets, after a gap of
+ * FlowletTimeout, take the best path. A flow moves off its path while
+ * sending only if the path is congested, the flow has sent more than
+ * RerouteSize bytes and is slower than RerouteRate, and another path is
+ * notably better.
+ */
+class Ipv4HermesRouting : public Ipv4RoutingProtocol {
+public:
+	// The IP protocol number of probes, from the range reserved for
+	// experimentation.
+	static const uint8_t PROBE_PROTOCOL = 253;
+
+	Ipv4HermesRouting(Ptr<Ipv4GlobalRouting> globalRouting);
+	~Ipv4HermesRouting();
+
+	static TypeId GetTypeId();
+
+	// Inherited from Ipv4RoutingProtocol.
+	Ptr<Ipv4Route> RouteOutput(
+		Ptr<Packet> p, const Ipv4Header& header, Ptr<NetDevice> oif,
+		Socket::SocketErrno& sockerr) override;
+	bool RouteInput(
+		Ptr<const Packet> p, const Ipv4Header& header,
+		Ptr<const NetDevice> idev, UnicastForwardCallback ucb,
+		MulticastForwardCallback mcb, LocalDeliverCallback lcb,
+		ErrorCallback ecb) override;
+	void NotifyInterfaceUp(uint32_t interface) override;
+	void NotifyInterfaceDown(uint32_t interface) override;
+	void NotifyAddAddress(uint32_t interface,
+		                  Ipv4InterfaceAddress address) override;
+	void NotifyRemoveAddress(uint32_t interface,
+		                     Ipv4InterfaceAddress address) override;
+	void SetIpv4(Ptr<Ipv4> ipv4) override;
+	void PrintRoutingTable(Ptr<OutputStreamWrapper> stream,
+		                   Time::Unit unit = Time::S) const override;
+
+	/**
+	 * \brief Get the number of individual unicast routes that have been
+	 * added to the routing table.
+	 */
+	uint32_t GetNRoutes() const;
+
+	/**
+	 * \brief Get a route from the unicast routing table.
+	 *
+	 * \param i The index (into the routing table) of the route to retrieve.
+	 *
+	 * \return If the route is set, a pointer to that Ipv4RoutingTableEntry
+	 * is returned, otherwise, nullptr is returned.
+	 */
+	Ipv4RoutingTableEntry* GetRoute(uint32_t i) const;
+
+	virtual void DoDispose(void) override;
+
+	/**
+	 * \brief Sets the number of paths to every destination, forgetting what
+	 * is known of the paths.
+	 *
+	 * \param nPaths the number of paths, usually the number of uplinks of
+	 * the leaf of the host.
+	 */
+	void SetPaths(uint32_t nPaths);
+
+	/**
+	 * \returns the number of paths to every destination.
+	 */
+	uint32_t GetPaths() const;
+
+	/**
+	 * \brief Gets what the host knows of the paths to a destination.
+	 *
+	 * \param dst the destination address.
+	 * \returns the path table of the destination, or nullptr if the host
+	 * did not send to it recently.
+	 */
+	const HermesPathTable* GetPathTable(Ipv4Address dst) const;
+
+	/**
+	 * \returns the number of times a flow or flowlet changed path.
+	 */
+	uint64_t GetReroutes() const;
+
+	/**
+	 * \returns the number of probes sent.
+	 */
+	uint64_t GetProbesSent() const;
+
+	/**
+	 * Assign a fixed random variable stream number to the random variables
+	 * used by this model.  Return the number of streams (possibly zero) that
+	 * have been assigned.
+	 *
+	 * \param stream first stream index to use
+	 * \return the number of stream indices assigned by this model
+	 */
+	int64_t AssignStreams(int64_t stream);
+
+private:
+	// The path a flow sent by this host is on.
+	struct Flow {
+		// The destination address of the flow.
+		uint32_t dst = 0;
+		uint32_t path = 0;
+		uint64_t bytesSent = 0;
+		Time startTime;
+		Time lastSendTime;
+	};
+
+	// The paths to a destination of the flows of this host.
+	struct Destination {
+		Ipv4Address address;
+		HermesPathTable paths;
+		// The last time a packet was sent to the destination.
+		Time activeTime;
+		// The last time a probe reply came back from the destination.
+		Time probeTime;
+	};
+
+	/**
+	 * \brief Picks the path of a packet sent by this host.
+	 *
+	 * \param flowKey the key of the flow of the packet.
+	 * \param dst the destination address.
+	 * \param size the size of the packet.
+	 *
+	 * \returns the path ID.
+	 */
+	uint32_t ChoosePath(uint64_t flowKey, Ipv4Address dst, uint32_t size);
+
+	/**
+	 * \param dst the destination address.
+	 * \returns the paths to the destination, created if needed.
+	 */
+	Destination& GetDestination(Ipv4Address dst);
+
+	/**
+	 * \brief Receives the report of an ACK from TcpL4Protocol.
+	 *
+	 * \param flowKey the key of the flow the ACK acknowledged data of.
+	 * \param bytesAcked the number of bytes newly acknowledged.
+	 * \param ecnEcho whether the ACK carried an ECN echo.
+	 * \param rtt the latest RTT sample of the flow.
+	 */
+	void AckReceived(uint64_t flowKey, uint32_t bytesAcked, bool ecnEcho,
+		             Time rtt);
+
+	/**
+	 * \brief Probes the paths to the destinations sent to recently.
+	 */
+	void Probe();
+
+	/**
+	 * \brief Sends a probe or probe reply.
+	 *
+	 * \param dst the destination address.
+	 * \param tag the probe header.
+	 * \param tagPath whether to steer the probe on the path of the tag.
+	 */
+	void SendProbe(Ipv4Address dst, const HermesProbeTag& tag, bool tagPath);
+
+	/**
+	 * \brief Answers a probe, or records what a probe reply tells of a path.
+	 *
+	 * \param tag the probe header.
+	 * \param header the IPv4 header of the probe.
+	 */
+	void ReceiveProbe(const HermesProbeTag& tag, const Ipv4Header& header);
+
+	/**
+	 * \brief Forgets the flows that sent nothing for IdleTimeout, and the
+	 * destinations that were neither sent to nor probed for IdleTimeout.
+	 */
+	void ForgetIdleFlows();
+
+	/**
+	 * \brief constructs a route to the destination.
+	 *
+	 * Routes are cached per (port, destination) pair.
+	 *
+	 * \param entry the routing table entry of the chosen path.
+	 * \param dstAddr the destination address for the route.
+	 *
+	 * \returns Ptr<Ipv4Route> through the entry to the destination.
+	 */
+	Ptr<Ipv4Route> ConstructIpv4Route(const Ipv4RoutingTableEntry* entry,
+		                              Ipv4Address dstAddr);
+
+	// A uniform random number generator for path choices and probes.
+	Ptr<UniformRandomVariable> m_rand;
+
+	// The number of paths to every destination.
+	uint32_t m_nPaths;
+
+	// The thresholds of the path types, as attributes and as passed to the
+	// path tables.
+	double m_ecnThreshold;
+	Time m_rttLow;
+	Time m_rttHigh;
+	Time m_deltaRtt;
+	double m_deltaEcnThreshold;
+	double m_gain;
+	HermesThresholds m_thresholds;
+
+	Time m_flowletTimeout;
+	uint32_t m_rerouteSize;
+	DataRate m_rerouteRate;
+	Time m_probeInterval;
+	Time m_idleTimeout;
+
+	// Ipv4 address associated with this router.
+	Ptr<Ipv4> m_ipv4;
+
+	// Whether the ACK reports of TCP are connected. TCP is installed after
+	// the routing protocol, so this is done with the first packet sent.
+	bool m_tcpConnected;
+
+	std::unordered_map<uint64_t, Flow> m_flows;
+	std::unordered_map<uint32_t, Destination> m_destinations;
+
+	Time m_lastFlowSweep;
+	EventId m_probeEvent;
+
+	uint64_t m_reroutes;
+	uint64_t m_probesSent;
+
+	// Routes built by ConstructIpv4Route, keyed by the port in the upper 32
+	// bits and the destination address in the lower 32 bits. The cache is
+	// cleared whenever an interface or address changes.
+	std::unordered_map<uint64_t, Ptr<Ipv4Route>> m_routeCache;
+
+	// A pointer to an Ipv4GlobalRouting object. Hermes only changes routes
+	// to balance loads but we leverage the existing global routing
+	// capabilities to pre-install routes and maintain the routing table.
+	Ptr<Ipv4GlobalRouting> m_globalRouting;
+};
+
+}  // namespace ns3
+
+#endif  // IPV4_HERMES_ROUTING_H
@@ -0,0 +1,443 @@
+#include "ns3/flow-key-tag.h"
+#include "ns3/hermes-path-table.h"
+#include "ns3/hermes-probe-tag.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/ipv4-hermes-routing-helper.h"
+#include "ns3/ipv4-hermes-routing.h"
+#include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/ipv4-xpath-tag.h"
+#include "ns3/log.h"
+#include "ns3/node-container.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/pointer.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simulator.h"
+#include "ns3/tcp-l4-protocol.h"
+#include "ns3/test.h"
+#include "ns3/uinteger.h"
+
+#include <set>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("Ipv4HermesRoutingTestSuite");
+
+/**
+ * \defgroup hermes-routing-tests Tests for hermes-routing
+ * \ingroup hermes-routing
+ * \ingroup tests
+ * 
+ * This test suite tests the path table of Hermes hosts, the conditions under
+ * which Hermes moves a flow off its path, and the probing of paths.
+ * 
+ * The reroute and probe tests run on two hosts and two leaves joined by two
+ * spines, with Hermes on every node:
+ * 
+ *    h0 --- A === 2 spines === B --- h1
+ * 10.1.0.1                        10.9.0.2
+ */
+
+/**
+ * \ingroup hermes-routing-tests
+ * 
+ * \brief Builds the leaf-spine network of the reroute and probe tests.
+ * 
+ * \param hosts The hosts h0 and h1, created by the function.
+ * \param delay The delay of every link.
+ */
+static void BuildLeafSpine(NodeContainer& hosts, Time delay) {
+  const uint32_t nSpines = 2;
+  hosts.Create(2);
+  NodeContainer leaves;
+  leaves.Create(2);
+  NodeContainer spines;
+  spines.Create(nSpines);
+
+  InternetStackHelper internet;
+  Ipv4HermesRoutingHelper hermesRouting;
+  internet.SetRoutingHelper(hermesRouting);
+  internet.Install(hosts);
+  internet.Install(leaves);
+  internet.Install(spines);
+
+  SimpleNetDeviceHelper simpleHelper;
+  simpleHelper.SetNetDevicePointToPointMode(true);
+  simpleHelper.SetChannelAttribute("Delay", TimeValue(delay));
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase("10.1.0.0", "255.255.255.252");
+  ipv4.Assign(simpleHelper.Install(NodeContainer(hosts.Get(0),
+                                                 leaves.Get(0))));
+  ipv4.NewNetwork();
+  for (uint32_t spine = 0; spine < nSpines; spine++) {
+    for (uint32_t leaf = 0; leaf < 2; leaf++) {
+      ipv4.Assign(simpleHelper.Install(
+        NodeContainer(leaves.Get(leaf), spines.Get(spine))));
+      ipv4.NewNetwork();
+    }
+  }
+  ipv4.SetBase("10.9.0.0", "255.255.255.0");
+  ipv4.Assign(simpleHelper.Install(NodeContainer(leaves.Get(1),
+                                                 hosts.Get(1))));
+  Ipv4HermesRoutingHelper::PopulateRoutingTables();
+  hermesRouting.AddLeaf(leaves.Get(0), NodeContainer(hosts.Get(0)));
+  hermesRouting.AddLeaf(leaves.Get(1), NodeContainer(hosts.Get(1)));
+}
+
+/**
+ * \ingroup hermes-routing-tests
+ * 
+ * \brief Hermes path table test.
+ * 
+ * Checks that paths are told apart by their RTT and ECN fraction, that new
+ * flows prefer good paths, and that flows leave congested paths only for
+ * notably better ones.
+ */
+class PathTableTest : public TestCase {
+public:
+  void DoRun() override;
+  PathTableTest();
+};
+
+PathTableTest::PathTableTest()
+  : TestCase("Hermes path table classifies and ranks paths") {}
+
+void PathTableTest::DoRun() {
+  HermesThresholds thresholds;
+  thresholds.ecnFraction = 0.4;
+  thresholds.rttLow = MicroSeconds(100);
+  thresholds.rttHigh = MicroSeconds(150);
+  thresholds.deltaRtt = MicroSeconds(20);
+  thresholds.deltaEcnFraction = 0.05;
+  Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable>();
+
+  HermesPathTable table;
+  table.Configure(4);
+  NS_TEST_ASSERT_MSG_EQ(table.GetNPaths(), 4, "Error -- wrong path count");
+  NS_TEST_ASSERT_MSG_EQ(table.Classify(0, thresholds), HERMES_PATH_GRAY,
+                        "Error -- unexplored path is not gray");
+
+  // Path 0 is good, path 1 congested, path 2 gray and path 3 unexplored.
+  table.RecordRtt(0, MicroSeconds(90), 1);
+  table.RecordEcn(0, false, 1);
+  table.RecordRtt(1, MicroSeconds(300), 1);
+  table.RecordEcn(1, true, 1);
+  table.RecordRtt(2, MicroSeconds(120), 1);
+  table.RecordEcn(2, false, 1);
+  NS_TEST_ASSERT_MSG_EQ(table.Classify(0, thresholds), HERMES_PATH_GOOD,
+                        "Error -- good path not recognized");
+  NS_TEST_ASSERT_MSG_EQ(table.Classify(1, thresholds), HERMES_PATH_CONGESTED,
+                        "Error -- congested path not recognized");
+  NS_TEST_ASSERT_MSG_EQ(table.Classify(2, thresholds), HERMES_PATH_GRAY,
+                        "Error -- gray path not recognized");
+
+  // Samples are averaged with the gain.
+  table.RecordRtt(2, MicroSeconds(200), 0.5);
+  NS_TEST_ASSERT_MSG_EQ(table.GetPath(2).rtt, MicroSeconds(160),
+                        "Error -- wrong RTT average");
+
+  NS_TEST_ASSERT_MSG_EQ(table.ChooseBest(thresholds, rand), 0,
+                        "Error -- good path not preferred");
+
+  // A flow leaves the congested path for a good path, or for a gray path
+  // only if it is better by the deltas.
+  NS_TEST_ASSERT_MSG_EQ(table.IsNotablyBetter(1, 0, thresholds), true,
+                        "Error -- good path is not better");
+  NS_TEST_ASSERT_MSG_EQ(table.IsNotablyBetter(1, 2, thresholds), true,
+                        "Error -- gray path is not better");
+  NS_TEST_ASSERT_MSG_EQ(table.IsNotablyBetter(1, 3, thresholds), false,
+                        "Error -- unexplored path is better");
+  table.RecordRtt(2, MicroSeconds(300), 1);
+  NS_TEST_ASSERT_MSG_EQ(table.IsNotablyBetter(1, 2, thresholds), false,
+                        "Error -- gray path as slow as the congested one "
+                        "is better");
+
+  // Without good paths, unexplored gray paths beat slower gray paths.
+  table.RecordRtt(0, MicroSeconds(300), 1);
+  table.RecordEcn(0, true, 1);
+  NS_TEST_ASSERT_MSG_EQ(table.ChooseBest(thresholds, rand), 3,
+                        "Error -- wrong gray path preferred");
+}
+
+/**
+ * \ingroup hermes-routing-tests
+ * 
+ * \brief Hermes reroute test.
+ * 
+ * h0 sends three flows to h1 over the two paths, and reports the ACKs of
+ * the flows as TCP would:
+ * 
+ * - A and C start on a path P that turns congested, after which B starts on
+ *   the other path Q, which turns good.
+ * - A sends slowly and must move to Q once it has sent more than
+ *   RerouteSize bytes, and not before.
+ * - C sends faster than RerouteRate and must stay on P, which it congests
+ *   rather than suffers from.
+ * - B must stay on the good path Q.
+ */
+class RerouteTest : public TestCase {
+public:
+  void DoRun() override;
+  RerouteTest();
+
+private:
+  /**
+   * \brief Sends a packet of a flow from h0 to h1 through the routing of h0.
+   * 
+   * \param routing The Hermes routing of h0.
+   * \param sport The source port of the flow.
+   * \param size The size of the packet.
+   * 
+   * \return The path ID the packet is stamped with, or UINT32_MAX if it is
+   * not stamped.
+   */
+  static uint32_t Send(Ptr<Ipv4HermesRouting> routing, uint16_t sport,
+                       uint32_t size);
+
+  /**
+   * \brief Reports an ACK of a flow from h0 to h1 to the TCP of h0.
+   * 
+   * \param tcp The TCP of h0.
+   * \param sport The source port of the flow.
+   * \param ecnEcho Whether the ACK carries an ECN echo.
+   * \param rtt The RTT sample of the ACK.
+   */
+  static void Ack(Ptr<TcpL4Protocol> tcp, uint16_t sport, bool ecnEcho,
+                  Time rtt);
+};
+
+RerouteTest::RerouteTest()
+  : TestCase("Hermes moves only slow flows off congested paths") {}
+
+uint32_t RerouteTest::Send(Ptr<Ipv4HermesRouting> routing, uint16_t sport,
+                           uint32_t size) {
+  Ptr<Packet> packet = Create<Packet>(size);
+  packet->AddPacketTag(FlowKeyTag(FlowKeyTag::ConstructFlowKey(
+    Ipv4Address("10.1.0.1"), Ipv4Address("10.9.0.2"), sport, 80,
+    TcpL4Protocol::PROT_NUMBER)));
+  Ipv4Header header;
+  header.SetDestination(Ipv4Address("10.9.0.2"));
+  header.SetProtocol(TcpL4Protocol::PROT_NUMBER);
+  Socket::SocketErrno sockerr;
+  routing->RouteOutput(packet, header, nullptr, sockerr);
+  Ipv4XPathTag xpathTag;
+  if (!packet->PeekPacketTag(xpathTag)) {
+    return UINT32_MAX;
+  }
+  return xpathTag.GetPathId();
+}
+
+void RerouteTest::Ack(Ptr<TcpL4Protocol> tcp, uint16_t sport, bool ecnEcho,
+                      Time rtt) {
+  tcp->NotifyAckReceived(Ipv4Address("10.1.0.1"), Ipv4Address("10.9.0.2"),
+                         sport, 80, 1000, ecnEcho, rtt);
+}
+
+void RerouteTest::DoRun() {
+  const uint16_t flowA = 1000;
+  const uint16_t flowB = 2000;
+  const uint16_t flowC = 3000;
+  const Time step = MicroSeconds(100);
+  NodeContainer hosts;
+  BuildLeafSpine(hosts, MicroSeconds(10));
+  Ipv4HermesRoutingHelper hermesRouting;
+  Ptr<Ipv4HermesRouting> routing =
+    hermesRouting.GetHermesRouting(hosts.Get(0)->GetObject<Ipv4>());
+  Ptr<TcpL4Protocol> tcp = hosts.Get(0)->GetObject<TcpL4Protocol>();
+  routing->SetAttribute("ProbeInterval", TimeValue(Seconds(0)));
+  routing->SetAttribute("RerouteSize", UintegerValue(5000));
+  NS_TEST_ASSERT_MSG_EQ(routing->GetPaths(), 2,
+                        "Error -- paths not set to the uplinks of the leaf");
+
+  // A starts on a path that proves good, so C follows it. With the default
+  // gain of 1/8, eight marked slow ACKs make the path congested.
+  uint32_t congested = Send(routing, flowA, 1000);
+  Ack(tcp, flowA, false, MicroSeconds(50));
+  NS_TEST_ASSERT_MSG_EQ(Send(routing, flowC, 40000), congested,
+                        "Error -- new flow does not take the good path");
+  for (uint32_t i = 0; i < 8; i++) {
+    Ack(tcp, flowA, true, MicroSeconds(300));
+  }
+  const HermesPathTable* paths =
+    routing->GetPathTable(Ipv4Address("10.9.0.2"));
+  NS_TEST_ASSERT_MSG_NE(paths, nullptr, "Error -- no path table");
+  HermesThresholds thresholds;
+  thresholds.rttLow = MicroSeconds(100);
+  thresholds.rttHigh = MicroSeconds(150);
+  NS_TEST_ASSERT_MSG_EQ(paths->Classify(congested, thresholds),
+                        HERMES_PATH_CONGESTED,
+                        "Error -- ACKs do not congest the path");
+  uint32_t good = Send(routing, flowB, 1000);
+  NS_TEST_ASSERT_MSG_NE(good, congested,
+                        "Error -- new flow takes the congested path");
+  Ack(tcp, flowB, false, MicroSeconds(50));
+  NS_TEST_ASSERT_MSG_EQ(paths->Classify(good, thresholds), HERMES_PATH_GOOD,
+                        "Error -- ACKs do not clear the path");
+
+  // Packets a step apart stay in their flowlet. A has sent 1000 bytes per
+  // step, so it exceeds RerouteSize on the sixth.
+  for (uint32_t k = 1; k <= 12; k++) {
+    Simulator::Stop(step);
+    Simulator::Run();
+    uint32_t pathA = Send(routing, flowA, 1000);
+    if (k <= 5) {
+      NS_TEST_ASSERT_MSG_EQ(pathA, congested,
+                            "Error -- flow rerouted before RerouteSize");
+    } else {
+      NS_TEST_ASSERT_MSG_EQ(pathA, good,
+                            "Error -- slow flow stays on congested path");
+    }
+    NS_TEST_ASSERT_MSG_EQ(Send(routing, flowC, 40000), congested,
+                          "Error -- fast flow rerouted");
+    NS_TEST_ASSERT_MSG_EQ(Send(routing, flowB, 1000), good,
+                          "Error -- flow leaves a good path");
+  }
+  NS_TEST_ASSERT_MSG_EQ(routing->GetReroutes(), 1,
+                        "Error -- wrong number of reroutes");
+
+  Simulator::Destroy();
+}
+
+/**
+ * \ingroup hermes-routing-tests
+ * 
+ * \brief Hermes probe test.
+ * 
+ * Once h0 sends to h1, it probes the paths to h1 every ProbeInterval. h1
+ * must echo every probe it receives on protocol 253 back to h0, and h0 must
+ * measure the RTT of each probed path from the echoes. Once h1 is idle, h0
+ * must forget its paths.
+ */
+class ProbeTest : public TestCase {
+public:
+  void DoRun() override;
+  ProbeTest();
+
+private:
+  /**
+   * \brief Counts the probes or probe replies a host receives.
+   * 
+   * \param reply Whether to count replies rather than probes.
+   * \param count The number of packets counted so far.
+   * \param paths The path IDs of the counted packets.
+   * \param p The packet, with its IP header.
+   * \param ipv4 The Ipv4 of the host.
+   * \param interface The interface of the packet.
+   */
+  static void CountProbe(bool reply, uint32_t* count,
+                         std::set<uint32_t>* paths, Ptr<const Packet> p,
+                         Ptr<Ipv4> ipv4, uint32_t interface);
+};
+
+ProbeTest::ProbeTest()
+  : TestCase("Hermes probes paths and measures them from the echoes") {}
+
+void ProbeTest::CountProbe(bool reply, uint32_t* count,
+                           std::set<uint32_t>* paths, Ptr<const Packet> p,
+                           Ptr<Ipv4> ipv4, uint32_t interface) {
+  Ipv4Header header;
+  p->PeekHeader(header);
+  HermesProbeTag probeTag;
+  if (header.GetProtocol() != Ipv4HermesRouting::PROBE_PROTOCOL ||
+      !p->PeekPacketTag(probeTag) || probeTag.IsReply() != reply) {
+    return;
+  }
+  (*count)++;
+  paths->insert(probeTag.GetPathId());
+}
+
+void ProbeTest::DoRun() {
+  const Time delay = MicroSeconds(10);
+  NodeContainer hosts;
+  BuildLeafSpine(hosts, delay);
+  Ipv4HermesRoutingHelper hermesRouting;
+  Ptr<Ipv4HermesRouting> routing =
+    hermesRouting.GetHermesRouting(hosts.Get(0)->GetObject<Ipv4>());
+  uint32_t probes = 0;
+  uint32_t replies = 0;
+  std::set<uint32_t> probedPaths;
+  std::set<uint32_t> repliedPaths;
+  hosts.Get(1)->GetObject<Ipv4L3Protocol>()->TraceConnectWithoutContext(
+    "Rx", MakeBoundCallback(&ProbeTest::CountProbe, false, &probes,
+                            &probedPaths));
+  hosts.Get(0)->GetObject<Ipv4L3Protocol>()->TraceConnectWithoutContext(
+    "Rx", MakeBoundCallback(&ProbeTest::CountProbe, true, &replies,
+                            &repliedPaths));
+
+  Ptr<Packet> packet = Create<Packet>(1000);
+  packet->AddPacketTag(FlowKeyTag(42));
+  Ipv4Header header;
+  header.SetDestination(Ipv4Address("10.9.0.2"));
+  Socket::SocketErrno sockerr;
+  routing->RouteOutput(packet, header, nullptr, sockerr);
+  // Two rounds of probes, at 500 and 1000 us.
+  Simulator::Stop(MicroSeconds(1200));
+  Simulator::Run();
+
+  NS_TEST_ASSERT_MSG_GT(routing->GetProbesSent(), 0,
+                        "Error -- no probe sent");
+  NS_TEST_ASSERT_MSG_EQ(probes, routing->GetProbesSent(),
+                        "Error -- probes lost on the way");
+  NS_TEST_ASSERT_MSG_EQ(replies, probes, "Error -- probes not echoed");
+  NS_TEST_ASSERT_MSG_EQ((repliedPaths == probedPaths), true,
+                        "Error -- echoes do not name the probed paths");
+  const HermesPathTable* paths =
+    routing->GetPathTable(Ipv4Address("10.9.0.2"));
+  NS_TEST_ASSERT_MSG_NE(paths, nullptr, "Error -- no path table");
+  for (uint32_t path : probedPaths) {
+    NS_TEST_ASSERT_MSG_EQ(paths->GetPath(path).measured, true,
+                          "Error -- probed path not measured");
+    // Four links there and four back.
+    NS_TEST_ASSERT_MSG_EQ(paths->GetPath(path).rtt, 8 * delay,
+                          "Error -- wrong probed RTT");
+  }
+
+  // Once h1 is neither sent to nor probed for IdleTimeout, the next packet
+  // h0 sends, here to the leaf of h1, forgets it.
+  Simulator::Stop(MilliSeconds(25));
+  Simulator::Run();
+  NS_TEST_ASSERT_MSG_NE(routing->GetPathTable(Ipv4Address("10.9.0.2")),
+                        nullptr,
+                        "Error -- destination forgotten before a send");
+  header.SetDestination(Ipv4Address("10.9.0.1"));
+  routing->RouteOutput(packet, header, nullptr, sockerr);
+  NS_TEST_ASSERT_MSG_EQ(routing->GetPathTable(Ipv4Address("10.9.0.2")),
+                        nullptr, "Error -- idle destination kept");
+  NS_TEST_ASSERT_MSG_NE(routing->GetPathTable(Ipv4Address("10.9.0.1")),
+                        nullptr, "Error -- new destination not added");
+
+  Simulator::Destroy();
+}
+
+/**
+ * \ingroup hermes-routing-tests
+ * TestSuite for module hermes-routing
+ */
+class HermesRoutingTestSuite : public TestSuite
+{
+  public:
+    HermesRoutingTestSuite();
+};
+
+HermesRoutingTestSuite::HermesRoutingTestSuite()
+    : TestSuite("ipv4-hermes-routing", UNIT)
+{
+    // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
+    AddTestCase(new PathTableTest, TestCase::QUICK);
+    AddTestCase(new RerouteTest, TestCase::QUICK);
+    AddTestCase(new ProbeTest, TestCase::QUICK);
+}
+
+// Do not forget to allocate an instance of this TestSuite
+/**
+ * \ingroup hermes-routing-tests
+ * Static variable for test initialization
+ */
+static HermesRoutingTestSuite shermesRoutingTestSuite;
@@ -0,0 +1,370 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "fat-tree-routing-helper.h"
+
+#include "ns3/callback.h"
+#include "ns3/channel.h"
+#include "ns3/data-rate.h"
+#include "ns3/global-router-interface.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/ipv4.h"
+#include "ns3/log.h"
+#include "ns3/net-device.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("FatTreeRoutingHelper");
+
+FatTreeRoutingHelper::FatTreeRoutingHelper(NodeContainer spines, NodeContainer leaves)
+    : m_spines(spines),
+      m_leaves(leaves)
+{
+}
+
+void
+FatTreeRoutingHelper::PopulateRoutingTables() const
+{
+    NS_LOG_FUNCTION(this);
+    // Find the links of every leaf first, and the capacity between each leaf
+    // and each spine in both directions, which bounds the traffic a path
+    // through the spine can carry.
+    uint32_t nLeaves = m_leaves.GetN();
+    std::vector<LeafLinks> links = GetLeafLinks(m_spines, m_leaves);
+    std::vector<std::vector<double>> upCapacities(nLeaves,
+                                                  std::vector<double>(m_spines.GetN(), 0));
+    std::vector<std::vector<double>> downCapacities(nLeaves,
+                                                    std::vector<double>(m_spines.GetN(), 0));
+    for (uint32_t leaf = 0; leaf < nLeaves; leaf++)
+    {
+        Ptr<Node> leafNode = m_leaves.Get(leaf);
+        for (uint32_t i = 0; i < links[leaf].uplinks.size(); i++)
+        {
+            const Link& link = links[leaf].uplinks[i];
+            uint32_t spine = links[leaf].uplinkSpines[i];
+            upCapacities[leaf][spine] +=
+                GetCapacity(leafNode, link.interface, link.peer, link.peerInterface);
+            downCapacities[leaf][spine] +=
+                GetCapacity(link.peer, link.peerInterface, leafNode, link.interface);
+        }
+    }
+
+    for (uint32_t leaf = 0; leaf < nLeaves; leaf++)
+    {
+        Ptr<Node> leafNode = m_leaves.Get(leaf);
+        Ptr<Ipv4GlobalRouting> leafRouting = GetGlobalRouting(leafNode);
+        const std::vector<Link>& up = links[leaf].uplinks;
+        const std::vector<uint32_t>& upSpines = links[leaf].uplinkSpines;
+        for (const Link& down : links[leaf].downlinks)
+        {
+            leafRouting->AddHostRouteTo(down.peerAddress, down.peerAddress, down.interface);
+            GetGlobalRouting(down.peer)->AddNetworkRouteTo(Ipv4Address::GetZero(),
+                                                           Ipv4Mask::GetZero(),
+                                                           down.address,
+                                                           down.peerInterface);
+        }
+
+        // A spine weighs its parallel links to this leaf by their capacity,
+        // and the leaf weighs its default routes by the capacity of its
+        // uplinks.
+        std::vector<double> uplinkCapacities;
+        std::vector<double> spineCapacities;
+        for (const Link& link : up)
+        {
+            uplinkCapacities.push_back(
+                GetCapacity(leafNode, link.interface, link.peer, link.peerInterface));
+            spineCapacities.push_back(
+                GetCapacity(link.peer, link.peerInterface, leafNode, link.interface));
+        }
+        std::vector<uint32_t> defaultWeights = GetWeights(uplinkCapacities);
+        std::vector<uint32_t> spineWeights(up.size(), 0);
+        for (uint32_t spine = 0; spine < m_spines.GetN(); spine++)
+        {
+            std::vector<double> linkCapacities(up.size(), 0);
+            for (uint32_t i = 0; i < up.size(); i++)
+            {
+                if (upSpines[i] == spine)
+                {
+                    linkCapacities[i] = spineCapacities[i];
+                }
+            }
+            std::vector<uint32_t> weights = GetWeights(linkCapacities);
+            for (uint32_t i = 0; i < up.size(); i++)
+            {
+                if (upSpines[i] == spine)
+                {
+                    spineWeights[i] = weights[i];
+                }
+            }
+        }
+
+        for (uint32_t i = 0; i < up.size(); i++)
+        {
+            if (defaultWeights[i] > 0)
+            {
+                leafRouting->AddNetworkRouteTo(Ipv4Address::GetZero(),
+                                               Ipv4Mask::GetZero(),
+                                               up[i].peerAddress,
+                                               up[i].interface,
+                                               defaultWeights[i]);
+            }
+            if (spineWeights[i] == 0)
+            {
+                continue;
+            }
+            Ptr<Ipv4GlobalRouting> spineRouting = GetGlobalRouting(up[i].peer);
+            for (const Link& down : links[leaf].downlinks)
+            {
+                spineRouting->AddHostRouteTo(down.peerAddress,
+                                             up[i].address,
+                                             up[i].peerInterface,
+                                             spineWeights[i]);
+            }
+        }
+
+        // Traffic to another leaf is also bounded by the capacity from each
+        // spine down to that leaf. An uplink gets its share of the capacity
+        // of the paths through its spine, and the servers of a leaf whose
+        // weights differ from the default routes get host routes.
+        for (uint32_t other = 0; other < nLeaves; other++)
+        {
+            if (other == leaf)
+            {
+                continue;
+            }
+            std::vector<double> pathCapacities(up.size(), 0);
+            for (uint32_t i = 0; i < up.size(); i++)
+            {
+                uint32_t spine = upSpines[i];
+                if (upCapacities[leaf][spine] > 0)
+                {
+                    pathCapacities[i] =
+                        uplinkCapacities[i] / upCapacities[leaf][spine] *
+                        std::min(upCapacities[leaf][spine], downCapacities[other][spine]);
+                }
+            }
+            std::vector<uint32_t> pathWeights = GetWeights(pathCapacities);
+            if (pathWeights == defaultWeights)
+            {
+                continue;
+            }
+            NS_LOG_LOGIC("Leaf " << leafNode->GetId() << " weighs the paths to leaf "
+                                 << m_leaves.Get(other)->GetId() << " apart");
+            for (const Link& down : links[other].downlinks)
+            {
+                for (uint32_t i = 0; i < up.size(); i++)
+                {
+                    if (pathWeights[i] > 0)
+                    {
+                        leafRouting->AddHostRouteTo(down.peerAddress,
+                                                    up[i].peerAddress,
+                                                    up[i].interface,
+                                                    pathWeights[i]);
+                    }
+                }
+            }
+        }
+    }
+
+    // Weigh the routes again whenever an interface of the fabric goes up or
+    // down, rather than letting the global route manager replace them.
+    Callback<void> recompute([helper = *this]() { helper.Recompute(); });
+    for (uint32_t spine = 0; spine < m_spines.GetN(); spine++)
+    {
+        GetGlobalRouting(m_spines.Get(spine))->SetRecomputeCallback(recompute);
+    }
+    for (uint32_t leaf = 0; leaf < nLeaves; leaf++)
+    {
+        GetGlobalRouting(m_leaves.Get(leaf))->SetRecomputeCallback(recompute);
+        for (const Link& down : links[leaf].downlinks)
+        {
+            GetGlobalRouting(down.peer)->SetRecomputeCallback(recompute);
+        }
+    }
+}
+
+void
+FatTreeRoutingHelper::Recompute() const
+{
+    NS_LOG_FUNCTION(this);
+    for (uint32_t spine = 0; spine < m_spines.GetN(); spine++)
+    {
+        GetGlobalRouting(m_spines.Get(spine))->ClearRoutes();
+    }
+    std::vector<LeafLinks> links = GetLeafLinks(m_spines, m_leaves);
+    for (uint32_t leaf = 0; leaf < m_leaves.GetN(); leaf++)
+    {
+        GetGlobalRouting(m_leaves.Get(leaf))->ClearRoutes();
+        for (const Link& down : links[leaf].downlinks)
+        {
+            GetGlobalRouting(down.peer)->ClearRoutes();
+        }
+    }
+    PopulateRoutingTables();
+}
+
+double
+FatTreeRoutingHelper::GetCapacity(Ptr<Node> node,
+                                  uint32_t interface,
+                                  Ptr<Node> peer,
+                                  uint32_t peerInterface)
+{
+    Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
+    if (!ipv4->IsUp(interface) || !peer->GetObject<Ipv4>()->IsUp(peerInterface))
+    {
+        return 0;
+    }
+    DataRateValue rate;
+    if (ipv4->GetNetDevice(interface)->GetAttributeFailSafe("DataRate", rate) &&
+        rate.Get().GetBitRate() > 0)
+    {
+        return rate.Get().GetBitRate();
+    }
+    // Devices without a data rate count as equally fast.
+    return 1;
+}
+
+std::vector<uint32_t>
+FatTreeRoutingHelper::GetWeights(const std::vector<double>& capacities)
+{
+    std::vector<uint32_t> weights(capacities.size(), 0);
+    double maxCapacity = 0;
+    for (double capacity : capacities)
+    {
+        maxCapacity = std::max(maxCapacity, capacity);
+    }
+    if (maxCapacity == 0)
+    {
+        return weights;
+    }
+    // Weights are kept to WEIGHT_RESOLUTION steps and reduced, so that equal
+    // capacities give the plain ECMP weight of 1.
+    uint32_t divisor = 0;
+    for (uint32_t i = 0; i < capacities.size(); i++)
+    {
+        if (capacities[i] > 0)
+        {
+            weights[i] = std::max<uint32_t>(
+                1,
+                std::lround(WEIGHT_RESOLUTION * capacities[i] / maxCapacity));
+            divisor = std::gcd(divisor, weights[i]);
+        }
+    }
+    for (uint32_t& weight : weights)
+    {
+        weight /= divisor;
+    }
+    return weights;
+}
+
+std::vector<FatTreeRoutingHelper::LeafLinks>
+FatTreeRoutingHelper::GetLeafLinks(NodeContainer spines, NodeContainer leaves)
+{
+    NS_LOG_FUNCTION(spines.GetN() << leaves.GetN());
+    std::unordered_map<uint32_t, uint32_t> spineIndices;
+    for (uint32_t spine = 0; spine < spines.GetN(); spine++)
+    {
+        spineIndices[spines.Get(spine)->GetId()] = spine;
+    }
+
+    std::vector<LeafLinks> links(leaves.GetN());
+    for (uint32_t leaf = 0; leaf < leaves.GetN(); leaf++)
+    {
+        // The parallel links to a spine keep their interface order.
+        std::vector<std::pair<uint32_t, Link>> uplinks;
+        for (const Link& link : GetLinks(leaves.Get(leaf)))
+        {
+            auto spineItr = spineIndices.find(link.peer->GetId());
+            if (spineItr == spineIndices.end())
+            {
+                links[leaf].downlinks.push_back(link);
+                continue;
+            }
+            uplinks.emplace_back(spineItr->second, link);
+        }
+        std::stable_sort(uplinks.begin(),
+                         uplinks.end(),
+                         [](const std::pair<uint32_t, Link>& a,
+                            const std::pair<uint32_t, Link>& b) { return a.first < b.first; });
+        for (const std::pair<uint32_t, Link>& uplink : uplinks)
+        {
+            links[leaf].uplinkSpines.push_back(uplink.first);
+            links[leaf].uplinks.push_back(uplink.second);
+        }
+        NS_LOG_LOGIC("Leaf " << leaves.Get(leaf)->GetId() << " has "
+                             << links[leaf].uplinks.size() << " uplinks and "
+                             << links[leaf].downlinks.size() << " servers");
+    }
+    return links;
+}
+
+std::vector<FatTreeRoutingHelper::Link>
+FatTreeRoutingHelper::GetLinks(Ptr<Node> node)
+{
+    NS_LOG_FUNCTION(node);
+    Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
+    NS_ASSERT_MSG(ipv4, "Ipv4 not installed on node " << node->GetId());
+    std::vector<Link> links;
+    for (uint32_t interface = 0; interface < ipv4->GetNInterfaces(); interface++)
+    {
+        Ptr<NetDevice> device = ipv4->GetNetDevice(interface);
+        Ptr<Channel> channel = device->GetChannel();
+        // The loopback interface has no channel.
+        if (!channel || ipv4->GetNAddresses(interface) == 0)
+        {
+            continue;
+        }
+        for (std::size_t j = 0; j < channel->GetNDevices(); j++)
+        {
+            Ptr<NetDevice> peerDevice = channel->GetDevice(j);
+            if (peerDevice == device)
+            {
+                continue;
+            }
+            Ptr<Ipv4> peerIpv4 = peerDevice->GetNode()->GetObject<Ipv4>();
+            int32_t peerInterface = peerIpv4 ? peerIpv4->GetInterfaceForDevice(peerDevice) : -1;
+            if (peerInterface < 0 || peerIpv4->GetNAddresses(peerInterface) == 0)
+            {
+                continue;
+            }
+            Link link;
+            link.interface = interface;
+            link.address = ipv4->GetAddress(interface, 0).GetLocal();
+            link.peer = peerDevice->GetNode();
+            link.peerInterface = peerInterface;
+            link.peerAddress = peerIpv4->GetAddress(peerInterface, 0).GetLocal();
+            links.push_back(link);
+        }
+    }
+    return links;
+}
+
+Ptr<Ipv4GlobalRouting>
+FatTreeRoutingHelper::GetGlobalRouting(Ptr<Node> node)
+{
+    Ptr<GlobalRouter> router = node->GetObject<GlobalRouter>();
+    NS_ASSERT_MSG(router, "No GlobalRouter on node " << node->GetId());
+    Ptr<Ipv4GlobalRouting> routing = router->GetRoutingProtocol();
+    NS_ASSERT_MSG(routing, "No Ipv4GlobalRouting on node " << node->GetId());
+    return routing;
+}
+
+} // namespace ns3
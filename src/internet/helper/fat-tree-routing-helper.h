@@ -0,0 +1,187 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef FAT_TREE_ROUTING_HELPER_H
+#define FAT_TREE_ROUTING_HELPER_H
+
+#include "ns3/ipv4-address.h"
+#include "ns3/node-container.h"
+
+#include <vector>
+
+namespace ns3
+{
+
+class Ipv4GlobalRouting;
+
+/**
+ * \ingroup ipv4Helpers
+ *
+ * \brief Helper class that fills the Ipv4GlobalRouting tables of a two-tier
+ * leaf-spine fabric without running the SPF calculations
+ *
+ * In a leaf-spine fabric every path between two servers goes up through the
+ * leaf of the sender, over one of the spines and down through the leaf of the
+ * receiver.  The routes are therefore known in closed form:
+ *
+ * - a server has a default route to its leaf;
+ * - a leaf has a host route to each of its servers and a default route over
+ *   each of its uplinks, which form one ECMP group;
+ * - a spine has a host route to each server over every link to the leaf of
+ *   the server.
+ *
+ * The servers and the links are found from the channels of the leaves, so
+ * any number of servers per leaf and of parallel links between a leaf and a
+ * spine is supported.  Any node attached to a leaf that is not a spine is a
+ * server.  Only the addresses of the servers are routed, the addresses of the
+ * leaf to spine links are not.
+ *
+ * Only two tiers are supported.  In a three-tier fat tree the aggregation
+ * switches attached to the leaves would be taken for servers, so such
+ * topologies must be routed with Ipv4GlobalRoutingHelper::PopulateRoutingTables().
+ *
+ * The routes are weighted by the residual capacity of their paths, from the
+ * DataRate of the devices, so that fabrics with uneven links are balanced by
+ * WCMP (see Ipv4GlobalRouting::PickWeightedRoute): a spine weighs its links to
+ * a leaf by their rate, and a leaf weighs an uplink by its share of the
+ * capacity up to its spine and down from the spine to the destination leaf.
+ * When the capacity down to some leaf differs between spines, the leaves get
+ * weighted host routes to its servers ahead of their default routes.  Links
+ * that are down carry no route, and equal capacities give the plain ECMP
+ * routes of weight 1.
+ *
+ * The routes are added to the Ipv4GlobalRouting object that is attached to
+ * the GlobalRouter of each node, so the helper works with every routing helper
+ * built on Ipv4GlobalRouting.  It replaces, and must not be mixed with,
+ * Ipv4GlobalRoutingHelper::PopulateRoutingTables(); recomputing the global
+ * routes with Ipv4GlobalRoutingHelper::RecomputeRoutingTables() replaces the
+ * routes of the whole fabric by the unweighted routes of the SPF
+ * calculations.  When a link fails or comes back, Recompute() weighs the
+ * routes again from the capacity that is left.  The nodes of the fabric call
+ * it upon interface events if their RespondToInterfaceEvents attribute is set.
+ */
+class FatTreeRoutingHelper
+{
+  public:
+    /**
+     * \brief Construct a helper for a fabric
+     * \param spines the spine switches
+     * \param leaves the leaf switches
+     */
+    FatTreeRoutingHelper(NodeContainer spines, NodeContainer leaves);
+
+    /**
+     * \brief Add the routes of the fabric to the spines, the leaves and the
+     * servers
+     *
+     * Must be called after the addresses are assigned.  The number of routes
+     * added, and the time taken, is linear in the number of servers times the
+     * number of links between a leaf and the spines.
+     */
+    void PopulateRoutingTables() const;
+
+    /**
+     * \brief Replace the routes of the fabric by routes weighted from the
+     * current state of its links
+     *
+     * Clears the global routes of the spines, the leaves and the servers and
+     * adds them again, so that links that are down carry no route and the
+     * other paths share the remaining capacity.  PopulateRoutingTables() sets
+     * this as the recompute callback of the Ipv4GlobalRouting of every node of
+     * the fabric (see Ipv4GlobalRouting::SetRecomputeCallback).
+     */
+    void Recompute() const;
+
+    /**
+     * \brief One end of a link between two nodes
+     */
+    struct Link
+    {
+        uint32_t interface;      //!< the interface of the node
+        Ipv4Address address;     //!< the address of the node on the link
+        Ptr<Node> peer;          //!< the node at the other end
+        uint32_t peerInterface;  //!< the interface of the peer
+        Ipv4Address peerAddress; //!< the address of the peer on the link
+    };
+
+    /**
+     * \brief The links of a leaf, split between spines and servers
+     */
+    struct LeafLinks
+    {
+        std::vector<Link> uplinks;          //!< the links to spines
+        std::vector<uint32_t> uplinkSpines; //!< the index of the spine of each uplink
+        std::vector<Link> downlinks;        //!< the links to servers
+    };
+
+    /**
+     * \brief Find the links of the leaves of a fabric
+     *
+     * This is how every leaf-spine helper tells the uplinks of a leaf, and
+     * their order, so that they agree on the paths of the fabric.  Uplinks
+     * are ordered by spine, and the parallel links to a spine by interface.
+     * Downlinks are in interface order.
+     *
+     * \param spines the spine switches
+     * \param leaves the leaf switches
+     * \returns the links of each leaf, in the order of the leaves
+     */
+    static std::vector<LeafLinks> GetLeafLinks(NodeContainer spines, NodeContainer leaves);
+
+  private:
+    /**
+     * \brief Find the links of a node
+     * \param node the node
+     * \returns the links of the node, in interface order
+     */
+    static std::vector<Link> GetLinks(Ptr<Node> node);
+
+    /**
+     * \brief Get the global routing of a node
+     * \param node the node
+     * \returns the Ipv4GlobalRouting object of the GlobalRouter of the node
+     */
+    static Ptr<Ipv4GlobalRouting> GetGlobalRouting(Ptr<Node> node);
+
+    /**
+     * \brief Get the capacity of a link in one direction
+     * \param node the sending node
+     * \param interface the interface of the sending node
+     * \param peer the receiving node
+     * \param peerInterface the interface of the receiving node
+     * \returns the data rate of the device of the sender in bit/s, 1 if the
+     * device has none, or 0 if either end is down
+     */
+    static double GetCapacity(Ptr<Node> node,
+                              uint32_t interface,
+                              Ptr<Node> peer,
+                              uint32_t peerInterface);
+
+    /**
+     * \brief Turn the capacities of the routes of a group into weights
+     * \param capacities the capacity of each route
+     * \returns the weight of each route, 0 for routes without capacity
+     */
+    static std::vector<uint32_t> GetWeights(const std::vector<double>& capacities);
+
+    /// The number of steps weights are rounded to, relative to the largest
+    static constexpr uint32_t WEIGHT_RESOLUTION = 1000;
+
+    NodeContainer m_spines; //!< the spine switches
+    NodeContainer m_leaves; //!< the leaf switches
+};
+
+} // namespace ns3
+
+#endif /* FAT_TREE_ROUTING_HELPER_H */
@@ -2,6 +2,7 @@
 #define IPV4_DRB_HELPER
 
 #include "ns3/node.h"
+#include "ns3/node-container.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-drb.h"
 
@@ -17,6 +18,17 @@ public:
 	virtual Ptr<Ipv4Drb> Create(Ptr<Node> node) const;
 	
 	Ptr<Ipv4Drb> GetIpv4Drb(Ptr<Ipv4> ipv4) const;
+
+	/**
+	 * Assign a fixed random variable stream number to the random variables
+	 * used by the DRB engines of the nodes.
+	 *
+	 * \param c NodeContainer of the set of nodes whose DRB engines should
+	 *          be modified to use a fixed stream
+	 * \param stream first stream index to use
+	 * \return the number of stream indices assigned by this helper
+	 */
+	int64_t AssignStreams(NodeContainer c, int64_t stream) const;
 };
 
 }  // namespace ns3
@@ -88,6 +88,18 @@ class Ipv4GlobalRoutingHelper : public Ipv4RoutingHelper
      *
      */
     static void RecomputeRoutingTables();
+    /**
+     * \brief Update the routes installed by a prior call to
+     * PopulateRoutingTables(), RecomputeRoutingTables() or
+     * UpdateRoutingTables() after links went up or down.
+     *
+     * The resulting routes are the same as those of RecomputeRoutingTables(),
+     * but only the nodes whose shortest paths may have changed run the SPF
+     * calculation again; the routes of the other nodes towards the routers
+     * whose links changed are patched in place.
+     *
+     */
+    static void UpdateRoutingTables();
 };
 
 } // namespace ns3
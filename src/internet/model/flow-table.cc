@@ -0,0 +1,59 @@
+#include "flow-table.h"
+
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("FlowTable");
+
+FlowTableBase::FlowTableBase()
+	: m_capacity(0),
+	  m_mask(0),
+	  m_indexBits(0),
+	  m_shared(false),
+	  m_collisions(0),
+	  m_evictions(0) {}
+
+uint32_t FlowTableBase::Resize(uint32_t capacity, bool shared) {
+	NS_LOG_FUNCTION(this << capacity << shared);
+	NS_ASSERT_MSG(capacity > 0, "The flow table needs at least one entry");
+	NS_ASSERT_MSG(capacity <= (1u << 31), "The flow table is too large");
+
+	// Round the capacity up to a power of 2 so that indices can be masked.
+	m_indexBits = 0;
+	while ((1u << m_indexBits) < capacity) {
+		m_indexBits++;
+	}
+	m_capacity = 1u << m_indexBits;
+	m_mask = m_capacity - 1;
+	m_shared = shared;
+	m_collisions = 0;
+	m_evictions = 0;
+	return m_capacity;
+}
+
+bool FlowTableBase::IsConfigured() const {
+	return m_capacity > 0;
+}
+
+uint32_t FlowTableBase::GetCapacity() const {
+	return m_capacity;
+}
+
+uint64_t FlowTableBase::GetCollisions() const {
+	return m_collisions;
+}
+
+uint64_t FlowTableBase::GetEvictions() const {
+	return m_evictions;
+}
+
+uint32_t FlowTableBase::HomeIndex(uint64_t flowKey) const {
+	if (m_indexBits == 0) {
+		return 0;
+	}
+	// Fibonacci hashing spreads sequential flow keys over the whole table.
+	return (flowKey * 0x9E3779B97F4A7C15ULL) >> (64 - m_indexBits);
+}
+
+}  // namespace ns3
@@ -0,0 +1,187 @@
+#ifndef FLOW_TABLE_H
+#define FLOW_TABLE_H
+
+#include "ns3/assert.h"
+#include "ns3/nstime.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup internet
+ *
+ * \brief The parts of FlowTable that do not depend on its entries.
+ */
+class FlowTableBase {
+public:
+	/**
+	 * \returns whether the table has been allocated by Configure.
+	 */
+	bool IsConfigured() const;
+
+	/**
+	 * \returns the number of entries in the table, 0 until it is configured.
+	 */
+	uint32_t GetCapacity() const;
+
+	/**
+	 * \returns the number of lookups that found the home entry of the flow
+	 * held by another active flow.
+	 */
+	uint64_t GetCollisions() const;
+
+	/**
+	 * \returns the number of active flows that lost their entry to another
+	 * flow.
+	 */
+	uint64_t GetEvictions() const;
+
+protected:
+	FlowTableBase();
+
+	/**
+	 * \brief Sizes the table and resets the counters.
+	 *
+	 * \param capacity the number of entries, rounded up to a power of 2.
+	 * \param shared whether entries are shared by all flows hashing to them.
+	 *
+	 * \returns the number of entries to allocate.
+	 */
+	uint32_t Resize(uint32_t capacity, bool shared);
+
+	/**
+	 * \returns the home entry of a flow.
+	 *
+	 * \param flowKey the key of the flow.
+	 */
+	uint32_t HomeIndex(uint64_t flowKey) const;
+
+	// The number of entries examined before evicting one.
+	static const uint32_t MAX_PROBES = 8;
+
+	uint32_t m_capacity;
+	// m_capacity - 1, used to wrap indices.
+	uint32_t m_mask;
+	// The number of bits used to index the table.
+	uint32_t m_indexBits;
+	bool m_shared;
+
+	uint64_t m_collisions;
+	uint64_t m_evictions;
+};
+
+/**
+ * \ingroup internet
+ *
+ * \brief A fixed-capacity table of per-flow state, modeled after the flow
+ * caches of switches.
+ *
+ * Entries live in a flat array indexed by a hash of the flow key and are
+ * found by linear probing over a small window, comparing flow keys. An
+ * entry that has been idle for longer than the idle timeout of the lookup
+ * is reused by the next flow that needs one. If every entry in the window
+ * is busy, the least recently active one is evicted, so memory stays
+ * bounded however many flows go through the node. In shared mode (as in
+ * the LetFlow paper) there is no probing: every flow hashing to an entry
+ * uses it, so colliding flows share their state.
+ *
+ * Entry must have a uint64_t flowKey, a Time activeTime, which the caller
+ * keeps up to date, and a bool valid, and must default to an unused entry.
+ */
+template <typename Entry>
+class FlowTable : public FlowTableBase {
+public:
+	/**
+	 * \brief Allocates the table, discarding any existing entries.
+	 *
+	 * \param capacity the number of entries, rounded up to a power of 2.
+	 * \param shared whether entries are shared by all flows hashing to them.
+	 */
+	void Configure(uint32_t capacity, bool shared = false);
+
+	/**
+	 * \brief Finds the entry of a flow.
+	 *
+	 * \param flowKey the key of the flow.
+	 * \param now the current time.
+	 * \param idleTimeout how long another flow keeps its entry without
+	 * packets. Time::Max() keeps entries until they are evicted.
+	 * \param found set to true if the flow already had the entry, however
+	 * long ago it was active. Otherwise the entry has been reset and claimed
+	 * for the flow. In shared mode, set to true if any flow used the entry.
+	 *
+	 * \returns the entry of the flow, valid until the next lookup.
+	 */
+	Entry& Lookup(uint64_t flowKey, Time now, Time idleTimeout, bool& found);
+
+private:
+	std::vector<Entry> m_entries;
+};
+
+template <typename Entry>
+void FlowTable<Entry>::Configure(uint32_t capacity, bool shared) {
+	m_entries.assign(Resize(capacity, shared), Entry());
+}
+
+template <typename Entry>
+Entry& FlowTable<Entry>::Lookup(uint64_t flowKey, Time now, Time idleTimeout,
+	                            bool& found) {
+	NS_ASSERT_MSG(!m_entries.empty(), "The flow table is not configured");
+	uint32_t home = HomeIndex(flowKey);
+
+	if (m_shared) {
+		Entry& entry = m_entries[home];
+		found = entry.valid;
+		if (found && entry.flowKey != flowKey &&
+			now - entry.activeTime <= idleTimeout) {
+			m_collisions++;
+		}
+		entry.flowKey = flowKey;
+		entry.valid = true;
+		return entry;
+	}
+
+	Entry* freeEntry = nullptr;
+	Entry* oldestEntry = nullptr;
+	uint32_t nProbes = MAX_PROBES < m_capacity ? MAX_PROBES : m_capacity;
+	for (uint32_t probe = 0; probe < nProbes; probe++) {
+		Entry& entry = m_entries[(home + probe) & m_mask];
+		if (entry.valid && entry.flowKey == flowKey) {
+			found = true;
+			return entry;
+		}
+		if (!entry.valid || now - entry.activeTime > idleTimeout) {
+			// Keep probing, the flow may own an entry further along.
+			if (freeEntry == nullptr) {
+				freeEntry = &entry;
+			}
+			continue;
+		}
+		if (probe == 0) {
+			m_collisions++;
+		}
+		if (oldestEntry == nullptr ||
+			entry.activeTime < oldestEntry->activeTime) {
+			oldestEntry = &entry;
+		}
+	}
+
+	// The flow has no entry, so claim one that is unused or idle or, failing
+	// that, evict the least recently active flow in the probe window.
+	Entry* claimed = freeEntry;
+	if (claimed == nullptr) {
+		m_evictions++;
+		claimed = oldestEntry;
+	}
+	*claimed = Entry();
+	claimed->flowKey = flowKey;
+	claimed->valid = true;
+	found = false;
+	return *claimed;
+}
+
+}  // namespace ns3
+
+#endif  // FLOW_TABLE_H
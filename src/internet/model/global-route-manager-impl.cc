@@ -25,19 +25,30 @@
 
 #include "candidate-queue.h"
 #include "global-router-interface.h"
+#include "ipv4-global-route-pool.h"
 #include "ipv4-global-routing.h"
 
 #include "ns3/assert.h"
 #include "ns3/fatal-error.h"
+#include "ns3/global-value.h"
 #include "ns3/ipv4-list-routing.h"
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/ipv4.h"
 #include "ns3/log.h"
 #include "ns3/node-list.h"
+#include "ns3/uinteger.h"
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <queue>
+#include <set>
+#include <thread>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -46,6 +57,18 @@ namespace ns3
 
 NS_LOG_COMPONENT_DEFINE("GlobalRouteManagerImpl");
 
+/**
+ * \ingroup globalrouting
+ * The number of threads InitializeRoutes spreads the SPF calculations over.
+ */
+static GlobalValue g_globalRoutingWorkers(
+    "GlobalRoutingWorkers",
+    "The number of threads used to compute global routes, 0 for one per "
+    "hardware thread.  Logging of the route manager at levels other than "
+    "info forces a serial build.",
+    UintegerValue(1),
+    MakeUintegerChecker<uint32_t>());
+
 /**
  * \brief Stream insertion operator.
  *
@@ -429,7 +452,8 @@ SPFVertex::ClearVertexProcessed()
 
 GlobalRouteManagerLSDB::GlobalRouteManagerLSDB()
     : m_database(),
-      m_extdatabase()
+      m_extdatabase(),
+      m_adjacenciesValid(false)
 {
     NS_LOG_FUNCTION(this);
 }
@@ -473,10 +497,30 @@ GlobalRouteManagerLSDB::Insert(Ipv4Address addr, GlobalRoutingLSA* lsa)
     if (lsa->GetLSType() == GlobalRoutingLSA::ASExternalLSAs)
     {
         m_extdatabase.push_back(lsa);
+        return;
     }
-    else
+    if (!m_database.insert(LSDBPair_t(addr, lsa)).second)
+    {
+        return;
+    }
+    m_adjacenciesValid = false;
+    //
+    // Index the link data of the TransitNetwork link records.  A scan of the
+    // database would find the LSA with the lowest address first, so that one
+    // is kept when several LSAs have the same link data.
+    //
+    for (uint32_t j = 0; j < lsa->GetNLinkRecords(); j++)
     {
-        m_database.insert(LSDBPair_t(addr, lsa));
+        GlobalRoutingLinkRecord* lr = lsa->GetLinkRecord(j);
+        if (lr->GetLinkType() != GlobalRoutingLinkRecord::TransitNetwork)
+        {
+            continue;
+        }
+        auto indexed = m_linkDataIndex.insert(std::make_pair(lr->GetLinkData(), lsa));
+        if (!indexed.second && addr < indexed.first->second->GetLinkStateId())
+        {
+            indexed.first->second = lsa;
+        }
     }
 }
 
@@ -501,15 +545,12 @@ GlobalRouteManagerLSDB::GetLSA(Ipv4Address addr) const
     //
     // Look up an LSA by its address.
     //
-    LSDBMap_t::const_iterator i;
-    for (i = m_database.begin(); i != m_database.end(); i++)
+    LSDBMap_t::const_iterator i = m_database.find(addr);
+    if (i == m_database.end())
     {
-        if (i->first == addr)
-        {
-            return i->second;
-        }
+        return nullptr;
     }
-    return nullptr;
+    return i->second;
 }
 
 GlobalRoutingLSA*
@@ -517,24 +558,226 @@ GlobalRouteManagerLSDB::GetLSAByLinkData(Ipv4Address addr) const
 {
     NS_LOG_FUNCTION(this << addr);
     //
-    // Look up an LSA by its address.
+    // Look up an LSA by the link data of one of its TransitNetwork records.
     //
-    LSDBMap_t::const_iterator i;
-    for (i = m_database.begin(); i != m_database.end(); i++)
+    auto i = m_linkDataIndex.find(addr);
+    if (i == m_linkDataIndex.end())
     {
-        GlobalRoutingLSA* temp = i->second;
-        // Iterate among temp's Link Records
-        for (uint32_t j = 0; j < temp->GetNLinkRecords(); j++)
+        return nullptr;
+    }
+    return i->second;
+}
+
+void
+GlobalRouteManagerLSDB::BuildAdjacencies() const
+{
+    NS_LOG_FUNCTION(this);
+    if (m_adjacenciesValid)
+    {
+        return;
+    }
+    m_adjacencies.clear();
+    m_adjacencies.reserve(m_database.size());
+    for (LSDBMap_t::const_iterator i = m_database.begin(); i != m_database.end(); i++)
+    {
+        GlobalRoutingLSA* lsa = i->second;
+        std::vector<GlobalRoutingLSA*>& adjacent = m_adjacencies[lsa];
+        if (lsa->GetLSType() == GlobalRoutingLSA::RouterLSA)
         {
-            GlobalRoutingLinkRecord* lr = temp->GetLinkRecord(j);
-            if (lr->GetLinkType() == GlobalRoutingLinkRecord::TransitNetwork &&
-                lr->GetLinkData() == addr)
+            adjacent.reserve(lsa->GetNLinkRecords());
+            for (uint32_t j = 0; j < lsa->GetNLinkRecords(); j++)
             {
-                return temp;
+                GlobalRoutingLinkRecord* l = lsa->GetLinkRecord(j);
+                if (l->GetLinkType() == GlobalRoutingLinkRecord::StubNetwork)
+                {
+                    adjacent.push_back(nullptr);
+                }
+                else
+                {
+                    adjacent.push_back(GetLSA(l->GetLinkId()));
+                }
+            }
+        }
+        else if (lsa->GetLSType() == GlobalRoutingLSA::NetworkLSA)
+        {
+            adjacent.reserve(lsa->GetNAttachedRouters());
+            for (uint32_t j = 0; j < lsa->GetNAttachedRouters(); j++)
+            {
+                adjacent.push_back(GetLSAByLinkData(lsa->GetAttachedRouter(j)));
             }
         }
     }
-    return nullptr;
+    m_adjacenciesValid = true;
+}
+
+const std::vector<GlobalRoutingLSA*>&
+GlobalRouteManagerLSDB::GetAdjacentLSAs(const GlobalRoutingLSA* lsa) const
+{
+    BuildAdjacencies();
+    auto i = m_adjacencies.find(lsa);
+    NS_ASSERT_MSG(i != m_adjacencies.end(),
+                  "GlobalRouteManagerLSDB::GetAdjacentLSAs (): LSA not in the database");
+    return i->second;
+}
+
+/**
+ * \brief Compare the link records of two LSAs
+ * \param a an LSA
+ * \param b another LSA
+ * \returns true if the LSAs have the same link records in the same order
+ */
+static bool
+SameLinkRecords(const GlobalRoutingLSA* a, const GlobalRoutingLSA* b)
+{
+    if (a->GetNLinkRecords() != b->GetNLinkRecords())
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < a->GetNLinkRecords(); i++)
+    {
+        GlobalRoutingLinkRecord* la = a->GetLinkRecord(i);
+        GlobalRoutingLinkRecord* lb = b->GetLinkRecord(i);
+        if (la->GetLinkType() != lb->GetLinkType() || la->GetLinkId() != lb->GetLinkId() ||
+            la->GetLinkData() != lb->GetLinkData() || la->GetMetric() != lb->GetMetric())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * \brief Compare the networks described by two NetworkLSAs
+ * \param a an LSA
+ * \param b another LSA
+ * \returns true if the LSAs have the same mask and attached routers
+ */
+static bool
+SameNetwork(const GlobalRoutingLSA* a, const GlobalRoutingLSA* b)
+{
+    if (a->GetNetworkLSANetworkMask() != b->GetNetworkLSANetworkMask() ||
+        a->GetNAttachedRouters() != b->GetNAttachedRouters())
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < a->GetNAttachedRouters(); i++)
+    {
+        if (a->GetAttachedRouter(i) != b->GetAttachedRouter(i))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool
+GlobalRouteManagerLSDB::GetChangedRouterLSAs(const GlobalRouteManagerLSDB& other,
+                                             std::vector<Ipv4Address>& changed) const
+{
+    NS_LOG_FUNCTION(this << &other);
+    changed.clear();
+    if (m_database.size() != other.m_database.size() ||
+        m_extdatabase.size() != other.m_extdatabase.size())
+    {
+        return false;
+    }
+    for (uint32_t j = 0; j < m_extdatabase.size(); j++)
+    {
+        const GlobalRoutingLSA* a = m_extdatabase[j];
+        const GlobalRoutingLSA* b = other.m_extdatabase[j];
+        if (a->GetLinkStateId() != b->GetLinkStateId() ||
+            a->GetAdvertisingRouter() != b->GetAdvertisingRouter() ||
+            a->GetNetworkLSANetworkMask() != b->GetNetworkLSANetworkMask())
+        {
+            return false;
+        }
+    }
+    // Both maps are sorted by link state ID, so they can be walked together.
+    LSDBMap_t::const_iterator j = other.m_database.begin();
+    for (LSDBMap_t::const_iterator i = m_database.begin(); i != m_database.end(); i++, j++)
+    {
+        const GlobalRoutingLSA* a = i->second;
+        const GlobalRoutingLSA* b = j->second;
+        if (i->first != j->first || a->GetLSType() != b->GetLSType())
+        {
+            return false;
+        }
+        if (a->GetLSType() == GlobalRoutingLSA::RouterLSA)
+        {
+            if (!SameLinkRecords(a, b))
+            {
+                changed.push_back(i->first);
+            }
+        }
+        else if (a->GetLSType() != GlobalRoutingLSA::NetworkLSA || !SameNetwork(a, b))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::unordered_map<const GlobalRoutingLSA*, uint32_t>
+GlobalRouteManagerLSDB::GetDistancesTo(const GlobalRoutingLSA* lsa) const
+{
+    NS_LOG_FUNCTION(this << lsa);
+    BuildAdjacencies();
+    //
+    // Run Dijkstra from the destination over the links reversed.  The links
+    // are those followed by SPFNext: the link records of a RouterLSA, with
+    // their metric, and the attached routers of a NetworkLSA, at no cost.
+    //
+    typedef std::pair<const GlobalRoutingLSA*, uint32_t> Link_t;
+    std::unordered_map<const GlobalRoutingLSA*, std::vector<Link_t>> reversed;
+    for (auto i = m_adjacencies.begin(); i != m_adjacencies.end(); i++)
+    {
+        const GlobalRoutingLSA* from = i->first;
+        for (uint32_t j = 0; j < i->second.size(); j++)
+        {
+            if (!i->second[j])
+            {
+                continue;
+            }
+            uint32_t metric = 0;
+            if (from->GetLSType() == GlobalRoutingLSA::RouterLSA)
+            {
+                metric = from->GetLinkRecord(j)->GetMetric();
+            }
+            reversed[i->second[j]].push_back(Link_t(from, metric));
+        }
+    }
+
+    std::unordered_map<const GlobalRoutingLSA*, uint32_t> distances;
+    typedef std::pair<uint32_t, const GlobalRoutingLSA*> Candidate_t;
+    std::priority_queue<Candidate_t, std::vector<Candidate_t>, std::greater<Candidate_t>>
+        candidates;
+    distances[lsa] = 0;
+    candidates.push(Candidate_t(0, lsa));
+    while (!candidates.empty())
+    {
+        Candidate_t c = candidates.top();
+        candidates.pop();
+        if (c.first > distances[c.second])
+        {
+            continue;
+        }
+        auto links = reversed.find(c.second);
+        if (links == reversed.end())
+        {
+            continue;
+        }
+        for (const Link_t& link : links->second)
+        {
+            uint32_t distance = c.first + link.second;
+            auto known = distances.find(link.first);
+            if (known == distances.end() || distance < known->second)
+            {
+                distances[link.first] = distance;
+                candidates.push(Candidate_t(distance, link.first));
+            }
+        }
+    }
+    return distances;
 }
 
 // ---------------------------------------------------------------------------
@@ -544,16 +787,31 @@ GlobalRouteManagerLSDB::GetLSAByLinkData(Ipv4Address addr) const
 // ---------------------------------------------------------------------------
 
 GlobalRouteManagerImpl::GlobalRouteManagerImpl()
-    : m_spfroot(nullptr)
+    : m_spfroot(nullptr),
+      m_ownsLsdb(true),
+      m_routesFromLsdb(false),
+      m_nRecalculatedRoots(0),
+      m_nSparedRoots(0)
 {
     NS_LOG_FUNCTION(this);
     m_lsdb = new GlobalRouteManagerLSDB();
 }
 
+GlobalRouteManagerImpl::GlobalRouteManagerImpl(GlobalRouteManagerLSDB* lsdb)
+    : m_spfroot(nullptr),
+      m_lsdb(lsdb),
+      m_ownsLsdb(false),
+      m_routesFromLsdb(false),
+      m_nRecalculatedRoots(0),
+      m_nSparedRoots(0)
+{
+    NS_LOG_FUNCTION(this << lsdb);
+}
+
 GlobalRouteManagerImpl::~GlobalRouteManagerImpl()
 {
     NS_LOG_FUNCTION(this);
-    if (m_lsdb)
+    if (m_lsdb && m_ownsLsdb)
     {
         delete m_lsdb;
     }
@@ -568,6 +826,7 @@ GlobalRouteManagerImpl::DebugUseLsdb(GlobalRouteManagerLSDB* lsdb)
         delete m_lsdb;
     }
     m_lsdb = lsdb;
+    m_routesFromLsdb = false;
 }
 
 void
@@ -583,19 +842,8 @@ GlobalRouteManagerImpl::DeleteGlobalRoutes()
         {
             continue;
         }
-        Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol();
-        uint32_t j = 0;
-        uint32_t nRoutes = gr->GetNRoutes();
-        NS_LOG_LOGIC("Deleting " << gr->GetNRoutes() << " routes from node " << node->GetId());
-        // Each time we delete route 0, the route index shifts downward
-        // We can delete all routes if we delete the route numbered 0
-        // nRoutes times
-        for (j = 0; j < nRoutes; j++)
-        {
-            NS_LOG_LOGIC("Deleting global route " << j << " from node " << node->GetId());
-            gr->RemoveRoute(0);
-        }
-        NS_LOG_LOGIC("Deleted " << j << " global routes from node " << node->GetId());
+        NS_LOG_LOGIC("Deleting routes from node " << node->GetId());
+        DeleteRoutes(router->GetRoutingProtocol());
     }
     if (m_lsdb)
     {
@@ -603,6 +851,14 @@ GlobalRouteManagerImpl::DeleteGlobalRoutes()
         delete m_lsdb;
         m_lsdb = new GlobalRouteManagerLSDB();
     }
+    m_routesFromLsdb = false;
+}
+
+void
+GlobalRouteManagerImpl::DeleteRoutes(Ptr<Ipv4GlobalRouting> routing)
+{
+    NS_LOG_FUNCTION(routing);
+    routing->ClearRoutes();
 }
 
 //
@@ -618,6 +874,8 @@ void
 GlobalRouteManagerImpl::BuildGlobalRoutingDatabase()
 {
     NS_LOG_FUNCTION(this);
+    auto discoveryStart = std::chrono::steady_clock::now();
+    m_routesFromLsdb = false;
     //
     // Walk the list of nodes looking for the GlobalRouter Interface.  Nodes with
     // global router interfaces are, not too surprisingly, our routers.
@@ -662,6 +920,17 @@ GlobalRouteManagerImpl::BuildGlobalRoutingDatabase()
             m_lsdb->Insert(lsa->GetLinkStateId(), lsa);
         }
     }
+    auto indexStart = std::chrono::steady_clock::now();
+    //
+    // Resolve the neighbors of every LSA once, rather than in every SPF
+    // calculation.
+    //
+    m_lsdb->BuildAdjacencies();
+    auto indexEnd = std::chrono::steady_clock::now();
+    std::chrono::duration<double> discoveryTime = indexStart - discoveryStart;
+    std::chrono::duration<double> indexTime = indexEnd - indexStart;
+    NS_LOG_INFO("LSDB built: LSA discovery " << discoveryTime.count() << " s, indexing "
+                                             << indexTime.count() << " s");
 }
 
 //
@@ -699,39 +968,477 @@ GlobalRouteManagerImpl::BuildGlobalRoutingDatabase()
 //
 void
 GlobalRouteManagerImpl::InitializeRoutes()
+{
+    NS_LOG_FUNCTION(this);
+    auto collectStart = std::chrono::steady_clock::now();
+    std::vector<SPFRoot> roots = CollectSPFRoots();
+    m_lsdb->BuildAdjacencies();
+    auto spfStart = std::chrono::steady_clock::now();
+    uint32_t nWorkers = CalculateRoutes(roots);
+    auto spfEnd = std::chrono::steady_clock::now();
+    m_routesFromLsdb = true;
+    m_nRecalculatedRoots = roots.size();
+    m_nSparedRoots = 0;
+    std::chrono::duration<double> collectTime = spfStart - collectStart;
+    std::chrono::duration<double> spfTime = spfEnd - spfStart;
+    NS_LOG_INFO("Finished SPF calculation: " << roots.size() << " roots on " << nWorkers
+                                             << " workers, router lookup " << collectTime.count()
+                                             << " s, SPF " << spfTime.count() << " s");
+    NS_LOG_INFO("Routing tables hold " << Ipv4GlobalRoutePool::Get()->GetNEntries() << " routes");
+}
+
+std::vector<GlobalRouteManagerImpl::SPFRoot>
+GlobalRouteManagerImpl::CollectSPFRoots() const
 {
     NS_LOG_FUNCTION(this);
     //
-    // Walk the list of nodes in the system.
+    // Walk the list of nodes in the system, collecting the routers.
     //
-    NS_LOG_INFO("About to start SPF calculation");
+    std::vector<SPFRoot> roots;
     NodeList::Iterator listEnd = NodeList::End();
     for (NodeList::Iterator i = NodeList::Begin(); i != listEnd; i++)
     {
-        Ptr<Node> node = *i;
-        //
-        // Look for the GlobalRouter interface that indicates that the node is
-        // participating in routing.
-        //
-        Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter>();
-
-        uint32_t systemId = Simulator::GetSystemId();
-        // Ignore nodes that are not assigned to our systemId (distributed sim)
-        if (node->GetSystemId() != systemId)
+        Ptr<Node> node = *i;
+        //
+        // Look for the GlobalRouter interface that indicates that the node is
+        // participating in routing.
+        //
+        Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter>();
+
+        uint32_t systemId = Simulator::GetSystemId();
+        // Ignore nodes that are not assigned to our systemId (distributed sim)
+        if (node->GetSystemId() != systemId)
+        {
+            continue;
+        }
+
+        //
+        // if the node has a global router interface, then run the global routing
+        // algorithms.
+        //
+        if (rtr && rtr->GetNumLSAs())
+        {
+            SPFRoot root;
+            root.routerId = rtr->GetRouterId();
+            root.nodeId = node->GetId();
+            root.ipv4 = node->GetObject<Ipv4>();
+            root.routing = rtr->GetRoutingProtocol();
+            roots.push_back(root);
+        }
+    }
+    return roots;
+}
+
+uint32_t
+GlobalRouteManagerImpl::CalculateRoutes(const std::vector<SPFRoot>& roots)
+{
+    NS_LOG_FUNCTION(this << roots.size());
+    UintegerValue workersValue;
+    g_globalRoutingWorkers.GetValue(workersValue);
+    uint32_t nWorkers = workersValue.Get();
+    if (nWorkers == 0)
+    {
+        nWorkers = std::max(std::thread::hardware_concurrency(), 1U);
+    }
+    nWorkers = std::max(std::min<uint32_t>(nWorkers, roots.size()), 1U);
+    // Log output of the calculations would interleave, so logging keeps the
+    // build serial.  Info is only logged from this thread.
+    if (g_log.IsEnabled(LOG_ERROR) || g_log.IsEnabled(LOG_WARN) || g_log.IsEnabled(LOG_DEBUG) ||
+        g_log.IsEnabled(LOG_FUNCTION) || g_log.IsEnabled(LOG_LOGIC))
+    {
+        nWorkers = 1;
+    }
+
+    NS_LOG_INFO("About to start SPF calculation");
+    // The workers only read the LSDB, so its neighbors are resolved here.
+    m_lsdb->BuildAdjacencies();
+    if (nWorkers == 1)
+    {
+        for (const SPFRoot& root : roots)
+        {
+            SPFCalculate(root);
+        }
+    }
+    else
+    {
+        SPFCalculateParallel(roots, nWorkers);
+    }
+    return nWorkers;
+}
+
+//
+// After a change of the topology, most routers keep their shortest path
+// trees.  The LSDB is rebuilt, which is cheap, and compared with the one the
+// current routes were computed from.  A router has to run its SPF
+// calculation again only if:
+//
+// - its own LSA changed;
+// - a neighbor changed the link records pointing back to it, from which its
+//   next hops are taken;
+// - a link that was removed lay on one of its shortest paths, or a link that
+//   was added lies on one of its new shortest paths.  Both are found with the
+//   distances of every router to the ends of the link.
+//
+// The trees of the other routers are unchanged, so only the routes towards
+// the addresses and stub networks of the changed LSAs are patched, using the
+// next hops the router already has towards them.
+//
+void
+GlobalRouteManagerImpl::UpdateRoutes()
+{
+    NS_LOG_FUNCTION(this);
+    if (!m_routesFromLsdb)
+    {
+        NS_LOG_LOGIC("The routes were not computed from the LSDB, rebuilding them");
+        DeleteGlobalRoutes();
+        BuildGlobalRoutingDatabase();
+        InitializeRoutes();
+        return;
+    }
+    auto updateStart = std::chrono::steady_clock::now();
+    GlobalRouteManagerLSDB* oldLsdb = m_lsdb;
+    m_lsdb = new GlobalRouteManagerLSDB();
+    BuildGlobalRoutingDatabase();
+    std::vector<SPFRoot> roots = CollectSPFRoots();
+
+    std::vector<Ipv4Address> changed;
+    if (!m_lsdb->GetChangedRouterLSAs(*oldLsdb, changed))
+    {
+        NS_LOG_LOGIC("LSAs were added, removed or changed type, recomputing every route");
+        for (const SPFRoot& root : roots)
+        {
+            if (root.routing)
+            {
+                DeleteRoutes(root.routing);
+            }
+        }
+        delete oldLsdb;
+        CalculateRoutes(roots);
+        m_routesFromLsdb = true;
+        m_nRecalculatedRoots = roots.size();
+        m_nSparedRoots = 0;
+        return;
+    }
+
+    //
+    // A link of the SPF graph that was removed from, or added to, a changed
+    // LSA.
+    //
+    struct ChangedLink
+    {
+        const GlobalRouteManagerLSDB* lsdb; // the LSDB that has the link
+        const GlobalRoutingLSA* from;
+        const GlobalRoutingLSA* to;
+        uint32_t metric;
+    };
+
+    std::vector<ChangedLink> changedLinks;
+    std::unordered_set<Ipv4Address, Ipv4AddressHash> recalculate;
+    for (Ipv4Address id : changed)
+    {
+        recalculate.insert(id);
+        const GlobalRoutingLSA* lsas[2] = {oldLsdb->GetLSA(id), m_lsdb->GetLSA(id)};
+        // The metrics and the link data of the records to each neighbor.
+        std::map<Ipv4Address, std::pair<std::set<uint32_t>, std::vector<Ipv4Address>>>
+            neighbors[2];
+        for (uint32_t k = 0; k < 2; k++)
+        {
+            for (uint32_t j = 0; j < lsas[k]->GetNLinkRecords(); j++)
+            {
+                GlobalRoutingLinkRecord* l = lsas[k]->GetLinkRecord(j);
+                if (l->GetLinkType() == GlobalRoutingLinkRecord::StubNetwork)
+                {
+                    continue;
+                }
+                neighbors[k][l->GetLinkId()].first.insert(l->GetMetric());
+                neighbors[k][l->GetLinkId()].second.push_back(l->GetLinkData());
+            }
+        }
+        for (uint32_t k = 0; k < 2; k++)
+        {
+            const GlobalRouteManagerLSDB* lsdb = k == 0 ? oldLsdb : m_lsdb;
+            for (auto i = neighbors[k].begin(); i != neighbors[k].end(); i++)
+            {
+                auto other = neighbors[1 - k].find(i->first);
+                const GlobalRoutingLSA* neighbor = lsdb->GetLSA(i->first);
+                if (!neighbor)
+                {
+                    continue;
+                }
+                // Parallel links with the same metric leave the distances as
+                // they are.
+                for (uint32_t metric : i->second.first)
+                {
+                    if (other == neighbors[1 - k].end() || !other->second.first.count(metric))
+                    {
+                        changedLinks.push_back({lsdb, lsas[k], neighbor, metric});
+                    }
+                }
+                if (other != neighbors[1 - k].end() && other->second.second == i->second.second)
+                {
+                    continue;
+                }
+                if (neighbor->GetLSType() == GlobalRoutingLSA::RouterLSA)
+                {
+                    recalculate.insert(neighbor->GetLinkStateId());
+                }
+                else
+                {
+                    for (const GlobalRoutingLSA* router : lsdb->GetAdjacentLSAs(neighbor))
+                    {
+                        if (router)
+                        {
+                            recalculate.insert(router->GetLinkStateId());
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    //
+    // Each end of a changed link costs about as much as an SPF calculation,
+    // so give up on sparing routers if there are too many of them.
+    //
+    typedef std::pair<const GlobalRouteManagerLSDB*, const GlobalRoutingLSA*> End_t;
+    std::map<End_t, std::unordered_map<const GlobalRoutingLSA*, uint32_t>> distancesTo;
+    for (const ChangedLink& link : changedLinks)
+    {
+        distancesTo[End_t(link.lsdb, link.from)];
+        distancesTo[End_t(link.lsdb, link.to)];
+    }
+    bool recalculateAll = 2 * distancesTo.size() >= roots.size();
+    if (!recalculateAll)
+    {
+        for (auto i = distancesTo.begin(); i != distancesTo.end(); i++)
+        {
+            i->second = i->first.first->GetDistancesTo(i->first.second);
+        }
+    }
+
+    std::vector<SPFRoot> recalculated;
+    uint32_t nSpared = 0;
+    for (const SPFRoot& root : roots)
+    {
+        if (!root.routing)
+        {
+            continue;
+        }
+        // The only route of a stub root is a default route over its one
+        // link, which stays right as long as that link does, wherever else
+        // the changed links lie on its reverse paths.
+        Ipv4Address nextHops[2];
+        Ipv4Address linkData[2];
+        if (GetStubRoute(oldLsdb, root.routerId, nextHops[0], linkData[0]) &&
+            GetStubRoute(m_lsdb, root.routerId, nextHops[1], linkData[1]) &&
+            nextHops[0] == nextHops[1] && linkData[0] == linkData[1])
+        {
+            nSpared++;
+            continue;
+        }
+        bool affected = recalculateAll || recalculate.count(root.routerId);
+        for (uint32_t i = 0; !affected && i < changedLinks.size(); i++)
+        {
+            const ChangedLink& link = changedLinks[i];
+            const GlobalRoutingLSA* lsa = link.lsdb->GetLSA(root.routerId);
+            const auto& toFrom = distancesTo[End_t(link.lsdb, link.from)];
+            const auto& toTo = distancesTo[End_t(link.lsdb, link.to)];
+            auto fromDistance = toFrom.find(lsa);
+            auto toDistance = toTo.find(lsa);
+            affected = fromDistance != toFrom.end() && toDistance != toTo.end() &&
+                       fromDistance->second + link.metric == toDistance->second;
+        }
+        std::vector<std::vector<SPFVertex::NodeExit_t>> exits(changed.size());
+        for (uint32_t i = 0; !affected && i < changed.size(); i++)
+        {
+            affected = !GetRootExits(root, oldLsdb->GetLSA(changed[i]), exits[i]);
+        }
+        if (affected)
+        {
+            DeleteRoutes(root.routing);
+            recalculated.push_back(root);
+            continue;
+        }
+        nSpared++;
+        for (uint32_t i = 0; i < changed.size(); i++)
+        {
+            PatchRoutes(root,
+                        oldLsdb->GetLSA(changed[i]),
+                        m_lsdb->GetLSA(changed[i]),
+                        exits[i]);
+        }
+    }
+    delete oldLsdb;
+
+    uint32_t nWorkers = CalculateRoutes(recalculated);
+    m_routesFromLsdb = true;
+    m_nRecalculatedRoots = recalculated.size();
+    m_nSparedRoots = nSpared;
+    std::chrono::duration<double> updateTime = std::chrono::steady_clock::now() - updateStart;
+    NS_LOG_INFO("Updated routes: " << changed.size() << " changed LSAs, " << recalculated.size()
+                                   << " of " << roots.size() << " roots recalculated on "
+                                   << nWorkers << " workers in " << updateTime.count() << " s");
+}
+
+uint32_t
+GlobalRouteManagerImpl::GetNRecalculatedRoots() const
+{
+    return m_nRecalculatedRoots;
+}
+
+uint32_t
+GlobalRouteManagerImpl::GetNSparedRoots() const
+{
+    return m_nSparedRoots;
+}
+
+bool
+GlobalRouteManagerImpl::GetRootExits(const SPFRoot& root,
+                                     const GlobalRoutingLSA* lsa,
+                                     std::vector<SPFVertex::NodeExit_t>& exits) const
+{
+    NS_LOG_FUNCTION(this << root.routerId << lsa);
+    exits.clear();
+    //
+    // SPFIntraAddRouter gave the root a host route to the address of every
+    // point-to-point link of the router through each exit towards it, so any
+    // of these addresses tells the exits.
+    //
+    for (uint32_t j = 0; j < lsa->GetNLinkRecords(); j++)
+    {
+        GlobalRoutingLinkRecord* l = lsa->GetLinkRecord(j);
+        if (l->GetLinkType() != GlobalRoutingLinkRecord::PointToPoint)
+        {
+            continue;
+        }
+        Ipv4Address address = l->GetLinkData();
+        for (Ipv4RoutingTableEntry* route : root.routing->GetRoutesToDst(address))
+        {
+            SPFVertex::NodeExit_t exit(route->GetGateway(), route->GetInterface());
+            if (route->IsHost() && route->GetDest() == address &&
+                std::find(exits.begin(), exits.end(), exit) == exits.end())
+            {
+                exits.push_back(exit);
+            }
+        }
+        return true;
+    }
+    // Without point-to-point links, the exits cannot be found.
+    return false;
+}
+
+void
+GlobalRouteManagerImpl::PatchRoutes(const SPFRoot& root,
+                                    const GlobalRoutingLSA* oldLsa,
+                                    const GlobalRoutingLSA* newLsa,
+                                    const std::vector<SPFVertex::NodeExit_t>& exits)
+{
+    NS_LOG_FUNCTION(this << root.routerId << oldLsa << newLsa);
+    if (exits.empty())
+    {
+        return;
+    }
+    //
+    // Count the host routes (point-to-point links) and network routes (stub
+    // networks) each LSA gives, per exit: -1 for each record of the old LSA
+    // and +1 for each record of the new one.
+    //
+    std::map<Ipv4Address, int32_t> hosts;
+    std::map<std::pair<Ipv4Address, Ipv4Address>, int32_t> networks;
+    const GlobalRoutingLSA* lsas[2] = {oldLsa, newLsa};
+    for (uint32_t k = 0; k < 2; k++)
+    {
+        int32_t count = k == 0 ? -1 : 1;
+        for (uint32_t j = 0; j < lsas[k]->GetNLinkRecords(); j++)
+        {
+            GlobalRoutingLinkRecord* l = lsas[k]->GetLinkRecord(j);
+            if (l->GetLinkType() == GlobalRoutingLinkRecord::PointToPoint)
+            {
+                hosts[l->GetLinkData()] += count;
+            }
+            else if (l->GetLinkType() == GlobalRoutingLinkRecord::StubNetwork)
+            {
+                Ipv4Mask mask(l->GetLinkData().Get());
+                networks[std::make_pair(l->GetLinkId().CombineMask(mask), l->GetLinkData())] +=
+                    count;
+            }
+        }
+    }
+    Ptr<Ipv4GlobalRouting> gr = root.routing;
+    for (auto i = hosts.begin(); i != hosts.end(); i++)
+    {
+        for (int32_t n = i->second; n < 0; n++)
+        {
+            for (const SPFVertex::NodeExit_t& exit : exits)
+            {
+                gr->RemoveHostRouteTo(i->first, exit.first, exit.second);
+            }
+        }
+        for (int32_t n = 0; n < i->second; n++)
+        {
+            for (const SPFVertex::NodeExit_t& exit : exits)
+            {
+                gr->AddHostRouteTo(i->first, exit.first, exit.second);
+            }
+        }
+    }
+    for (auto i = networks.begin(); i != networks.end(); i++)
+    {
+        Ipv4Mask mask(i->first.second.Get());
+        for (int32_t n = i->second; n < 0; n++)
         {
-            continue;
+            for (const SPFVertex::NodeExit_t& exit : exits)
+            {
+                gr->RemoveNetworkRouteTo(i->first.first, mask, exit.first, exit.second);
+            }
+        }
+        for (int32_t n = 0; n < i->second; n++)
+        {
+            for (const SPFVertex::NodeExit_t& exit : exits)
+            {
+                gr->AddNetworkRouteTo(i->first.first, mask, exit.first, exit.second);
+            }
         }
+    }
+}
 
-        //
-        // if the node has a global router interface, then run the global routing
-        // algorithms.
-        //
-        if (rtr && rtr->GetNumLSAs())
+void
+GlobalRouteManagerImpl::SPFCalculateParallel(const std::vector<SPFRoot>& roots, uint32_t nWorkers)
+{
+    NS_LOG_FUNCTION(this << roots.size() << nWorkers);
+
+    //
+    // Each root writes only to its own routing table, so the roots can be
+    // handed out in any order.  The workers share the LSDB, which is only
+    // read, and keep the SPF state of the LSAs to themselves.  They must not
+    // touch any object other than the root they are working on, which is why
+    // the roots were looked up above.
+    //
+    std::atomic<uint32_t> nextRoot(0);
+    auto work = [&roots, &nextRoot](GlobalRouteManagerImpl* worker) {
+        for (uint32_t r = nextRoot++; r < roots.size(); r = nextRoot++)
         {
-            SPFCalculate(rtr->GetRouterId());
+            worker->SPFCalculate(roots[r]);
         }
+    };
+    std::vector<std::unique_ptr<GlobalRouteManagerImpl>> workers;
+    std::vector<std::thread> threads;
+    for (uint32_t w = 0; w < nWorkers; w++)
+    {
+        workers.emplace_back(new GlobalRouteManagerImpl(m_lsdb));
+    }
+    // The routing tables all store their routes in the one pool.
+    Ipv4GlobalRoutePool::Get()->SetConcurrent(true);
+    for (uint32_t w = 1; w < nWorkers; w++)
+    {
+        threads.emplace_back(work, workers[w].get());
+    }
+    work(workers[0].get());
+    for (std::thread& thread : threads)
+    {
+        thread.join();
     }
-    NS_LOG_INFO("Finished SPF calculation");
+    Ipv4GlobalRoutePool::Get()->SetConcurrent(false);
 }
 
 //
@@ -769,6 +1476,11 @@ GlobalRouteManagerImpl::SPFNext(SPFVertex* v, CandidateQueue& candidate)
     {
         numRecordsInVertex = v->GetLSA()->GetNAttachedRouters();
     }
+    //
+    // The LSAs at the other end of each link were resolved when the LSDB was
+    // built.
+    //
+    const std::vector<GlobalRoutingLSA*>& adjacent = m_lsdb->GetAdjacentLSAs(v->GetLSA());
 
     for (uint32_t i = 0; i < numRecordsInVertex; i++)
     {
@@ -800,14 +1512,14 @@ GlobalRouteManagerImpl::SPFNext(SPFVertex* v, CandidateQueue& candidate)
                 // Lookup the link state advertisement of the new link -- we call it <w> in
                 // the link state database.
                 //
-                w_lsa = m_lsdb->GetLSA(l->GetLinkId());
+                w_lsa = adjacent[i];
                 NS_ASSERT(w_lsa);
                 NS_LOG_LOGIC("Found a P2P record from " << v->GetVertexId() << " to "
                                                         << w_lsa->GetLinkStateId());
             }
             else if (l->GetLinkType() == GlobalRoutingLinkRecord::TransitNetwork)
             {
-                w_lsa = m_lsdb->GetLSA(l->GetLinkId());
+                w_lsa = adjacent[i];
                 NS_ASSERT(w_lsa);
                 NS_LOG_LOGIC("Found a Transit record from " << v->GetVertexId() << " to "
                                                             << w_lsa->GetLinkStateId());
@@ -820,7 +1532,7 @@ GlobalRouteManagerImpl::SPFNext(SPFVertex* v, CandidateQueue& candidate)
         // Get w_lsa:  In case of V is Network-LSA
         if (v->GetVertexType() == SPFVertex::VertexNetwork)
         {
-            w_lsa = m_lsdb->GetLSAByLinkData(v->GetLSA()->GetAttachedRouter(i));
+            w_lsa = adjacent[i];
             if (!w_lsa)
             {
                 continue;
@@ -837,7 +1549,7 @@ GlobalRouteManagerImpl::SPFNext(SPFVertex* v, CandidateQueue& candidate)
         // If the link is to a router that is already in the shortest path first tree
         // then we have it covered -- ignore it.
         //
-        if (w_lsa->GetStatus() == GlobalRoutingLSA::LSA_SPF_IN_SPFTREE)
+        if (GetLSAStatus(w_lsa) == GlobalRoutingLSA::LSA_SPF_IN_SPFTREE)
         {
             NS_LOG_LOGIC("Skipping ->  LSA " << w_lsa->GetLinkStateId() << " already in SPF tree");
             continue;
@@ -861,7 +1573,7 @@ GlobalRouteManagerImpl::SPFNext(SPFVertex* v, CandidateQueue& candidate)
         NS_LOG_LOGIC("Considering w_lsa " << w_lsa->GetLinkStateId());
 
         // Is there already vertex w in candidate list?
-        if (w_lsa->GetStatus() == GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED)
+        if (GetLSAStatus(w_lsa) == GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED)
         {
             // Calculate nexthop to w
             // We need to figure out how to actually get to the new router represented
@@ -873,7 +1585,7 @@ GlobalRouteManagerImpl::SPFNext(SPFVertex* v, CandidateQueue& candidate)
             w = new SPFVertex(w_lsa);
             if (SPFNexthopCalculation(v, w, l, distance))
             {
-                w_lsa->SetStatus(GlobalRoutingLSA::LSA_SPF_CANDIDATE);
+                SetLSAStatus(w_lsa, GlobalRoutingLSA::LSA_SPF_CANDIDATE);
                 //
                 // Push this new vertex onto the priority queue (ordered by distance from the
                 // root node).
@@ -890,7 +1602,7 @@ GlobalRouteManagerImpl::SPFNext(SPFVertex* v, CandidateQueue& candidate)
                                   << "return false, but it does now!");
             }
         }
-        else if (w_lsa->GetStatus() == GlobalRoutingLSA::LSA_SPF_CANDIDATE)
+        else if (GetLSAStatus(w_lsa) == GlobalRoutingLSA::LSA_SPF_CANDIDATE)
         {
             //
             // We have already considered the link represented by <w>.  What wse have to
@@ -1257,97 +1969,157 @@ bool
 GlobalRouteManagerImpl::CheckForStubNode(Ipv4Address root)
 {
     NS_LOG_FUNCTION(this << root);
+    Ipv4Address nextHop;
+    Ipv4Address linkData;
+    if (GetStubRoute(m_lsdb, root, nextHop, linkData))
+    {
+        // Install default route to next hop
+        Ptr<Ipv4GlobalRouting> gr = m_spfrootNode.routing;
+        NS_ASSERT(gr);
+        uint32_t interface = FindOutgoingInterfaceId(linkData);
+        gr->AddNetworkRouteTo(Ipv4Address("0.0.0.0"), Ipv4Mask("0.0.0.0"), nextHop, interface);
+        NS_LOG_LOGIC("Inserting default route for node " << root << " to next hop " << nextHop
+                                                         << " via interface " << interface);
+        return true;
+    }
     GlobalRoutingLSA* rlsa = m_lsdb->GetLSA(root);
-    Ipv4Address myRouterId = rlsa->GetLinkStateId();
-    int transits = 0;
-    GlobalRoutingLinkRecord* transitLink = nullptr;
     for (uint32_t i = 0; i < rlsa->GetNLinkRecords(); i++)
     {
         GlobalRoutingLinkRecord* l = rlsa->GetLinkRecord(i);
-        if (l->GetLinkType() == GlobalRoutingLinkRecord::TransitNetwork)
+        if (l->GetLinkType() == GlobalRoutingLinkRecord::TransitNetwork ||
+            l->GetLinkType() == GlobalRoutingLinkRecord::PointToPoint)
         {
-            transits++;
-            transitLink = l;
+            // A single transit network would need a default route to the
+            // one router on it with other transit links.  Not yet
+            // implemented, so SPF is run for it as for any other router.
+            return false;
         }
-        else if (l->GetLinkType() == GlobalRoutingLinkRecord::PointToPoint)
+    }
+    // This router is not connected to any router.  Probably, global
+    // routing should not be called for this node, but we can just raise
+    // a warning here and return true.
+    NS_LOG_WARN("all nodes should have at least one transit link:" << root);
+    return true;
+}
+
+bool
+GlobalRouteManagerImpl::GetStubRoute(const GlobalRouteManagerLSDB* lsdb,
+                                     Ipv4Address root,
+                                     Ipv4Address& nextHop,
+                                     Ipv4Address& linkData)
+{
+    const GlobalRoutingLSA* rlsa = lsdb->GetLSA(root);
+    if (!rlsa)
+    {
+        return false;
+    }
+    uint32_t transits = 0;
+    const GlobalRoutingLinkRecord* transitLink = nullptr;
+    for (uint32_t i = 0; i < rlsa->GetNLinkRecords(); i++)
+    {
+        const GlobalRoutingLinkRecord* l = rlsa->GetLinkRecord(i);
+        if (l->GetLinkType() == GlobalRoutingLinkRecord::TransitNetwork ||
+            l->GetLinkType() == GlobalRoutingLinkRecord::PointToPoint)
         {
             transits++;
             transitLink = l;
         }
     }
-    if (transits == 0)
+    if (transits != 1 || transitLink->GetLinkType() != GlobalRoutingLinkRecord::PointToPoint)
     {
-        // This router is not connected to any router.  Probably, global
-        // routing should not be called for this node, but we can just raise
-        // a warning here and return true.
-        NS_LOG_WARN("all nodes should have at least one transit link:" << root);
-        return true;
+        return false;
+    }
+    //
+    // The link record LinkID is the router ID of the peer, and the Link Data
+    // is the local IP interface address.  The next hop is the Link Data of
+    // the record of the peer that links back to this router.
+    //
+    const GlobalRoutingLSA* w_lsa = lsdb->GetLSA(transitLink->GetLinkId());
+    if (!w_lsa)
+    {
+        return false;
     }
-    if (transits == 1)
+    for (uint32_t j = 0; j < w_lsa->GetNLinkRecords(); ++j)
     {
-        if (transitLink->GetLinkType() == GlobalRoutingLinkRecord::TransitNetwork)
+        const GlobalRoutingLinkRecord* lr = w_lsa->GetLinkRecord(j);
+        if (lr->GetLinkType() == GlobalRoutingLinkRecord::PointToPoint &&
+            lr->GetLinkId() == root)
         {
-            // Install default route to next hop router
-            // What is the next hop?  We need to check all neighbors on the link.
-            // If there is a single router that has two transit links, then
-            // that is the default next hop.  If there are more than one
-            // routers on link with multiple transit links, return false.
-            // Not yet implemented, so simply return false
-            NS_LOG_LOGIC("TBD: Would have inserted default for transit");
-            return false;
+            nextHop = lr->GetLinkData();
+            linkData = transitLink->GetLinkData();
+            return true;
         }
-        else if (transitLink->GetLinkType() == GlobalRoutingLinkRecord::PointToPoint)
+    }
+    return false;
+}
+
+GlobalRouteManagerImpl::SPFRoot
+GlobalRouteManagerImpl::LookupSPFRoot(Ipv4Address routerId) const
+{
+    NS_LOG_FUNCTION(this << routerId);
+    SPFRoot root;
+    root.routerId = routerId;
+    root.nodeId = 0;
+    //
+    // Walk the list of nodes looking for the one that has the router ID.  If
+    // there is none (as in the unit tests) the SPF tree is still built, but
+    // no routes are written.
+    //
+    NodeList::Iterator listEnd = NodeList::End();
+    for (NodeList::Iterator i = NodeList::Begin(); i != listEnd; i++)
+    {
+        Ptr<Node> node = *i;
+        Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter>();
+        if (rtr && rtr->GetRouterId() == routerId)
         {
-            // Install default route to next hop
-            // The link record LinkID is the router ID of the peer.
-            // The Link Data is the local IP interface address
-            GlobalRoutingLSA* w_lsa = m_lsdb->GetLSA(transitLink->GetLinkId());
-            uint32_t nLinkRecords = w_lsa->GetNLinkRecords();
-            for (uint32_t j = 0; j < nLinkRecords; ++j)
-            {
-                //
-                // We are only concerned about point-to-point links
-                //
-                GlobalRoutingLinkRecord* lr = w_lsa->GetLinkRecord(j);
-                if (lr->GetLinkType() != GlobalRoutingLinkRecord::PointToPoint)
-                {
-                    continue;
-                }
-                // Find the link record that corresponds to our routerId
-                if (lr->GetLinkId() == myRouterId)
-                {
-                    // Next hop is stored in the LinkID field of lr
-                    Ptr<GlobalRouter> router = rlsa->GetNode()->GetObject<GlobalRouter>();
-                    NS_ASSERT(router);
-                    Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol();
-                    NS_ASSERT(gr);
-                    gr->AddNetworkRouteTo(Ipv4Address("0.0.0.0"),
-                                          Ipv4Mask("0.0.0.0"),
-                                          lr->GetLinkData(),
-                                          FindOutgoingInterfaceId(transitLink->GetLinkData()));
-                    NS_LOG_LOGIC("Inserting default route for node "
-                                 << myRouterId << " to next hop " << lr->GetLinkData()
-                                 << " via interface "
-                                 << FindOutgoingInterfaceId(transitLink->GetLinkData()));
-                    return true;
-                }
-            }
+            root.nodeId = node->GetId();
+            root.ipv4 = node->GetObject<Ipv4>();
+            root.routing = rtr->GetRoutingProtocol();
+            break;
         }
     }
-    return false;
+    return root;
+}
+
+GlobalRoutingLSA::SPFStatus
+GlobalRouteManagerImpl::GetLSAStatus(const GlobalRoutingLSA* lsa) const
+{
+    auto i = m_lsaStatus.find(lsa);
+    if (i == m_lsaStatus.end())
+    {
+        return GlobalRoutingLSA::LSA_SPF_NOT_EXPLORED;
+    }
+    return i->second;
+}
+
+void
+GlobalRouteManagerImpl::SetLSAStatus(const GlobalRoutingLSA* lsa,
+                                     GlobalRoutingLSA::SPFStatus status)
+{
+    m_lsaStatus[lsa] = status;
 }
 
-// quagga ospf_spf_calculate
 void
 GlobalRouteManagerImpl::SPFCalculate(Ipv4Address root)
 {
     NS_LOG_FUNCTION(this << root);
+    SPFCalculate(LookupSPFRoot(root));
+}
+
+// quagga ospf_spf_calculate
+void
+GlobalRouteManagerImpl::SPFCalculate(const SPFRoot& spfRoot)
+{
+    Ipv4Address root = spfRoot.routerId;
+    NS_LOG_FUNCTION(this << root);
 
     SPFVertex* v;
     //
-    // Initialize the Link State Database.
+    // Every LSA starts out unexplored.  Clearing keeps the buckets allocated
+    // for the next root.
     //
-    m_lsdb->Initialize();
+    m_lsaStatus.clear();
+    m_spfrootNode = spfRoot;
     //
     // The candidate queue is a priority queue of SPFVertex objects, with the top
     // of the queue being the closest vertex in terms of distance from the root
@@ -1367,7 +2139,7 @@ GlobalRouteManagerImpl::SPFCalculate(Ipv4Address root)
     //
     m_spfroot = v;
     v->SetDistanceFromRoot(0);
-    v->GetLSA()->SetStatus(GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
+    SetLSAStatus(v->GetLSA(), GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
     NS_LOG_LOGIC("Starting SPFCalculate for node " << root);
 
     //
@@ -1377,10 +2149,12 @@ GlobalRouteManagerImpl::SPFCalculate(Ipv4Address root)
     // reached.  Instead, short-circuit this computation and just install
     // a default route in the CheckForStubNode() method.
     //
-    if (NodeList::GetNNodes() > 0 && CheckForStubNode(root))
+    if (m_spfrootNode.routing && CheckForStubNode(root))
     {
         NS_LOG_LOGIC("SPFCalculate truncated for stub node " << root);
         delete m_spfroot;
+        m_spfroot = nullptr;
+        m_spfrootNode = SPFRoot();
         return;
     }
 
@@ -1428,7 +2202,7 @@ GlobalRouteManagerImpl::SPFCalculate(Ipv4Address root)
         // Update the status field of the vertex to indicate that it is in the SPF
         // tree.
         //
-        v->GetLSA()->SetStatus(GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
+        SetLSAStatus(v->GetLSA(), GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
         //
         // The current vertex has a parent pointer.  By calling this rather oddly
         // named method (blame quagga) we add the current vertex to the list of
@@ -1502,6 +2276,7 @@ GlobalRouteManagerImpl::SPFCalculate(Ipv4Address root)
     //
     delete m_spfroot;
     m_spfroot = nullptr;
+    m_spfrootNode = SPFRoot();
 }
 
 void
@@ -1554,109 +2329,48 @@ GlobalRouteManagerImpl::SPFAddASExternal(GlobalRoutingLSA* extlsa, SPFVertex* v)
     NS_LOG_LOGIC("External is on remote host: " << extlsa->GetAdvertisingRouter()
                                                 << "; installing");
 
-    Ipv4Address routerId = m_spfroot->GetVertexId();
-
-    NS_LOG_LOGIC("Vertex ID = " << routerId);
     //
-    // We need to walk the list of nodes looking for the one that has the router
-    // ID corresponding to the root vertex.  This is the one we're going to write
-    // the routing information to.
+    // The routing information is written to the node at the root of the SPF
+    // tree, which was looked up when the calculation started.
     //
-    NodeList::Iterator i = NodeList::Begin();
-    NodeList::Iterator listEnd = NodeList::End();
-    for (; i != listEnd; i++)
+    Ptr<Ipv4GlobalRouting> gr = m_spfrootNode.routing;
+    if (!gr)
     {
-        Ptr<Node> node = *i;
-        //
-        // The router ID is accessible through the GlobalRouter interface, so we need
-        // to QI for that interface.  If there's no GlobalRouter interface, the node
-        // in question cannot be the router we want, so we continue.
-        //
-        Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter>();
-
-        if (!rtr)
+        NS_LOG_LOGIC("No node has router ID " << m_spfroot->GetVertexId());
+        return;
+    }
+    uint32_t nodeId = m_spfrootNode.nodeId;
+    NS_LOG_LOGIC("Setting routes for node " << nodeId);
+    NS_ASSERT_MSG(v->GetLSA(),
+                  "GlobalRouteManagerImpl::SPFAddASExternal (): "
+                  "Expected valid LSA in SPFVertex* v");
+    Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask();
+    Ipv4Address tempip = extlsa->GetLinkStateId();
+    tempip = tempip.CombineMask(tempmask);
+
+    // walk through all next-hop-IPs and out-going-interfaces for reaching
+    // the stub network gateway 'v' from the root node
+    for (uint32_t i = 0; i < v->GetNRootExitDirections(); i++)
+    {
+        SPFVertex::NodeExit_t exit = v->GetRootExitDirection(i);
+        Ipv4Address nextHop = exit.first;
+        int32_t outIf = exit.second;
+        if (outIf >= 0)
         {
-            NS_LOG_LOGIC("No GlobalRouter interface on node " << node->GetId());
-            continue;
+            gr->AddASExternalRouteTo(tempip, tempmask, nextHop, outIf);
+            NS_LOG_LOGIC("(Route " << i << ") Node " << nodeId
+                                   << " add external network route to " << tempip
+                                   << " using next hop " << nextHop << " via interface "
+                                   << outIf);
         }
-        //
-        // If the router ID of the current node is equal to the router ID of the
-        // root of the SPF tree, then this node is the one for which we need to
-        // write the routing tables.
-        //
-        NS_LOG_LOGIC("Considering router " << rtr->GetRouterId());
-
-        if (rtr->GetRouterId() == routerId)
+        else
         {
-            NS_LOG_LOGIC("Setting routes for node " << node->GetId());
-            //
-            // Routing information is updated using the Ipv4 interface.  We need to QI
-            // for that interface.  If the node is acting as an IP version 4 router, it
-            // should absolutely have an Ipv4 interface.
-            //
-            Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
-            NS_ASSERT_MSG(ipv4,
-                          "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                          "QI for <Ipv4> interface failed");
-            //
-            // Get the Global Router Link State Advertisement from the vertex we're
-            // adding the routes to.  The LSA will have a number of attached Global Router
-            // Link Records corresponding to links off of that vertex / node.  We're going
-            // to be interested in the records corresponding to point-to-point links.
-            //
-            NS_ASSERT_MSG(v->GetLSA(),
-                          "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                          "Expected valid LSA in SPFVertex* v");
-            Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask();
-            Ipv4Address tempip = extlsa->GetLinkStateId();
-            tempip = tempip.CombineMask(tempmask);
-
-            //
-            // Here's why we did all of that work.  We're going to add a host route to the
-            // host address found in the m_linkData field of the point-to-point link
-            // record.  In the case of a point-to-point link, this is the local IP address
-            // of the node connected to the link.  Each of these point-to-point links
-            // will correspond to a local interface that has an IP address to which
-            // the node at the root of the SPF tree can send packets.  The vertex <v>
-            // (corresponding to the node that has these links and interfaces) has
-            // an m_nextHop address precalculated for us that is the address to which the
-            // root node should send packets to be forwarded to these IP addresses.
-            // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
-            // which the packets should be send for forwarding.
-            //
-            Ptr<GlobalRouter> router = node->GetObject<GlobalRouter>();
-            if (!router)
-            {
-                continue;
-            }
-            Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol();
-            NS_ASSERT(gr);
-            // walk through all next-hop-IPs and out-going-interfaces for reaching
-            // the stub network gateway 'v' from the root node
-            for (uint32_t i = 0; i < v->GetNRootExitDirections(); i++)
-            {
-                SPFVertex::NodeExit_t exit = v->GetRootExitDirection(i);
-                Ipv4Address nextHop = exit.first;
-                int32_t outIf = exit.second;
-                if (outIf >= 0)
-                {
-                    gr->AddASExternalRouteTo(tempip, tempmask, nextHop, outIf);
-                    NS_LOG_LOGIC("(Route " << i << ") Node " << node->GetId()
-                                           << " add external network route to " << tempip
-                                           << " using next hop " << nextHop << " via interface "
-                                           << outIf);
-                }
-                else
-                {
-                    NS_LOG_LOGIC("(Route " << i << ") Node " << node->GetId()
-                                           << " NOT able to add network route to " << tempip
-                                           << " using next hop " << nextHop
-                                           << " since outgoing interface id is negative");
-                }
-            }
-            return;
-        } // if
-    }     // for
+            NS_LOG_LOGIC("(Route " << i << ") Node " << nodeId
+                                   << " NOT able to add network route to " << tempip
+                                   << " using next hop " << nextHop
+                                   << " since outgoing interface id is negative");
+        }
+    }
 }
 
 // Processing logic from RFC 2328, page 166 and quagga ospf_spf_process_stubs ()
@@ -1715,114 +2429,49 @@ GlobalRouteManagerImpl::SPFIntraAddStub(GlobalRoutingLinkRecord* l, SPFVertex* v
     NS_LOG_LOGIC("Stub is on remote host: " << v->GetVertexId() << "; installing");
     //
     // The root of the Shortest Path First tree is the router to which we are
-    // going to write the actual routing table entries.  The vertex corresponding
-    // to this router has a vertex ID which is the router ID of that node.  We're
-    // going to use this ID to discover which node it is that we're actually going
-    // to update.
+    // going to write the actual routing table entries.  Its routing table was
+    // looked up when the calculation started.
     //
-    Ipv4Address routerId = m_spfroot->GetVertexId();
-
-    NS_LOG_LOGIC("Vertex ID = " << routerId);
+    Ptr<Ipv4GlobalRouting> gr = m_spfrootNode.routing;
+    if (!gr)
+    {
+        NS_LOG_LOGIC("No node has router ID " << m_spfroot->GetVertexId());
+        return;
+    }
+    uint32_t nodeId = m_spfrootNode.nodeId;
+    NS_LOG_LOGIC("Setting routes for node " << nodeId);
+    NS_ASSERT_MSG(v->GetLSA(),
+                  "GlobalRouteManagerImpl::SPFIntraAddStub (): "
+                  "Expected valid LSA in SPFVertex* v");
+    Ipv4Mask tempmask(l->GetLinkData().Get());
+    Ipv4Address tempip = l->GetLinkId();
+    tempip = tempip.CombineMask(tempmask);
     //
-    // We need to walk the list of nodes looking for the one that has the router
-    // ID corresponding to the root vertex.  This is the one we're going to write
-    // the routing information to.
+    // The vertex <v> has the next hops and outbound interfaces the root node
+    // uses to reach it, so the stub network is reached the same way.
     //
-    NodeList::Iterator i = NodeList::Begin();
-    NodeList::Iterator listEnd = NodeList::End();
-    for (; i != listEnd; i++)
+    // walk through all next-hop-IPs and out-going-interfaces for reaching
+    // the stub network gateway 'v' from the root node
+    for (uint32_t i = 0; i < v->GetNRootExitDirections(); i++)
     {
-        Ptr<Node> node = *i;
-        //
-        // The router ID is accessible through the GlobalRouter interface, so we need
-        // to QI for that interface.  If there's no GlobalRouter interface, the node
-        // in question cannot be the router we want, so we continue.
-        //
-        Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter>();
-
-        if (!rtr)
+        SPFVertex::NodeExit_t exit = v->GetRootExitDirection(i);
+        Ipv4Address nextHop = exit.first;
+        int32_t outIf = exit.second;
+        if (outIf >= 0)
         {
-            NS_LOG_LOGIC("No GlobalRouter interface on node " << node->GetId());
-            continue;
+            gr->AddNetworkRouteTo(tempip, tempmask, nextHop, outIf);
+            NS_LOG_LOGIC("(Route " << i << ") Node " << nodeId << " add network route to "
+                                   << tempip << " using next hop " << nextHop
+                                   << " via interface " << outIf);
         }
-        //
-        // If the router ID of the current node is equal to the router ID of the
-        // root of the SPF tree, then this node is the one for which we need to
-        // write the routing tables.
-        //
-        NS_LOG_LOGIC("Considering router " << rtr->GetRouterId());
-
-        if (rtr->GetRouterId() == routerId)
+        else
         {
-            NS_LOG_LOGIC("Setting routes for node " << node->GetId());
-            //
-            // Routing information is updated using the Ipv4 interface.  We need to QI
-            // for that interface.  If the node is acting as an IP version 4 router, it
-            // should absolutely have an Ipv4 interface.
-            //
-            Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
-            NS_ASSERT_MSG(ipv4,
-                          "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                          "QI for <Ipv4> interface failed");
-            //
-            // Get the Global Router Link State Advertisement from the vertex we're
-            // adding the routes to.  The LSA will have a number of attached Global Router
-            // Link Records corresponding to links off of that vertex / node.  We're going
-            // to be interested in the records corresponding to point-to-point links.
-            //
-            NS_ASSERT_MSG(v->GetLSA(),
-                          "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                          "Expected valid LSA in SPFVertex* v");
-            Ipv4Mask tempmask(l->GetLinkData().Get());
-            Ipv4Address tempip = l->GetLinkId();
-            tempip = tempip.CombineMask(tempmask);
-            //
-            // Here's why we did all of that work.  We're going to add a host route to the
-            // host address found in the m_linkData field of the point-to-point link
-            // record.  In the case of a point-to-point link, this is the local IP address
-            // of the node connected to the link.  Each of these point-to-point links
-            // will correspond to a local interface that has an IP address to which
-            // the node at the root of the SPF tree can send packets.  The vertex <v>
-            // (corresponding to the node that has these links and interfaces) has
-            // an m_nextHop address precalculated for us that is the address to which the
-            // root node should send packets to be forwarded to these IP addresses.
-            // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
-            // which the packets should be send for forwarding.
-            //
-
-            Ptr<GlobalRouter> router = node->GetObject<GlobalRouter>();
-            if (!router)
-            {
-                continue;
-            }
-            Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol();
-            NS_ASSERT(gr);
-            // walk through all next-hop-IPs and out-going-interfaces for reaching
-            // the stub network gateway 'v' from the root node
-            for (uint32_t i = 0; i < v->GetNRootExitDirections(); i++)
-            {
-                SPFVertex::NodeExit_t exit = v->GetRootExitDirection(i);
-                Ipv4Address nextHop = exit.first;
-                int32_t outIf = exit.second;
-                if (outIf >= 0)
-                {
-                    gr->AddNetworkRouteTo(tempip, tempmask, nextHop, outIf);
-                    NS_LOG_LOGIC("(Route " << i << ") Node " << node->GetId()
-                                           << " add network route to " << tempip
-                                           << " using next hop " << nextHop << " via interface "
-                                           << outIf);
-                }
-                else
-                {
-                    NS_LOG_LOGIC("(Route " << i << ") Node " << node->GetId()
-                                           << " NOT able to add network route to " << tempip
-                                           << " using next hop " << nextHop
-                                           << " since outgoing interface id is negative");
-                }
-            }
-            return;
-        } // if
-    }     // for
+            NS_LOG_LOGIC("(Route " << i << ") Node " << nodeId
+                                   << " NOT able to add network route to " << tempip
+                                   << " using next hop " << nextHop
+                                   << " since outgoing interface id is negative");
+        }
+    }
 }
 
 //
@@ -1837,69 +2486,26 @@ GlobalRouteManagerImpl::FindOutgoingInterfaceId(Ipv4Address a, Ipv4Mask amask)
 {
     NS_LOG_FUNCTION(this << a << amask);
     //
-    // We have an IP address <a> and a vertex ID of the root of the SPF tree.
-    // The question is what interface index does this address correspond to.
-    // The answer is a little complicated since we have to find a pointer to
-    // the node corresponding to the vertex ID, find the Ipv4 interface on that
-    // node in order to iterate the interfaces and find the one corresponding to
-    // the address in question.
-    //
-    Ipv4Address routerId = m_spfroot->GetVertexId();
+    // We have an IP address <a> and the node at the root of the SPF tree.  The
+    // question is what interface index on that node this address corresponds
+    // to.
     //
-    // Walk the list of nodes in the system looking for the one corresponding to
-    // the node at the root of the SPF tree.  This is the node for which we are
-    // building the routing table.
-    //
-    NodeList::Iterator i = NodeList::Begin();
-    NodeList::Iterator listEnd = NodeList::End();
-    for (; i != listEnd; i++)
+    Ptr<Ipv4> ipv4 = m_spfrootNode.ipv4;
+    if (!ipv4)
     {
-        Ptr<Node> node = *i;
-
-        Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter>();
         //
-        // If the node doesn't have a GlobalRouter interface it can't be the one
-        // we're interested in.
+        // Couldn't find it.
         //
-        if (!rtr)
-        {
-            continue;
-        }
-
-        if (rtr->GetRouterId() == routerId)
-        {
-            //
-            // This is the node we're building the routing table for.  We're going to need
-            // the Ipv4 interface to look for the ipv4 interface index.  Since this node
-            // is participating in routing IP version 4 packets, it certainly must have
-            // an Ipv4 interface.
-            //
-            Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
-            NS_ASSERT_MSG(ipv4,
-                          "GlobalRouteManagerImpl::FindOutgoingInterfaceId (): "
-                          "GetObject for <Ipv4> interface failed");
-            //
-            // Look through the interfaces on this node for one that has the IP address
-            // we're looking for.  If we find one, return the corresponding interface
-            // index, or -1 if not found.
-            //
-            int32_t interface = ipv4->GetInterfaceForPrefix(a, amask);
-
-#if 0
-          if (interface < 0)
-            {
-              NS_FATAL_ERROR ("GlobalRouteManagerImpl::FindOutgoingInterfaceId(): "
-                              "Expected an interface associated with address a:" << a);
-            }
-#endif
-            return interface;
-        }
+        NS_LOG_LOGIC("FindOutgoingInterfaceId():Can't find root node "
+                     << m_spfroot->GetVertexId());
+        return -1;
     }
     //
-    // Couldn't find it.
+    // Look through the interfaces on this node for one that has the IP address
+    // we're looking for.  If we find one, return the corresponding interface
+    // index, or -1 if not found.
     //
-    NS_LOG_LOGIC("FindOutgoingInterfaceId():Can't find root node " << routerId);
-    return -1;
+    return ipv4->GetInterfaceForPrefix(a, amask);
 }
 
 //
@@ -1926,139 +2532,85 @@ GlobalRouteManagerImpl::SPFIntraAddRouter(SPFVertex* v)
     NS_ASSERT_MSG(m_spfroot, "GlobalRouteManagerImpl::SPFIntraAddRouter (): Root pointer not set");
     //
     // The root of the Shortest Path First tree is the router to which we are
-    // going to write the actual routing table entries.  The vertex corresponding
-    // to this router has a vertex ID which is the router ID of that node.  We're
-    // going to use this ID to discover which node it is that we're actually going
-    // to update.
+    // going to write the actual routing table entries.  Its routing table was
+    // looked up when the calculation started.
+    //
+    Ptr<Ipv4GlobalRouting> gr = m_spfrootNode.routing;
+    if (!gr)
+    {
+        NS_LOG_LOGIC("No node has router ID " << m_spfroot->GetVertexId());
+        return;
+    }
+    uint32_t nodeId = m_spfrootNode.nodeId;
+    NS_LOG_LOGIC("Setting routes for node " << nodeId);
+    //
+    // Get the Global Router Link State Advertisement from the vertex we're
+    // adding the routes to.  The LSA will have a number of attached Global Router
+    // Link Records corresponding to links off of that vertex / node.  We're going
+    // to be interested in the records corresponding to point-to-point links.
     //
-    Ipv4Address routerId = m_spfroot->GetVertexId();
+    GlobalRoutingLSA* lsa = v->GetLSA();
+    NS_ASSERT_MSG(lsa,
+                  "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                  "Expected valid LSA in SPFVertex* v");
 
-    NS_LOG_LOGIC("Vertex ID = " << routerId);
+    uint32_t nLinkRecords = lsa->GetNLinkRecords();
     //
-    // We need to walk the list of nodes looking for the one that has the router
-    // ID corresponding to the root vertex.  This is the one we're going to write
-    // the routing information to.
+    // Iterate through the link records on the vertex to which we're going to add
+    // routes.  To make sure we're being clear, we're going to add routing table
+    // entries to the tables on the node corresping to the root of the SPF tree.
+    // These entries will have routes to the IP addresses we find from looking at
+    // the local side of the point-to-point links found on the node described by
+    // the vertex <v>.
     //
-    NodeList::Iterator i = NodeList::Begin();
-    NodeList::Iterator listEnd = NodeList::End();
-    for (; i != listEnd; i++)
+    NS_LOG_LOGIC(" Node " << nodeId << " found " << nLinkRecords << " link records in LSA "
+                          << lsa << "with LinkStateId " << lsa->GetLinkStateId());
+    for (uint32_t j = 0; j < nLinkRecords; ++j)
     {
-        Ptr<Node> node = *i;
         //
-        // The router ID is accessible through the GlobalRouter interface, so we need
-        // to GetObject for that interface.  If there's no GlobalRouter interface,
-        // the node in question cannot be the router we want, so we continue.
+        // We are only concerned about point-to-point links
         //
-        Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter>();
-
-        if (!rtr)
+        GlobalRoutingLinkRecord* lr = lsa->GetLinkRecord(j);
+        if (lr->GetLinkType() != GlobalRoutingLinkRecord::PointToPoint)
         {
-            NS_LOG_LOGIC("No GlobalRouter interface on node " << node->GetId());
             continue;
         }
         //
-        // If the router ID of the current node is equal to the router ID of the
-        // root of the SPF tree, then this node is the one for which we need to
-        // write the routing tables.
+        // Here's why we did all of that work.  We're going to add a host route to the
+        // host address found in the m_linkData field of the point-to-point link
+        // record.  In the case of a point-to-point link, this is the local IP address
+        // of the node connected to the link.  Each of these point-to-point links
+        // will correspond to a local interface that has an IP address to which
+        // the node at the root of the SPF tree can send packets.  The vertex <v>
+        // (corresponding to the node that has these links and interfaces) has
+        // an m_nextHop address precalculated for us that is the address to which the
+        // root node should send packets to be forwarded to these IP addresses.
+        // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
+        // which the packets should be send for forwarding.
         //
-        NS_LOG_LOGIC("Considering router " << rtr->GetRouterId());
-
-        if (rtr->GetRouterId() == routerId)
+        // walk through all available exit directions due to ECMP,
+        // and add host route for each of the exit direction toward
+        // the vertex 'v'
+        for (uint32_t i = 0; i < v->GetNRootExitDirections(); i++)
         {
-            NS_LOG_LOGIC("Setting routes for node " << node->GetId());
-            //
-            // Routing information is updated using the Ipv4 interface.  We need to
-            // GetObject for that interface.  If the node is acting as an IP version 4
-            // router, it should absolutely have an Ipv4 interface.
-            //
-            Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
-            NS_ASSERT_MSG(ipv4,
-                          "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                          "GetObject for <Ipv4> interface failed");
-            //
-            // Get the Global Router Link State Advertisement from the vertex we're
-            // adding the routes to.  The LSA will have a number of attached Global Router
-            // Link Records corresponding to links off of that vertex / node.  We're going
-            // to be interested in the records corresponding to point-to-point links.
-            //
-            GlobalRoutingLSA* lsa = v->GetLSA();
-            NS_ASSERT_MSG(lsa,
-                          "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                          "Expected valid LSA in SPFVertex* v");
-
-            uint32_t nLinkRecords = lsa->GetNLinkRecords();
-            //
-            // Iterate through the link records on the vertex to which we're going to add
-            // routes.  To make sure we're being clear, we're going to add routing table
-            // entries to the tables on the node corresping to the root of the SPF tree.
-            // These entries will have routes to the IP addresses we find from looking at
-            // the local side of the point-to-point links found on the node described by
-            // the vertex <v>.
-            //
-            NS_LOG_LOGIC(" Node " << node->GetId() << " found " << nLinkRecords
-                                  << " link records in LSA " << lsa << "with LinkStateId "
-                                  << lsa->GetLinkStateId());
-            for (uint32_t j = 0; j < nLinkRecords; ++j)
+            SPFVertex::NodeExit_t exit = v->GetRootExitDirection(i);
+            Ipv4Address nextHop = exit.first;
+            int32_t outIf = exit.second;
+            if (outIf >= 0)
             {
-                //
-                // We are only concerned about point-to-point links
-                //
-                GlobalRoutingLinkRecord* lr = lsa->GetLinkRecord(j);
-                if (lr->GetLinkType() != GlobalRoutingLinkRecord::PointToPoint)
-                {
-                    continue;
-                }
-                //
-                // Here's why we did all of that work.  We're going to add a host route to the
-                // host address found in the m_linkData field of the point-to-point link
-                // record.  In the case of a point-to-point link, this is the local IP address
-                // of the node connected to the link.  Each of these point-to-point links
-                // will correspond to a local interface that has an IP address to which
-                // the node at the root of the SPF tree can send packets.  The vertex <v>
-                // (corresponding to the node that has these links and interfaces) has
-                // an m_nextHop address precalculated for us that is the address to which the
-                // root node should send packets to be forwarded to these IP addresses.
-                // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
-                // which the packets should be send for forwarding.
-                //
-                Ptr<GlobalRouter> router = node->GetObject<GlobalRouter>();
-                if (!router)
-                {
-                    continue;
-                }
-                Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol();
-                NS_ASSERT(gr);
-                // walk through all available exit directions due to ECMP,
-                // and add host route for each of the exit direction toward
-                // the vertex 'v'
-                for (uint32_t i = 0; i < v->GetNRootExitDirections(); i++)
-                {
-                    SPFVertex::NodeExit_t exit = v->GetRootExitDirection(i);
-                    Ipv4Address nextHop = exit.first;
-                    int32_t outIf = exit.second;
-                    if (outIf >= 0)
-                    {
-                        gr->AddHostRouteTo(lr->GetLinkData(), nextHop, outIf);
-                        NS_LOG_LOGIC("(Route " << i << ") Node " << node->GetId()
-                                               << " adding host route to " << lr->GetLinkData()
-                                               << " using next hop " << nextHop
-                                               << " and outgoing interface " << outIf);
-                    }
-                    else
-                    {
-                        NS_LOG_LOGIC("(Route " << i << ") Node " << node->GetId()
-                                               << " NOT able to add host route to "
-                                               << lr->GetLinkData() << " using next hop " << nextHop
-                                               << " since outgoing interface id is negative "
-                                               << outIf);
-                    }
-                } // for all routes from the root the vertex 'v'
+                gr->AddHostRouteTo(lr->GetLinkData(), nextHop, outIf);
+                NS_LOG_LOGIC("(Route " << i << ") Node " << nodeId << " adding host route to "
+                                       << lr->GetLinkData() << " using next hop " << nextHop
+                                       << " and outgoing interface " << outIf);
             }
-            //
-            // Done adding the routes for the selected node.
-            //
-            return;
-        }
+            else
+            {
+                NS_LOG_LOGIC("(Route " << i << ") Node " << nodeId
+                                       << " NOT able to add host route to " << lr->GetLinkData()
+                                       << " using next hop " << nextHop
+                                       << " since outgoing interface id is negative " << outIf);
+            }
+        } // for all routes from the root the vertex 'v'
     }
 }
 
@@ -2070,100 +2622,50 @@ GlobalRouteManagerImpl::SPFIntraAddTransit(SPFVertex* v)
     NS_ASSERT_MSG(m_spfroot, "GlobalRouteManagerImpl::SPFIntraAddTransit (): Root pointer not set");
     //
     // The root of the Shortest Path First tree is the router to which we are
-    // going to write the actual routing table entries.  The vertex corresponding
-    // to this router has a vertex ID which is the router ID of that node.  We're
-    // going to use this ID to discover which node it is that we're actually going
-    // to update.
+    // going to write the actual routing table entries.  Its routing table was
+    // looked up when the calculation started.
     //
-    Ipv4Address routerId = m_spfroot->GetVertexId();
-
-    NS_LOG_LOGIC("Vertex ID = " << routerId);
+    Ptr<Ipv4GlobalRouting> gr = m_spfrootNode.routing;
+    if (!gr)
+    {
+        NS_LOG_LOGIC("No node has router ID " << m_spfroot->GetVertexId());
+        return;
+    }
+    uint32_t nodeId = m_spfrootNode.nodeId;
+    NS_LOG_LOGIC("setting routes for node " << nodeId);
     //
-    // We need to walk the list of nodes looking for the one that has the router
-    // ID corresponding to the root vertex.  This is the one we're going to write
-    // the routing information to.
+    // Get the Global Router Link State Advertisement from the vertex we're
+    // adding the routes to.  The LSA describes the transit network.
     //
-    NodeList::Iterator i = NodeList::Begin();
-    NodeList::Iterator listEnd = NodeList::End();
-    for (; i != listEnd; i++)
+    GlobalRoutingLSA* lsa = v->GetLSA();
+    NS_ASSERT_MSG(lsa,
+                  "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
+                  "Expected valid LSA in SPFVertex* v");
+    Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask();
+    Ipv4Address tempip = lsa->GetLinkStateId();
+    tempip = tempip.CombineMask(tempmask);
+    // walk through all available exit directions due to ECMP,
+    // and add host route for each of the exit direction toward
+    // the vertex 'v'
+    for (uint32_t i = 0; i < v->GetNRootExitDirections(); i++)
     {
-        Ptr<Node> node = *i;
-        //
-        // The router ID is accessible through the GlobalRouter interface, so we need
-        // to GetObject for that interface.  If there's no GlobalRouter interface,
-        // the node in question cannot be the router we want, so we continue.
-        //
-        Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter>();
+        SPFVertex::NodeExit_t exit = v->GetRootExitDirection(i);
+        Ipv4Address nextHop = exit.first;
+        int32_t outIf = exit.second;
 
-        if (!rtr)
+        if (outIf >= 0)
         {
-            NS_LOG_LOGIC("No GlobalRouter interface on node " << node->GetId());
-            continue;
+            gr->AddNetworkRouteTo(tempip, tempmask, nextHop, outIf);
+            NS_LOG_LOGIC("(Route " << i << ") Node " << nodeId << " add network route to "
+                                   << tempip << " using next hop " << nextHop
+                                   << " via interface " << outIf);
         }
-        //
-        // If the router ID of the current node is equal to the router ID of the
-        // root of the SPF tree, then this node is the one for which we need to
-        // write the routing tables.
-        //
-        NS_LOG_LOGIC("Considering router " << rtr->GetRouterId());
-
-        if (rtr->GetRouterId() == routerId)
+        else
         {
-            NS_LOG_LOGIC("setting routes for node " << node->GetId());
-            //
-            // Routing information is updated using the Ipv4 interface.  We need to
-            // GetObject for that interface.  If the node is acting as an IP version 4
-            // router, it should absolutely have an Ipv4 interface.
-            //
-            Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
-            NS_ASSERT_MSG(ipv4,
-                          "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                          "GetObject for <Ipv4> interface failed");
-            //
-            // Get the Global Router Link State Advertisement from the vertex we're
-            // adding the routes to.  The LSA will have a number of attached Global Router
-            // Link Records corresponding to links off of that vertex / node.  We're going
-            // to be interested in the records corresponding to point-to-point links.
-            //
-            GlobalRoutingLSA* lsa = v->GetLSA();
-            NS_ASSERT_MSG(lsa,
-                          "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                          "Expected valid LSA in SPFVertex* v");
-            Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask();
-            Ipv4Address tempip = lsa->GetLinkStateId();
-            tempip = tempip.CombineMask(tempmask);
-            Ptr<GlobalRouter> router = node->GetObject<GlobalRouter>();
-            if (!router)
-            {
-                continue;
-            }
-            Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol();
-            NS_ASSERT(gr);
-            // walk through all available exit directions due to ECMP,
-            // and add host route for each of the exit direction toward
-            // the vertex 'v'
-            for (uint32_t i = 0; i < v->GetNRootExitDirections(); i++)
-            {
-                SPFVertex::NodeExit_t exit = v->GetRootExitDirection(i);
-                Ipv4Address nextHop = exit.first;
-                int32_t outIf = exit.second;
-
-                if (outIf >= 0)
-                {
-                    gr->AddNetworkRouteTo(tempip, tempmask, nextHop, outIf);
-                    NS_LOG_LOGIC("(Route " << i << ") Node " << node->GetId()
-                                           << " add network route to " << tempip
-                                           << " using next hop " << nextHop << " via interface "
-                                           << outIf);
-                }
-                else
-                {
-                    NS_LOG_LOGIC("(Route " << i << ") Node " << node->GetId()
-                                           << " NOT able to add network route to " << tempip
-                                           << " using next hop " << nextHop
-                                           << " since outgoing interface id is negative " << outIf);
-                }
-            }
+            NS_LOG_LOGIC("(Route " << i << ") Node " << nodeId
+                                   << " NOT able to add network route to " << tempip
+                                   << " using next hop " << nextHop
+                                   << " since outgoing interface id is negative " << outIf);
         }
     }
 }
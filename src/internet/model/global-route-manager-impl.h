@@ -31,6 +31,7 @@
 #include <map>
 #include <queue>
 #include <stdint.h>
+#include <unordered_map>
 #include <vector>
 
 namespace ns3
@@ -39,6 +40,7 @@ namespace ns3
 const uint32_t SPF_INFINITY = 0xffffffff; //!< "infinite" distance between nodes
 
 class CandidateQueue;
+class Ipv4;
 class Ipv4GlobalRouting;
 
 /**
@@ -631,6 +633,10 @@ class GlobalRouteManagerLSDB
      * to allow the LSA to be found by matching addr with the LinkData field
      * of the TransitNetwork link record.
      *
+     * The link data of every TransitNetwork link record is indexed when the
+     * LSA is inserted, so this is a map lookup.  If several LSAs have the same
+     * link data, the one with the lowest link state ID is returned.
+     *
      * @see GetLSA
      * @param addr The IP address associated with the LSA.  Typically the Router
      * @returns A pointer to the Link State Advertisement for the router specified
@@ -639,6 +645,30 @@ class GlobalRouteManagerLSDB
      */
     GlobalRoutingLSA* GetLSAByLinkData(Ipv4Address addr) const;
 
+    /**
+     * @brief Resolve the neighbors of every Link State Advertisement.
+     *
+     * Does nothing if the neighbors are already resolved.  GetAdjacentLSAs
+     * and GetDistancesTo resolve them on first use, so this only needs to be
+     * called before the database is read by several threads at once.
+     */
+    void BuildAdjacencies() const;
+
+    /**
+     * @brief Get the neighbors of a Link State Advertisement, as resolved by
+     * BuildAdjacencies.
+     *
+     * The neighbors are resolved on the first call after an LSA is inserted.
+     *
+     * For a RouterLSA, entry i is the LSA at the other end of link record i,
+     * or null for a stub network.  For a NetworkLSA, entry i is the LSA of
+     * attached router i, or null if it is unknown.
+     *
+     * @param lsa the Link State Advertisement
+     * @returns the neighbors of the LSA, one per link record or attached router
+     */
+    const std::vector<GlobalRoutingLSA*>& GetAdjacentLSAs(const GlobalRoutingLSA* lsa) const;
+
     /**
      * @brief Set all LSA flags to an initialized state, for SPF computation
      *
@@ -672,6 +702,34 @@ class GlobalRouteManagerLSDB
      */
     uint32_t GetNumExtLSAs() const;
 
+    /**
+     * @brief Compare the Link State Advertisements with those of another
+     * database.
+     *
+     * @param other the database to compare with
+     * @param changed set to the link state IDs of the RouterLSAs whose link
+     * records differ
+     * @returns true if both databases have the same LSAs and only the link
+     * records of RouterLSAs differ, false if an LSA was added or removed or
+     * a NetworkLSA or external LSA differs
+     */
+    bool GetChangedRouterLSAs(const GlobalRouteManagerLSDB& other,
+                              std::vector<Ipv4Address>& changed) const;
+
+    /**
+     * @brief Get the distance from every Link State Advertisement to a given
+     * one.
+     *
+     * Distances follow the links of the SPF calculation, so the distance from
+     * a router to the LSA is the one its SPF calculation would find.
+     *
+     * @param lsa the destination
+     * @returns the distance of every LSA from which the destination is
+     * reachable
+     */
+    std::unordered_map<const GlobalRoutingLSA*, uint32_t> GetDistancesTo(
+        const GlobalRoutingLSA* lsa) const;
+
   private:
     typedef std::map<Ipv4Address, GlobalRoutingLSA*>
         LSDBMap_t; //!< container of IPv4 addresses / Link State Advertisements
@@ -681,6 +739,13 @@ class GlobalRouteManagerLSDB
     LSDBMap_t m_database; //!< database of IPv4 addresses / Link State Advertisements
     std::vector<GlobalRoutingLSA*>
         m_extdatabase; //!< database of External Link State Advertisements
+
+    /// TransitNetwork link data / Link State Advertisements, for GetLSAByLinkData
+    std::map<Ipv4Address, GlobalRoutingLSA*> m_linkDataIndex;
+    /// The neighbors of each Link State Advertisement, see GetAdjacentLSAs
+    mutable std::unordered_map<const GlobalRoutingLSA*, std::vector<GlobalRoutingLSA*>>
+        m_adjacencies;
+    mutable bool m_adjacenciesValid; //!< whether m_adjacencies covers every LSA
 };
 
 /**
@@ -722,9 +787,47 @@ class GlobalRouteManagerImpl
     /**
      * @brief Compute routes using a Dijkstra SPF computation and populate
      * per-node forwarding tables
+     *
+     * The SPF of each root only reads the LSDB and only writes the routing
+     * table of the root, so when the GlobalRoutingWorkers global value is
+     * above 1 the roots are spread over that many threads.  Every table
+     * receives its routes in the same order as in a serial build.
+     *
+     * The time spent building the LSDB and in the SPF calculations is logged
+     * at the info level.
      */
     virtual void InitializeRoutes();
 
+    /**
+     * @brief Update the routes of every node after the topology changed.
+     *
+     * Rebuilds the LSDB and compares it with the one the current routes were
+     * computed from.  Only the routers whose shortest path trees may have
+     * changed run their SPF calculation again; the others patch the routes
+     * towards the addresses and networks of the LSAs that changed.  The
+     * resulting routes are the same as those of DeleteGlobalRoutes (),
+     * BuildGlobalRoutingDatabase () and InitializeRoutes (), although not
+     * necessarily in the same order.  If the routes were not computed by
+     * InitializeRoutes (), or a router or a network appeared or disappeared,
+     * all of the routes are computed again.
+     */
+    virtual void UpdateRoutes();
+
+    /**
+     * @brief Get the number of routers that ran their SPF calculation in the
+     * last InitializeRoutes () or UpdateRoutes ()
+     * @returns the number of routers whose routes were computed again
+     */
+    uint32_t GetNRecalculatedRoots() const;
+
+    /**
+     * @brief Get the number of routers that kept their shortest path trees in
+     * the last UpdateRoutes (), only patching the routes towards the changed
+     * LSAs
+     * @returns the number of routers whose routes were patched
+     */
+    uint32_t GetNSparedRoots() const;
+
     /**
      * @brief Debugging routine; allow client code to supply a pre-built LSDB
      * @param lsdb the pre-built LSDB
@@ -738,8 +841,64 @@ class GlobalRouteManagerImpl
     void DebugSPFCalculate(Ipv4Address root);
 
   private:
+    /**
+     * \brief The node at the root of an SPF calculation.
+     *
+     * The objects of the root are looked up once, before the calculation, so
+     * that the calculation does not have to walk the NodeList.
+     */
+    struct SPFRoot
+    {
+        Ipv4Address routerId;           //!< the router ID of the root
+        uint32_t nodeId = 0;            //!< the ID of the root node
+        Ptr<Ipv4> ipv4;                 //!< the Ipv4 of the root node
+        Ptr<Ipv4GlobalRouting> routing; //!< the routing table to fill in
+    };
+
+    /**
+     * \brief Create an SPF worker sharing the LSDB of another manager.
+     *
+     * A worker only runs SPFCalculate and does not own the LSDB.
+     *
+     * \param lsdb the LSDB to read
+     */
+    GlobalRouteManagerImpl(GlobalRouteManagerLSDB* lsdb);
+
     SPFVertex* m_spfroot;           //!< the root node
+    SPFRoot m_spfrootNode;          //!< the node at the root of the SPF calculation
     GlobalRouteManagerLSDB* m_lsdb; //!< the Link State DataBase (LSDB) of the Global Route Manager
+    bool m_ownsLsdb;                //!< whether the LSDB is deleted with this object
+    bool m_routesFromLsdb; //!< whether the routes of the nodes were computed from m_lsdb
+    uint32_t m_nRecalculatedRoots; //!< routers that ran their SPF calculation in the last update
+    uint32_t m_nSparedRoots;       //!< routers that only patched their routes in the last update
+
+    /**
+     * The SPF state of the LSAs in the current calculation, absent for LSAs
+     * not yet explored.  It is kept here rather than in the shared LSAs so
+     * that calculations for different roots can run at the same time.
+     */
+    std::unordered_map<const GlobalRoutingLSA*, GlobalRoutingLSA::SPFStatus> m_lsaStatus;
+
+    /**
+     * \brief Get the SPF state of an LSA in the current calculation
+     * \param lsa the LSA
+     * \returns the state of the LSA
+     */
+    GlobalRoutingLSA::SPFStatus GetLSAStatus(const GlobalRoutingLSA* lsa) const;
+
+    /**
+     * \brief Set the SPF state of an LSA in the current calculation
+     * \param lsa the LSA
+     * \param status the new state of the LSA
+     */
+    void SetLSAStatus(const GlobalRoutingLSA* lsa, GlobalRoutingLSA::SPFStatus status);
+
+    /**
+     * \brief Look up the node with a given router ID
+     * \param routerId the router ID
+     * \returns the root, with null objects if no node has the router ID
+     */
+    SPFRoot LookupSPFRoot(Ipv4Address routerId) const;
 
     /**
      * \brief Test if a node is a stub, from an OSPF sense.
@@ -753,6 +912,24 @@ class GlobalRouteManagerImpl
      */
     bool CheckForStubNode(Ipv4Address root);
 
+    /**
+     * \brief Find the default route of a stub router
+     *
+     * A router whose only link to another router is a point-to-point link
+     * that the other router links back over gets a default route to it, as
+     * installed by CheckForStubNode, and no other route.
+     *
+     * \param lsdb the LSDB to read
+     * \param root the router ID of the router
+     * \param nextHop set to the address of the other router on the link
+     * \param linkData set to the address of the router on the link
+     * \returns true if the router is a stub
+     */
+    static bool GetStubRoute(const GlobalRouteManagerLSDB* lsdb,
+                             Ipv4Address root,
+                             Ipv4Address& nextHop,
+                             Ipv4Address& linkData);
+
     /**
      * \brief Calculate the shortest path first (SPF) tree
      *
@@ -761,6 +938,72 @@ class GlobalRouteManagerImpl
      */
     void SPFCalculate(Ipv4Address root);
 
+    /**
+     * \brief Calculate the shortest path first (SPF) tree of a node that has
+     * already been looked up
+     *
+     * \param root the root node
+     */
+    void SPFCalculate(const SPFRoot& root);
+
+    /**
+     * \brief Calculate the SPF trees of several nodes on several threads
+     *
+     * \param roots the root nodes
+     * \param nWorkers the number of threads, including the calling one
+     */
+    void SPFCalculateParallel(const std::vector<SPFRoot>& roots, uint32_t nWorkers);
+
+    /**
+     * \brief Find the routers whose routes are computed
+     * \returns the routers of this system that have LSAs, in node order
+     */
+    std::vector<SPFRoot> CollectSPFRoots() const;
+
+    /**
+     * \brief Calculate the SPF trees of several nodes and add their routes
+     *
+     * The calculations are spread over the number of threads set by the
+     * GlobalRoutingWorkers global value.
+     *
+     * \param roots the root nodes
+     * \returns the number of threads used
+     */
+    uint32_t CalculateRoutes(const std::vector<SPFRoot>& roots);
+
+    /**
+     * \brief Delete every route of a routing table
+     * \param routing the routing table
+     */
+    static void DeleteRoutes(Ptr<Ipv4GlobalRouting> routing);
+
+    /**
+     * \brief Find the exits a root uses to reach a router, from its routes
+     *
+     * \param root the root node
+     * \param lsa the LSA of the router the routes of the root were computed from
+     * \param exits set to the next hops and outgoing interfaces, empty if the
+     * router is not reachable
+     * \returns false if the exits cannot be told from the routes
+     */
+    bool GetRootExits(const SPFRoot& root,
+                      const GlobalRoutingLSA* lsa,
+                      std::vector<SPFVertex::NodeExit_t>& exits) const;
+
+    /**
+     * \brief Replace the routes a root has towards the addresses and stub
+     * networks of a router by those of its new LSA
+     *
+     * \param root the root node
+     * \param oldLsa the LSA of the router the routes were computed from
+     * \param newLsa the new LSA of the router
+     * \param exits the exits of the root towards the router
+     */
+    void PatchRoutes(const SPFRoot& root,
+                     const GlobalRoutingLSA* oldLsa,
+                     const GlobalRoutingLSA* newLsa,
+                     const std::vector<SPFVertex::NodeExit_t>& exits);
+
     /**
      * \brief Process Stub nodes
      *
@@ -910,8 +1153,8 @@ class GlobalRouteManagerImpl
     /**
      * \brief Return the interface number corresponding to a given IP address and mask
      *
-     * This is a wrapper around GetInterfaceForPrefix(), but we first
-     * have to find the right node pointer to pass to that function.
+     * This is a wrapper around GetInterfaceForPrefix() on the Ipv4 of the
+     * root node.
      * If no such interface is found, return -1 (note:  unit test framework
      * for routing assumes -1 to be a legal return value)
      *
@@ -70,6 +70,13 @@ class GlobalRouteManager
      * per-node forwarding tables
      */
     static void InitializeRoutes();
+
+    /**
+     * @brief Rebuild the routing database and update the per-node forwarding
+     * tables, recomputing only the routes affected by the topology changes
+     * since the routes were last computed
+     */
+    static void UpdateRoutes();
 };
 
 } // namespace ns3
@@ -0,0 +1,99 @@
+#include "ipv4-drb-path-table.h"
+
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("Ipv4DrbPathTable");
+
+DrbPathSchedule::DrbPathSchedule() {}
+
+Ptr<DrbPathSchedule> DrbPathSchedule::AddPath(uint32_t path,
+	                                          uint32_t weight) const {
+	NS_LOG_FUNCTION(this << path << weight);
+	Ptr<DrbPathSchedule> schedule = Create<DrbPathSchedule>(*this);
+	if (weight == 0) {
+		return schedule;
+	}
+
+	auto itr = std::find(schedule->m_paths.begin(), schedule->m_paths.end(),
+		                 path);
+	if (itr != schedule->m_paths.end()) {
+		schedule->m_weights[itr - schedule->m_paths.begin()] += weight;
+	} else {
+		schedule->m_paths.push_back(path);
+		schedule->m_weights.push_back(weight);
+	}
+	schedule->BuildSchedule();
+	return schedule;
+}
+
+uint32_t DrbPathSchedule::GetLength() const {
+	return m_schedule.size();
+}
+
+uint32_t DrbPathSchedule::GetPath(uint32_t position) const {
+	NS_ASSERT_MSG(!m_schedule.empty(), "The schedule has no paths");
+	return m_schedule[position % m_schedule.size()];
+}
+
+uint32_t DrbPathSchedule::GetNPaths() const {
+	return m_paths.size();
+}
+
+void DrbPathSchedule::BuildSchedule() {
+	uint32_t divisor = 0;
+	for (uint32_t weight : m_weights) {
+		divisor = std::gcd(divisor, weight);
+	}
+	uint64_t total = 0;
+	for (uint32_t weight : m_weights) {
+		total += weight / divisor;
+	}
+
+	// Smooth weighted round robin: every slot each path gains its weight and
+	// the path with the most credit is picked and pays back the total.
+	std::vector<int64_t> credit(m_paths.size(), 0);
+	m_schedule.clear();
+	m_schedule.reserve(total);
+	for (uint64_t slot = 0; slot < total; slot++) {
+		uint32_t best = 0;
+		for (uint32_t i = 0; i < m_paths.size(); i++) {
+			credit[i] += m_weights[i] / divisor;
+			if (credit[i] > credit[best]) {
+				best = i;
+			}
+		}
+		credit[best] -= total;
+		m_schedule.push_back(m_paths[best]);
+	}
+}
+
+DrbFlowCursorTable::DrbFlowCursorTable() {}
+
+void DrbFlowCursorTable::Configure(uint32_t capacity, Time idleTimeout) {
+	NS_LOG_FUNCTION(this << capacity << idleTimeout);
+	m_entries.Configure(capacity);
+	m_idleTimeout = idleTimeout;
+}
+
+uint32_t& DrbFlowCursorTable::Lookup(uint64_t flowKey, Time now,
+	                                 bool& found) {
+	Entry& entry = m_entries.Lookup(flowKey, now, m_idleTimeout, found);
+	entry.activeTime = now;
+	return entry.cursor;
+}
+
+uint32_t DrbFlowCursorTable::GetCapacity() const {
+	return m_entries.GetCapacity();
+}
+
+uint64_t DrbFlowCursorTable::GetEvictions() const {
+	return m_entries.GetEvictions();
+}
+
+}  // namespace ns3
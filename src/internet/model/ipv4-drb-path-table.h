@@ -0,0 +1,125 @@
+#ifndef IPV4_DRB_PATH_TABLE_H
+#define IPV4_DRB_PATH_TABLE_H
+
+#include "ns3/flow-table.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup internet
+ *
+ * \brief An immutable weighted round robin schedule over a set of paths.
+ *
+ * Each path is stored once with its weight. The weights are divided by
+ * their greatest common divisor and laid out in smooth weighted round
+ * robin order, so paths A and B with weights 3 and 1 are visited as
+ * A A B A rather than A A A B. A schedule is shared by every destination
+ * that uses the same paths, and flows only keep a cursor into it.
+ */
+class DrbPathSchedule : public SimpleRefCount<DrbPathSchedule> {
+public:
+	DrbPathSchedule();
+
+	/**
+	 * \brief Builds a new schedule with a path added to this one.
+	 *
+	 * \param path the path to add.
+	 * \param weight the weight to add to the path, which may already be
+	 * part of the schedule.
+	 *
+	 * \returns the new schedule. This schedule is left unchanged.
+	 */
+	Ptr<DrbPathSchedule> AddPath(uint32_t path, uint32_t weight) const;
+
+	/**
+	 * \returns the number of slots in one round of the schedule.
+	 */
+	uint32_t GetLength() const;
+
+	/**
+	 * \returns the path in a slot of the schedule.
+	 *
+	 * \param position the slot, taken modulo the length of the schedule.
+	 */
+	uint32_t GetPath(uint32_t position) const;
+
+	/**
+	 * \returns the number of distinct paths in the schedule.
+	 */
+	uint32_t GetNPaths() const;
+
+private:
+	// Lays out m_paths and m_weights in m_schedule.
+	void BuildSchedule();
+
+	// The distinct paths and their weights.
+	std::vector<uint32_t> m_paths;
+	std::vector<uint32_t> m_weights;
+	// One round of the schedule.
+	std::vector<uint32_t> m_schedule;
+};
+
+/**
+ * \ingroup internet
+ *
+ * \brief A fixed-capacity table of per-flow DRB cursors.
+ *
+ * A FlowTable whose entries are released once idle for longer than the idle
+ * timeout, so memory stays bounded however many flows go through the node.
+ */
+class DrbFlowCursorTable {
+public:
+	DrbFlowCursorTable();
+
+	/**
+	 * \brief Allocates the table, discarding any existing cursors.
+	 *
+	 * \param capacity the number of entries, rounded up to a power of 2.
+	 * \param idleTimeout how long a flow keeps its entry without packets.
+	 */
+	void Configure(uint32_t capacity, Time idleTimeout);
+
+	/**
+	 * \brief Finds the cursor of a flow.
+	 *
+	 * \param flowKey the key of the flow.
+	 * \param now the current time.
+	 * \param found set to true if the flow already had a cursor. Otherwise
+	 * an entry has been claimed for the flow and the caller must initialize
+	 * the cursor.
+	 *
+	 * \returns the cursor of the flow, valid until the next lookup.
+	 */
+	uint32_t& Lookup(uint64_t flowKey, Time now, bool& found);
+
+	/**
+	 * \returns the number of entries in the table, 0 until it is configured.
+	 */
+	uint32_t GetCapacity() const;
+
+	/**
+	 * \returns the number of busy cursors replaced before they went idle.
+	 */
+	uint64_t GetEvictions() const;
+
+private:
+	struct Entry {
+		uint64_t flowKey = 0;
+		uint32_t cursor = 0;
+		Time activeTime;
+		bool valid = false;
+	};
+
+	FlowTable<Entry> m_entries;
+	Time m_idleTimeout;
+};
+
+}  // namespace ns3
+
+#endif  // IPV4_DRB_PATH_TABLE_H
@@ -1,13 +1,20 @@
 #include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
 #include "ipv4-drb.h"
 
+#include <algorithm>
+
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE("Ipv4Drb");
 
 NS_OBJECT_ENSURE_REGISTERED(Ipv4Drb);
 
-Ipv4Drb::Ipv4Drb() {
+Ipv4Drb::Ipv4Drb()
+	: m_schedule(Create<DrbPathSchedule>()),
+	  m_flowTableSize(4096),
+	  m_rand(CreateObject<UniformRandomVariable>()) {
 	NS_LOG_FUNCTION(this);
 }
 
@@ -19,53 +26,80 @@ TypeId Ipv4Drb::GetTypeId() {
 	static TypeId tid = TypeId("ns3::Ipv4Drb")
 	  .SetParent<Object>()
 	  .SetGroupName("Internet")
-	  .AddConstructor<Ipv4Drb>();
+	  .AddConstructor<Ipv4Drb>()
+	  .AddAttribute("FlowTableSize",
+	                "The number of flows whose core switch cursor is kept",
+	                UintegerValue(4096),
+	                MakeUintegerAccessor(&Ipv4Drb::m_flowTableSize),
+	                MakeUintegerChecker<uint32_t>(1))
+	  .AddAttribute("FlowIdleTimeout",
+	                "How long a flow keeps its cursor without sending packets",
+	                TimeValue(MilliSeconds(100)),
+	                MakeTimeAccessor(&Ipv4Drb::m_flowIdleTimeout),
+	                MakeTimeChecker());
 
 	return tid;
 }
 
-Ipv4Address Ipv4Drb::GetCoreSwitchAddress(uint32_t flowId) {
+Ipv4Address Ipv4Drb::GetCoreSwitchAddress(uint64_t flowKey) {
 	NS_LOG_FUNCTION(this);
 
-	if (m_coreSwitchAddressList.size() == 0) {
+	uint32_t length = m_schedule->GetLength();
+	if (length == 0) {
 		return Ipv4Address();
 	}
-
-	uint32_t pathIdx;
-	auto itr = m_flowPathMap.find(flowId);
-	
-	// If we already have a path entry for the flow, use that path.
-	if (itr != m_flowPathMap.end()) {
-		pathIdx = itr->second;
+	if (m_flowCursors.GetCapacity() == 0) {
+		m_flowCursors.Configure(m_flowTableSize, m_flowIdleTimeout);
 	}
-	// Otherwise, just pick a path at random.
-	else {
-		pathIdx = rand() % m_coreSwitchAddressList.size();
+
+	bool found = false;
+	uint32_t& cursor = m_flowCursors.Lookup(flowKey, Simulator::Now(), found);
+	// If we don't have a path entry for the flow, pick a path at random.
+	if (!found) {
+		cursor = m_rand->GetInteger(0, length - 1);
 	}
 
-	Ipv4Address addr = m_coreSwitchAddressList[pathIdx];
+	uint32_t pathIdx = cursor % length;
+	Ipv4Address addr = m_coreSwitchAddressList[m_schedule->GetPath(pathIdx)];
 
 	// For a given destination or flow, DRB sends packets in a round robin
 	// fashion to the core switches. So once we pick the path for this packet
-	// the next packet will go to the next core switch, so we increment the
-	// path index by 1 and store it in the list for the next time.
-	m_flowPathMap[flowId] = ((pathIdx + 1) % m_coreSwitchAddressList.size());
+	// the next packet will go to the next core switch, so we move the cursor
+	// by 1 for the next time.
+	cursor = (pathIdx + 1) % length;
 
 	NS_LOG_DEBUG(
-		this << " The index for flow: " << flowId << " is: " << pathIdx);
+		this << " The index for flow: " << flowKey << " is: " << pathIdx);
 	return addr;
 }
 
 void Ipv4Drb::AddCoreSwitchAddress(Ipv4Address addr) {
 	NS_LOG_FUNCTION(this << addr);
-	m_coreSwitchAddressList.push_back(addr);
+	Ipv4Drb::AddCoreSwitchAddress(1, addr);
 }
 
 void Ipv4Drb::AddCoreSwitchAddress(uint32_t weight, Ipv4Address addr) {
-	// Store `weight` copies of `addr`.
-	for (uint32_t i = 0; i < weight; i++) {
-		Ipv4Drb::AddCoreSwitchAddress(addr);
+	NS_LOG_FUNCTION(this << weight << addr);
+	// Each address is stored once and the schedule visits it `weight` times
+	// per round.
+	auto itr = std::find(m_coreSwitchAddressList.begin(),
+		                 m_coreSwitchAddressList.end(), addr);
+	uint32_t index = itr - m_coreSwitchAddressList.begin();
+	if (itr == m_coreSwitchAddressList.end()) {
+		m_coreSwitchAddressList.push_back(addr);
 	}
+	m_schedule = m_schedule->AddPath(index, weight);
+}
+
+int64_t Ipv4Drb::AssignStreams(int64_t stream) {
+	NS_LOG_FUNCTION(this << stream);
+	m_rand->SetStream(stream);
+	return 1;
+}
+
+void Ipv4Drb::DoDispose() {
+	m_rand = nullptr;
+	Object::DoDispose();
 }
 	
-}  // namespace ns3
\ No newline at end of file
+}  // namespace ns3
@@ -1,10 +1,12 @@
 #ifndef IPV4_DRB_H
 #define IPV4_DRB_H
 
+#include "ipv4-drb-path-table.h"
+
 #include "ns3/object.h"
 #include "ns3/ipv4-address.h"
+#include "ns3/random-variable-stream.h"
 
-#include <map>
 #include <vector>
 
 namespace ns3 {
@@ -16,19 +18,38 @@ public:
 
 	static TypeId GetTypeId();
 
-	Ipv4Address GetCoreSwitchAddress(uint32_t flowId);
+	Ipv4Address GetCoreSwitchAddress(uint64_t flowKey);
 	void AddCoreSwitchAddress(Ipv4Address addr);
 	void AddCoreSwitchAddress(uint32_t weight, Ipv4Address addr);
 
+	/**
+	 * Assign a fixed random variable stream number to the random variables
+	 * used by this model.  Return the number of streams (possibly zero) that
+	 * have been assigned.
+	 *
+	 * \param stream first stream index to use
+	 * \return the number of stream indices assigned by this model
+	 */
+	int64_t AssignStreams(int64_t stream);
+
+protected:
+	void DoDispose() override;
+
 private:
 	// The addresses of the core switches. The idea behind DRB is to ping
 	// traffic of a core switch before routing it to its almost destination.
 	std::vector<Ipv4Address> m_coreSwitchAddressList;
-	// Maintains a map of flow IDs to paths. So if a flow already has an
-	// associated path we can just reuse that path.
-	std::map<uint32_t, uint32_t> m_flowPathMap;
+	// Weighted round robin over indices into m_coreSwitchAddressList.
+	Ptr<DrbPathSchedule> m_schedule;
+	// The position of each flow in m_schedule. So if a flow already has an
+	// associated path we can just move on to the next one.
+	DrbFlowCursorTable m_flowCursors;
+	uint32_t m_flowTableSize;
+	Time m_flowIdleTimeout;
+	// Picks the first core switch of a new flow.
+	Ptr<UniformRandomVariable> m_rand;
 };
 
 }  // namespace ns3
 
-#endif  // IPV4_DRB_H
\ No newline at end of file
+#endif  // IPV4_DRB_H
@@ -0,0 +1,117 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "ipv4-global-route-pool.h"
+
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("Ipv4GlobalRoutePool");
+
+Ipv4GlobalRoutePool*
+Ipv4GlobalRoutePool::Get()
+{
+    static Ipv4GlobalRoutePool pool;
+    return &pool;
+}
+
+Ipv4GlobalRoutePool::Ipv4GlobalRoutePool()
+    : m_concurrent(false),
+      m_nEntries(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+Ipv4RoutingTableEntry*
+Ipv4GlobalRoutePool::Add(const Ipv4RoutingTableEntry& route)
+{
+    std::unique_lock<std::mutex> lock(m_mutex, std::defer_lock);
+    if (m_concurrent)
+    {
+        lock.lock();
+    }
+    m_nEntries++;
+    if (m_freeSlots.empty())
+    {
+        m_slots.push_back(route);
+        return &m_slots.back();
+    }
+    Ipv4RoutingTableEntry* slot = m_freeSlots.back();
+    m_freeSlots.pop_back();
+    *slot = route;
+    return slot;
+}
+
+void
+Ipv4GlobalRoutePool::Release(Ipv4RoutingTableEntry* route)
+{
+    std::unique_lock<std::mutex> lock(m_mutex, std::defer_lock);
+    if (m_concurrent)
+    {
+        lock.lock();
+    }
+    ReleaseLocked(route);
+}
+
+void
+Ipv4GlobalRoutePool::Release(const std::vector<Ipv4RoutingTableEntry*>& routes)
+{
+    std::unique_lock<std::mutex> lock(m_mutex, std::defer_lock);
+    if (m_concurrent)
+    {
+        lock.lock();
+    }
+    for (Ipv4RoutingTableEntry* route : routes)
+    {
+        ReleaseLocked(route);
+    }
+}
+
+void
+Ipv4GlobalRoutePool::ReleaseLocked(Ipv4RoutingTableEntry* route)
+{
+    NS_ASSERT_MSG(m_nEntries > 0, "Ipv4GlobalRoutePool::Release (): the pool is empty");
+    m_nEntries--;
+    if (m_nEntries == 0)
+    {
+        NS_LOG_LOGIC("Pool empty, freeing " << m_slots.size() << " slots");
+        std::deque<Ipv4RoutingTableEntry>().swap(m_slots);
+        std::vector<Ipv4RoutingTableEntry*>().swap(m_freeSlots);
+        return;
+    }
+    m_freeSlots.push_back(route);
+}
+
+void
+Ipv4GlobalRoutePool::SetConcurrent(bool concurrent)
+{
+    NS_LOG_FUNCTION(this << concurrent);
+    m_concurrent = concurrent;
+}
+
+uint32_t
+Ipv4GlobalRoutePool::GetNEntries() const
+{
+    std::unique_lock<std::mutex> lock(m_mutex, std::defer_lock);
+    if (m_concurrent)
+    {
+        lock.lock();
+    }
+    return m_nEntries;
+}
+
+} // namespace ns3
@@ -0,0 +1,116 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef IPV4_GLOBAL_ROUTE_POOL_H
+#define IPV4_GLOBAL_ROUTE_POOL_H
+
+#include "ipv4-routing-table-entry.h"
+
+#include <deque>
+#include <mutex>
+#include <stdint.h>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup globalrouting
+ *
+ * \brief Storage for the routing table entries of every Ipv4GlobalRouting
+ * object in the simulation
+ *
+ * Large topologies give every switch a route to nearly every address, so the
+ * routing tables hold many small entries.  Instead of allocating each entry
+ * on its own, the tables keep pointers to entries stored in a single pool, in
+ * chunks that never move.  The entries of released routes are reused, and
+ * when the last entry is released, all of the memory of the pool is freed.
+ *
+ * Entries are not shared between routes: the next hop of a route differs from
+ * one switch to the next, so few entries repeat and indexing them would cost
+ * more memory than sharing them saves.
+ *
+ * While the global routes are computed by several threads, Add and Release
+ * are serialized by a mutex.
+ */
+class Ipv4GlobalRoutePool
+{
+  public:
+    /**
+     * \brief Get the pool of the simulation
+     * \returns the pool
+     */
+    static Ipv4GlobalRoutePool* Get();
+
+    Ipv4GlobalRoutePool();
+
+    // Delete copy constructor and assignment operator to avoid misuse
+    Ipv4GlobalRoutePool(const Ipv4GlobalRoutePool&) = delete;
+    Ipv4GlobalRoutePool& operator=(const Ipv4GlobalRoutePool&) = delete;
+
+    /**
+     * \brief Store a copy of a route
+     *
+     * Every call must be matched by a call to Release.
+     *
+     * \param route the route
+     * \returns the stored entry, valid until it is released
+     */
+    Ipv4RoutingTableEntry* Add(const Ipv4RoutingTableEntry& route);
+
+    /**
+     * \brief Release an entry returned by Add
+     * \param route the stored entry
+     */
+    void Release(Ipv4RoutingTableEntry* route);
+
+    /**
+     * \brief Release entries returned by Add, taking the mutex once
+     * \param routes the stored entries
+     */
+    void Release(const std::vector<Ipv4RoutingTableEntry*>& routes);
+
+    /**
+     * \brief Set whether the pool is used by several threads at once
+     *
+     * The mutex is only taken while this is set, which the route manager
+     * does for the duration of a parallel SPF calculation.
+     *
+     * \param concurrent true if several threads may use the pool
+     */
+    void SetConcurrent(bool concurrent);
+
+    /**
+     * \returns the number of entries in use, that is the number of routes in
+     * all of the routing tables
+     */
+    uint32_t GetNEntries() const;
+
+  private:
+    /**
+     * \brief Release an entry, with the mutex held if needed
+     * \param route the stored entry
+     */
+    void ReleaseLocked(Ipv4RoutingTableEntry* route);
+
+    mutable std::mutex m_mutex;                      //!< serializes the SPF workers
+    bool m_concurrent;                               //!< whether to take the mutex
+    std::deque<Ipv4RoutingTableEntry> m_slots;       //!< the entries, which never move
+    std::vector<Ipv4RoutingTableEntry*> m_freeSlots; //!< the entries of released routes
+    uint32_t m_nEntries;                             //!< the number of entries in use
+};
+
+} // namespace ns3
+
+#endif /* IPV4_GLOBAL_ROUTE_POOL_H */
@@ -18,6 +18,7 @@
 #include "ipv4-global-routing.h"
 
 #include "global-route-manager.h"
+#include "ipv4-global-route-pool.h"
 
 #include "ns3/boolean.h"
 #include "ns3/flow-id-tag.h"
@@ -30,8 +31,12 @@
 #include "ns3/object.h"
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
+#include "ns3/uinteger.h"
 
+#include <algorithm>
 #include <iomanip>
+#include <limits>
+#include <numeric>
 #include <vector>
 
 namespace ns3
@@ -59,13 +64,21 @@ Ipv4GlobalRouting::GetTypeId()
                           "Interface notification events (up/down, or add/remove address)",
                           BooleanValue(false),
                           MakeBooleanAccessor(&Ipv4GlobalRouting::m_respondToInterfaceEvents),
-                          MakeBooleanChecker());
+                          MakeBooleanChecker())
+            .AddAttribute("WcmpTableSize",
+                          "The number of slots of the table a group of weighted routes is "
+                          "compiled into; larger tables follow the weights more closely",
+                          UintegerValue(64),
+                          MakeUintegerAccessor(&Ipv4GlobalRouting::m_wcmpTableSize),
+                          MakeUintegerChecker<uint32_t>(1));
     return tid;
 }
 
 Ipv4GlobalRouting::Ipv4GlobalRouting()
     : m_randomEcmpRouting(false),
-      m_respondToInterfaceEvents(false)
+      m_respondToInterfaceEvents(false),
+      m_nWeightedRoutes(0),
+      m_wcmpTableSize(64)
 {
     NS_LOG_FUNCTION(this);
 
@@ -78,42 +91,53 @@ Ipv4GlobalRouting::~Ipv4GlobalRouting()
 }
 
 void
-Ipv4GlobalRouting::AddHostRouteTo(Ipv4Address dest, Ipv4Address nextHop, uint32_t interface)
+Ipv4GlobalRouting::AddHostRouteTo(Ipv4Address dest,
+                                  Ipv4Address nextHop,
+                                  uint32_t interface,
+                                  uint32_t weight)
 {
-    NS_LOG_FUNCTION(this << dest << nextHop << interface);
-    Ipv4RoutingTableEntry* route = new Ipv4RoutingTableEntry();
-    *route = Ipv4RoutingTableEntry::CreateHostRouteTo(dest, nextHop, interface);
-    m_hostRoutes.push_back(route);
+    NS_LOG_FUNCTION(this << dest << nextHop << interface << weight);
+    Ipv4RoutingTableEntry route =
+        Ipv4RoutingTableEntry::CreateHostRouteTo(dest, nextHop, interface);
+    m_hostRoutes.push_back(Ipv4GlobalRoutePool::Get()->Add(route));
+    AppendRouteWeight(m_hostRouteWeights, m_hostRoutes.size(), weight);
+    InvalidateRouteGroups();
 }
 
 void
 Ipv4GlobalRouting::AddHostRouteTo(Ipv4Address dest, uint32_t interface)
 {
     NS_LOG_FUNCTION(this << dest << interface);
-    Ipv4RoutingTableEntry* route = new Ipv4RoutingTableEntry();
-    *route = Ipv4RoutingTableEntry::CreateHostRouteTo(dest, interface);
-    m_hostRoutes.push_back(route);
+    Ipv4RoutingTableEntry route = Ipv4RoutingTableEntry::CreateHostRouteTo(dest, interface);
+    m_hostRoutes.push_back(Ipv4GlobalRoutePool::Get()->Add(route));
+    AppendRouteWeight(m_hostRouteWeights, m_hostRoutes.size(), 1);
+    InvalidateRouteGroups();
 }
 
 void
 Ipv4GlobalRouting::AddNetworkRouteTo(Ipv4Address network,
                                      Ipv4Mask networkMask,
                                      Ipv4Address nextHop,
-                                     uint32_t interface)
+                                     uint32_t interface,
+                                     uint32_t weight)
 {
-    NS_LOG_FUNCTION(this << network << networkMask << nextHop << interface);
-    Ipv4RoutingTableEntry* route = new Ipv4RoutingTableEntry();
-    *route = Ipv4RoutingTableEntry::CreateNetworkRouteTo(network, networkMask, nextHop, interface);
-    m_networkRoutes.push_back(route);
+    NS_LOG_FUNCTION(this << network << networkMask << nextHop << interface << weight);
+    Ipv4RoutingTableEntry route =
+        Ipv4RoutingTableEntry::CreateNetworkRouteTo(network, networkMask, nextHop, interface);
+    m_networkRoutes.push_back(Ipv4GlobalRoutePool::Get()->Add(route));
+    AppendRouteWeight(m_networkRouteWeights, m_networkRoutes.size(), weight);
+    InvalidateRouteGroups();
 }
 
 void
 Ipv4GlobalRouting::AddNetworkRouteTo(Ipv4Address network, Ipv4Mask networkMask, uint32_t interface)
 {
     NS_LOG_FUNCTION(this << network << networkMask << interface);
-    Ipv4RoutingTableEntry* route = new Ipv4RoutingTableEntry();
-    *route = Ipv4RoutingTableEntry::CreateNetworkRouteTo(network, networkMask, interface);
-    m_networkRoutes.push_back(route);
+    Ipv4RoutingTableEntry route =
+        Ipv4RoutingTableEntry::CreateNetworkRouteTo(network, networkMask, interface);
+    m_networkRoutes.push_back(Ipv4GlobalRoutePool::Get()->Add(route));
+    AppendRouteWeight(m_networkRouteWeights, m_networkRoutes.size(), 1);
+    InvalidateRouteGroups();
 }
 
 void
@@ -123,17 +147,48 @@ Ipv4GlobalRouting::AddASExternalRouteTo(Ipv4Address network,
                                         uint32_t interface)
 {
     NS_LOG_FUNCTION(this << network << networkMask << nextHop << interface);
-    Ipv4RoutingTableEntry* route = new Ipv4RoutingTableEntry();
-    *route = Ipv4RoutingTableEntry::CreateNetworkRouteTo(network, networkMask, nextHop, interface);
-    m_ASexternalRoutes.push_back(route);
+    Ipv4RoutingTableEntry route =
+        Ipv4RoutingTableEntry::CreateNetworkRouteTo(network, networkMask, nextHop, interface);
+    m_ASexternalRoutes.push_back(Ipv4GlobalRoutePool::Get()->Add(route));
+    InvalidateRouteGroups();
 }
 
-std::vector<Ipv4RoutingTableEntry*>
-Ipv4GlobalRouting::GetRoutesToDst(Ipv4Address dst, Ptr<NetDevice> oif) {
+const Ipv4GlobalRouting::RouteGroup&
+Ipv4GlobalRouting::GetRoutesToDst(Ipv4Address dst, Ptr<NetDevice> oif)
+{
     NS_LOG_FUNCTION(this << dst << oif);
-    NS_LOG_LOGIC("Looking for all routes to " << dst);
-    std::vector<Ipv4RoutingTableEntry*> dstRoutes;
+    if (oif)
+    {
+        // Lookups restricted to an output interface are only made for locally
+        // generated packets bound to a device, so they are not compiled.
+        m_oifRouteGroup.clear();
+        CollectRoutesToDst(dst, oif, m_oifRouteGroup);
+        return m_oifRouteGroup;
+    }
+
+    auto groupItr = m_routeGroups.find(dst.Get());
+    if (groupItr != m_routeGroups.end())
+    {
+        NS_LOG_LOGIC("Found compiled group of " << groupItr->second.size() << " routes to "
+                                                << dst);
+        return groupItr->second;
+    }
 
+    NS_LOG_LOGIC("Compiling group of routes to " << dst);
+    RouteGroup& dstRoutes = m_routeGroups[dst.Get()];
+    CollectRoutesToDst(dst, nullptr, dstRoutes);
+    dstRoutes.shrink_to_fit();
+    return dstRoutes;
+}
+
+void
+Ipv4GlobalRouting::CollectRoutesToDst(Ipv4Address dst,
+                                      Ptr<NetDevice> oif,
+                                      RouteGroup& dstRoutes,
+                                      std::vector<uint32_t>* weights) const
+{
+    NS_LOG_FUNCTION(this << dst << oif);
+    NS_LOG_LOGIC("Looking for all routes to " << dst);
     NS_LOG_LOGIC("Number of host routes = " << m_hostRoutes.size());
     HostRoutesCI i = m_hostRoutes.begin();
     for (; i != m_hostRoutes.end(); i++) {
@@ -144,6 +199,11 @@ Ipv4GlobalRouting::GetRoutesToDst(Ipv4Address dst, Ptr<NetDevice> oif) {
                 continue;
             }
             dstRoutes.push_back(*i);
+            if (weights)
+            {
+                weights->push_back(
+                    LookupRouteWeight(m_hostRouteWeights, i - m_hostRoutes.begin()));
+            }
             NS_LOG_LOGIC(
                 dstRoutes.size() << "Found global host route " << *i);
         }
@@ -151,7 +211,7 @@ Ipv4GlobalRouting::GetRoutesToDst(Ipv4Address dst, Ptr<NetDevice> oif) {
     // No host route found.
     if (dstRoutes.empty()) {
         NS_LOG_LOGIC("Number of network routes = " << m_networkRoutes.size());
-        NetworkRoutesI j = m_networkRoutes.begin();
+        NetworkRoutesCI j = m_networkRoutes.begin();
         for (; j != m_networkRoutes.end(); j++) {
             Ipv4Mask mask = (*j)->GetDestNetworkMask();
             Ipv4Address entry = (*j)->GetDestNetwork();
@@ -162,6 +222,11 @@ Ipv4GlobalRouting::GetRoutesToDst(Ipv4Address dst, Ptr<NetDevice> oif) {
                     continue;
                 }
                 dstRoutes.push_back(*j);
+                if (weights)
+                {
+                    weights->push_back(
+                        LookupRouteWeight(m_networkRouteWeights, j - m_networkRoutes.begin()));
+                }
                 NS_LOG_LOGIC(
                     "Found " << dstRoutes.size() << " global network route " << *j);
             }
@@ -171,7 +236,7 @@ Ipv4GlobalRouting::GetRoutesToDst(Ipv4Address dst, Ptr<NetDevice> oif) {
     if (dstRoutes.empty()) {
         NS_LOG_LOGIC(
             "Number of external routes " << m_ASexternalRoutes.size());
-        ASExternalRoutesI k = m_ASexternalRoutes.begin();
+        ASExternalRoutesCI k = m_ASexternalRoutes.begin();
         for (; k != m_ASexternalRoutes.end(); k++) {
             Ipv4Mask mask = (*k)->GetDestNetworkMask();
             Ipv4Address entry = (*k)->GetDestNetwork();
@@ -181,12 +246,148 @@ Ipv4GlobalRouting::GetRoutesToDst(Ipv4Address dst, Ptr<NetDevice> oif) {
                     continue;
                 }
                 dstRoutes.push_back(*k);
+                if (weights)
+                {
+                    weights->push_back(1);
+                }
                 break;
             }
         }
     }
     NS_LOG_LOGIC("Found destination routes");
-    return dstRoutes;
+}
+
+void
+Ipv4GlobalRouting::InvalidateRouteGroups()
+{
+    NS_LOG_FUNCTION(this);
+    m_routeGroups.clear();
+    m_oifRouteGroup.clear();
+    m_wcmpTables.clear();
+}
+
+void
+Ipv4GlobalRouting::AppendRouteWeight(std::vector<uint32_t>& weights,
+                                     std::size_t nRoutes,
+                                     uint32_t weight)
+{
+    NS_ASSERT_MSG(weight > 0, "A route needs a positive weight");
+    // Most tables have no weights at all, so the weights are only kept once
+    // a route has a weight other than 1.
+    if (weights.empty() && weight == 1)
+    {
+        return;
+    }
+    weights.resize(nRoutes - 1, 1);
+    weights.push_back(weight);
+    if (weight != 1)
+    {
+        m_nWeightedRoutes++;
+    }
+}
+
+void
+Ipv4GlobalRouting::EraseRouteWeight(std::vector<uint32_t>& weights, std::size_t index)
+{
+    if (weights.empty())
+    {
+        return;
+    }
+    if (weights[index] != 1)
+    {
+        m_nWeightedRoutes--;
+    }
+    weights.erase(weights.begin() + index);
+    if (m_nWeightedRoutes == 0)
+    {
+        m_hostRouteWeights.clear();
+        m_networkRouteWeights.clear();
+    }
+}
+
+uint32_t
+Ipv4GlobalRouting::LookupRouteWeight(const std::vector<uint32_t>& weights, std::size_t index) const
+{
+    return weights.empty() ? 1 : weights[index];
+}
+
+bool
+Ipv4GlobalRouting::HasWeightedRoutes() const
+{
+    return m_nWeightedRoutes > 0;
+}
+
+uint32_t
+Ipv4GlobalRouting::PickWeightedRoute(Ipv4Address dst, const RouteGroup& routes, uint32_t key)
+{
+    NS_ASSERT_MSG(!routes.empty(), "No route to pick from");
+    if (m_nWeightedRoutes == 0 || &routes == &m_oifRouteGroup)
+    {
+        return key % routes.size();
+    }
+
+    auto tableItr = m_wcmpTables.find(dst.Get());
+    if (tableItr == m_wcmpTables.end())
+    {
+        NS_LOG_LOGIC("Compiling WCMP table of routes to " << dst);
+        tableItr = m_wcmpTables.emplace(dst.Get(), std::vector<uint32_t>()).first;
+        // The weights are kept by the positions of the routes in the table,
+        // not in the entries.
+        RouteGroup weightedRoutes;
+        std::vector<uint32_t> weights;
+        CollectRoutesToDst(dst, nullptr, weightedRoutes, &weights);
+        NS_ASSERT(weightedRoutes == routes);
+        CompileWcmpTable(weights, tableItr->second);
+    }
+    const std::vector<uint32_t>& table = tableItr->second;
+    if (table.empty())
+    {
+        return key % routes.size();
+    }
+    return table[key % table.size()];
+}
+
+void
+Ipv4GlobalRouting::CompileWcmpTable(const std::vector<uint32_t>& weights,
+                                    std::vector<uint32_t>& table) const
+{
+    NS_LOG_FUNCTION(this << weights.size());
+    if (std::all_of(weights.begin(), weights.end(), [&weights](uint32_t weight) {
+            return weight == weights[0];
+        }))
+    {
+        return;
+    }
+
+    // Every route keeps one slot so that no path is left unused, and the
+    // other slots are shared in proportion to the weights, the remainders
+    // going to the routes that lost the most to rounding.
+    uint32_t nRoutes = weights.size();
+    uint32_t nSlots = std::max(m_wcmpTableSize, nRoutes);
+    uint64_t spare = nSlots - nRoutes;
+    uint64_t totalWeight = std::accumulate(weights.begin(), weights.end(), uint64_t(0));
+    std::vector<uint64_t> slots(nRoutes, 1);
+    std::vector<uint32_t> byRemainder(nRoutes);
+    uint64_t assigned = nRoutes;
+    for (uint32_t i = 0; i < nRoutes; i++)
+    {
+        slots[i] += spare * weights[i] / totalWeight;
+        assigned += spare * weights[i] / totalWeight;
+        byRemainder[i] = i;
+    }
+    std::stable_sort(byRemainder.begin(), byRemainder.end(), [&](uint32_t a, uint32_t b) {
+        return spare * weights[a] % totalWeight > spare * weights[b] % totalWeight;
+    });
+    for (uint32_t i = 0; assigned < nSlots; i++, assigned++)
+    {
+        slots[byRemainder[i]]++;
+    }
+
+    table.reserve(nSlots);
+    for (uint32_t i = 0; i < nRoutes; i++)
+    {
+        table.insert(table.end(), slots[i], i);
+    }
 }
 
 Ptr<Ipv4Route>
@@ -196,8 +397,7 @@ Ipv4GlobalRouting::LookupGlobal(Ipv4Address dest, Ptr<NetDevice> oif)
     NS_LOG_LOGIC("Looking for route for destination " << dest);
     Ptr<Ipv4Route> rtentry = nullptr;
     // store all available routes that bring packets to their destination
-    typedef std::vector<Ipv4RoutingTableEntry*> RouteVec_t;
-    RouteVec_t allRoutes = GetRoutesToDst(dest, oif);
+    const RouteGroup& allRoutes = GetRoutesToDst(dest, oif);
 
     if (!allRoutes.empty()) // if route(s) is found
     {
@@ -205,7 +405,14 @@ Ipv4GlobalRouting::LookupGlobal(Ipv4Address dest, Ptr<NetDevice> oif)
         // ECMP routing is enabled, or always select the first route
         // consistently if random ECMP routing is disabled
         uint32_t selectIndex;
-        if (m_randomEcmpRouting)
+        if (m_randomEcmpRouting && HasWeightedRoutes())
+        {
+            selectIndex = PickWeightedRoute(
+                dest,
+                allRoutes,
+                m_rand->GetInteger(0, std::numeric_limits<uint32_t>::max() - 1));
+        }
+        else if (m_randomEcmpRouting)
         {
             selectIndex = m_rand->GetInteger(0, allRoutes.size() - 1);
         } else {
@@ -246,96 +453,126 @@ Ipv4GlobalRouting::GetRoute(uint32_t index) const
     NS_LOG_FUNCTION(this << index);
     if (index < m_hostRoutes.size())
     {
-        uint32_t tmp = 0;
-        for (HostRoutesCI i = m_hostRoutes.begin(); i != m_hostRoutes.end(); i++)
-        {
-            if (tmp == index)
-            {
-                return *i;
-            }
-            tmp++;
-        }
+        return m_hostRoutes[index];
     }
     index -= m_hostRoutes.size();
-    uint32_t tmp = 0;
     if (index < m_networkRoutes.size())
     {
-        for (NetworkRoutesCI j = m_networkRoutes.begin(); j != m_networkRoutes.end(); j++)
-        {
-            if (tmp == index)
-            {
-                return *j;
-            }
-            tmp++;
-        }
+        return m_networkRoutes[index];
     }
     index -= m_networkRoutes.size();
-    tmp = 0;
-    for (ASExternalRoutesCI k = m_ASexternalRoutes.begin(); k != m_ASexternalRoutes.end(); k++)
+    NS_ASSERT(index < m_ASexternalRoutes.size());
+    return m_ASexternalRoutes[index];
+}
+
+uint32_t
+Ipv4GlobalRouting::GetRouteWeight(uint32_t index) const
+{
+    NS_LOG_FUNCTION(this << index);
+    if (index < m_hostRoutes.size())
     {
-        if (tmp == index)
-        {
-            return *k;
-        }
-        tmp++;
+        return LookupRouteWeight(m_hostRouteWeights, index);
+    }
+    index -= m_hostRoutes.size();
+    if (index < m_networkRoutes.size())
+    {
+        return LookupRouteWeight(m_networkRouteWeights, index);
     }
-    NS_ASSERT(false);
-    // quiet compiler.
-    return nullptr;
+    NS_ASSERT(index - m_networkRoutes.size() < m_ASexternalRoutes.size());
+    return 1;
 }
 
 void
 Ipv4GlobalRouting::RemoveRoute(uint32_t index)
 {
     NS_LOG_FUNCTION(this << index);
+    InvalidateRouteGroups();
     if (index < m_hostRoutes.size())
     {
-        uint32_t tmp = 0;
-        for (HostRoutesI i = m_hostRoutes.begin(); i != m_hostRoutes.end(); i++)
-        {
-            if (tmp == index)
-            {
-                NS_LOG_LOGIC("Removing route " << index << "; size = " << m_hostRoutes.size());
-                delete *i;
-                m_hostRoutes.erase(i);
-                NS_LOG_LOGIC("Done removing host route "
-                             << index << "; host route remaining size = " << m_hostRoutes.size());
-                return;
-            }
-            tmp++;
-        }
+        NS_LOG_LOGIC("Removing route " << index << "; size = " << m_hostRoutes.size());
+        EraseRouteWeight(m_hostRouteWeights, index);
+        Ipv4GlobalRoutePool::Get()->Release(m_hostRoutes[index]);
+        m_hostRoutes.erase(m_hostRoutes.begin() + index);
+        NS_LOG_LOGIC("Done removing host route "
+                     << index << "; host route remaining size = " << m_hostRoutes.size());
+        return;
     }
     index -= m_hostRoutes.size();
-    uint32_t tmp = 0;
-    for (NetworkRoutesI j = m_networkRoutes.begin(); j != m_networkRoutes.end(); j++)
+    if (index < m_networkRoutes.size())
+    {
+        NS_LOG_LOGIC("Removing route " << index << "; size = " << m_networkRoutes.size());
+        EraseRouteWeight(m_networkRouteWeights, index);
+        Ipv4GlobalRoutePool::Get()->Release(m_networkRoutes[index]);
+        m_networkRoutes.erase(m_networkRoutes.begin() + index);
+        NS_LOG_LOGIC("Done removing network route "
+                     << index << "; network route remaining size = " << m_networkRoutes.size());
+        return;
+    }
+    index -= m_networkRoutes.size();
+    NS_ASSERT(index < m_ASexternalRoutes.size());
+    NS_LOG_LOGIC("Removing route " << index << "; size = " << m_ASexternalRoutes.size());
+    Ipv4GlobalRoutePool::Get()->Release(m_ASexternalRoutes[index]);
+    m_ASexternalRoutes.erase(m_ASexternalRoutes.begin() + index);
+    NS_LOG_LOGIC("Done removing external route "
+                 << index << "; external route remaining size = " << m_ASexternalRoutes.size());
+}
+
+bool
+Ipv4GlobalRouting::RemoveHostRouteTo(Ipv4Address dest, Ipv4Address nextHop, uint32_t interface)
+{
+    NS_LOG_FUNCTION(this << dest << nextHop << interface);
+    for (HostRoutesI i = m_hostRoutes.begin(); i != m_hostRoutes.end(); i++)
     {
-        if (tmp == index)
+        if ((*i)->GetDest() == dest && (*i)->GetGateway() == nextHop &&
+            (*i)->GetInterface() == interface)
         {
-            NS_LOG_LOGIC("Removing route " << index << "; size = " << m_networkRoutes.size());
-            delete *j;
-            m_networkRoutes.erase(j);
-            NS_LOG_LOGIC("Done removing network route "
-                         << index << "; network route remaining size = " << m_networkRoutes.size());
-            return;
+            EraseRouteWeight(m_hostRouteWeights, i - m_hostRoutes.begin());
+            Ipv4GlobalRoutePool::Get()->Release(*i);
+            m_hostRoutes.erase(i);
+            InvalidateRouteGroups();
+            return true;
         }
-        tmp++;
     }
-    index -= m_networkRoutes.size();
-    tmp = 0;
-    for (ASExternalRoutesI k = m_ASexternalRoutes.begin(); k != m_ASexternalRoutes.end(); k++)
+    return false;
+}
+
+bool
+Ipv4GlobalRouting::RemoveNetworkRouteTo(Ipv4Address network,
+                                        Ipv4Mask networkMask,
+                                        Ipv4Address nextHop,
+                                        uint32_t interface)
+{
+    NS_LOG_FUNCTION(this << network << networkMask << nextHop << interface);
+    for (NetworkRoutesI j = m_networkRoutes.begin(); j != m_networkRoutes.end(); j++)
     {
-        if (tmp == index)
+        if ((*j)->GetDestNetwork() == network && (*j)->GetDestNetworkMask() == networkMask &&
+            (*j)->GetGateway() == nextHop && (*j)->GetInterface() == interface)
         {
-            NS_LOG_LOGIC("Removing route " << index << "; size = " << m_ASexternalRoutes.size());
-            delete *k;
-            m_ASexternalRoutes.erase(k);
-            NS_LOG_LOGIC("Done removing network route "
-                         << index << "; network route remaining size = " << m_networkRoutes.size());
-            return;
+            EraseRouteWeight(m_networkRouteWeights, j - m_networkRoutes.begin());
+            Ipv4GlobalRoutePool::Get()->Release(*j);
+            m_networkRoutes.erase(j);
+            InvalidateRouteGroups();
+            return true;
         }
-        tmp++;
     }
-    NS_ASSERT(false);
+    return false;
+}
+
+void
+Ipv4GlobalRouting::ClearRoutes()
+{
+    NS_LOG_FUNCTION(this);
+    Ipv4GlobalRoutePool* pool = Ipv4GlobalRoutePool::Get();
+    pool->Release(m_hostRoutes);
+    pool->Release(m_networkRoutes);
+    pool->Release(m_ASexternalRoutes);
+    m_hostRoutes.clear();
+    m_networkRoutes.clear();
+    m_ASexternalRoutes.clear();
+    m_hostRouteWeights.clear();
+    m_networkRouteWeights.clear();
+    m_nWeightedRoutes = 0;
+    InvalidateRouteGroups();
 }
 
 int64_t
@@ -350,20 +587,11 @@ void
 Ipv4GlobalRouting::DoDispose()
 {
     NS_LOG_FUNCTION(this);
-    for (HostRoutesI i = m_hostRoutes.begin(); i != m_hostRoutes.end(); i = m_hostRoutes.erase(i))
-    {
-        delete (*i);
-    }
-    for (NetworkRoutesI j = m_networkRoutes.begin(); j != m_networkRoutes.end();
-         j = m_networkRoutes.erase(j))
-    {
-        delete (*j);
-    }
-    for (ASExternalRoutesI l = m_ASexternalRoutes.begin(); l != m_ASexternalRoutes.end();
-         l = m_ASexternalRoutes.erase(l))
-    {
-        delete (*l);
-    }
+    ClearRoutes();
+    HostRoutes().swap(m_hostRoutes);
+    NetworkRoutes().swap(m_networkRoutes);
+    ASExternalRoutes().swap(m_ASexternalRoutes);
+    m_recompute = MakeNullCallback<void>();
 
     Ipv4RoutingProtocol::DoDispose();
 }
@@ -530,48 +758,51 @@ void
 Ipv4GlobalRouting::NotifyInterfaceUp(uint32_t i)
 {
     NS_LOG_FUNCTION(this << i);
-    if (m_respondToInterfaceEvents && Simulator::Now().GetSeconds() > 0) // avoid startup events
-    {
-        GlobalRouteManager::DeleteGlobalRoutes();
-        GlobalRouteManager::BuildGlobalRoutingDatabase();
-        GlobalRouteManager::InitializeRoutes();
-    }
+    RespondToInterfaceEvent();
 }
 
 void
 Ipv4GlobalRouting::NotifyInterfaceDown(uint32_t i)
 {
     NS_LOG_FUNCTION(this << i);
-    if (m_respondToInterfaceEvents && Simulator::Now().GetSeconds() > 0) // avoid startup events
-    {
-        GlobalRouteManager::DeleteGlobalRoutes();
-        GlobalRouteManager::BuildGlobalRoutingDatabase();
-        GlobalRouteManager::InitializeRoutes();
-    }
+    RespondToInterfaceEvent();
 }
 
 void
 Ipv4GlobalRouting::NotifyAddAddress(uint32_t interface, Ipv4InterfaceAddress address)
 {
     NS_LOG_FUNCTION(this << interface << address);
-    if (m_respondToInterfaceEvents && Simulator::Now().GetSeconds() > 0) // avoid startup events
-    {
-        GlobalRouteManager::DeleteGlobalRoutes();
-        GlobalRouteManager::BuildGlobalRoutingDatabase();
-        GlobalRouteManager::InitializeRoutes();
-    }
+    RespondToInterfaceEvent();
 }
 
 void
 Ipv4GlobalRouting::NotifyRemoveAddress(uint32_t interface, Ipv4InterfaceAddress address)
 {
     NS_LOG_FUNCTION(this << interface << address);
-    if (m_respondToInterfaceEvents && Simulator::Now().GetSeconds() > 0) // avoid startup events
+    RespondToInterfaceEvent();
+}
+
+void
+Ipv4GlobalRouting::SetRecomputeCallback(Callback<void> recompute)
+{
+    NS_LOG_FUNCTION(this);
+    m_recompute = recompute;
+}
+
+void
+Ipv4GlobalRouting::RespondToInterfaceEvent()
+{
+    NS_LOG_FUNCTION(this);
+    if (!m_respondToInterfaceEvents || Simulator::Now().GetSeconds() <= 0) // avoid startup events
+    {
+        return;
+    }
+    if (!m_recompute.IsNull())
     {
-        GlobalRouteManager::DeleteGlobalRoutes();
-        GlobalRouteManager::BuildGlobalRoutingDatabase();
-        GlobalRouteManager::InitializeRoutes();
+        m_recompute();
+        return;
     }
+    GlobalRouteManager::UpdateRoutes();
 }
 
 void
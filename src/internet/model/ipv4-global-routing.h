@@ -26,8 +26,9 @@
 #include "ns3/ptr.h"
 #include "ns3/random-variable-stream.h"
 
-#include <list>
 #include <stdint.h>
+#include <unordered_map>
+#include <vector>
 
 namespace ns3
 {
@@ -115,10 +116,15 @@ class Ipv4GlobalRouting : public Ipv4RoutingProtocol
      * \param nextHop The Ipv4Address of the next hop in the route.
      * \param interface The network interface index used to send packets to the
      * destination.
+     * \param weight The share of the traffic to the destination this route
+     * takes relative to the other routes to it (see PickWeightedRoute).
      *
      * \see Ipv4Address
      */
-    void AddHostRouteTo(Ipv4Address dest, Ipv4Address nextHop, uint32_t interface);
+    void AddHostRouteTo(Ipv4Address dest,
+                        Ipv4Address nextHop,
+                        uint32_t interface,
+                        uint32_t weight = 1);
     /**
      * \brief Add a host route to the global routing table.
      *
@@ -138,13 +144,16 @@ class Ipv4GlobalRouting : public Ipv4RoutingProtocol
      * \param nextHop The next hop in the route to the destination network.
      * \param interface The network interface index used to send packets to the
      * destination.
+     * \param weight The share of the traffic to the destination this route
+     * takes relative to the other routes to it (see PickWeightedRoute).
      *
      * \see Ipv4Address
      */
     void AddNetworkRouteTo(Ipv4Address network,
                            Ipv4Mask networkMask,
                            Ipv4Address nextHop,
-                           uint32_t interface);
+                           uint32_t interface,
+                           uint32_t weight = 1);
 
     /**
      * \brief Add a network route to the global routing table.
@@ -203,6 +212,14 @@ class Ipv4GlobalRouting : public Ipv4RoutingProtocol
      */
     Ipv4RoutingTableEntry* GetRoute(uint32_t i) const;
 
+    /**
+     * \brief Get the weight of a route of the global unicast routing table.
+     *
+     * \param i The index (into the routing table) of the route, as for GetRoute.
+     * \returns the weight the route was added with, 1 by default.
+     */
+    uint32_t GetRouteWeight(uint32_t i) const;
+
     /**
      * \brief Remove a route from the global unicast routing table.
      *
@@ -222,16 +239,105 @@ class Ipv4GlobalRouting : public Ipv4RoutingProtocol
     void RemoveRoute(uint32_t i);
 
     /**
-     * \brief Returns a list of routes to a given destination.
-     * 
+     * \brief Remove a host route from the global routing table.
+     *
+     * Only the first host route matching all the parameters is removed.
+     *
+     * \param dest The Ipv4Address destination of the route.
+     * \param nextHop The Ipv4Address of the next hop in the route.
+     * \param interface The network interface index of the route.
+     * \returns true if a route was removed
+     */
+    bool RemoveHostRouteTo(Ipv4Address dest, Ipv4Address nextHop, uint32_t interface);
+
+    /**
+     * \brief Remove a network route from the global routing table.
+     *
+     * Only the first network route matching all the parameters is removed.
+     *
+     * \param network The Ipv4Address network of the route.
+     * \param networkMask The Ipv4Mask of the network.
+     * \param nextHop The next hop in the route.
+     * \param interface The network interface index of the route.
+     * \returns true if a route was removed
+     */
+    bool RemoveNetworkRouteTo(Ipv4Address network,
+                              Ipv4Mask networkMask,
+                              Ipv4Address nextHop,
+                              uint32_t interface);
+
+    /**
+     * \brief Remove every route from the global routing table.
+     *
+     * Releases all of the entries at once and discards the next-hop groups
+     * a single time, where removing the routes one by one with RemoveRoute
+     * would take time quadratic in the size of the table.
+     */
+    void ClearRoutes();
+
+    /**
+     * \brief Set how the routes are recomputed upon interface events.
+     *
+     * When RespondToInterfaceEvents is set, interface events update the
+     * routes of the GlobalRouteManager, unless a callback is set, in which
+     * case it is invoked instead.  This lets helpers that install routes of
+     * their own, such as FatTreeRoutingHelper, recompute them when a link
+     * fails or comes back.
+     *
+     * \param recompute The callback, or a null callback to restore the
+     * GlobalRouteManager updates.
+     */
+    void SetRecomputeCallback(Callback<void> recompute);
+
+    /// A next-hop group: every route that can be used to reach a destination.
+    typedef std::vector<Ipv4RoutingTableEntry*> RouteGroup;
+
+    /**
+     * \brief Returns the next-hop group for a given destination.
+     *
+     * Groups are compiled lazily, the first time a destination is looked up,
+     * and are kept until the routing table changes. Any call that adds or
+     * removes a route (including GlobalRouteManager::InitializeRoutes and
+     * GlobalRouteManager::DeleteGlobalRoutes) discards the compiled groups,
+     * so a lookup on the forwarding path costs a single hash lookup and no
+     * allocation.
+     *
      * \param dst The destination address for which routes are being queried.
      * \param oif output interface if any (put nullptr otherwise).
-     * 
-     * \returns vector of Ipv4RoutingTableEntry pointers corresponding to
-     * routes to the destination.
+     *
+     * \returns a reference to the group of Ipv4RoutingTableEntry pointers
+     * corresponding to routes to the destination. The reference is
+     * invalidated by the next change to the routing table, or by the next
+     * lookup restricted to an output interface if `oif` is not null.
+     */
+    const RouteGroup& GetRoutesToDst(Ipv4Address dst, Ptr<NetDevice> oif = nullptr);
+
+    /**
+     * \brief Picks a route of the next-hop group of a destination in
+     * proportion to the weights of the routes (WCMP).
+     *
+     * The weighted groups are compiled lazily, like the next-hop groups,
+     * into a table of WcmpTableSize slots in which each route appears a
+     * number of times proportional to its weight, and at least once, so a
+     * pick is one table lookup. Groups whose routes all have the same weight
+     * have no table and are picked from uniformly, as are groups restricted
+     * to an output interface.
+     *
+     * \param dst The destination address.
+     * \param routes The group returned by GetRoutesToDst for dst.
+     * \param key A flow hash, or a uniform random number for per-packet
+     * picks.
+     * \returns the index of the picked route in routes.
      */
-    std::vector<Ipv4RoutingTableEntry*> GetRoutesToDst(
-      Ipv4Address dst, Ptr<NetDevice> oif = nullptr);
+    uint32_t PickWeightedRoute(Ipv4Address dst, const RouteGroup& routes, uint32_t key);
+
+    /**
+     * \brief Returns whether some route of this table has a weight other than
+     * 1, so that callers can keep their uniform picks otherwise.
+     *
+     * \returns true if routes may be picked by weight.
+     */
+    bool HasWeightedRoutes() const;
 
     /**
      * Assign a fixed random variable stream number to the random variables
@@ -252,29 +358,31 @@ class Ipv4GlobalRouting : public Ipv4RoutingProtocol
     /// Set to true if this interface should respond to interface events by globallly recomputing
     /// routes
     bool m_respondToInterfaceEvents;
+    /// Recomputes the routes upon interface events instead of the GlobalRouteManager, if not null
+    Callback<void> m_recompute;
     /// A uniform random number generator for randomly routing packets among ECMP
     Ptr<UniformRandomVariable> m_rand;
 
     /// container of Ipv4RoutingTableEntry (routes to hosts)
-    typedef std::list<Ipv4RoutingTableEntry*> HostRoutes;
+    typedef std::vector<Ipv4RoutingTableEntry*> HostRoutes;
     /// const iterator of container of Ipv4RoutingTableEntry (routes to hosts)
-    typedef std::list<Ipv4RoutingTableEntry*>::const_iterator HostRoutesCI;
+    typedef std::vector<Ipv4RoutingTableEntry*>::const_iterator HostRoutesCI;
     /// iterator of container of Ipv4RoutingTableEntry (routes to hosts)
-    typedef std::list<Ipv4RoutingTableEntry*>::iterator HostRoutesI;
+    typedef std::vector<Ipv4RoutingTableEntry*>::iterator HostRoutesI;
 
     /// container of Ipv4RoutingTableEntry (routes to networks)
-    typedef std::list<Ipv4RoutingTableEntry*> NetworkRoutes;
+    typedef std::vector<Ipv4RoutingTableEntry*> NetworkRoutes;
     /// const iterator of container of Ipv4RoutingTableEntry (routes to networks)
-    typedef std::list<Ipv4RoutingTableEntry*>::const_iterator NetworkRoutesCI;
+    typedef std::vector<Ipv4RoutingTableEntry*>::const_iterator NetworkRoutesCI;
     /// iterator of container of Ipv4RoutingTableEntry (routes to networks)
-    typedef std::list<Ipv4RoutingTableEntry*>::iterator NetworkRoutesI;
+    typedef std::vector<Ipv4RoutingTableEntry*>::iterator NetworkRoutesI;
 
     /// container of Ipv4RoutingTableEntry (routes to external AS)
-    typedef std::list<Ipv4RoutingTableEntry*> ASExternalRoutes;
+    typedef std::vector<Ipv4RoutingTableEntry*> ASExternalRoutes;
     /// const iterator of container of Ipv4RoutingTableEntry (routes to external AS)
-    typedef std::list<Ipv4RoutingTableEntry*>::const_iterator ASExternalRoutesCI;
+    typedef std::vector<Ipv4RoutingTableEntry*>::const_iterator ASExternalRoutesCI;
     /// iterator of container of Ipv4RoutingTableEntry (routes to external AS)
-    typedef std::list<Ipv4RoutingTableEntry*>::iterator ASExternalRoutesI;
+    typedef std::vector<Ipv4RoutingTableEntry*>::iterator ASExternalRoutesI;
 
     /**
      * \brief Lookup in the forwarding table for destination.
@@ -287,10 +395,91 @@ class Ipv4GlobalRouting : public Ipv4RoutingProtocol
     Ptr<Ipv4Route> LookupGlobal(
       Ipv4Address dest, Ptr<NetDevice> oif = nullptr);
 
+    /**
+     * \brief Scan the routing table for every route to a destination.
+     *
+     * Host routes are preferred over network routes, which are preferred
+     * over external routes.
+     *
+     * \param dst destination address.
+     * \param oif output interface if any (put 0 otherwise).
+     * \param dstRoutes the group that the matching routes are appended to.
+     * \param weights if not null, the weights of the matching routes are
+     * appended to it.
+     */
+    void CollectRoutesToDst(Ipv4Address dst,
+                            Ptr<NetDevice> oif,
+                            RouteGroup& dstRoutes,
+                            std::vector<uint32_t>* weights = nullptr) const;
+
+    /**
+     * \brief Discard the compiled next-hop groups after a routing table
+     * change.
+     */
+    void InvalidateRouteGroups();
+
+    /**
+     * \brief Recompute the routes after an interface event, if
+     * RespondToInterfaceEvents is set.
+     */
+    void RespondToInterfaceEvent();
+
+    /**
+     * \brief Records the weight of a route that was just appended to a table.
+     *
+     * \param weights The weights of the host or network routes.
+     * \param nRoutes The number of routes of the table, the new one included.
+     * \param weight The weight of the route.
+     */
+    void AppendRouteWeight(std::vector<uint32_t>& weights, std::size_t nRoutes, uint32_t weight);
+
+    /**
+     * \brief Forgets the weight of a route that is being removed from a table.
+     *
+     * \param weights The weights of the host or network routes.
+     * \param index The position of the route in its table.
+     */
+    void EraseRouteWeight(std::vector<uint32_t>& weights, std::size_t index);
+
+    /**
+     * \brief Returns the weight of a route.
+     *
+     * \param weights The weights of the host or network routes.
+     * \param index The position of the route in its table.
+     * \returns the weight of the route.
+     */
+    uint32_t LookupRouteWeight(const std::vector<uint32_t>& weights, std::size_t index) const;
+
+    /**
+     * \brief Builds the WCMP table of a next-hop group.
+     *
+     * \param weights The weights of the routes of the group.
+     * \param table The table to fill, left empty if every route of the
+     * group has the same weight.
+     */
+    void CompileWcmpTable(const std::vector<uint32_t>& weights, std::vector<uint32_t>& table) const;
+
+    // The routes are entries stored in the Ipv4GlobalRoutePool.
     HostRoutes m_hostRoutes;             //!< Routes to hosts
     NetworkRoutes m_networkRoutes;       //!< Routes to networks
     ASExternalRoutes m_ASexternalRoutes; //!< External routes imported
 
+    /// Compiled next-hop groups, keyed by destination address
+    std::unordered_map<uint32_t, RouteGroup> m_routeGroups;
+    /// Scratch group returned by lookups restricted to an output interface
+    RouteGroup m_oifRouteGroup;
+
+    /// Weights of the host and network routes, by position in their tables.
+    /// The entries are plain routing table entries, so the weights are kept
+    /// here. Empty while every route has weight 1.
+    std::vector<uint32_t> m_hostRouteWeights;
+    std::vector<uint32_t> m_networkRouteWeights; //!< \see m_hostRouteWeights
+    uint32_t m_nWeightedRoutes; //!< Number of routes with a weight other than 1
+    /// Compiled WCMP tables of route indices, keyed by destination address
+    std::unordered_map<uint32_t, std::vector<uint32_t>> m_wcmpTables;
+    /// Number of slots of a WCMP table
+    uint32_t m_wcmpTableSize;
+
     Ptr<Ipv4> m_ipv4; //!< associated IPv4 instance
 };
 
@@ -19,7 +19,7 @@
 #include "ipv4-drb-tag.h"
 #include "ipv4-list-routing.h"
 
-#include "ns3/flow-id-tag.h"
+#include "ns3/flow-key-tag.h"
 #include "ns3/ipv4-route.h"
 #include "ns3/ipv4-static-routing.h"
 #include "ns3/ipv4.h"
@@ -155,31 +155,36 @@ Ipv4ListRouting::RouteInput(Ptr<const Packet> p,
 
     // DRB Support
     // We need to query the DRB index to simulate IP-in-IP encapsulation.
-    Ptr<Packet> packet = p->Copy();
-    Ipv4Header ipHeader = header;
+    // Nodes without DRB forward the packet and header they were given, and
+    // DRB nodes only copy them when the destination is actually rewritten.
+    Ptr<const Packet> packet = p;
+    const Ipv4Header* ipHeader = &header;
+    Ipv4Header drbHeader;
 
     Ipv4DrbTag ipv4DrbTag;
-    bool foundDrb = packet->PeekPacketTag(ipv4DrbTag);
-
-    FlowIdTag flowIdTag;
-    bool foundFlowId = packet->PeekPacketTag(flowIdTag);
+    bool foundDrb = false;
+    if (m_drb != nullptr) {
+        foundDrb = p->PeekPacketTag(ipv4DrbTag);
+    }
 
     if (m_drb != nullptr && !foundDrb) {
         NS_LOG_DEBUG("DRB is enabled, currently no DRB tag");
-        uint32_t flowId = 0;
-        if (foundFlowId) {
-            flowId = flowIdTag.GetFlowId();
-        } else {
-            NS_LOG_ERROR("Cannot find flow ID in DRB");
+        uint64_t flowKey = FlowKeyTag::ExtractFlowKey(p);
+        if (flowKey == 0) {
+            NS_LOG_ERROR("Cannot find flow key in DRB");
         }
 
-        Ipv4Address addr = m_drb->GetCoreSwitchAddress(flowId);
+        Ipv4Address addr = m_drb->GetCoreSwitchAddress(flowKey);
         // NULL check
         if (addr != Ipv4Address()) {
             Ipv4DrbTag ipv4DrbTag;
             ipv4DrbTag.SetOriginalDstAddr(header.GetDestination());
-            ipHeader.SetDestination(addr);
-            packet->AddPacketTag(ipv4DrbTag);
+            Ptr<Packet> encapsulated = p->Copy();
+            encapsulated->AddPacketTag(ipv4DrbTag);
+            packet = encapsulated;
+            drbHeader = header;
+            drbHeader.SetDestination(addr);
+            ipHeader = &drbHeader;
             NS_LOG_DEBUG(
                 "Forwarding the packet to the core switch: " << addr);
         } else {
@@ -191,10 +196,12 @@ Ipv4ListRouting::RouteInput(Ptr<const Packet> p,
     if (retVal == true)
     {
         // DRB support, extract the original address.
-        if (m_drb != nullptr && foundDrb && !m_ipv4->IsDestinationAddress(
+        if (foundDrb && !m_ipv4->IsDestinationAddress(
             ipv4DrbTag.GetOriginalDstAddr(), iif)) {
             Ipv4Address originalDstAddr = ipv4DrbTag.GetOriginalDstAddr();
-            ipHeader.SetDestination(originalDstAddr);
+            drbHeader = header;
+            drbHeader.SetDestination(originalDstAddr);
+            ipHeader = &drbHeader;
             NS_LOG_DEBUG("Received DRB packet, bouncing packet to: "
                 << originalDstAddr);
         } else {
@@ -229,7 +236,7 @@ Ipv4ListRouting::RouteInput(Ptr<const Packet> p,
          rprotoIter != m_routingProtocols.end();
          rprotoIter++)
     {
-        if ((*rprotoIter).second->RouteInput(p, header, idev, ucb, mcb, downstreamLcb, ecb))
+        if ((*rprotoIter).second->RouteInput(packet, *ipHeader, idev, ucb, mcb, downstreamLcb, ecb))
         {
             NS_LOG_LOGIC("Route found to forward packet in protocol "
                          << (*rprotoIter).second->GetInstanceTypeId().GetName());
@@ -38,6 +38,7 @@
 #include "ns3/assert.h"
 #include "ns3/boolean.h"
 #include "ns3/flow-id-tag.h"
+#include "ns3/flow-key-tag.h"
 #include "ns3/ipv4-route.h"
 #include "ns3/ipv6-route.h"
 #include "ns3/log.h"
@@ -46,6 +47,7 @@
 #include "ns3/object-vector.h"
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
+#include "ns3/trace-source-accessor.h"
 
 #include <iomanip>
 #include <sstream>
@@ -96,7 +98,11 @@ TcpL4Protocol::GetTypeId()
                                           "The list of sockets associated to this protocol.",
                                           ObjectVectorValue(),
                                           MakeObjectVectorAccessor(&TcpL4Protocol::m_sockets),
-                                          MakeObjectVectorChecker<TcpSocketBase>());
+                                          MakeObjectVectorChecker<TcpSocketBase>())
+                            .AddTraceSource("AckReceived",
+                                            "An ACK acknowledged new data of an IPv4 flow",
+                                            MakeTraceSourceAccessor(&TcpL4Protocol::m_ackReceivedTrace),
+                                            "ns3::TcpL4Protocol::AckReceivedTracedCallback");
     return tid;
 }
 
@@ -583,22 +589,34 @@ TcpL4Protocol::Receive(Ptr<Packet> packet,
 void TcpL4Protocol::AttachFlowId(Ptr<Packet> packet, const Ipv4Address& saddr,
                                  const Ipv4Address& daddr, uint16_t sport,
                                  uint16_t dport) const {
-    uint32_t flowId = TcpL4Protocol::ConstructFlowId(saddr, daddr, sport, dport);
-    packet->AddPacketTag(FlowIdTag(flowId));
+    uint64_t flowKey = FlowKeyTag::ConstructFlowKey(saddr, daddr, sport, dport, PROT_NUMBER);
+    packet->AddPacketTag(FlowKeyTag(flowKey));
+    packet->AddPacketTag(FlowIdTag(FlowKeyTag::FoldFlowKey(flowKey)));
+}
+
+void
+TcpL4Protocol::NotifyAckReceived(const Ipv4Address& saddr,
+                                 const Ipv4Address& daddr,
+                                 uint16_t sport,
+                                 uint16_t dport,
+                                 uint32_t bytesAcked,
+                                 bool ecnEcho,
+                                 Time rtt)
+{
+    if (m_ackReceivedTrace.IsEmpty())
+    {
+        return;
+    }
+    uint64_t flowKey = FlowKeyTag::ConstructFlowKey(saddr, daddr, sport, dport, PROT_NUMBER);
+    m_ackReceivedTrace(flowKey, bytesAcked, ecnEcho, rtt);
 }
 
 uint32_t TcpL4Protocol::ConstructFlowId(const Ipv4Address& saddr,
                                         const Ipv4Address& daddr,
                                         uint16_t sport,
                                         uint16_t dport) const {
-    uint32_t flowId = 0;
-    flowId ^= saddr.Get();
-    flowId ^= daddr.Get();
-    flowId ^= sport;
-    flowId ^= (dport << 16);
-    flowId += PROT_NUMBER;
-
-    return flowId;
+    return FlowKeyTag::FoldFlowKey(
+        FlowKeyTag::ConstructFlowKey(saddr, daddr, sport, dport, PROT_NUMBER));
 }
 
 void
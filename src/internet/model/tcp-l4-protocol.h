@@ -24,7 +24,9 @@
 
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv6-address.h"
+#include "ns3/nstime.h"
 #include "ns3/sequence-number.h"
+#include "ns3/traced-callback.h"
 
 #include <stdint.h>
 
@@ -228,6 +230,42 @@ class TcpL4Protocol : public IpL4Protocol
                     const Address& daddr,
                     Ptr<NetDevice> oif = nullptr) const;
 
+    /**
+     * \brief Report an ACK that acknowledged new data of an IPv4 flow.
+     *
+     * Called by the sockets of this protocol. Fires the AckReceived trace,
+     * which lets load balancers on the node see the congestion that each
+     * flow meets.
+     *
+     * \param saddr the local address of the flow
+     * \param daddr the peer address of the flow
+     * \param sport the local port of the flow
+     * \param dport the peer port of the flow
+     * \param bytesAcked the number of bytes newly acknowledged
+     * \param ecnEcho whether the ACK carried an ECN echo
+     * \param rtt the latest RTT sample of the socket
+     */
+    void NotifyAckReceived(const Ipv4Address& saddr,
+                           const Ipv4Address& daddr,
+                           uint16_t sport,
+                           uint16_t dport,
+                           uint32_t bytesAcked,
+                           bool ecnEcho,
+                           Time rtt);
+
+    /**
+     * TracedCallback signature for the ACKs received by the sockets.
+     *
+     * \param [in] flowKey the FlowKeyTag key of the packets sent by the flow
+     * \param [in] bytesAcked the number of bytes newly acknowledged
+     * \param [in] ecnEcho whether the ACK carried an ECN echo
+     * \param [in] rtt the latest RTT sample of the socket
+     */
+    typedef void (*AckReceivedTracedCallback)(uint64_t flowKey,
+                                              uint32_t bytesAcked,
+                                              bool ecnEcho,
+                                              Time rtt);
+
     /**
      * \brief Make a socket fully operational
      *
@@ -344,11 +382,15 @@ class TcpL4Protocol : public IpL4Protocol
     IpL4Protocol::DownTargetCallback m_downTarget;   //!< Callback to send packets over IPv4
     IpL4Protocol::DownTargetCallback6 m_downTarget6; //!< Callback to send packets over IPv6
 
+    /// Trace of the ACKs acknowledging new data of IPv4 flows.
+    TracedCallback<uint64_t, uint32_t, bool, Time> m_ackReceivedTrace;
+
     /**
      * \brief Attach a Flow ID to the packet.
      * 
      * The flow ID is used to identify when a packet belongs to a particular
-     * flow.
+     * flow. The packet gets a FlowKeyTag holding the 64-bit key of the
+     * 5-tuple and a FlowIdTag holding the key folded to 32 bits.
      * 
      * \param packet the packet to which the flow ID will be attached.
      * \param saddr the source address for the packet.
@@ -363,7 +405,7 @@ class TcpL4Protocol : public IpL4Protocol
     /**
      * \brief Constructs the flow ID.
      * 
-     * The Flow ID is constructed from the given data.
+     * The Flow ID is the 32-bit fold of the FlowKeyTag key of the 5-tuple.
      * 
      * \param saddr the source address for the packet.
      * \param daddr the destination address for the packet.
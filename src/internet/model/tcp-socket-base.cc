@@ -1861,6 +1861,17 @@ TcpSocketBase::ReceivedAck(Ptr<Packet> packet, const TcpHeader& tcpHeader)
         static_cast<uint32_t>(m_rateOps->GetConnectionRate().m_delivered - previousDelivered);
     m_tcb->m_lastAckedSackedBytes = currentDelivered;
 
+    if (ackNumber > oldHeadSequence && m_endPoint != nullptr)
+    {
+        m_tcp->NotifyAckReceived(m_endPoint->GetLocalAddress(),
+                                 m_endPoint->GetPeerAddress(),
+                                 m_endPoint->GetLocalPort(),
+                                 m_endPoint->GetPeerPort(),
+                                 ackNumber - oldHeadSequence,
+                                 tcpHeader.GetFlags() & TcpHeader::ECE,
+                                 m_tcb->m_lastRtt.Get());
+    }
+
     if (m_tcb->m_congState == TcpSocketState::CA_CWR && (ackNumber > m_recover))
     {
         // Recovery is over after the window exceeds m_recover
@@ -31,6 +31,8 @@
 
 #include "ns3/assert.h"
 #include "ns3/boolean.h"
+#include "ns3/flow-id-tag.h"
+#include "ns3/flow-key-tag.h"
 #include "ns3/ipv4-route.h"
 #include "ns3/ipv6-header.h"
 #include "ns3/ipv6-route.h"
@@ -447,6 +449,8 @@ UdpL4Protocol::Send(Ptr<Packet> packet,
 
     packet->AddHeader(udpHeader);
 
+    AttachFlowId(packet, saddr, daddr, sport, dport);
+
     m_downTarget(packet, saddr, daddr, PROT_NUMBER, nullptr);
 }
 
@@ -471,6 +475,8 @@ UdpL4Protocol::Send(Ptr<Packet> packet,
 
     packet->AddHeader(udpHeader);
 
+    AttachFlowId(packet, saddr, daddr, sport, dport);
+
     m_downTarget(packet, saddr, daddr, PROT_NUMBER, route);
 }
 
@@ -521,6 +527,24 @@ UdpL4Protocol::Send(Ptr<Packet> packet,
     m_downTarget6(packet, saddr, daddr, PROT_NUMBER, route);
 }
 
+void
+UdpL4Protocol::AttachFlowId(Ptr<Packet> packet,
+                            Ipv4Address saddr,
+                            Ipv4Address daddr,
+                            uint16_t sport,
+                            uint16_t dport) const
+{
+    NS_LOG_FUNCTION(this << packet << saddr << daddr << sport << dport);
+
+    // Applications may hand down packets that already carry flow tags, so
+    // they are replaced rather than added.
+    uint64_t flowKey = FlowKeyTag::ConstructFlowKey(saddr, daddr, sport, dport, PROT_NUMBER);
+    FlowKeyTag flowKeyTag(flowKey);
+    packet->ReplacePacketTag(flowKeyTag);
+    FlowIdTag flowIdTag(FlowKeyTag::FoldFlowKey(flowKey));
+    packet->ReplacePacketTag(flowIdTag);
+}
+
 void
 UdpL4Protocol::SetDownTarget(IpL4Protocol::DownTargetCallback callback)
 {
@@ -283,6 +283,24 @@ class UdpL4Protocol : public IpL4Protocol
     void NotifyNewAggregate() override;
 
   private:
+    /**
+     * \brief Attach the flow tags of an IPv4 5-tuple to the packet.
+     *
+     * Like TcpL4Protocol, the packet gets a FlowKeyTag with the 64-bit key
+     * and a FlowIdTag with the key folded to 32 bits.
+     *
+     * \param packet the packet to tag
+     * \param saddr the source address
+     * \param daddr the destination address
+     * \param sport the source port
+     * \param dport the destination port
+     */
+    void AttachFlowId(Ptr<Packet> packet,
+                      Ipv4Address saddr,
+                      Ipv4Address daddr,
+                      uint16_t sport,
+                      uint16_t dport) const;
+
     Ptr<Node> m_node;                //!< the node this stack is associated with
     Ipv4EndPointDemux* m_endPoints;  //!< A list of IPv4 end points.
     Ipv6EndPointDemux* m_endPoints6; //!< A list of IPv6 end points.
@@ -199,6 +199,13 @@ GlobalRouteManagerImplTestCase::DoRun()
     NS_TEST_ASSERT_MSG_EQ(lsa2,
                           srmlsdb->GetLSA(lsa2->GetLinkStateId()),
                           "The Ipv4Address is not stored as the link state ID");
+    // The neighbors are resolved on first use.
+    const std::vector<GlobalRoutingLSA*>& adjacent = srmlsdb->GetAdjacentLSAs(lsa2);
+    NS_TEST_ASSERT_MSG_EQ(adjacent.size(), 6, "One neighbor per link record");
+    NS_TEST_ASSERT_MSG_EQ(adjacent[0], lsa0, "Point-to-point link 0 not resolved");
+    NS_TEST_ASSERT_MSG_EQ(adjacent[1], nullptr, "Stub networks have no neighbor LSA");
+    NS_TEST_ASSERT_MSG_EQ(adjacent[2], lsa1, "Point-to-point link 1 not resolved");
+    NS_TEST_ASSERT_MSG_EQ(adjacent[4], lsa3, "Point-to-point link 2 not resolved");
 
     // next, calculate routes based on the manually created LSDB
     GlobalRouteManagerImpl* srm = new GlobalRouteManagerImpl();
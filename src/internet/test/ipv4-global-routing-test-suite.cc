@@ -16,8 +16,12 @@
 #include "ns3/boolean.h"
 #include "ns3/bridge-helper.h"
 #include "ns3/config.h"
+#include "ns3/data-rate.h"
+#include "ns3/fat-tree-routing-helper.h"
+#include "ns3/global-route-manager-impl.h"
 #include "ns3/inet-socket-address.h"
 #include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-global-route-pool.h"
 #include "ns3/ipv4-address-helper.h"
 #include "ns3/ipv4-global-routing-helper.h"
 #include "ns3/ipv4-global-routing.h"
@@ -34,6 +38,7 @@
 #include "ns3/simple-channel.h"
 #include "ns3/simple-net-device-helper.h"
 #include "ns3/simple-net-device.h"
+#include "ns3/simulation-singleton.h"
 #include "ns3/simulator.h"
 #include "ns3/socket-factory.h"
 #include "ns3/string.h"
@@ -41,6 +46,8 @@
 #include "ns3/udp-socket-factory.h"
 #include "ns3/uinteger.h"
 
+#include <algorithm>
+#include <sstream>
 #include <vector>
 
 using namespace ns3;
@@ -1313,6 +1320,884 @@ Ipv4GlobalRoutingSlash32TestCase::DoRun()
     Simulator::Destroy();
 }
 
+/**
+ * \ingroup internet-test
+ *
+ * \brief IPv4 GlobalRouting next-hop group test
+ *
+ * Checks that the compiled next-hop groups returned by
+ * Ipv4GlobalRouting::GetRoutesToDst honour the host/network precedence of the
+ * routing table, and that they are rebuilt when routes are added or removed.
+ */
+class Ipv4GlobalRoutingRouteGroupTestCase : public TestCase
+{
+  public:
+    Ipv4GlobalRoutingRouteGroupTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+Ipv4GlobalRoutingRouteGroupTestCase::Ipv4GlobalRoutingRouteGroupTestCase()
+    : TestCase("Global routing next-hop groups are compiled and invalidated")
+{
+}
+
+void
+Ipv4GlobalRoutingRouteGroupTestCase::DoRun()
+{
+    Ptr<Ipv4GlobalRouting> globalRouting = CreateObject<Ipv4GlobalRouting>();
+    globalRouting->AddNetworkRouteTo(Ipv4Address("10.1.0.0"),
+                                     Ipv4Mask("255.255.0.0"),
+                                     Ipv4Address("10.0.0.1"),
+                                     1);
+    globalRouting->AddNetworkRouteTo(Ipv4Address("10.1.0.0"),
+                                     Ipv4Mask("255.255.0.0"),
+                                     Ipv4Address("10.0.0.5"),
+                                     2);
+
+    const Ipv4GlobalRouting::RouteGroup& networkGroup =
+        globalRouting->GetRoutesToDst(Ipv4Address("10.1.2.3"));
+    NS_TEST_ASSERT_MSG_EQ(networkGroup.size(), 2, "Expected both network routes");
+    NS_TEST_ASSERT_MSG_EQ(networkGroup[0]->GetInterface(), 1, "Group order changed");
+    NS_TEST_ASSERT_MSG_EQ(networkGroup[1]->GetInterface(), 2, "Group order changed");
+    NS_TEST_ASSERT_MSG_EQ(&networkGroup,
+                          &globalRouting->GetRoutesToDst(Ipv4Address("10.1.2.3")),
+                          "Expected the compiled group to be reused");
+    NS_TEST_ASSERT_MSG_EQ(globalRouting->GetRoutesToDst(Ipv4Address("10.2.0.1")).size(),
+                          0,
+                          "Expected no route to an unknown network");
+
+    // A host route takes precedence over the network routes, and adding it
+    // must discard the previously compiled group.
+    globalRouting->AddHostRouteTo(Ipv4Address("10.1.2.3"), Ipv4Address("10.0.0.9"), 3);
+    const Ipv4GlobalRouting::RouteGroup& hostGroup =
+        globalRouting->GetRoutesToDst(Ipv4Address("10.1.2.3"));
+    NS_TEST_ASSERT_MSG_EQ(hostGroup.size(), 1, "Expected only the host route");
+    NS_TEST_ASSERT_MSG_EQ(hostGroup[0]->GetInterface(), 3, "Expected the host route");
+    NS_TEST_ASSERT_MSG_EQ(globalRouting->GetRoutesToDst(Ipv4Address("10.1.2.4")).size(),
+                          2,
+                          "Expected the network routes for other hosts");
+
+    // Removing the host route falls back to the network routes.
+    globalRouting->RemoveRoute(0);
+    NS_TEST_ASSERT_MSG_EQ(globalRouting->GetRoutesToDst(Ipv4Address("10.1.2.3")).size(),
+                          2,
+                          "Expected the network routes after removing the host route");
+
+    globalRouting->Dispose();
+}
+
+/**
+ * \ingroup internet-test
+ *
+ * \brief IPv4 GlobalRouting parallel route build test
+ *
+ * Builds the routes of a leaf-spine topology serially and then with several
+ * workers, and checks that every node ends up with the same routes in the
+ * same order.
+ */
+class Ipv4GlobalRoutingParallelSpfTestCase : public TestCase
+{
+  public:
+    Ipv4GlobalRoutingParallelSpfTestCase();
+
+  private:
+    void DoRun() override;
+
+    /**
+     * \brief Describe the routes of every node
+     * \returns the routes of each node, one line per route
+     */
+    std::vector<std::string> GetAllRoutes() const;
+
+    NodeContainer m_nodes; //!< Nodes used in the test.
+};
+
+Ipv4GlobalRoutingParallelSpfTestCase::Ipv4GlobalRoutingParallelSpfTestCase()
+    : TestCase("Global routes built by several workers match a serial build")
+{
+}
+
+std::vector<std::string>
+Ipv4GlobalRoutingParallelSpfTestCase::GetAllRoutes() const
+{
+    std::vector<std::string> allRoutes;
+    for (uint32_t n = 0; n < m_nodes.GetN(); n++)
+    {
+        Ptr<Ipv4GlobalRouting> routing = m_nodes.Get(n)
+                                             ->GetObject<Ipv4L3Protocol>()
+                                             ->GetRoutingProtocol()
+                                             ->GetObject<Ipv4GlobalRouting>();
+        std::ostringstream routes;
+        for (uint32_t i = 0; i < routing->GetNRoutes(); i++)
+        {
+            routes << *routing->GetRoute(i) << "\n";
+        }
+        allRoutes.push_back(routes.str());
+    }
+    return allRoutes;
+}
+
+void
+Ipv4GlobalRoutingParallelSpfTestCase::DoRun()
+{
+    // Two spines, four leaves and two hosts per leaf.
+    const uint32_t nSpines = 2;
+    const uint32_t nLeaves = 4;
+    const uint32_t nHosts = 2;
+    m_nodes.Create(nSpines + nLeaves + nLeaves * nHosts);
+
+    InternetStackHelper internet;
+    Ipv4GlobalRoutingHelper ipv4RoutingHelper;
+    internet.SetRoutingHelper(ipv4RoutingHelper);
+    internet.Install(m_nodes);
+
+    SimpleNetDeviceHelper simpleHelper;
+    simpleHelper.SetNetDevicePointToPointMode(true);
+    Ipv4AddressHelper ipv4;
+    ipv4.SetBase("10.0.0.0", "255.255.255.252");
+    for (uint32_t leaf = 0; leaf < nLeaves; leaf++)
+    {
+        Ptr<Node> leafNode = m_nodes.Get(nSpines + leaf);
+        for (uint32_t spine = 0; spine < nSpines; spine++)
+        {
+            Ptr<SimpleChannel> channel = CreateObject<SimpleChannel>();
+            ipv4.Assign(
+                simpleHelper.Install(NodeContainer(leafNode, m_nodes.Get(spine)), channel));
+            ipv4.NewNetwork();
+        }
+        for (uint32_t host = 0; host < nHosts; host++)
+        {
+            Ptr<Node> hostNode = m_nodes.Get(nSpines + nLeaves + leaf * nHosts + host);
+            Ptr<SimpleChannel> channel = CreateObject<SimpleChannel>();
+            ipv4.Assign(simpleHelper.Install(NodeContainer(hostNode, leafNode), channel));
+            ipv4.NewNetwork();
+        }
+    }
+
+    Ipv4GlobalRoutingHelper::PopulateRoutingTables();
+    std::vector<std::string> serialRoutes = GetAllRoutes();
+
+    Config::SetGlobal("GlobalRoutingWorkers", UintegerValue(3));
+    Ipv4GlobalRoutingHelper::RecomputeRoutingTables();
+    Config::SetGlobal("GlobalRoutingWorkers", UintegerValue(1));
+    std::vector<std::string> parallelRoutes = GetAllRoutes();
+
+    for (uint32_t n = 0; n < m_nodes.GetN(); n++)
+    {
+        NS_TEST_ASSERT_MSG_NE(serialRoutes[n], "", "Node " << n << " has no routes");
+        NS_TEST_ASSERT_MSG_EQ(parallelRoutes[n],
+                              serialRoutes[n],
+                              "Node " << n << " has different routes");
+    }
+
+    Simulator::Destroy();
+}
+
+/**
+ * \ingroup internet-test
+ *
+ * \brief Leaf-spine routes installed by FatTreeRoutingHelper
+ *
+ * Checks the ECMP groups of the servers, the leaves and the spines of a
+ * fabric with two parallel links between each leaf and spine.
+ */
+class Ipv4FatTreeRoutingTestCase : public TestCase
+{
+  public:
+    Ipv4FatTreeRoutingTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+Ipv4FatTreeRoutingTestCase::Ipv4FatTreeRoutingTestCase()
+    : TestCase("Closed-form leaf-spine routes")
+{
+}
+
+void
+Ipv4FatTreeRoutingTestCase::DoRun()
+{
+    const uint32_t nSpines = 2;
+    const uint32_t nLeaves = 2;
+    const uint32_t nHosts = 2;
+    const uint32_t nLinks = 2;
+    NodeContainer spines;
+    spines.Create(nSpines);
+    NodeContainer leaves;
+    leaves.Create(nLeaves);
+    NodeContainer hosts;
+    hosts.Create(nLeaves * nHosts);
+
+    InternetStackHelper internet;
+    Ipv4GlobalRoutingHelper ipv4RoutingHelper;
+    internet.SetRoutingHelper(ipv4RoutingHelper);
+    internet.Install(spines);
+    internet.Install(leaves);
+    internet.Install(hosts);
+
+    SimpleNetDeviceHelper simpleHelper;
+    simpleHelper.SetNetDevicePointToPointMode(true);
+    Ipv4AddressHelper ipv4;
+    ipv4.SetBase("10.0.0.0", "255.255.255.252");
+    std::vector<Ipv4Address> hostAddresses;
+    for (uint32_t leaf = 0; leaf < nLeaves; leaf++)
+    {
+        for (uint32_t host = 0; host < nHosts; host++)
+        {
+            Ptr<SimpleChannel> channel = CreateObject<SimpleChannel>();
+            Ipv4InterfaceContainer interfaces = ipv4.Assign(simpleHelper.Install(
+                NodeContainer(hosts.Get(leaf * nHosts + host), leaves.Get(leaf)),
+                channel));
+            hostAddresses.push_back(interfaces.GetAddress(0));
+            ipv4.NewNetwork();
+        }
+        for (uint32_t spine = 0; spine < nSpines; spine++)
+        {
+            for (uint32_t link = 0; link < nLinks; link++)
+            {
+                Ptr<SimpleChannel> channel = CreateObject<SimpleChannel>();
+                ipv4.Assign(
+                    simpleHelper.Install(NodeContainer(leaves.Get(leaf), spines.Get(spine)),
+                                         channel));
+                ipv4.NewNetwork();
+            }
+        }
+    }
+
+    FatTreeRoutingHelper fatTreeRouting(spines, leaves);
+    fatTreeRouting.PopulateRoutingTables();
+
+    auto getRouting = [](Ptr<Node> node) {
+        return node->GetObject<Ipv4L3Protocol>()
+            ->GetRoutingProtocol()
+            ->GetObject<Ipv4GlobalRouting>();
+    };
+
+    // Host 0 and 1 are on leaf 0, host 2 and 3 on leaf 1.
+    Ptr<Ipv4GlobalRouting> hostRouting = getRouting(hosts.Get(0));
+    NS_TEST_ASSERT_MSG_EQ(hostRouting->GetNRoutes(), 1, "A server has only a default route");
+    NS_TEST_ASSERT_MSG_EQ(hostRouting->GetRoutesToDst(hostAddresses[3]).size(),
+                          1,
+                          "A server reaches every other server through its leaf");
+
+    Ptr<Ipv4GlobalRouting> leafRouting = getRouting(leaves.Get(0));
+    const Ipv4GlobalRouting::RouteGroup& downRoutes =
+        leafRouting->GetRoutesToDst(hostAddresses[1]);
+    NS_TEST_ASSERT_MSG_EQ(downRoutes.size(), 1, "A leaf has one route to its servers");
+    NS_TEST_ASSERT_MSG_EQ(downRoutes[0]->GetGateway(),
+                          hostAddresses[1],
+                          "A leaf delivers to its servers directly");
+    NS_TEST_ASSERT_MSG_EQ(leafRouting->GetRoutesToDst(hostAddresses[2]).size(),
+                          nSpines * nLinks,
+                          "A leaf spreads traffic to other leaves over every uplink");
+
+    for (uint32_t spine = 0; spine < nSpines; spine++)
+    {
+        Ptr<Ipv4GlobalRouting> spineRouting = getRouting(spines.Get(spine));
+        NS_TEST_ASSERT_MSG_EQ(spineRouting->GetNRoutes(),
+                              nLeaves * nHosts * nLinks,
+                              "A spine has a route to each server over each link");
+        NS_TEST_ASSERT_MSG_EQ(spineRouting->GetRoutesToDst(hostAddresses[3]).size(),
+                              nLinks,
+                              "A spine spreads traffic over the parallel links to a leaf");
+    }
+
+    Simulator::Destroy();
+}
+
+/**
+ * \ingroup internet-test
+ *
+ * \brief Global routes updated incrementally after links go down and up
+ *
+ * Takes links of a leaf-spine topology down and up again, updates the routes
+ * incrementally, several times in a row, and checks that every node ends up
+ * with the same routes as a full recomputation, in any order.  Also checks
+ * how many routers each update recalculates and spares.
+ */
+class Ipv4GlobalRoutingUpdateTestCase : public TestCase
+{
+  public:
+    Ipv4GlobalRoutingUpdateTestCase();
+
+  private:
+    void DoRun() override;
+
+    /**
+     * \brief Describe the routes of every node
+     * \returns the sorted routes of each node, one line per route
+     */
+    std::vector<std::string> GetAllRoutes() const;
+
+    /**
+     * \brief Update the routes and check how many routers recomputed them
+     * \param step the topology change, for the messages
+     * \param nRecalculated the number of routers expected to run their SPF
+     * calculation again, the others only patching their routes
+     */
+    void Update(std::string step, uint32_t nRecalculated);
+
+    /**
+     * \brief Compare the routes with recomputed ones
+     * \param steps the topology changes since the last comparison, for the
+     * messages
+     */
+    void CheckRoutes(std::string steps);
+
+    NodeContainer m_nodes; //!< Nodes used in the test.
+};
+
+Ipv4GlobalRoutingUpdateTestCase::Ipv4GlobalRoutingUpdateTestCase()
+    : TestCase("Global routes updated incrementally match recomputed ones")
+{
+}
+
+std::vector<std::string>
+Ipv4GlobalRoutingUpdateTestCase::GetAllRoutes() const
+{
+    std::vector<std::string> allRoutes;
+    for (uint32_t n = 0; n < m_nodes.GetN(); n++)
+    {
+        Ptr<Ipv4GlobalRouting> routing = m_nodes.Get(n)
+                                             ->GetObject<Ipv4L3Protocol>()
+                                             ->GetRoutingProtocol()
+                                             ->GetObject<Ipv4GlobalRouting>();
+        std::vector<std::string> lines;
+        for (uint32_t i = 0; i < routing->GetNRoutes(); i++)
+        {
+            std::ostringstream route;
+            route << *routing->GetRoute(i);
+            lines.push_back(route.str());
+        }
+        std::sort(lines.begin(), lines.end());
+        std::ostringstream routes;
+        for (const std::string& line : lines)
+        {
+            routes << line << "\n";
+        }
+        allRoutes.push_back(routes.str());
+    }
+    return allRoutes;
+}
+
+void
+Ipv4GlobalRoutingUpdateTestCase::Update(std::string step, uint32_t nRecalculated)
+{
+    Ipv4GlobalRoutingHelper::UpdateRoutingTables();
+    GlobalRouteManagerImpl* manager = SimulationSingleton<GlobalRouteManagerImpl>::Get();
+    NS_TEST_ASSERT_MSG_EQ(manager->GetNRecalculatedRoots(),
+                          nRecalculated,
+                          "Wrong number of routers recalculated after " << step);
+    NS_TEST_ASSERT_MSG_EQ(manager->GetNSparedRoots(),
+                          m_nodes.GetN() - nRecalculated,
+                          "Wrong number of routers spared after " << step);
+}
+
+void
+Ipv4GlobalRoutingUpdateTestCase::CheckRoutes(std::string steps)
+{
+    std::vector<std::string> updatedRoutes = GetAllRoutes();
+    Ipv4GlobalRoutingHelper::RecomputeRoutingTables();
+    std::vector<std::string> recomputedRoutes = GetAllRoutes();
+    for (uint32_t n = 0; n < m_nodes.GetN(); n++)
+    {
+        NS_TEST_ASSERT_MSG_EQ(updatedRoutes[n],
+                              recomputedRoutes[n],
+                              "Node " << n << " has different routes after " << steps);
+    }
+}
+
+void
+Ipv4GlobalRoutingUpdateTestCase::DoRun()
+{
+    // Two spines, three leaves and two hosts per leaf.  Leaf 0 has two
+    // parallel links to spine 0.
+    const uint32_t nSpines = 2;
+    const uint32_t nLeaves = 3;
+    const uint32_t nHosts = 2;
+    m_nodes.Create(nSpines + nLeaves + nLeaves * nHosts);
+
+    InternetStackHelper internet;
+    Ipv4GlobalRoutingHelper ipv4RoutingHelper;
+    internet.SetRoutingHelper(ipv4RoutingHelper);
+    internet.Install(m_nodes);
+
+    SimpleNetDeviceHelper simpleHelper;
+    simpleHelper.SetNetDevicePointToPointMode(true);
+    Ipv4AddressHelper ipv4;
+    ipv4.SetBase("10.0.0.0", "255.255.255.252");
+    for (uint32_t leaf = 0; leaf < nLeaves; leaf++)
+    {
+        Ptr<Node> leafNode = m_nodes.Get(nSpines + leaf);
+        for (uint32_t spine = 0; spine < nSpines; spine++)
+        {
+            for (uint32_t link = 0; link < (leaf == 0 && spine == 0 ? 2 : 1); link++)
+            {
+                Ptr<SimpleChannel> channel = CreateObject<SimpleChannel>();
+                ipv4.Assign(
+                    simpleHelper.Install(NodeContainer(leafNode, m_nodes.Get(spine)), channel));
+                ipv4.NewNetwork();
+            }
+        }
+        for (uint32_t host = 0; host < nHosts; host++)
+        {
+            Ptr<Node> hostNode = m_nodes.Get(nSpines + nLeaves + leaf * nHosts + host);
+            Ptr<SimpleChannel> channel = CreateObject<SimpleChannel>();
+            ipv4.Assign(simpleHelper.Install(NodeContainer(hostNode, leafNode), channel));
+            ipv4.NewNetwork();
+        }
+    }
+
+    Ipv4GlobalRoutingHelper::PopulateRoutingTables();
+
+    // Interface 1 and 2 of leaf 0 are the parallel links to spine 0, interface
+    // 1 of leaf 1 is its link to spine 0.
+    Ptr<Ipv4> leaf0 = m_nodes.Get(nSpines)->GetObject<Ipv4>();
+    Ptr<Ipv4> leaf1 = m_nodes.Get(nSpines + 1)->GetObject<Ipv4>();
+    // Only leaf 0 and spine 0 lose a next hop when a parallel link goes
+    // down.  Every shortest path tree holds the uplinks of leaf 1, but the
+    // hosts are stubs whose default route never changes, so only the five
+    // switches are recalculated when one of those goes down.
+    leaf0->SetDown(2);
+    Update("a parallel link went down", 2);
+    CheckRoutes("a parallel link went down");
+    // Several updates in a row, each from the routes of the previous one.
+    leaf0->SetUp(2);
+    Update("a parallel link went up", 2);
+    leaf1->SetDown(1);
+    Update("an uplink went down", 5);
+    leaf1->SetUp(1);
+    Update("an uplink went up", 5);
+    leaf0->SetDown(2);
+    Update("a parallel link went down again", 2);
+    CheckRoutes("four updates in a row");
+    // Several changes in one update.
+    leaf0->SetUp(2);
+    leaf1->SetDown(1);
+    Update("a parallel link went up and an uplink went down", 5);
+    leaf1->SetUp(1);
+    Update("an uplink went up", 5);
+    // Nothing changed.
+    Update("no change", 0);
+    CheckRoutes("updates with several changes");
+
+    Simulator::Destroy();
+}
+
+/**
+ * \ingroup internet-test
+ *
+ * \brief Routing table entries stored in the Ipv4GlobalRoutePool
+ *
+ * Adds the same routes to two routing tables, checks that each table has
+ * entries of its own, that removing or clearing routes from one table leaves
+ * the other intact, and that the entries of removed routes are reused.
+ */
+class Ipv4GlobalRoutingPooledRoutesTestCase : public TestCase
+{
+  public:
+    Ipv4GlobalRoutingPooledRoutesTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+Ipv4GlobalRoutingPooledRoutesTestCase::Ipv4GlobalRoutingPooledRoutesTestCase()
+    : TestCase("Global routing tables store their entries in a pool")
+{
+}
+
+void
+Ipv4GlobalRoutingPooledRoutesTestCase::DoRun()
+{
+    Ipv4GlobalRoutePool* pool = Ipv4GlobalRoutePool::Get();
+    uint32_t nEntries = pool->GetNEntries();
+
+    const uint32_t nRoutes = 1000;
+    Ptr<Ipv4GlobalRouting> a = CreateObject<Ipv4GlobalRouting>();
+    Ptr<Ipv4GlobalRouting> b = CreateObject<Ipv4GlobalRouting>();
+    Ipv4Address gateway("10.0.0.1");
+    for (uint32_t i = 0; i < nRoutes; i++)
+    {
+        a->AddHostRouteTo(Ipv4Address(0x0b000000 + i), gateway, 1);
+        b->AddHostRouteTo(Ipv4Address(0x0b000000 + i), gateway, 1);
+    }
+    a->AddNetworkRouteTo(Ipv4Address::GetZero(), Ipv4Mask::GetZero(), gateway, 1);
+
+    NS_TEST_ASSERT_MSG_EQ(pool->GetNEntries() - nEntries,
+                          2 * nRoutes + 1,
+                          "Each route has an entry");
+    NS_TEST_ASSERT_MSG_NE(a->GetRoute(7), b->GetRoute(7), "Tables do not share entries");
+    NS_TEST_ASSERT_MSG_EQ(a->GetRoute(nRoutes)->IsDefault(),
+                          true,
+                          "Network routes follow host routes");
+
+    // Remove every other host route from a, last to first.
+    for (uint32_t i = nRoutes; i > 0; i -= 2)
+    {
+        a->RemoveRoute(i - 1);
+    }
+    NS_TEST_ASSERT_MSG_EQ(a->GetNRoutes(), nRoutes / 2 + 1, "Routes were removed");
+    NS_TEST_ASSERT_MSG_EQ(pool->GetNEntries() - nEntries,
+                          nRoutes + nRoutes / 2 + 1,
+                          "Entries of removed routes are released");
+    for (uint32_t i = 0; i < nRoutes; i++)
+    {
+        NS_TEST_ASSERT_MSG_EQ(b->GetRoute(i)->GetDest(),
+                              Ipv4Address(0x0b000000 + i),
+                              "Routes of b are unchanged");
+    }
+
+    // The entry of the last removed route is the first to be reused.
+    Ipv4RoutingTableEntry* released = b->GetRoute(0);
+    b->RemoveRoute(0);
+    a->AddHostRouteTo(Ipv4Address(0x0c000000), gateway, 1);
+    NS_TEST_ASSERT_MSG_EQ(a->GetRoute(nRoutes / 2), released, "Released entries are reused");
+    NS_TEST_ASSERT_MSG_EQ(a->GetRoute(nRoutes / 2)->GetDest(),
+                          Ipv4Address(0x0c000000),
+                          "The reused entry holds the new route");
+    for (uint32_t i = 0; i < nRoutes / 2; i++)
+    {
+        NS_TEST_ASSERT_MSG_EQ(a->GetRoute(i)->GetDest(),
+                              Ipv4Address(0x0b000000 + 2 * i),
+                              "Routes of a are unchanged");
+    }
+
+    // Clearing a leaves the routes of b.
+    a->ClearRoutes();
+    NS_TEST_ASSERT_MSG_EQ(a->GetNRoutes(), 0, "Every route of a is removed");
+    NS_TEST_ASSERT_MSG_EQ(a->GetRoutesToDst(Ipv4Address(0x0b000000)).empty(),
+                          true,
+                          "The next-hop groups of a are discarded");
+    NS_TEST_ASSERT_MSG_EQ(pool->GetNEntries() - nEntries,
+                          nRoutes - 1,
+                          "Entries still used by b are kept");
+    NS_TEST_ASSERT_MSG_EQ(b->GetRoute(0)->GetDest(),
+                          Ipv4Address(0x0b000001),
+                          "Routes of b are unchanged");
+
+    a->Dispose();
+    b->Dispose();
+    NS_TEST_ASSERT_MSG_EQ(pool->GetNEntries(), nEntries, "Every entry is released");
+}
+
+/**
+ * \ingroup internet-test
+ *
+ * \brief Weighted (WCMP) next-hop groups
+ *
+ * Checks that weighted routes are picked in proportion to their weights,
+ * and that FatTreeRoutingHelper weighs the routes of a fabric with uneven
+ * links by their residual capacity.
+ */
+class Ipv4GlobalRoutingWcmpTestCase : public TestCase
+{
+  public:
+    Ipv4GlobalRoutingWcmpTestCase();
+
+  private:
+    void DoRun() override;
+
+    /**
+     * \brief Count the picks of each route of a group over every key of a
+     * full table
+     * \param routing the routing table
+     * \param dst the destination
+     * \returns the number of picks of each route of the group
+     */
+    std::vector<uint32_t> CountPicks(Ptr<Ipv4GlobalRouting> routing, Ipv4Address dst) const;
+};
+
+Ipv4GlobalRoutingWcmpTestCase::Ipv4GlobalRoutingWcmpTestCase()
+    : TestCase("Global routing weighted next-hop groups follow link capacity")
+{
+}
+
+std::vector<uint32_t>
+Ipv4GlobalRoutingWcmpTestCase::CountPicks(Ptr<Ipv4GlobalRouting> routing, Ipv4Address dst) const
+{
+    const Ipv4GlobalRouting::RouteGroup& routes = routing->GetRoutesToDst(dst);
+    std::vector<uint32_t> picks(routes.size(), 0);
+    for (uint32_t key = 0; key < 64; key++)
+    {
+        picks[routing->PickWeightedRoute(dst, routes, key)]++;
+    }
+    return picks;
+}
+
+void
+Ipv4GlobalRoutingWcmpTestCase::DoRun()
+{
+    Ptr<Ipv4GlobalRouting> globalRouting = CreateObject<Ipv4GlobalRouting>();
+    globalRouting->SetAttribute("WcmpTableSize", UintegerValue(64));
+    Ipv4Address network("10.1.0.0");
+    Ipv4Mask mask("255.255.0.0");
+    globalRouting->AddNetworkRouteTo(network, mask, Ipv4Address("10.0.0.1"), 1);
+    globalRouting->AddNetworkRouteTo(network, mask, Ipv4Address("10.0.0.5"), 2);
+    NS_TEST_ASSERT_MSG_EQ(globalRouting->HasWeightedRoutes(), false, "No route has a weight");
+    NS_TEST_ASSERT_MSG_EQ(CountPicks(globalRouting, Ipv4Address("10.1.2.3"))[0],
+                          32,
+                          "Unweighted routes are picked equally");
+
+    globalRouting->AddNetworkRouteTo(network, mask, Ipv4Address("10.0.0.9"), 3, 2);
+    NS_TEST_ASSERT_MSG_EQ(globalRouting->GetRouteWeight(2), 2, "Weight not kept");
+    std::vector<uint32_t> picks = CountPicks(globalRouting, Ipv4Address("10.1.2.3"));
+    NS_TEST_ASSERT_MSG_EQ(picks[0], 16, "Route of weight 1 is picked a quarter of the time");
+    NS_TEST_ASSERT_MSG_EQ(picks[1], 16, "Route of weight 1 is picked a quarter of the time");
+    NS_TEST_ASSERT_MSG_EQ(picks[2], 32, "Route of weight 2 is picked half of the time");
+
+    // A route of tiny weight still gets a slot.
+    globalRouting->AddNetworkRouteTo(network, mask, Ipv4Address("10.0.0.13"), 4, 1000);
+    picks = CountPicks(globalRouting, Ipv4Address("10.1.2.3"));
+    NS_TEST_ASSERT_MSG_EQ(picks[0], 1, "Every route keeps a slot");
+    NS_TEST_ASSERT_MSG_EQ(picks[3], 61, "Heavy route takes the remaining slots");
+
+    globalRouting->RemoveRoute(3);
+    globalRouting->RemoveRoute(2);
+    NS_TEST_ASSERT_MSG_EQ(globalRouting->HasWeightedRoutes(),
+                          false,
+                          "Weights are dropped with their routes");
+
+    // Duplicate routes keep their own entries and weights.
+    Ipv4Address gateway("10.0.0.9");
+    globalRouting->AddNetworkRouteTo(network, mask, gateway, 3, 2);
+    globalRouting->AddNetworkRouteTo(network, mask, gateway, 3);
+    NS_TEST_ASSERT_MSG_NE(globalRouting->GetRoute(3),
+                          globalRouting->GetRoute(2),
+                          "Duplicate routes have their own entries");
+    NS_TEST_ASSERT_MSG_EQ(globalRouting->GetRouteWeight(2), 2, "Weight overwritten by a duplicate");
+    NS_TEST_ASSERT_MSG_EQ(globalRouting->GetRouteWeight(3), 1, "Duplicate took the weight");
+    globalRouting->RemoveRoute(3);
+    NS_TEST_ASSERT_MSG_EQ(globalRouting->GetRouteWeight(2),
+                          2,
+                          "Weight dropped with a duplicate route");
+    picks = CountPicks(globalRouting, Ipv4Address("10.1.2.3"));
+    NS_TEST_ASSERT_MSG_EQ(picks[2], 32, "Route of weight 2 is picked half of the time");
+    globalRouting->AddNetworkRouteTo(network, mask, gateway, 3, 2);
+    globalRouting->RemoveNetworkRouteTo(network, mask, gateway, 3);
+    NS_TEST_ASSERT_MSG_EQ(globalRouting->GetRouteWeight(2),
+                          2,
+                          "Weight dropped with a duplicate route");
+    NS_TEST_ASSERT_MSG_EQ(globalRouting->HasWeightedRoutes(), true, "Weight dropped");
+    globalRouting->RemoveRoute(2);
+    NS_TEST_ASSERT_MSG_EQ(globalRouting->HasWeightedRoutes(),
+                          false,
+                          "Weights are dropped with their routes");
+    globalRouting->Dispose();
+
+    // Two spines and two leaves with a host each.  The link from leaf 0 to
+    // spine 0 is twice as fast as the others.
+    NodeContainer spines;
+    spines.Create(2);
+    NodeContainer leaves;
+    leaves.Create(2);
+    NodeContainer hosts;
+    hosts.Create(2);
+    InternetStackHelper internet;
+    Ipv4GlobalRoutingHelper ipv4RoutingHelper;
+    internet.SetRoutingHelper(ipv4RoutingHelper);
+    internet.Install(spines);
+    internet.Install(leaves);
+    internet.Install(hosts);
+
+    SimpleNetDeviceHelper simpleHelper;
+    simpleHelper.SetNetDevicePointToPointMode(true);
+    Ipv4AddressHelper ipv4;
+    ipv4.SetBase("10.0.0.0", "255.255.255.252");
+    std::vector<Ipv4Address> hostAddresses;
+    for (uint32_t leaf = 0; leaf < 2; leaf++)
+    {
+        simpleHelper.SetDeviceAttribute("DataRate", DataRateValue(DataRate("10Gbps")));
+        Ipv4InterfaceContainer interfaces = ipv4.Assign(
+            simpleHelper.Install(NodeContainer(hosts.Get(leaf), leaves.Get(leaf)),
+                                 CreateObject<SimpleChannel>()));
+        hostAddresses.push_back(interfaces.GetAddress(0));
+        ipv4.NewNetwork();
+        for (uint32_t spine = 0; spine < 2; spine++)
+        {
+            simpleHelper.SetDeviceAttribute(
+                "DataRate",
+                DataRateValue(DataRate(leaf == 0 && spine == 0 ? "20Gbps" : "10Gbps")));
+            ipv4.Assign(simpleHelper.Install(NodeContainer(leaves.Get(leaf), spines.Get(spine)),
+                                             CreateObject<SimpleChannel>()));
+            ipv4.NewNetwork();
+        }
+    }
+
+    FatTreeRoutingHelper fatTreeRouting(spines, leaves);
+    fatTreeRouting.PopulateRoutingTables();
+
+    // Leaf 0 sends twice as much up the faster uplink by default, but spine 0
+    // only has 10Gbps down to leaf 1, so the paths to host 1 are even.
+    Ptr<Ipv4GlobalRouting> leafRouting = leaves.Get(0)
+                                             ->GetObject<Ipv4L3Protocol>()
+                                             ->GetRoutingProtocol()
+                                             ->GetObject<Ipv4GlobalRouting>();
+    picks = CountPicks(leafRouting, Ipv4Address("10.9.9.9"));
+    NS_TEST_ASSERT_MSG_EQ(picks.size(), 2, "A default route over each uplink");
+    NS_TEST_ASSERT_MSG_EQ(picks[0], 42, "Faster uplink takes two thirds of the table");
+    NS_TEST_ASSERT_MSG_EQ(picks[1], 22, "Slower uplink takes a third of the table");
+    picks = CountPicks(leafRouting, hostAddresses[1]);
+    NS_TEST_ASSERT_MSG_EQ(picks.size(), 2, "A host route over each uplink");
+    NS_TEST_ASSERT_MSG_EQ(picks[0], picks[1], "Paths to leaf 1 are bounded by the spines");
+
+    // Leaf 1 sees the same capacity through both spines.
+    Ptr<Ipv4GlobalRouting> otherLeafRouting = leaves.Get(1)
+                                                  ->GetObject<Ipv4L3Protocol>()
+                                                  ->GetRoutingProtocol()
+                                                  ->GetObject<Ipv4GlobalRouting>();
+    NS_TEST_ASSERT_MSG_EQ(otherLeafRouting->HasWeightedRoutes(),
+                          false,
+                          "Even paths keep weight 1");
+    NS_TEST_ASSERT_MSG_EQ(otherLeafRouting->GetRoutesToDst(hostAddresses[0]).size(),
+                          2,
+                          "Leaf 1 reaches leaf 0 over both spines");
+
+    Simulator::Destroy();
+}
+
+/**
+ * \ingroup internet-test
+ *
+ * \brief FatTreeRoutingHelper reweighs its routes after a link failure
+ *
+ * Takes down one of two parallel links between a leaf and a spine and
+ * checks that FatTreeRoutingHelper::Recompute moves its share of the
+ * traffic to the remaining links, and that the interface event of bringing
+ * it back up restores the weights when RespondToInterfaceEvents is set.
+ */
+class Ipv4FatTreeRoutingRecomputeTestCase : public TestCase
+{
+  public:
+    Ipv4FatTreeRoutingRecomputeTestCase();
+
+  private:
+    void DoRun() override;
+
+    /**
+     * \brief Get the weights of the routes to a destination
+     * \param routing the routing table
+     * \param dst the destination
+     * \returns the weight of each route of the group, in table order
+     */
+    std::vector<uint32_t> GetWeights(Ptr<Ipv4GlobalRouting> routing, Ipv4Address dst) const;
+};
+
+Ipv4FatTreeRoutingRecomputeTestCase::Ipv4FatTreeRoutingRecomputeTestCase()
+    : TestCase("FatTreeRoutingHelper reweighs its routes after a link failure")
+{
+}
+
+std::vector<uint32_t>
+Ipv4FatTreeRoutingRecomputeTestCase::GetWeights(Ptr<Ipv4GlobalRouting> routing,
+                                                Ipv4Address dst) const
+{
+    const Ipv4GlobalRouting::RouteGroup& routes = routing->GetRoutesToDst(dst);
+    std::vector<uint32_t> weights;
+    for (uint32_t i = 0; i < routing->GetNRoutes(); i++)
+    {
+        if (std::find(routes.begin(), routes.end(), routing->GetRoute(i)) != routes.end())
+        {
+            weights.push_back(routing->GetRouteWeight(i));
+        }
+    }
+    return weights;
+}
+
+void
+Ipv4FatTreeRoutingRecomputeTestCase::DoRun()
+{
+    // Two spines and two leaves with a host each.  Leaf 0 has two parallel
+    // links to spine 0, on its interfaces 2 and 3, and every link has the
+    // same rate.
+    NodeContainer spines;
+    spines.Create(2);
+    NodeContainer leaves;
+    leaves.Create(2);
+    NodeContainer hosts;
+    hosts.Create(2);
+    InternetStackHelper internet;
+    Ipv4GlobalRoutingHelper ipv4RoutingHelper;
+    internet.SetRoutingHelper(ipv4RoutingHelper);
+    internet.Install(spines);
+    internet.Install(leaves);
+    internet.Install(hosts);
+
+    SimpleNetDeviceHelper simpleHelper;
+    simpleHelper.SetNetDevicePointToPointMode(true);
+    simpleHelper.SetDeviceAttribute("DataRate", DataRateValue(DataRate("10Gbps")));
+    Ipv4AddressHelper ipv4;
+    ipv4.SetBase("10.0.0.0", "255.255.255.252");
+    std::vector<Ipv4Address> hostAddresses;
+    for (uint32_t leaf = 0; leaf < 2; leaf++)
+    {
+        Ipv4InterfaceContainer interfaces = ipv4.Assign(
+            simpleHelper.Install(NodeContainer(hosts.Get(leaf), leaves.Get(leaf)),
+                                 CreateObject<SimpleChannel>()));
+        hostAddresses.push_back(interfaces.GetAddress(0));
+        ipv4.NewNetwork();
+        for (uint32_t spine = 0; spine < 2; spine++)
+        {
+            for (uint32_t link = 0; link < (leaf == 0 && spine == 0 ? 2 : 1); link++)
+            {
+                ipv4.Assign(simpleHelper.Install(NodeContainer(leaves.Get(leaf), spines.Get(spine)),
+                                                 CreateObject<SimpleChannel>()));
+                ipv4.NewNetwork();
+            }
+        }
+    }
+
+    FatTreeRoutingHelper fatTreeRouting(spines, leaves);
+    fatTreeRouting.PopulateRoutingTables();
+
+    // Spine 0 only has 10Gbps down to leaf 1, so each parallel link gets half
+    // the weight of the uplink to spine 1 on the paths to host 1.
+    Ptr<Ipv4GlobalRouting> leafRouting = leaves.Get(0)
+                                             ->GetObject<Ipv4L3Protocol>()
+                                             ->GetRoutingProtocol()
+                                             ->GetObject<Ipv4GlobalRouting>();
+    std::vector<uint32_t> weights = GetWeights(leafRouting, hostAddresses[1]);
+    NS_TEST_ASSERT_MSG_EQ(weights.size(), 3, "A host route over each uplink");
+    NS_TEST_ASSERT_MSG_EQ(weights[0], 1, "Parallel links share the capacity of spine 0");
+    NS_TEST_ASSERT_MSG_EQ(weights[1], 1, "Parallel links share the capacity of spine 0");
+    NS_TEST_ASSERT_MSG_EQ(weights[2], 2, "Spine 1 has as much capacity as spine 0");
+
+    // With one parallel link down, both spines have a single link from leaf
+    // 0, so the paths to host 1 are even again and take the default routes.
+    Ptr<Ipv4> leaf0 = leaves.Get(0)->GetObject<Ipv4>();
+    leaf0->SetDown(2);
+    fatTreeRouting.Recompute();
+    weights = GetWeights(leafRouting, hostAddresses[1]);
+    NS_TEST_ASSERT_MSG_EQ(weights.size(), 2, "No route over the failed link");
+    NS_TEST_ASSERT_MSG_EQ(weights[0], 1, "Remaining uplinks are even");
+    NS_TEST_ASSERT_MSG_EQ(weights[1], 1, "Remaining uplinks are even");
+    NS_TEST_ASSERT_MSG_EQ(leafRouting->HasWeightedRoutes(), false, "Weights were not rebalanced");
+    Ptr<Ipv4GlobalRouting> spineRouting = spines.Get(0)
+                                              ->GetObject<Ipv4L3Protocol>()
+                                              ->GetRoutingProtocol()
+                                              ->GetObject<Ipv4GlobalRouting>();
+    NS_TEST_ASSERT_MSG_EQ(spineRouting->GetRoutesToDst(hostAddresses[0]).size(),
+                          1,
+                          "Spine 0 still routes over the failed link");
+
+    // Bringing the link back up is an interface event, which recomputes the
+    // routes of the fabric rather than the SPF routes.
+    leafRouting->SetAttribute("RespondToInterfaceEvents", BooleanValue(true));
+    Simulator::Schedule(Seconds(1), &Ipv4::SetUp, leaf0, 2);
+    Simulator::Run();
+    weights = GetWeights(leafRouting, hostAddresses[1]);
+    NS_TEST_ASSERT_MSG_EQ(weights.size(), 3, "Link not restored by the interface event");
+    NS_TEST_ASSERT_MSG_EQ(weights[2], 2, "Weights not restored by the interface event");
+    NS_TEST_ASSERT_MSG_EQ(spineRouting->GetRoutesToDst(hostAddresses[0]).size(),
+                          2,
+                          "Spine 0 does not route over the restored link");
+
+    Simulator::Destroy();
+}
+
 /**
  * \ingroup internet-test
  *
@@ -1335,6 +2220,13 @@ Ipv4GlobalRoutingTestSuite::Ipv4GlobalRoutingTestSuite()
     AddTestCase(new TwoBridgeTest, TestCase::QUICK);
     AddTestCase(new Ipv4DynamicGlobalRoutingTestCase, TestCase::QUICK);
     AddTestCase(new Ipv4GlobalRoutingSlash32TestCase, TestCase::QUICK);
+    AddTestCase(new Ipv4GlobalRoutingRouteGroupTestCase, TestCase::QUICK);
+    AddTestCase(new Ipv4GlobalRoutingParallelSpfTestCase, TestCase::QUICK);
+    AddTestCase(new Ipv4FatTreeRoutingTestCase, TestCase::QUICK);
+    AddTestCase(new Ipv4GlobalRoutingUpdateTestCase, TestCase::QUICK);
+    AddTestCase(new Ipv4GlobalRoutingPooledRoutesTestCase, TestCase::QUICK);
+    AddTestCase(new Ipv4GlobalRoutingWcmpTestCase, TestCase::QUICK);
+    AddTestCase(new Ipv4FatTreeRoutingRecomputeTestCase, TestCase::QUICK);
 }
 
 static Ipv4GlobalRoutingTestSuite
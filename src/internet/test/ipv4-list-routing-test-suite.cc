@@ -16,10 +16,20 @@
  *
  */
 
+#include "ns3/flow-key-tag.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-drb-helper.h"
+#include "ns3/ipv4-drb-tag.h"
+#include "ns3/ipv4-drb.h"
 #include "ns3/ipv4-list-routing.h"
 #include "ns3/ipv4-routing-protocol.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/simulator.h"
 #include "ns3/test.h"
 
+#include <vector>
+
 using namespace ns3;
 
 /**
@@ -126,6 +136,64 @@ class Ipv4BRouting : public Ipv4RoutingProtocol
     }
 };
 
+/**
+ * \ingroup internet-test
+ *
+ * \brief IPv4 routing class recording the packets it is asked to forward
+ */
+class Ipv4RecordRouting : public Ipv4RoutingProtocol
+{
+  public:
+    Ptr<Ipv4Route> RouteOutput(Ptr<Packet> p,
+                               const Ipv4Header& header,
+                               Ptr<NetDevice> oif,
+                               Socket::SocketErrno& sockerr) override
+    {
+        return nullptr;
+    }
+
+    bool RouteInput(Ptr<const Packet> p,
+                    const Ipv4Header& header,
+                    Ptr<const NetDevice> idev,
+                    UnicastForwardCallback ucb,
+                    MulticastForwardCallback mcb,
+                    LocalDeliverCallback lcb,
+                    ErrorCallback ecb) override
+    {
+        m_destinations.push_back(header.GetDestination());
+        Ipv4DrbTag drbTag;
+        m_drbTagged.push_back(p->PeekPacketTag(drbTag));
+        return true;
+    }
+
+    void NotifyInterfaceUp(uint32_t interface) override
+    {
+    }
+
+    void NotifyInterfaceDown(uint32_t interface) override
+    {
+    }
+
+    void NotifyAddAddress(uint32_t interface, Ipv4InterfaceAddress address) override
+    {
+    }
+
+    void NotifyRemoveAddress(uint32_t interface, Ipv4InterfaceAddress address) override
+    {
+    }
+
+    void SetIpv4(Ptr<Ipv4> ipv4) override
+    {
+    }
+
+    void PrintRoutingTable(Ptr<OutputStreamWrapper> stream, Time::Unit unit) const override
+    {
+    }
+
+    std::vector<Ipv4Address> m_destinations; //!< Destination of each forwarded packet
+    std::vector<bool> m_drbTagged;            //!< Whether each packet carried a DRB tag
+};
+
 /**
  * \ingroup internet-test
  *
@@ -199,6 +267,122 @@ Ipv4ListRoutingPositiveTestCase::DoRun()
     NS_TEST_ASSERT_MSG_EQ(secondRp, bRouting, "204");
 }
 
+/**
+ * \ingroup internet-test
+ *
+ * \brief IPv4 ListRouting DRB detour test.
+ *
+ * A node n1 between n0 (10.1.1.1) and the core switch 10.1.2.2 receives
+ * packets from n0. With DRB, a new packet is tagged and handed to the
+ * routing protocols towards the core switch, and a tagged packet addressed
+ * to n1 itself bounces back to its original destination. Without DRB the
+ * routing protocols get the packet and header unchanged.
+ */
+class Ipv4ListRoutingDrbTestCase : public TestCase
+{
+  public:
+    Ipv4ListRoutingDrbTestCase();
+    void DoRun() override;
+
+  private:
+    /**
+     * \brief Forwards packets from n0 through the list routing of n1.
+     * \param drb whether n1 runs DRB
+     * \return the packets the routing protocols of n1 were asked to forward
+     */
+    Ptr<Ipv4RecordRouting> Forward(bool drb);
+};
+
+Ipv4ListRoutingDrbTestCase::Ipv4ListRoutingDrbTestCase()
+    : TestCase("Check the DRB detour to the core switches")
+{
+}
+
+Ptr<Ipv4RecordRouting>
+Ipv4ListRoutingDrbTestCase::Forward(bool drb)
+{
+    NodeContainer nodes;
+    nodes.Create(3);
+    InternetStackHelper internet;
+    if (drb)
+    {
+        internet.SetDrb();
+    }
+    internet.Install(nodes);
+
+    SimpleNetDeviceHelper simpleHelper;
+    simpleHelper.SetNetDevicePointToPointMode(true);
+    Ipv4AddressHelper ipv4;
+    ipv4.SetBase("10.1.1.0", "255.255.255.0");
+    NetDeviceContainer inLink = simpleHelper.Install(NodeContainer(nodes.Get(0), nodes.Get(1)));
+    Ipv4InterfaceContainer inInterfaces = ipv4.Assign(inLink);
+    ipv4.SetBase("10.1.2.0", "255.255.255.0");
+    ipv4.Assign(simpleHelper.Install(NodeContainer(nodes.Get(1), nodes.Get(2))));
+
+    Ptr<Ipv4> ipv4n1 = nodes.Get(1)->GetObject<Ipv4>();
+    Ptr<Ipv4ListRouting> listRouting = DynamicCast<Ipv4ListRouting>(ipv4n1->GetRoutingProtocol());
+    Ptr<Ipv4RecordRouting> record = CreateObject<Ipv4RecordRouting>();
+    listRouting->AddRoutingProtocol(record, 100);
+    if (drb)
+    {
+        Ipv4DrbHelper drbHelper;
+        drbHelper.GetIpv4Drb(ipv4n1)->AddCoreSwitchAddress(Ipv4Address("10.1.2.2"));
+    }
+
+    Ipv4Header header;
+    header.SetSource(Ipv4Address("10.1.1.1"));
+    header.SetDestination(Ipv4Address("10.9.0.1"));
+    Ptr<Packet> packet = Create<Packet>(100);
+    packet->AddPacketTag(FlowKeyTag(42));
+    listRouting->RouteInput(packet,
+                            header,
+                            inLink.Get(1),
+                            Ipv4RoutingProtocol::UnicastForwardCallback(),
+                            Ipv4RoutingProtocol::MulticastForwardCallback(),
+                            Ipv4RoutingProtocol::LocalDeliverCallback(),
+                            Ipv4RoutingProtocol::ErrorCallback());
+
+    if (drb)
+    {
+        // A packet DRB sent to n1 as the core switch of its flow.
+        header.SetDestination(inInterfaces.GetAddress(1));
+        Ipv4DrbTag drbTag;
+        drbTag.SetOriginalDstAddr(Ipv4Address("10.9.0.1"));
+        packet->AddPacketTag(drbTag);
+        listRouting->RouteInput(packet,
+                                header,
+                                inLink.Get(1),
+                                Ipv4RoutingProtocol::UnicastForwardCallback(),
+                                Ipv4RoutingProtocol::MulticastForwardCallback(),
+                                Ipv4RoutingProtocol::LocalDeliverCallback(),
+                                Ipv4RoutingProtocol::ErrorCallback());
+    }
+
+    Simulator::Destroy();
+    return record;
+}
+
+void
+Ipv4ListRoutingDrbTestCase::DoRun()
+{
+    Ptr<Ipv4RecordRouting> drb = Forward(true);
+    NS_TEST_ASSERT_MSG_EQ(drb->m_destinations.size(), 2, "Both packets are forwarded");
+    NS_TEST_ASSERT_MSG_EQ(drb->m_destinations[0],
+                          Ipv4Address("10.1.2.2"),
+                          "A new packet goes to the core switch");
+    NS_TEST_ASSERT_MSG_EQ(drb->m_drbTagged[0], true, "A new packet is DRB tagged");
+    NS_TEST_ASSERT_MSG_EQ(drb->m_destinations[1],
+                          Ipv4Address("10.9.0.1"),
+                          "A packet at its core switch bounces to its original destination");
+
+    Ptr<Ipv4RecordRouting> plain = Forward(false);
+    NS_TEST_ASSERT_MSG_EQ(plain->m_destinations.size(), 1, "The packet is forwarded");
+    NS_TEST_ASSERT_MSG_EQ(plain->m_destinations[0],
+                          Ipv4Address("10.9.0.1"),
+                          "Without DRB the destination is unchanged");
+    NS_TEST_ASSERT_MSG_EQ(plain->m_drbTagged[0], false, "Without DRB packets are not tagged");
+}
+
 /**
  * \ingroup internet-test
  *
@@ -212,6 +396,7 @@ class Ipv4ListRoutingTestSuite : public TestSuite
     {
         AddTestCase(new Ipv4ListRoutingPositiveTestCase(), TestCase::QUICK);
         AddTestCase(new Ipv4ListRoutingNegativeTestCase(), TestCase::QUICK);
+        AddTestCase(new Ipv4ListRoutingDrbTestCase(), TestCase::QUICK);
     }
 };
 
@@ -45,6 +45,10 @@ void Ipv4LetFlowRoutingHelper::RecomputeRoutingTables() {
 	GlobalRouteManager::InitializeRoutes();
 }
 
+void Ipv4LetFlowRoutingHelper::UpdateRoutingTables() {
+	GlobalRouteManager::UpdateRoutes();
+}
+
 Ptr<Ipv4LetFlowRouting>
 Ipv4LetFlowRoutingHelper::GetLetFlowRouting(Ptr<Ipv4> ipv4) const {
 	Ptr<Ipv4RoutingProtocol> ipv4rp = ipv4->GetRoutingProtocol();
@@ -1,8 +1,9 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 #include "ipv4-letflow-routing.h"
 
+#include "ns3/boolean.h"
 #include "ns3/channel.h"
-#include "ns3/flow-id-tag.h"
+#include "ns3/flow-key-tag.h"
 #include "ns3/ipv4-route.h"
 #include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/log.h"
@@ -13,8 +14,10 @@
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
 #include "ns3/nstime.h"
+#include "ns3/uinteger.h"
 
 #include <algorithm>
+#include <limits>
 
 namespace ns3 {
 
@@ -31,7 +34,22 @@ TypeId Ipv4LetFlowRouting::GetTypeId(void) {
 	    	              "flowlet",
 	    	              TimeValue(MicroSeconds(50)),
 	    	              MakeTimeAccessor(&Ipv4LetFlowRouting::m_flowletTimeout),
-	    	              MakeTimeChecker());
+	    	              MakeTimeChecker())
+	      .AddAttribute("FlowletTableSize",
+	    	              "The number of entries in the flowlet table, rounded "
+	    	              "up to a power of 2",
+	    	              UintegerValue(65536),
+	    	              MakeUintegerAccessor(
+	    	              	  &Ipv4LetFlowRouting::m_flowletTableSize),
+	    	              MakeUintegerChecker<uint32_t>(1, 1u << 31))
+	      .AddAttribute("KeylessFlowletTable",
+	    	              "Set to true to share flowlet table entries between "
+	    	              "all flows hashing to them instead of storing the "
+	    	              "flow ID",
+	    	              BooleanValue(false),
+	    	              MakeBooleanAccessor(
+	    	              	  &Ipv4LetFlowRouting::m_keylessFlowletTable),
+	    	              MakeBooleanChecker());
 	  return tid;
 }
 
@@ -39,6 +57,8 @@ TypeId Ipv4LetFlowRouting::GetTypeId(void) {
 Ipv4LetFlowRouting::Ipv4LetFlowRouting(Ptr<Ipv4GlobalRouting> globalRouting)
     : m_flowletTimeout(MicroSeconds(50)),
       m_ipv4(nullptr),
+      m_flowletTableSize(65536),
+      m_keylessFlowletTable(false),
       m_globalRouting(globalRouting) 
 {
     NS_LOG_FUNCTION(this);
@@ -106,53 +126,49 @@ bool Ipv4LetFlowRouting::RouteInput(Ptr<const Packet> p,
 
 	  // Packet arrival time.
 	  Time now = Simulator::Now();
-	  std::vector<Ipv4RoutingTableEntry*> routeEntries =
+	  const Ipv4GlobalRouting::RouteGroup& routeEntries =
 	      LookupLetFlowRoutes(header.GetDestination());
 	  // Select a port for the packet.
     uint32_t selectedPort = 0;
 
-	  // Extract the flow ID.
-	  uint32_t flowId = 0;
-	  FlowIdTag flowIdTag;
-	  // Flow ID for the packet.
-	  bool flowIdFound = p->PeekPacketTag(flowIdTag);
-	  if (!flowIdFound) {
-		    NS_LOG_LOGIC(this << " LetFlow routing cannot extract the flow ID, "
+	  // Extract the flow key.
+	  uint64_t flowKey = FlowKeyTag::ExtractFlowKey(p);
+	  if (flowKey == 0) {
+		    if (routeEntries.empty()) {
+	          NS_LOG_ERROR(this << " LetFlow routing cannot find routing entry");
+	          ecb(p, header, Socket::ERROR_NOROUTETOHOST);
+	          return false;
+		    }
+		    NS_LOG_LOGIC(this << " LetFlow routing cannot extract the flow key, "
 		  	    << "picking path at random");
 		    Ptr<Ipv4Route> route = ChooseRandomRoute(
 		  	    routeEntries, selectedPort, header.GetDestination());
+		    ucb(route, p, header);
+		    return true;
 	  }
-	  // If the flow ID was found, extract it.
-	  flowId = flowIdTag.GetFlowId();
 
     // We first examine the flowlet table to see if it is part of an active
-    // flowlet.
-	  auto flowletItr = m_flowletTable.find(flowId);
-	  // If the flowlet table entry is valid, return the route.
-	  if (flowletItr != m_flowletTable.end()) {
-	      // Get the flowlet from the iterator.
-	      LetFlowFlowlet flowlet = flowletItr->second;
-	      // If the interpacket gap is less than the flowlet timeout.
-	      if (now - flowlet.activeTime <= m_flowletTimeout) {
-	    	    NS_LOG_LOGIC(this << " Found active flowlet for " << flowId);
-	    	    // Update the flowlet last active time and get the route.
-	    	    flowlet.activeTime = now;
-            selectedPort = flowlet.port;
-
-	    	    // Update the flowlet table.
-	    	    m_flowletTable[flowId] = flowlet;
-
-            // Construct the route and then call the unicast callback.
-            Ptr<Ipv4Route> route = ConstructIpv4Route(
-          	    selectedPort, header.GetDestination());
-	    	    ucb(route, p, header);
-
-	    	    return true;
-	      } else {
-	    	    NS_LOG_LOGIC("Flowlet for " << flowId << " timed out. Packet gap: "
-	    		      << now - flowlet.activeTime << " timeout period: "
-	    		      << m_flowletTimeout);
-	      }
+    // flowlet. The lookup claims an entry for the flow if it is not.
+	  if (!m_flowletTable.IsConfigured()) {
+	      // The table is large, so it is only allocated on nodes that
+	      // actually forward flows, and hosts never pay for it.
+	      m_flowletTable.Configure(m_flowletTableSize, m_keylessFlowletTable);
+	  }
+	  bool found = false;
+	  LetFlowFlowlet& flowlet = m_flowletTable.Lookup(
+	      flowKey, now, m_flowletTimeout, found);
+	  if (found && now - flowlet.activeTime <= m_flowletTimeout) {
+	      NS_LOG_LOGIC(this << " Found active flowlet for " << flowKey);
+	      // Update the flowlet last active time and get the route.
+	      flowlet.activeTime = now;
+        selectedPort = flowlet.port;
+
+        // Construct the route and then call the unicast callback.
+        Ptr<Ipv4Route> route = ConstructIpv4Route(
+            selectedPort, header.GetDestination());
+	      ucb(route, p, header);
+
+	      return true;
 	  }
 
 	  // Otherwise, the flowlet either timed out or we don't have a flowlet
@@ -169,15 +185,12 @@ bool Ipv4LetFlowRouting::RouteInput(Ptr<const Packet> p,
 	  // should forward the packet.
 	  Ptr<Ipv4Route> route = ChooseRandomRoute(
 		    routeEntries, selectedPort, header.GetDestination());
-	  NS_LOG_LOGIC(this << " Creating new flowlet for " << flowId
+	  NS_LOG_LOGIC(this << " Creating new flowlet for " << flowKey
 		    << " selected rport: " << selectedPort);
 
-	  // Construct the flowlet and route.
-	  LetFlowFlowlet flowlet;
+	  // Record the new flowlet in the entry claimed by the lookup.
 	  flowlet.port = selectedPort;
 	  flowlet.activeTime = now;
-	  // Update the flowlet table.
-	  m_flowletTable[flowId] = flowlet;
 
 	  ucb(route, p, header);
 	  return true;
@@ -185,29 +198,41 @@ bool Ipv4LetFlowRouting::RouteInput(Ptr<const Packet> p,
 
 Ptr<Ipv4Route>
 Ipv4LetFlowRouting::ChooseRandomRoute(
-	  std::vector<Ipv4RoutingTableEntry*>& routeEntries,
+	  const Ipv4GlobalRouting::RouteGroup& routeEntries,
 	  uint32_t& selectedPort, Ipv4Address dstAddr) {
 	  NS_LOG_FUNCTION(this << dstAddr);
-	  uint32_t selectedIdx = m_rand->GetInteger(0, routeEntries.size() - 1);
+	  uint32_t selectedIdx;
+	  if (m_globalRouting->HasWeightedRoutes()) {
+	      // New flowlets are spread in proportion to the WCMP weights.
+	      selectedIdx = m_globalRouting->PickWeightedRoute(
+	          dstAddr, routeEntries,
+	          m_rand->GetInteger(0, std::numeric_limits<uint32_t>::max() - 1));
+	  } else {
+	      selectedIdx = m_rand->GetInteger(0, routeEntries.size() - 1);
+	  }
 	  selectedPort = routeEntries.at(selectedIdx)->GetInterface();
 	  return ConstructIpv4Route(selectedPort, dstAddr);
 }
 
 void Ipv4LetFlowRouting::NotifyInterfaceUp(uint32_t interface) {
+	  m_routeCache.clear();
 	  m_globalRouting->NotifyInterfaceUp(interface);
 }
 
 void Ipv4LetFlowRouting::NotifyInterfaceDown(uint32_t interface) {
+	  m_routeCache.clear();
 	  m_globalRouting->NotifyInterfaceDown(interface);
 }
 
 void Ipv4LetFlowRouting::NotifyAddAddress(
 	  uint32_t interface, Ipv4InterfaceAddress address) {
+	  m_routeCache.clear();
 	  m_globalRouting->NotifyAddAddress(interface, address);
 }
 
 void Ipv4LetFlowRouting::NotifyRemoveAddress(
 	  uint32_t interface, Ipv4InterfaceAddress address) {
+	  m_routeCache.clear();
 	  m_globalRouting->NotifyRemoveAddress(interface, address);
 }
 
@@ -226,6 +251,7 @@ void Ipv4LetFlowRouting::PrintRoutingTable(Ptr<OutputStreamWrapper> stream,
 
 void Ipv4LetFlowRouting::DoDispose(void) {
 	  NS_LOG_FUNCTION(this);
+	  m_routeCache.clear();
 	  m_ipv4 = nullptr;
 	  m_globalRouting->DoDispose();
 	  m_globalRouting = nullptr;
@@ -241,7 +267,7 @@ Ipv4RoutingTableEntry* Ipv4LetFlowRouting::GetRoute(uint32_t i) const {
 	  return m_globalRouting->GetRoute(i);
 }
 
-std::vector<Ipv4RoutingTableEntry*>
+const Ipv4GlobalRouting::RouteGroup&
 Ipv4LetFlowRouting::LookupLetFlowRoutes(Ipv4Address dst, Ptr<NetDevice> oif) {
 	  NS_LOG_FUNCTION(this  << dst  << oif);
 	  return m_globalRouting->GetRoutesToDst(dst, oif);
@@ -249,6 +275,14 @@ Ipv4LetFlowRouting::LookupLetFlowRoutes(Ipv4Address dst, Ptr<NetDevice> oif) {
 
 Ptr<Ipv4Route>
 Ipv4LetFlowRouting::ConstructIpv4Route(uint32_t port, Ipv4Address dstAddr) {
+	  // Reuse the route if one was already built from this port to the
+	  // destination.
+	  uint64_t cacheKey = (static_cast<uint64_t>(port) << 32) | dstAddr.Get();
+	  auto cacheItr = m_routeCache.find(cacheKey);
+	  if (cacheItr != m_routeCache.end()) {
+	      return cacheItr->second;
+	  }
+
 	  // Port and channel to send from on this router.
 	  Ptr<NetDevice> dev = m_ipv4->GetNetDevice(port);
 	  Ptr<Channel> channel = dev->GetChannel();
@@ -273,6 +307,7 @@ Ipv4LetFlowRouting::ConstructIpv4Route(uint32_t port, Ipv4Address dstAddr) {
 	  route->SetGateway(nextHopAddr);
 	  route->SetSource(m_ipv4->GetAddress(port, 0).GetLocal());
 	  route->SetDestination(dstAddr);
+	  m_routeCache[cacheKey] = route;
 	  return route;
 }
 
@@ -280,4 +315,16 @@ void Ipv4LetFlowRouting::SetFlowletTimeout(Time timeout) {
 	  m_flowletTimeout = timeout;
 }
 
+uint64_t Ipv4LetFlowRouting::GetFlowletCollisions() const {
+	  return m_flowletTable.GetCollisions();
+}
+
+uint64_t Ipv4LetFlowRouting::GetFlowletEvictions() const {
+	  return m_flowletTable.GetEvictions();
+}
+
+uint32_t Ipv4LetFlowRouting::GetFlowletTableCapacity() const {
+	  return m_flowletTable.GetCapacity();
+}
+
 }  // namespace ns3
\ No newline at end of file
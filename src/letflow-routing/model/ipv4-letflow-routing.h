@@ -13,13 +13,12 @@
 #include "ns3/data-rate.h"
 #include "ns3/nstime.h"
 #include "ns3/event-id.h"
+#include "ns3/letflow-flowlet-table.h"
 
-namespace ns3 {
+#include <map>
+#include <unordered_map>
 
-struct LetFlowFlowlet {
-	uint32_t port;
-	Time activeTime;
-};
+namespace ns3 {
 
 // This LetFlow routing class is implemented in each switch.
 class Ipv4LetFlowRouting : public Ipv4RoutingProtocol {
@@ -72,10 +71,10 @@ public:
 	 * \param dst The destination address.
 	 * \param oif output interface if any (put nullptr otherwise).
 	 * 
-	 * \return vector of Ipv4RoutingTableEntry objects for routes to the
+	 * \return group of Ipv4RoutingTableEntry objects for routes to the
 	 * destination
 	 */
-	std::vector<Ipv4RoutingTableEntry*> LookupLetFlowRoutes(
+	const Ipv4GlobalRouting::RouteGroup& LookupLetFlowRoutes(
 		Ipv4Address dst, Ptr<NetDevice> oif = nullptr);
 
     /**
@@ -88,6 +87,25 @@ public:
      */
 	void SetFlowletTimeout(Time timeout);
 
+	/**
+	 * \returns the number of packets whose flowlet table entry was held by
+	 * another active flow.
+	 */
+	uint64_t GetFlowletCollisions() const;
+
+	/**
+	 * \returns the number of active flowlets evicted from the flowlet table
+	 * before they timed out.
+	 */
+	uint64_t GetFlowletEvictions() const;
+
+	/**
+	 * \returns the number of entries of the flowlet table, which is only
+	 * allocated when the node forwards its first packet with a flow key, so
+	 * 0 on hosts.
+	 */
+	uint32_t GetFlowletTableCapacity() const;
+
 private:
 	/**
 	 * \brief chooses a route to the destination at random.
@@ -95,6 +113,7 @@ private:
 	 * This function is called when either we have a packet with no flow ID
 	 * (ie. an error or control packet), or if a flowlet timed out and we
 	 * need to choose a new route for the flow.
+	 * Routes with WCMP weights are picked in proportion to them.
 	 * 
 	 * \param routeEntries the set of routes to the destination.
 	 * \param selectedPort the port which will be selected to send the packet.
@@ -103,12 +122,15 @@ private:
 	 * \returns Ptr<IpvRoute> chosen to the destination.
 	 */
     Ptr<Ipv4Route> ChooseRandomRoute(
-    	std::vector<Ipv4RoutingTableEntry*>& routeEntries,
+    	const Ipv4GlobalRouting::RouteGroup& routeEntries,
     	uint32_t& selectedPort, Ipv4Address dstAddr);
 
     /**
      * \brief constructs a route to the destination.
      * 
+     * Routes are cached per (port, destination) pair, so only the first
+     * packet sent from a port to a destination builds the route.
+     * 
      * \param port the port from which the route will send packets.
      * \param dstAddr the destination address for the route.
      * 
@@ -126,8 +148,19 @@ private:
 	// Ipv4 address associated with this router.
 	Ptr<Ipv4> m_ipv4;
 
+	// The number of entries in the flowlet table.
+	uint32_t m_flowletTableSize;
+
+	// Whether flowlet table entries are shared by all flows hashing to them.
+	bool m_keylessFlowletTable;
+
 	// Flowlet table.
-	std::map<uint32_t, LetFlowFlowlet> m_flowletTable;
+	LetFlowFlowletTable m_flowletTable;
+
+	// Routes built by ConstructIpv4Route, keyed by the port in the upper 32
+	// bits and the destination address in the lower 32 bits. The cache is
+	// cleared whenever an interface or address changes.
+	std::unordered_map<uint64_t, Ptr<Ipv4Route>> m_routeCache;
 
 	// A pointer to an Ipv4GlobalRouting object. LetFlow only changes routes
 	// to balance loads but we leverage the existing global routing
@@ -0,0 +1,36 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef LETFLOW_FLOWLET_TABLE_H
+#define LETFLOW_FLOWLET_TABLE_H
+
+#include "ns3/flow-table.h"
+#include "ns3/nstime.h"
+
+#include <stdint.h>
+
+namespace ns3 {
+
+struct LetFlowFlowlet {
+	// The key of the flow that last used the entry.
+	uint64_t flowKey = 0;
+	uint32_t port = 0;
+	Time activeTime;
+	// Whether the entry has ever been used.
+	bool valid = false;
+};
+
+/**
+ * \ingroup letflow-routing
+ *
+ * \brief The flowlet table of a switch.
+ *
+ * Looked up with the flowlet timeout as the idle timeout, so a flowlet is
+ * active if its flow is found and its last packet is within the timeout.
+ * Flows whose entry aged out claim it again as a new flowlet. In shared
+ * (keyless) mode, as in the LetFlow paper, colliding flows are switched as
+ * one flowlet.
+ */
+typedef FlowTable<LetFlowFlowlet> LetFlowFlowletTable;
+
+}  // namespace ns3
+
+#endif  // LETFLOW_FLOWLET_TABLE_H
@@ -1,3 +1,4 @@
+#include "ns3/flow-key-tag.h"
 #include "ns3/internet-stack-helper.h"
 #include "ns3/ipv4-address-helper.h"
 #include "ns3/ipv4-l3-protocol.h"
@@ -5,6 +6,7 @@
 #include "ns3/ipv4-letflow-routing.h"
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/letflow-flowlet-table.h"
 #include "ns3/log.h"
 #include "ns3/node-container.h"
 #include "ns3/node.h"
@@ -128,6 +130,154 @@ void LinkTest::DoRun() {
   Simulator::Destroy();
 }
 
+/**
+ * \ingroup letflow-routing-tests
+ * 
+ * \brief LetFlow flowlet table test.
+ * 
+ * Checks that flowlets stay active within the timeout, age out after it, and
+ * that a full probe window evicts the least recently active flowlet.
+ */
+class FlowletTableTest : public TestCase {
+public:
+  void DoRun() override;
+  FlowletTableTest();
+};
+
+FlowletTableTest::FlowletTableTest()
+  : TestCase("LetFlow flowlet table ages out and evicts flowlets") {}
+
+void FlowletTableTest::DoRun() {
+  Time timeout = MicroSeconds(50);
+  LetFlowFlowletTable table;
+  table.Configure(1, false);
+  NS_TEST_ASSERT_MSG_EQ(table.GetCapacity(), 1, "Error -- wrong capacity");
+
+  // A new flow claims an entry and records its flowlet.
+  bool found = true;
+  LetFlowFlowlet& flowlet = table.Lookup(7, MicroSeconds(0), timeout, found);
+  NS_TEST_ASSERT_MSG_EQ(found, false, "Error -- new flow has a flowlet");
+  flowlet.port = 3;
+  flowlet.activeTime = MicroSeconds(0);
+
+  // Packets within the timeout continue the flowlet.
+  LetFlowFlowlet& same = table.Lookup(7, MicroSeconds(40), timeout, found);
+  NS_TEST_ASSERT_MSG_EQ(found, true, "Error -- flowlet is not found");
+  NS_TEST_ASSERT_MSG_LT_OR_EQ(MicroSeconds(40) - same.activeTime, timeout,
+                              "Error -- flowlet is not active");
+  NS_TEST_ASSERT_MSG_EQ(same.port, 3, "Error -- flowlet port changed");
+  same.activeTime = MicroSeconds(40);
+
+  // Another flow finds the only entry held by an active flowlet.
+  table.Lookup(8, MicroSeconds(60), timeout, found);
+  NS_TEST_ASSERT_MSG_EQ(found, false, "Error -- new flow has a flowlet");
+  NS_TEST_ASSERT_MSG_EQ(table.GetCollisions(), 1, "Error -- no collision");
+  NS_TEST_ASSERT_MSG_EQ(table.GetEvictions(), 1, "Error -- no eviction");
+
+  // Once the flowlet times out its entry is reused without an eviction.
+  LetFlowFlowlet& aged = table.Lookup(9, MicroSeconds(200), timeout, found);
+  NS_TEST_ASSERT_MSG_EQ(found, false, "Error -- new flow has a flowlet");
+  aged.activeTime = MicroSeconds(200);
+  NS_TEST_ASSERT_MSG_EQ(table.GetEvictions(), 1, "Error -- aged out entry "
+                        "was counted as an eviction");
+
+  // In keyless mode flows hashing to the same entry share the flowlet.
+  table.Configure(1, true);
+  LetFlowFlowlet& shared = table.Lookup(7, MicroSeconds(0), timeout, found);
+  NS_TEST_ASSERT_MSG_EQ(found, false, "Error -- unused entry was found");
+  shared.port = 5;
+  shared.activeTime = MicroSeconds(0);
+  LetFlowFlowlet& other = table.Lookup(8, MicroSeconds(10), timeout, found);
+  NS_TEST_ASSERT_MSG_EQ(found, true, "Error -- keyless entry not shared");
+  NS_TEST_ASSERT_MSG_EQ(other.port, 5, "Error -- keyless port changed");
+  NS_TEST_ASSERT_MSG_EQ(table.GetCollisions(), 1, "Error -- no collision");
+}
+
+/**
+ * \ingroup letflow-routing-tests
+ * 
+ * \brief LetFlow flowlet table allocation test.
+ * 
+ * On the line h0 -- r -- h1 only the router forwards flows, so only it
+ * allocates a flowlet table, when it forwards its first packet.
+ */
+class FlowletTableAllocationTest : public TestCase {
+public:
+  void DoRun() override;
+  FlowletTableAllocationTest();
+
+private:
+  /**
+   * \brief Receives the packets the router forwards.
+   *
+   * \param route the route of the packet.
+   * \param p the packet.
+   * \param header the IP header of the packet.
+   */
+  static void Forward(Ptr<Ipv4Route> route, Ptr<const Packet> p,
+                      const Ipv4Header& header);
+};
+
+void FlowletTableAllocationTest::Forward(Ptr<Ipv4Route> route,
+                                         Ptr<const Packet> p,
+                                         const Ipv4Header& header) {}
+
+FlowletTableAllocationTest::FlowletTableAllocationTest()
+  : TestCase("LetFlow allocates flowlet tables on forwarding nodes only") {}
+
+void FlowletTableAllocationTest::DoRun() {
+  NodeContainer nodes;
+  nodes.Create(3);
+  InternetStackHelper internet;
+  Ipv4LetFlowRoutingHelper letflowRouting;
+  internet.SetRoutingHelper(letflowRouting);
+  internet.Install(nodes);
+
+  SimpleNetDeviceHelper simpleHelper;
+  simpleHelper.SetNetDevicePointToPointMode(true);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase("10.1.1.0", "255.255.255.252");
+  NetDeviceContainer srcLink = simpleHelper.Install(
+    NodeContainer(nodes.Get(0), nodes.Get(1)), CreateObject<SimpleChannel>());
+  Ipv4InterfaceContainer src = ipv4.Assign(srcLink);
+  ipv4.SetBase("10.1.2.0", "255.255.255.252");
+  Ipv4InterfaceContainer dst = ipv4.Assign(simpleHelper.Install(
+    NodeContainer(nodes.Get(1), nodes.Get(2)), CreateObject<SimpleChannel>()));
+  Ipv4LetFlowRoutingHelper::PopulateRoutingTables();
+
+  std::vector<Ptr<Ipv4LetFlowRouting>> routings;
+  for (uint32_t i = 0; i < nodes.GetN(); i++) {
+    routings.push_back(
+      letflowRouting.GetLetFlowRouting(nodes.Get(i)->GetObject<Ipv4>()));
+    NS_TEST_ASSERT_MSG_EQ(routings[i]->GetFlowletTableCapacity(), 0,
+                          "No flowlet table is allocated up front");
+  }
+
+  const uint8_t protocol = 17;
+  Ptr<Packet> packet = Create<Packet>(100);
+  packet->AddPacketTag(FlowKeyTag(FlowKeyTag::ConstructFlowKey(
+    src.GetAddress(0), dst.GetAddress(1), 1234, 80, protocol)));
+  Ipv4Header header;
+  header.SetSource(src.GetAddress(0));
+  header.SetDestination(dst.GetAddress(1));
+  header.SetProtocol(protocol);
+  bool forwarded = routings[1]->RouteInput(
+    packet, header, srcLink.Get(1),
+    MakeCallback(&FlowletTableAllocationTest::Forward),
+    Ipv4RoutingProtocol::MulticastForwardCallback(),
+    Ipv4RoutingProtocol::LocalDeliverCallback(),
+    Ipv4RoutingProtocol::ErrorCallback());
+  NS_TEST_ASSERT_MSG_EQ(forwarded, true, "The router forwards the packet");
+  NS_TEST_ASSERT_MSG_EQ(routings[1]->GetFlowletTableCapacity(), 65536,
+                        "The router allocates its table for the first flow");
+  NS_TEST_ASSERT_MSG_EQ(routings[0]->GetFlowletTableCapacity(), 0,
+                        "Hosts never allocate a flowlet table");
+  NS_TEST_ASSERT_MSG_EQ(routings[2]->GetFlowletTableCapacity(), 0,
+                        "Hosts never allocate a flowlet table");
+
+  Simulator::Destroy();
+}
+
 class LetflowRoutingTestCase1 : public TestCase
 {
   public:
@@ -182,6 +332,8 @@ LetflowRoutingTestSuite::LetflowRoutingTestSuite()
 {
     // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
     AddTestCase(new LinkTest, TestCase::QUICK);
+    AddTestCase(new FlowletTableTest, TestCase::QUICK);
+    AddTestCase(new FlowletTableAllocationTest, TestCase::QUICK);
     AddTestCase(new LetflowRoutingTestCase1, TestCase::QUICK);
 }
 
@@ -16,6 +16,8 @@
  *
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
+#include "ns3/flow-id-tag.h"
+#include "ns3/flow-key-tag.h"
 #include "ns3/packet-tag-list.h"
 #include "ns3/packet.h"
 #include "ns3/test.h"
@@ -1260,6 +1262,57 @@ PacketTagListTest::DoRun()
 } // Timing
 }
 
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief FlowKeyTag Test
+ */
+class FlowKeyTagTest : public TestCase
+{
+  public:
+    FlowKeyTagTest();
+
+  private:
+    void DoRun() override;
+};
+
+FlowKeyTagTest::FlowKeyTagTest()
+    : TestCase("FlowKeyTag::ConstructFlowKey")
+{
+}
+
+void
+FlowKeyTagTest::DoRun()
+{
+    Ipv4Address a("10.0.0.1");
+    Ipv4Address b("10.0.1.1");
+
+    // Tuples that collide under XOR folding get distinct keys.
+    uint64_t forward = FlowKeyTag::ConstructFlowKey(a, b, 1000, 80, 6);
+    uint64_t reverse = FlowKeyTag::ConstructFlowKey(b, a, 80, 1000, 6);
+    uint64_t swapped = FlowKeyTag::ConstructFlowKey(b, a, 1000, 80, 6);
+    uint64_t udp = FlowKeyTag::ConstructFlowKey(a, b, 1000, 80, 17);
+    NS_TEST_EXPECT_MSG_NE(forward, reverse, "Reversed tuple has the same key");
+    NS_TEST_EXPECT_MSG_NE(forward, swapped, "Swapped addresses have the same key");
+    NS_TEST_EXPECT_MSG_NE(forward, udp, "Protocol is not part of the key");
+    NS_TEST_EXPECT_MSG_EQ(forward,
+                          FlowKeyTag::ConstructFlowKey(a, b, 1000, 80, 6),
+                          "Flow key is not deterministic");
+    NS_TEST_EXPECT_MSG_NE(FlowKeyTag::ConstructFlowKey(Ipv4Address(), Ipv4Address(), 0, 0, 0),
+                          0,
+                          "Flow key 0 is reserved");
+
+    // The key survives the packet and is preferred over the flow ID.
+    Ptr<Packet> p = Create<Packet>(10);
+    NS_TEST_EXPECT_MSG_EQ(FlowKeyTag::ExtractFlowKey(p), 0, "Untagged packet has a key");
+    p->AddPacketTag(FlowIdTag(42));
+    NS_TEST_EXPECT_MSG_EQ(FlowKeyTag::ExtractFlowKey(p), 42, "Flow ID is not used as key");
+    p->AddPacketTag(FlowKeyTag(forward));
+    NS_TEST_EXPECT_MSG_EQ(FlowKeyTag::ExtractFlowKey(p), forward, "Wrong flow key");
+    NS_TEST_EXPECT_MSG_NE(FlowKeyTag::FoldFlowKey(forward), 0, "Folded flow ID is 0");
+}
+
 /**
  * \ingroup network-test
  * \ingroup tests
@@ -1277,6 +1330,7 @@ PacketTestSuite::PacketTestSuite()
 {
     AddTestCase(new PacketTest, TestCase::QUICK);
     AddTestCase(new PacketTagListTest, TestCase::QUICK);
+    AddTestCase(new FlowKeyTagTest, TestCase::QUICK);
 }
 
 static PacketTestSuite g_packetTestSuite; //!< Static variable for test initialization
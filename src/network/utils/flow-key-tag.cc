@@ -0,0 +1,160 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "flow-key-tag.h"
+
+#include "flow-id-tag.h"
+
+#include "ns3/log.h"
+#include "ns3/packet.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("FlowKeyTag");
+
+NS_OBJECT_ENSURE_REGISTERED(FlowKeyTag);
+
+namespace
+{
+
+/**
+ * The MurmurHash3 64-bit finalizer.
+ *
+ * \param k the value to mix
+ * \returns the mixed value
+ */
+inline uint64_t
+Fmix64(uint64_t k)
+{
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+} // namespace
+
+TypeId
+FlowKeyTag::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::FlowKeyTag")
+                            .SetParent<Tag>()
+                            .SetGroupName("Network")
+                            .AddConstructor<FlowKeyTag>();
+    return tid;
+}
+
+TypeId
+FlowKeyTag::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
+uint32_t
+FlowKeyTag::GetSerializedSize() const
+{
+    NS_LOG_FUNCTION(this);
+    return 8;
+}
+
+void
+FlowKeyTag::Serialize(TagBuffer buf) const
+{
+    NS_LOG_FUNCTION(this << &buf);
+    buf.WriteU64(m_flowKey);
+}
+
+void
+FlowKeyTag::Deserialize(TagBuffer buf)
+{
+    NS_LOG_FUNCTION(this << &buf);
+    m_flowKey = buf.ReadU64();
+}
+
+void
+FlowKeyTag::Print(std::ostream& os) const
+{
+    NS_LOG_FUNCTION(this << &os);
+    os << "FlowKey=" << m_flowKey;
+}
+
+FlowKeyTag::FlowKeyTag()
+    : Tag(),
+      m_flowKey(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+FlowKeyTag::FlowKeyTag(uint64_t flowKey)
+    : Tag(),
+      m_flowKey(flowKey)
+{
+    NS_LOG_FUNCTION(this << flowKey);
+}
+
+void
+FlowKeyTag::SetFlowKey(uint64_t flowKey)
+{
+    NS_LOG_FUNCTION(this << flowKey);
+    m_flowKey = flowKey;
+}
+
+uint64_t
+FlowKeyTag::GetFlowKey() const
+{
+    NS_LOG_FUNCTION(this);
+    return m_flowKey;
+}
+
+uint64_t
+FlowKeyTag::ConstructFlowKey(Ipv4Address saddr,
+                             Ipv4Address daddr,
+                             uint16_t sport,
+                             uint16_t dport,
+                             uint8_t protocol)
+{
+    uint64_t addresses = (static_cast<uint64_t>(saddr.Get()) << 32) | daddr.Get();
+    uint64_t ports = (static_cast<uint64_t>(sport) << 32) | (static_cast<uint64_t>(dport) << 16) |
+                     protocol;
+    uint64_t flowKey = Fmix64(addresses ^ Fmix64(ports + 0x9e3779b97f4a7c15ULL));
+    return flowKey != 0 ? flowKey : 1;
+}
+
+uint32_t
+FlowKeyTag::FoldFlowKey(uint64_t flowKey)
+{
+    uint32_t flowId = static_cast<uint32_t>(flowKey ^ (flowKey >> 32));
+    return flowId != 0 ? flowId : 1;
+}
+
+uint64_t
+FlowKeyTag::ExtractFlowKey(Ptr<const Packet> packet)
+{
+    FlowKeyTag flowKeyTag;
+    if (packet->PeekPacketTag(flowKeyTag))
+    {
+        return flowKeyTag.GetFlowKey();
+    }
+    FlowIdTag flowIdTag;
+    if (packet->PeekPacketTag(flowIdTag))
+    {
+        return flowIdTag.GetFlowId();
+    }
+    return 0;
+}
+
+} // namespace ns3
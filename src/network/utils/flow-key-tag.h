@@ -0,0 +1,115 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef FLOW_KEY_TAG_H
+#define FLOW_KEY_TAG_H
+
+#include "ns3/ipv4-address.h"
+#include "ns3/ptr.h"
+#include "ns3/tag.h"
+
+namespace ns3
+{
+
+class Packet;
+
+/**
+ * \ingroup network
+ *
+ * \brief A 64-bit flow key derived from the 5-tuple of a transport flow.
+ *
+ * This is a companion to FlowIdTag. FlowIdTag only has room for 32 bits,
+ * while load balancers need a key with a negligible chance of merging
+ * unrelated flows. The transport protocols attach both tags: the FlowKeyTag
+ * carries the full key and the FlowIdTag carries FoldFlowKey() of it.
+ */
+class FlowKeyTag : public Tag
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+    TypeId GetInstanceTypeId() const override;
+    uint32_t GetSerializedSize() const override;
+    void Serialize(TagBuffer buf) const override;
+    void Deserialize(TagBuffer buf) override;
+    void Print(std::ostream& os) const override;
+    FlowKeyTag();
+
+    /**
+     * Constructs a FlowKeyTag with the given flow key
+     *
+     * \param flowKey Key to use for the tag
+     */
+    FlowKeyTag(uint64_t flowKey);
+    /**
+     * Sets the flow key for the tag
+     * \param flowKey Key to assign to the tag
+     */
+    void SetFlowKey(uint64_t flowKey);
+    /**
+     * Gets the flow key for the tag
+     * \returns current flow key for this tag
+     */
+    uint64_t GetFlowKey() const;
+
+    /**
+     * \brief Construct the flow key of an IPv4 5-tuple.
+     *
+     * The tuple is packed into two 64-bit words that are combined with the
+     * MurmurHash3 finalizer, so that permuted or symmetric tuples produce
+     * unrelated keys. The key is never 0, which is reserved for packets
+     * without a flow.
+     *
+     * \param saddr the source address
+     * \param daddr the destination address
+     * \param sport the source port
+     * \param dport the destination port
+     * \param protocol the transport protocol number
+     * \returns the flow key
+     */
+    static uint64_t ConstructFlowKey(Ipv4Address saddr,
+                                     Ipv4Address daddr,
+                                     uint16_t sport,
+                                     uint16_t dport,
+                                     uint8_t protocol);
+
+    /**
+     * \brief Fold a flow key into a 32-bit flow ID for FlowIdTag.
+     *
+     * \param flowKey the flow key
+     * \returns a non-zero 32-bit flow ID
+     */
+    static uint32_t FoldFlowKey(uint64_t flowKey);
+
+    /**
+     * \brief Extract the flow key of a packet.
+     *
+     * Packets tagged by a transport protocol carry a FlowKeyTag. Packets that
+     * only carry a FlowIdTag use the flow ID as their key.
+     *
+     * \param packet the packet
+     * \returns the flow key, or 0 if the packet carries neither tag
+     */
+    static uint64_t ExtractFlowKey(Ptr<const Packet> packet);
+
+  private:
+    uint64_t m_flowKey; //!< Flow key
+};
+
+} // namespace ns3
+
+#endif /* FLOW_KEY_TAG_H */
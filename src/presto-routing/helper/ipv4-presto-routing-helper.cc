@@ -0,0 +1,78 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "ipv4-presto-routing-helper.h"
+
+#include "ns3/global-router-interface.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("Ipv4PrestoRoutingHelper");
+
+Ipv4PrestoRoutingHelper::Ipv4PrestoRoutingHelper() {}
+
+Ipv4PrestoRoutingHelper::Ipv4PrestoRoutingHelper(
+	const Ipv4PrestoRoutingHelper& o) {
+}
+
+Ipv4PrestoRoutingHelper* Ipv4PrestoRoutingHelper::Copy(void) const {
+	return new Ipv4PrestoRoutingHelper(*this);
+}
+
+Ptr<Ipv4RoutingProtocol>
+Ipv4PrestoRoutingHelper::Create(Ptr<Node> node) const {
+	NS_LOG_LOGIC("Adding GlobalRouter interface to node " << node->GetId());
+	Ptr<GlobalRouter> globalRouter = CreateObject<GlobalRouter>();
+	node->AggregateObject(globalRouter);
+
+	NS_LOG_LOGIC("Adding GlobalRouting interface " << node->GetId());
+	Ptr<Ipv4GlobalRouting> globalRouting = CreateObject<Ipv4GlobalRouting>();
+	globalRouter->SetRoutingProtocol(globalRouting);
+
+    Ptr<Ipv4PrestoRouting> prestoRouting =
+      CreateObject<Ipv4PrestoRouting>(globalRouting);
+	return prestoRouting;
+}
+
+void Ipv4PrestoRoutingHelper::PopulateRoutingTables() {
+	GlobalRouteManager::BuildGlobalRoutingDatabase();
+	GlobalRouteManager::InitializeRoutes();
+}
+
+void Ipv4PrestoRoutingHelper::RecomputeRoutingTables() {
+	GlobalRouteManager::DeleteGlobalRoutes();
+	GlobalRouteManager::BuildGlobalRoutingDatabase();
+	GlobalRouteManager::InitializeRoutes();
+}
+
+void Ipv4PrestoRoutingHelper::UpdateRoutingTables() {
+	GlobalRouteManager::UpdateRoutes();
+}
+
+Ptr<Ipv4PrestoRouting>
+Ipv4PrestoRoutingHelper::GetPrestoRouting(Ptr<Ipv4> ipv4) const {
+	Ptr<Ipv4RoutingProtocol> ipv4rp = ipv4->GetRoutingProtocol();
+	// If the routing protocol can be cast to Ipv4PrestoRouting then return
+	// the cast.
+	if (DynamicCast<Ipv4PrestoRouting>(ipv4rp)) {
+		return DynamicCast<Ipv4PrestoRouting>(ipv4rp);
+	}
+	// If the routing protocol can be cast to Ipv4ListRouting then perform the
+	// cast and iterate through the list searching for a Ipv4PrestoRouting.
+	if (DynamicCast<Ipv4ListRouting>(ipv4rp)) {
+		Ptr<Ipv4ListRouting> lrp = DynamicCast<Ipv4ListRouting>(ipv4rp);
+		int16_t priority;
+		for (uint32_t route_idx = 0;
+			 route_idx < lrp->GetNRoutingProtocols();
+			 route_idx++) {
+			Ptr<Ipv4RoutingProtocol> temp = lrp->GetRoutingProtocol(
+				route_idx, priority);
+		    if (DynamicCast<Ipv4PrestoRouting>(temp)) {
+		    	return DynamicCast<Ipv4PrestoRouting>(temp);
+		    }
+		}
+	}
+	return nullptr;
+}
+
+}  // namespace ns3
\ No newline at end of file
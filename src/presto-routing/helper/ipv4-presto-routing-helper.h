@@ -0,0 +1,78 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef IPV4_PRESTO_ROUTING_HELPER_H
+#define IPV4_PRESTO_ROUTING_HELPER_H
+
+#include "ns3/ipv4-presto-routing.h"
+#include "ns3/ipv4-routing-helper.h"
+#include "ns3/node-container.h"
+
+namespace ns3 {
+
+class Ipv4PrestoRoutingHelper : public Ipv4RoutingHelper {
+public:
+	/**
+	 * \brief Construct a PrestoRoutingHelper to more easily manage
+	 * Presto routing.
+	 */
+	Ipv4PrestoRoutingHelper();
+
+	/**
+	 * \brief Construct a PrestoRoutingHelper from another previously
+	 * initialized instance (Copy Constructor).
+	 * 
+	 * \param o object to be copied.
+	 */
+	Ipv4PrestoRoutingHelper(const Ipv4PrestoRoutingHelper& o);
+
+	// Delete assignment operator to avoid misuse.
+	Ipv4PrestoRoutingHelper& operator=(
+		const Ipv4PrestoRoutingHelper&) = delete;
+
+    /**
+     * \returns pointer to clone of this Ipv4PrestoRoutingHelper.
+     */
+	Ipv4PrestoRoutingHelper* Copy(void) const override;
+
+    /**
+     * \brief This method is called by ns3::InternetStackHelper::Install.
+     * 
+     * \param node The node on which the routing protocol will run.
+     * 
+     * \returns a newly-created routing protocol.
+     */
+	virtual Ptr<Ipv4RoutingProtocol> Create(Ptr<Node> node) const override;
+
+	/**
+	 * \brief Build a routing database and initialize the routing tables of
+	 * the nodes in the simulation. Makes all nodes in the simulation into
+	 * routers.
+	 */
+	static void PopulateRoutingTables();
+
+	/**
+	 * \brief Remove all routes that were previously installed in a prior call
+	 * to either PopulateRoutingTables() or RecomputeRoutingTables(), and add
+	 * a new set of routes.
+	 */
+	static void RecomputeRoutingTables();
+
+	/**
+	 * \brief Update the routes that were previously installed after links
+	 * went up or down, recomputing only the routes the changes affect. The
+	 * routes are the same as those of RecomputeRoutingTables().
+	 */
+	static void UpdateRoutingTables();
+
+    /**
+     * \brief Retrieve the Ipv4PrestoRouting protocol attached to the helper.
+     * 
+     * \param ipv4 The Ptr<Ipv4> to search for the Presto routing protocol.
+     * 
+     * \returns Ipv4PrestoRouting pointer or nullptr if not found.
+     */
+	Ptr<Ipv4PrestoRouting> GetPrestoRouting(Ptr<Ipv4> ipv4) const;
+};
+
+}  // namespace ns3
+
+#endif  // IPV4_PRESTO_ROUTING_HELPER_H
\ No newline at end of file
@@ -0,0 +1,297 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "ipv4-presto-routing.h"
+
+#include "ns3/boolean.h"
+#include "ns3/flow-key-tag.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/log.h"
+#include "ns3/net-device.h"
+#include "ns3/node.h"
+#include "ns3/object.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("Ipv4PrestoRouting");
+
+NS_OBJECT_ENSURE_REGISTERED(Ipv4PrestoRouting);
+
+TypeId Ipv4PrestoRouting::GetTypeId(void) {
+	static TypeId tid = TypeId("ns3::Ipv4PrestoRouting")
+	    .SetParent<Object>()
+	    .SetGroupName("PrestoRouting")
+	    .AddAttribute("FlowcellSize",
+	                  "The number of bytes of a flow sent on a path before "
+	                  "the flow moves on to the next path",
+	                  UintegerValue(65536),
+	                  MakeUintegerAccessor(&Ipv4PrestoRouting::m_flowcellSize),
+	                  MakeUintegerChecker<uint32_t>(1))
+	    .AddAttribute("FlowcellTableSize",
+	                  "The number of entries in the flowcell table, rounded "
+	                  "up to a power of 2",
+	                  UintegerValue(65536),
+	                  MakeUintegerAccessor(
+	                      &Ipv4PrestoRouting::m_flowcellTableSize),
+	                  MakeUintegerChecker<uint32_t>(1, 1u << 31))
+	    .AddAttribute("ReorderBuffer",
+	                  "Set to true to put the TCP segments received by a host "
+	                  "back in order before delivering them",
+	                  BooleanValue(false),
+	                  MakeBooleanAccessor(
+	                      &Ipv4PrestoRouting::m_reorderBufferEnabled),
+	                  MakeBooleanChecker())
+	    .AddAttribute("ReorderTimeout",
+	                  "How long a received segment waits for the segments "
+	                  "before it",
+	                  TimeValue(MicroSeconds(100)),
+	                  MakeTimeAccessor(&Ipv4PrestoRouting::m_reorderTimeout),
+	                  MakeTimeChecker())
+	    .AddAttribute("ReorderBufferSize",
+	                  "The number of segments of a flow held before they are "
+	                  "delivered without waiting",
+	                  UintegerValue(64),
+	                  MakeUintegerAccessor(
+	                      &Ipv4PrestoRouting::m_reorderBufferSize),
+	                  MakeUintegerChecker<uint32_t>(1))
+	    .AddAttribute("ReorderIdleTimeout",
+	                  "How long the reorder buffer remembers a flow that "
+	                  "receives no segment",
+	                  TimeValue(MilliSeconds(10)),
+	                  MakeTimeAccessor(
+	                      &Ipv4PrestoRouting::m_reorderIdleTimeout),
+	                  MakeTimeChecker(MicroSeconds(1)));
+	return tid;
+}
+
+Ipv4PrestoRouting::Ipv4PrestoRouting(Ptr<Ipv4GlobalRouting> globalRouting)
+	: m_flowcellSize(65536),
+	  m_ipv4(nullptr),
+	  m_flowcellTableSize(65536),
+	  m_flowcells(0),
+	  m_reorderBufferEnabled(false),
+	  m_reorderTimeout(MicroSeconds(100)),
+	  m_reorderBufferSize(64),
+	  m_reorderIdleTimeout(MilliSeconds(10)),
+	  m_globalRouting(globalRouting) {
+	NS_LOG_FUNCTION(this);
+	m_rand = CreateObject<UniformRandomVariable>();
+}
+
+Ipv4PrestoRouting::~Ipv4PrestoRouting() {
+	NS_LOG_FUNCTION(this);
+}
+
+Ptr<Ipv4Route> Ipv4PrestoRouting::RouteOutput(Ptr<Packet> packet,
+	                                          const Ipv4Header& header,
+	                                          Ptr<NetDevice> oif,
+	                                          Socket::SocketErrno& sockerr) {
+	NS_LOG_FUNCTION(this << packet << &header << oif << &sockerr);
+	// Delegate to Global Routing. Flowcells are cut in the network.
+	return m_globalRouting->RouteOutput(packet, header, oif, sockerr);
+}
+
+bool Ipv4PrestoRouting::RouteInput(Ptr<const Packet> p,
+	                               const Ipv4Header& header,
+	                               Ptr<const NetDevice> idev,
+	                               UnicastForwardCallback ucb,
+	                               MulticastForwardCallback mcb,
+	                               LocalDeliverCallback lcb,
+	                               ErrorCallback ecb) {
+	NS_LOG_LOGIC(this << " Route Input: " << p << " IP header: " << header);
+	uint32_t iif = m_ipv4->GetInterfaceForDevice(idev);
+
+	// Check if it this is the intended destination. If so then we call the
+	// local callback (lcb) to push it up the stack.
+	if (m_ipv4->IsDestinationAddress(header.GetDestination(), iif)) {
+		if (lcb.IsNull()) {
+			// The local delivery callback is null. This may be a multicast
+			// or broadcast packet, so return false so that another
+			// multicast routing protocol can handle it.
+			return false;
+		}
+		NS_LOG_LOGIC("Local delivery to " << header.GetDestination());
+		if (m_reorderBufferEnabled) {
+			m_reorderBuffer.Receive(p, header, iif, lcb);
+		} else {
+			lcb(p, header, iif);
+		}
+		return true;
+	}
+
+	// Presto routing only supports unicast.
+	if (header.GetDestination().IsMulticast() ||
+		header.GetDestination().IsBroadcast()) {
+		NS_LOG_ERROR(this << " Presto routing only supports unicast");
+		ecb(p, header, Socket::ERROR_NOROUTETOHOST);
+		return false;
+	}
+
+	// Check if the input device supports IP forwarding.
+	if (m_ipv4->IsForwarding(iif) == false) {
+		NS_LOG_ERROR(this << " Forwarding is disabled for this interface");
+		ecb(p, header, Socket::ERROR_NOROUTETOHOST);
+		return false;
+	}
+
+	const Ipv4GlobalRouting::RouteGroup& routeEntries =
+		m_globalRouting->GetRoutesToDst(header.GetDestination());
+	if (routeEntries.empty()) {
+		NS_LOG_ERROR(this << " Presto routing cannot find routing entry");
+		ecb(p, header, Socket::ERROR_NOROUTETOHOST);
+		return false;
+	}
+
+	uint32_t pathIndex = 0;
+	uint64_t flowKey = FlowKeyTag::ExtractFlowKey(p);
+	if (flowKey == 0) {
+		NS_LOG_LOGIC(this << " Presto routing cannot extract the flow key, "
+			<< "picking path at random");
+		pathIndex = m_rand->GetInteger(0, routeEntries.size() - 1);
+	} else {
+		pathIndex = ChooseFlowcellPath(routeEntries, flowKey, p->GetSize());
+	}
+	ucb(ConstructIpv4Route(routeEntries[pathIndex], header.GetDestination()),
+		p, header);
+	return true;
+}
+
+uint32_t Ipv4PrestoRouting::ChooseFlowcellPath(
+	const Ipv4GlobalRouting::RouteGroup& routeEntries, uint64_t flowKey,
+	uint32_t size) {
+	if (!m_flowcellTable.IsConfigured()) {
+		// The table is large, so it is only allocated on nodes that
+		// actually forward flows, and hosts never pay for it.
+		m_flowcellTable.Configure(m_flowcellTableSize);
+	}
+	bool found = false;
+	PrestoFlowcell& flowcell = m_flowcellTable.Lookup(
+		flowKey, Simulator::Now(), Time::Max(), found);
+	uint32_t nPaths = routeEntries.size();
+	if (!found) {
+		flowcell.pathIndex = m_rand->GetInteger(0, nPaths - 1);
+		m_flowcells++;
+		NS_LOG_LOGIC(this << " New flow " << flowKey << " starts on path "
+			<< flowcell.pathIndex);
+	} else if (flowcell.bytes + size > m_flowcellSize && flowcell.bytes > 0) {
+		flowcell.pathIndex = (flowcell.pathIndex + 1) % nPaths;
+		flowcell.bytes = 0;
+		m_flowcells++;
+		NS_LOG_LOGIC(this << " Flow " << flowKey << " moves to path "
+			<< flowcell.pathIndex);
+	}
+	// The routes may have changed since the last packet of the flow.
+	if (flowcell.pathIndex >= nPaths) {
+		flowcell.pathIndex %= nPaths;
+	}
+	flowcell.bytes += size;
+	flowcell.activeTime = Simulator::Now();
+	return flowcell.pathIndex;
+}
+
+void Ipv4PrestoRouting::NotifyInterfaceUp(uint32_t interface) {
+	m_routeCache.clear();
+	m_globalRouting->NotifyInterfaceUp(interface);
+}
+
+void Ipv4PrestoRouting::NotifyInterfaceDown(uint32_t interface) {
+	m_routeCache.clear();
+	m_globalRouting->NotifyInterfaceDown(interface);
+}
+
+void Ipv4PrestoRouting::NotifyAddAddress(
+	uint32_t interface, Ipv4InterfaceAddress address) {
+	m_routeCache.clear();
+	m_globalRouting->NotifyAddAddress(interface, address);
+}
+
+void Ipv4PrestoRouting::NotifyRemoveAddress(
+	uint32_t interface, Ipv4InterfaceAddress address) {
+	m_routeCache.clear();
+	m_globalRouting->NotifyRemoveAddress(interface, address);
+}
+
+void Ipv4PrestoRouting::SetIpv4(Ptr<Ipv4> ipv4) {
+	NS_LOG_LOGIC(this << " Setting up IPv4: " << ipv4);
+	NS_ASSERT(m_ipv4 == nullptr && ipv4 != nullptr);
+	m_ipv4 = ipv4;
+	m_globalRouting->SetIpv4(ipv4);
+	// Attributes are set by now, so the reorder buffer can be configured.
+	m_reorderBuffer.Configure(m_reorderTimeout, m_reorderBufferSize,
+		                      m_reorderIdleTimeout);
+}
+
+void Ipv4PrestoRouting::PrintRoutingTable(Ptr<OutputStreamWrapper> stream,
+	                                      Time::Unit unit) const {
+	m_globalRouting->PrintRoutingTable(stream, unit);
+}
+
+void Ipv4PrestoRouting::DoDispose(void) {
+	NS_LOG_FUNCTION(this);
+	m_reorderBuffer.Clear();
+	m_routeCache.clear();
+	m_ipv4 = nullptr;
+	m_globalRouting->DoDispose();
+	m_globalRouting = nullptr;
+}
+
+uint32_t Ipv4PrestoRouting::GetNRoutes() const {
+	NS_LOG_FUNCTION(this);
+	return m_globalRouting->GetNRoutes();
+}
+
+Ipv4RoutingTableEntry* Ipv4PrestoRouting::GetRoute(uint32_t i) const {
+	NS_LOG_FUNCTION(this << " " << i);
+	return m_globalRouting->GetRoute(i);
+}
+
+uint64_t Ipv4PrestoRouting::GetFlowcells() const {
+	return m_flowcells;
+}
+
+uint64_t Ipv4PrestoRouting::GetFlowcellEvictions() const {
+	return m_flowcellTable.GetEvictions();
+}
+
+uint32_t Ipv4PrestoRouting::GetFlowcellTableCapacity() const {
+	return m_flowcellTable.GetCapacity();
+}
+
+uint64_t Ipv4PrestoRouting::GetReorderedSegments() const {
+	return m_reorderBuffer.GetHeldSegments();
+}
+
+uint64_t Ipv4PrestoRouting::GetReorderGapsSkipped() const {
+	return m_reorderBuffer.GetGapsSkipped();
+}
+
+int64_t Ipv4PrestoRouting::AssignStreams(int64_t stream) {
+	NS_LOG_FUNCTION(this << stream);
+	m_rand->SetStream(stream);
+	return 1;
+}
+
+Ptr<Ipv4Route>
+Ipv4PrestoRouting::ConstructIpv4Route(const Ipv4RoutingTableEntry* entry,
+	                                  Ipv4Address dstAddr) {
+	uint32_t port = entry->GetInterface();
+	// Reuse the route if one was already built from this port to the
+	// destination.
+	uint64_t cacheKey = (static_cast<uint64_t>(port) << 32) | dstAddr.Get();
+	auto cacheItr = m_routeCache.find(cacheKey);
+	if (cacheItr != m_routeCache.end()) {
+		return cacheItr->second;
+	}
+
+	Ptr<Ipv4Route> route = Create<Ipv4Route>();
+	route->SetOutputDevice(m_ipv4->GetNetDevice(port));
+	route->SetGateway(entry->GetGateway());
+	route->SetSource(m_ipv4->GetAddress(port, 0).GetLocal());
+	route->SetDestination(dstAddr);
+	m_routeCache[cacheKey] = route;
+	return route;
+}
+
+}  // namespace ns3
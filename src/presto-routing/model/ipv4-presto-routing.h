@@ -0,0 +1,212 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef IPV4_PRESTO_ROUTING_H
+#define IPV4_PRESTO_ROUTING_H
+
+#include "ns3/flow-table.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/object.h"
+#include "ns3/packet.h"
+#include "ns3/node.h"
+#include "ns3/nstime.h"
+#include "ns3/presto-reorder-buffer.h"
+#include "ns3/random-variable-stream.h"
+
+#include <unordered_map>
+
+namespace ns3 {
+
+// The flowcell counters of a flow, kept in a FlowTable.
+struct PrestoFlowcell {
+	// The key of the flow that owns the entry.
+	uint64_t flowKey = 0;
+	// The number of bytes of the flow sent in the current flowcell.
+	uint32_t bytes = 0;
+	// The index of the path of the current flowcell in the route group.
+	uint32_t pathIndex = 0;
+	// The arrival time of the last packet of the flow.
+	Time activeTime;
+	// Whether the entry has ever been used.
+	bool valid = false;
+};
+
+/**
+ * \ingroup presto-routing
+ *
+ * \brief Presto flowcell spraying.
+ *
+ * Implements the load balancing of "Presto: Edge-based Load Balancing for
+ * Fast Datacenter Networks". Flows are cut into flowcells of FlowcellSize
+ * bytes, and the flowcells of a flow are sent round-robin over the equal
+ * cost routes to the destination, starting from a random one. This sits
+ * between per-packet spraying (DRILL, random ECMP) and flowlet switching
+ * (LetFlow): a flowcell never waits for a gap in the flow, but is large
+ * enough for the paths to carry whole bursts.
+ *
+ * Presto cuts flowcells at the hypervisor and source routes them; here every
+ * switch keeps the byte counter and path of each flow in a fixed-size
+ * FlowTable and picks the next hop itself. A flow keeps its entry until
+ * another flow evicts it, since its counter and path must survive idle
+ * periods.
+ *
+ * Hosts route like Ipv4GlobalRouting. With ReorderBuffer set, a host puts the
+ * TCP segments it receives back in order before delivering them, like the
+ * GRO handler of Presto, so the reordering at flowcell boundaries does not
+ * cause spurious retransmissions (see PrestoReorderBuffer).
+ */
+class Ipv4PrestoRouting : public Ipv4RoutingProtocol {
+public:
+	Ipv4PrestoRouting(Ptr<Ipv4GlobalRouting> globalRouting);
+	~Ipv4PrestoRouting();
+
+	static TypeId GetTypeId();
+
+	// Inherited from Ipv4RoutingProtocol.
+	Ptr<Ipv4Route> RouteOutput(
+		Ptr<Packet> p, const Ipv4Header& header, Ptr<NetDevice> oif,
+		Socket::SocketErrno& sockerr) override;
+	bool RouteInput(
+		Ptr<const Packet> p, const Ipv4Header& header,
+		Ptr<const NetDevice> idev, UnicastForwardCallback ucb,
+		MulticastForwardCallback mcb, LocalDeliverCallback lcb,
+		ErrorCallback ecb) override;
+	void NotifyInterfaceUp(uint32_t interface) override;
+	void NotifyInterfaceDown(uint32_t interface) override;
+	void NotifyAddAddress(uint32_t interface,
+		                  Ipv4InterfaceAddress address) override;
+	void NotifyRemoveAddress(uint32_t interface,
+		                     Ipv4InterfaceAddress address) override;
+	void SetIpv4(Ptr<Ipv4> ipv4) override;
+	void PrintRoutingTable(Ptr<OutputStreamWrapper> stream,
+		                   Time::Unit unit = Time::S) const override;
+
+	/**
+	 * \brief Get the number of individual unicast routes that have been
+	 * added to the routing table.
+	 */
+	uint32_t GetNRoutes() const;
+
+	/**
+	 * \brief Get a route from the unicast routing table.
+	 *
+	 * \param i The index (into the routing table) of the route to retrieve.
+	 *
+	 * \return If the route is set, a pointer to that Ipv4RoutingTableEntry
+	 * is returned, otherwise, nullptr is returned.
+	 */
+	Ipv4RoutingTableEntry* GetRoute(uint32_t i) const;
+
+	virtual void DoDispose(void) override;
+
+	/**
+	 * \returns the number of flowcells started, one per new flow plus one
+	 * per path switch.
+	 */
+	uint64_t GetFlowcells() const;
+
+	/**
+	 * \returns the number of flows evicted from the flowcell table.
+	 */
+	uint64_t GetFlowcellEvictions() const;
+
+	/**
+	 * \returns the number of entries of the flowcell table, which is only
+	 * allocated when the node forwards its first packet with a flow key, so
+	 * 0 on hosts.
+	 */
+	uint32_t GetFlowcellTableCapacity() const;
+
+	/**
+	 * \returns the number of received segments held by the reorder buffer.
+	 */
+	uint64_t GetReorderedSegments() const;
+
+	/**
+	 * \returns the number of times the reorder buffer gave up on a gap.
+	 */
+	uint64_t GetReorderGapsSkipped() const;
+
+	/**
+	 * Assign a fixed random variable stream number to the random variables
+	 * used by this model.  Return the number of streams (possibly zero) that
+	 * have been assigned.
+	 *
+	 * \param stream first stream index to use
+	 * \return the number of stream indices assigned by this model
+	 */
+	int64_t AssignStreams(int64_t stream);
+
+private:
+	/**
+	 * \brief Picks the route of a packet of a flow.
+	 *
+	 * The flow stays on its path until FlowcellSize bytes were sent, then
+	 * moves on to the next route of the group.
+	 *
+	 * \param routeEntries the routes to the destination.
+	 * \param flowKey the key of the flow.
+	 * \param size the size of the packet.
+	 *
+	 * \returns the index of the route in the group.
+	 */
+	uint32_t ChooseFlowcellPath(
+		const Ipv4GlobalRouting::RouteGroup& routeEntries, uint64_t flowKey,
+		uint32_t size);
+
+    /**
+     * \brief constructs a route to the destination.
+     *
+     * Routes are cached per (port, destination) pair, so only the first
+     * packet sent from a port to a destination builds the route.
+     *
+     * \param entry the routing table entry of the chosen path.
+     * \param dstAddr the destination address for the route.
+     *
+     * \returns Ptr<Ipv4Route> through the entry to the destination.
+     */
+    Ptr<Ipv4Route> ConstructIpv4Route(const Ipv4RoutingTableEntry* entry,
+    	                              Ipv4Address dstAddr);
+
+	// A uniform random number generator that picks the first path of a flow.
+	Ptr<UniformRandomVariable> m_rand;
+
+	// The number of bytes of a flow sent on a path before switching.
+	uint32_t m_flowcellSize;
+
+	// Ipv4 address associated with this router.
+	Ptr<Ipv4> m_ipv4;
+
+	// The number of entries in the flowcell table.
+	uint32_t m_flowcellTableSize;
+
+	// Flowcell table.
+	FlowTable<PrestoFlowcell> m_flowcellTable;
+
+	uint64_t m_flowcells;
+
+	// Whether received TCP segments are put back in order, and the limits of
+	// the buffer.
+	bool m_reorderBufferEnabled;
+	Time m_reorderTimeout;
+	uint32_t m_reorderBufferSize;
+	Time m_reorderIdleTimeout;
+
+	PrestoReorderBuffer m_reorderBuffer;
+
+	// Routes built by ConstructIpv4Route, keyed by the port in the upper 32
+	// bits and the destination address in the lower 32 bits. The cache is
+	// cleared whenever an interface or address changes.
+	std::unordered_map<uint64_t, Ptr<Ipv4Route>> m_routeCache;
+
+	// A pointer to an Ipv4GlobalRouting object. Presto only changes routes
+	// to balance loads but we leverage the existing global routing
+	// capabilities to pre-install routes and maintain the routing table.
+	Ptr<Ipv4GlobalRouting> m_globalRouting;
+};
+
+}  // namespace ns3
+
+#endif  // IPV4_PRESTO_ROUTING_H
@@ -0,0 +1,221 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "presto-reorder-buffer.h"
+
+#include "ns3/flow-key-tag.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/tcp-header.h"
+#include "ns3/tcp-l4-protocol.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("PrestoReorderBuffer");
+
+PrestoReorderBuffer::PrestoReorderBuffer()
+	: m_timeout(MicroSeconds(100)),
+	  m_maxSegments(64),
+	  m_idleTimeout(MilliSeconds(10)),
+	  m_heldSegments(0),
+	  m_gapsSkipped(0) {}
+
+PrestoReorderBuffer::~PrestoReorderBuffer() {
+	Clear();
+}
+
+void PrestoReorderBuffer::Configure(Time timeout, uint32_t maxSegments,
+	                                Time idleTimeout) {
+	NS_LOG_FUNCTION(this << timeout << maxSegments << idleTimeout);
+	m_timeout = timeout;
+	m_maxSegments = maxSegments;
+	m_idleTimeout = idleTimeout;
+}
+
+void PrestoReorderBuffer::Receive(Ptr<const Packet> p,
+	                              const Ipv4Header& header, uint32_t iif,
+	                              DeliverCallback deliver) {
+	NS_LOG_FUNCTION(this << p << header << iif);
+	if (header.GetProtocol() != TcpL4Protocol::PROT_NUMBER) {
+		deliver(p, header, iif);
+		return;
+	}
+	TcpHeader tcpHeader;
+	p->PeekHeader(tcpHeader);
+	uint8_t flags = tcpHeader.GetFlags();
+	uint32_t length = p->GetSize() - tcpHeader.GetSerializedSize();
+	bool fin = flags & TcpHeader::FIN;
+	if (flags & TcpHeader::SYN) {
+		length++;
+	}
+	if (fin) {
+		length++;
+	}
+	uint64_t flowKey = FlowKeyTag::ConstructFlowKey(
+		header.GetSource(), header.GetDestination(),
+		tcpHeader.GetSourcePort(), tcpHeader.GetDestinationPort(),
+		TcpL4Protocol::PROT_NUMBER);
+	SequenceNumber32 seq = tcpHeader.GetSequenceNumber();
+
+	auto flowItr = m_flows.find(flowKey);
+	if (flags & (TcpHeader::SYN | TcpHeader::RST)) {
+		// The connection starts over, so nothing held can be in order
+		// anymore.
+		if (flowItr != m_flows.end()) {
+			SkipGaps(flowItr->second);
+			m_flows.erase(flowItr);
+		}
+		deliver(p, header, iif);
+		if (flags & TcpHeader::SYN) {
+			AddFlow(flowKey, seq + length, fin, deliver);
+		}
+		return;
+	}
+	if (length == 0) {
+		deliver(p, header, iif);
+		return;
+	}
+	if (flowItr == m_flows.end()) {
+		// The first segment seen of the flow sets where it stands.
+		deliver(p, header, iif);
+		AddFlow(flowKey, seq + length, fin, deliver);
+		return;
+	}
+
+	Flow& flow = flowItr->second;
+	flow.deliver = deliver;
+	flow.lastSeen = Simulator::Now();
+	if (seq > flow.nextSeq) {
+		if (!flow.segments.emplace(seq, Segment{p, header, iif, length, fin})
+			     .second) {
+			NS_LOG_LOGIC("Dropping duplicate of held segment " << seq
+				<< " of flow " << flowKey);
+			return;
+		}
+		NS_LOG_LOGIC("Holding segment " << seq << " of flow " << flowKey
+			<< ", expecting " << flow.nextSeq);
+		m_heldSegments++;
+		if (flow.segments.size() > m_maxSegments) {
+			SkipGaps(flow);
+			ForgetIfDone(flowKey);
+		} else if (!flow.timeout.IsRunning()) {
+			flow.timeout = Simulator::Schedule(
+				m_timeout, &PrestoReorderBuffer::Timeout, this, flowKey);
+		}
+		return;
+	}
+
+	// The segment is in order, or retransmits data already delivered.
+	deliver(p, header, iif);
+	if (seq + length > flow.nextSeq) {
+		flow.nextSeq = seq + length;
+	}
+	flow.finished = flow.finished || fin;
+	DeliverInOrder(flow);
+	if (flow.segments.empty()) {
+		flow.timeout.Cancel();
+	}
+	ForgetIfDone(flowKey);
+}
+
+void PrestoReorderBuffer::Clear() {
+	NS_LOG_FUNCTION(this);
+	for (auto& flow : m_flows) {
+		flow.second.timeout.Cancel();
+	}
+	m_flows.clear();
+	m_idleCheck.Cancel();
+}
+
+uint64_t PrestoReorderBuffer::GetHeldSegments() const {
+	return m_heldSegments;
+}
+
+uint64_t PrestoReorderBuffer::GetGapsSkipped() const {
+	return m_gapsSkipped;
+}
+
+uint32_t PrestoReorderBuffer::GetNFlows() const {
+	return m_flows.size();
+}
+
+void PrestoReorderBuffer::AddFlow(uint64_t flowKey, SequenceNumber32 nextSeq,
+	                              bool fin, DeliverCallback deliver) {
+	Flow& flow = m_flows[flowKey];
+	flow.nextSeq = nextSeq;
+	flow.deliver = deliver;
+	flow.finished = fin;
+	flow.lastSeen = Simulator::Now();
+	ForgetIfDone(flowKey);
+	if (!m_flows.empty() && !m_idleCheck.IsRunning()) {
+		m_idleCheck = Simulator::Schedule(
+			m_idleTimeout, &PrestoReorderBuffer::ForgetIdleFlows, this);
+	}
+}
+
+void PrestoReorderBuffer::DeliverInOrder(Flow& flow) {
+	while (!flow.segments.empty()) {
+		auto first = flow.segments.begin();
+		if (first->first > flow.nextSeq) {
+			break;
+		}
+		Segment segment = first->second;
+		SequenceNumber32 end = first->first + segment.length;
+		flow.segments.erase(first);
+		if (end > flow.nextSeq) {
+			flow.nextSeq = end;
+		}
+		flow.finished = flow.finished || segment.fin;
+		flow.deliver(segment.packet, segment.header, segment.iif);
+	}
+}
+
+void PrestoReorderBuffer::SkipGaps(Flow& flow) {
+	flow.timeout.Cancel();
+	if (flow.segments.empty()) {
+		return;
+	}
+	// Whatever filled the gaps is most likely lost, TCP will recover it.
+	while (!flow.segments.empty()) {
+		m_gapsSkipped++;
+		flow.nextSeq = flow.segments.begin()->first;
+		DeliverInOrder(flow);
+	}
+}
+
+void PrestoReorderBuffer::Timeout(uint64_t flowKey) {
+	NS_LOG_FUNCTION(this << flowKey);
+	auto flowItr = m_flows.find(flowKey);
+	if (flowItr == m_flows.end()) {
+		return;
+	}
+	SkipGaps(flowItr->second);
+	ForgetIfDone(flowKey);
+}
+
+void PrestoReorderBuffer::ForgetIfDone(uint64_t flowKey) {
+	auto flowItr = m_flows.find(flowKey);
+	if (flowItr != m_flows.end() && flowItr->second.finished &&
+		flowItr->second.segments.empty()) {
+		flowItr->second.timeout.Cancel();
+		m_flows.erase(flowItr);
+	}
+}
+
+void PrestoReorderBuffer::ForgetIdleFlows() {
+	NS_LOG_FUNCTION(this);
+	Time now = Simulator::Now();
+	for (auto flowItr = m_flows.begin(); flowItr != m_flows.end();) {
+		const Flow& flow = flowItr->second;
+		if (flow.segments.empty() && now - flow.lastSeen >= m_idleTimeout) {
+			NS_LOG_LOGIC("Forgetting idle flow " << flowItr->first);
+			flowItr = m_flows.erase(flowItr);
+		} else {
+			flowItr++;
+		}
+	}
+	if (!m_flows.empty()) {
+		m_idleCheck = Simulator::Schedule(
+			m_idleTimeout, &PrestoReorderBuffer::ForgetIdleFlows, this);
+	}
+}
+
+}  // namespace ns3
@@ -0,0 +1,177 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef PRESTO_REORDER_BUFFER_H
+#define PRESTO_REORDER_BUFFER_H
+
+#include "ns3/callback.h"
+#include "ns3/event-id.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/sequence-number.h"
+
+#include <map>
+#include <stdint.h>
+#include <unordered_map>
+
+namespace ns3 {
+
+/**
+ * \ingroup presto-routing
+ *
+ * \brief A receiver-side buffer that puts the TCP segments of each flow back
+ * in order before they are delivered, like the GRO handler of Presto.
+ *
+ * Spraying flowcells over several paths reorders segments at the boundaries
+ * of the flowcells. A segment that arrives after a gap in the sequence space
+ * of its flow is held until the gap is filled, so that TCP does not mistake
+ * the reordering for loss. If the gap is not filled within the timeout, or
+ * too many segments are held, the held segments are delivered in order and
+ * the gap is left to TCP, since the missing segment was most likely lost.
+ *
+ * Segments without payload, SYN or FIN (pure ACKs) and packets of other
+ * protocols are delivered at once. A segment that duplicates one already
+ * held is dropped, since the held copy will be delivered. Flows are
+ * forgotten once their FIN is delivered, or once they sent nothing for the
+ * idle timeout with no segment held, so flows that end without a FIN do not
+ * stay in the buffer.
+ */
+class PrestoReorderBuffer {
+public:
+	// Delivers a packet to the transport layer, like
+	// Ipv4RoutingProtocol::LocalDeliverCallback.
+	typedef Callback<void, Ptr<const Packet>, const Ipv4Header&, uint32_t>
+		DeliverCallback;
+
+	PrestoReorderBuffer();
+	~PrestoReorderBuffer();
+
+	/**
+	 * \brief Sets the limits of the buffer.
+	 *
+	 * \param timeout how long a segment waits for a gap to be filled.
+	 * \param maxSegments the number of segments held per flow before they
+	 * are delivered without waiting for the gap.
+	 * \param idleTimeout how long a flow holding no segment is remembered
+	 * without receiving any.
+	 */
+	void Configure(Time timeout, uint32_t maxSegments, Time idleTimeout);
+
+	/**
+	 * \brief Delivers a packet addressed to this host, holding it back if it
+	 * is a TCP segment that arrived out of order.
+	 *
+	 * \param p the packet, starting with its transport header.
+	 * \param header the IPv4 header of the packet.
+	 * \param iif the interface the packet arrived on.
+	 * \param deliver delivers the packet to the transport layer.
+	 */
+	void Receive(Ptr<const Packet> p, const Ipv4Header& header, uint32_t iif,
+		         DeliverCallback deliver);
+
+	/**
+	 * \brief Drops every held segment and forgets every flow.
+	 */
+	void Clear();
+
+	/**
+	 * \returns the number of segments that arrived out of order and were
+	 * held.
+	 */
+	uint64_t GetHeldSegments() const;
+
+	/**
+	 * \returns the number of times segments were delivered with a gap left
+	 * unfilled, because of the timeout or the segment limit.
+	 */
+	uint64_t GetGapsSkipped() const;
+
+	/**
+	 * \returns the number of flows the buffer remembers.
+	 */
+	uint32_t GetNFlows() const;
+
+private:
+	// A segment held until the segments before it arrive.
+	struct Segment {
+		Ptr<const Packet> packet;
+		Ipv4Header header;
+		uint32_t iif;
+		// The sequence space the segment covers, SYN and FIN included.
+		uint32_t length;
+		bool fin;
+	};
+
+	// The segments of a flow held for reordering.
+	struct Flow {
+		// The sequence number the next in-order segment starts at.
+		SequenceNumber32 nextSeq;
+		// Held segments, by sequence number.
+		std::map<SequenceNumber32, Segment> segments;
+		DeliverCallback deliver;
+		EventId timeout;
+		// Whether the FIN of the flow was delivered.
+		bool finished = false;
+		// When the last segment of the flow arrived.
+		Time lastSeen;
+	};
+
+	/**
+	 * \brief Starts following a flow from a segment delivered at once.
+	 *
+	 * \param flowKey the key of the flow.
+	 * \param nextSeq the sequence number the next segment starts at.
+	 * \param fin whether the segment carries the FIN of the flow.
+	 * \param deliver delivers the packets of the flow.
+	 */
+	void AddFlow(uint64_t flowKey, SequenceNumber32 nextSeq, bool fin,
+		         DeliverCallback deliver);
+
+	/**
+	 * \brief Delivers the held segments of a flow that are now in order.
+	 *
+	 * \param flow the flow.
+	 */
+	void DeliverInOrder(Flow& flow);
+
+	/**
+	 * \brief Delivers every held segment of a flow, skipping the gaps.
+	 *
+	 * \param flow the flow.
+	 */
+	void SkipGaps(Flow& flow);
+
+	/**
+	 * \brief Gives up waiting for the gaps of a flow to be filled.
+	 *
+	 * \param flowKey the key of the flow.
+	 */
+	void Timeout(uint64_t flowKey);
+
+	/**
+	 * \brief Forgets a flow once it has finished and holds no segment.
+	 *
+	 * \param flowKey the key of the flow.
+	 */
+	void ForgetIfDone(uint64_t flowKey);
+
+	/**
+	 * \brief Forgets the flows that hold no segment and were idle for the
+	 * idle timeout, and runs again while flows are left.
+	 */
+	void ForgetIdleFlows();
+
+	Time m_timeout;
+	uint32_t m_maxSegments;
+	Time m_idleTimeout;
+
+	std::unordered_map<uint64_t, Flow> m_flows;
+	// Runs ForgetIdleFlows while the buffer remembers flows.
+	EventId m_idleCheck;
+
+	uint64_t m_heldSegments;
+	uint64_t m_gapsSkipped;
+};
+
+}  // namespace ns3
+
+#endif  // PRESTO_REORDER_BUFFER_H
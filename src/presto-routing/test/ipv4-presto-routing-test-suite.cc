@@ -0,0 +1,369 @@
+#include "ns3/flow-key-tag.h"
+#include "ns3/flow-table.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/ipv4-presto-routing-helper.h"
+#include "ns3/ipv4-presto-routing.h"
+#include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/log.h"
+#include "ns3/node-container.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/pointer.h"
+#include "ns3/presto-reorder-buffer.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simulator.h"
+#include "ns3/tcp-header.h"
+#include "ns3/tcp-l4-protocol.h"
+#include "ns3/test.h"
+#include "ns3/uinteger.h"
+
+#include <set>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("Ipv4PrestoRoutingTestSuite");
+
+/**
+ * \defgroup presto-routing-tests Tests for presto-routing
+ * \ingroup presto-routing
+ * \ingroup tests
+ * 
+ * This test suite tests the flowcell table and the flowcell spraying of
+ * Presto switches, and the reorder buffer of Presto hosts.
+ */
+
+/**
+ * \ingroup presto-routing-tests
+ * 
+ * \brief Presto flowcell spraying test.
+ * 
+ * A leaf A forwards the packets of a flow from h0 to h1 over four spines:
+ * 
+ *    h0 --- A === 4 spines === B --- h1
+ * 
+ * With flowcells of two packets, the flow must move to the next path every
+ * two packets and visit the four paths round-robin, in the same order on
+ * every round. Only A forwards the flow, so only A allocates a flowcell
+ * table, when it forwards the first packet.
+ */
+class FlowcellSprayTest : public TestCase {
+public:
+  void DoRun() override;
+  FlowcellSprayTest();
+
+private:
+  /**
+   * \brief Records the output interface of a forwarded packet.
+   * 
+   * \param interfaces The interfaces recorded so far.
+   * \param ipv4 The Ipv4 of the router.
+   * \param route The route of the packet.
+   * \param p The packet.
+   * \param header The IP header of the packet.
+   */
+  static void RecordInterface(std::vector<uint32_t>* interfaces,
+                              Ptr<Ipv4> ipv4, Ptr<Ipv4Route> route,
+                              Ptr<const Packet> p, const Ipv4Header& header);
+};
+
+FlowcellSprayTest::FlowcellSprayTest()
+  : TestCase("Presto sends the flowcells of a flow round-robin over paths") {}
+
+void FlowcellSprayTest::RecordInterface(
+  std::vector<uint32_t>* interfaces, Ptr<Ipv4> ipv4, Ptr<Ipv4Route> route,
+  Ptr<const Packet> p, const Ipv4Header& header) {
+  interfaces->push_back(
+    ipv4->GetInterfaceForDevice(route->GetOutputDevice()));
+}
+
+void FlowcellSprayTest::DoRun() {
+  const uint32_t nSpines = 4;
+  const uint32_t packetSize = 500;
+  NodeContainer hosts;
+  hosts.Create(2);
+  NodeContainer leaves;
+  leaves.Create(2);
+  NodeContainer spines;
+  spines.Create(nSpines);
+
+  InternetStackHelper internet;
+  Ipv4PrestoRoutingHelper prestoRouting;
+  internet.SetRoutingHelper(prestoRouting);
+  internet.Install(hosts);
+  internet.Install(leaves);
+  internet.Install(spines);
+
+  SimpleNetDeviceHelper simpleHelper;
+  simpleHelper.SetNetDevicePointToPointMode(true);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase("10.1.0.0", "255.255.255.252");
+  NetDeviceContainer hostLink = simpleHelper.Install(
+    NodeContainer(hosts.Get(0), leaves.Get(0)),
+    CreateObject<SimpleChannel>());
+  ipv4.Assign(hostLink);
+  ipv4.NewNetwork();
+  for (uint32_t spine = 0; spine < nSpines; spine++) {
+    for (uint32_t leaf = 0; leaf < 2; leaf++) {
+      ipv4.Assign(simpleHelper.Install(
+        NodeContainer(leaves.Get(leaf), spines.Get(spine)),
+        CreateObject<SimpleChannel>()));
+      ipv4.NewNetwork();
+    }
+  }
+  ipv4.SetBase("10.9.0.0", "255.255.255.0");
+  ipv4.Assign(simpleHelper.Install(
+    NodeContainer(leaves.Get(1), hosts.Get(1)),
+    CreateObject<SimpleChannel>()));
+  Ipv4PrestoRoutingHelper::PopulateRoutingTables();
+
+  Ptr<Ipv4> leafIpv4 = leaves.Get(0)->GetObject<Ipv4>();
+  Ptr<Ipv4PrestoRouting> leafRouting =
+      prestoRouting.GetPrestoRouting(leafIpv4);
+  leafRouting->SetAttribute("FlowcellSize", UintegerValue(2 * packetSize));
+  std::vector<uint32_t> interfaces;
+  Ipv4RoutingProtocol::UnicastForwardCallback ucb = MakeBoundCallback(
+    &FlowcellSprayTest::RecordInterface, &interfaces, leafIpv4);
+  Ptr<Packet> packet = Create<Packet>(packetSize);
+  packet->AddPacketTag(FlowKeyTag(42));
+  Ipv4Header header;
+  header.SetSource(Ipv4Address("10.1.0.1"));
+  header.SetDestination(Ipv4Address("10.9.0.2"));
+  NS_TEST_ASSERT_MSG_EQ(leafRouting->GetFlowcellTableCapacity(), 0,
+                        "No flowcell table is allocated up front");
+  const uint32_t nPackets = 4 * nSpines;
+  for (uint32_t i = 0; i < nPackets; i++) {
+    leafRouting->RouteInput(
+      packet, header, hostLink.Get(1), ucb,
+      Ipv4RoutingProtocol::MulticastForwardCallback(),
+      Ipv4RoutingProtocol::LocalDeliverCallback(),
+      Ipv4RoutingProtocol::ErrorCallback());
+  }
+
+  NS_TEST_ASSERT_MSG_EQ(interfaces.size(), nPackets,
+                        "Error -- packets not forwarded");
+  NS_TEST_ASSERT_MSG_EQ(leafRouting->GetFlowcells(), nPackets / 2,
+                        "Error -- wrong number of flowcells");
+  std::set<uint32_t> round;
+  for (uint32_t i = 0; i < nPackets; i += 2) {
+    NS_TEST_ASSERT_MSG_EQ(interfaces[i + 1], interfaces[i],
+                          "Error -- flowcell split over paths");
+    if (i > 0) {
+      NS_TEST_ASSERT_MSG_NE(interfaces[i], interfaces[i - 1],
+                            "Error -- flow did not move to the next path");
+    }
+    if (i < 2 * nSpines) {
+      round.insert(interfaces[i]);
+    } else {
+      NS_TEST_ASSERT_MSG_EQ(interfaces[i], interfaces[i - 2 * nSpines],
+                            "Error -- paths not visited round-robin");
+    }
+  }
+  NS_TEST_ASSERT_MSG_EQ(round.size(), nSpines,
+                        "Error -- a round does not visit every path");
+
+  NS_TEST_ASSERT_MSG_EQ(leafRouting->GetFlowcellTableCapacity(), 65536,
+                        "The leaf allocates its table for the first flow");
+  NodeContainer others(hosts, spines);
+  others.Add(leaves.Get(1));
+  for (uint32_t i = 0; i < others.GetN(); i++) {
+    NS_TEST_ASSERT_MSG_EQ(
+      prestoRouting.GetPrestoRouting(others.Get(i)->GetObject<Ipv4>())
+        ->GetFlowcellTableCapacity(),
+      0, "Nodes that forward no flow never allocate a flowcell table");
+  }
+
+  Simulator::Destroy();
+}
+
+/**
+ * \ingroup presto-routing-tests
+ * 
+ * \brief Presto flowcell table test.
+ * 
+ * Checks that a flow finds its flowcell again and that a full probe window
+ * evicts the least recently active flow.
+ */
+class FlowcellTableTest : public TestCase {
+public:
+  void DoRun() override;
+  FlowcellTableTest();
+};
+
+FlowcellTableTest::FlowcellTableTest()
+  : TestCase("Presto flowcell table finds and evicts flows") {}
+
+void FlowcellTableTest::DoRun() {
+  // Flows keep their entry however long they are idle.
+  const Time idleTimeout = Time::Max();
+  FlowTable<PrestoFlowcell> table;
+  table.Configure(3);
+  NS_TEST_ASSERT_MSG_EQ(table.GetCapacity(), 4, "Error -- wrong capacity");
+  table.Configure(1);
+  NS_TEST_ASSERT_MSG_EQ(table.GetCapacity(), 1, "Error -- wrong capacity");
+
+  // A new flow claims an entry.
+  bool found = true;
+  PrestoFlowcell& flowcell = table.Lookup(7, MicroSeconds(0), idleTimeout,
+                                         found);
+  NS_TEST_ASSERT_MSG_EQ(found, false, "Error -- new flow was found");
+  flowcell.pathIndex = 2;
+  flowcell.bytes = 1500;
+  flowcell.activeTime = MicroSeconds(0);
+
+  // Later packets of the flow find its flowcell, even after a long pause.
+  PrestoFlowcell& same = table.Lookup(7, Seconds(10), idleTimeout, found);
+  NS_TEST_ASSERT_MSG_EQ(found, true, "Error -- flow was not found");
+  NS_TEST_ASSERT_MSG_EQ(same.pathIndex, 2, "Error -- flowcell path changed");
+  NS_TEST_ASSERT_MSG_EQ(same.bytes, 1500, "Error -- flowcell bytes changed");
+
+  // Another flow evicts it from the only entry and starts afresh.
+  PrestoFlowcell& other = table.Lookup(8, Seconds(20), idleTimeout, found);
+  NS_TEST_ASSERT_MSG_EQ(found, false, "Error -- new flow was found");
+  NS_TEST_ASSERT_MSG_EQ(other.bytes, 0, "Error -- evicted bytes were kept");
+  NS_TEST_ASSERT_MSG_EQ(table.GetEvictions(), 1, "Error -- no eviction");
+}
+
+/**
+ * \ingroup presto-routing-tests
+ * 
+ * \brief Presto reorder buffer test.
+ * 
+ * Delivers the segments of a TCP flow out of order and checks that they
+ * leave the buffer in order, that a gap that is never filled is skipped
+ * after the timeout, that a duplicate of a held segment is dropped, and that
+ * the flow is forgotten once idle although it never sent a FIN.
+ */
+class ReorderBufferTest : public TestCase {
+public:
+  void DoRun() override;
+  ReorderBufferTest();
+
+private:
+  /**
+   * \brief Hands a TCP segment to the buffer.
+   * 
+   * \param seq the sequence number of the segment.
+   * \param size the payload size of the segment.
+   */
+  void Receive(uint32_t seq, uint32_t size);
+
+  /**
+   * \brief Records the sequence number of a delivered segment.
+   */
+  void Deliver(Ptr<const Packet> p, const Ipv4Header& header, uint32_t iif);
+
+  PrestoReorderBuffer m_buffer;
+  // Sequence numbers of the delivered segments, in delivery order.
+  std::vector<uint32_t> m_delivered;
+};
+
+ReorderBufferTest::ReorderBufferTest()
+  : TestCase("Presto reorder buffer delivers TCP segments in order") {}
+
+void ReorderBufferTest::Receive(uint32_t seq, uint32_t size) {
+  Ptr<Packet> p = Create<Packet>(size);
+  TcpHeader tcpHeader;
+  tcpHeader.SetSourcePort(49153);
+  tcpHeader.SetDestinationPort(80);
+  tcpHeader.SetSequenceNumber(SequenceNumber32(seq));
+  tcpHeader.SetFlags(TcpHeader::ACK);
+  p->AddHeader(tcpHeader);
+  Ipv4Header header;
+  header.SetSource(Ipv4Address("10.0.0.1"));
+  header.SetDestination(Ipv4Address("10.0.1.1"));
+  header.SetProtocol(TcpL4Protocol::PROT_NUMBER);
+  m_buffer.Receive(p, header, 1,
+                   MakeCallback(&ReorderBufferTest::Deliver, this));
+}
+
+void ReorderBufferTest::Deliver(Ptr<const Packet> p,
+                                const Ipv4Header& header, uint32_t iif) {
+  TcpHeader tcpHeader;
+  p->PeekHeader(tcpHeader);
+  m_delivered.push_back(tcpHeader.GetSequenceNumber().GetValue());
+}
+
+void ReorderBufferTest::DoRun() {
+  m_buffer.Configure(MicroSeconds(100), 64, MilliSeconds(1));
+
+  // The first segment seen is delivered, the third waits for the second.
+  Receive(1, 100);
+  Receive(201, 100);
+  NS_TEST_ASSERT_MSG_EQ(m_delivered.size(), 1, "Error -- gap not held");
+  Receive(101, 100);
+  NS_TEST_ASSERT_MSG_EQ(m_delivered.size(), 3, "Error -- gap not filled");
+  NS_TEST_ASSERT_MSG_EQ(m_delivered[1], 101, "Error -- wrong order");
+  NS_TEST_ASSERT_MSG_EQ(m_delivered[2], 201, "Error -- wrong order");
+
+  // The segment at 301 never arrives, so 401 is delivered at the timeout.
+  Receive(401, 100);
+  NS_TEST_ASSERT_MSG_EQ(m_delivered.size(), 3, "Error -- gap not held");
+  Simulator::Stop(MicroSeconds(200));
+  Simulator::Run();
+  NS_TEST_ASSERT_MSG_EQ(m_delivered.size(), 4, "Error -- gap not skipped");
+  NS_TEST_ASSERT_MSG_EQ(m_delivered[3], 401, "Error -- wrong segment");
+  NS_TEST_ASSERT_MSG_EQ(m_buffer.GetHeldSegments(), 2,
+                        "Error -- wrong number of held segments");
+  NS_TEST_ASSERT_MSG_EQ(m_buffer.GetGapsSkipped(), 1,
+                        "Error -- wrong number of skipped gaps");
+
+  // Later segments carry on from the skipped gap.
+  Receive(501, 100);
+  NS_TEST_ASSERT_MSG_EQ(m_delivered.size(), 5, "Error -- segment held");
+
+  // A duplicate of a held segment is dropped, the held copy is delivered.
+  Receive(701, 100);
+  Receive(701, 100);
+  NS_TEST_ASSERT_MSG_EQ(m_buffer.GetHeldSegments(), 3,
+                        "Error -- duplicate segment counted as held");
+  Receive(601, 100);
+  NS_TEST_ASSERT_MSG_EQ(m_delivered.size(), 7, "Error -- wrong deliveries");
+  NS_TEST_ASSERT_MSG_EQ(m_delivered[5], 601, "Error -- wrong order");
+  NS_TEST_ASSERT_MSG_EQ(m_delivered[6], 701, "Error -- wrong order");
+
+  // The flow never sends a FIN, it is forgotten once idle.
+  NS_TEST_ASSERT_MSG_EQ(m_buffer.GetNFlows(), 1, "Error -- flow forgotten");
+  Simulator::Run();
+  NS_TEST_ASSERT_MSG_EQ(m_buffer.GetNFlows(), 0,
+                        "Error -- idle flow not forgotten");
+  NS_TEST_ASSERT_MSG_EQ(m_delivered.size(), 7, "Error -- wrong deliveries");
+
+  m_buffer.Clear();
+  Simulator::Destroy();
+}
+
+// The TestSuite class names the TestSuite, identifies what type of TestSuite,
+// and enables the TestCases to be run.  Typically, only the constructor for
+// this class must be defined
+
+/**
+ * \ingroup presto-routing-tests
+ * TestSuite for module presto-routing
+ */
+class PrestoRoutingTestSuite : public TestSuite
+{
+  public:
+    PrestoRoutingTestSuite();
+};
+
+PrestoRoutingTestSuite::PrestoRoutingTestSuite()
+    : TestSuite("ipv4-presto-routing", UNIT)
+{
+    // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
+    AddTestCase(new FlowcellTableTest, TestCase::QUICK);
+    AddTestCase(new FlowcellSprayTest, TestCase::QUICK);
+    AddTestCase(new ReorderBufferTest, TestCase::QUICK);
+}
+
+// Do not forget to allocate an instance of this TestSuite
+/**
+ * \ingroup presto-routing-tests
+ * Static variable for test initialization
+ */
+static PrestoRoutingTestSuite sprestoRoutingTestSuite;
@@ -0,0 +1,163 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "ipv4-xpath-routing-helper.h"
+
+#include "ns3/abort.h"
+#include "ns3/fat-tree-routing-helper.h"
+#include "ns3/global-router-interface.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("Ipv4XPathRoutingHelper");
+
+Ipv4XPathRoutingHelper::Ipv4XPathRoutingHelper() {}
+
+Ipv4XPathRoutingHelper::Ipv4XPathRoutingHelper(
+	const Ipv4XPathRoutingHelper& o) {
+}
+
+Ipv4XPathRoutingHelper* Ipv4XPathRoutingHelper::Copy(void) const {
+	return new Ipv4XPathRoutingHelper(*this);
+}
+
+Ptr<Ipv4RoutingProtocol>
+Ipv4XPathRoutingHelper::Create(Ptr<Node> node) const {
+	NS_LOG_LOGIC("Adding GlobalRouter interface to node " << node->GetId());
+	Ptr<GlobalRouter> globalRouter = CreateObject<GlobalRouter>();
+	node->AggregateObject(globalRouter);
+
+	NS_LOG_LOGIC("Adding GlobalRouting interface " << node->GetId());
+	Ptr<Ipv4GlobalRouting> globalRouting = CreateObject<Ipv4GlobalRouting>();
+	globalRouter->SetRoutingProtocol(globalRouting);
+
+    Ptr<Ipv4XPathRouting> xpathRouting =
+      CreateObject<Ipv4XPathRouting>(globalRouting);
+	return xpathRouting;
+}
+
+void Ipv4XPathRoutingHelper::PopulateRoutingTables() {
+	GlobalRouteManager::BuildGlobalRoutingDatabase();
+	GlobalRouteManager::InitializeRoutes();
+}
+
+void Ipv4XPathRoutingHelper::RecomputeRoutingTables() {
+	GlobalRouteManager::DeleteGlobalRoutes();
+	GlobalRouteManager::BuildGlobalRoutingDatabase();
+	GlobalRouteManager::InitializeRoutes();
+}
+
+void Ipv4XPathRoutingHelper::UpdateRoutingTables() {
+	GlobalRouteManager::UpdateRoutes();
+}
+
+uint32_t Ipv4XPathRoutingHelper::PopulatePathTables(
+	NodeContainer spines, NodeContainer leaves) const {
+	NS_LOG_FUNCTION(this);
+	typedef FatTreeRoutingHelper::Link Link;
+
+	// The uplinks of each leaf, ordered by spine, and its servers.
+	std::vector<FatTreeRoutingHelper::LeafLinks> links =
+		FatTreeRoutingHelper::GetLeafLinks(spines, leaves);
+	for (uint32_t l = 0; l < leaves.GetN(); l++) {
+		NS_ABORT_MSG_IF(links[l].uplinks.size() != links[0].uplinks.size(),
+			"Leaf " << leaves.Get(l)->GetId() << " has "
+			<< links[l].uplinks.size() << " uplinks instead of "
+			<< links[0].uplinks.size());
+	}
+	uint32_t nUplinks = leaves.GetN() ? links[0].uplinks.size() : 0;
+	if (nUplinks == 0) {
+		return 0;
+	}
+
+	auto getRouting = [this](Ptr<Node> node) {
+		Ptr<Ipv4XPathRouting> routing =
+			GetXPathRouting(node->GetObject<Ipv4>());
+		NS_ABORT_MSG_UNLESS(routing,
+			"No Ipv4XPathRouting on node " << node->GetId());
+		return routing;
+	};
+
+	// Leaves send the servers of other leaves up on digit p % nUplinks.
+	for (uint32_t l = 0; l < leaves.GetN(); l++) {
+		Ptr<Ipv4XPathRouting> routing = getRouting(leaves.Get(l));
+		routing->ClearPathTable();
+		XPathPortTable& table = routing->GetPathTable();
+		std::vector<uint32_t> hops;
+		for (const Link& up : links[l].uplinks) {
+			hops.push_back(routing->AddHop(up.interface, up.peerAddress));
+		}
+		uint32_t upGroup = table.AddGroup(1, hops);
+		for (uint32_t other = 0; other < leaves.GetN(); other++) {
+			for (const Link& down : links[other].downlinks) {
+				if (other != l) {
+					table.SetGroup(down.peerAddress, upGroup);
+					continue;
+				}
+				uint32_t hop =
+					routing->AddHop(down.interface, down.peerAddress);
+				table.SetGroup(down.peerAddress, table.AddGroup(1, {hop}));
+			}
+		}
+	}
+
+	// Spines send the servers of a leaf down on digit
+	// (p / nUplinks) % links, over the links to the leaf.
+	uint32_t maxLinks = 0;
+	for (uint32_t s = 0; s < spines.GetN(); s++) {
+		Ptr<Ipv4XPathRouting> routing = getRouting(spines.Get(s));
+		routing->ClearPathTable();
+		XPathPortTable& table = routing->GetPathTable();
+		for (uint32_t l = 0; l < leaves.GetN(); l++) {
+			std::vector<uint32_t> hops;
+			for (const Link& up : links[l].uplinks) {
+				if (up.peer == spines.Get(s)) {
+					hops.push_back(
+						routing->AddHop(up.peerInterface, up.address));
+				}
+			}
+			if (hops.empty()) {
+				continue;
+			}
+			maxLinks = std::max<uint32_t>(maxLinks, hops.size());
+			uint32_t group = table.AddGroup(nUplinks, hops);
+			for (const Link& down : links[l].downlinks) {
+				table.SetGroup(down.peerAddress, group);
+			}
+		}
+	}
+	NS_LOG_LOGIC("Leaves have " << nUplinks << " uplinks and up to "
+		<< maxLinks << " links to a spine");
+	return nUplinks * maxLinks;
+}
+
+Ptr<Ipv4XPathRouting>
+Ipv4XPathRoutingHelper::GetXPathRouting(Ptr<Ipv4> ipv4) const {
+	Ptr<Ipv4RoutingProtocol> ipv4rp = ipv4->GetRoutingProtocol();
+	// If the routing protocol can be cast to Ipv4XPathRouting then return
+	// the cast.
+	if (DynamicCast<Ipv4XPathRouting>(ipv4rp)) {
+		return DynamicCast<Ipv4XPathRouting>(ipv4rp);
+	}
+	// If the routing protocol can be cast to Ipv4ListRouting then perform the
+	// cast and iterate through the list searching for a Ipv4XPathRouting.
+	if (DynamicCast<Ipv4ListRouting>(ipv4rp)) {
+		Ptr<Ipv4ListRouting> lrp = DynamicCast<Ipv4ListRouting>(ipv4rp);
+		int16_t priority;
+		for (uint32_t route_idx = 0;
+			 route_idx < lrp->GetNRoutingProtocols();
+			 route_idx++) {
+			Ptr<Ipv4RoutingProtocol> temp = lrp->GetRoutingProtocol(
+				route_idx, priority);
+		    if (DynamicCast<Ipv4XPathRouting>(temp)) {
+		    	return DynamicCast<Ipv4XPathRouting>(temp);
+		    }
+		}
+	}
+	return nullptr;
+}
+
+}  // namespace ns3
\ No newline at end of file
@@ -0,0 +1,95 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef IPV4_XPATH_ROUTING_HELPER_H
+#define IPV4_XPATH_ROUTING_HELPER_H
+
+#include "ns3/ipv4-xpath-routing.h"
+#include "ns3/ipv4-routing-helper.h"
+#include "ns3/node-container.h"
+
+namespace ns3 {
+
+class Ipv4XPathRoutingHelper : public Ipv4RoutingHelper {
+public:
+	/**
+	 * \brief Construct a XPathRoutingHelper to more easily manage
+	 * XPath routing.
+	 */
+	Ipv4XPathRoutingHelper();
+
+	/**
+	 * \brief Construct a XPathRoutingHelper from another previously
+	 * initialized instance (Copy Constructor).
+	 * 
+	 * \param o object to be copied.
+	 */
+	Ipv4XPathRoutingHelper(const Ipv4XPathRoutingHelper& o);
+
+	// Delete assignment operator to avoid misuse.
+	Ipv4XPathRoutingHelper& operator=(
+		const Ipv4XPathRoutingHelper&) = delete;
+
+    /**
+     * \returns pointer to clone of this Ipv4XPathRoutingHelper.
+     */
+	Ipv4XPathRoutingHelper* Copy(void) const override;
+
+    /**
+     * \brief This method is called by ns3::InternetStackHelper::Install.
+     * 
+     * \param node The node on which the routing protocol will run.
+     * 
+     * \returns a newly-created routing protocol.
+     */
+	virtual Ptr<Ipv4RoutingProtocol> Create(Ptr<Node> node) const override;
+
+	/**
+	 * \brief Build a routing database and initialize the routing tables of
+	 * the nodes in the simulation. Makes all nodes in the simulation into
+	 * routers.
+	 */
+	static void PopulateRoutingTables();
+
+	/**
+	 * \brief Remove all routes that were previously installed in a prior call
+	 * to either PopulateRoutingTables() or RecomputeRoutingTables(), and add
+	 * a new set of routes.
+	 */
+	static void RecomputeRoutingTables();
+
+	/**
+	 * \brief Update the routes that were previously installed after links
+	 * went up or down, recomputing only the routes the changes affect. The
+	 * routes are the same as those of RecomputeRoutingTables().
+	 */
+	static void UpdateRoutingTables();
+
+	/**
+	 * \brief Fills the path tables of the switches of a leaf-spine network.
+	 *
+	 * The servers and the (possibly parallel) leaf-spine links are found
+	 * from the channels of the leaves, like FatTreeRoutingHelper does. The
+	 * uplinks of every leaf are numbered by spine, then by link, so a path
+	 * ID names the same spine at every leaf. Every leaf must have the same
+	 * number of uplinks.
+	 *
+	 * \param spines the spine switches.
+	 * \param leaves the leaf switches.
+	 * \returns the number of distinct path IDs, the number of uplinks of a
+	 * leaf times the largest number of links between a leaf and a spine.
+	 */
+	uint32_t PopulatePathTables(NodeContainer spines,
+		                        NodeContainer leaves) const;
+
+    /**
+     * \brief Retrieve the Ipv4XPathRouting protocol attached to the helper.
+     * 
+     * \param ipv4 The Ptr<Ipv4> to search for the XPath routing protocol.
+     * 
+     * \returns Ipv4XPathRouting pointer or nullptr if not found.
+     */
+	Ptr<Ipv4XPathRouting> GetXPathRouting(Ptr<Ipv4> ipv4) const;
+};
+
+}  // namespace ns3
+
+#endif  // IPV4_XPATH_ROUTING_HELPER_H
\ No newline at end of file
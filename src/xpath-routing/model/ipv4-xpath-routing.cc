@@ -0,0 +1,167 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "ipv4-xpath-routing.h"
+
+#include "ns3/ipv4-xpath-tag.h"
+#include "ns3/log.h"
+#include "ns3/net-device.h"
+#include "ns3/node.h"
+#include "ns3/object.h"
+#include "ns3/packet.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("Ipv4XPathRouting");
+
+NS_OBJECT_ENSURE_REGISTERED(Ipv4XPathRouting);
+
+TypeId Ipv4XPathRouting::GetTypeId(void) {
+	static TypeId tid = TypeId("ns3::Ipv4XPathRouting")
+	    .SetParent<Object>()
+	    .SetGroupName("XPathRouting");
+	return tid;
+}
+
+Ipv4XPathRouting::Ipv4XPathRouting(Ptr<Ipv4GlobalRouting> globalRouting)
+	: m_ipv4(nullptr),
+	  m_pathForwarded(0),
+	  m_globalRouting(globalRouting) {
+	NS_LOG_FUNCTION(this);
+}
+
+Ipv4XPathRouting::~Ipv4XPathRouting() {
+	NS_LOG_FUNCTION(this);
+}
+
+Ptr<Ipv4Route> Ipv4XPathRouting::RouteOutput(Ptr<Packet> packet,
+	                                         const Ipv4Header& header,
+	                                         Ptr<NetDevice> oif,
+	                                         Socket::SocketErrno& sockerr) {
+	NS_LOG_FUNCTION(this << packet << &header << oif << &sockerr);
+	// Delegate to Global Routing. Paths are picked by the host schemes that
+	// stamp the tag.
+	return m_globalRouting->RouteOutput(packet, header, oif, sockerr);
+}
+
+bool Ipv4XPathRouting::RouteInput(Ptr<const Packet> p,
+	                              const Ipv4Header& header,
+	                              Ptr<const NetDevice> idev,
+	                              UnicastForwardCallback ucb,
+	                              MulticastForwardCallback mcb,
+	                              LocalDeliverCallback lcb,
+	                              ErrorCallback ecb) {
+	NS_LOG_LOGIC(this << " Route Input: " << p << " IP header: " << header);
+	uint32_t iif = m_ipv4->GetInterfaceForDevice(idev);
+
+	Ipv4XPathTag tag;
+	if (!m_ipv4->IsDestinationAddress(header.GetDestination(), iif) &&
+		m_ipv4->IsForwarding(iif) && p->PeekPacketTag(tag)) {
+		Ptr<Ipv4Route> route =
+			LookupPath(header.GetDestination(), tag.GetPathId());
+		if (route) {
+			NS_LOG_LOGIC(this << " Path " << tag.GetPathId() << " to "
+				<< header.GetDestination() << " leaves on "
+				<< route->GetOutputDevice());
+			m_pathForwarded++;
+			ucb(route, p, header);
+			return true;
+		}
+	}
+
+	// Local delivery, packets without a path and paths the table does not
+	// cover are left to Global Routing.
+	return m_globalRouting->RouteInput(p, header, idev, ucb, mcb, lcb, ecb);
+}
+
+Ptr<Ipv4Route> Ipv4XPathRouting::LookupPath(Ipv4Address dst,
+	                                        uint32_t pathId) const {
+	uint32_t hop = m_pathTable.Lookup(dst, pathId);
+	if (hop == XPathPortTable::NO_HOP) {
+		return nullptr;
+	}
+	const Ptr<Ipv4Route>& route = m_hops[hop];
+	uint32_t interface =
+		m_ipv4->GetInterfaceForDevice(route->GetOutputDevice());
+	if (!m_ipv4->IsUp(interface)) {
+		NS_LOG_LOGIC(this << " Path " << pathId << " to " << dst
+			<< " is down");
+		return nullptr;
+	}
+	return route;
+}
+
+uint32_t Ipv4XPathRouting::AddHop(uint32_t interface, Ipv4Address gateway) {
+	NS_LOG_FUNCTION(this << interface << gateway);
+	NS_ASSERT_MSG(m_ipv4, "Hops are added after the stack is installed");
+	// The destination is taken from the IP header, so a hop serves every
+	// destination of its groups.
+	Ptr<Ipv4Route> route = Create<Ipv4Route>();
+	route->SetOutputDevice(m_ipv4->GetNetDevice(interface));
+	route->SetGateway(gateway);
+	route->SetSource(m_ipv4->GetAddress(interface, 0).GetLocal());
+	m_hops.push_back(route);
+	return m_hops.size() - 1;
+}
+
+XPathPortTable& Ipv4XPathRouting::GetPathTable() {
+	return m_pathTable;
+}
+
+void Ipv4XPathRouting::ClearPathTable() {
+	NS_LOG_FUNCTION(this);
+	m_pathTable.Clear();
+	m_hops.clear();
+}
+
+void Ipv4XPathRouting::NotifyInterfaceUp(uint32_t interface) {
+	m_globalRouting->NotifyInterfaceUp(interface);
+}
+
+void Ipv4XPathRouting::NotifyInterfaceDown(uint32_t interface) {
+	m_globalRouting->NotifyInterfaceDown(interface);
+}
+
+void Ipv4XPathRouting::NotifyAddAddress(
+	uint32_t interface, Ipv4InterfaceAddress address) {
+	m_globalRouting->NotifyAddAddress(interface, address);
+}
+
+void Ipv4XPathRouting::NotifyRemoveAddress(
+	uint32_t interface, Ipv4InterfaceAddress address) {
+	m_globalRouting->NotifyRemoveAddress(interface, address);
+}
+
+void Ipv4XPathRouting::SetIpv4(Ptr<Ipv4> ipv4) {
+	NS_LOG_LOGIC(this << " Setting up IPv4: " << ipv4);
+	NS_ASSERT(m_ipv4 == nullptr && ipv4 != nullptr);
+	m_ipv4 = ipv4;
+	m_globalRouting->SetIpv4(ipv4);
+}
+
+void Ipv4XPathRouting::PrintRoutingTable(Ptr<OutputStreamWrapper> stream,
+	                                     Time::Unit unit) const {
+	m_globalRouting->PrintRoutingTable(stream, unit);
+}
+
+void Ipv4XPathRouting::DoDispose(void) {
+	NS_LOG_FUNCTION(this);
+	ClearPathTable();
+	m_ipv4 = nullptr;
+	m_globalRouting->DoDispose();
+	m_globalRouting = nullptr;
+}
+
+uint32_t Ipv4XPathRouting::GetNRoutes() const {
+	NS_LOG_FUNCTION(this);
+	return m_globalRouting->GetNRoutes();
+}
+
+Ipv4RoutingTableEntry* Ipv4XPathRouting::GetRoute(uint32_t i) const {
+	NS_LOG_FUNCTION(this << " " << i);
+	return m_globalRouting->GetRoute(i);
+}
+
+uint64_t Ipv4XPathRouting::GetPathForwarded() const {
+	return m_pathForwarded;
+}
+
+}  // namespace ns3
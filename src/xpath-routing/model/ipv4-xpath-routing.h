@@ -0,0 +1,136 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef IPV4_XPATH_ROUTING_H
+#define IPV4_XPATH_ROUTING_H
+
+#include "ns3/ipv4-address.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/object.h"
+#include "ns3/packet.h"
+#include "ns3/node.h"
+#include "ns3/xpath-port-table.h"
+
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup xpath-routing
+ *
+ * \brief XPath explicit path forwarding.
+ *
+ * Implements the switch side of "Explicit Path Control in Commodity Data
+ * Centers: Design and Applications". Hosts pick the path of each packet and
+ * stamp its path ID in an Ipv4XPathTag, as Ipv4DrbRouting does; switches
+ * forward a tagged packet on the hop its path ID selects in an
+ * XPathPortTable. The hops are routes built once, when the table is filled,
+ * so forwarding does not search the routing table nor build routes.
+ *
+ * Ipv4XPathRoutingHelper::PopulatePathTables fills the tables of a leaf-spine
+ * network: with U uplinks per leaf and at most L links between a leaf and a
+ * spine, path ID p leaves the source leaf on uplink p % U and the spine on
+ * link (p / U) % L to the destination leaf.
+ *
+ * Packets without a tag, to destinations not in the table or whose hop is
+ * down are routed like Ipv4GlobalRouting, as are the packets of hosts.
+ */
+class Ipv4XPathRouting : public Ipv4RoutingProtocol {
+public:
+	Ipv4XPathRouting(Ptr<Ipv4GlobalRouting> globalRouting);
+	~Ipv4XPathRouting();
+
+	static TypeId GetTypeId();
+
+	// Inherited from Ipv4RoutingProtocol.
+	Ptr<Ipv4Route> RouteOutput(
+		Ptr<Packet> p, const Ipv4Header& header, Ptr<NetDevice> oif,
+		Socket::SocketErrno& sockerr) override;
+	bool RouteInput(
+		Ptr<const Packet> p, const Ipv4Header& header,
+		Ptr<const NetDevice> idev, UnicastForwardCallback ucb,
+		MulticastForwardCallback mcb, LocalDeliverCallback lcb,
+		ErrorCallback ecb) override;
+	void NotifyInterfaceUp(uint32_t interface) override;
+	void NotifyInterfaceDown(uint32_t interface) override;
+	void NotifyAddAddress(uint32_t interface,
+		                  Ipv4InterfaceAddress address) override;
+	void NotifyRemoveAddress(uint32_t interface,
+		                     Ipv4InterfaceAddress address) override;
+	void SetIpv4(Ptr<Ipv4> ipv4) override;
+	void PrintRoutingTable(Ptr<OutputStreamWrapper> stream,
+		                   Time::Unit unit = Time::S) const override;
+
+	/**
+	 * \brief Get the number of individual unicast routes that have been
+	 * added to the routing table.
+	 */
+	uint32_t GetNRoutes() const;
+
+	/**
+	 * \brief Get a route from the unicast routing table.
+	 *
+	 * \param i The index (into the routing table) of the route to retrieve.
+	 *
+	 * \return If the route is set, a pointer to that Ipv4RoutingTableEntry
+	 * is returned, otherwise, nullptr is returned.
+	 */
+	Ipv4RoutingTableEntry* GetRoute(uint32_t i) const;
+
+	virtual void DoDispose(void) override;
+
+	/**
+	 * \brief Adds a hop for the path table.
+	 *
+	 * \param interface the output interface.
+	 * \param gateway the next hop address.
+	 * \returns the index of the hop, to be put in port groups.
+	 */
+	uint32_t AddHop(uint32_t interface, Ipv4Address gateway);
+
+	/**
+	 * \returns the path table, whose groups hold the indices returned by
+	 * AddHop.
+	 */
+	XPathPortTable& GetPathTable();
+
+	/**
+	 * \brief Removes every hop and the path table.
+	 */
+	void ClearPathTable();
+
+	/**
+	 * \brief Looks up the hop of a path.
+	 *
+	 * \param dst the destination address.
+	 * \param pathId the path ID.
+	 * \returns the route of the hop, or nullptr if the destination is not in
+	 * the table or the hop is down.
+	 */
+	Ptr<Ipv4Route> LookupPath(Ipv4Address dst, uint32_t pathId) const;
+
+	/**
+	 * \returns the number of packets forwarded on their path ID.
+	 */
+	uint64_t GetPathForwarded() const;
+
+private:
+	// Ipv4 address associated with this router.
+	Ptr<Ipv4> m_ipv4;
+
+	// The route of each hop, indexed by the hops of the path table.
+	std::vector<Ptr<Ipv4Route>> m_hops;
+
+	XPathPortTable m_pathTable;
+
+	uint64_t m_pathForwarded;
+
+	// A pointer to an Ipv4GlobalRouting object. It routes the packets the
+	// path table does not cover and maintains the routing table.
+	Ptr<Ipv4GlobalRouting> m_globalRouting;
+};
+
+}  // namespace ns3
+
+#endif  // IPV4_XPATH_ROUTING_H
@@ -0,0 +1,57 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "xpath-port-table.h"
+
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("XPathPortTable");
+
+XPathPortTable::XPathPortTable() {}
+
+uint32_t XPathPortTable::AddGroup(uint32_t stride,
+	                              const std::vector<uint32_t>& hops) {
+	NS_LOG_FUNCTION(this << stride << hops.size());
+	NS_ASSERT_MSG(stride > 0, "The stride of a port group must be positive");
+	NS_ASSERT_MSG(!hops.empty(), "A port group needs at least one hop");
+	Group group;
+	group.offset = m_hops.size();
+	group.size = hops.size();
+	group.stride = stride;
+	m_hops.insert(m_hops.end(), hops.begin(), hops.end());
+	m_groups.push_back(group);
+	return m_groups.size() - 1;
+}
+
+void XPathPortTable::SetGroup(Ipv4Address dst, uint32_t group) {
+	NS_LOG_FUNCTION(this << dst << group);
+	NS_ASSERT_MSG(group < m_groups.size(), "No port group " << group);
+	m_dstGroups[dst.Get()] = group;
+}
+
+uint32_t XPathPortTable::Lookup(Ipv4Address dst, uint32_t pathId) const {
+	auto itr = m_dstGroups.find(dst.Get());
+	if (itr == m_dstGroups.end()) {
+		return NO_HOP;
+	}
+	const Group& group = m_groups[itr->second];
+	return m_hops[group.offset + (pathId / group.stride) % group.size];
+}
+
+uint32_t XPathPortTable::GetNGroups() const {
+	return m_groups.size();
+}
+
+uint32_t XPathPortTable::GetNDestinations() const {
+	return m_dstGroups.size();
+}
+
+void XPathPortTable::Clear() {
+	NS_LOG_FUNCTION(this);
+	m_groups.clear();
+	m_hops.clear();
+	m_dstGroups.clear();
+}
+
+}  // namespace ns3
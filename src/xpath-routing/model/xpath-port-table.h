@@ -0,0 +1,92 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef XPATH_PORT_TABLE_H
+#define XPATH_PORT_TABLE_H
+
+#include "ns3/ipv4-address.h"
+
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup xpath-routing
+ *
+ * \brief The hops a switch takes for each path ID.
+ *
+ * Destinations that leave the switch over the same set of ports share a port
+ * group, e.g. every server behind another leaf on a leaf switch, or every
+ * server of a leaf on a spine. A group holds its hops in one slice of a flat
+ * array, and each switch reads one digit of the path ID: the hop of path ID
+ * p in a group of n hops with stride s is hop (p / s) % n. So a lookup is a
+ * hash of the destination followed by an array index, whatever the number of
+ * paths, and the table is linear in the number of destinations and ports
+ * rather than in the number of paths.
+ *
+ * Hops are opaque indices; Ipv4XPathRouting maps them to routes.
+ */
+class XPathPortTable {
+public:
+	// The hop of a destination that is not in the table.
+	static const uint32_t NO_HOP = 0xffffffff;
+
+	XPathPortTable();
+
+	/**
+	 * \brief Adds a port group.
+	 *
+	 * \param stride the weight of the digit of the path ID the group reads.
+	 * \param hops the hops of the group, in the order of the digit.
+	 * \returns the index of the group.
+	 */
+	uint32_t AddGroup(uint32_t stride, const std::vector<uint32_t>& hops);
+
+	/**
+	 * \brief Sends the packets to a destination over a port group.
+	 *
+	 * \param dst the destination address.
+	 * \param group the index of the group.
+	 */
+	void SetGroup(Ipv4Address dst, uint32_t group);
+
+	/**
+	 * \param dst the destination address.
+	 * \param pathId the path ID of the packet.
+	 * \returns the hop of the path to the destination, or NO_HOP.
+	 */
+	uint32_t Lookup(Ipv4Address dst, uint32_t pathId) const;
+
+	/**
+	 * \returns the number of port groups.
+	 */
+	uint32_t GetNGroups() const;
+
+	/**
+	 * \returns the number of destinations.
+	 */
+	uint32_t GetNDestinations() const;
+
+	/**
+	 * \brief Removes every group and destination.
+	 */
+	void Clear();
+
+private:
+	struct Group {
+		// The index of the first hop of the group in m_hops.
+		uint32_t offset;
+		uint32_t size;
+		uint32_t stride;
+	};
+
+	std::vector<Group> m_groups;
+	// The hops of every group, one slice per group.
+	std::vector<uint32_t> m_hops;
+	// The group of each destination address.
+	std::unordered_map<uint32_t, uint32_t> m_dstGroups;
+};
+
+}  // namespace ns3
+
+#endif  // XPATH_PORT_TABLE_H
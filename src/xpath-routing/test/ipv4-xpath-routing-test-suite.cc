@@ -0,0 +1,402 @@
+#include "ns3/channel.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-drb-path-table.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/ipv4-xpath-routing-helper.h"
+#include "ns3/ipv4-xpath-routing.h"
+#include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/ipv4-xpath-tag.h"
+#include "ns3/log.h"
+#include "ns3/node-container.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/pointer.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simulator.h"
+#include "ns3/test.h"
+#include "ns3/uinteger.h"
+#include "ns3/xpath-port-table.h"
+
+#include <set>
+#include <utility>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("Ipv4XPathRoutingTestSuite");
+
+/**
+ * \defgroup xpath-routing-tests Tests for xpath-routing
+ * \ingroup xpath-routing
+ * \ingroup tests
+ * 
+ * This test suite tests the port groups of XPath path tables, the path
+ * tables of a leaf-spine network, and that the path IDs DRB hosts stamp
+ * name every path of the network once.
+ */
+
+/**
+ * \ingroup xpath-routing-tests
+ * 
+ * \brief XPath port table test.
+ */
+class PortTableTest : public TestCase {
+public:
+  PortTableTest();
+
+private:
+  void DoRun() override;
+};
+
+PortTableTest::PortTableTest()
+    : TestCase("XPath port groups read one digit of the path ID") {}
+
+void PortTableTest::DoRun() {
+  XPathPortTable table;
+  Ipv4Address a("10.0.0.1");
+  Ipv4Address b("10.0.0.2");
+  table.SetGroup(a, table.AddGroup(1, {10, 11}));
+  table.SetGroup(b, table.AddGroup(2, {20, 21, 22}));
+  NS_TEST_ASSERT_MSG_EQ(table.GetNGroups(), 2, "Two groups were added");
+  NS_TEST_ASSERT_MSG_EQ(table.GetNDestinations(), 2, "Two destinations were set");
+
+  NS_TEST_ASSERT_MSG_EQ(table.Lookup(a, 0), 10, "Path 0 takes the first hop");
+  NS_TEST_ASSERT_MSG_EQ(table.Lookup(a, 3), 11, "The path ID wraps around the group");
+  NS_TEST_ASSERT_MSG_EQ(table.Lookup(b, 1), 20, "The stride skips the lower digit");
+  NS_TEST_ASSERT_MSG_EQ(table.Lookup(b, 3), 21, "The stride skips the lower digit");
+  NS_TEST_ASSERT_MSG_EQ(table.Lookup(b, 5), 22, "The stride skips the lower digit");
+  NS_TEST_ASSERT_MSG_EQ(table.Lookup(b, 6), 20, "The digit wraps around the group");
+  NS_TEST_ASSERT_MSG_EQ(table.Lookup(Ipv4Address("10.0.0.3"), 0),
+                        XPathPortTable::NO_HOP,
+                        "Unknown destinations have no hop");
+
+  table.Clear();
+  NS_TEST_ASSERT_MSG_EQ(table.Lookup(a, 0), XPathPortTable::NO_HOP,
+                        "A cleared table has no hop");
+}
+
+/**
+ * \ingroup xpath-routing-tests
+ * 
+ * \brief XPath path tables of a leaf-spine network.
+ *
+ * Two leaves with one server each, and two parallel links between each leaf
+ * and each of the two spines.
+ */
+class LeafSpineTest : public TestCase {
+public:
+  LeafSpineTest();
+
+private:
+  void DoRun() override;
+
+  void Forward(Ptr<Ipv4Route> route, Ptr<const Packet> p,
+               const Ipv4Header& header);
+
+  // The route of the last packet forwarded by RouteInput.
+  Ptr<Ipv4Route> m_forwarded;
+};
+
+LeafSpineTest::LeafSpineTest()
+    : TestCase("XPath path tables of a leaf-spine network") {}
+
+void LeafSpineTest::Forward(Ptr<Ipv4Route> route, Ptr<const Packet> p,
+                            const Ipv4Header& header) {
+  m_forwarded = route;
+}
+
+void LeafSpineTest::DoRun() {
+  const uint32_t nSpines = 2;
+  const uint32_t nLeaves = 2;
+  const uint32_t nLinks = 2;
+  NodeContainer spines;
+  spines.Create(nSpines);
+  NodeContainer leaves;
+  leaves.Create(nLeaves);
+  NodeContainer hosts;
+  hosts.Create(nLeaves);
+
+  InternetStackHelper internet;
+  Ipv4XPathRoutingHelper xpathRouting;
+  internet.SetRoutingHelper(xpathRouting);
+  internet.Install(spines);
+  internet.Install(leaves);
+  internet.Install(hosts);
+
+  SimpleNetDeviceHelper simpleHelper;
+  simpleHelper.SetNetDevicePointToPointMode(true);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase("10.0.0.0", "255.255.255.252");
+  std::vector<Ipv4Address> hostAddresses;
+  // The addresses of the leaf and spine ends of each leaf-spine link.
+  Ipv4Address leafAddresses[nLeaves][nSpines][nLinks];
+  Ipv4Address spineAddresses[nLeaves][nSpines][nLinks];
+  for (uint32_t leaf = 0; leaf < nLeaves; leaf++) {
+    Ptr<SimpleChannel> channel = CreateObject<SimpleChannel>();
+    Ipv4InterfaceContainer interfaces = ipv4.Assign(simpleHelper.Install(
+      NodeContainer(hosts.Get(leaf), leaves.Get(leaf)), channel));
+    hostAddresses.push_back(interfaces.GetAddress(0));
+    ipv4.NewNetwork();
+    for (uint32_t spine = 0; spine < nSpines; spine++) {
+      for (uint32_t link = 0; link < nLinks; link++) {
+        channel = CreateObject<SimpleChannel>();
+        interfaces = ipv4.Assign(simpleHelper.Install(
+          NodeContainer(leaves.Get(leaf), spines.Get(spine)), channel));
+        leafAddresses[leaf][spine][link] = interfaces.GetAddress(0);
+        spineAddresses[leaf][spine][link] = interfaces.GetAddress(1);
+        ipv4.NewNetwork();
+      }
+    }
+  }
+
+  Ipv4XPathRoutingHelper::PopulateRoutingTables();
+  uint32_t nPaths = xpathRouting.PopulatePathTables(spines, leaves);
+  NS_TEST_ASSERT_MSG_EQ(nPaths, nSpines * nLinks * nLinks,
+                        "A path is an uplink and a spine downlink");
+
+  Ptr<Ipv4XPathRouting> leafRouting =
+    xpathRouting.GetXPathRouting(leaves.Get(0)->GetObject<Ipv4>());
+  for (uint32_t path = 0; path < nPaths; path++) {
+    uint32_t uplink = path % (nSpines * nLinks);
+    Ptr<Ipv4Route> route = leafRouting->LookupPath(hostAddresses[1], path);
+    NS_TEST_ASSERT_MSG_NE(route, nullptr, "A leaf has a path to remote servers");
+    NS_TEST_ASSERT_MSG_EQ(route->GetGateway(),
+                          spineAddresses[0][uplink / nLinks][uplink % nLinks],
+                          "The path ID picks the uplink of the source leaf");
+    route = leafRouting->LookupPath(hostAddresses[0], path);
+    NS_TEST_ASSERT_MSG_NE(route, nullptr, "A leaf has a path to its servers");
+    NS_TEST_ASSERT_MSG_EQ(route->GetGateway(), hostAddresses[0],
+                          "A leaf delivers to its servers directly");
+  }
+  NS_TEST_ASSERT_MSG_EQ(leafRouting->LookupPath(spineAddresses[0][0][0], 0),
+                        nullptr,
+                        "Switch addresses are left to global routing");
+
+  for (uint32_t spine = 0; spine < nSpines; spine++) {
+    Ptr<Ipv4XPathRouting> spineRouting =
+      xpathRouting.GetXPathRouting(spines.Get(spine)->GetObject<Ipv4>());
+    for (uint32_t path = 0; path < nPaths; path++) {
+      Ptr<Ipv4Route> route = spineRouting->LookupPath(hostAddresses[1], path);
+      NS_TEST_ASSERT_MSG_NE(route, nullptr, "A spine has a path to every server");
+      NS_TEST_ASSERT_MSG_EQ(
+        route->GetGateway(),
+        leafAddresses[1][spine][(path / (nSpines * nLinks)) % nLinks],
+        "The path ID picks the downlink of the spine");
+    }
+  }
+
+  // A tagged packet entering a spine leaves on its path.
+  Ptr<Ipv4> spineIpv4 = spines.Get(0)->GetObject<Ipv4>();
+  Ptr<Ipv4XPathRouting> spineRouting = xpathRouting.GetXPathRouting(spineIpv4);
+  Ptr<Packet> packet = Create<Packet>(100);
+  Ipv4XPathTag tag;
+  tag.SetPathId(nSpines * nLinks);
+  packet->AddPacketTag(tag);
+  Ipv4Header header;
+  header.SetSource(hostAddresses[0]);
+  header.SetDestination(hostAddresses[1]);
+  bool routed = spineRouting->RouteInput(
+    packet, header, spineIpv4->GetNetDevice(1),
+    MakeCallback(&LeafSpineTest::Forward, this),
+    MakeNullCallback<void, Ptr<Ipv4MulticastRoute>, Ptr<const Packet>,
+                     const Ipv4Header&>(),
+    MakeNullCallback<void, Ptr<const Packet>, const Ipv4Header&, uint32_t>(),
+    MakeNullCallback<void, Ptr<const Packet>, const Ipv4Header&,
+                     Socket::SocketErrno>());
+  NS_TEST_ASSERT_MSG_EQ(routed, true, "The packet is forwarded");
+  NS_TEST_ASSERT_MSG_NE(m_forwarded, nullptr, "The packet is forwarded");
+  NS_TEST_ASSERT_MSG_EQ(m_forwarded->GetGateway(), leafAddresses[1][0][1],
+                        "The packet leaves on the second link to its leaf");
+  NS_TEST_ASSERT_MSG_EQ(spineRouting->GetPathForwarded(), 1,
+                        "The packet is forwarded on its path");
+
+  Simulator::Destroy();
+}
+
+/**
+ * \ingroup xpath-routing-tests
+ * 
+ * \brief XPath follows the path IDs of DRB hosts.
+ *
+ * A DRB host given the path IDs 0 to N - 1, N being the number of paths
+ * PopulatePathTables returns, sprays the packets of a flow round-robin over
+ * them. On the leaf-spine network of LeafSpineTest, each of these IDs must
+ * name a distinct uplink of the source leaf and downlink of the spine, so
+ * that a round of the DRB schedule visits every path once.
+ */
+class DrbPathTest : public TestCase {
+public:
+  DrbPathTest();
+
+private:
+  void DoRun() override;
+
+  /**
+   * \brief Records the route of a forwarded packet.
+   *
+   * \param forwarded Where to record the route.
+   * \param route The route of the packet.
+   * \param p The packet.
+   * \param header The IP header of the packet.
+   */
+  static void Forward(Ptr<Ipv4Route>* forwarded, Ptr<Ipv4Route> route,
+                      Ptr<const Packet> p, const Ipv4Header& header);
+
+  /**
+   * \brief Forwards a packet through a switch.
+   *
+   * \param node The switch.
+   * \param idev The device the packet enters on.
+   * \param packet The packet.
+   * \param header The IP header of the packet.
+   *
+   * \return The route of the packet, or nullptr if it is not forwarded.
+   */
+  static Ptr<Ipv4Route> RouteThrough(Ptr<Node> node, Ptr<NetDevice> idev,
+                                     Ptr<const Packet> packet,
+                                     const Ipv4Header& header);
+};
+
+DrbPathTest::DrbPathTest()
+    : TestCase("XPath path IDs match the paths of DRB hosts") {}
+
+void DrbPathTest::Forward(Ptr<Ipv4Route>* forwarded, Ptr<Ipv4Route> route,
+                          Ptr<const Packet> p, const Ipv4Header& header) {
+  *forwarded = route;
+}
+
+Ptr<Ipv4Route> DrbPathTest::RouteThrough(Ptr<Node> node, Ptr<NetDevice> idev,
+                                         Ptr<const Packet> packet,
+                                         const Ipv4Header& header) {
+  Ipv4XPathRoutingHelper xpathRouting;
+  Ptr<Ipv4Route> forwarded;
+  xpathRouting.GetXPathRouting(node->GetObject<Ipv4>())->RouteInput(
+    packet, header, idev,
+    MakeBoundCallback(&DrbPathTest::Forward, &forwarded),
+    Ipv4RoutingProtocol::MulticastForwardCallback(),
+    Ipv4RoutingProtocol::LocalDeliverCallback(),
+    Ipv4RoutingProtocol::ErrorCallback());
+  return forwarded;
+}
+
+void DrbPathTest::DoRun() {
+  const uint32_t nSpines = 2;
+  const uint32_t nLeaves = 2;
+  const uint32_t nLinks = 2;
+  NodeContainer spines;
+  spines.Create(nSpines);
+  NodeContainer leaves;
+  leaves.Create(nLeaves);
+  NodeContainer hosts;
+  hosts.Create(nLeaves);
+
+  InternetStackHelper internet;
+  Ipv4XPathRoutingHelper xpathRouting;
+  internet.SetRoutingHelper(xpathRouting);
+  internet.Install(spines);
+  internet.Install(leaves);
+  internet.Install(hosts);
+
+  SimpleNetDeviceHelper simpleHelper;
+  simpleHelper.SetNetDevicePointToPointMode(true);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase("10.0.0.0", "255.255.255.252");
+  std::vector<Ipv4Address> hostAddresses;
+  Ptr<NetDevice> hostPort;
+  for (uint32_t leaf = 0; leaf < nLeaves; leaf++) {
+    NetDeviceContainer hostLink = simpleHelper.Install(
+      NodeContainer(hosts.Get(leaf), leaves.Get(leaf)));
+    hostAddresses.push_back(ipv4.Assign(hostLink).GetAddress(0));
+    if (leaf == 0) {
+      hostPort = hostLink.Get(1);
+    }
+    ipv4.NewNetwork();
+    for (uint32_t spine = 0; spine < nSpines; spine++) {
+      for (uint32_t link = 0; link < nLinks; link++) {
+        ipv4.Assign(simpleHelper.Install(
+          NodeContainer(leaves.Get(leaf), spines.Get(spine))));
+        ipv4.NewNetwork();
+      }
+    }
+  }
+  Ipv4XPathRoutingHelper::PopulateRoutingTables();
+  uint32_t nPaths = xpathRouting.PopulatePathTables(spines, leaves);
+
+  // The schedule of a DRB host with every path, as Ipv4DrbRouting::AddPath
+  // builds it.
+  Ptr<DrbPathSchedule> schedule = Create<DrbPathSchedule>();
+  for (uint32_t path = 0; path < nPaths; path++) {
+    schedule = schedule->AddPath(path, 1);
+  }
+  NS_TEST_ASSERT_MSG_EQ(schedule->GetLength(), nPaths,
+                        "Every path has one slot");
+
+  Ipv4Header header;
+  header.SetSource(hostAddresses[0]);
+  header.SetDestination(hostAddresses[1]);
+  // The uplink gateway and spine downlink gateway of each packet.
+  std::vector<std::pair<Ipv4Address, Ipv4Address>> hops;
+  for (uint32_t i = 0; i < 2 * nPaths; i++) {
+    Ptr<Packet> packet = Create<Packet>(100);
+    Ipv4XPathTag tag;
+    tag.SetPathId(schedule->GetPath(i % nPaths));
+    packet->AddPacketTag(tag);
+    Ptr<Ipv4Route> uplink =
+      RouteThrough(leaves.Get(0), hostPort, packet, header);
+    NS_TEST_ASSERT_MSG_NE(uplink, nullptr, "The leaf forwards the packet");
+    // Enter the spine on the far end of the uplink.
+    Ptr<Channel> channel = uplink->GetOutputDevice()->GetChannel();
+    Ptr<NetDevice> spinePort = channel->GetDevice(0) ==
+      uplink->GetOutputDevice() ? channel->GetDevice(1)
+                                : channel->GetDevice(0);
+    Ptr<Ipv4Route> downlink =
+      RouteThrough(spinePort->GetNode(), spinePort, packet, header);
+    NS_TEST_ASSERT_MSG_NE(downlink, nullptr, "The spine forwards the packet");
+    hops.emplace_back(uplink->GetGateway(), downlink->GetGateway());
+  }
+
+  std::set<std::pair<Ipv4Address, Ipv4Address>> round(
+    hops.begin(), hops.begin() + nPaths);
+  NS_TEST_ASSERT_MSG_EQ(round.size(), nPaths,
+                        "A round of DRB visits every path once");
+  for (uint32_t i = nPaths; i < 2 * nPaths; i++) {
+    NS_TEST_ASSERT_MSG_EQ((hops[i] == hops[i - nPaths]), true,
+                          "A path ID always names the same path");
+  }
+  Ptr<Ipv4XPathRouting> leafRouting =
+    xpathRouting.GetXPathRouting(leaves.Get(0)->GetObject<Ipv4>());
+  NS_TEST_ASSERT_MSG_EQ(leafRouting->GetPathForwarded(), 2 * nPaths,
+                        "Every packet is forwarded on its path");
+
+  Simulator::Destroy();
+}
+
+/**
+ * \ingroup xpath-routing-tests
+ * TestSuite for module xpath-routing
+ */
+class XPathRoutingTestSuite : public TestSuite
+{
+  public:
+    XPathRoutingTestSuite();
+};
+
+XPathRoutingTestSuite::XPathRoutingTestSuite()
+    : TestSuite("ipv4-xpath-routing", UNIT)
+{
+    // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
+    AddTestCase(new PortTableTest, TestCase::QUICK);
+    AddTestCase(new LeafSpineTest, TestCase::QUICK);
+    AddTestCase(new DrbPathTest, TestCase::QUICK);
+}
+
+// Do not forget to allocate an instance of this TestSuite
+/**
+ * \ingroup xpath-routing-tests
+ * Static variable for test initialization
+ */
+static XPathRoutingTestSuite sxpathRoutingTestSuite;